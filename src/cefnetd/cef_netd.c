@@ -114,6 +114,31 @@ typedef struct {
 }	CefT_Netd_TxWorker;
 #endif // CefC_TxMultiThread
 
+typedef struct {
+	uint8_t				type;			/* PT_XXX of the message */
+	int					faceid;			/* Face-ID where the message arrived at */
+	int					peer_faceid;	/* Face-ID to reply to the origin of the message */
+	uint32_t			face_gen;		/* generations of the Faces when the message */
+	uint32_t			peer_gen;		/* was parked */
+	uint16_t			payload_len;
+	uint16_t			header_len;
+	int					res;			/* result of cef_valid_msg_verify */
+	char				user_id[512];
+	unsigned char		msg[];			/* copy of the message */
+}	CefT_Netd_Verify_Elem;
+
+typedef struct {
+	int					worker_id;		/* worker id */
+	int					running_f;		/* cleared to stop the worker */
+	pthread_t			th;
+	CefT_Rngque* 		req_que;		/* messages to verify (cefnetd -> worker) */
+	CefT_Rngque* 		cmp_que;		/* verified messages (worker -> cefnetd) */
+	int					parked_num;		/* messages in req_que, worker and cmp_que */
+	int					doorbell_fd;	/* wakes up the poll of cefnetd */
+	pthread_mutex_t		mutex;
+	pthread_cond_t		cond;
+}	CefT_Netd_VerifyWorker;
+
 /****************************************************************************************
  State Variables
  ****************************************************************************************/
@@ -148,6 +173,7 @@ static CefT_Netd_TxWorker transmit_worker_hdl[CefC_TxWorkerMax];
 #endif // CefC_TxMultiThread
 static	pthread_t cefnetd_transmit_main_th;
 static	pthread_t cefnetd_cefstatus_th;
+static CefT_Netd_VerifyWorker verify_worker_hdl[CefC_VerifyWorkerMax];
 
 static	pthread_mutex_t cefnetd_txqueue_mutex;
 static	pthread_cond_t  cefnetd_txqueue_cond;
@@ -705,6 +731,18 @@ static int									/* No care now								*/
 cefnetd_input_from_local_process (
 	CefT_Netd_Handle* hdl					/* cefnetd handle							*/
 );
+/*--------------------------------------------------------------------------------------
+	Attaches the shared memory rings passed by the local process
+----------------------------------------------------------------------------------------*/
+static void
+cefnetd_input_shmring_open (
+	CefT_Netd_Handle* hdl,					/* cefnetd handle							*/
+	int app_idx,							/* index of the local connection 			*/
+	unsigned char* msg,						/* the received message 					*/
+	int msg_len,							/* length of the received message 			*/
+	int fds[],								/* passed file descriptors 					*/
+	int fd_num								/* number of the passed descriptors			*/
+);
 
 /*--------------------------------------------------------------------------------------
 	Handles the elements of cs_stat TX queue
@@ -713,6 +751,41 @@ static int										/* No care now							*/
 cefnetd_input_from_csque_process (
 	CefT_Netd_Handle* hdl						/* cefnetd handle						*/
 );
+/*--------------------------------------------------------------------------------------
+	Verifies the message, or parks it to the verification worker
+----------------------------------------------------------------------------------------*/
+static int										/* Returns 1 if the message is parked	*/
+cefnetd_valid_msg_verify (
+	CefT_Netd_Handle* hdl,						/* cefnetd handle						*/
+	int faceid, 								/* Face-ID where messages arrived at	*/
+	int peer_faceid, 							/* Face-ID to reply to the origin of 	*/
+	unsigned char* msg, 						/* received message to verify			*/
+	uint16_t payload_len, 						/* Payload Length of this message		*/
+	uint16_t header_len,						/* Header Length of this message		*/
+	char* user_id,
+	int* res_p									/* result of cef_valid_msg_verify		*/
+);
+/*--------------------------------------------------------------------------------------
+	Re-injects the messages verified by the verification workers
+----------------------------------------------------------------------------------------*/
+static int										/* No care now							*/
+cefnetd_input_from_verifyque_process (
+	CefT_Netd_Handle* hdl						/* cefnetd handle						*/
+);
+/*--------------------------------------------------------------------------------------
+	Creates the verification workers
+----------------------------------------------------------------------------------------*/
+static int										/* Returns a negative value if it fails */
+cefnetd_verify_workers_create (
+	CefT_Netd_Handle* hdl						/* cefnetd handle						*/
+);
+/*--------------------------------------------------------------------------------------
+	Stops the verification workers and discards the parked messages
+----------------------------------------------------------------------------------------*/
+static void
+cefnetd_verify_workers_destroy (
+	CefT_Netd_Handle* hdl						/* cefnetd handle						*/
+);
 /*--------------------------------------------------------------------------------------
 	check state of port use
 ----------------------------------------------------------------------------------------*/
@@ -830,6 +903,11 @@ cefnetd_transmit_main_thread (
 	void* hdl							/* cefnetd handle						*/
 );
 
+static void *
+cefnetd_verify_worker_thread (
+	void* p								/* verification worker					*/
+);
+
 /****************************************************************************************
  ****************************************************************************************/
 /*--------------------------------------------------------------------------------------
@@ -881,6 +959,9 @@ cefnetd_handle_create (
 	hdl->tx_worker_num = CefC_TxWorkerDefault;
 #endif  // CefC_TxMultiThread
 	hdl->tx_que_size = CefC_TxQueueDefault;
+	hdl->verify_worker_num = CefC_VerifyWorkerDefault;
+	hdl->verify_pipe_fd[0] = -1;
+	hdl->verify_pipe_fd[1] = -1;
 	hdl->face_lifetime = -1;
 
 	hdl->ccninfo_access_policy = CefC_Default_CcninfoAccessPolicy;
@@ -900,6 +981,7 @@ cefnetd_handle_create (
 	hdl->Regular_max_lifetime	= CefC_Default_REGULAR_LIFETIME;
 	hdl->Ex_Cache_Access		= CefC_Default_CSMGR_ACCESS_RW;
 	hdl->Buffer_Cache_Time		= CefC_Default_BUFFER_CACHE_TIME * 1000;
+	hdl->Local_Shmring_Size		= CefC_Shmring_Size_Def;
 	hdl->cefstatus_pipe_fd[0]	= -1;
 	hdl->cefstatus_pipe_fd[1]	= -1;
 	//202108
@@ -1274,6 +1356,17 @@ cefnetd_handle_create (
 	pthread_mutex_init(&cefnetd_txqueue_mutex, NULL);
 	pthread_cond_init(&cefnetd_txqueue_cond, NULL);
 
+	/*#####*/
+	{	/* cefnetd_verify_worker_thread */
+		if (cefnetd_verify_workers_create (hdl) < 0) {
+			cefnetd_handle_destroy (hdl);
+			cef_log_write (CefC_Log_Error
+						, "%s Failed to create the new thread(cefnetd_verify_worker_thread)\n"
+						, __func__);
+			return (NULL);
+		}
+	}
+
 	/*#####*/
 	{	/* cefstatus_thread */
 		int flags;
@@ -1328,6 +1421,8 @@ cefnetd_handle_destroy (
 	cef_tp_plugin_destroy (hdl->plugin_hdl.tp);
 	cef_plugin_destroy (&(hdl->plugin_hdl));
 
+	cefnetd_verify_workers_destroy (hdl);
+
 #ifdef CefC_TxMultiThread
 	for (int i = 0; i < hdl->tx_worker_num; i++ ){
 		if ( hdl->tx_worker_que[i] ){
@@ -1486,9 +1581,9 @@ cefnetd_event_dispatch (
 	cef_log_write (CefC_Log_Info, "Running\n");
 	cefnetd_running_f = 1;
 
-	struct pollfd fds[CefC_Listen_Face_Max * 2];
-	CefC_Connection_Type fd_type[CefC_Listen_Face_Max * 2];
-	int faceids[CefC_Listen_Face_Max * 2];
+	struct pollfd fds[CefC_Poll_Fd_Max];
+	CefC_Connection_Type fd_type[CefC_Poll_Fd_Max];
+	int faceids[CefC_Poll_Fd_Max];
 	int fdnum;
 
 	while (cefnetd_running_f) {
@@ -1550,8 +1645,19 @@ cefnetd_event_dispatch (
 			}
 		}
 
+#if CefC_IsEnable_ContentStore
+		/* Sends the Interests gathered in this round to csmgrd at once 	*/
+		if (hdl->cs_stat->cache_type != CefC_Cache_Type_None) {
+			cef_csmgr_excache_lookup_push (hdl->cs_stat);
+			cef_csmgr_excache_access_push (hdl->cs_stat, nowt);
+		}
+#endif // CefC_IsEnable_ContentStore
+
 		cefnetd_input_from_csque_process (hdl);
 
+		/* Re-injects the messages whose signature has been verified 		*/
+		cefnetd_input_from_verifyque_process (hdl);
+
 #if CefC_IsEnable_ContentStore
 		if ((hdl->cs_stat->cache_type != CefC_Cache_Type_None) &&
 			(nowt > ccninfo_push_time)) {
@@ -1723,6 +1829,7 @@ cefnetd_poll_socket_prepare (
 	int res = 0;
 	int i;
 	int n;
+	CefT_Shmring_Pair* shm;
 
 	for (i = 0 ; i < hdl->inudpfdc ; i++) {
 		if (cef_face_check_active (hdl->inudpfaces[i]) > 0) {
@@ -1785,9 +1892,28 @@ cefnetd_poll_socket_prepare (
 			fd_type[res] = CefC_Connection_Type_Local;
 			faceids[res] = 0;
 			res++;
+
+			/* Doorbell of the shared memory ring 	*/
+			shm = cef_face_local_shmring_get (hdl->app_faces[i]);
+			if (shm) {
+				fds[res].events = POLLIN;
+				fds[res].fd = shm->rx.efd;
+				fd_type[res] = CefC_Connection_Type_Local;
+				faceids[res] = 0;
+				res++;
+			}
 		}
 	}
 
+	/* Doorbell of the verification workers 	*/
+	if (hdl->verify_pipe_fd[0] != -1) {
+		fds[res].events = POLLIN;
+		fds[res].fd = hdl->verify_pipe_fd[0];
+		fd_type[res] = CefC_Connection_Type_Local;
+		faceids[res] = 0;
+		res++;
+	}
+
 	return (res);
 }
 /*--------------------------------------------------------------------------------------
@@ -1887,6 +2013,280 @@ cefnetd_input_from_csque_process (
 	return (1);
 }
 
+/*--------------------------------------------------------------------------------------
+	Verifies the message, or parks it to the verification worker
+----------------------------------------------------------------------------------------*/
+static int										/* Returns 1 if the message is parked	*/
+cefnetd_valid_msg_verify (
+	CefT_Netd_Handle* hdl,						/* cefnetd handle						*/
+	int faceid, 								/* Face-ID where messages arrived at	*/
+	int peer_faceid, 							/* Face-ID to reply to the origin of 	*/
+	unsigned char* msg, 						/* received message to verify			*/
+	uint16_t payload_len, 						/* Payload Length of this message		*/
+	uint16_t header_len,						/* Header Length of this message		*/
+	char* user_id,
+	int* res_p									/* result of cef_valid_msg_verify		*/
+) {
+	CefT_Netd_VerifyWorker* wkr;
+	CefT_Netd_Verify_Elem* elem;
+	uint16_t msg_len = payload_len + header_len;
+	int i;
+
+	/* The message re-injected by cefnetd_input_from_verifyque_process 	*/
+	if (hdl->verify_reinject_f) {
+		hdl->verify_reinject_f = 0;
+		*res_p = hdl->verify_reinject_res;
+		return (0);
+	}
+
+	/* Only the signatures are verified by the workers, since CRC32C and 	*/
+	/* the messages without the validation are checked faster here 			*/
+	if ((hdl->verify_worker_num == 0) ||
+		(cef_valid_msg_alg_get (msg, msg_len) != CefC_T_RSA_SHA256)) {
+		*res_p = cef_valid_msg_verify (msg, msg_len);
+		return (0);
+	}
+
+	/* Selects the worker which has room for the message 		*/
+	wkr = NULL;
+	for (i = 0 ; i < hdl->verify_worker_num ; i++) {
+		wkr = &verify_worker_hdl[hdl->verify_worker_next];
+		hdl->verify_worker_next = (hdl->verify_worker_next + 1) % hdl->verify_worker_num;
+		if (wkr->parked_num < CefC_VerifyQueueSize - 1) {
+			break;
+		}
+		wkr = NULL;
+	}
+	elem = NULL;
+	if (wkr != NULL) {
+		elem = (CefT_Netd_Verify_Elem*) malloc (sizeof (CefT_Netd_Verify_Elem) + msg_len);
+	}
+	if (elem == NULL) {
+		/* All workers are busy, verifies here 		*/
+		*res_p = cef_valid_msg_verify (msg, msg_len);
+		return (0);
+	}
+
+	/* Parks the message until the worker verifies it 		*/
+	elem->type			= msg[CefC_O_Fix_Type];
+	elem->faceid		= faceid;
+	elem->peer_faceid	= peer_faceid;
+	elem->face_gen		= cef_face_generation_get (faceid);
+	elem->peer_gen		= cef_face_generation_get (peer_faceid);
+	elem->payload_len	= payload_len;
+	elem->header_len	= header_len;
+	elem->res			= -1;
+	elem->user_id[0]	= 0x00;
+	if (user_id) {
+		strncpy (elem->user_id, user_id, sizeof (elem->user_id) - 1);
+		elem->user_id[sizeof (elem->user_id) - 1] = 0x00;
+	}
+	memcpy (elem->msg, msg, msg_len);
+
+	if (cef_rngque_push (wkr->req_que, elem) == 0) {
+		free (elem);
+		*res_p = cef_valid_msg_verify (msg, msg_len);
+		return (0);
+	}
+	wkr->parked_num++;
+	pthread_mutex_lock (&wkr->mutex);
+	pthread_cond_signal (&wkr->cond);
+	pthread_mutex_unlock (&wkr->mutex);
+
+	return (1);
+}
+
+/*--------------------------------------------------------------------------------------
+	Re-injects the messages verified by the verification workers
+----------------------------------------------------------------------------------------*/
+static int										/* No care now							*/
+cefnetd_input_from_verifyque_process (
+	CefT_Netd_Handle* hdl						/* cefnetd handle						*/
+) {
+	CefT_Netd_VerifyWorker* wkr;
+	CefT_Netd_Verify_Elem* elem;
+	unsigned char buff[64];
+	int i;
+
+	if (hdl->verify_pipe_fd[0] == -1) {
+		return (1);
+	}
+	/* Clears the doorbell before looking at the queues 	*/
+	while (read (hdl->verify_pipe_fd[0], buff, sizeof (buff)) > 0) {
+		;
+	}
+
+	for (i = 0 ; i < hdl->verify_worker_num ; i++) {
+		wkr = &verify_worker_hdl[i];
+
+		while ((elem = (CefT_Netd_Verify_Elem*) cef_rngque_pop (wkr->cmp_que)) != NULL) {
+			wkr->parked_num--;
+
+			/* Discards the message if the face was closed while verifying it, 	*/
+			/* even if the Face-ID has been assigned to another peer 				*/
+			if ((cef_face_check_active (elem->peer_faceid) > 0) &&
+				(cef_face_generation_get (elem->peer_faceid) == elem->peer_gen) &&
+				(cef_face_generation_get (elem->faceid) == elem->face_gen)) {
+				hdl->verify_reinject_f   = 1;
+				hdl->verify_reinject_res = elem->res;
+				(*cefnetd_incoming_msg_process[elem->type])
+					(hdl, elem->faceid, elem->peer_faceid,
+						elem->msg, elem->payload_len, elem->header_len, elem->user_id);
+				hdl->verify_reinject_f   = 0;
+			}
+			free (elem);
+		}
+	}
+
+	return (1);
+}
+
+/*--------------------------------------------------------------------------------------
+	Creates the verification workers
+----------------------------------------------------------------------------------------*/
+static int										/* Returns a negative value if it fails */
+cefnetd_verify_workers_create (
+	CefT_Netd_Handle* hdl						/* cefnetd handle						*/
+) {
+	CefT_Netd_VerifyWorker* wkr;
+	int flags;
+	int i;
+
+	if (hdl->verify_worker_num == 0) {
+		return (1);
+	}
+
+	/* Creates the doorbell which wakes up the poll when the workers complete 	*/
+	if (pipe (hdl->verify_pipe_fd) == -1) {
+		cef_log_write (CefC_Log_Error, "%s pipe error (%s)\n"
+						, __func__, strerror(errno));
+		hdl->verify_pipe_fd[0] = -1;
+		hdl->verify_pipe_fd[1] = -1;
+		return (-1);
+	}
+	for (i = 0 ; i < 2 ; i++) {
+		if (((flags = fcntl (hdl->verify_pipe_fd[i], F_GETFL, 0)) < 0) ||
+			(fcntl (hdl->verify_pipe_fd[i], F_SETFL, flags | O_NONBLOCK) < 0)) {
+			cef_log_write (CefC_Log_Error, "%s fcntl error (%s)\n"
+							, __func__, strerror(errno));
+			return (-1);
+		}
+	}
+
+	for (i = 0 ; i < hdl->verify_worker_num ; i++) {
+		wkr = &verify_worker_hdl[i];
+		memset (wkr, 0x00, sizeof (CefT_Netd_VerifyWorker));
+		wkr->worker_id = i;
+		wkr->doorbell_fd = hdl->verify_pipe_fd[1];
+		wkr->req_que = cef_rngque_create (CefC_VerifyQueueSize);
+		wkr->cmp_que = cef_rngque_create (CefC_VerifyQueueSize);
+		if ((wkr->req_que == NULL) || (wkr->cmp_que == NULL)) {
+			cef_log_write (CefC_Log_Error,
+				"Failed to cef_rngque_create [%d/%d]\n", i, hdl->verify_worker_num);
+			return (-1);
+		}
+		pthread_mutex_init (&wkr->mutex, NULL);
+		pthread_cond_init (&wkr->cond, NULL);
+
+		wkr->running_f = 1;
+		if (cef_pthread_create (&wkr->th, NULL
+				, &cefnetd_verify_worker_thread, wkr) == -1) {
+			wkr->running_f = 0;
+			return (-1);
+		}
+	}
+
+	return (1);
+}
+
+/*--------------------------------------------------------------------------------------
+	Stops the verification workers and discards the parked messages
+----------------------------------------------------------------------------------------*/
+static void
+cefnetd_verify_workers_destroy (
+	CefT_Netd_Handle* hdl						/* cefnetd handle						*/
+) {
+	CefT_Netd_VerifyWorker* wkr;
+	void* elem;
+	int i;
+
+	for (i = 0 ; i < hdl->verify_worker_num ; i++) {
+		wkr = &verify_worker_hdl[i];
+
+		if (wkr->running_f) {
+			pthread_mutex_lock (&wkr->mutex);
+			wkr->running_f = 0;
+			pthread_cond_signal (&wkr->cond);
+			pthread_mutex_unlock (&wkr->mutex);
+			pthread_join (wkr->th, NULL);
+		}
+		if (wkr->req_que) {
+			while ((elem = cef_rngque_pop (wkr->req_que)) != NULL) {
+				free (elem);
+			}
+			cef_rngque_destroy (wkr->req_que);
+			wkr->req_que = NULL;
+		}
+		if (wkr->cmp_que) {
+			while ((elem = cef_rngque_pop (wkr->cmp_que)) != NULL) {
+				free (elem);
+			}
+			cef_rngque_destroy (wkr->cmp_que);
+			wkr->cmp_que = NULL;
+		}
+		pthread_mutex_destroy (&wkr->mutex);
+		pthread_cond_destroy (&wkr->cond);
+	}
+	for (i = 0 ; i < 2 ; i++) {
+		if (hdl->verify_pipe_fd[i] != -1) {
+			close (hdl->verify_pipe_fd[i]);
+			hdl->verify_pipe_fd[i] = -1;
+		}
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+	Attaches the shared memory rings passed by the local process
+----------------------------------------------------------------------------------------*/
+static void
+cefnetd_input_shmring_open (
+	CefT_Netd_Handle* hdl,						/* cefnetd handle						*/
+	int app_idx,								/* index of the local connection 		*/
+	unsigned char* msg,							/* the received message 				*/
+	int msg_len,								/* length of the received message 		*/
+	int fds[],									/* passed file descriptors 				*/
+	int fd_num									/* number of the passed descriptors		*/
+) {
+	CefT_Shmring_Pair* pair = NULL;
+	const char* rsp = CefC_Shmring_Reject;
+	int i;
+
+	if ((hdl->Local_Shmring_Size > 0) &&
+		(fd_num == CefC_Shmring_Fd_Num) &&
+		(msg_len == (int) strlen (CefC_Shmring_Open)) &&
+		(memcmp (msg, CefC_Shmring_Open, msg_len) == 0)) {
+
+		/* The rings are closed in cef_shmring_pair_attach if it fails 	*/
+		pair = cef_shmring_pair_attach (fds);
+		if (pair) {
+			if (cef_face_local_shmring_set (hdl->app_faces[app_idx], pair) < 0) {
+				cef_shmring_pair_destroy (pair);
+				pair = NULL;
+			}
+		}
+	} else {
+		for (i = 0 ; i < fd_num ; i++) {
+			close (fds[i]);
+		}
+	}
+	if (pair) {
+		rsp = CefC_Shmring_Accept;
+	}
+	cef_log_write (CefC_Log_Info, "Local Face#%d uses %s\n",
+		hdl->app_faces[app_idx], (pair) ? "the shared memory ring" : "the socket");
+
+	send (hdl->app_fds[app_idx], rsp, CefC_Shmring_Reply_Len, 0);
+}
 /*--------------------------------------------------------------------------------------
 	Accepts and receives the frame(s) from local face
 ----------------------------------------------------------------------------------------*/
@@ -1906,6 +2306,9 @@ cefnetd_input_from_local_process (
 	unsigned char* rsp_msg = hdl->app_rsp_msg;
 	struct pollfd send_fds[1];
 	char	user_id[512];
+	int shm_fds[CefC_Shmring_Fd_Num];
+	int shm_fd_num;
+	CefT_Shmring_Pair* shm;
 
 	/* Obtains the FD for local face 	*/
 	sock = cef_face_get_fd_from_faceid (CefC_Faceid_Local);
@@ -1955,9 +2358,38 @@ cefnetd_input_from_local_process (
 
 	/* Checks whether frame(s) arrivals from the active local faces */
 	for (i = 0 ; i < hdl->app_fds_num ; i++) {
-		len = recv (hdl->app_fds[i], buff, CefC_Max_Length, 0);
+		/* Frames written into the shared memory ring by the application 	*/
+		shm = cef_face_local_shmring_get (hdl->app_faces[i]);
+		if (shm) {
+			len = cef_shmring_read (&shm->rx, buff, CefC_Max_Length);
+			if (len > 0) {
+				hdl->app_steps[i] = 0;
+				cefnetd_input_message_process (
+						hdl, CefC_Faceid_Local, hdl->app_faces[i], buff, len, user_id);
+			} else if (len < 0) {
+				/* The application broke the ring, closes the face 	*/
+				cef_log_write (CefC_Log_Warn,
+					"Broken shared memory ring, closed the Face#%d\n", hdl->app_faces[i]);
+				cef_face_close (hdl->app_faces[i]);
+				hdl->app_fds[i] = -1;
+				hdl->app_fds_num--;
+
+				for (flag = i ; flag < hdl->app_fds_num ; flag++) {
+					hdl->app_fds[flag] = hdl->app_fds[flag + 1];
+					hdl->app_faces[flag] = hdl->app_faces[flag + 1];
+					hdl->app_steps[flag] = hdl->app_steps[flag + 1];
+				}
+				i--;
+				continue;
+			}
+		}
+
+		len = cef_shmring_fds_recv (
+				hdl->app_fds[i], buff, CefC_Max_Length, shm_fds, &shm_fd_num);
 
-		if (len > 0) {
+		if ((len > 0) && (shm_fd_num > 0)) {
+			cefnetd_input_shmring_open (hdl, i, buff, len, shm_fds, shm_fd_num);
+		} else if (len > 0) {
 			hdl->app_steps[i] = 0;
 
 			if (memcmp (buff, CefC_Ctrl, CefC_Ctrl_Len) == 0) {
@@ -3325,6 +3757,41 @@ cef_dbg_write (CefC_Dbg_Finer, "rcv_len=%u, move_len=%u, msg_size=%u\n", hdl->cs
 		msg += move_len;
 
 		while (hdl->cs_stat->rcvbuf.rcv_len > 0) {
+			/* Consumes the Bulk_Cob message which follows the Cobs replied to 	*/
+			/* the Bulk Interest 												*/
+			if ((hdl->cs_stat->rcvbuf.rcv_len > CefC_Csmgr_Msg_HeaderLen) &&
+				(hdl->cs_stat->rcvbuf.rcv_buff[CefC_O_Fix_Ver] == CefC_Version) &&
+				(hdl->cs_stat->rcvbuf.rcv_buff[CefC_O_Fix_Type]
+					== CefC_Csmgr_Msg_Type_Bulk_Cob)) {
+				unsigned char* bitmap;
+				uint16_t bulk_len;
+				uint16_t bulk_num;
+
+				memcpy (&bulk_len,
+					&hdl->cs_stat->rcvbuf.rcv_buff[CefC_O_Fix_PacketLength], CefC_S_Length);
+				bulk_len = ntohs (bulk_len);
+				if (bulk_len > hdl->cs_stat->rcvbuf.rcv_len) {
+					break;
+				}
+				if ((bulk_len > CefC_Csmgr_Msg_HeaderLen) &&
+					(cef_csmgr_bulk_cob_parse (
+						&hdl->cs_stat->rcvbuf.rcv_buff[CefC_Csmgr_Msg_HeaderLen],
+						bulk_len - CefC_Csmgr_Msg_HeaderLen, &bulk_num, &bitmap) == 0)) {
+#ifdef CefC_Debug
+					cef_dbg_write (CefC_Dbg_Finer,
+						"Bulk_Cob from csmgrd, num=%u\n", bulk_num);
+					cef_dbg_buff_write (CefC_Dbg_Finest, bitmap, (bulk_num + 7) / 8);
+#endif // CefC_Debug
+				} else {
+					/* Skips the header of the broken message 	*/
+					bulk_len = CefC_Csmgr_Msg_HeaderLen;
+				}
+				hdl->cs_stat->rcvbuf.rcv_len -= bulk_len;
+				memmove (hdl->cs_stat->rcvbuf.rcv_buff,
+					&hdl->cs_stat->rcvbuf.rcv_buff[bulk_len], hdl->cs_stat->rcvbuf.rcv_len);
+				continue;
+			}
+
 			/* Seeks the top of the message */
 			res = cefnetd_messege_head_seek (-1,
 						&(hdl->cs_stat->rcvbuf), &fdv_payload_len, &fdv_header_len);
@@ -3395,7 +3862,11 @@ cefnetd_incoming_interest_process (
 	}
 
 	/* Checks the Validation 			*/
-	res = cef_valid_msg_verify (msg, payload_len + header_len);
+	if (cefnetd_valid_msg_verify (hdl, faceid, peer_faceid,
+			msg, payload_len, header_len, user_id, &res) > 0) {
+		/* Processed again when the worker has verified it 	*/
+		return (1);
+	}
 	if (res != 0) {
 		/* ★ここでcef_frame_message_parseしてalg.keyidをチェックする★ */
 		CefT_CcnMsg_OptHdr poh_temp = {0};
@@ -3933,7 +4404,11 @@ cefnetd_incoming_object_process (
 	pkt_len = payload_len + header_len;	//0.8.3
 
 	/* Checks the Validation 			*/
-	res = cef_valid_msg_verify (msg, payload_len + header_len);
+	if (cefnetd_valid_msg_verify (hdl, faceid, peer_faceid,
+			msg, payload_len, header_len, user_id, &res) > 0) {
+		/* Processed again when the worker has verified it 	*/
+		return (1);
+	}
 	if (res != 0) {
 		cef_log_write (CefC_Log_Info, "Drops a malformed Object.\n");
 		return (-1);
@@ -6076,6 +6551,14 @@ cefnetd_config_read (
 			}
 			hdl->Buffer_Cache_Time = res * 1000;
 		}
+		else if ( strcasecmp (pname, CefC_ParamName_LocalShmRing) == 0 ) {
+			res = atoi(ws);
+			if ( res < 0 ) {
+				cef_log_write (CefC_Log_Error, "LOCAL_SHM_RING_SIZE must be higher than or equal to 0.\n");
+				return (-1);
+			}
+			hdl->Local_Shmring_Size = (uint32_t) res;
+		}
 		//202108
 #ifdef	CefC_INTEREST_RETURN
 		else if ( strcasecmp (pname, CefC_ParamName_IR_Option) == 0 ) {
@@ -6143,6 +6626,14 @@ cefnetd_config_read (
 			hdl->tx_worker_num = num;
 		}
 #endif // CefC_TxMultiThread
+		else if (strcmp (pname, "VERIFY_WORKER_NUM") == 0) {
+			long num = strtol (ws, NULL, 10);
+			if ( num < 0 || CefC_VerifyWorkerMax < num ){
+				cef_log_write (CefC_Log_Error, "VERIFY_WORKER_NUM must be lower than %d.\n", CefC_VerifyWorkerMax+1);
+				return (-1);
+			}
+			hdl->verify_worker_num = num;
+		}
 		else if (strcmp (pname, "TX_QUEUE_SIZE") == 0) {
 			long num = strtol (ws, NULL, 10);
 			if ( num < CefC_Tx_Que_Size ){
@@ -6199,6 +6690,7 @@ cefnetd_config_read (
 	cef_dbg_write (CefC_Dbg_Fine, "CSMGR_ACCESS = %s\n",
 					(hdl->Ex_Cache_Access == CefC_Default_CSMGR_ACCESS_RW) ? "RW" : "RO" );
 	cef_dbg_write (CefC_Dbg_Fine, "BUFFER_CACHE_TIME    = %d\n", hdl->Buffer_Cache_Time);
+	cef_dbg_write (CefC_Dbg_Fine, "LOCAL_SHM_RING_SIZE  = %u\n", hdl->Local_Shmring_Size);
 	cef_dbg_write (CefC_Dbg_Fine, "ENABLE_INTEREST_RETURN = %d\n", hdl->IR_Option);
 	cef_dbg_write (CefC_Dbg_Fine, "ENABLED_RETURN_CODE = %d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n", hdl->IR_enable[0],
 																						   hdl->IR_enable[1],
@@ -6226,6 +6718,7 @@ cefnetd_config_read (
 	cef_dbg_write (CefC_Dbg_Fine, "TX_WORKER_NUM = %d\n", hdl->tx_worker_num);
 #endif // CefC_TxMultiThread
 	cef_dbg_write (CefC_Dbg_Fine, "TX_QUEUE_SIZE = %d\n", hdl->tx_que_size);
+	cef_dbg_write (CefC_Dbg_Fine, "VERIFY_WORKER_NUM = %d\n", hdl->verify_worker_num);
 	cef_dbg_write (CefC_Dbg_Fine, "UDP_LISTEN_ADDR = %s\n", hdl->udp_listen_addr);
 
 	if ( hdl->My_Node_Name != NULL ) {
@@ -8501,6 +8994,50 @@ cefnetd_get_waittime(
 	return ts;
 }
 
+/*--------------------------------------------------------------------------------------
+	Verifies the signatures of the parked messages
+----------------------------------------------------------------------------------------*/
+static void *
+cefnetd_verify_worker_thread (
+	void *p
+) {
+	CefT_Netd_VerifyWorker* wkr = p;
+	CefT_Netd_Verify_Elem* elem;
+
+#ifdef CefC_Debug
+cef_dbg_write (CefC_Dbg_Finer, "verify worker#%d thread(%p) start..\n", wkr->worker_id, pthread_self());
+#endif // CefC_Debug
+
+	while (wkr->running_f) {
+
+		/* Pop one message from the request queue 		*/
+		elem = (CefT_Netd_Verify_Elem*) cef_rngque_pop (wkr->req_que);
+
+		if (!elem) {
+			struct timespec ts = { 0, 0 };
+
+			cefnetd_get_waittime (&ts, 100000);
+			pthread_mutex_lock (&wkr->mutex);
+			if (wkr->running_f && (cef_rngque_read (wkr->req_que) == NULL)) {
+				pthread_cond_timedwait (&wkr->cond, &wkr->mutex, &ts);
+			}
+			pthread_mutex_unlock (&wkr->mutex);
+			continue;
+		}
+
+		elem->res = cef_valid_msg_verify (
+						elem->msg, elem->payload_len + elem->header_len);
+
+		/* cefnetd bounds the parked messages, so the push always succeeds 	*/
+		cef_rngque_push (wkr->cmp_que, elem);
+		if (write (wkr->doorbell_fd, "", 1) < 0) {
+			/* The doorbell is full, cefnetd is already woken up 	*/
+		}
+	}
+
+	return (NULL);
+}
+
 #ifdef CefC_TxMultiThread
 static void *
 cefnetd_transmit_worker_thread (
@@ -114,9 +114,16 @@
 #define CefC_Cefstatus_MsgSize		128
 
 #define CefC_Listen_Face_Max		CefC_Face_Router_Max
+#define CefC_Poll_Fd_Max			(CefC_Listen_Face_Max * 2 + CefC_App_Conn_Num * 2 + 3)
+											/* UDP/TCP faces, local faces with the doorbells	*/
+											/* of the shared memory rings, csmgr sockets and	*/
+											/* the doorbell of the verification workers			*/
 #define	CefC_TxWorkerMax			32
 #define	CefC_TxWorkerDefault		(CefC_TxWorkerMax/4)
 #define	CefC_TxQueueDefault			(CefC_Tx_Que_Size*CefC_TxWorkerMax)
+#define	CefC_VerifyWorkerMax		16
+#define	CefC_VerifyWorkerDefault	0		/* verifies on the forwarding thread	*/
+#define	CefC_VerifyQueueSize		1024	/* messages parked per worker			*/
 
 /* cefstatus output option */
 #define CefC_Ctrl_StatusOpt_Stat	0x0001
@@ -242,6 +249,7 @@ typedef struct {
 	int					Regular_max_lifetime;
 	int					Ex_Cache_Access;		/* 0:Read/Write   1:ReadOnly			*/
 	uint32_t			Buffer_Cache_Time;		/* Buffer cahce timt					*/
+	uint32_t			Local_Shmring_Size;		/* Ring size for local faces (0:off)	*/
 												/* for KeyIdRestriction					*/
 												/* Private key, public key prefix		*/
 												/*   Private key name: 					*/
@@ -371,6 +379,13 @@ typedef struct {
 	uint	 			tx_que_size;
 	CefT_Mp_Handle 		tx_que_mp;
 
+	/*** signature verification workers 		***/
+	uint16_t 			verify_worker_num;		/* 0 verifies on the forwarding thread	*/
+	uint16_t 			verify_worker_next;		/* worker to which the next is parked	*/
+	int 				verify_reinject_f;		/* 1 while re-injecting a verified msg	*/
+	int 				verify_reinject_res;	/* verification result of the above 	*/
+	int 				verify_pipe_fd[2];		/* doorbell rung by the workers 		*/
+
 	/*** Key Pair Management ***/
 	CefT_KeyPair_Entry*	keypair_table_head;		/* Key pair table */
 
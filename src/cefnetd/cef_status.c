@@ -271,6 +271,16 @@ cef_status_stats_output (
 		goto endfunc;
 	}
 #endif	// CefC_INTEREST_RETURN
+	{
+		uint64_t vc_hit, vc_miss;
+
+		cef_valid_verify_cache_stat_get (&vc_hit, &vc_miss);
+		sprintf (work_str, "Verify Cache     : hit %llu, miss %llu\n"
+			, (unsigned long long) vc_hit, (unsigned long long) vc_miss);
+		if ((fret=cef_status_add_output_to_rsp_buf(work_str)) != 0){
+			goto endfunc;
+		}
+	}
 
 	/* output Interest details when -i option is specified */
 	if (output_opt_f & CefC_Ctrl_StatusOpt_Interest) {
@@ -1219,6 +1229,21 @@ cef_status_localcache_output (
 	if ((fret=cef_status_add_output_to_rsp_buf(work_str)) != 0){
 		return (-1);
 	}
+	{
+		uint64_t cobs, bytes, cap_bytes;
+
+		cef_mem_cache_usage_get (&cobs, &bytes, &cap_bytes);
+		if (cap_bytes > 0) {
+			sprintf (work_str, "\n  Cobs : "FMTU64", Bytes : "FMTU64" / "FMTU64
+						, cobs, bytes, cap_bytes);
+		} else {
+			sprintf (work_str, "\n  Cobs : "FMTU64", Bytes : "FMTU64" / Unlimited"
+						, cobs, bytes);
+		}
+		if ((fret=cef_status_add_output_to_rsp_buf(work_str)) != 0){
+			return (-1);
+		}
+	}
 
 	fret = cef_mem_cache_mstat_get_buff (buff_str, CefC_Max_Length);
 
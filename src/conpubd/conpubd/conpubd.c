@@ -82,6 +82,17 @@
 
 #define CefC_Cpub_InconsistentVersion			-1000
 
+/* Macros used in the publish pipeline */
+#define CefC_Cpub_Pipeline_Depth				16	/* Cobs in flight per worker		*/
+#define CefC_Cpub_Cob_Empty						0	/* Slot has no Cob					*/
+#define CefC_Cpub_Cob_Built						1	/* Slot has the built Cob			*/
+#define CefC_Cpub_Cob_Failed					-1	/* Failed to build the Cob			*/
+
+/* Macros used in the signature sidecar files */
+#define CefC_Cpub_Sign_Magic					"CPS2"	/* Magic of the sidecar file	*/
+#define CefC_Cpub_Sign_Suffix					".sig"
+#define CefC_Cpub_Sign_Max						256		/* Max length of a signature	*/
+
 
 /****************************************************************************************
  Structures Declaration
@@ -98,6 +109,141 @@ typedef struct _CefT_Cpubctlg_Hdl {
 	struct _CefT_Cpubctlg_Hdl* next;
 } CefT_Cpubctlg_Hdl;
 
+/* Cob built by a publish worker */
+typedef struct {
+
+	int 				state;			/* CefC_Cpub_Cob_xxx						*/
+	unsigned char*		msg;			/* built Cob (NULL if it is not created)	*/
+	int 				msg_len;
+	uint16_t			pay_len;
+
+} CefT_Cpub_Built_Cob;
+
+/* Pipeline which builds and signs the Cobs of a content. The workers read the	*/
+/* blocks of the file and build the Cobs in parallel, the publishing thread		*/
+/* commits them to the cache plugin in the order of the chunk number.			*/
+typedef struct {
+
+	pthread_mutex_t 		mutex;
+	pthread_cond_t 			built_cond;		/* signaled when a Cob is built			*/
+	pthread_cond_t 			free_cond;		/* signaled when a Cob is committed		*/
+	int 					fd;				/* source file							*/
+	off_t 					file_size;
+	int 					block_size;
+	uint32_t 				cob_num;		/* number of the Cobs to build			*/
+	uint32_t 				next_seq;		/* next chunk to build					*/
+	uint32_t 				commit_seq;		/* next chunk to commit					*/
+	int 					abort_f;
+	CefT_CcnMsg_OptHdr* 	opt;
+	CefT_CcnMsg_MsgBdy* 	prames;			/* parameters of the Cobs				*/
+	CefT_CcnMsg_MsgBdy* 	last_prames;	/* parameters of the last Cob			*/
+	CefT_Cpub_Built_Cob* 	slots;			/* ring indexed by the chunk number		*/
+	uint32_t 				slot_num;
+
+} CefT_Cpub_Pipeline;
+
+/* Signature record of the sidecar file */
+typedef struct {
+
+	unsigned char 			digest[SHA256_DIGEST_LENGTH];	/* digest of the signed	*/
+															/* message				*/
+	uint16_t 				sign_len;
+	unsigned char 			sign[CefC_Cpub_Sign_Max];
+	uint32_t 				crc;				/* CRC-32C of the above fields		*/
+
+} CefT_Cpub_Sign_Rec;
+
+/* Header of the sidecar file, followed by the records sorted by the digest */
+typedef struct {
+
+	char 					magic[4];
+	uint32_t 				rec_num;
+	unsigned char 			key[SHA256_DIGEST_LENGTH];	/* hash of the file hash,	*/
+														/* block size and name		*/
+	unsigned char 			keyid[CefC_KeyId_SIZ];		/* key id of the signer		*/
+
+} CefT_Cpub_Sign_Hdr;
+
+/* Signatures of the content being published. The sidecar file of the content	*/
+/* is mapped, and the signatures of the Cobs which are not changed are reused	*/
+/* without the private key operation.											*/
+typedef struct {
+
+	int 					active_f;
+	unsigned char 			name[CefC_Max_Length];
+	uint16_t 				name_len;
+	char 					path[PATH_MAX];		/* sidecar file						*/
+	unsigned char 			key[SHA256_DIGEST_LENGTH];
+	unsigned char 			keyid[CefC_KeyId_SIZ];
+	int 					stale_f;			/* sidecar file of the old content	*/
+	unsigned char* 			map;				/* mapped sidecar file				*/
+	size_t 					map_size;
+	CefT_Cpub_Sign_Rec* 	recs;				/* records of the sidecar file		*/
+	uint32_t 				rec_num;
+	unsigned char* 			used;				/* 1 if the record is reused		*/
+	uint32_t 				used_num;
+	uint32_t 				invalid_num;		/* records which failed to verify	*/
+	CefT_Cpub_Sign_Rec* 	new_recs;			/* records signed in this publishing*/
+	uint32_t 				new_num;
+	uint32_t 				new_max;
+
+} CefT_Cpub_Sign_Store;
+
+/* Reference to a content definition, used to sort the definitions by name */
+typedef struct {
+
+	CefT_Cpubcnt_Hdl* 		cnt;
+	uint32_t 				pos;			/* position in the definition list		*/
+
+} CefT_Cpubcnt_Ref;
+
+struct _CefT_Cpub_Lazy_Cob;
+
+/* Content published in the lazy mode. The Cobs are read from the file when	*/
+/* the Interests arrive, as long as the file is the one which was published.	*/
+typedef struct _CefT_Cpub_Lazy_Cont {
+
+	dev_t 					dev;			/* identity of the published file		*/
+	ino_t 					ino;
+	off_t 					file_size;
+	struct timespec 		mtime;
+	uint32_t 				cob_num;
+	int 					block_size;
+	CefT_CcnMsg_OptHdr 		opt;
+	CefT_CcnMsg_MsgBdy* 	prames;			/* parameters of the Cobs				*/
+	CefT_CcnMsg_MsgBdy* 	last_prames;	/* parameters of the last Cob			*/
+	struct _CefT_Cpub_Lazy_Cob* cobs;		/* Cobs of the content in the LRU		*/
+
+} CefT_Cpub_Lazy_Cont;
+
+/* Cob built in the lazy mode */
+typedef struct _CefT_Cpub_Lazy_Cob {
+
+	CefT_Cpub_Lazy_Cont* 	cont;
+	uint32_t 				chunk_num;
+	unsigned char* 			msg;
+	uint16_t 				msg_len;
+	struct _CefT_Cpub_Lazy_Cob* hnext;		/* next in the hash bucket				*/
+	struct _CefT_Cpub_Lazy_Cob* prev;		/* LRU list								*/
+	struct _CefT_Cpub_Lazy_Cob* next;
+	struct _CefT_Cpub_Lazy_Cob* cprev;		/* Cobs of the same content				*/
+	struct _CefT_Cpub_Lazy_Cob* cnext;
+
+} CefT_Cpub_Lazy_Cob;
+
+/* LRU of the Cobs built in the lazy mode */
+typedef struct {
+
+	CefT_Cpub_Lazy_Cob** 	buckets;
+	uint32_t 				bucket_mask;
+	uint32_t 				capacity;
+	uint32_t 				cob_num;
+	CefT_Cpub_Lazy_Cob* 	head;			/* most recently used					*/
+	CefT_Cpub_Lazy_Cob* 	tail;			/* least recently used					*/
+	unsigned char* 			cobbuff;
+
+} CefT_Cpub_Lazy_Lru;
+
 /****************************************************************************************
  State Variables
  ****************************************************************************************/
@@ -119,6 +265,13 @@ static uint64_t Intial_free_mem_mega = 0;
 
 static CefT_Cpubctlg_Hdl Cpbctlghdl;					/* Catalog Data entry */
 
+static CefT_Cpub_Lazy_Lru 	Lazy_lru;					/* Cobs built in the lazy mode */
+static pthread_mutex_t 		conpub_lazy_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static CefT_Cpub_Sign_Store Sign_store;					/* Signatures of the content	*/
+														/* being published				*/
+static pthread_mutex_t 		conpub_sign_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /* Work areas */
 static CefT_CcnMsg_MsgBdy* Cob_prames_p = NULL;
 static unsigned char* 		Cob_msg_p = NULL;
@@ -360,6 +513,53 @@ conpub_contdef_read (
 	CefT_Conpubd_Handle* hdl,				/* conpub daemon handle						*/
 	CefT_Cpubcnt_Hdl* cnthdl
 );
+/*--------------------------------------------------------------------------------------
+	Removes the duplicate definitions of the same URI
+----------------------------------------------------------------------------------------*/
+static int									/* Returns a negative value if it fails 	*/
+conpub_contdef_dup_remove (
+	CefT_Cpubcnt_Hdl* cnthdl
+);
+/*--------------------------------------------------------------------------------------
+	Calculates the fingerprint of the content definition
+----------------------------------------------------------------------------------------*/
+static uint64_t
+conpubd_cnt_fingerprint_calc (
+	CefT_Cpubcnt_Hdl* entry,
+	struct stat* st								/* status of the content file			*/
+);
+/*--------------------------------------------------------------------------------------
+	Creates the references to the content definitions sorted by name
+----------------------------------------------------------------------------------------*/
+static CefT_Cpubcnt_Ref*					/* The return value is null if an error occurs	*/
+conpubd_cnt_refs_create (
+	CefT_Cpubcnt_Hdl* cnthdl,
+	uint32_t* ref_num
+);
+/*--------------------------------------------------------------------------------------
+	Compares the names of the content definitions
+----------------------------------------------------------------------------------------*/
+static int
+conpubd_cnt_name_compare (
+	const void* a,
+	const void* b
+);
+/*--------------------------------------------------------------------------------------
+	Compares the content definitions by name and the position in the file
+----------------------------------------------------------------------------------------*/
+static int
+conpubd_cnt_ref_compare (
+	const void* a,
+	const void* b
+);
+/*--------------------------------------------------------------------------------------
+	Unlinks and frees the dropped content definitions
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_cnt_list_drop (
+	CefT_Cpubcnt_Hdl* cnthdl,
+	const unsigned char* drop					/* drop flag of each position			*/
+);
 /*--------------------------------------------------------------------------------------
 	Triming a line read from a file
 ----------------------------------------------------------------------------------------*/
@@ -429,6 +629,153 @@ conpubd_publish_content_create (
 	CefT_Cpubcnt_Hdl* entry,
 	time_t now_time
 );
+/*--------------------------------------------------------------------------------------
+	Builds the Cobs of the content in the publish pipeline
+----------------------------------------------------------------------------------------*/
+static void*
+conpubd_publish_worker_thread (
+	void* arg
+);
+/*--------------------------------------------------------------------------------------
+	Waits for the Cob of the specified chunk from the publish pipeline
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+conpubd_publish_cob_take (
+	CefT_Cpub_Pipeline* pl,
+	uint32_t seq,
+	CefT_Cpub_Built_Cob* cob
+);
+/*--------------------------------------------------------------------------------------
+	Sets the parameters of the Cobs of the content
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+conpubd_publish_prames_set (
+	CefT_Conpubd_Handle* hdl,					/* conpub daemon handle					*/
+	CefT_Cpubcnt_Hdl* entry,
+	CefT_CcnMsg_MsgBdy* prames,					/* parameters of the Cobs				*/
+	CefT_CcnMsg_OptHdr* opt,
+	CefT_CcnMsg_MsgBdy** last_prames			/* parameters of the last Cob (NULL if	*/
+												/* it is same as prames)				*/
+);
+/*--------------------------------------------------------------------------------------
+	Opens the signature sidecar file of the content to publish
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_sign_store_open (
+	CefT_Conpubd_Handle* hdl,					/* conpub daemon handle					*/
+	CefT_Cpubcnt_Hdl* entry,
+	int fd,										/* content file							*/
+	off_t file_size
+);
+/*--------------------------------------------------------------------------------------
+	Closes the signature sidecar file and writes the signatures which are used
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_sign_store_close (
+	int commit_f								/* 1 if the content is published		*/
+);
+/*--------------------------------------------------------------------------------------
+	Creates the path of the signature sidecar file of the content
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_sign_path_create (
+	CefT_Conpubd_Handle* hdl,					/* conpub daemon handle					*/
+	const unsigned char* name,
+	int name_len,
+	char* path
+);
+/*--------------------------------------------------------------------------------------
+	Removes the signature sidecar file of the content which is no longer published
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_sign_remove (
+	CefT_Conpubd_Handle* hdl,					/* conpub daemon handle					*/
+	CefT_Cpubcnt_Hdl* entry
+);
+/*--------------------------------------------------------------------------------------
+	Looks up the signature of the digest in the sidecar file
+----------------------------------------------------------------------------------------*/
+static int									/* 1 if the signature is found				*/
+conpubd_sign_lookup (
+	const unsigned char* name,
+	int name_len,
+	const unsigned char* digest,
+	unsigned char* sign,
+	unsigned int* sign_len
+);
+/*--------------------------------------------------------------------------------------
+	Stores the signature computed in the publishing
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_sign_store (
+	const unsigned char* name,
+	int name_len,
+	const unsigned char* digest,
+	const unsigned char* sign,
+	unsigned int sign_len
+);
+/*--------------------------------------------------------------------------------------
+	Compares the digests of the signature records
+----------------------------------------------------------------------------------------*/
+static int
+conpubd_sign_rec_compare (
+	const void* a,
+	const void* b
+);
+/*--------------------------------------------------------------------------------------
+	Publishes the content in the lazy mode
+----------------------------------------------------------------------------------------*/
+static int
+conpubd_publish_lazy_content_create (
+	CefT_Conpubd_Handle* hdl,					/* conpub daemon handle					*/
+	CefT_Cpubcnt_Hdl* entry
+);
+/*--------------------------------------------------------------------------------------
+	Releases the content published in the lazy mode
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_lazy_content_release (
+	CefT_Cpubcnt_Hdl* entry
+);
+/*--------------------------------------------------------------------------------------
+	Creates the LRU of the Cobs built in the lazy mode
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+conpubd_lazy_lru_create (
+	uint32_t capacity							/* max number of the Cobs				*/
+);
+/*--------------------------------------------------------------------------------------
+	Destroys the LRU of the Cobs built in the lazy mode
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_lazy_lru_destroy (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Returns the hash bucket of the Cob built in the lazy mode
+----------------------------------------------------------------------------------------*/
+static CefT_Cpub_Lazy_Cob**
+conpubd_lazy_lru_bucket (
+	CefT_Cpub_Lazy_Cont* lc,
+	uint32_t chunk_num
+);
+/*--------------------------------------------------------------------------------------
+	Removes the Cob from the LRU
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_lazy_lru_remove (
+	CefT_Cpub_Lazy_Cob* cob
+);
+/*--------------------------------------------------------------------------------------
+	Builds the Cob of the content published in the lazy mode and sends it
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+conpubd_lazy_cob_send (
+	CefT_Conpubd_Handle* hdl,					/* conpub daemon handle					*/
+	CefT_Cpubcnt_Hdl* entry,
+	uint32_t chunk_num,
+	int sock									/* socket to send the Cob				*/
+);
 /*--------------------------------------------------------------------------------------
 	Deletes the Cobs
 ----------------------------------------------------------------------------------------*/
@@ -664,6 +1011,16 @@ main (
 		return (-1);
 	}
 
+	if ((hdl->lazy_publish) &&
+		(conpubd_lazy_lru_create (hdl->lazy_cache_cobs) < 0)) {
+		cef_log_write (CefC_Log_Error, "Unable to create woek area (Lazy_lru).\n");
+		conpubd_post_process (hdl);
+		return (-1);
+	}
+	if ((hdl->sign_cache_dir[0] != 0x00) && (hdl->valid_type == CefC_T_RSA_SHA256)) {
+		cef_valid_sign_cache_set (conpubd_sign_lookup, conpubd_sign_store);
+	}
+
 	/* Inits cefcontentserver */
 	rtc = conpubd_init (conpub_conf_dir);
 	if (rtc < 0) {
@@ -745,6 +1102,10 @@ conpubd_handle_create (
 	hdl->cache_default_rct = conf_param.cache_default_rct;
 	hdl->valid_type = (uint16_t)cef_valid_type_get (conf_param.Valid_Alg);
 	hdl->block_size = conf_param.block_size;
+	hdl->publish_workers = conf_param.publish_workers;
+	hdl->lazy_publish = conf_param.lazy_publish;
+	hdl->lazy_cache_cobs = conf_param.lazy_cache_cobs;
+	strcpy (hdl->sign_cache_dir, conf_param.sign_cache_dir);
 	hdl->t_pending = conf_param.t_pending;
 	memcpy (hdl->publisher_id, conf_param.publisher_id, SHA512_DIGEST_LENGTH);
 
@@ -952,6 +1313,7 @@ conpubd_event_dispatch (
 					}
 					else {
 						struct cef_app_request app_request;
+						CefT_Cpubcnt_Hdl* exist;
 						do {
 							len = cef_client_request_get_with_info (hdl->tcp_buff[fds_index[i]], len, &app_request);
 							if (app_request.version == CefC_App_Version) {
@@ -972,7 +1334,6 @@ conpubd_event_dispatch (
 								}
 
 								{
-									CefT_Cpubcnt_Hdl* exist;
 									if ((exist=conpubd_content_reg_check (hdl, app_request.name, app_request.total_segs_len)) != NULL) {
 										if (app_request.version_f == 0 ||
 											(app_request.ver_len == exist->version_len &&
@@ -988,8 +1349,12 @@ conpubd_event_dispatch (
 								}
 
 								/* Searches and sends a Cob */
-								hdl->cs_mod_int->cache_item_get
+								if (exist->lazy) {
+									conpubd_lazy_cob_send (hdl, exist, app_request.chunk_num, fds[i].fd);
+								} else {
+									hdl->cs_mod_int->cache_item_get
 													(app_request.name, app_request.total_segs_len, app_request.chunk_num, fds[i].fd, app_request.ver_value, app_request.ver_len);
+								}
 							}
 							else {
 								break;
@@ -1107,6 +1472,7 @@ conpubd_expire_check_thread (
 						if (conpubd_publish_content_delete (hdl, wk) != 0) {
 							;
 						}
+						conpubd_sign_remove (hdl, wk);
 						bwk->next = wk->next;
 						free (wk);
 						wk = bwk;
@@ -1409,6 +1775,7 @@ conpubd_handle_destroy (
 	if (Stat_p != NULL) {
 		free (Stat_p);
 	}
+	conpubd_lazy_lru_destroy ();
 	/* Unlink local sock */
 	if (duplicate_flag == 0) {
 		if (strlen (conpub_local_sock_name) != 0) {
@@ -1470,6 +1837,10 @@ conpubd_config_read (
 	conf_param->contents_num			= CefC_CnpbDefault_Contents_num;
 	conf_param->contents_capacity	= CefC_CnpbDefault_Contents_Capacity;
 	conf_param->block_size			= CefC_CnpbDefault_Block_Size;
+	conf_param->publish_workers		= CefC_CnpbDefault_Publish_Workers;
+	conf_param->lazy_publish		= 0;
+	conf_param->lazy_cache_cobs		= CefC_CnpbDefault_Lazy_Cache_Cobs;
+	conf_param->sign_cache_dir[0]	= 0x00;
 	strcpy(conf_param->cefnetd_node,  CefC_CnpbDefault_Node_Path);
 	conf_param->cefnetd_port		= CefC_CnpbDefault_Cefnetd_Port;
 	conf_param->t_pending			= CefC_CnpbDefault_Pending_Timer;
@@ -1619,6 +1990,48 @@ conpubd_config_read (
 			}
 			conf_param->block_size = res;
 		} else
+		if (strcmp (option, "PUBLISH_WORKERS") == 0) {
+			res = conpubd_config_value_get (option, value);
+			if ((res < 1) || (res > CefC_CnpbMax_Publish_Workers)) {
+				cef_log_write (CefC_Log_Error,
+					"PUBLISH_WORKERS must be higher than 0 and lower than %d.\n",
+					CefC_CnpbMax_Publish_Workers + 1);
+				fclose (fp);
+				return (-1);
+			}
+			conf_param->publish_workers = res;
+		} else
+		if (strcmp (option, "PUBLISH_MODE") == 0) {
+			if (strcmp (value, CefC_Cnpb_Lazy_Publish_Mode) == 0) {
+				conf_param->lazy_publish = 1;
+			} else if (strcmp (value, CefC_Cnpb_Eager_Publish_Mode) == 0) {
+				conf_param->lazy_publish = 0;
+			} else {
+				cef_log_write (CefC_Log_Error,
+					"PUBLISH_MODE is invalid. (Invalid value %s=%s)\n", option, value);
+				fclose (fp);
+				return (-1);
+			}
+		} else
+		if (strcmp (option, "LAZY_CACHE_COBS") == 0) {
+			res = conpubd_config_value_get (option, value);
+			if ((res < 1) || (res > CefC_CnpbMax_Lazy_Cache_Cobs)) {
+				cef_log_write (CefC_Log_Error,
+					"LAZY_CACHE_COBS must be higher than 0 and lower than %d.\n",
+					CefC_CnpbMax_Lazy_Cache_Cobs + 1);
+				fclose (fp);
+				return (-1);
+			}
+			conf_param->lazy_cache_cobs = (uint32_t) res;
+		} else
+		if (strcmp (option, "SIGN_CACHE_DIR") == 0) {
+			if (strlen (value) > sizeof (conf_param->sign_cache_dir) - 80) {
+				cef_log_write (CefC_Log_Error, "SIGN_CACHE_DIR is too long.\n");
+				fclose (fp);
+				return (-1);
+			}
+			strcpy (conf_param->sign_cache_dir, value);
+		} else
 		if (strcmp (option, "CEFNETD_NODE") == 0) {
 			if (strlen (value) > sizeof (conf_param->cefnetd_node)-1) {
 				cef_log_write (CefC_Log_Error,
@@ -1669,6 +2082,15 @@ conpubd_config_read (
 			return (-1);
 	    }
 	}
+	if (conf_param->sign_cache_dir[0] != 0x00) {
+		if (!(    access (conf_param->sign_cache_dir, R_OK) == 0
+		   && access (conf_param->sign_cache_dir, W_OK) == 0
+		   && access (conf_param->sign_cache_dir, X_OK) == 0)) {
+			cef_log_write (CefC_Log_Error,
+				"Invalid value SIGN_CACHE_DIR=%s - %s\n", conf_param->sign_cache_dir, strerror (errno));
+			return (-1);
+		}
+	}
 
 #ifdef CefC_Debug
 	cef_dbg_write (CefC_Dbg_Fine, "conf_param->port_num=%d\n", conf_param->port_num);
@@ -1681,6 +2103,10 @@ conpubd_config_read (
 	cef_dbg_write (CefC_Dbg_Fine, "conf_param->contents_num=%d\n", conf_param->contents_num);
 	cef_dbg_write (CefC_Dbg_Fine, "conf_param->contents_capacity="FMTU64"\n", conf_param->contents_capacity);
 	cef_dbg_write (CefC_Dbg_Fine, "conf_param->block_size=%d\n", conf_param->block_size);
+	cef_dbg_write (CefC_Dbg_Fine, "conf_param->publish_workers=%d\n", conf_param->publish_workers);
+	cef_dbg_write (CefC_Dbg_Fine, "conf_param->lazy_publish=%d\n", conf_param->lazy_publish);
+	cef_dbg_write (CefC_Dbg_Fine, "conf_param->lazy_cache_cobs=%u\n", conf_param->lazy_cache_cobs);
+	cef_dbg_write (CefC_Dbg_Fine, "conf_param->sign_cache_dir=%s\n", conf_param->sign_cache_dir);
 	cef_dbg_write (CefC_Dbg_Fine, "conf_param->cefnetd_node=%s\n", conf_param->cefnetd_node);
 	cef_dbg_write (CefC_Dbg_Fine, "conf_param->cefnetd_port=%d\n", conf_param->cefnetd_port);
 	cef_dbg_write (CefC_Dbg_Fine, "conf_param->t_pending=%d\n", conf_param->t_pending);
@@ -2861,88 +3287,93 @@ conpubd_content_load_thread (
 	{
 		CefT_Cpubcnt_Hdl* cnt_bp;
 		CefT_Cpubcnt_Hdl* cnt_wk;
-		CefT_Cpubcnt_Hdl* rld_bp;
 		CefT_Cpubcnt_Hdl* rld_wk;
+		CefT_Cpubcnt_Ref* rld_refs;
+		CefT_Cpubcnt_Ref* rld_ref;
+		CefT_Cpubcnt_Ref key;
+		uint32_t rld_num;
+		unsigned char* rld_drop = NULL;
 		int	foundf;
 		CefT_Cpubcnt_Hdl* del_wk;
 
 		memset (&Cpubreloadhdl, 0, sizeof (CefT_Cpubcnt_Hdl));
 		conpub_contdef_read (hdl, &Cpubreloadhdl);
 
+		/* The definitions are looked up by name, so that only the changed ones	*/
+		/* are deleted and published											*/
+		rld_refs = conpubd_cnt_refs_create (&Cpubreloadhdl, &rld_num);
+		if ((rld_num > 0) &&
+			((rld_refs == NULL) || ((rld_drop = calloc (rld_num, 1)) == NULL))) {
+			cef_log_write (CefC_Log_Error, "malloc error(Cpubcnt)\n");
+			free (rld_refs);
+			rld_refs = NULL;
+			rld_num = 0;
+		}
+
 		del_wk = &delcnthdl;
 		cnt_bp = &Cpubcnthdl;
 		cnt_wk = Cpubcnthdl.next;
 
 		while (cnt_wk) {
 			foundf = 0;
-			rld_bp = &Cpubreloadhdl;
-			rld_wk = Cpubreloadhdl.next;
-			while (rld_wk) {
-				if ((cnt_wk->name_len == rld_wk->name_len)
-					&& (memcmp (cnt_wk->name, rld_wk->name, rld_wk->name_len) == 0)) {
-					/* Same name */
-					int cmpver;
-					cmpver = conpubd_version_compare (
-								cnt_wk->version, cnt_wk->version_len,
-								rld_wk->version, rld_wk->version_len);
-					if (cmpver == 0) {
-						if (cnt_wk->expiry == rld_wk->expiry) {
-							/* Same date */
-							foundf = 1; /* Don't re-create Cob */
-							/* Delete from content reload list */
-							rld_bp->next = rld_wk->next;
-							free (rld_wk);
-							break;
-						} else {
-							break; /* re-create Cob */
-						}
+			key.cnt = cnt_wk;
+			rld_ref = (rld_num > 0) ?
+				bsearch (&key, rld_refs, rld_num, sizeof (CefT_Cpubcnt_Ref), conpubd_cnt_name_compare) : NULL;
+			if (rld_ref) {
+				/* Same name */
+				int cmpver;
+				rld_wk = rld_ref->cnt;
+				cmpver = conpubd_version_compare (
+							cnt_wk->version, cnt_wk->version_len,
+							rld_wk->version, rld_wk->version_len);
+				if (cmpver == 0) {
+					if (cnt_wk->fingerprint == rld_wk->fingerprint) {
+						/* Same definition and same file */
+						foundf = 1; /* Don't re-create Cob */
+						/* Delete from content reload list */
+						rld_drop[rld_ref->pos] = 1;
 					} else {
-						if (cmpver == CefC_Cpub_InconsistentVersion) {
-							char 	uri[CefC_Name_Max_Length];
-							cef_frame_conversion_name_to_string (cnt_wk->name, cnt_wk->name_len, uri, "ccn");
-							cef_log_write (CefC_Log_Warn
-								, "<%d> Inconsistent version number used for URI (%s).\n"
-								, rld_wk->line_no
-								, uri);
-							if (cnt_wk->version_len) {
-								cef_log_write (CefC_Log_Warn, "        uploaded      : %s\n", cnt_wk->version);
-							} else {
-								cef_log_write (CefC_Log_Warn, "        uploaded      : None\n");
-							}
-							if (rld_wk->version_len) {
-								cef_log_write (CefC_Log_Warn, "        conpubcont.def: %s\n", rld_wk->version);
-							} else {
-								cef_log_write (CefC_Log_Warn, "        conpubcont.def: None\n");
-							}
-							foundf = 1;
-							/* Delete from content reload list */
-							rld_bp->next = rld_wk->next;
-							free (rld_wk);
-							break;
+						; /* re-create Cob */
+					}
+				} else {
+					if (cmpver == CefC_Cpub_InconsistentVersion) {
+						char 	uri[CefC_Name_Max_Length];
+						cef_frame_conversion_name_to_string (cnt_wk->name, cnt_wk->name_len, uri, "ccn");
+						cef_log_write (CefC_Log_Warn
+							, "<%d> Inconsistent version number used for URI (%s).\n"
+							, rld_wk->line_no
+							, uri);
+						if (cnt_wk->version_len) {
+							cef_log_write (CefC_Log_Warn, "        uploaded      : %s\n", cnt_wk->version);
+						} else {
+							cef_log_write (CefC_Log_Warn, "        uploaded      : None\n");
 						}
-						if (cmpver > 0) {
-							char 	uri[CefC_Name_Max_Length];
-							cef_frame_conversion_name_to_string (cnt_wk->name, cnt_wk->name_len, uri, "ccn");
-							cef_log_write (CefC_Log_Warn
-								, "<%d> Old version number used for URI (%s).\n"
-								, rld_wk->line_no
-								, uri);
-							cef_log_write (CefC_Log_Warn
-								, "        uploaded: %s, conpubcont.def: %s\n"
-								, cnt_wk->version
-								, rld_wk->version);
-							foundf = 1;
-							/* Delete from content reload list */
-							rld_bp->next = rld_wk->next;
-							free (rld_wk);
-							break;
+						if (rld_wk->version_len) {
+							cef_log_write (CefC_Log_Warn, "        conpubcont.def: %s\n", rld_wk->version);
 						} else {
-							break; /* re-create Co */
+							cef_log_write (CefC_Log_Warn, "        conpubcont.def: None\n");
 						}
+						foundf = 1;
+						/* Delete from content reload list */
+						rld_drop[rld_ref->pos] = 1;
+					} else if (cmpver > 0) {
+						char 	uri[CefC_Name_Max_Length];
+						cef_frame_conversion_name_to_string (cnt_wk->name, cnt_wk->name_len, uri, "ccn");
+						cef_log_write (CefC_Log_Warn
+							, "<%d> Old version number used for URI (%s).\n"
+							, rld_wk->line_no
+							, uri);
+						cef_log_write (CefC_Log_Warn
+							, "        uploaded: %s, conpubcont.def: %s\n"
+							, cnt_wk->version
+							, rld_wk->version);
+						foundf = 1;
+						/* Delete from content reload list */
+						rld_drop[rld_ref->pos] = 1;
+					} else {
+						; /* re-create Co */
 					}
 				}
-				rld_bp = rld_wk;
-				rld_wk = rld_wk->next;
 			}
 			if (foundf == 0) {
 				/* Move from content list to delete list */
@@ -2955,6 +3386,12 @@ conpubd_content_load_thread (
 			cnt_bp = cnt_wk;
 			cnt_wk = cnt_wk->next;
 		}
+
+		if (rld_num > 0) {
+			conpubd_cnt_list_drop (&Cpubreloadhdl, rld_drop);
+		}
+		free (rld_drop);
+		free (rld_refs);
 	}
 
 	/* Delete contnts from delete list */
@@ -2973,6 +3410,20 @@ conpubd_content_load_thread (
 			if (conpubd_publish_content_delete (hdl, wk) != 0) {
 				;
 			}
+			/* The signatures are kept for the content which is published again, 	*/
+			/* they are reused if the file is not changed 							*/
+			{
+				CefT_Cpubcnt_Hdl* rwk;
+				for (rwk = Cpubreloadhdl.next ; rwk ; rwk = rwk->next) {
+					if ((rwk->name_len == wk->name_len) &&
+						(memcmp (rwk->name, wk->name, wk->name_len) == 0)) {
+						break;
+					}
+				}
+				if (rwk == NULL) {
+					conpubd_sign_remove (hdl, wk);
+				}
+			}
 			bwk->next = wk->next;
 			free (wk);
 			wk = bwk;
@@ -2997,7 +3448,11 @@ conpubd_content_load_thread (
 		while (wk) {
 			Cpubreloadhdl.next = wk->next;
 			if (conpubd_running_f != 0) {
-				rtc = conpubd_publish_content_create (hdl, wk, now_time);
+				if (hdl->lazy_publish) {
+					rtc = conpubd_publish_lazy_content_create (hdl, wk);
+				} else {
+					rtc = conpubd_publish_content_create (hdl, wk, now_time);
+				}
 			} else {
 				rtc = 0;
 			}
@@ -3112,6 +3567,9 @@ conpub_contdef_read (
 	char 	path[PATH_MAX];
 	char 	date_str[1024];
 	char 	time_str[1024];
+	char 	last_date_str[1024];
+	char 	last_time_str[1024];
+	time_t 	last_expiry = -1;
 	char	t_pending_str[1024];
 	uint16_t t_pending;
 	int 	res;
@@ -3119,6 +3577,7 @@ conpub_contdef_read (
 	int 				name_len;
 	time_t 				expiry;
 	uint64_t			cob_num;
+	struct stat			statBuf;
 	struct tm t;
 	time_t now;
 	time_t timer;
@@ -3155,6 +3614,9 @@ conpub_contdef_read (
 	/*--------------------------------------------------------
 		Read content definitionfile
 	----------------------------------------------------------*/
+	timer = time (NULL);
+	local = localtime (&timer);
+	now = mktime (local);
 	buff_len = sizeof (buff) - 1;
 	while (fgets (buff, buff_len, fp) != NULL) {
 
@@ -3187,17 +3649,25 @@ conpub_contdef_read (
 			continue;
 		}
 
-		/* Get the expiry 			*/
-		memset (&t, 0, sizeof (struct tm));
-		res = conpub_parse_date (date_str, time_str, &t);
-		if (res < 0) {
-			cef_log_write (CefC_Log_Warn, "<%d> Invalid Date/Time (%s %s)\n", line_no, date_str, time_str);
-			continue;
-		}
-		expiry = mktime (&t);
-		if (expiry == -1) {
-			cef_log_write (CefC_Log_Warn, "<%d> Invalid Expiry (%s %s)\n", line_no, date_str, time_str);
-			continue;
+		/* Get the expiry (the lines usually share the same date and time) 	*/
+		if ((last_expiry == -1) ||
+			(strcmp (date_str, last_date_str) != 0) || (strcmp (time_str, last_time_str) != 0)) {
+			memset (&t, 0, sizeof (struct tm));
+			res = conpub_parse_date (date_str, time_str, &t);
+			if (res < 0) {
+				cef_log_write (CefC_Log_Warn, "<%d> Invalid Date/Time (%s %s)\n", line_no, date_str, time_str);
+				continue;
+			}
+			expiry = mktime (&t);
+			if (expiry == -1) {
+				cef_log_write (CefC_Log_Warn, "<%d> Invalid Expiry (%s %s)\n", line_no, date_str, time_str);
+				continue;
+			}
+			strcpy (last_date_str, date_str);
+			strcpy (last_time_str, time_str);
+			last_expiry = expiry;
+		} else {
+			expiry = last_expiry;
 		}
 
 		name_len = cef_frame_conversion_uri_to_name (uri, name);
@@ -3222,64 +3692,27 @@ conpub_contdef_read (
 			continue;
 		}
 
-		timer = time (NULL);
-		local = localtime (&timer);
-		now = mktime (local);
-
 		if (expiry < now) {
 			cef_log_write (CefC_Log_Warn, "<%d> Invalid Expiry (%s: %s %s) specified.\n", line_no, uri, date_str, time_str);
 			continue;
 		}
 
 		/* Calculates number of cobs */
-		{
-		    struct stat statBuf;
-			if (stat (path, &statBuf) == 0) {
-				cob_num = statBuf.st_size / hdl->block_size;
-				if (statBuf.st_size % hdl->block_size != 0) {
-					cob_num++;
-				}
-			} else {
-				cef_log_write (CefC_Log_Error, "<%d> Error in accessing content file. (%s)\n"
-								, line_no , path);
-				continue;
+		if (stat (path, &statBuf) == 0) {
+			cob_num = statBuf.st_size / hdl->block_size;
+			if (statBuf.st_size % hdl->block_size != 0) {
+				cob_num++;
 			}
+		} else {
+			cef_log_write (CefC_Log_Error, "<%d> Error in accessing content file. (%s)\n"
+							, line_no , path);
+			continue;
 		}
 		if (cob_num > (uint64_t)UINT32_MAX + 1) {
 			cef_log_write (CefC_Log_Error, "<%d> Error in accessing content file. (%s) - chunk_num over\n"
 								, line_no, path);
 			continue;
 		}
-		/* Check URI duplicate definition */
-		{
-			CefT_Cpubcnt_Hdl* dwk;
-			dwk = cnthdl->next;
-			while (dwk) {
-				if ( (dwk->name_len == name_len)
-					&& memcmp (dwk->name, name, name_len) == 0) {
-					char uri[CefC_Name_Max_Length];
-					cef_frame_conversion_name_to_string (name, name_len, uri, "ccn");
-					cef_log_write (CefC_Log_Warn, "<%d> Duplicate URI (%s, %s) specified.\n", line_no, uri, ver);
-					if (ver_len == 4 && strcasecmp (ver, "None") == 0) {
-						if (dwk->version_len > 0) {
-							cef_log_write (CefC_Log_Warn, "<%d> Inconsistent version number specified for URI.\n", line_no);
-						}
-					} else {
-						if (dwk->version_len == 0) {
-							cef_log_write (CefC_Log_Warn, "<%d> Inconsistent version number specified for URI.\n", line_no);
-						} else if (memcmp (dwk->version, ver, ver_len) != 0) {
-							cef_log_write (CefC_Log_Warn, "<%d> Different version number specified for URI.\n", line_no);
-						}
-					}
-					break;
-				}
-				dwk = dwk->next;
-			}
-			if (dwk != NULL) {
-				continue;
-			}
-		}
-
 		work->next = (CefT_Cpubcnt_Hdl*) malloc (sizeof (CefT_Cpubcnt_Hdl));
 		if (work->next == NULL) {
 			cef_log_write (CefC_Log_Error, "malloc error(Cpubcnt)\n", ws);
@@ -3302,6 +3735,7 @@ conpub_contdef_read (
 			work->version_len = ver_len;
 		}
 		work->line_no = line_no;
+		work->fingerprint = conpubd_cnt_fingerprint_calc (work, &statBuf);
 		t_pending = atoi(t_pending_str);
 		if (t_pending) {
 			work->t_pending = t_pending;
@@ -3311,69 +3745,249 @@ conpub_contdef_read (
 	}
 
 	fclose (fp);
+
+	/* Check URI duplicate definition */
+	if (conpub_contdef_dup_remove (cnthdl) < 0) {
+		cef_log_write (CefC_Log_Error, "malloc error(Cpubcnt)\n");
+		return (-1);
+	}
 	cef_log_write (CefC_Log_Info, "Finished reading conpubcont.def. \n");
 	return (0);
 }
 /*--------------------------------------------------------------------------------------
-	Triming a line read from a file
+	Removes the duplicate definitions of the same URI
 ----------------------------------------------------------------------------------------*/
-static int
-conpub_trim_line_string (
-	const char* p, 								/* target string for trimming 			*/
-	char* uri, 									/* URI string after trimming			*/
-	char* ver,									/* Version string after trimming		*/
-	char* path,									/* Path string after trimming			*/
-	char* date,									/* Date string after trimming			*/
-	char* time,
-	char* t_pending								/* pending_timer string after trimming	*/
+static int									/* Returns a negative value if it fails 	*/
+conpub_contdef_dup_remove (
+	CefT_Cpubcnt_Hdl* cnthdl
 ) {
-	int num;
-	int yy, mm, dd;
-	int h, m;
-	int YY, MM, DD;
-	int H, M;
-	int datef = 0;
-	int timef = 0;
-	int i;
-	uint16_t t_pending_uint = 0;
-	int t_pendingf = 0;
-	char option_str[3][100] = {0};
-	strcpy (uri, "");
-	strcpy (path, "");
-	strcpy (date, "");
-	strcpy (time, "");
-    strcpy (t_pending, "");
-	yy = mm = dd = 0;
-	h = m = 0;
-	while (*p) {
-		if ((*p == 0x0D) || (*p == 0x0A)) {
-			return (-1);
-		}
-		if ((*p == 0x20) || (*p == 0x09)) {
-			p++;
-			continue;
-		}
-		break;
+	CefT_Cpubcnt_Ref* refs;
+	uint32_t ref_num;
+	unsigned char* drop;
+	CefT_Cpubcnt_Hdl* first;
+	CefT_Cpubcnt_Hdl* dup;
+	char uri[CefC_Name_Max_Length];
+	uint32_t i, n;
+
+	refs = conpubd_cnt_refs_create (cnthdl, &ref_num);
+	if (ref_num < 2) {
+		free (refs);
+		return (0);
 	}
-	num = sscanf (p, "%s %s %s %s %s %s", uri, ver, path, option_str[0], option_str[1], option_str[2]);
-	if (num < 3) {
+	if ((refs == NULL) || ((drop = calloc (ref_num, 1)) == NULL)) {
+		free (refs);
 		return (-1);
-	} else if(num > 3) {
-		for (i=3; i<num; i++) {
-			if (sscanf (option_str[i-3], "%d-%d-%d", &YY, &MM, &DD) == 3) {
-				yy = YY;
-				mm = MM;
-				dd = DD;
-				strcpy (date, option_str[i-3]);
-				datef = 1;
-			} else if (sscanf (option_str[i-3], "%d:%d", &H, &M) == 2) {
-				h = H;
-				m = M;
-				strcpy (time, option_str[i-3]);
-				timef = 1;
-			} else if(!t_pendingf) {
-				if (strtoul (option_str[i-3], NULL, 10) <= UINT16_MAX) {
-		 			sscanf (option_str[i-3], "%hd", &t_pending_uint);
+	}
+
+	/* The first definition in the file is used 	*/
+	for (i = 0 ; i < ref_num ; i = n) {
+		first = refs[i].cnt;
+		for (n = i + 1 ; n < ref_num ; n++) {
+			if (conpubd_cnt_name_compare (&refs[i], &refs[n]) != 0) {
+				break;
+			}
+			dup = refs[n].cnt;
+			drop[refs[n].pos] = 1;
+			cef_frame_conversion_name_to_string (dup->name, dup->name_len, uri, "ccn");
+			cef_log_write (CefC_Log_Warn, "<%d> Duplicate URI (%s, %s) specified.\n"
+				, dup->line_no, uri, (dup->version_len) ? (char*) dup->version : "None");
+			if ((dup->version_len == 0) != (first->version_len == 0)) {
+				cef_log_write (CefC_Log_Warn, "<%d> Inconsistent version number specified for URI.\n", dup->line_no);
+			} else if ((dup->version_len != first->version_len) ||
+				(memcmp (dup->version, first->version, dup->version_len) != 0)) {
+				cef_log_write (CefC_Log_Warn, "<%d> Different version number specified for URI.\n", dup->line_no);
+			}
+		}
+	}
+	conpubd_cnt_list_drop (cnthdl, drop);
+
+	free (drop);
+	free (refs);
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Calculates the fingerprint of the content definition
+----------------------------------------------------------------------------------------*/
+static uint64_t
+conpubd_cnt_fingerprint_calc (
+	CefT_Cpubcnt_Hdl* entry,
+	struct stat* st								/* status of the content file			*/
+) {
+	uint64_t fields[4];
+	const unsigned char* bp;
+	uint64_t hash = 0xcbf29ce484222325llu;		/* FNV-1a 								*/
+	size_t i;
+
+	for (bp = (const unsigned char*) entry->file_path ; *bp ; bp++) {
+		hash = (hash ^ *bp) * 0x100000001b3llu;
+	}
+	hash = (hash ^ 0xff) * 0x100000001b3llu;
+	for (i = 0 ; i < (size_t) entry->version_len ; i++) {
+		hash = (hash ^ entry->version[i]) * 0x100000001b3llu;
+	}
+
+	fields[0] = (uint64_t) st->st_size;
+	fields[1] = (uint64_t) st->st_mtim.tv_sec;
+	fields[2] = (uint64_t) st->st_mtim.tv_nsec;
+	fields[3] = (uint64_t) entry->expiry;
+	bp = (const unsigned char*) fields;
+	for (i = 0 ; i < sizeof (fields) ; i++) {
+		hash = (hash ^ bp[i]) * 0x100000001b3llu;
+	}
+
+	return (hash);
+}
+/*--------------------------------------------------------------------------------------
+	Creates the references to the content definitions sorted by name
+----------------------------------------------------------------------------------------*/
+static CefT_Cpubcnt_Ref*					/* The return value is null if an error occurs	*/
+conpubd_cnt_refs_create (
+	CefT_Cpubcnt_Hdl* cnthdl,
+	uint32_t* ref_num
+) {
+	CefT_Cpubcnt_Ref* refs;
+	CefT_Cpubcnt_Hdl* wk;
+	uint32_t num = 0;
+
+	for (wk = cnthdl->next ; wk ; wk = wk->next) {
+		num++;
+	}
+	*ref_num = num;
+	if (num == 0) {
+		return (NULL);
+	}
+	refs = (CefT_Cpubcnt_Ref*) malloc (sizeof (CefT_Cpubcnt_Ref) * num);
+	if (refs == NULL) {
+		return (NULL);
+	}
+	num = 0;
+	for (wk = cnthdl->next ; wk ; wk = wk->next) {
+		refs[num].cnt = wk;
+		refs[num].pos = num;
+		num++;
+	}
+	qsort (refs, num, sizeof (CefT_Cpubcnt_Ref), conpubd_cnt_ref_compare);
+
+	return (refs);
+}
+/*--------------------------------------------------------------------------------------
+	Compares the names of the content definitions
+----------------------------------------------------------------------------------------*/
+static int
+conpubd_cnt_name_compare (
+	const void* a,
+	const void* b
+) {
+	const CefT_Cpubcnt_Hdl* ca = ((const CefT_Cpubcnt_Ref*) a)->cnt;
+	const CefT_Cpubcnt_Hdl* cb = ((const CefT_Cpubcnt_Ref*) b)->cnt;
+
+	if (ca->name_len != cb->name_len) {
+		return ((ca->name_len < cb->name_len) ? -1 : 1);
+	}
+	return (memcmp (ca->name, cb->name, ca->name_len));
+}
+/*--------------------------------------------------------------------------------------
+	Compares the content definitions by name and the position in the file
+----------------------------------------------------------------------------------------*/
+static int
+conpubd_cnt_ref_compare (
+	const void* a,
+	const void* b
+) {
+	int res;
+
+	res = conpubd_cnt_name_compare (a, b);
+	if (res == 0) {
+		res = (((const CefT_Cpubcnt_Ref*) a)->pos < ((const CefT_Cpubcnt_Ref*) b)->pos) ? -1 : 1;
+	}
+	return (res);
+}
+/*--------------------------------------------------------------------------------------
+	Unlinks and frees the dropped content definitions
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_cnt_list_drop (
+	CefT_Cpubcnt_Hdl* cnthdl,
+	const unsigned char* drop					/* drop flag of each position			*/
+) {
+	CefT_Cpubcnt_Hdl* bwk = cnthdl;
+	CefT_Cpubcnt_Hdl* wk = cnthdl->next;
+	uint32_t pos = 0;
+
+	while (wk) {
+		if (drop[pos]) {
+			bwk->next = wk->next;
+			free (wk);
+		} else {
+			bwk = wk;
+		}
+		wk = bwk->next;
+		pos++;
+	}
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Triming a line read from a file
+----------------------------------------------------------------------------------------*/
+static int
+conpub_trim_line_string (
+	const char* p, 								/* target string for trimming 			*/
+	char* uri, 									/* URI string after trimming			*/
+	char* ver,									/* Version string after trimming		*/
+	char* path,									/* Path string after trimming			*/
+	char* date,									/* Date string after trimming			*/
+	char* time,
+	char* t_pending								/* pending_timer string after trimming	*/
+) {
+	int num;
+	int yy, mm, dd;
+	int h, m;
+	int YY, MM, DD;
+	int H, M;
+	int datef = 0;
+	int timef = 0;
+	int i;
+	uint16_t t_pending_uint = 0;
+	int t_pendingf = 0;
+	char option_str[3][100] = {0};
+	strcpy (uri, "");
+	strcpy (path, "");
+	strcpy (date, "");
+	strcpy (time, "");
+    strcpy (t_pending, "");
+	yy = mm = dd = 0;
+	h = m = 0;
+	while (*p) {
+		if ((*p == 0x0D) || (*p == 0x0A)) {
+			return (-1);
+		}
+		if ((*p == 0x20) || (*p == 0x09)) {
+			p++;
+			continue;
+		}
+		break;
+	}
+	num = sscanf (p, "%s %s %s %s %s %s", uri, ver, path, option_str[0], option_str[1], option_str[2]);
+	if (num < 3) {
+		return (-1);
+	} else if(num > 3) {
+		for (i=3; i<num; i++) {
+			if (sscanf (option_str[i-3], "%d-%d-%d", &YY, &MM, &DD) == 3) {
+				yy = YY;
+				mm = MM;
+				dd = DD;
+				strcpy (date, option_str[i-3]);
+				datef = 1;
+			} else if (sscanf (option_str[i-3], "%d:%d", &H, &M) == 2) {
+				h = H;
+				m = M;
+				strcpy (time, option_str[i-3]);
+				timef = 1;
+			} else if(!t_pendingf) {
+				if (strtoul (option_str[i-3], NULL, 10) <= UINT16_MAX) {
+		 			sscanf (option_str[i-3], "%hd", &t_pending_uint);
 	 				strcpy (t_pending, option_str[i-3]);
 			 		t_pendingf = 1;
 				} else {
@@ -3423,13 +4037,9 @@ int
 conpub_check_file_path (
 	const char* path 							/* file path 							*/
 ) {
-	FILE*	fp = NULL;
-
-	fp = fopen (path, "r");
-	if (fp == NULL) {
+	if (access (path, R_OK) != 0) {
 		return (-1);
 	}
-	fclose (fp);
 
 	return (1);
 }
@@ -3654,30 +4264,25 @@ conpubd_publish_content_create (
 	CefT_Cpubcnt_Hdl* entry,
 	time_t now_time
 ) {
-	FILE* fp;
-	FILE* key_fp;
-	char key_file_path[PATH_MAX+7];
-	int16_t key_len;
-	char padding_file_path[PATH_MAX+8];
-	FILE* padding_fp;
-	size_t padding_len;
-	int padding = 0;
-	char padding_str[32] = {0};
-	uint32_t seqnum = 0;
-	int res;
-	unsigned char buff[CefC_Max_Length];
-	unsigned char cobbuff[CefC_Max_Length];
+	int fd;
+	struct stat st;
+	uint32_t seqnum;
 
 	int len;
 	int rtc = 0;
 	ConpubdT_Content_Entry cont_entry;
 	time_t wtime_s = 0;
-	int first_cob_f = 0;
 	uint64_t free_mem_mega = 0;
 	uint64_t estimated_mem_mega = 0;
 	uint64_t free_file_mega = 0;
 	uint64_t estimated_file_mega = 0;
 	CefT_CcnMsg_OptHdr	opt;
+	CefT_CcnMsg_MsgBdy* last_prames = NULL;
+	CefT_Cpub_Pipeline pl;
+	CefT_Cpub_Built_Cob cob;
+	pthread_t workers[CefC_CnpbMax_Publish_Workers];
+	int worker_num = 0;
+	int i;
 
 	/* Check Content num  */
 	if (hdl->published_contents_num >= hdl->contents_num) {
@@ -3706,47 +4311,381 @@ conpubd_publish_content_create (
 	/* Creates and inputs the Cobs 	*/
 	wtime_s = time (NULL);
 
-	fp = fopen (entry->file_path, "rb");
-	if (fp == NULL) {
+	fd = open (entry->file_path, O_RDONLY);
+	if (fd < 0) {
+		return (-1);
+	}
+	if (fstat (fd, &st) < 0) {
+		close (fd);
 		return (-1);
 	}
+	/* Inits the parameters 		*/
+	memset (&opt, 0, sizeof (CefT_CcnMsg_OptHdr));
+	if (conpubd_publish_prames_set (hdl, entry, Cob_prames_p, &opt, &last_prames) < 0) {
+		cef_log_write (CefC_Log_Critical, "Failed to alloc memory\n");
+		conpubd_running_f = 0;
+		close (fd);
+		return (-1);
+	}
+	cef_frame_conversion_name_to_string (entry->name, entry->name_len, Uri_buff_p, "ccn");
+
+	/* Starts the workers which build and sign the Cobs 	*/
+	memset (&pl, 0, sizeof (CefT_Cpub_Pipeline));
+	pl.fd			= fd;
+	pl.file_size	= st.st_size;
+	pl.block_size	= hdl->block_size;
+	pl.cob_num		= (uint32_t)((st.st_size + hdl->block_size - 1) / hdl->block_size);
+	pl.opt			= &opt;
+	pl.prames		= Cob_prames_p;
+	pl.last_prames	= (last_prames) ? last_prames : Cob_prames_p;
+	pl.slot_num		= hdl->publish_workers * CefC_Cpub_Pipeline_Depth;
+	pl.slots = (CefT_Cpub_Built_Cob*) calloc (pl.slot_num, sizeof (CefT_Cpub_Built_Cob));
+	if (pl.slots == NULL) {
+		cef_log_write (CefC_Log_Critical, "Failed to alloc memory\n");
+		conpubd_running_f = 0;
+		close (fd);
+		free (last_prames);
+		return (-1);
+	}
+	pthread_mutex_init (&pl.mutex, NULL);
+	pthread_cond_init (&pl.built_cond, NULL);
+	pthread_cond_init (&pl.free_cond, NULL);
+	conpubd_sign_store_open (hdl, entry, fd, st.st_size);
+
+	for (i = 0 ; (i < hdl->publish_workers) && ((uint32_t) i < pl.cob_num) ; i++) {
+		if (cef_pthread_create (
+				&workers[worker_num], NULL, conpubd_publish_worker_thread, &pl) == -1) {
+			break;
+		}
+		worker_num++;
+	}
+	if ((worker_num == 0) && (pl.cob_num > 0)) {
+		cef_log_write (CefC_Log_Critical, "Failed to publish %s (pthread_create)\n", Uri_buff_p);
+		rtc = -1;
+		goto PUBLISH_END;
+	}
+
+	/* Commits the Cobs in the order of the chunk number 	*/
+	for (seqnum = 0 ; (seqnum < pl.cob_num) && (conpubd_running_f) ; seqnum++) {
+		if (conpubd_publish_cob_take (&pl, seqnum, &cob) < 0) {
+			cef_log_write (CefC_Log_Critical, "Failed to publish %s (Read Error)\n", Uri_buff_p);
+			conpubd_running_f = 0;
+			rtc = -1;
+			goto PUBLISH_END;
+		}
+		len = cob.msg_len;
+
+		if (seqnum == 0) {
+			if (strcmp(hdl->cache_type, CefC_Cnpb_memory_Cache_Type) == 0) {
+				/* Get free mem size */
+				conpubd_free_memsize_get (&free_mem_mega);
+				estimated_mem_mega = ( 64 /* size of ConpubdT_Content_Mem_Entry */
+										+ Cob_prames_p->name_len
+										+ (len+3/* for chunk# */)
+										+ (40/* size of CefT_Mem_Hash_Cell */
+										+ (Cob_prames_p->name_len+8/* for hush KEY */))
+									) * entry->cob_num / 1024 /1024;
+				estimated_mem_mega = estimated_mem_mega * CefC_Cpub_Memory_Usage_Correction_Factor;
+				if (estimated_mem_mega > free_mem_mega) {
+					cef_log_write (CefC_Log_Warn,
+						"Skipping content(%s) registration due to lack of memory.\n"
+						"	free memory="FMTU64"(MB), estimated memory usage="FMTU64"(MB)\n",
+						Uri_buff_p, free_mem_mega, estimated_mem_mega);
+					free (cob.msg);
+					rtc = -99;
+					goto PUBLISH_END;
+				} else {
+						cef_log_write (CefC_Log_Info,
+							"Publishing %s \n"
+							"	free memory="FMTU64"(MB), estimated memory usage="FMTU64"(MB)\n",
+						Uri_buff_p, free_mem_mega, estimated_mem_mega);
+				}
+			} else { //CefC_Cnpb_filesystem_Cache_Type
+				/* Get initial free fisk size */
+				get_filesystem_info (hdl->cache_path, &free_file_mega);
+				estimated_file_mega = (sizeof(uint16_t)+len+3)  * entry->cob_num / 1024 /1024;
+				if (estimated_file_mega > free_file_mega - CefC_Cpub_Reserved_Disk_Mega) {
+					cef_log_write (CefC_Log_Warn,
+						"Skipping content(%s) registration due to lack of disk.\n"
+						"	free disk="FMTU64"(MB), estimated disk usage="FMTU64"(MB)\n"
+						"	(Use %dMB as free reserve)\n",
+						Uri_buff_p, free_file_mega, estimated_file_mega,
+						CefC_Cpub_Reserved_Disk_Mega);
+					free (cob.msg);
+					rtc = -99;
+					goto PUBLISH_END;
+				} else {
+					cef_log_write (CefC_Log_Info, "Publishing %s \n"
+						"	free disk="FMTU64"(MB), estimated disk usage="FMTU64"(MB)\n"
+						"	(Use %dMB as free reserve)\n",
+						Uri_buff_p, free_file_mega, estimated_file_mega,
+						CefC_Cpub_Reserved_Disk_Mega);
+				}
+			}
+		}
+		if (len > 0) {
+			/*----------------------------------------------------------------------------------*/
+			/* [filesystem cache]                                                               */
+			/* "msg" and "name" are released after copying to the cache memory resource         */
+			/* in the cache program.                                                            */
+			/* [memory cache]                                                                   */
+			/* In the cache program, "msg" and "name" are reused even after being copied        */
+			/* to the memory resource of the cache, and are released when the cache is deleted. */
+			/*----------------------------------------------------------------------------------*/
+			cont_entry.msg = cob.msg;
+			cont_entry.msg_len = len;
+			if ((cont_entry.name = calloc (1, Cob_prames_p->name_len)) == NULL) {
+				cef_log_write (CefC_Log_Critical, "Failed to alloc memory\n");
+				conpubd_running_f = 0;
+				free (cob.msg);
+				rtc = -1;
+				goto PUBLISH_END;
+			}
+			memcpy (cont_entry.name, Cob_prames_p->name, Cob_prames_p->name_len);
+			cont_entry.name_len = Cob_prames_p->name_len;
+			cont_entry.pay_len = cob.pay_len;
+			cont_entry.chunk_num = seqnum;
+			cont_entry.expiry = Cob_prames_p->expiry * 1000;
+			cont_entry.rct = (uint64_t)hdl->cache_default_rct;
+			/* cont_entry.node does not care */
+			rtc = hdl->cs_mod_int->cache_item_puts (&cont_entry, sizeof (cont_entry), NULL);
+			if (rtc < 0) {
+				cef_log_write (CefC_Log_Critical, "Failed to publish %s (cache_item_puts)\n", Uri_buff_p);
+				conpubd_running_f = 0;
+				rtc = -1;
+				goto PUBLISH_END;
+			}
+		} else {
+			free (cob.msg);
+		}
+	}
+
+PUBLISH_END:;
+	/* Stops the workers and releases the Cobs which are not committed 	*/
+	pthread_mutex_lock (&pl.mutex);
+	pl.abort_f = 1;
+	pthread_cond_broadcast (&pl.free_cond);
+	pthread_mutex_unlock (&pl.mutex);
+	for (i = 0 ; i < worker_num ; i++) {
+		pthread_join (workers[i], NULL);
+	}
+	for (i = 0 ; (uint32_t) i < pl.slot_num ; i++) {
+		free (pl.slots[i].msg);
+	}
+	free (pl.slots);
+	pthread_cond_destroy (&pl.free_cond);
+	pthread_cond_destroy (&pl.built_cond);
+	pthread_mutex_destroy (&pl.mutex);
+	free (last_prames);
+	conpubd_sign_store_close ((rtc < 0) ? 0 : 1);
+
+	hdl->cs_mod_int->cache_item_puts (NULL, 0, NULL);
+	close (fd);
+	if (rtc < 0) {
+		return (rtc);
+	}
+	cef_log_write (CefC_Log_Info, "Published %s (time=%ld) \n", Uri_buff_p, time (NULL) - wtime_s);
+	/* CefC_T_OPT_APP_REG */
+	{
+		CefT_Connect connect;
+		connect.ai = 0;
+		connect.sock = hdl->cefnetd_sock;
+		CefT_Client_Handle fhdl;
+		fhdl = (CefT_Client_Handle) &connect;
+		if (connect.sock != -1) {
+			cef_client_prefix_reg (fhdl, CefC_T_OPT_APP_REG, entry->name, entry->name_len);
+		}
+	}
+
+	hdl->published_contents_num ++;
+
+   	return (rtc);
+}
+/*--------------------------------------------------------------------------------------
+	Builds the Cobs of the content in the publish pipeline
+----------------------------------------------------------------------------------------*/
+static void*
+conpubd_publish_worker_thread (
+	void* arg
+) {
+	CefT_Cpub_Pipeline* pl = (CefT_Cpub_Pipeline*) arg;
+	CefT_CcnMsg_MsgBdy* prames;
+	unsigned char* cobbuff;
+	CefT_Cpub_Built_Cob* slot;
+	uint32_t seq;
+	off_t offset;
+	ssize_t res;
+	int len;
+	unsigned char* msg;
+	int read_f;
+	int last_f = 0;
+
+	/* Each worker has its own copy of the parameters, since the Cob creation 	*/
+	/* caches the encoded Org TLVs in the parameters 							*/
+	prames  = (CefT_CcnMsg_MsgBdy*) malloc (sizeof (CefT_CcnMsg_MsgBdy));
+	cobbuff = (unsigned char*) malloc (CefC_Max_Length);
+	if ((prames == NULL) || (cobbuff == NULL)) {
+		cef_log_write (CefC_Log_Critical, "Failed to alloc memory\n");
+		free (prames);
+		free (cobbuff);
+		pthread_mutex_lock (&pl->mutex);
+		pl->abort_f = 1;
+		pthread_cond_broadcast (&pl->built_cond);
+		pthread_cond_broadcast (&pl->free_cond);
+		pthread_mutex_unlock (&pl->mutex);
+		return ((void*) NULL);
+	}
+	memcpy (prames, pl->prames, sizeof (CefT_CcnMsg_MsgBdy));
+
+	while (1) {
+		pthread_mutex_lock (&pl->mutex);
+		while ((pl->abort_f == 0) && (pl->next_seq < pl->cob_num) &&
+			(pl->next_seq - pl->commit_seq >= pl->slot_num)) {
+			pthread_cond_wait (&pl->free_cond, &pl->mutex);
+		}
+		if ((pl->abort_f) || (pl->next_seq >= pl->cob_num)) {
+			pthread_mutex_unlock (&pl->mutex);
+			break;
+		}
+		seq = pl->next_seq;
+		pl->next_seq++;
+		pthread_mutex_unlock (&pl->mutex);
+
+		if ((seq == pl->cob_num - 1) && (pl->last_prames != pl->prames)) {
+			memcpy (prames, pl->last_prames, sizeof (CefT_CcnMsg_MsgBdy));
+			last_f = 1;
+		}
+
+		/* Reads the block of the chunk 		*/
+		offset = (off_t) seq * pl->block_size;
+		len = (pl->file_size - offset < pl->block_size) ?
+				(int)(pl->file_size - offset) : pl->block_size;
+		res = pread (pl->fd, prames->payload, len, offset);
+		read_f = (res == len);
+
+		msg = NULL;
+		if (read_f) {
+			prames->payload_len = (uint16_t) len;
+			prames->chunk_num = seq;
+			len = cef_frame_object_create (cobbuff, pl->opt, prames);
+			if ((len > 0) && ((msg = (unsigned char*) malloc (len)) != NULL)) {
+				memcpy (msg, cobbuff, len);
+			}
+		}
+
+		pthread_mutex_lock (&pl->mutex);
+		slot = &pl->slots[seq % pl->slot_num];
+		slot->msg		= msg;
+		slot->msg_len	= len;
+		slot->pay_len	= prames->payload_len;
+		if ((!read_f) || ((len > 0) && (msg == NULL))) {
+			slot->state = CefC_Cpub_Cob_Failed;
+		} else {
+			slot->state = CefC_Cpub_Cob_Built;
+		}
+		pthread_cond_broadcast (&pl->built_cond);
+		pthread_mutex_unlock (&pl->mutex);
+
+		if (last_f) {
+			break;
+		}
+	}
+	free (prames);
+	free (cobbuff);
+
+	return ((void*) NULL);
+}
+/*--------------------------------------------------------------------------------------
+	Waits for the Cob of the specified chunk from the publish pipeline
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+conpubd_publish_cob_take (
+	CefT_Cpub_Pipeline* pl,
+	uint32_t seq,
+	CefT_Cpub_Built_Cob* cob
+) {
+	CefT_Cpub_Built_Cob* slot;
+	struct timespec ts;
+
+	pthread_mutex_lock (&pl->mutex);
+	slot = &pl->slots[seq % pl->slot_num];
+	while (slot->state == CefC_Cpub_Cob_Empty) {
+		/* Wakes up to check that conpubd is running 	*/
+		clock_gettime (CLOCK_REALTIME, &ts);
+		ts.tv_sec += 1;
+		pthread_cond_timedwait (&pl->built_cond, &pl->mutex, &ts);
+		if ((!conpubd_running_f) || (pl->abort_f)) {
+			pthread_mutex_unlock (&pl->mutex);
+			return (-1);
+		}
+	}
+	*cob = *slot;
+	slot->state 	= CefC_Cpub_Cob_Empty;
+	slot->msg 		= NULL;
+	pl->commit_seq 	= seq + 1;
+	pthread_cond_broadcast (&pl->free_cond);
+	pthread_mutex_unlock (&pl->mutex);
+
+	return ((cob->state == CefC_Cpub_Cob_Failed) ? -1 : 0);
+}
+/*--------------------------------------------------------------------------------------
+	Sets the parameters of the Cobs of the content
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+conpubd_publish_prames_set (
+	CefT_Conpubd_Handle* hdl,					/* conpub daemon handle					*/
+	CefT_Cpubcnt_Hdl* entry,
+	CefT_CcnMsg_MsgBdy* prames,					/* parameters of the Cobs				*/
+	CefT_CcnMsg_OptHdr* opt,
+	CefT_CcnMsg_MsgBdy** last_prames			/* parameters of the last Cob (NULL if	*/
+												/* it is same as prames)				*/
+) {
+	FILE* key_fp;
+	char key_file_path[PATH_MAX+7];
+	int16_t key_len;
+	char padding_file_path[PATH_MAX+8];
+	FILE* padding_fp;
+	size_t padding_len;
+	int padding = 0;
+	char padding_str[32] = {0};
+	CefT_CcnMsg_MsgBdy* lprames;
+
+	*last_prames = NULL;
 	strcpy (key_file_path, entry->file_path);
 	strcat (key_file_path, ".pubkey");
 	key_fp = fopen (key_file_path, "rb");
 
-	/* Inits the parameters 		*/
-	memset (&opt, 0, sizeof (CefT_CcnMsg_OptHdr));
-	memset (Cob_prames_p, 0, sizeof (CefT_CcnMsg_MsgBdy));
+	memset (prames, 0, sizeof (CefT_CcnMsg_MsgBdy));
 	/* Sets the name */
-	memcpy (Cob_prames_p->name, entry->name, entry->name_len);
-	Cob_prames_p->name_len = entry->name_len;
+	memcpy (prames->name, entry->name, entry->name_len);
+	prames->name_len = entry->name_len;
 	/* Sets Expiry TIme */
-	Cob_prames_p->expiry = entry->expiry * 1000;
+	prames->expiry = entry->expiry * 1000;
 	/* Sets Cache TIme */
-	opt.cachetime_f = 1;
-	opt.cachetime = Cob_prames_p->expiry;
+	opt->cachetime_f = 1;
+	opt->cachetime = prames->expiry;
 	/* Sets chunk flag */
-	Cob_prames_p->chunk_num_f = 1;
+	prames->chunk_num_f = 1;
 	/* Sets end chunk */
-	Cob_prames_p->end_chunk_num_f =1;
-	Cob_prames_p->end_chunk_num = entry->cob_num-1;
+	prames->end_chunk_num_f =1;
+	prames->end_chunk_num = entry->cob_num-1;
 	/* Sets validation info */
-	Cob_prames_p->alg.valid_type = hdl->valid_type;
+	prames->alg.valid_type = hdl->valid_type;
 
 	if(key_fp != NULL) {
-		Cob_prames_p->org.pending_val = entry->t_pending;
-		opt.cachetime_f = 0;
+		prames->org.pending_val = entry->t_pending;
+		opt->cachetime_f = 0;
 
 		strcpy (padding_file_path, entry->file_path);
 		strcat (padding_file_path, ".padding");
 		padding_fp = fopen (padding_file_path, "r");
 		if (NULL != padding_fp) {
 			fclose (padding_fp);
-			Cob_prames_p->org.encryptalg.encryptalg_f = 1;
-			Cob_prames_p->org.encryptalg.type = CefC_T_EA_CPABE;
-			Cob_prames_p->org.orgkeyid.hash_type = CefC_T_SHA_512;
-			memcpy (Cob_prames_p->org.orgkeyid.hash_val, hdl->publisher_id, SHA512_DIGEST_LENGTH);
-			Cob_prames_p->org.orgkeyid.hash_len = SHA512_DIGEST_LENGTH;
+			prames->org.encryptalg.encryptalg_f = 1;
+			prames->org.encryptalg.type = CefC_T_EA_CPABE;
+			prames->org.orgkeyid.hash_type = CefC_T_SHA_512;
+			memcpy (prames->org.orgkeyid.hash_val, hdl->publisher_id, SHA512_DIGEST_LENGTH);
+			prames->org.orgkeyid.hash_len = SHA512_DIGEST_LENGTH;
 		}
 	} else {
 		entry->t_pending = 0;
@@ -3754,169 +4693,448 @@ conpubd_publish_content_create (
 
 	/* Sets Version */
 	if (entry->version_len) {
-		Cob_prames_p->org.version_f = 1;
-		memcpy (Cob_prames_p->org.version_val, entry->version, entry->version_len);
+		prames->org.version_f = 1;
+		memcpy (prames->org.version_val, entry->version, entry->version_len);
 	}
-	Cob_prames_p->org.version_len = (uint16_t)entry->version_len;
+	prames->org.version_len = (uint16_t)entry->version_len;
 
-	cef_frame_conversion_name_to_string (entry->name, entry->name_len, Uri_buff_p, "ccn");
-	while (conpubd_running_f) {
-		res = fread (buff, sizeof (unsigned char), hdl->block_size, fp);
-		if (res > 0) {
-			if (key_fp != NULL) {
-				if (feof(fp) != 0) {
-					key_len = fread (Cob_prames_p->org.csact.publickey_val, sizeof (unsigned char), CefC_S_PUBLICKEY, key_fp);
-					if (key_len > 0) {
-						Cob_prames_p->org.csact.publickey_len = key_len;
-						Cob_prames_p->org.csact.csact_alg_f = 1;
-						Cob_prames_p->org.csact.csact_type = CefC_T_EC_SECP_384R1;
-						Cob_prames_p->org_len = 0;
-					} else {
-						cef_log_write (CefC_Log_Warn,"T_ECDSA_KEY length equals 0.\n");
-					}
+	if (key_fp == NULL) {
+		return (0);
+	}
+
+	/* The last Cob carries the public key and the padding 	*/
+	if ((lprames = malloc (sizeof (CefT_CcnMsg_MsgBdy))) == NULL) {
+		fclose (key_fp);
+		return (-1);
+	}
+	memcpy (lprames, prames, sizeof (CefT_CcnMsg_MsgBdy));
+	key_len = fread (lprames->org.csact.publickey_val, sizeof (unsigned char), CefC_S_PUBLICKEY, key_fp);
+	if (key_len > 0) {
+		lprames->org.csact.publickey_len = key_len;
+		lprames->org.csact.csact_alg_f = 1;
+		lprames->org.csact.csact_type = CefC_T_EC_SECP_384R1;
+		lprames->org_len = 0;
+	} else {
+		cef_log_write (CefC_Log_Warn,"T_ECDSA_KEY length equals 0.\n");
+	}
+	fclose (key_fp);
+
+	padding_fp = fopen (padding_file_path, "r");
+	if (NULL != padding_fp) {
+		padding_len = fread (padding_str, sizeof (unsigned char), sizeof (padding_str), padding_fp);
+		if (0 < padding_len) {
+			padding = atoi (padding_str);
+			lprames->org.encryptalg.encryptalg_f = 1;
+			lprames->org.encryptalg.type = CefC_T_EA_CPABE;
+			lprames->org.encryptalg.padding = padding;
+			lprames->org_len = 0;
+		}
+		fclose (padding_fp);
+	}
+	*last_prames = lprames;
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Opens the signature sidecar file of the content to publish
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_sign_store_open (
+	CefT_Conpubd_Handle* hdl,					/* conpub daemon handle					*/
+	CefT_Cpubcnt_Hdl* entry,
+	int fd,										/* content file							*/
+	off_t file_size
+) {
+	CefT_Cpub_Sign_Store* ss = &Sign_store;
+	unsigned char file_hash[SHA256_DIGEST_LENGTH];
+	unsigned char pubkey[CefC_PUBKEY_BUFSIZ];
+	unsigned char keyid[CefC_KeyId_SIZ];
+	unsigned char key_src[SHA256_DIGEST_LENGTH + sizeof (uint32_t) + CefC_Max_Length];
+	CefT_Cpub_Sign_Hdr* shdr;
+	CefT_Cpub_Sign_Rec* recs;
+	unsigned char* map;
+	struct stat st;
+	uint32_t block_size;
+	uint32_t n;
+	int sfd;
+	int index;
+
+	if ((hdl->sign_cache_dir[0] == 0x00) || (hdl->valid_type != CefC_T_RSA_SHA256)) {
+		return;
+	}
+	if (cef_valid_keyid_create (entry->name, entry->name_len, pubkey, keyid) == 0) {
+		return;
+	}
 
-					padding_fp = fopen (padding_file_path, "r");
-					if (NULL != padding_fp) {
-						padding_len = fread (padding_str, sizeof (unsigned char), sizeof (padding_str), padding_fp);
-						if (0 < padding_len) {
-							padding = atoi (padding_str);
-							Cob_prames_p->org.encryptalg.encryptalg_f = 1;
-							Cob_prames_p->org.encryptalg.type = CefC_T_EA_CPABE;
-							Cob_prames_p->org.encryptalg.padding = padding;
-							Cob_prames_p->org_len = 0;
+	/* The sidecar file is named by the hash of the name, and its key is the 	*/
+	/* hash of the file hash, block size and name. When the content is 		*/
+	/* replaced, the file of the old content is overwritten. 				*/
+	if (cef_valid_digest_fd (CefC_Valid_Digest_SHA256, fd, file_size, file_hash) < 0) {
+		cef_log_write (CefC_Log_Warn,
+			"Failed to read the content file to reuse the signatures\n");
+		return;
+	}
+	block_size = htonl ((uint32_t) hdl->block_size);
+	index = 0;
+	memcpy (&key_src[index], file_hash, SHA256_DIGEST_LENGTH);
+	index += SHA256_DIGEST_LENGTH;
+	memcpy (&key_src[index], &block_size, sizeof (uint32_t));
+	index += sizeof (uint32_t);
+	memcpy (&key_src[index], entry->name, entry->name_len);
+	index += entry->name_len;
+
+	pthread_mutex_lock (&conpub_sign_mutex);
+	memset (ss, 0, sizeof (CefT_Cpub_Sign_Store));
+	cef_valid_sha256 (key_src, (size_t) index, ss->key);
+	memcpy (ss->keyid, keyid, CefC_KeyId_SIZ);
+	conpubd_sign_path_create (hdl, entry->name, entry->name_len, ss->path);
+	memcpy (ss->name, entry->name, entry->name_len);
+	ss->name_len = entry->name_len;
+
+	/* Maps the sidecar file if it exists. The signatures are reused only if 	*/
+	/* the file is of the same content and key, and none of the records is 	*/
+	/* broken. 																	*/
+	sfd = open (ss->path, O_RDONLY);
+	if (sfd >= 0) {
+		if ((fstat (sfd, &st) == 0) && (st.st_size >= (off_t) sizeof (CefT_Cpub_Sign_Hdr))) {
+			map = mmap (NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, sfd, 0);
+			if (map != MAP_FAILED) {
+				shdr = (CefT_Cpub_Sign_Hdr*) map;
+				recs = (CefT_Cpub_Sign_Rec*) &map[sizeof (CefT_Cpub_Sign_Hdr)];
+				n = 0;
+				if ((memcmp (shdr->magic, CefC_Cpub_Sign_Magic, sizeof (shdr->magic)) == 0) &&
+					((size_t) st.st_size == sizeof (CefT_Cpub_Sign_Hdr)
+						+ (size_t) shdr->rec_num * sizeof (CefT_Cpub_Sign_Rec))) {
+					for (n = 0 ; n < shdr->rec_num ; n++) {
+						if ((recs[n].sign_len > CefC_Cpub_Sign_Max) ||
+							(recs[n].crc != cef_valid_crc32c_calc ((unsigned char*) &recs[n],
+												offsetof (CefT_Cpub_Sign_Rec, crc)))) {
+							break;
 						}
-						fclose (padding_fp);
 					}
 				}
-			}
-			memcpy (Cob_prames_p->payload, buff, res);
-			Cob_prames_p->payload_len = (uint16_t) res;
-			Cob_prames_p->chunk_num = seqnum;
-
-			len = cef_frame_object_create (cobbuff, &opt, Cob_prames_p);
-			if (first_cob_f == 0) {
-				if (strcmp(hdl->cache_type, CefC_Cnpb_memory_Cache_Type) == 0) {
-					/* Get free mem size */
-					conpubd_free_memsize_get (&free_mem_mega);
-					estimated_mem_mega = ( 64 /* size of ConpubdT_Content_Mem_Entry */
-											+ Cob_prames_p->name_len
-											+ (len+3/* for chunk# */)
-											+ (40/* size of CefT_Mem_Hash_Cell */
-											+ (Cob_prames_p->name_len+8/* for hush KEY */))
-										) * entry->cob_num / 1024 /1024;
-					estimated_mem_mega = estimated_mem_mega * CefC_Cpub_Memory_Usage_Correction_Factor;
-					if (estimated_mem_mega > free_mem_mega) {
-						cef_log_write (CefC_Log_Warn,
-							"Skipping content(%s) registration due to lack of memory.\n"
-							"	free memory="FMTU64"(MB), estimated memory usage="FMTU64"(MB)\n",
-							Uri_buff_p, free_mem_mega, estimated_mem_mega);
-						fclose (fp);
-						if (key_fp != NULL) {
-							fclose(key_fp);
-						}
-						return (-99);
-					} else {
-							cef_log_write (CefC_Log_Info,
-								"Publishing %s \n"
-								"	free memory="FMTU64"(MB), estimated memory usage="FMTU64"(MB)\n",
-							Uri_buff_p, free_mem_mega, estimated_mem_mega);
-					}
-				} else { //CefC_Cnpb_filesystem_Cache_Type
-					/* Get initial free fisk size */
-					get_filesystem_info (hdl->cache_path, &free_file_mega);
-					estimated_file_mega = (sizeof(uint16_t)+len+3)  * entry->cob_num / 1024 /1024;
-					if (estimated_file_mega > free_file_mega - CefC_Cpub_Reserved_Disk_Mega) {
-						cef_log_write (CefC_Log_Warn,
-							"Skipping content(%s) registration due to lack of disk.\n"
-							"	free disk="FMTU64"(MB), estimated disk usage="FMTU64"(MB)\n"
-							"	(Use %dMB as free reserve)\n",
-							Uri_buff_p, free_file_mega, estimated_file_mega,
-							CefC_Cpub_Reserved_Disk_Mega);
-						fclose (fp);
-						if (key_fp != NULL) {
-							fclose(key_fp);
-						}
-						return (-99);
-					} else {
-						cef_log_write (CefC_Log_Info, "Publishing %s \n"
-							"	free disk="FMTU64"(MB), estimated disk usage="FMTU64"(MB)\n"
-							"	(Use %dMB as free reserve)\n",
-							Uri_buff_p, free_file_mega, estimated_file_mega,
-							CefC_Cpub_Reserved_Disk_Mega);
-					}
+				if ((n == shdr->rec_num) &&
+					((memcmp (shdr->key, ss->key, SHA256_DIGEST_LENGTH) != 0) ||
+					 (memcmp (shdr->keyid, ss->keyid, CefC_KeyId_SIZ) != 0))) {
+					/* The content or the key was changed 	*/
+					ss->stale_f = 1;
+					munmap (map, (size_t) st.st_size);
+				} else if ((n == shdr->rec_num) &&
+					((ss->used = calloc (shdr->rec_num + 1, 1)) != NULL)) {
+					ss->map 	 = map;
+					ss->map_size = (size_t) st.st_size;
+					ss->recs 	 = recs;
+					ss->rec_num  = shdr->rec_num;
+				} else {
+					cef_log_write (CefC_Log_Warn,
+						"Ignored the invalid signature file (%s)\n", ss->path);
+					ss->stale_f = 1;
+					munmap (map, (size_t) st.st_size);
 				}
-				first_cob_f = 1;
 			}
-			if (len > 0) {
-				/*----------------------------------------------------------------------------------*/
-				/* [filesystem cache]                                                               */
-				/* "msg" and "name" are released after copying to the cache memory resource         */
-				/* in the cache program.                                                            */
-				/* [memory cache]                                                                   */
-				/* In the cache program, "msg" and "name" are reused even after being copied        */
-				/* to the memory resource of the cache, and are released when the cache is deleted. */
-				/*----------------------------------------------------------------------------------*/
-				if ((cont_entry.msg = calloc (1, len)) == NULL) {
-					cef_log_write (CefC_Log_Critical, "Failed to alloc memory\n");
-					conpubd_running_f = 0;
-					fclose (fp);
-					if (key_fp != NULL) {
-						fclose(key_fp);
-					}
-					return (-1);
-				}
-				memcpy (cont_entry.msg, cobbuff, len);
-				cont_entry.msg_len = len;
-				if ((cont_entry.name = calloc (1, Cob_prames_p->name_len)) == NULL) {
-					cef_log_write (CefC_Log_Critical, "Failed to alloc memory\n");
-					conpubd_running_f = 0;
-					fclose (fp);
-					if (key_fp != NULL) {
-						fclose(key_fp);
-					}
-					return (-1);
-				}
-				memcpy (cont_entry.name, Cob_prames_p->name, Cob_prames_p->name_len);
-				cont_entry.name_len = Cob_prames_p->name_len;
-				cont_entry.pay_len = Cob_prames_p->payload_len;
-				cont_entry.chunk_num = Cob_prames_p->chunk_num;
-				cont_entry.expiry = Cob_prames_p->expiry * 1000;
-				cont_entry.rct = (uint64_t)hdl->cache_default_rct;
-				/* cont_entry.node does not care */
-				rtc = hdl->cs_mod_int->cache_item_puts (&cont_entry, sizeof (cont_entry), NULL);
-				if (rtc < 0) {
-					cef_log_write (CefC_Log_Critical, "Failed to publish %s (cache_item_puts)\n", Uri_buff_p);
-					conpubd_running_f = 0;
-					fclose (fp);
-					if (key_fp != NULL) {
-						fclose(key_fp);
-					}
-					hdl->cs_mod_int->cache_item_puts (NULL, 0, NULL);
-					return (-1);
-				}
+		} else {
+			ss->stale_f = 1;
+		}
+		close (sfd);
+	}
+	ss->active_f = 1;
+	pthread_mutex_unlock (&conpub_sign_mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Closes the signature sidecar file and writes the signatures which are used
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_sign_store_close (
+	int commit_f								/* 1 if the content is published		*/
+) {
+	CefT_Cpub_Sign_Store* ss = &Sign_store;
+	CefT_Cpub_Sign_Hdr shdr;
+	CefT_Cpub_Sign_Rec* recs = NULL;
+	char tmp_path[PATH_MAX + 8];
+	uint32_t rec_num = 0;
+	uint32_t i;
+	FILE* fp;
+
+	pthread_mutex_lock (&conpub_sign_mutex);
+	if (ss->active_f == 0) {
+		pthread_mutex_unlock (&conpub_sign_mutex);
+		return;
+	}
+	ss->active_f = 0;
+	pthread_mutex_unlock (&conpub_sign_mutex);
+
+	/* Rewrites the sidecar file with the signatures used in this publishing 	*/
+	if ((commit_f) &&
+		((ss->new_num > 0) || (ss->used_num < ss->rec_num) || (ss->stale_f))) {
+		recs = (CefT_Cpub_Sign_Rec*) malloc (
+			((size_t) ss->used_num + ss->new_num + 1) * sizeof (CefT_Cpub_Sign_Rec));
+	}
+	if (recs != NULL) {
+		for (i = 0 ; i < ss->rec_num ; i++) {
+			if (ss->used[i]) {
+				memcpy (&recs[rec_num], &ss->recs[i], sizeof (CefT_Cpub_Sign_Rec));
+				rec_num++;
+			}
+		}
+		memcpy (&recs[rec_num], ss->new_recs, (size_t) ss->new_num * sizeof (CefT_Cpub_Sign_Rec));
+		rec_num += ss->new_num;
+		qsort (recs, rec_num, sizeof (CefT_Cpub_Sign_Rec), conpubd_sign_rec_compare);
+
+		memset (&shdr, 0, sizeof (CefT_Cpub_Sign_Hdr));
+		memcpy (shdr.magic, CefC_Cpub_Sign_Magic, sizeof (shdr.magic));
+		shdr.rec_num = rec_num;
+		memcpy (shdr.key, ss->key, SHA256_DIGEST_LENGTH);
+		memcpy (shdr.keyid, ss->keyid, CefC_KeyId_SIZ);
+
+		/* Replaces the file at once so that a broken file is not left 	*/
+		snprintf (tmp_path, sizeof (tmp_path), "%.*s.tmp", PATH_MAX - 1, ss->path);
+		fp = fopen (tmp_path, "wb");
+		if ((fp != NULL) &&
+			(fwrite (&shdr, sizeof (CefT_Cpub_Sign_Hdr), 1, fp) == 1) &&
+			(fwrite (recs, sizeof (CefT_Cpub_Sign_Rec), rec_num, fp) == rec_num) &&
+			(fclose (fp) == 0)) {
+			fp = NULL;
+			if (rename (tmp_path, ss->path) < 0) {
+				unlink (tmp_path);
 			}
-			seqnum++;
 		} else {
-			if (feof (fp) == 0 || ferror (fp) != 0) {
-				cef_log_write (CefC_Log_Critical, "Failed to publish %s (Read Error)\n", Uri_buff_p);
-				conpubd_running_f = 0;
+			cef_log_write (CefC_Log_Warn,
+				"Failed to write the signature file (%s)\n", tmp_path);
+			if (fp != NULL) {
 				fclose (fp);
-				if (key_fp != NULL) {
-					fclose(key_fp);
-				}
-				hdl->cs_mod_int->cache_item_puts (NULL, 0, NULL);
-				return (-1);
 			}
-			break;
+			unlink (tmp_path);
 		}
+		free (recs);
+	}
+	if (commit_f) {
+		cef_log_write (CefC_Log_Info,
+			"Signatures of %s: reused=%u, signed=%u\n", Uri_buff_p, ss->used_num, ss->new_num);
+	}
+	if (ss->invalid_num > 0) {
+		cef_log_write (CefC_Log_Warn,
+			"Ignored %u invalid signatures in the signature file (%s)\n",
+			ss->invalid_num, ss->path);
 	}
 
-	hdl->cs_mod_int->cache_item_puts (NULL, 0, NULL);
-	fclose (fp);
-	if (key_fp != NULL) {
-		fclose(key_fp);
+	if (ss->map) {
+		munmap (ss->map, ss->map_size);
 	}
-	cef_log_write (CefC_Log_Info, "Published %s (time=%ld) \n", Uri_buff_p, time (NULL) - wtime_s);
+	free (ss->used);
+	free (ss->new_recs);
+	pthread_mutex_lock (&conpub_sign_mutex);
+	memset (ss, 0, sizeof (CefT_Cpub_Sign_Store));
+	pthread_mutex_unlock (&conpub_sign_mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Looks up the signature of the digest in the sidecar file
+----------------------------------------------------------------------------------------*/
+static int									/* 1 if the signature is found				*/
+conpubd_sign_lookup (
+	const unsigned char* name,
+	int name_len,
+	const unsigned char* digest,
+	unsigned char* sign,
+	unsigned int* sign_len
+) {
+	CefT_Cpub_Sign_Store* ss = &Sign_store;
+	CefT_Cpub_Sign_Rec* recs;
+	CefT_Cpub_Sign_Rec* rec = NULL;
+	uint32_t pos;
+
+	pthread_mutex_lock (&conpub_sign_mutex);
+	/* The digest is the first member of the record, so it is used as the key 	*/
+	if ((ss->active_f) && (ss->rec_num > 0) &&
+		(ss->name_len == name_len) && (memcmp (ss->name, name, name_len) == 0)) {
+		rec = (CefT_Cpub_Sign_Rec*) bsearch (digest, ss->recs, ss->rec_num,
+					sizeof (CefT_Cpub_Sign_Rec), conpubd_sign_rec_compare);
+	}
+	if ((rec == NULL) || (rec->sign_len > CefC_Cpub_Sign_Max)) {
+		pthread_mutex_unlock (&conpub_sign_mutex);
+		return (0);
+	}
+	memcpy (sign, rec->sign, rec->sign_len);
+	*sign_len = rec->sign_len;
+	recs = ss->recs;
+	pos = (uint32_t)(rec - ss->recs);
+	pthread_mutex_unlock (&conpub_sign_mutex);
+
+	/* The sidecar file is not trusted, the CRC of a record only detects that 	*/
+	/* it was broken, so the signature is verified before it is reused. The 	*/
+	/* record which fails is not used and the message is signed again. 		*/
+	if (cef_valid_rsa_sha256_sign_verify (name, name_len, digest, sign, *sign_len) != 1) {
+		pthread_mutex_lock (&conpub_sign_mutex);
+		if ((ss->active_f) && (ss->recs == recs)) {
+			ss->invalid_num++;
+		}
+		pthread_mutex_unlock (&conpub_sign_mutex);
+		return (0);
+	}
+
+	pthread_mutex_lock (&conpub_sign_mutex);
+	if ((ss->active_f) && (ss->recs == recs) && (ss->used[pos] == 0)) {
+		ss->used[pos] = 1;
+		ss->used_num++;
+	}
+	pthread_mutex_unlock (&conpub_sign_mutex);
+
+	return (1);
+}
+/*--------------------------------------------------------------------------------------
+	Stores the signature computed in the publishing
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_sign_store (
+	const unsigned char* name,
+	int name_len,
+	const unsigned char* digest,
+	const unsigned char* sign,
+	unsigned int sign_len
+) {
+	CefT_Cpub_Sign_Store* ss = &Sign_store;
+	CefT_Cpub_Sign_Rec* recs;
+	CefT_Cpub_Sign_Rec* rec;
+	uint32_t new_max;
+
+	if (sign_len > CefC_Cpub_Sign_Max) {
+		return;
+	}
+	pthread_mutex_lock (&conpub_sign_mutex);
+	if ((ss->active_f == 0) ||
+		(ss->name_len != name_len) || (memcmp (ss->name, name, name_len) != 0)) {
+		pthread_mutex_unlock (&conpub_sign_mutex);
+		return;
+	}
+	if (ss->new_num == ss->new_max) {
+		new_max = (ss->new_max) ? ss->new_max * 2 : 1024;
+		recs = (CefT_Cpub_Sign_Rec*) realloc (
+					ss->new_recs, (size_t) new_max * sizeof (CefT_Cpub_Sign_Rec));
+		if (recs == NULL) {
+			pthread_mutex_unlock (&conpub_sign_mutex);
+			return;
+		}
+		ss->new_recs = recs;
+		ss->new_max  = new_max;
+	}
+	rec = &ss->new_recs[ss->new_num];
+	memset (rec, 0, sizeof (CefT_Cpub_Sign_Rec));
+	memcpy (rec->digest, digest, SHA256_DIGEST_LENGTH);
+	memcpy (rec->sign, sign, sign_len);
+	rec->sign_len = (uint16_t) sign_len;
+	rec->crc = cef_valid_crc32c_calc ((unsigned char*) rec, offsetof (CefT_Cpub_Sign_Rec, crc));
+	ss->new_num++;
+	pthread_mutex_unlock (&conpub_sign_mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Compares the digests of the signature records
+----------------------------------------------------------------------------------------*/
+static int
+conpubd_sign_rec_compare (
+	const void* a,
+	const void* b
+) {
+	return (memcmp (a, b, SHA256_DIGEST_LENGTH));
+}
+/*--------------------------------------------------------------------------------------
+	Creates the path of the signature sidecar file of the content
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_sign_path_create (
+	CefT_Conpubd_Handle* hdl,					/* conpub daemon handle					*/
+	const unsigned char* name,
+	int name_len,
+	char* path
+) {
+	unsigned char hash[SHA256_DIGEST_LENGTH];
+	char hex[SHA256_DIGEST_LENGTH * 2 + 1];
+	int i;
+
+	cef_valid_sha256 (name, (size_t) name_len, hash);
+	for (i = 0 ; i < SHA256_DIGEST_LENGTH ; i++) {
+		sprintf (&hex[i * 2], "%02x", hash[i]);
+	}
+	/* The length of the directory is checked when the config file is read 	*/
+	snprintf (path, PATH_MAX, "%.*s/%s" CefC_Cpub_Sign_Suffix,
+		(int)(PATH_MAX - sizeof (hex) - sizeof (CefC_Cpub_Sign_Suffix) - 1),
+		hdl->sign_cache_dir, hex);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the signature sidecar file of the content which is no longer published
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_sign_remove (
+	CefT_Conpubd_Handle* hdl,					/* conpub daemon handle					*/
+	CefT_Cpubcnt_Hdl* entry
+) {
+	char path[PATH_MAX];
+
+	if (hdl->sign_cache_dir[0] == 0x00) {
+		return;
+	}
+	conpubd_sign_path_create (hdl, entry->name, entry->name_len, path);
+	unlink (path);
+}
+/*--------------------------------------------------------------------------------------
+	Publishes the content in the lazy mode
+----------------------------------------------------------------------------------------*/
+static int
+conpubd_publish_lazy_content_create (
+	CefT_Conpubd_Handle* hdl,					/* conpub daemon handle					*/
+	CefT_Cpubcnt_Hdl* entry
+) {
+	CefT_Cpub_Lazy_Cont* lc;
+	int fd;
+	struct stat st;
+
+	/* Check Content num  */
+	if (hdl->published_contents_num >= hdl->contents_num) {
+		cef_frame_conversion_name_to_string (entry->name, entry->name_len, Uri_buff_p, "ccn");
+		cef_log_write (CefC_Log_Warn
+						, "CONTENTS CAPACITY over : %s, Publishied contents=%d\n"
+						, Uri_buff_p, hdl->contents_num);
+		return (-99);
+	}
+	cef_frame_conversion_name_to_string (entry->name, entry->name_len, Uri_buff_p, "ccn");
+
+	fd = open (entry->file_path, O_RDONLY);
+	if (fd < 0) {
+		cef_log_write (CefC_Log_Error, "Failed to publish %s (%s)\n", Uri_buff_p, strerror (errno));
+		return (-1);
+	}
+	if (fstat (fd, &st) < 0) {
+		cef_log_write (CefC_Log_Error, "Failed to publish %s (%s)\n", Uri_buff_p, strerror (errno));
+		close (fd);
+		return (-1);
+	}
+	lc = (CefT_Cpub_Lazy_Cont*) calloc (1, sizeof (CefT_Cpub_Lazy_Cont));
+	if (lc == NULL) {
+		cef_log_write (CefC_Log_Critical, "Failed to alloc memory\n");
+		close (fd);
+		return (-1);
+	}
+	close (fd);
+	/* The file is not mapped, so that the truncation of the file by another 	*/
+	/* process does not raise SIGBUS. The Cobs are read with pread. 			*/
+	lc->dev 		= st.st_dev;
+	lc->ino 		= st.st_ino;
+	lc->file_size 	= st.st_size;
+	lc->mtime 		= st.st_mtim;
+	lc->block_size 	= hdl->block_size;
+	lc->cob_num 	= (uint32_t)((st.st_size + hdl->block_size - 1) / hdl->block_size);
+
+	lc->prames = (CefT_CcnMsg_MsgBdy*) malloc (sizeof (CefT_CcnMsg_MsgBdy));
+	if ((lc->prames == NULL) ||
+		(conpubd_publish_prames_set (hdl, entry, lc->prames, &lc->opt, &lc->last_prames) < 0)) {
+		cef_log_write (CefC_Log_Critical, "Failed to alloc memory\n");
+		free (lc->prames);
+		free (lc);
+		return (-1);
+	}
+	pthread_mutex_lock (&conpub_lazy_mutex);
+	entry->lazy = lc;
+	pthread_mutex_unlock (&conpub_lazy_mutex);
+
+	cef_log_write (CefC_Log_Info, "Published %s (lazy, cobs=%u) \n", Uri_buff_p, lc->cob_num);
 	/* CefC_T_OPT_APP_REG */
 	{
 		CefT_Connect connect;
@@ -3931,7 +5149,263 @@ conpubd_publish_content_create (
 
 	hdl->published_contents_num ++;
 
-   	return (rtc);
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Releases the content published in the lazy mode
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_lazy_content_release (
+	CefT_Cpubcnt_Hdl* entry
+) {
+	CefT_Cpub_Lazy_Cont* lc;
+
+	pthread_mutex_lock (&conpub_lazy_mutex);
+	lc = entry->lazy;
+	entry->lazy = NULL;
+	if (lc == NULL) {
+		pthread_mutex_unlock (&conpub_lazy_mutex);
+		return;
+	}
+
+	/* Drops the Cobs of the content from the LRU 	*/
+	while (lc->cobs) {
+		conpubd_lazy_lru_remove (lc->cobs);
+	}
+	pthread_mutex_unlock (&conpub_lazy_mutex);
+
+	free (lc->prames);
+	free (lc->last_prames);
+	free (lc);
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Creates the LRU of the Cobs built in the lazy mode
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+conpubd_lazy_lru_create (
+	uint32_t capacity							/* max number of the Cobs				*/
+) {
+	uint32_t bucket_num = 1;
+
+	memset (&Lazy_lru, 0, sizeof (CefT_Cpub_Lazy_Lru));
+
+	while (bucket_num < capacity) {
+		bucket_num <<= 1;
+	}
+	Lazy_lru.buckets = (CefT_Cpub_Lazy_Cob**) calloc (bucket_num, sizeof (CefT_Cpub_Lazy_Cob*));
+	Lazy_lru.cobbuff = (unsigned char*) malloc (CefC_Max_Length);
+	if ((Lazy_lru.buckets == NULL) || (Lazy_lru.cobbuff == NULL)) {
+		conpubd_lazy_lru_destroy ();
+		return (-1);
+	}
+	Lazy_lru.bucket_mask 	= bucket_num - 1;
+	Lazy_lru.capacity 		= capacity;
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Destroys the LRU of the Cobs built in the lazy mode
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_lazy_lru_destroy (
+	void
+) {
+	while (Lazy_lru.head) {
+		conpubd_lazy_lru_remove (Lazy_lru.head);
+	}
+	free (Lazy_lru.buckets);
+	free (Lazy_lru.cobbuff);
+	memset (&Lazy_lru, 0, sizeof (CefT_Cpub_Lazy_Lru));
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Returns the hash bucket of the Cob built in the lazy mode
+----------------------------------------------------------------------------------------*/
+static CefT_Cpub_Lazy_Cob**
+conpubd_lazy_lru_bucket (
+	CefT_Cpub_Lazy_Cont* lc,
+	uint32_t chunk_num
+) {
+	uint32_t hash;
+
+	hash = (uint32_t)((uintptr_t) lc >> 4) * 2654435761u;
+	hash ^= chunk_num * 2246822519u;
+
+	return (&Lazy_lru.buckets[(hash ^ (hash >> 16)) & Lazy_lru.bucket_mask]);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the Cob from the LRU
+----------------------------------------------------------------------------------------*/
+static void
+conpubd_lazy_lru_remove (
+	CefT_Cpub_Lazy_Cob* cob
+) {
+	CefT_Cpub_Lazy_Cob** bp;
+
+	bp = conpubd_lazy_lru_bucket (cob->cont, cob->chunk_num);
+	while (*bp != cob) {
+		bp = &(*bp)->hnext;
+	}
+	*bp = cob->hnext;
+
+	if (cob->cprev) {
+		cob->cprev->cnext = cob->cnext;
+	} else {
+		cob->cont->cobs = cob->cnext;
+	}
+	if (cob->cnext) {
+		cob->cnext->cprev = cob->cprev;
+	}
+
+	if (cob->prev) {
+		cob->prev->next = cob->next;
+	} else {
+		Lazy_lru.head = cob->next;
+	}
+	if (cob->next) {
+		cob->next->prev = cob->prev;
+	} else {
+		Lazy_lru.tail = cob->prev;
+	}
+	Lazy_lru.cob_num--;
+
+	free (cob->msg);
+	free (cob);
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Builds the Cob of the content published in the lazy mode and sends it
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+conpubd_lazy_cob_send (
+	CefT_Conpubd_Handle* hdl,					/* conpub daemon handle					*/
+	CefT_Cpubcnt_Hdl* entry,
+	uint32_t chunk_num,
+	int sock									/* socket to send the Cob				*/
+) {
+	CefT_Cpub_Lazy_Cont* lc;
+	CefT_Cpub_Lazy_Cob** bp;
+	CefT_Cpub_Lazy_Cob* cob;
+	CefT_CcnMsg_MsgBdy* prames;
+	struct stat st;
+	off_t offset;
+	int len;
+	int fd;
+
+	pthread_mutex_lock (&conpub_lazy_mutex);
+	lc = entry->lazy;
+	if ((lc == NULL) || (chunk_num >= lc->cob_num)) {
+		pthread_mutex_unlock (&conpub_lazy_mutex);
+		return (-1);
+	}
+
+	bp = conpubd_lazy_lru_bucket (lc, chunk_num);
+	for (cob = *bp ; cob ; cob = cob->hnext) {
+		if ((cob->cont == lc) && (cob->chunk_num == chunk_num)) {
+			break;
+		}
+	}
+
+	if (cob == NULL) {
+		/* Builds the Cob from the file, which may have been truncated or 	*/
+		/* replaced since it was published 									*/
+		fd = open (entry->file_path, O_RDONLY);
+		if ((fd < 0) || (fstat (fd, &st) < 0) ||
+			(st.st_dev != lc->dev) || (st.st_ino != lc->ino) ||
+			(st.st_size != lc->file_size) ||
+			(st.st_mtim.tv_sec != lc->mtime.tv_sec) ||
+			(st.st_mtim.tv_nsec != lc->mtime.tv_nsec)) {
+			pthread_mutex_unlock (&conpub_lazy_mutex);
+			if (fd >= 0) {
+				close (fd);
+			}
+			cef_log_write (CefC_Log_Warn,
+				"%s (%s was changed after it was published)\n", __func__, entry->file_path);
+			return (-1);
+		}
+		prames = ((chunk_num == lc->cob_num - 1) && (lc->last_prames)) ?
+					lc->last_prames : lc->prames;
+		offset = (off_t) chunk_num * lc->block_size;
+		len = (lc->file_size - offset < (off_t) lc->block_size) ?
+					(int)(lc->file_size - offset) : lc->block_size;
+		if (pread (fd, prames->payload, len, offset) != len) {
+			pthread_mutex_unlock (&conpub_lazy_mutex);
+			close (fd);
+			cef_log_write (CefC_Log_Warn,
+				"%s (failed to read %s)\n", __func__, entry->file_path);
+			return (-1);
+		}
+		close (fd);
+		prames->payload_len = (uint16_t) len;
+		prames->chunk_num = chunk_num;
+		len = cef_frame_object_create (Lazy_lru.cobbuff, &lc->opt, prames);
+		if (len <= 0) {
+			pthread_mutex_unlock (&conpub_lazy_mutex);
+			return (-1);
+		}
+
+		/* Discards the least recently used Cob 	*/
+		if (Lazy_lru.cob_num >= Lazy_lru.capacity) {
+			conpubd_lazy_lru_remove (Lazy_lru.tail);
+		}
+		cob = (CefT_Cpub_Lazy_Cob*) calloc (1, sizeof (CefT_Cpub_Lazy_Cob));
+		if ((cob == NULL) || ((cob->msg = (unsigned char*) malloc (len)) == NULL)) {
+			free (cob);
+			pthread_mutex_unlock (&conpub_lazy_mutex);
+			cef_log_write (CefC_Log_Warn, "Failed to alloc memory (lazy Cob)\n");
+			return (-1);
+		}
+		memcpy (cob->msg, Lazy_lru.cobbuff, len);
+		cob->msg_len 	= (uint16_t) len;
+		cob->cont 		= lc;
+		cob->chunk_num 	= chunk_num;
+		cob->hnext 		= *bp;
+		*bp = cob;
+		cob->cnext = lc->cobs;
+		if (lc->cobs) {
+			lc->cobs->cprev = cob;
+		}
+		lc->cobs = cob;
+		cob->next = Lazy_lru.head;
+		if (Lazy_lru.head) {
+			Lazy_lru.head->prev = cob;
+		} else {
+			Lazy_lru.tail = cob;
+		}
+		Lazy_lru.head = cob;
+		Lazy_lru.cob_num++;
+	} else if (cob != Lazy_lru.head) {
+		/* Moves the Cob to the head of the LRU 	*/
+		cob->prev->next = cob->next;
+		if (cob->next) {
+			cob->next->prev = cob->prev;
+		} else {
+			Lazy_lru.tail = cob->prev;
+		}
+		cob->prev = NULL;
+		cob->next = Lazy_lru.head;
+		Lazy_lru.head->prev = cob;
+		Lazy_lru.head = cob;
+	}
+
+	/* Set cache time */
+	{
+		uint64_t cachetime;
+		time_t timer = time (NULL);
+		struct tm* local = localtime (&timer);
+		time_t now_time = mktime (local);
+		cachetime = (uint64_t)(now_time + hdl->cache_default_rct) * 1000;
+		cef_frame_opheader_cachetime_update (cob->msg, cachetime);
+	}
+	/* Send Cob to cefnetd */
+	conpubd_plugin_cob_msg_send (sock, cob->msg, cob->msg_len);
+	pthread_mutex_unlock (&conpub_lazy_mutex);
+
+	return (0);
 }
 /*--------------------------------------------------------------------------------------
 	Deletes the Cobs
@@ -3966,6 +5440,11 @@ conpubd_publish_content_delete (
 		}
 	}
 
+	if (entry->lazy) {
+		conpubd_lazy_content_release (entry);
+		return (rtc);
+	}
+
 	memcpy (Name_buff_p, entry->name, entry->name_len);
 	name_len = entry->name_len;
 
@@ -4010,6 +5489,7 @@ conpubd_content_reg_check (
 				if (conpubd_publish_content_delete (hdl, work) != 0) {
 					;
 				}
+				conpubd_sign_remove (hdl, work);
 				bwork->next = work->next;
 				free (work);
 				work = bwork;
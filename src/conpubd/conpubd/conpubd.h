@@ -77,6 +77,10 @@ typedef struct {
 	int				contents_num;
 	uint64_t		contents_capacity;
 	int				block_size;
+	int				publish_workers;
+	int				lazy_publish;
+	uint32_t		lazy_cache_cobs;
+	char			sign_cache_dir[PATH_MAX];
 	char			cefnetd_node[128];
 	int				cefnetd_port;
 	char			restore_path[PATH_MAX];
@@ -134,6 +134,10 @@ typedef struct {
 	uint16_t 		valid_type;
 	int				t_pending;
 	char			publisher_id[SHA512_DIGEST_LENGTH];
+	int				publish_workers;			/* Threads which build Cobs				*/
+	int				lazy_publish;				/* Builds Cobs when Interests arrive	*/
+	uint32_t		lazy_cache_cobs;			/* Cobs kept by the lazy publishing		*/
+	char			sign_cache_dir[PATH_MAX];	/* Directory of the signature files		*/
 
 	/********** APP FIB registration info. ***********/
 	char 		cefnetd_id[128];
@@ -176,6 +180,10 @@ typedef struct _CefT_Cpubcnt_Hdl {
 	uint64_t			cob_num;
 	int					line_no;
 	uint16_t			t_pending;
+	uint64_t			fingerprint;			/* Digest of the definition and the		*/
+												/* content file							*/
+	struct _CefT_Cpub_Lazy_Cont* lazy;			/* Source of the Cobs built on demand	*/
+												/* (NULL if the Cobs are cached)		*/
 	struct _CefT_Cpubcnt_Hdl* next;
 
 } CefT_Cpubcnt_Hdl;
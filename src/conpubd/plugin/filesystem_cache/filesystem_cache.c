@@ -412,8 +412,6 @@ fsc_cache_item_get (
 
 	CsmgrT_Stat* rcd = NULL;
 	uint32_t	file_msglen;
-	uint64_t 	mask;
-	uint32_t 	x;
 	char		file_path[PATH_MAX];
 	static char	red_file_path[PATH_MAX] = {0};
 	int 		cob_block_index;
@@ -570,11 +568,7 @@ fsc_cache_item_get (
 
 	for (i = pos_index + 1 ; i < FscC_Page_Cob_Num ; i++) {
 		if (tx_cnt < FscC_Tx_Cob_Num) {
-			mask = 1;
-			x = seqno / 64;
-			mask <<= (seqno % 64);
-
-			if ((rcd->map_max-1) < x || !(rcd->cob_map[x] & mask)) {
+			if (!cef_chunk_set_contains (&rcd->cob_set, seqno)) {
 				seqno++;
 				continue;
 			}
@@ -115,6 +115,7 @@ static uint8_t 				csmgrd_running_f = 0;
 static char 				csmgr_conf_dir[PATH_MAX] = {"/usr/local/cefore"};
 static char 				root_user_name[CefC_Csmgr_User_Len] = {"root"};
 static char 				csmgr_local_sock_name[PATH_MAX] = {0};
+static char 				csmgr_worker_sock_name[CsmgrdC_Worker_Max][PATH_MAX];
 
 static pthread_mutex_t 		csmgr_comn_buff_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t 		csmgr_main_cob_buff_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -259,7 +260,7 @@ csmgrd_input_message_process (
 /*--------------------------------------------------------------------------------------
 	Incoming Interest Message
 ----------------------------------------------------------------------------------------*/
-static void
+static int							/* CefC_Csmgr_Cob_Exist if the Cob has been sent	*/
 csmgrd_incoming_interest (
 	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
 	int sock,									/* recv socket							*/
@@ -267,6 +268,16 @@ csmgrd_incoming_interest (
 	int buff_len,								/* receive message length				*/
 	uint8_t type								/* receive message type					*/
 );
+/*--------------------------------------------------------------------------------------
+	Incoming Bulk Interest Message
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_incoming_bulk_interest (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock,									/* recv socket							*/
+	unsigned char* buff,						/* receive message						*/
+	int buff_len								/* receive message length				*/
+);
 /*--------------------------------------------------------------------------------------
 	Parse Interest message
 ----------------------------------------------------------------------------------------*/
@@ -335,6 +346,15 @@ csmgrd_incoming_increment_msg (
 	unsigned char* buff,						/* receive message						*/
 	int buff_len								/* receive message length				*/
 );
+/*--------------------------------------------------------------------------------------
+	Receive Bulk Increment Access Count message
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_incoming_bulk_increment_msg (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	unsigned char* buff,						/* receive message						*/
+	int buff_len								/* receive message length				*/
+);
 /*--------------------------------------------------------------------------------------
 	Receive Echo message
 ----------------------------------------------------------------------------------------*/
@@ -565,6 +585,57 @@ csmgrd_status_msg_set_peernum (
 	uint16_t peer_num							/* Number of connections to csmgrd		*/
 );
 
+/*--------------------------------------------------------------------------------------
+	Selects the lookup worker which handles the message
+----------------------------------------------------------------------------------------*/
+static int							/* index of the lookup worker						*/
+csmgrd_worker_select (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	unsigned char* msg,							/* receive message						*/
+	int msg_len,								/* message length						*/
+	uint8_t type								/* message type							*/
+);
+
+/*--------------------------------------------------------------------------------------
+	Closes the sockets to the threads which are opened for the peer
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_thread_sock_close (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int index									/* index of the peer					*/
+);
+
+/*--------------------------------------------------------------------------------------
+	Creates the epoll instance and registers the listen sockets
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_epoll_create (
+	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
+);
+
+/*--------------------------------------------------------------------------------------
+	Registers the socket to epoll
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_epoll_sock_add (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int fd,										/* socket								*/
+	uint32_t index								/* index of the peer					*/
+);
+
+#ifdef CsmgrdC_Epoll_Enable
+/*--------------------------------------------------------------------------------------
+	Waits for the sockets registered to epoll
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgrd_epoll_socket_wait (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	struct pollfd fds[],
+	int fds_index[],
+	int* accept_f								/* set if a listen socket is readable	*/
+);
+#endif // CsmgrdC_Epoll_Enable
+
 /****************************************************************************************
  ****************************************************************************************/
 /*--------------------------------------------------------------------------------------
@@ -667,6 +738,7 @@ csmgrd_handle_create (
 	hdl->tcp_listen_fd 		= -1;
 	hdl->local_listen_fd 	= -1;
 	hdl->local_peer_sock 	= -1;
+	hdl->epoll_fd			= -1;
 	hdl->task				= CsmgrdC_Task_Main_Process;
 
 	/* Records the user which launched cefnetd 		*/
@@ -719,13 +791,15 @@ csmgrd_handle_create (
 		return (NULL);
 	}
 	hdl->port_num = conf_param.port_num;
+	hdl->worker_num = conf_param.worker_num;
 	for (i = 0 ; i < CsmgrdC_Max_Sock_Num ; i++) {
 		hdl->tcp_fds[i] 	= -1;
 		hdl->tcp_index[i] 	= 0;
-		hdl->th_fds[i]		= -1;
+		memset (hdl->th_fds[i], -1, sizeof (hdl->th_fds[i]));
 		hdl->snd_fds[i]		= -1;
 	}
 	cef_log_write (CefC_Log_Info, "Creation the TCP listen socket ... OK\n");
+	csmgrd_epoll_create (hdl);
 
 #ifdef CefC_Debug
 	cef_dbg_write (CefC_Dbg_Fine, "Create plugin interface.\n");
@@ -870,6 +944,7 @@ csmgrd_thread_handle_create (
 	hdl->tcp_listen_fd 		= -1;
 	hdl->local_listen_fd 	= -1;
 	hdl->local_peer_sock 	= -1;
+	hdl->epoll_fd			= -1;
 	hdl->task				= CsmgrdC_Task_Thread;
 
 	for (i = 0 ; i < CsmgrdC_Max_Sock_Num ; i++) {
@@ -892,10 +967,11 @@ csmgrd_thread_handle_create (
 	for (i = 0 ; i < CsmgrdC_Max_Sock_Num ; i++) {
 		hdl->tcp_fds[i] 	= -1;
 		hdl->tcp_index[i] 	= 0;
-		hdl->th_fds[i]		= -1;
+		memset (hdl->th_fds[i], -1, sizeof (hdl->th_fds[i]));
 		hdl->snd_fds[i]		= -1;
 	}
 	cef_log_write (CefC_Log_Info, "Creation the local listen socket ... OK\n");
+	csmgrd_epoll_create (hdl);
 
 #ifdef CefC_Debug
 	cef_dbg_write (CefC_Dbg_Fine, "Duplication plugin interface.\n");
@@ -934,8 +1010,10 @@ csmgrd_event_dispatch (
 	pthread_t		push_bytes_process_th;
 	pthread_t		csmgrd_resource_mon_th;
 	pthread_t		csmgrd_incoming_status_msg_th;
-	pthread_t		csmgrd_incoming_other_msg_th;
+	pthread_t		csmgrd_incoming_other_msg_th[CsmgrdC_Worker_Max];
+	int 			worker_num = 0;
 	void*			status;
+	int 			i;
 
 	CefT_Csmgrd_Handle* thread_hdl = NULL;
 
@@ -993,24 +1071,40 @@ csmgrd_event_dispatch (
 		csmgrd_handle_destroy (&thread_hdl, CSMGR_LOCAL_SOCK_NAME_STATUS_THREAD);
 	}
 
-	thread_hdl = csmgrd_thread_handle_create (hdl, CSMGR_LOCAL_SOCK_NAME_OTHER_THREAD);
-	if (thread_hdl == NULL) {
-		cef_log_write (CefC_Log_Error, "Unable to create csmgrd thread handle.\n");
-		unlink (CSMGR_LOCAL_SOCK_NAME_OTHER_THREAD);
-		csmgrd_running_f = 0;
-	}
-	if (cef_pthread_create (&csmgrd_incoming_other_msg_th, NULL, csmgrd_incoming_msg_thread, thread_hdl) == -1) {
-		cef_log_write (CefC_Log_Error,
-						"Failed to create the new thread(csmgrd_incoming_msg_thread(other))\n");
-		csmgrd_running_f = 0;
-		csmgrd_handle_destroy (&thread_hdl, CSMGR_LOCAL_SOCK_NAME_OTHER_THREAD);
+	/* Creates the lookup workers, the messages are distributed by the name hash 	*/
+	for (i = 0 ; i < hdl->worker_num && csmgrd_running_f ; i++) {
+		if (i == 0) {
+			strcpy (csmgr_worker_sock_name[i], CSMGR_LOCAL_SOCK_NAME_OTHER_THREAD);
+		} else {
+			sprintf (csmgr_worker_sock_name[i], "%s_%d",
+				CSMGR_LOCAL_SOCK_NAME_OTHER_THREAD, i);
+		}
+		thread_hdl = csmgrd_thread_handle_create (hdl, csmgr_worker_sock_name[i]);
+		if (thread_hdl == NULL) {
+			cef_log_write (CefC_Log_Error, "Unable to create csmgrd thread handle.\n");
+			unlink (csmgr_worker_sock_name[i]);
+			csmgrd_running_f = 0;
+			break;
+		}
+		if (cef_pthread_create (&csmgrd_incoming_other_msg_th[i], NULL,
+				csmgrd_incoming_msg_thread, thread_hdl) == -1) {
+			cef_log_write (CefC_Log_Error,
+				"Failed to create the new thread(csmgrd_incoming_msg_thread(other))\n");
+			csmgrd_running_f = 0;
+			csmgrd_handle_destroy (&thread_hdl, csmgr_worker_sock_name[i]);
+			break;
+		}
+		worker_num++;
 	}
+	cef_log_write (CefC_Log_Info, "Lookup workers: %d\n", worker_num);
 
 	csmgrd_event_main_loop (hdl);
 
 	pthread_cond_signal (&csmgr_comn_buff_cond);		/* To avoid deadlock */
 	pthread_join (csmgrd_incoming_status_msg_th, &status);
-	pthread_join (csmgrd_incoming_other_msg_th, &status);
+	for (i = 0 ; i < worker_num ; i++) {
+		pthread_join (csmgrd_incoming_other_msg_th[i], &status);
+	}
 	pthread_join (csmgrd_msg_process_th, &status);
 	pthread_join (csmgrd_expire_check_th, &status);
 	pthread_join (push_bytes_process_th, &status);
@@ -1036,23 +1130,45 @@ csmgrd_event_main_loop (
 	int len;
 	int res;
 	int i;
+	int accept_f = 1;
 
 	/* Main loop */
 	while (csmgrd_running_f) {
-		if (hdl->task == CsmgrdC_Task_Main_Process) {
-			/* check accept */
-			csmgrd_local_sock_check (hdl);
+		if (accept_f) {
+			if (hdl->task == CsmgrdC_Task_Main_Process) {
+				/* check accept */
+				csmgrd_local_sock_check (hdl);
 
-			/* Checks socket accept 			*/
-			csmgrd_tcp_connect_accept (hdl);
-		} else {
-			/* Checks thread socket accept */
-			csmgrd_thread_local_sock_check (hdl);
+				/* Checks socket accept 			*/
+				csmgrd_tcp_connect_accept (hdl);
+			} else {
+				/* Checks thread socket accept */
+				csmgrd_thread_local_sock_check (hdl);
+			}
 		}
 
-		/* Sets fds to be polled 			*/
-		fdnum = csmgrd_poll_socket_prepare (hdl, fds, fds_index);
-		res = poll (fds, fdnum, 1);
+#ifdef CsmgrdC_Epoll_Enable
+		if (hdl->epoll_fd != -1) {
+			/* Waits for the registered sockets, the listen sockets are also 	*/
+			/* registered so that accept is called only when it is needed 		*/
+			res = csmgrd_epoll_socket_wait (hdl, fds, fds_index, &accept_f);
+			if (accept_f) {
+				/* Accepts before the received messages are handled 	*/
+				if (hdl->task == CsmgrdC_Task_Main_Process) {
+					csmgrd_local_sock_check (hdl);
+					csmgrd_tcp_connect_accept (hdl);
+				} else {
+					csmgrd_thread_local_sock_check (hdl);
+				}
+				accept_f = 0;
+			}
+		} else
+#endif // CsmgrdC_Epoll_Enable
+		{
+			/* Sets fds to be polled 			*/
+			fdnum = csmgrd_poll_socket_prepare (hdl, fds, fds_index);
+			res = poll (fds, fdnum, 1);
+		}
 		if (res < 0) {
 			/* poll error */
 #ifdef CefC_Debug
@@ -1080,6 +1196,7 @@ csmgrd_event_main_loop (
 #endif // CefC_Debug
 				if ((hdl->local_peer_sock != -1) && (fds[i].fd == hdl->local_peer_sock)) {
 					/* Close Local socket */
+					csmgrd_plugin_send_queue_close (hdl->local_peer_sock);
 					close (hdl->local_peer_sock);
 					hdl->local_peer_sock = -1;
 					cef_log_write (CefC_Log_Info, "Close Local peer\n");
@@ -1090,6 +1207,7 @@ csmgrd_event_main_loop (
 							hdl->peer_id_str[fds_index[i]],
 							hdl->peer_sv_str[fds_index[i]],
 							hdl->tcp_fds[fds_index[i]]);
+						csmgrd_plugin_send_queue_close (hdl->tcp_fds[fds_index[i]]);
 						close (hdl->tcp_fds[fds_index[i]]);
 						hdl->tcp_fds[fds_index[i]] = -1;
 						hdl->peer_num--;
@@ -1097,14 +1215,7 @@ csmgrd_event_main_loop (
 					/* Reset buffer */
 					hdl->tcp_index[fds_index[i]] = 0;
 				}
-				if (hdl->th_fds[fds_index[i]] != -1) {
-#ifdef CefC_Debug
-					cef_dbg_write (CefC_Dbg_Fine, "close sock:%d\n",
-						hdl->th_fds[fds_index[i]]);
-#endif // CefC_Debug
-					close (hdl->th_fds[fds_index[i]]);
-					hdl->th_fds[fds_index[i]] = -1;
-				}
+				csmgrd_thread_sock_close (hdl, fds_index[i]);
 				hdl->snd_fds[fds_index[i]] = -1;
 				res--;
 				continue;
@@ -1137,6 +1248,7 @@ cef_dbg_write (CefC_Dbg_Finer, "i=%d, len=%d, last_len=%d\n",
 					if ((hdl->local_peer_sock != -1) &&
 						(fds[i].fd == hdl->local_peer_sock)) {
 						/* Close Local socket */
+						csmgrd_plugin_send_queue_close (hdl->local_peer_sock);
 						close (hdl->local_peer_sock);
 						hdl->local_peer_sock = -1;
 						cef_log_write (CefC_Log_Info, "Close Local peer\n");
@@ -1147,6 +1259,7 @@ cef_dbg_write (CefC_Dbg_Finer, "i=%d, len=%d, last_len=%d\n",
 								hdl->peer_id_str[fds_index[i]],
 								hdl->peer_sv_str[fds_index[i]],
 								hdl->tcp_fds[fds_index[i]]);
+							csmgrd_plugin_send_queue_close (hdl->tcp_fds[fds_index[i]]);
 							close (hdl->tcp_fds[fds_index[i]]);
 							hdl->tcp_fds[fds_index[i]] = -1;
 							hdl->peer_num--;
@@ -1154,14 +1267,7 @@ cef_dbg_write (CefC_Dbg_Finer, "i=%d, len=%d, last_len=%d\n",
 						/* Reset buffer */
 						hdl->tcp_index[fds_index[i]] = 0;
 					}
-					if (hdl->th_fds[fds_index[i]] != -1) {
-#ifdef CefC_Debug
-						cef_dbg_write (CefC_Dbg_Fine, "close sock:%d\n",
-							hdl->th_fds[fds_index[i]]);
-#endif // CefC_Debug
-						close (hdl->th_fds[fds_index[i]]);
-						hdl->th_fds[fds_index[i]] = -1;
-					}
+					csmgrd_thread_sock_close (hdl, fds_index[i]);
 					hdl->snd_fds[fds_index[i]] = -1;
 				} else {
 #ifdef CefC_Debug
@@ -1174,6 +1280,7 @@ cef_dbg_write (CefC_Dbg_Fine, "errno=%d:%s\n", errno, strerror (errno));
 							/* Close Local socket */
 							cef_log_write (CefC_Log_Warn,
 								"Receive error (%d) . Close Local socket\n", errno);
+							csmgrd_plugin_send_queue_close (hdl->local_peer_sock);
 							close (hdl->local_peer_sock);
 							hdl->local_peer_sock = -1;
 							cef_log_write (CefC_Log_Info, "Close Local peer\n");
@@ -1187,6 +1294,7 @@ cef_dbg_write (CefC_Dbg_Fine, "errno=%d:%s\n", errno, strerror (errno));
 									hdl->peer_id_str[fds_index[i]],
 									hdl->peer_sv_str[fds_index[i]],
 									hdl->tcp_fds[fds_index[i]]);
+								csmgrd_plugin_send_queue_close (hdl->tcp_fds[fds_index[i]]);
 								close (hdl->tcp_fds[fds_index[i]]);
 								hdl->tcp_fds[fds_index[i]] = -1;
 								hdl->peer_num--;
@@ -1194,14 +1302,7 @@ cef_dbg_write (CefC_Dbg_Fine, "errno=%d:%s\n", errno, strerror (errno));
 							/* Reset buffer */
 							hdl->tcp_index[fds_index[i]] = 0;
 						}
-						if (hdl->th_fds[fds_index[i]] != -1) {
-#ifdef CefC_Debug
-							cef_dbg_write (CefC_Dbg_Fine, "close sock:%d\n",
-								hdl->th_fds[fds_index[i]]);
-#endif // CefC_Debug
-							close (hdl->th_fds[fds_index[i]]);
-							hdl->th_fds[fds_index[i]] = -1;
-						}
+						csmgrd_thread_sock_close (hdl, fds_index[i]);
 						hdl->snd_fds[fds_index[i]] = -1;
 					}
 				}
@@ -1612,9 +1713,11 @@ csmgrd_local_sock_check (
 			}
 		}
 		if (hdl->local_peer_sock != -1) {
+			csmgrd_plugin_send_queue_close (hdl->local_peer_sock);
 			close (hdl->local_peer_sock);
 		}
 		hdl->local_peer_sock = sock;
+		csmgrd_epoll_sock_add (hdl, sock, 0);
 	}
 
 	return;
@@ -1645,22 +1748,26 @@ csmgrd_handle_destroy (
 		hdl->local_listen_fd = -1;
 	}
 	if (hdl->local_peer_sock != -1) {
+		csmgrd_plugin_send_queue_close (hdl->local_peer_sock);
 		close (hdl->local_peer_sock);
 		hdl->local_peer_sock = -1;
 	}
+	if (hdl->epoll_fd != -1) {
+		close (hdl->epoll_fd);
+		hdl->epoll_fd = -1;
+	}
 
 	/* Close Tcp listen socket */
 	if (hdl->tcp_listen_fd != -1) {
 
 		for (i = 1 ; i < CsmgrdC_Max_Sock_Num ; i++) {
 			if (hdl->tcp_fds[i] > 0) {
+				csmgrd_plugin_send_queue_close (hdl->tcp_fds[i]);
 				close (hdl->tcp_fds[i]);
 			}
 		}
 		for (i = 0 ; i < CsmgrdC_Max_Sock_Num ; i++) {
-			if (hdl->th_fds[i] > 0) {
-				close (hdl->th_fds[i]);
-			}
+			csmgrd_thread_sock_close (hdl, i);
 		}
 		close (hdl->tcp_listen_fd);
 #ifdef CefC_Debug
@@ -1789,6 +1896,7 @@ csmgrd_config_read (
 	strcpy (conf_param->fsc_cache_path, csmgr_conf_dir);
 	conf_param->port_num 	= CefC_Default_Tcp_Prot;
 	strcpy (conf_param->local_sock_id, "0");
+	conf_param->worker_num	= CsmgrdC_Worker_Default;
 
 	/* get parameter */
 	while (fgets (param_buff, sizeof (param_buff), fp) != NULL) {
@@ -1837,6 +1945,8 @@ csmgrd_config_read (
 			if (!(strcmp (conf_param->cs_mod_name, "filesystem") == 0
 				    ||
 				  strcmp (conf_param->cs_mod_name, "memory") == 0
+				    ||
+				  strcmp (conf_param->cs_mod_name, "tiered") == 0
 			     )) {
 				cef_log_write (CefC_Log_Error,
 					"EXCACHE_PLUGIN (Invalid value CACHE_TYPE=%s)\n", conf_param->cs_mod_name);
@@ -1870,12 +1980,23 @@ csmgrd_config_read (
 				return (-1);
 			}
 			strcpy (conf_param->local_sock_id, value);
+		} else if (strcmp (option, "LOOKUP_WORKER_NUM") == 0) {
+			res = csmgrd_config_value_get (option, value);
+			if ((res < 1) || (res > CsmgrdC_Worker_Max)) {
+				cef_log_write (CefC_Log_Error,
+					"LOOKUP_WORKER_NUM must be higher than 0 and lower than %d.\n",
+					CsmgrdC_Worker_Max + 1);
+				fclose (fp);
+				return (-1);
+			}
+			conf_param->worker_num = res;
 		} else {
 			continue;
 		}
 	}
 
-	if (strcmp (conf_param->cs_mod_name, "filesystem") == 0) {
+	if ((strcmp (conf_param->cs_mod_name, "filesystem") == 0) ||
+		(strcmp (conf_param->cs_mod_name, "tiered") == 0)) {
 		if (!(    access (conf_param->fsc_cache_path, F_OK) == 0
 			   && access (conf_param->fsc_cache_path, R_OK) == 0
 	   		   && access (conf_param->fsc_cache_path, W_OK) == 0
@@ -2217,6 +2338,7 @@ csmgrd_tcp_connect_accept (
 			if (hdl->tcp_fds[i] != -1) {
 				cef_log_write (CefC_Log_Info, "Close TCP peer: [%d] %s:%s, socket : %d\n",
 					i, hdl->peer_id_str[i], hdl->peer_sv_str[i], hdl->tcp_fds[i]);
+				csmgrd_plugin_send_queue_close (hdl->tcp_fds[i]);
 				close (hdl->tcp_fds[i]);
 				hdl->tcp_fds[i] 	= -1;
 				hdl->tcp_index[i] 	= 0;
@@ -2239,8 +2361,9 @@ csmgrd_tcp_connect_accept (
 			hdl->peer_num++;
 			hdl->tcp_fds[i] 	= cs;
 			hdl->tcp_index[i] 	= 0;
+			csmgrd_epoll_sock_add (hdl, cs, i);
 
-			cef_csmgr_send_msg (hdl->tcp_fds[i],
+			csmgrd_plugin_msg_send (hdl->tcp_fds[i],
 				(unsigned char*) CefC_Csmgr_Cmd_ConnOK, strlen (CefC_Csmgr_Cmd_ConnOK));
 		} else {
 			cef_log_write (CefC_Log_Warn,
@@ -2253,8 +2376,9 @@ csmgrd_tcp_connect_accept (
 		hdl->peer_num++;
 		hdl->tcp_fds[i] 	= cs;
 		hdl->tcp_index[i] 	= 0;
+		csmgrd_epoll_sock_add (hdl, cs, i);
 
-		cef_csmgr_send_msg (hdl->tcp_fds[i],
+		csmgrd_plugin_msg_send (hdl->tcp_fds[i],
 			(unsigned char*) CefC_Csmgr_Cmd_ConnOK, strlen (CefC_Csmgr_Cmd_ConnOK));
 	}
 	return;
@@ -2317,6 +2441,13 @@ csmgrd_input_message_process (
 			csmgrd_incoming_interest (hdl, sock, msg, msg_len, type);
 			break;
 		}
+		case CefC_Csmgr_Msg_Type_BulkInterest: {
+#ifdef CefC_Debug
+			cef_dbg_write (CefC_Dbg_Finest, "Receive the Bulk Interest Message\n");
+#endif // CefC_Debug
+			csmgrd_incoming_bulk_interest (hdl, sock, msg, msg_len);
+			break;
+		}
 
 		case CefC_Csmgr_Msg_Type_Ccninfo: {
 #ifdef CefC_Debug
@@ -2348,6 +2479,14 @@ csmgrd_input_message_process (
 			csmgrd_incoming_increment_msg (hdl, msg, msg_len);
 			break;
 		}
+		case CefC_Csmgr_Msg_Type_Bulk_Increment: {
+#ifdef CefC_Debug
+			cef_dbg_write (CefC_Dbg_Finest,
+				"Receive the Bulk Increment Access Count Message\n");
+#endif // CefC_Debug
+			csmgrd_incoming_bulk_increment_msg (hdl, msg, msg_len);
+			break;
+		}
 		case CefC_Csmgr_Msg_Type_Echo: {
 #ifdef CefC_Debug
 			cef_dbg_write (CefC_Dbg_Finest, "Receive the Echo Message\n");
@@ -2397,7 +2536,7 @@ csmgrd_input_message_process (
 /*--------------------------------------------------------------------------------------
 	Incoming Interest Message
 ----------------------------------------------------------------------------------------*/
-static void
+static int							/* CefC_Csmgr_Cob_Exist if the Cob has been sent	*/
 csmgrd_incoming_interest (
 	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
 	int sock,									/* recv socket							*/
@@ -2418,6 +2557,7 @@ csmgrd_incoming_interest (
 	uint16_t csact_len = 0;
 	unsigned char* signature_val = NULL;
 	uint16_t signature_len = 0;
+	int exist_f = CefC_Csmgr_Cob_NotExist;
 
 	/* Parses the csmgr Interest message */
 	res = cef_csmgr_interest_msg_parse (
@@ -2428,7 +2568,7 @@ csmgrd_incoming_interest (
 #ifdef CefC_Debug
 		cef_dbg_write (CefC_Dbg_Fine, "Parse message error (interest)\n");
 #endif // CefC_Debug
-		return;
+		return (exist_f);
 	}
 
 	/* Checks Interest Type */
@@ -2440,8 +2580,8 @@ csmgrd_incoming_interest (
 			csmgrd_stat_request_count_update (stat_hdl, name, name_len);
 
 			/* Searches and sends a Cob */
-			hdl->cs_mod_int->cache_item_get (name, name_len, chunk_num, sock, ver, ver_len,
-				csact_val, csact_len, signature_val, signature_len);
+			exist_f = hdl->cs_mod_int->cache_item_get (name, name_len, chunk_num, sock,
+				ver, ver_len, csact_val, csact_len, signature_val, signature_len);
 			break;
 		}
 		default: {
@@ -2452,6 +2592,81 @@ csmgrd_incoming_interest (
 	free(csact_val);
 	free(signature_val);
 
+	return (exist_f);
+}
+/*--------------------------------------------------------------------------------------
+	Incoming Bulk Interest Message
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_incoming_bulk_interest (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int sock,									/* recv socket							*/
+	unsigned char* buff,						/* receive message						*/
+	int buff_len								/* receive message length				*/
+) {
+	unsigned char* rsp;
+	unsigned char* bitmap;
+	uint16_t num;
+	uint16_t len;
+	uint16_t value16;
+	uint16_t rsp_len;
+	int index = 0;
+	int i;
+
+	/* Obtains the number of Interests 		*/
+	if (buff_len < CefC_S_Length) {
+		return;
+	}
+	memcpy (&value16, buff, CefC_S_Length);
+	num = ntohs (value16);
+	index += CefC_S_Length;
+	if ((num == 0) || (num > CefC_Csmgr_Bulk_Interest_Max)) {
+#ifdef CefC_Debug
+		cef_dbg_write (CefC_Dbg_Fine, "Parse message error (bulk interest)\n");
+#endif // CefC_Debug
+		return;
+	}
+
+	/* Creates the Bulk_Cob message sent after the found Cobs 	*/
+	rsp_len = CefC_Csmgr_Msg_HeaderLen + CefC_S_Length + (num + 7) / 8;
+	rsp = (unsigned char*) calloc (1, rsp_len);
+	if (rsp == NULL) {
+		cef_log_write (CefC_Log_Error, "%s (calloc Bulk_Cob)\n", __func__);
+		return;
+	}
+	rsp[CefC_O_Fix_Ver]  = CefC_Version;
+	rsp[CefC_O_Fix_Type] = CefC_Csmgr_Msg_Type_Bulk_Cob;
+	value16 = htons (rsp_len);
+	memcpy (&rsp[CefC_O_Fix_PacketLength], &value16, CefC_S_Length);
+	value16 = htons (num);
+	memcpy (&rsp[CefC_Csmgr_Msg_HeaderLen], &value16, CefC_S_Length);
+	bitmap = &rsp[CefC_Csmgr_Msg_HeaderLen + CefC_S_Length];
+
+	/* Searches the Cobs, they are written together when the hold is released 	*/
+	csmgrd_plugin_send_queue_hold (sock, 1);
+	for (i = 0 ; i < num ; i++) {
+		if (index + CefC_S_Length > buff_len) {
+			break;
+		}
+		memcpy (&value16, buff + index, CefC_S_Length);
+		len = ntohs (value16);
+		index += CefC_S_Length;
+		if (index + len > buff_len) {
+			break;
+		}
+		if (csmgrd_incoming_interest (hdl, sock, buff + index, len,
+				CefC_Csmgr_Msg_Type_Interest) != CefC_Csmgr_Cob_Exist) {
+			bitmap[i / 8] |= (unsigned char)(1 << (i % 8));
+		}
+		index += len;
+	}
+	for ( ; i < num ; i++) {
+		/* The rest of the message is broken 	*/
+		bitmap[i / 8] |= (unsigned char)(1 << (i % 8));
+	}
+	csmgrd_plugin_cob_msg_enqueue (sock, rsp, rsp_len, free, rsp);
+	csmgrd_plugin_send_queue_hold (sock, 0);
+
 	return;
 }
 /*--------------------------------------------------------------------------------------
@@ -2600,7 +2815,6 @@ csmgrd_incoming_status_msg (
 	struct CefT_Csmgr_Status_Hdr stat_hdr;
 	struct CefT_Csmgr_Status_Rep stat_rep;
 	uint32_t value32;
-	struct pollfd fds[1];
 	uint32_t 		con_num = 0;
 	uint8_t option_f = CefC_Csmgr_Stat_Opt_None;
 
@@ -2727,65 +2941,24 @@ csmgrd_incoming_status_msg (
 SKIP_RESPONSE:;
 	stat_hdr.node_num = peer_num;
 	stat_hdr.con_num  = htonl (con_num);
+	stat_hdr.cached_bytes	= cef_client_htonb (csmgrd_stat_cached_bytes_get (stat_hdl));
+	stat_hdr.capacity_bytes	= cef_client_htonb (csmgrd_stat_cache_capacity_bytes_get (stat_hdl));
 	memcpy (&wbuf[CefC_Csmgr_Msg_HeaderLen+2/* To extend length from 2 bytes to 4 bytes */], &stat_hdr, sizeof (struct CefT_Csmgr_Status_Hdr));
 
 	value32 = htonl (index);
 	memcpy (&wbuf[CefC_O_Fix_PacketLength], &value32, sizeof (value32));
 
-	{
-		int	fblocks;
-		int rem_size;
-		int counter;
-		fblocks = index / CefC_Csmgr_Stat_Mtu;
-		rem_size = index % CefC_Csmgr_Stat_Mtu;
-		int flag;
-		flag = fcntl (sock, F_GETFL, 0);
-		fcntl (sock, F_SETFL, flag & ~O_NONBLOCK);
-		for (counter=0; counter<fblocks; counter++) {
-			/* Send message 		*/
-			fds[0].fd = sock;
-			fds[0].events = POLLOUT | POLLERR;
-			res = poll (fds, 1, 1000);
-			if (res < 1) {
-#ifdef CefC_Debug
-		cef_dbg_write (CefC_Dbg_Fine, "Failed to poll (response status message).\n");
-#endif // CefC_Debug
-				free (wbuf);
-				return;
-			}
-#ifdef CefC_Debug
-			cef_dbg_write (CefC_Dbg_Fine, "Send status response(len = %u).\n", CefC_Csmgr_Stat_Mtu);
-#endif // CefC_Debug
-			res = cef_csmgr_send_msg (sock, &wbuf[counter*CefC_Csmgr_Stat_Mtu], CefC_Csmgr_Stat_Mtu);
-#ifdef CefC_Debug
-			if (res < 0) {
-				cef_dbg_write (CefC_Dbg_Fine, "Failed to send response message(status).\n");
-			}
-#endif // CefC_Debug
-		}
-		if (rem_size != 0) {
-			/* Send message 		*/
-			fds[0].fd = sock;
-			fds[0].events = POLLOUT | POLLERR;
-			res = poll (fds, 1, 1000);
-			if (res < 1) {
+	/* The response is queued as one message, so that no Cob is written 	*/
+	/* between its parts 													*/
 #ifdef CefC_Debug
-		cef_dbg_write (CefC_Dbg_Fine, "Failed to poll (response status message).\n");
+	cef_dbg_write (CefC_Dbg_Fine, "Send status response(len = %u).\n", index);
 #endif // CefC_Debug
-				free (wbuf);
-				return;
-			}
+	res = csmgrd_plugin_msg_send (sock, wbuf, index);
 #ifdef CefC_Debug
-			cef_dbg_write (CefC_Dbg_Fine, "Send status response(len = %u).\n", rem_size);
-#endif // CefC_Debug
-			res = cef_csmgr_send_msg (sock, &wbuf[fblocks*CefC_Csmgr_Stat_Mtu], rem_size);
-#ifdef CefC_Debug
-			if (res < 0) {
-				cef_dbg_write (CefC_Dbg_Fine, "Failed to send response message(status).\n");
-			}
-#endif // CefC_Debug
-		}
+	if (res < 0) {
+		cef_dbg_write (CefC_Dbg_Fine, "Failed to send response message(status).\n");
 	}
+#endif // CefC_Debug
 
 	free (wbuf);
 
@@ -2831,12 +3004,8 @@ csmgrd_incoming_ccninfo_msg (
 		/* Queries without a chunk number(ExactMatch) */
 		stat[0] = csmgrd_stat_content_info_get (stat_hdl, key, tmp_klen);	//0.8.3c
 		if (stat[0]) {
-			uint64_t mask = 1;
-			uint32_t x;
-			x = seqno / 64;
-			mask <<= (seqno % 64);
 			/* There is a corresponding chunk number */
-			if ((stat[0]->map_max-1) >= x && stat[0]->cob_map[x] & mask) {
+			if (csmgrd_stat_cob_is_cached (stat_hdl, key, tmp_klen, seqno)) {
 				rec_index = index;
 				index += CefC_S_TLF;
 				{
@@ -2963,7 +3132,7 @@ csmgrd_incoming_ccninfo_msg (
 		cef_dbg_write (CefC_Dbg_Fine, "Send the ccninfo response (len = %u).\n", index);
 		cef_dbg_buff_write (CefC_Dbg_Finest, msg, index);
 #endif // CefC_Debug
-		res = cef_csmgr_send_msg (sock, msg, index);
+		res = csmgrd_plugin_msg_send (sock, msg, index);
 		if (res < 0) {
 			/* send error */
 #ifdef CefC_Debug
@@ -2971,7 +3140,7 @@ csmgrd_incoming_ccninfo_msg (
 #endif // CefC_Debug
 		}
 	} else {
-		cef_csmgr_send_msg (sock, msg, CefC_S_TLF);
+		csmgrd_plugin_msg_send (sock, msg, CefC_S_TLF);
 	}
 
 	return;
@@ -3039,7 +3208,7 @@ csmgrd_pre_ccninfo_response_send (
 	cef_dbg_buff_write (CefC_Dbg_Finest, buff, index);
 #endif // CefC_Debug
 	/* Send a response to source node */
-	res = cef_csmgr_send_msg (sock, buff, index);
+	res = csmgrd_plugin_msg_send (sock, buff, index);
 
 	if (res < 0) {
 #ifdef CefC_Debug
@@ -3104,6 +3273,112 @@ csmgrd_incoming_increment_msg (
 
 	return;
 }
+/*--------------------------------------------------------------------------------------
+	Receive Bulk Increment Access Count message
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_incoming_bulk_increment_msg (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	unsigned char* buff,						/* receive message						*/
+	int buff_len								/* receive message length				*/
+) {
+	CsmgrdT_Access_Count acs[CefC_Csmgr_Bulk_Increment_Max];
+	unsigned char key[CefC_Max_Msg_Size];
+	struct value32_tlv* tlv32_hdp;
+	uint16_t value16;
+	uint32_t value32;
+	uint32_t chunk_num;
+	uint32_t hits = 0;
+	int index = 0;
+	int num;
+	int i;
+
+	if ((hdl->cs_mod_int->ac_cnt_inc == NULL) &&
+		(hdl->cs_mod_int->ac_cnt_inc_bulk == NULL)) {
+#ifdef CefC_Debug
+		cef_dbg_write (
+			CefC_Dbg_Finest, "Cache plugin has no function(increment access count).\n");
+#endif // CefC_Debug
+		return;
+	}
+
+	if (buff_len < CefC_S_Length) {
+		return;
+	}
+	memcpy (&value16, buff, CefC_S_Length);
+	num = ntohs (value16);
+	index += CefC_S_Length;
+	if ((num == 0) || (num > CefC_Csmgr_Bulk_Increment_Max)) {
+#ifdef CefC_Debug
+		cef_dbg_write (CefC_Dbg_Fine,
+			"Parse error (bulk increment access count message)\n");
+#endif // CefC_Debug
+		return;
+	}
+
+	/* Obtains the records, every chunk in a range was hit at least once 	*/
+	for (i = 0 ; i < num ; i++) {
+		if (index + CefC_S_Length > buff_len) {
+			break;
+		}
+		memcpy (&value16, &buff[index], CefC_S_Length);
+		acs[i].name_len = ntohs (value16);
+		index += CefC_S_Length;
+		if ((acs[i].name_len == 0) ||
+			(acs[i].name_len + sizeof (struct value32_tlv) > CefC_Max_Msg_Size) ||
+			(index + acs[i].name_len + sizeof (uint32_t) * 3 > buff_len)) {
+			break;
+		}
+		acs[i].name = &buff[index];
+		index += acs[i].name_len;
+		memcpy (&value32, &buff[index], sizeof (uint32_t));
+		acs[i].first = ntohl (value32);
+		memcpy (&value32, &buff[index + sizeof (uint32_t)], sizeof (uint32_t));
+		acs[i].last  = ntohl (value32);
+		memcpy (&value32, &buff[index + sizeof (uint32_t) * 2], sizeof (uint32_t));
+		acs[i].count = ntohl (value32);
+		index += sizeof (uint32_t) * 3;
+		/* cefnetd sends the message when the hits reach 					*/
+		/* CefC_Csmgr_Bulk_Increment_Hits, so a range or a message which 	*/
+		/* has more hits is invalid and is dropped before taking the locks	*/
+		if ((acs[i].last < acs[i].first) || (acs[i].last - acs[i].first >= acs[i].count) ||
+			(acs[i].count > CefC_Csmgr_Bulk_Increment_Hits - hits)) {
+			break;
+		}
+		hits += acs[i].count;
+	}
+	if (i < num) {
+#ifdef CefC_Debug
+		cef_dbg_write (CefC_Dbg_Fine,
+			"Parse error (bulk increment access count message)\n");
+#endif // CefC_Debug
+		return;
+	}
+
+	/* Increment access counts */
+	if (hdl->cs_mod_int->ac_cnt_inc_bulk) {
+		hdl->cs_mod_int->ac_cnt_inc_bulk (acs, num);
+		return;
+	}
+
+	/* Passes the name with the chunk number as cefnetd did 	*/
+	for (i = 0 ; i < num ; i++) {
+		memcpy (key, acs[i].name, acs[i].name_len);
+		tlv32_hdp = (struct value32_tlv*) &key[acs[i].name_len];
+		tlv32_hdp->type   = htons (CefC_T_CHUNK);
+		tlv32_hdp->length = htons (sizeof (uint32_t));
+		for (chunk_num = acs[i].first ; ; chunk_num++) {
+			tlv32_hdp->value = htonl (chunk_num);
+			hdl->cs_mod_int->ac_cnt_inc (
+				key, acs[i].name_len + sizeof (struct value32_tlv), chunk_num);
+			if (chunk_num == acs[i].last) {
+				break;
+			}
+		}
+	}
+
+	return;
+}
 /*--------------------------------------------------------------------------------------
 	Receive Echo message
 ----------------------------------------------------------------------------------------*/
@@ -3136,7 +3411,7 @@ csmgrd_incoming_echo_msg (
 	cef_dbg_buff_write (CefC_Dbg_Finest, ret_buff, index);
 #endif // CefC_Debug
 	/* Send response */
-	cef_csmgr_send_msg (sock, ret_buff, index);
+	csmgrd_plugin_msg_send (sock, ret_buff, index);
 	return;
 }
 /*--------------------------------------------------------------------------------------
@@ -3591,7 +3866,8 @@ csmgrd_resource_mon_thread (
 
 	if (strcmp (hdl->cs_mod_name, "memory") == 0) {
 		cs_type = 'M';
-	} else if (strcmp (hdl->cs_mod_name, "filesystem") == 0) {
+	} else if ((strcmp (hdl->cs_mod_name, "filesystem") == 0) ||
+			   (strcmp (hdl->cs_mod_name, "tiered") == 0)) {
 		cs_type = 'F';
 	} else {
 		cs_type = 'M';
@@ -3653,7 +3929,9 @@ csmgrd_resource_mon_thread (
 			}
 //@@@fprintf(stderr, "[%s(%d)]: ===== Lack_of_M_resources = %d ======\n", __FUNCTION__, __LINE__, Lack_of_M_resources);
 		}
-		else if (strcmp (hdl->cs_mod_name, "filesystem") == 0) {
+		else if ((strcmp (hdl->cs_mod_name, "filesystem") == 0) ||
+				 (strcmp (hdl->cs_mod_name, "tiered") == 0)) {
+			/* The tiered cache also has the disk tier 	*/
 			if (max_cob_limit == 0) {
 				if (m_used > CSMGR_MAXIMUM_MEM_USAGE_FOR_FILE) {
 					Lack_of_M_resources = 1;
@@ -3929,9 +4207,8 @@ csmgrd_incoming_continfo_msg(
 	CsmgrT_Stat*		rcd = NULL;
 	uint16_t			range_len;
 	unsigned char		range[1024] = {0};
-	int					s_val, e_val, val, sidx, eidx, i, n, st, ed;
-	uint64_t			mask;
-	int					find_f = 0;
+	int					s_val, e_val;
+	uint32_t			from, first, last;
 	char				info[CefC_Max_Length] = {0};
 	int					info_rem_size = sizeof (info) - 1; /* -1 for EOS */
 	char				tmp_str[32] = {0};
@@ -4007,71 +4284,38 @@ csmgrd_incoming_continfo_msg(
 	} else if (s_val < rcd->min_seq) {
 		s_val = rcd->min_seq;
 	}
-	sidx = s_val / 64;
 	if (e_val < rcd->min_seq) {
 		e_val = rcd->min_seq;
 	} else if (e_val > rcd->max_seq) {
 		e_val = rcd->max_seq;
 	}
-	eidx = (e_val / 64) + 1;
-
-	/* Set start position */
-	st = ed = s_val;
-
-	/* Check */
-	for (i = sidx; i < eidx; i++) {
-		if ((rcd->map_max-1) >= i /*&& rcd->cob_map[i]*/) {
-			mask = 0x0000000000000001;
-			for (n = 0 ; n < 64 ; n++) {
-				val = i * 64 + n;
-				if (rcd->cob_map[i] & mask &&
-					(s_val <= val && val <= e_val)) {
-					if (find_f == 0) {
-						find_f = 1;
-						st = val;
-						sprintf (tmp_str, "%d", st);
-						len = strlen ((char*)tmp_str);
-						info_rem_size -= (int)len;
-						if (info_rem_size < 0) {
-							goto OUT_COBMAPCHECK_LOOP;
-						}
-						memcpy (wp, tmp_str, len);
-						wp = wp + len;
-					}
-				} else {
-					if (find_f == 1) {
-						find_f = 0;
-						ed = val - 1;
-						if (st < ed)
-							sprintf (tmp_str, ":%d,", ed);
-						else
-							sprintf (tmp_str, ",");
-						len = strlen ((char*)tmp_str);
-						info_rem_size -= (int)len;
-						if (info_rem_size < 0) {
-							goto OUT_COBMAPCHECK_LOOP;
-						}
-						memcpy (wp, tmp_str, len);
-						wp = wp + len;
-					}
-					if (val > e_val)
-						goto OUT_COBMAPCHECK_LOOP;
-				}
-				mask <<= 1;
-			}
+
+	/* Lists the ranges of the cached Cobs 	*/
+	from = (uint32_t) s_val;
+	while ((from <= (uint32_t) e_val) &&
+		(csmgrd_stat_cob_range_get (stat_hdl, name, name_len, from, &first, &last))) {
+		if (first > (uint32_t) e_val) {
+			break;
+		}
+		if (last > (uint32_t) e_val) {
+			last = (uint32_t) e_val;
+		}
+		if (first < last) {
+			sprintf (tmp_str, "%u:%u,", first, last);
+		} else {
+			sprintf (tmp_str, "%u,", first);
 		}
-	}
-OUT_COBMAPCHECK_LOOP:;
-	if (find_f == 1) {
-		if (st < e_val)
-			sprintf (tmp_str, ":%d,", e_val);
-		else
-			sprintf (tmp_str, ",");
 		len = strlen ((char*)tmp_str);
 		info_rem_size -= (int)len;
-		if (info_rem_size >= 0) {
-			memcpy (wp, tmp_str, len);
+		if (info_rem_size < 0) {
+			break;
 		}
+		memcpy (wp, tmp_str, len);
+		wp = wp + len;
+		if (last == UINT32_MAX) {
+			break;
+		}
+		from = last + 1;
 	}
 	failed_f = 0;
 
@@ -4121,7 +4365,7 @@ RESPSEND:;
 	cef_dbg_buff_write (CefC_Dbg_Finest, snd_buff, index);
 #endif // CefC_Debug
 	/* Send a response to source node */
-	if (cef_csmgr_send_msg (sock, snd_buff, index) < 0) {
+	if (csmgrd_plugin_msg_send (sock, snd_buff, index) < 0) {
 #ifdef CefC_Debug
 		cef_dbg_write (CefC_Dbg_Fine,
 			"Failed to send the Contents Information response\n");
@@ -4147,6 +4391,7 @@ csmgrd_input_message_transfer_process (
 	CefT_Cs_Stat cs_stat = {0};
 	int con_sock;
 	int index;
+	int th_idx;
 	unsigned char* wk_msg = NULL;
 
 	switch (type) {
@@ -4165,35 +4410,38 @@ csmgrd_input_message_transfer_process (
 				return (res);
 			}
 			strcpy(cs_stat.local_sock_name, CSMGR_LOCAL_SOCK_NAME_STATUS_THREAD);
+			th_idx = CsmgrdC_Th_Status_Idx;
 			break;
 		}
 		default: {
+			th_idx = csmgrd_worker_select (hdl, msg, msg_len, type);
 #ifdef CefC_Debug
-			cef_dbg_write (CefC_Dbg_Finest, "Transfer others message to thread\n");
+			cef_dbg_write (CefC_Dbg_Finest,
+				"Transfer others message to thread (worker %d)\n", th_idx);
 #endif // CefC_Debug
-			strcpy(cs_stat.local_sock_name, CSMGR_LOCAL_SOCK_NAME_OTHER_THREAD);
+			strcpy(cs_stat.local_sock_name, csmgr_worker_sock_name[th_idx]);
 			break;
 		}
 	}
 
 	index = fds_index;
 	if (index >= 0) {
-		if (hdl->th_fds[index] < 0) {
+		if (hdl->th_fds[index][th_idx] < 0) {
 			con_sock = cef_csmgr_csmgr_connect_local (&cs_stat);
 			if (con_sock >= 0) {
 #ifdef CefC_Debug
 				cef_dbg_write (CefC_Dbg_Fine, "connect sock:%d\n", con_sock);
 #endif // CefC_Debug
-				hdl->th_fds[index] = con_sock;
+				hdl->th_fds[index][th_idx] = con_sock;
 				csmgrd_sockid_msg_send (hdl, con_sock, sock);
 			} else {
 				res = -1;
 			}
 		} else {
-			con_sock = hdl->th_fds[index];
+			con_sock = hdl->th_fds[index][th_idx];
 		}
 		if (con_sock >= 0) {
-			cef_csmgr_send_msg (con_sock, msg, msg_len);
+			csmgrd_plugin_msg_send (con_sock, msg, msg_len);
 		}
 	} else {
 		res = -1;
@@ -4237,6 +4485,7 @@ csmgrd_thread_local_sock_check (
 		if (index > -1) {
 			hdl->tcp_fds[index] 	= sock;
 			hdl->tcp_index[index] 	= 0;
+			csmgrd_epoll_sock_add (hdl, sock, index);
 			cef_log_write (CefC_Log_Info, "Open TCP peer: :, socket : %d\n", sock);
 		} else {
 			cef_log_write (CefC_Log_Warn,
@@ -4281,7 +4530,7 @@ csmgrd_sockid_msg_send (
 	cef_dbg_buff_write (CefC_Dbg_Finest, ret_buff, index);
 #endif // CefC_Debug
 	/* Send message */
-	cef_csmgr_send_msg (sock, ret_buff, index);
+	csmgrd_plugin_msg_send (sock, ret_buff, index);
 	return;
 }
 /*--------------------------------------------------------------------------------------
@@ -4352,3 +4601,192 @@ csmgrd_status_msg_set_peernum (
 	return buff;
 }
 
+/*--------------------------------------------------------------------------------------
+	Selects the lookup worker which handles the message
+----------------------------------------------------------------------------------------*/
+static int							/* index of the lookup worker						*/
+csmgrd_worker_select (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	unsigned char* msg,							/* receive message						*/
+	int msg_len,								/* message length						*/
+	uint8_t type								/* message type							*/
+) {
+	unsigned char* name;
+	uint16_t name_len;
+	uint16_t value16;
+	uint16_t tlv_type;
+	uint16_t tlv_len;
+	uint32_t hash = 2166136261U;
+	int index;
+	int i;
+
+	if (hdl->worker_num < 2) {
+		return (0);
+	}
+
+	/* Obtains the Interest, the Bulk Interest is handled by one worker for 		*/
+	/* its Bulk_Cob message, so the first Interest decides the worker 			*/
+	index = CefC_Csmgr_Msg_HeaderLen;
+	if (type == CefC_Csmgr_Msg_Type_BulkInterest) {
+		index += CefC_S_Length * 2;
+	} else if (type != CefC_Csmgr_Msg_Type_Interest) {
+		return (0);
+	}
+
+	/* Skips the Interest type and the chunk num flag 	*/
+	index += sizeof (uint8_t) * 2;
+	if (index + CefC_S_Length > msg_len) {
+		return (0);
+	}
+	memcpy (&value16, &msg[index], CefC_S_Length);
+	name_len = ntohs (value16);
+	index += CefC_S_Length;
+	if (index + name_len > msg_len) {
+		return (0);
+	}
+	name = &msg[index];
+
+	/* Hashes the name without the chunk number, so that all Cobs of a content 	*/
+	/* are searched by the same worker 											*/
+	index = 0;
+	while (index + CefC_S_TLF <= name_len) {
+		memcpy (&value16, &name[index], CefC_S_Length);
+		tlv_type = ntohs (value16);
+		memcpy (&value16, &name[index + CefC_S_Length], CefC_S_Length);
+		tlv_len = ntohs (value16);
+		if ((tlv_type == CefC_T_CHUNK) ||
+			(index + CefC_S_TLF + tlv_len > name_len)) {
+			break;
+		}
+		for (i = 0 ; i < CefC_S_TLF + tlv_len ; i++) {
+			hash ^= name[index + i];
+			hash *= 16777619U;
+		}
+		index += CefC_S_TLF + tlv_len;
+	}
+
+	return ((int)(hash % hdl->worker_num));
+}
+/*--------------------------------------------------------------------------------------
+	Closes the sockets to the threads which are opened for the peer
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_thread_sock_close (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int index									/* index of the peer					*/
+) {
+	int i;
+
+	for (i = 0 ; i <= CsmgrdC_Worker_Max ; i++) {
+		if (hdl->th_fds[index][i] != -1) {
+#ifdef CefC_Debug
+			cef_dbg_write (CefC_Dbg_Fine, "close sock:%d\n", hdl->th_fds[index][i]);
+#endif // CefC_Debug
+			csmgrd_plugin_send_queue_close (hdl->th_fds[index][i]);
+			close (hdl->th_fds[index][i]);
+			hdl->th_fds[index][i] = -1;
+		}
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Creates the epoll instance and registers the listen sockets
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_epoll_create (
+	CefT_Csmgrd_Handle* hdl						/* csmgr daemon handle					*/
+) {
+#ifdef CsmgrdC_Epoll_Enable
+	hdl->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+	if (hdl->epoll_fd < 0) {
+		cef_log_write (CefC_Log_Warn,
+			"epoll_create1 failed (%s), the sockets are polled.\n", strerror (errno));
+		hdl->epoll_fd = -1;
+		return;
+	}
+	csmgrd_epoll_sock_add (hdl, hdl->tcp_listen_fd, CsmgrdC_Epoll_Listen_Id);
+	csmgrd_epoll_sock_add (hdl, hdl->local_listen_fd, CsmgrdC_Epoll_Listen_Id);
+#endif // CsmgrdC_Epoll_Enable
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Registers the socket to epoll
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_epoll_sock_add (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	int fd,										/* socket								*/
+	uint32_t index								/* index of the peer					*/
+) {
+#ifdef CsmgrdC_Epoll_Enable
+	struct epoll_event ev;
+
+	if ((hdl->epoll_fd == -1) || (fd < 0)) {
+		return;
+	}
+	/* The socket is removed from epoll when it is closed 	*/
+	memset (&ev, 0, sizeof (ev));
+	ev.events 	= EPOLLIN;
+	ev.data.u64 = ((uint64_t) index << 32) | (uint32_t) fd;
+	if (epoll_ctl (hdl->epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		cef_log_write (CefC_Log_Warn,
+			"epoll_ctl failed (%s), socket : %d\n", strerror (errno), fd);
+	}
+#endif // CsmgrdC_Epoll_Enable
+	return;
+}
+#ifdef CsmgrdC_Epoll_Enable
+/*--------------------------------------------------------------------------------------
+	Waits for the sockets registered to epoll
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+csmgrd_epoll_socket_wait (
+	CefT_Csmgrd_Handle* hdl,					/* csmgr daemon handle					*/
+	struct pollfd fds[],
+	int fds_index[],
+	int* accept_f								/* set if a listen socket is readable	*/
+) {
+	struct epoll_event evs[CsmgrdC_Max_Sock_Num + 2];
+	uint32_t index;
+	int fd;
+	int set_num = 0;
+	int res;
+	int i;
+
+	*accept_f = 0;
+	res = epoll_wait (hdl->epoll_fd, evs, CsmgrdC_Max_Sock_Num + 2, CsmgrdC_Epoll_Timeout);
+	if (res < 0) {
+		return (-1);
+	}
+
+	/* Sets the ready sockets in the same form as poll 	*/
+	for (i = 0 ; i < res ; i++) {
+		index = (uint32_t)(evs[i].data.u64 >> 32);
+		fd 	  = (int)(uint32_t) evs[i].data.u64;
+		if (index == CsmgrdC_Epoll_Listen_Id) {
+			*accept_f = 1;
+			continue;
+		}
+		if ((index >= CsmgrdC_Max_Sock_Num) ||
+			((fd != hdl->tcp_fds[index]) &&
+			 ((index != 0) || (fd != hdl->local_peer_sock)))) {
+			continue;
+		}
+		fds[set_num].fd 	 = fd;
+		fds[set_num].events  = POLLIN | POLLERR;
+		fds[set_num].revents = 0;
+		if (evs[i].events & EPOLLIN) {
+			fds[set_num].revents |= POLLIN;
+		}
+		if (evs[i].events & EPOLLERR) {
+			fds[set_num].revents |= POLLERR;
+		}
+		if (evs[i].events & EPOLLHUP) {
+			fds[set_num].revents |= POLLHUP;
+		}
+		fds_index[set_num] = (int) index;
+		set_num++;
+	}
+
+	return (set_num);
+}
+#endif // CsmgrdC_Epoll_Enable
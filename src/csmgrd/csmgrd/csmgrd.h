@@ -40,6 +40,9 @@
 #include <netdb.h>
 #include <poll.h>
 #include <sys/socket.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif // __linux__
 
 #include <cefore/cef_define.h>
 #include <cefore/cef_csmgr.h>
@@ -57,6 +60,22 @@
 #define CsmgrdC_Task_Main_Process	1					/* main process task			*/
 #define CsmgrdC_Task_Thread			2					/* thread task					*/
 
+/*------------------------------------------------------------------*/
+/* Macros for lookup workers										*/
+/*------------------------------------------------------------------*/
+#define CsmgrdC_Worker_Max			16					/* Max number of lookup workers	*/
+#define CsmgrdC_Worker_Default		1					/* LOOKUP_WORKER_NUM default	*/
+#define CsmgrdC_Th_Status_Idx		CsmgrdC_Worker_Max	/* th_fds index of status thread*/
+
+/*------------------------------------------------------------------*/
+/* Macros for epoll													*/
+/*------------------------------------------------------------------*/
+#ifdef __linux__
+#define CsmgrdC_Epoll_Enable
+#endif // __linux__
+#define CsmgrdC_Epoll_Timeout		100					/* epoll_wait timeout (ms)		*/
+#define CsmgrdC_Epoll_Listen_Id		0xFFFFFFFF			/* index of the listen sockets	*/
+
 /* Library name				*/
 #ifdef __APPLE__
 #define CsmgrdC_Plugin_Library_Name	"libcsmgrd_plugin.dylib"
@@ -77,6 +96,7 @@ typedef struct {
 	char			fsc_cache_path[CefC_Csmgr_File_Path_Length]; /* FSC cache path		*/
 	uint16_t 		port_num;					/* PORT_NUM in csmgrd.conf 				*/
 	char 			local_sock_id[CefC_LOCAL_SOCK_ID_SIZ+1];
+	uint16_t 		worker_num;					/* LOOKUP_WORKER_NUM in csmgrd.conf 	*/
 
 } CsmgrT_Config_Param;
 
@@ -106,7 +126,9 @@ typedef struct {
 	int 				tcp_fds[CsmgrdC_Max_Sock_Num];
 	int 				tcp_index[CsmgrdC_Max_Sock_Num];
 	unsigned char* 		tcp_buff[CsmgrdC_Max_Sock_Num];
-	int 				th_fds[CsmgrdC_Max_Sock_Num];
+	int 				th_fds[CsmgrdC_Max_Sock_Num][CsmgrdC_Worker_Max + 1];
+												/* sockets to the lookup workers and 	*/
+												/* the status thread per peer 			*/
 	int 				snd_fds[CsmgrdC_Max_Sock_Num];
 	char				peer_id_str[CsmgrdC_Max_Sock_Num][NI_MAXHOST];
 	char				peer_sv_str[CsmgrdC_Max_Sock_Num][NI_MAXSERV];
@@ -117,6 +139,10 @@ typedef struct {
 	char 				local_sock_name[1024];
 	int					local_peer_sock;
 
+	/********** Event loop				***********/
+	int 				epoll_fd;				/* -1 if the sockets are polled 		*/
+	uint16_t 			worker_num;				/* number of lookup workers 			*/
+
 	/********** load functions			***********/
 	CsmgrdT_Plugin_Interface* cs_mod_int;		/* plugin interface						*/
 	char			cs_mod_name[CsmgrdC_Max_Plugin_Name_Len];
@@ -59,6 +59,11 @@
 #define CsmgrC_Buff_Max 				100000000
 #define CsmgrC_Buff_Num 				65536
 
+#define CsmgrdC_Send_Queue_Fd_Max 		1024		/* sockets which use an output queue	*/
+#define CsmgrdC_Send_Queue_Size 		4096		/* messages kept in an output queue		*/
+#define CsmgrdC_Send_Iov_Max 			64			/* messages written by one sendmsg		*/
+#define CsmgrdC_Send_Poll_Timeout 		100			/* poll timeout of output thread (ms)	*/
+
 #define CsmgrC_UCINC_Extend_Lifetime 	100000llu
 
 /****************************************************************************************
@@ -83,6 +88,24 @@ typedef struct {
 	uint16_t		ver_len;					/* Length of version					*/
 } CsmgrdT_Content_Entry;
 
+/***** state information reported by Status API of cache algorithm library 	*****/
+typedef struct {
+	uint64_t		cache_cobs;					/* number of listed entries				*/
+	uint64_t		cache_bytes;				/* total of msg_len of listed entries	*/
+	uint64_t		capacity_bytes;				/* byte budget (0 means unlimited)		*/
+	uint64_t		hit_count;					/* number of hits notified by Hit API	*/
+	uint64_t		miss_count;					/* number of misses notified by Miss API*/
+} CsmgrdT_Lib_Status;
+
+/***** hits of a range of chunks notified by the Bulk Increment message 	*****/
+typedef struct {
+	unsigned char*	name;						/* Content name without chunk number	*/
+	uint16_t		name_len;					/* Content name length					*/
+	uint32_t		first;						/* first chunk number of the range		*/
+	uint32_t		last;						/* last chunk number of the range		*/
+	uint32_t		count;						/* number of hits in the range			*/
+} CsmgrdT_Access_Count;
+
 typedef struct CsmgrdT_Plugin_Interface {
 	/* Initialize process */
 	int (*init)(CsmgrT_Stat_Handle, int);		//0.8.3c
@@ -104,6 +127,10 @@ typedef struct CsmgrdT_Plugin_Interface {
 	/* Increment access count */
 	void (*ac_cnt_inc)(unsigned char*, uint16_t, uint32_t);
 
+	/* Increment access counts of the ranges of chunks at once (optional)	*/
+	/* csmgrd calls ac_cnt_inc for each chunk if the plugin does not set it	*/
+	void (*ac_cnt_inc_bulk)(CsmgrdT_Access_Count*, int);
+
 	int (*content_lifetime_get) (unsigned char*, uint16_t, uint32_t*, uint32_t*, uint8_t);
 
 } CsmgrdT_Plugin_Interface;
@@ -157,6 +184,22 @@ typedef struct CsmgrdT_Lib_Interface {
 		void*
 	);
 
+	/* Byte budget API (optional)	*/
+	int
+	(*capacity_bytes_set) (
+		uint64_t
+	);
+
+	/* Reference bit API (optional)	*/
+	/* When the library registers the test-and-clear function of the reference bit	*/
+	/* kept in the content entry of the cache plugin, the cache plugin sets the bit	*/
+	/* on a hit. The Hit API is still called to count the hit, and it must be safe	*/
+	/* without the lock of the cache plugin.										*/
+	int
+	(*reference_api_set) (
+		int (*)(unsigned char*, int)
+	);
+
 } CsmgrdT_Lib_Interface;
 
 /****************************************************************************************
@@ -180,12 +223,59 @@ typedef struct CsmgrdT_Lib_Interface {
 /*--------------------------------------------------------------------------------------
 	Function to Send Cob message
 ----------------------------------------------------------------------------------------*/
-int
+int									/* The return value is negative if an EBADF occurs	*/
 csmgrd_plugin_cob_msg_send (
 	int fd,									/* socket fd								*/
 	unsigned char* msg,						/* send message								*/
 	uint16_t msg_len						/* message length							*/
 );
+/*--------------------------------------------------------------------------------------
+	Sends the message through the output queue of the socket
+	(every write to a socket goes through its queue, so that the messages are never
+	interleaved with the rest of a message partially written)
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if an error occurs	*/
+csmgrd_plugin_msg_send (
+	int fd,									/* socket fd								*/
+	unsigned char* msg,						/* send message (copied)					*/
+	int msg_len								/* message length							*/
+);
+/*--------------------------------------------------------------------------------------
+	Queues Cob message to the output queue of the socket
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if an EBADF occurs	*/
+csmgrd_plugin_cob_msg_enqueue (
+	int fd,									/* socket fd								*/
+	unsigned char* msg,						/* send message (must be kept until release	*/
+											/* is called)								*/
+	uint16_t msg_len,						/* message length							*/
+	void (*release)(void*),					/* called when the message has been sent or	*/
+											/* dropped									*/
+	void* arg								/* argument of release						*/
+);
+/*--------------------------------------------------------------------------------------
+	Drops the messages queued to the socket which is closed
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_plugin_send_queue_close (
+	int fd									/* socket fd								*/
+);
+/*--------------------------------------------------------------------------------------
+	Holds the messages queued to the socket until it is released, so that they are
+	written together by one sendmsg
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_plugin_send_queue_hold (
+	int fd,									/* socket fd								*/
+	int hold_f								/* 1: holds, 0: releases and writes			*/
+);
+/*--------------------------------------------------------------------------------------
+	Stops the output thread and drops all queued messages
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_plugin_send_queue_destroy (
+	void
+);
 /*--------------------------------------------------------------------------------------
 	Sets APIs for cache algorithm library
 ----------------------------------------------------------------------------------------*/
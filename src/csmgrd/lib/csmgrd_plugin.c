@@ -45,6 +45,9 @@
 #include <stdio.h>
 #include <time.h>
 #include <limits.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
 #include <cefore/cef_client.h>
 #include <csmgrd/csmgrd_plugin.h>
@@ -61,6 +64,26 @@
  Structures Declaration
  ****************************************************************************************/
 
+/***** message waiting in an output queue *****/
+typedef struct {
+	unsigned char*		msg;					/* message 								*/
+	int					msg_len;				/* message length 						*/
+	void 				(*release)(void*);		/* called after it is sent or dropped 	*/
+	void*				arg;					/* argument of release 					*/
+} CsmgrdT_Send_Item;
+
+/***** output queue of a socket *****/
+typedef struct {
+	pthread_mutex_t		mutex;					/* protects the members below 			*/
+	int 				fd;						/* socket fd 							*/
+	int 				head;					/* index of the oldest message 			*/
+	int 				num;					/* number of queued messages 			*/
+	int 				offset;					/* bytes of the oldest message sent 	*/
+	int 				hold_f;					/* number of the callers holding the 	*/
+												/* messages 							*/
+	CsmgrdT_Send_Item	items[CsmgrdC_Send_Queue_Size];
+} CsmgrdT_Send_Queue;
+
 /****************************************************************************************
  State Variables
  ****************************************************************************************/
@@ -73,10 +96,57 @@ static char dbg_proc[256] = {0};
 static int 	dbg_lv = CefC_Dbg_None;
 #endif // CefC_Debug
 
+/* Output queues are indexed by the socket fd. The output thread writes the queued	*/
+/* messages when the sockets become writable, so that the caller never waits for 	*/
+/* a slow peer. The lock order is send_queue_mutex -> queue mutex. 					*/
+static CsmgrdT_Send_Queue*	send_queues[CsmgrdC_Send_Queue_Fd_Max] = {0};
+static int 					send_queue_fd_max = -1;		/* largest fd which has a queue */
+static pthread_mutex_t 		send_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t 		send_queue_cond = PTHREAD_COND_INITIALIZER;
+static int 					send_queue_pending = 0;		/* messages have been queued 	*/
+static int 					send_queue_th_f = 0;		/* output thread is running 	*/
+static pthread_t 			send_queue_th;
+
+/* Serializes the writes to the sockets which have no output queue, so that the 	*/
+/* messages of the lookup workers are never mixed 									*/
+static pthread_mutex_t 		send_direct_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /****************************************************************************************
  Static Function Declaration
  ****************************************************************************************/
 
+static CsmgrdT_Send_Queue*
+csmgrd_plugin_send_queue_get (
+	int fd
+);
+static int
+csmgrd_plugin_msg_write (
+	int fd,
+	unsigned char* msg,
+	int msg_len
+);
+static int
+csmgrd_plugin_send_queue_put (
+	CsmgrdT_Send_Queue* q,
+	unsigned char* msg,
+	int msg_len,
+	void (*release)(void*),
+	void* arg,
+	int wait_f
+);
+static void
+csmgrd_plugin_send_queue_flush (
+	CsmgrdT_Send_Queue* q
+);
+static void
+csmgrd_plugin_send_queue_drop (
+	CsmgrdT_Send_Queue* q
+);
+static void*
+csmgrd_plugin_send_queue_thread (
+	void* arg
+);
+
 static int
 csmgrd_log_trim_line_string (
 	const char* p1, 							/* target string for trimming 			*/
@@ -104,6 +174,209 @@ csmgrd_plugin_cob_msg_send (
 	int fd,									/* socket fd								*/
 	unsigned char* msg,						/* send message								*/
 	uint16_t msg_len						/* message length							*/
+) {
+	if ( msg_len <= 0 ) {
+		return (0);
+	}
+	return (csmgrd_plugin_msg_send (fd, msg, msg_len) < 0 ? -1 : 0);
+}
+/*--------------------------------------------------------------------------------------
+	Sends the message through the output queue of the socket
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if an error occurs	*/
+csmgrd_plugin_msg_send (
+	int fd,									/* socket fd								*/
+	unsigned char* msg,						/* send message (copied)					*/
+	int msg_len								/* message length							*/
+) {
+	CsmgrdT_Send_Queue* q;
+	unsigned char* copy;
+	int res;
+
+	if (msg_len <= 0) {
+		return (0);
+	}
+	q = csmgrd_plugin_send_queue_get (fd);
+	if (q == NULL) {
+		res = csmgrd_plugin_msg_write (fd, msg, msg_len);
+		return (res < 0 ? res : msg_len);
+	}
+	copy = (unsigned char*) malloc (msg_len);
+	if (copy == NULL) {
+		return (-1);
+	}
+	memcpy (copy, msg, msg_len);
+
+	/* Queued after the messages which have not been written yet, so that it 	*/
+	/* never goes into the middle of a message partially written 				*/
+	res = csmgrd_plugin_send_queue_put (q, copy, msg_len, free, copy, 1);
+	return (res < 0 ? res : msg_len);
+}
+/*--------------------------------------------------------------------------------------
+	Queues Cob message to the output queue of the socket
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if an EBADF occurs	*/
+csmgrd_plugin_cob_msg_enqueue (
+	int fd,									/* socket fd								*/
+	unsigned char* msg,						/* send message (must be kept until release	*/
+											/* is called)								*/
+	uint16_t msg_len,						/* message length							*/
+	void (*release)(void*),					/* called when the message has been sent or	*/
+											/* dropped									*/
+	void* arg								/* argument of release						*/
+) {
+	CsmgrdT_Send_Queue* q;
+	int res;
+
+	q = csmgrd_plugin_send_queue_get (fd);
+	if (q == NULL) {
+		/* Sends without the output queue 	*/
+		res = csmgrd_plugin_msg_write (fd, msg, msg_len);
+		(*release)(arg);
+		return (res);
+	}
+	return (csmgrd_plugin_send_queue_put (q, msg, msg_len, release, arg, 0));
+}
+/*--------------------------------------------------------------------------------------
+	Drops the messages queued to the socket which is closed
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_plugin_send_queue_close (
+	int fd									/* socket fd								*/
+) {
+	CsmgrdT_Send_Queue* q = NULL;
+
+	if ((fd < 0) || (fd >= CsmgrdC_Send_Queue_Fd_Max)) {
+		return;
+	}
+	pthread_mutex_lock (&send_queue_mutex);
+	q = send_queues[fd];
+	if (q) {
+		pthread_mutex_lock (&q->mutex);
+		csmgrd_plugin_send_queue_drop (q);
+		q->hold_f = 0;
+		pthread_mutex_unlock (&q->mutex);
+	}
+	pthread_mutex_unlock (&send_queue_mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Holds the messages queued to the socket until it is released, so that they are
+	written together by one sendmsg
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_plugin_send_queue_hold (
+	int fd,									/* socket fd								*/
+	int hold_f								/* 1: holds, 0: releases and writes			*/
+) {
+	CsmgrdT_Send_Queue* q;
+	int pending_f;
+
+	q = csmgrd_plugin_send_queue_get (fd);
+	if (q == NULL) {
+		return;
+	}
+	/* Lookup workers may hold the same socket at the same time, the messages 	*/
+	/* are written when the last one releases it 								*/
+	pthread_mutex_lock (&q->mutex);
+	if (hold_f) {
+		q->hold_f++;
+	} else if (q->hold_f > 0) {
+		q->hold_f--;
+	}
+	if (!q->hold_f) {
+		csmgrd_plugin_send_queue_flush (q);
+	}
+	pending_f = ((!q->hold_f) && (q->num > 0));
+	pthread_mutex_unlock (&q->mutex);
+
+	if (pending_f) {
+		/* Wakes up the output thread for the rest 	*/
+		pthread_mutex_lock (&send_queue_mutex);
+		send_queue_pending = 1;
+		pthread_cond_signal (&send_queue_cond);
+		pthread_mutex_unlock (&send_queue_mutex);
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Stops the output thread and drops all queued messages
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_plugin_send_queue_destroy (
+	void
+) {
+	CsmgrdT_Send_Queue* q;
+	int i;
+
+	pthread_mutex_lock (&send_queue_mutex);
+	if (send_queue_th_f) {
+		send_queue_th_f = 0;
+		pthread_cond_signal (&send_queue_cond);
+		pthread_mutex_unlock (&send_queue_mutex);
+		pthread_join (send_queue_th, NULL);
+		pthread_mutex_lock (&send_queue_mutex);
+	}
+	for (i = 0 ; i <= send_queue_fd_max ; i++) {
+		q = send_queues[i];
+		if (q == NULL) {
+			continue;
+		}
+		pthread_mutex_lock (&q->mutex);
+		csmgrd_plugin_send_queue_drop (q);
+		pthread_mutex_unlock (&q->mutex);
+		pthread_mutex_destroy (&q->mutex);
+		free (q);
+		send_queues[i] = NULL;
+	}
+	send_queue_fd_max = -1;
+	pthread_mutex_unlock (&send_queue_mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the output queue of the socket (creates it if needed)
+----------------------------------------------------------------------------------------*/
+static CsmgrdT_Send_Queue*					/* NULL if the output queue is not available 	*/
+csmgrd_plugin_send_queue_get (
+	int fd
+) {
+	CsmgrdT_Send_Queue* q;
+
+	if ((fd < 0) || (fd >= CsmgrdC_Send_Queue_Fd_Max)) {
+		return (NULL);
+	}
+	pthread_mutex_lock (&send_queue_mutex);
+	q = send_queues[fd];
+	if (q == NULL) {
+		q = (CsmgrdT_Send_Queue*) calloc (1, sizeof (CsmgrdT_Send_Queue));
+		if (q == NULL) {
+			pthread_mutex_unlock (&send_queue_mutex);
+			return (NULL);
+		}
+		pthread_mutex_init (&q->mutex, NULL);
+		q->fd = fd;
+		send_queues[fd] = q;
+		if (fd > send_queue_fd_max) {
+			send_queue_fd_max = fd;
+		}
+	}
+	if (!send_queue_th_f) {
+		send_queue_th_f = 1;
+		if (pthread_create (&send_queue_th, NULL, csmgrd_plugin_send_queue_thread, NULL) != 0) {
+			send_queue_th_f = 0;
+			pthread_mutex_unlock (&send_queue_mutex);
+			return (NULL);
+		}
+	}
+	pthread_mutex_unlock (&send_queue_mutex);
+
+	return (q);
+}
+/*--------------------------------------------------------------------------------------
+	Writes the message to the socket which has no output queue
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an EBADF occurs	*/
+csmgrd_plugin_msg_write (
+	int fd,									/* socket fd								*/
+	unsigned char* msg,						/* send message								*/
+	int msg_len								/* message length							*/
 ) {
 	unsigned char* p = msg;
 	int len = msg_len;
@@ -113,14 +386,16 @@ csmgrd_plugin_cob_msg_send (
 	if ( len <= 0 ) {
 		return (0);
 	}
+	pthread_mutex_lock (&send_direct_mutex);
 
 	errno = 0;
-	res = send (fd, p, len,  MSG_DONTWAIT);
+	res = send (fd, p, len,  MSG_DONTWAIT | MSG_NOSIGNAL);
 	if ( res <= 0 ) {
 #ifdef CefC_Debug
 		csmgrd_dbg_write (CefC_Dbg_Finer, "[%s](%d): ########### send_count:%d len:%d res:%d %s\n",
 							__FUNCTION__, __LINE__, send_count, len, res, strerror (errno));
 #endif // CefC_Debug
+		pthread_mutex_unlock (&send_direct_mutex);
 		return (errno == EBADF ? -1 : 0);
 	}
 	if ( 0 < res ){
@@ -143,8 +418,9 @@ csmgrd_plugin_cob_msg_send (
 		usleep(CSMGRD_PLUGIN_SEND_USLEEP);
 
 		errno = 0;
-		res = send (fd, p, len,  MSG_DONTWAIT);
+		res = send (fd, p, len,  MSG_DONTWAIT | MSG_NOSIGNAL);
 		if ( res == len ) {
+			pthread_mutex_unlock (&send_direct_mutex);
 			return (0);
 		} else if ( 0 < res ) {
 			len -= res;
@@ -156,9 +432,225 @@ csmgrd_plugin_cob_msg_send (
 							__FUNCTION__, __LINE__, send_count, len, res, strerror (errno));
 #endif // CefC_Debug
 	}
+	pthread_mutex_unlock (&send_direct_mutex);
 
 	return (errno == EBADF ? -1 : 0);
 }
+/*--------------------------------------------------------------------------------------
+	Puts the message to the output queue, or writes it at once if nothing is waiting
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an EBADF occurs	*/
+csmgrd_plugin_send_queue_put (
+	CsmgrdT_Send_Queue* q,
+	unsigned char* msg,
+	int msg_len,
+	void (*release)(void*),
+	void* arg,
+	int wait_f								/* 1: waits for a free slot when it is full	*/
+) {
+	CsmgrdT_Send_Item* item;
+	struct pollfd fds[1];
+	int offset = 0;
+	int res;
+	int retry;
+
+	pthread_mutex_lock (&q->mutex);
+	if ((q->num == 0) && (!q->hold_f)) {
+		/* Nothing is waiting, tries to write it now 	*/
+		errno = 0;
+		res = send (q->fd, msg, msg_len, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (res == msg_len) {
+			pthread_mutex_unlock (&q->mutex);
+			(*release)(arg);
+			return (0);
+		}
+		if (res < 0) {
+			if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+				pthread_mutex_unlock (&q->mutex);
+				(*release)(arg);
+				return (errno == EBADF ? -1 : 0);
+			}
+			res = 0;
+		}
+		offset = res;
+	}
+	for (retry = 0 ;
+		(wait_f) && (q->num >= CsmgrdC_Send_Queue_Size) && (retry < SEND_RETRY_LIMIT) ;
+			retry++) {
+		/* Writes the queued messages to make a room 	*/
+		pthread_mutex_unlock (&q->mutex);
+		fds[0].fd 		= q->fd;
+		fds[0].events 	= POLLOUT;
+		fds[0].revents 	= 0;
+		poll (fds, 1, CSMGRD_PLUGIN_SEND_USLEEP / 1000);
+		pthread_mutex_lock (&q->mutex);
+		csmgrd_plugin_send_queue_flush (q);
+	}
+	if (q->num >= CsmgrdC_Send_Queue_Size) {
+		/* The peer does not read, drops the message 	*/
+		pthread_mutex_unlock (&q->mutex);
+		(*release)(arg);
+		return (0);
+	}
+	item = &q->items[(q->head + q->num) % CsmgrdC_Send_Queue_Size];
+	item->msg 		= msg;
+	item->msg_len 	= msg_len;
+	item->release 	= release;
+	item->arg 		= arg;
+	if (q->num == 0) {
+		q->offset = offset;
+	}
+	q->num++;
+	pthread_mutex_unlock (&q->mutex);
+
+	/* Wakes up the output thread 	*/
+	pthread_mutex_lock (&send_queue_mutex);
+	send_queue_pending = 1;
+	pthread_cond_signal (&send_queue_cond);
+	pthread_mutex_unlock (&send_queue_mutex);
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Writes the queued messages as many as the socket accepts (the caller locks q)
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_plugin_send_queue_flush (
+	CsmgrdT_Send_Queue* q
+) {
+	struct iovec 		iov[CsmgrdC_Send_Iov_Max];
+	struct msghdr 		mh;
+	CsmgrdT_Send_Item*	item;
+	ssize_t 			res;
+	int 				iovcnt = 0;
+	int 				i;
+
+	/* Gathers the queued messages 	*/
+	for (i = 0 ; (i < q->num) && (i < CsmgrdC_Send_Iov_Max) ; i++) {
+		item = &q->items[(q->head + i) % CsmgrdC_Send_Queue_Size];
+		iov[i].iov_base = item->msg;
+		iov[i].iov_len 	= item->msg_len;
+		iovcnt++;
+	}
+	if (iovcnt == 0) {
+		return;
+	}
+	iov[0].iov_base = (unsigned char*) iov[0].iov_base + q->offset;
+	iov[0].iov_len -= q->offset;
+
+	memset (&mh, 0, sizeof (mh));
+	mh.msg_iov 		= iov;
+	mh.msg_iovlen 	= iovcnt;
+	res = sendmsg (q->fd, &mh, MSG_DONTWAIT | MSG_NOSIGNAL);
+	if (res < 0) {
+		if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+			csmgrd_plugin_send_queue_drop (q);
+		}
+		return;
+	}
+
+	/* Releases the messages which have been written 	*/
+	while ((res > 0) && (q->num > 0)) {
+		item = &q->items[q->head];
+		if (res < item->msg_len - q->offset) {
+			q->offset += res;
+			break;
+		}
+		res -= item->msg_len - q->offset;
+		(*item->release)(item->arg);
+		q->head = (q->head + 1) % CsmgrdC_Send_Queue_Size;
+		q->num--;
+		q->offset = 0;
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Drops all queued messages (the caller locks q)
+----------------------------------------------------------------------------------------*/
+static void
+csmgrd_plugin_send_queue_drop (
+	CsmgrdT_Send_Queue* q
+) {
+	CsmgrdT_Send_Item* item;
+
+	while (q->num > 0) {
+		item = &q->items[q->head];
+		(*item->release)(item->arg);
+		q->head = (q->head + 1) % CsmgrdC_Send_Queue_Size;
+		q->num--;
+	}
+	q->head 	= 0;
+	q->offset 	= 0;
+}
+/*--------------------------------------------------------------------------------------
+	Output thread which writes the queued messages
+----------------------------------------------------------------------------------------*/
+static void*
+csmgrd_plugin_send_queue_thread (
+	void* arg
+) {
+	struct pollfd 		fds[CsmgrdC_Send_Queue_Fd_Max];
+	CsmgrdT_Send_Queue* q;
+	int 				fdnum;
+	int 				fd_max;
+	int 				i;
+
+	while (1) {
+		/* Waits until a message is queued 	*/
+		pthread_mutex_lock (&send_queue_mutex);
+		if (!send_queue_th_f) {
+			pthread_mutex_unlock (&send_queue_mutex);
+			break;
+		}
+		fd_max = send_queue_fd_max;
+		fdnum = 0;
+		for (i = 0 ; i <= fd_max ; i++) {
+			q = send_queues[i];
+			if (q == NULL) {
+				continue;
+			}
+			pthread_mutex_lock (&q->mutex);
+			if ((q->num > 0) && (!q->hold_f)) {
+				fds[fdnum].fd 		= q->fd;
+				fds[fdnum].events 	= POLLOUT;
+				fds[fdnum].revents 	= 0;
+				fdnum++;
+			}
+			pthread_mutex_unlock (&q->mutex);
+		}
+		if (fdnum == 0) {
+			while ((!send_queue_pending) && (send_queue_th_f)) {
+				pthread_cond_wait (&send_queue_cond, &send_queue_mutex);
+			}
+			send_queue_pending = 0;
+			pthread_mutex_unlock (&send_queue_mutex);
+			continue;
+		}
+		send_queue_pending = 0;
+		pthread_mutex_unlock (&send_queue_mutex);
+
+		/* Writes the messages to the writable sockets 	*/
+		if (poll (fds, fdnum, CsmgrdC_Send_Poll_Timeout) <= 0) {
+			continue;
+		}
+		pthread_mutex_lock (&send_queue_mutex);
+		for (i = 0 ; i < fdnum ; i++) {
+			if (fds[i].revents == 0) {
+				continue;
+			}
+			q = send_queues[fds[i].fd];
+			pthread_mutex_lock (&q->mutex);
+			if (fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+				csmgrd_plugin_send_queue_drop (q);
+			} else {
+				csmgrd_plugin_send_queue_flush (q);
+			}
+			pthread_mutex_unlock (&q->mutex);
+		}
+		pthread_mutex_unlock (&send_queue_mutex);
+	}
+
+	return (NULL);
+}
 
 /*--------------------------------------------------------------------------------------
 	Sets APIs for cache algorithm library
@@ -183,6 +675,8 @@ csmgrd_lib_api_get (
 	algo_apis->hit = dlsym (*algo_lib, "hit");
 	algo_apis->miss = dlsym (*algo_lib, "miss");
 	algo_apis->status = dlsym (*algo_lib, "status");
+	algo_apis->capacity_bytes_set = dlsym (*algo_lib, "capacity_bytes_set");
+	algo_apis->reference_api_set = dlsym (*algo_lib, "reference_api_set");
 
 	return (1);
 }
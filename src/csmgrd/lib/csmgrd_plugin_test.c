@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * csmgrd_plugin_test.c
+ */
+
+/*
+	csmgrd_plugin_test.c checks that the messages sent through the output queue of a
+	socket reach the peer in order and unbroken, even if a message was written
+	partially and the rest of it was left in the queue, and even if several threads
+	write to the socket at the same time.
+*/
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+
+#include <csmgrd/csmgrd_plugin.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define CsmgrdT_Test_Msg_Len		8000		/* length of one message 				*/
+#define CsmgrdT_Test_Msg_Num		96			/* messages sent by the test 			*/
+#define CsmgrdT_Test_Read_Wait		5000		/* wait for the messages (ms) 			*/
+#define CsmgrdT_Test_Thread_Num		4			/* writers of the concurrent test 		*/
+#define CsmgrdT_Test_Thread_Msg		200			/* messages sent by each writer 		*/
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static int				test_fail = 0;
+static int				test_sock = -1;		/* socket shared by the writers 		*/
+
+/****************************************************************************************
+ Static Functions
+ ****************************************************************************************/
+
+static void
+test_expect (
+	const char* what,
+	uint64_t value,
+	uint64_t expected
+) {
+	if (value != expected) {
+		fprintf (stderr, "FAIL: %s = %llu (expected %llu)\n", what,
+			(unsigned long long) value, (unsigned long long) expected);
+		test_fail = 1;
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+	Creates a message which carries its sequence number in every byte
+----------------------------------------------------------------------------------------*/
+static unsigned char*
+test_msg_create (
+	uint32_t seq
+) {
+	unsigned char* msg;
+
+	msg = (unsigned char*) malloc (CsmgrdT_Test_Msg_Len);
+	memset (msg, (int)(seq & 0xff), CsmgrdT_Test_Msg_Len);
+	memcpy (msg, &seq, sizeof (seq));
+	return (msg);
+}
+
+/*--------------------------------------------------------------------------------------
+	Reads the messages and checks their order and contents
+----------------------------------------------------------------------------------------*/
+static void
+test_msg_check (
+	int sock,
+	uint32_t num
+) {
+	static unsigned char buff[CsmgrdT_Test_Msg_Len];
+	struct pollfd fds[1];
+	uint32_t seq;
+	uint32_t i;
+	int len;
+	int res;
+
+	for (i = 0 ; i < num ; i++) {
+		len = 0;
+		while (len < CsmgrdT_Test_Msg_Len) {
+			fds[0].fd 		= sock;
+			fds[0].events 	= POLLIN;
+			if (poll (fds, 1, CsmgrdT_Test_Read_Wait) <= 0) {
+				test_expect ("received messages", i, num);
+				return;
+			}
+			res = read (sock, &buff[len], CsmgrdT_Test_Msg_Len - len);
+			if (res <= 0) {
+				test_expect ("received messages", i, num);
+				return;
+			}
+			len += res;
+		}
+		memcpy (&seq, buff, sizeof (seq));
+		test_expect ("sequence number", seq, i);
+		for (len = sizeof (seq) ; len < CsmgrdT_Test_Msg_Len ; len++) {
+			if (buff[len] != (seq & 0xff)) {
+				test_expect ("byte of message", buff[len], seq & 0xff);
+				return;
+			}
+		}
+		if (seq != i) {
+			return;
+		}
+	}
+}
+
+static void
+test_release (
+	void* arg
+) {
+	free (arg);
+}
+
+static void
+test_run (
+	void
+) {
+	unsigned char* msg;
+	int socks[2];
+	int sndbuf = 4096;
+	uint32_t seq = 0;
+	uint32_t i;
+
+	if (socketpair (AF_UNIX, SOCK_STREAM, 0, socks) < 0) {
+		fprintf (stderr, "FAIL: socketpair\n");
+		test_fail = 1;
+		return;
+	}
+	setsockopt (socks[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof (sndbuf));
+	fcntl (socks[0], F_SETFL, fcntl (socks[0], F_GETFL, 0) | O_NONBLOCK);
+
+	/* Cobs which fill the socket, the last one written is left partially 	*/
+	for (i = 0 ; i < CsmgrdT_Test_Msg_Num / 3 ; i++) {
+		msg = test_msg_create (seq++);
+		csmgrd_plugin_cob_msg_enqueue (
+			socks[0], msg, CsmgrdT_Test_Msg_Len, test_release, msg);
+	}
+
+	/* A response written by csmgrd and Cobs sent by the page layout of 		*/
+	/* filesystem cache, both follow the queued Cobs 							*/
+	for (i = 0 ; i < CsmgrdT_Test_Msg_Num / 3 ; i++) {
+		msg = test_msg_create (seq++);
+		test_expect ("csmgrd_plugin_msg_send",
+			csmgrd_plugin_msg_send (socks[0], msg, CsmgrdT_Test_Msg_Len),
+			CsmgrdT_Test_Msg_Len);
+		free (msg);
+		msg = test_msg_create (seq++);
+		test_expect ("csmgrd_plugin_cob_msg_send",
+			csmgrd_plugin_cob_msg_send (socks[0], msg, CsmgrdT_Test_Msg_Len), 0);
+		free (msg);
+	}
+
+	test_msg_check (socks[1], seq);
+
+	csmgrd_plugin_send_queue_close (socks[0]);
+	csmgrd_plugin_send_queue_destroy ();
+	close (socks[0]);
+	close (socks[1]);
+}
+
+/*--------------------------------------------------------------------------------------
+	Writer of the concurrent test, alternates the two send paths
+----------------------------------------------------------------------------------------*/
+static void*
+test_writer (
+	void* arg
+) {
+	uint32_t id = (uint32_t)(uintptr_t) arg;
+	unsigned char* msg;
+	uint32_t seq;
+	uint32_t i;
+
+	for (i = 0 ; i < CsmgrdT_Test_Thread_Msg ; i++) {
+		/* The writer in the high byte, the count of the writer in the rest 	*/
+		seq = (id << 24) | i;
+		msg = test_msg_create (seq);
+		if (i % 2) {
+			csmgrd_plugin_msg_send (test_sock, msg, CsmgrdT_Test_Msg_Len);
+			free (msg);
+		} else {
+			csmgrd_plugin_cob_msg_enqueue (
+				test_sock, msg, CsmgrdT_Test_Msg_Len, test_release, msg);
+		}
+	}
+	return (NULL);
+}
+
+static void
+test_run_concurrent (
+	void
+) {
+	static unsigned char buff[CsmgrdT_Test_Msg_Len];
+	uint32_t next[CsmgrdT_Test_Thread_Num] = {0};
+	pthread_t th[CsmgrdT_Test_Thread_Num];
+	struct pollfd fds[1];
+	int socks[2];
+	int sndbuf = 4096;
+	uint32_t seq;
+	uint32_t id;
+	uint32_t i;
+	int len;
+	int res;
+
+	if (socketpair (AF_UNIX, SOCK_STREAM, 0, socks) < 0) {
+		fprintf (stderr, "FAIL: socketpair\n");
+		test_fail = 1;
+		return;
+	}
+	setsockopt (socks[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof (sndbuf));
+	fcntl (socks[0], F_SETFL, fcntl (socks[0], F_GETFL, 0) | O_NONBLOCK);
+	test_sock = socks[0];
+
+	for (i = 0 ; i < CsmgrdT_Test_Thread_Num ; i++) {
+		pthread_create (&th[i], NULL, test_writer, (void*)(uintptr_t) i);
+	}
+
+	/* Every message must arrive whole, and in order for each writer 	*/
+	for (i = 0 ; i < CsmgrdT_Test_Thread_Num * CsmgrdT_Test_Thread_Msg ; i++) {
+		len = 0;
+		while (len < CsmgrdT_Test_Msg_Len) {
+			fds[0].fd 		= socks[1];
+			fds[0].events 	= POLLIN;
+			if (poll (fds, 1, CsmgrdT_Test_Read_Wait) <= 0) {
+				break;
+			}
+			res = read (socks[1], &buff[len], CsmgrdT_Test_Msg_Len - len);
+			if (res <= 0) {
+				break;
+			}
+			len += res;
+		}
+		if (len < CsmgrdT_Test_Msg_Len) {
+			test_expect ("received messages (concurrent)",
+				i, CsmgrdT_Test_Thread_Num * CsmgrdT_Test_Thread_Msg);
+			break;
+		}
+		memcpy (&seq, buff, sizeof (seq));
+		id = seq >> 24;
+		if (id >= CsmgrdT_Test_Thread_Num) {
+			test_expect ("writer of message", id, 0);
+			break;
+		}
+		test_expect ("count of writer", seq & 0xffffff, next[id]);
+		next[id] = (seq & 0xffffff) + 1;
+		for (len = sizeof (seq) ; len < CsmgrdT_Test_Msg_Len ; len++) {
+			if (buff[len] != (seq & 0xff)) {
+				test_expect ("byte of message (concurrent)", buff[len], seq & 0xff);
+				break;
+			}
+		}
+		if (test_fail) {
+			break;
+		}
+	}
+
+	for (i = 0 ; i < CsmgrdT_Test_Thread_Num ; i++) {
+		pthread_join (th[i], NULL);
+	}
+	csmgrd_plugin_send_queue_close (socks[0]);
+	csmgrd_plugin_send_queue_destroy ();
+	close (socks[0]);
+	close (socks[1]);
+}
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+int
+main (
+	int argc,
+	char** argv
+) {
+	test_run ();
+	test_run_concurrent ();
+
+	if (test_fail) {
+		return (1);
+	}
+	fprintf (stderr, "csmgrd_plugin_test: OK\n");
+	return (0);
+}
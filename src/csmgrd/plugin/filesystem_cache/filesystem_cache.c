@@ -101,6 +101,22 @@
  Structures Declaration
  ****************************************************************************************/
 
+/***** Cobs read from a segment file, freed when all of them were sent *****/
+typedef struct {
+	int				refcnt;						/* Cobs waiting in the output queues	*/
+	unsigned char*	data;
+} FscT_Seg_Read_Buff;
+
+/***** State of the restore from the persistent index *****/
+typedef struct {
+	unsigned char*	kept;						/* restored contents, by index			*/
+	uint64_t		nowt;
+	uint64_t		num;						/* number of the restored Cobs			*/
+	uint32_t		page_con;					/* page file whose size is cached		*/
+	int				page_index;
+	uint64_t		page_size;
+} FscT_Ix_Restore_State;
+
 /****************************************************************************************
  State Variables
  ****************************************************************************************/
@@ -120,6 +136,8 @@ static CsmgrT_Stat_Handle 		csmgr_stat_hdl;
 static pthread_mutex_t 			fsc_cs_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static uint64_t					fsc_extend_lifetime = CsmgrC_UCINC_Extend_Lifetime;
+static char 					fsc_tier_algo[1024] = {0};	/* algorithm of the lower tier	*/
+static void 					(*fsc_tier_stored)(const CsmgrdT_Content_Entry*) = NULL;
 
 /****************************************************************************************
  Static Function Declaration
@@ -217,6 +235,14 @@ fsc_cs_ac_cnt_inc (
 	uint16_t key_size,							/* content name Length					*/
 	uint32_t seq_num							/* sequence number						*/
 );
+/*--------------------------------------------------------------------------------------
+	Function to increment access counts of the ranges of chunks
+----------------------------------------------------------------------------------------*/
+static void
+fsc_cs_ac_cnt_inc_bulk (
+	CsmgrdT_Access_Count* acs,					/* ranges of chunks which were hit		*/
+	int num										/* number of ranges						*/
+);
 /*--------------------------------------------------------------------------------------
 	get lifetime for ccninfo
 ----------------------------------------------------------------------------------------*/
@@ -246,6 +272,60 @@ static uint32_t						/* The return value is FSCID						*/
 fsc_cache_id_create (
 	FscT_Cache_Handle* hdl
 );
+/*--------------------------------------------------------------------------------------
+	Opens the directory which keeps the cache files over the restart
+----------------------------------------------------------------------------------------*/
+static uint32_t						/* The return value is FSCID						*/
+fsc_cache_dir_open (
+	FscT_Cache_Handle* hdl,
+	uint16_t port_num							/* port of csmgrd						*/
+);
+/*--------------------------------------------------------------------------------------
+	Restores the cached Cobs from the persistent index
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_ix_cache_restore (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Restores the content from the persistent index
+----------------------------------------------------------------------------------------*/
+static int 							/* The return value is negative if it is dropped	*/
+fsc_ix_restore_content (
+	const FscT_Ix_Content* info,
+	const unsigned char* name,
+	const unsigned char* version,
+	void* arg
+);
+/*--------------------------------------------------------------------------------------
+	Restores the Cob from the persistent index
+----------------------------------------------------------------------------------------*/
+static int 							/* The return value is negative if it is dropped	*/
+fsc_ix_restore_cob (
+	const FscT_Ix_Content* info,
+	const unsigned char* name,
+	const FscT_Ix_Cob* cob,
+	void* arg
+);
+/*--------------------------------------------------------------------------------------
+	Removes the content none of whose Cobs was restored
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ix_restore_empty (
+	const FscT_Ix_Content* info,
+	const unsigned char* name,
+	void* arg
+);
+/*--------------------------------------------------------------------------------------
+	Records the Cob written to the cache files in the persistent index
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ix_cob_record (
+	CsmgrT_Stat* rcd,
+	const CsmgrdT_Content_Entry* entry,
+	const FscT_Seg_Loc* loc,					/* NULL with the page files				*/
+	int con_f									/* records the content as well			*/
+);
 /*--------------------------------------------------------------------------------------
 	delete file in this directory
 ----------------------------------------------------------------------------------------*/
@@ -267,6 +347,50 @@ static int							/* The return value is negative if an error occurs	*/
 fsc_recursive_dir_clear (
 	char* filepath								/* file path							*/
 );
+/*--------------------------------------------------------------------------------------
+	Removes the cached Cobs of the content from the files
+----------------------------------------------------------------------------------------*/
+static void
+fsc_content_files_remove (
+	CsmgrT_Stat* rcd
+);
+/*--------------------------------------------------------------------------------------
+	Sends the Cobs in the segment files
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_cob_send (
+	int sock,
+	uint32_t con_index,
+	const uint32_t* chunks,
+	int num
+);
+/*--------------------------------------------------------------------------------------
+	Sends the Cobs in a page which was read from a cache file
+----------------------------------------------------------------------------------------*/
+static void
+fsc_page_cob_send (
+	int sock,
+	const unsigned char* page,
+	int rcdsize,
+	const int* idx,
+	int num
+);
+/*--------------------------------------------------------------------------------------
+	Releases the buffer which was read from a segment file
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_read_buff_release (
+	void* arg
+);
+/*--------------------------------------------------------------------------------------
+	Requests to read ahead the pages which follow the chunk
+----------------------------------------------------------------------------------------*/
+static void
+fsc_readahead_request (
+	CsmgrT_Stat* rcd,
+	uint32_t seqno,
+	int rcdsize
+);
 
 /****************************************************************************************
  ****************************************************************************************/
@@ -282,6 +406,7 @@ csmgrd_filesystem_plugin_load (
 	CSMGRD_SET_CALLBACKS (
 		fsc_cs_create, fsc_cs_destroy, fsc_cs_expire_check, fsc_cache_item_get,
 		fsc_cache_item_puts, fsc_cs_ac_cnt_inc, fsc_cache_lifetime_get);
+	cs_in->ac_cnt_inc_bulk = fsc_cs_ac_cnt_inc_bulk;
 
 	if (config_dir) {
 		strcpy (csmgr_conf_dir, config_dir);
@@ -296,6 +421,180 @@ csmgrd_filesystem_plugin_load (
 
 	return (0);
 }
+/*--------------------------------------------------------------------------------------
+	Sets the parameters used when the filesystem cache is the lower tier.
+	This function is called before the init API.
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_filesystem_plugin_tier_set (
+	const char* algo_name,						/* overrides CACHE_ALGORITHM			*/
+	void (*stored)(const CsmgrdT_Content_Entry*)
+												/* called with the Cob written			*/
+) {
+	strncpy (fsc_tier_algo, algo_name, sizeof (fsc_tier_algo) - 1);
+	fsc_tier_stored = stored;
+}
+/*--------------------------------------------------------------------------------------
+	Passes the Cob entry to the writer thread, the filesystem cache takes the
+	buffers of the entry
+----------------------------------------------------------------------------------------*/
+int 								/* The return value is negative if an error occurs	*/
+csmgrd_filesystem_plugin_entry_put (
+	CsmgrdT_Content_Entry* entry
+) {
+	int i;
+
+	for (i = 0 ; i < FscC_Max_Buff ; i++) {
+		if (pthread_mutex_trylock (&fsc_comn_buff_mutex[i]) != 0) {
+			continue;
+		}
+		if ((i >= FscC_Min_Buff) && (fsc_proc_cob_buff[i] == NULL)) {
+			fsc_proc_cob_buff[i] = (CsmgrdT_Content_Entry*)
+				malloc (sizeof (CsmgrdT_Content_Entry) * CsmgrC_Buff_Num);
+		}
+		if ((fsc_proc_cob_buff[i] == NULL) ||
+			(fsc_proc_cob_buff_idx[i] + 1 >= CsmgrC_Buff_Num)) {
+			pthread_mutex_unlock (&fsc_comn_buff_mutex[i]);
+			continue;
+		}
+		memcpy (&fsc_proc_cob_buff[i][fsc_proc_cob_buff_idx[i]],
+			entry, sizeof (CsmgrdT_Content_Entry));
+		fsc_proc_cob_buff_idx[i] += 1;
+		pthread_mutex_unlock (&fsc_comn_buff_mutex[i]);
+		sem_post (fsc_comn_buff_sem);
+		return (0);
+	}
+
+	/* All buffers are busy, the Cob is dropped 	*/
+	free (entry->msg);
+	free (entry->name);
+	if (entry->ver_len) {
+		free (entry->version);
+	}
+	return (-1);
+}
+/*--------------------------------------------------------------------------------------
+	Reads the cached Cob to the entry, the caller frees the buffers of the entry
+----------------------------------------------------------------------------------------*/
+int 								/* The return value is negative if an error occurs	*/
+csmgrd_filesystem_plugin_cob_read (
+	const unsigned char* name,					/* content name							*/
+	uint16_t name_len,							/* content name length					*/
+	uint32_t seqno,								/* chunk num							*/
+	CsmgrdT_Content_Entry* entry
+) {
+	CsmgrT_Stat* rcd;
+	FscT_Seg_Loc loc;
+	char		file_path[PATH_MAX];
+	unsigned char* rec = NULL;
+	uint32_t	con_index;
+	uint16_t	mlen = 0;
+	int 		rcdsize;
+	int 		fd;
+	struct timeval tv;
+
+	if (hdl == NULL) {
+		return (-1);
+	}
+	memset (entry, 0, sizeof (CsmgrdT_Content_Entry));
+
+	pthread_mutex_lock (&fsc_cs_mutex);
+	rcd = csmgrd_stat_content_info_get (csmgr_stat_hdl, name, name_len);
+	if ((!rcd) || (rcd->expire_f) ||
+		!cef_chunk_set_contains (&rcd->cob_set, seqno)) {
+		pthread_mutex_unlock (&fsc_cs_mutex);
+		return (-1);
+	}
+	con_index = rcd->index;
+	rcdsize = sizeof (uint16_t) + rcd->file_msglen;
+	entry->pay_len = (seqno == rcd->last_chunk_num) ? rcd->last_cob_size : rcd->cob_size;
+	entry->expiry = rcd->expiry;
+	entry->node = rcd->node;
+	if (rcd->ver_len) {
+		entry->version = (unsigned char*) malloc (rcd->ver_len);
+		if (entry->version == NULL) {
+			pthread_mutex_unlock (&fsc_cs_mutex);
+			return (-1);
+		}
+		memcpy (entry->version, rcd->version, rcd->ver_len);
+		entry->ver_len = rcd->ver_len;
+	}
+
+	if (hdl->seg_store == NULL) {
+		/* The page files are read with fsc_cs_mutex like fsc_cache_item_get 	*/
+		rec = (unsigned char*) malloc (rcdsize);
+		sprintf (file_path, "%s/%d/%d", hdl->fsc_cache_path, (int) con_index,
+			(int)(seqno / FscC_Page_Cob_Num / FscC_File_Page_Num));
+		fd = open (file_path, O_RDONLY);
+		if ((rec == NULL) || (fd < 0) ||
+			(pread (fd, rec, rcdsize, (off_t)(seqno %
+				(FscC_Page_Cob_Num * FscC_File_Page_Num)) * rcdsize) != rcdsize)) {
+			if (fd >= 0) {
+				close (fd);
+			}
+			pthread_mutex_unlock (&fsc_cs_mutex);
+			goto CobReadError;
+		}
+		close (fd);
+		pthread_mutex_unlock (&fsc_cs_mutex);
+
+		memcpy (&mlen, rec, sizeof (uint16_t));
+		if (!(CefC_S_Fix_Header < mlen && mlen < rcdsize)) {
+			goto CobReadError;
+		}
+		entry->msg = (unsigned char*) malloc (mlen);
+		if (entry->msg == NULL) {
+			goto CobReadError;
+		}
+		memcpy (entry->msg, &rec[sizeof (uint16_t)], mlen);
+		free (rec);
+		rec = NULL;
+	} else {
+		pthread_mutex_unlock (&fsc_cs_mutex);
+
+		if (fsc_seg_lookup (hdl->seg_store, con_index, &seqno, 1, &loc) != 1) {
+			goto CobReadError;
+		}
+		mlen = loc.msg_len;
+		entry->msg = (unsigned char*) malloc (mlen);
+		if ((entry->msg == NULL) ||
+			(fsc_seg_read (hdl->seg_store, loc.seg_id,
+				loc.offset + FscC_Seg_Rec_Head_Size, entry->msg, mlen) < 0)) {
+			fsc_seg_unpin (hdl->seg_store, &loc, 1);
+			goto CobReadError;
+		}
+		fsc_seg_unpin (hdl->seg_store, &loc, 1);
+	}
+
+	entry->name = (unsigned char*) malloc (name_len);
+	if (entry->name == NULL) {
+		goto CobReadError;
+	}
+	memcpy (entry->name, name, name_len);
+	entry->name_len = name_len;
+	entry->msg_len = mlen;
+	entry->chunk_num = seqno;
+
+	/* The time to cache the Cob is not kept in the cache files 	*/
+	entry->cache_time = (entry->expiry != 0) ? entry->expiry : UINT64_MAX;
+	gettimeofday (&tv, NULL);
+	entry->ins_time = tv.tv_sec * 1000000llu + tv.tv_usec;
+
+	return (0);
+
+CobReadError:
+	if (rec) {
+		free (rec);
+	}
+	if (entry->msg) {
+		free (entry->msg);
+	}
+	if (entry->version) {
+		free (entry->version);
+	}
+	memset (entry, 0, sizeof (CsmgrdT_Content_Entry));
+	return (-1);
+}
 /*--------------------------------------------------------------------------------------
 	Init API
 ----------------------------------------------------------------------------------------*/
@@ -326,6 +625,9 @@ fsc_cs_create (
 		csmgrd_log_write (CefC_Log_Error, "[%s] Read config error\n", __func__);
 		return (-1);
 	}
+	if (fsc_tier_algo[0]) {
+		strcpy (conf_param.algo_name, fsc_tier_algo);
+	}
 	hdl->cache_capacity = conf_param.cache_capacity;
 	strcpy (hdl->algo_name, conf_param.algo_name);
 	hdl->algo_name_size = conf_param.algo_name_size;
@@ -333,6 +635,8 @@ fsc_cs_create (
 	hdl->cache_cobs = 0;
 	strcpy (hdl->fsc_root_path, conf_param.fsc_root_path);
 	fsc_extend_lifetime = conf_param.extend_lifetime;
+	hdl->seg_store = NULL;
+	hdl->ra_tier = NULL;
 
 	/* Check for excessive or insufficient memory resources for cache algorithm library */
 	if (strcmp (hdl->algo_name, "None") != 0) {
@@ -352,7 +656,11 @@ fsc_cs_create (
 	}
 
 	/* Creates the directory to store cache files		*/
-	hdl->fsc_id = fsc_cache_id_create (hdl);
+	if (conf_param.persist_f) {
+		hdl->fsc_id = fsc_cache_dir_open (hdl, conf_param.port_num);
+	} else {
+		hdl->fsc_id = fsc_cache_id_create (hdl);
+	}
 	if (hdl->fsc_id == 0xFFFFFFFF) {
 		csmgrd_log_write (CefC_Log_Error, "FileSystemCache init error\n");
 		return (-1);
@@ -360,6 +668,53 @@ fsc_cs_create (
 	csmgrd_log_write (CefC_Log_Info,
 		"Creation the cache directory (%s) ... OK\n", hdl->fsc_cache_path);
 
+	/* Reads the index written before the restart 		*/
+	if (conf_param.persist_f) {
+		hdl->ix = fsc_ix_open (hdl->fsc_cache_path, conf_param.layout,
+			(conf_param.layout == FscC_Layout_Segment) ? conf_param.seg_size : 0,
+			FscC_Page_Cob_Num, FscC_File_Page_Num);
+		if (hdl->ix == NULL) {
+			csmgrd_log_write (CefC_Log_Error, "Failed to open the persistent index\n");
+			return (-1);
+		}
+		if (hdl->ix->fold == NULL) {
+			/* The files left without the index can not be restored 	*/
+			if (fsc_dir_clear (hdl->fsc_cache_path) != 0) {
+				csmgrd_log_write (CefC_Log_Error, "Failed to clear the cache directory\n");
+				return (-1);
+			}
+		}
+	}
+
+	/* Creates the segment files 		*/
+	if (conf_param.layout == FscC_Layout_Segment) {
+		if ((hdl->ix) && (hdl->ix->fold)) {
+			hdl->seg_store = fsc_seg_store_open (hdl->fsc_cache_path, conf_param.seg_size);
+		} else {
+			hdl->seg_store = fsc_seg_store_create (hdl->fsc_cache_path, conf_param.seg_size);
+		}
+		if (hdl->seg_store == NULL) {
+			csmgrd_log_write (CefC_Log_Error, "Failed to create the segment files\n");
+			return (-1);
+		}
+		if (hdl->ix) {
+			hdl->seg_store->move_fn  = fsc_ix_cob_move;
+			hdl->seg_store->move_arg = hdl->ix;
+		}
+		csmgrd_log_write (CefC_Log_Info,
+			"Segment files (%u bytes) ... OK\n", conf_param.seg_size);
+	} else if (conf_param.ra_page_num > 0) {
+		/* Creates the staging tier to read ahead the page files 	*/
+		hdl->ra_tier = fsc_ra_tier_create (
+			hdl->fsc_cache_path, FscC_Page_Cob_Num, conf_param.ra_page_num);
+		if (hdl->ra_tier == NULL) {
+			csmgrd_log_write (CefC_Log_Error, "Failed to create the readahead thread\n");
+			return (-1);
+		}
+		csmgrd_log_write (CefC_Log_Info,
+			"Readahead (%d pages) ... OK\n", conf_param.ra_page_num);
+	}
+
 	/* Loads the library for cache algorithm 		*/
 	if (strcmp (conf_param.algo_name, "None")) {
 		int rc = snprintf (hdl->algo_name, sizeof (hdl->algo_name), "%s%s", conf_param.algo_name, CsmgrdC_Library_Name);
@@ -379,6 +734,14 @@ fsc_cs_create (
 	} else {
 		csmgrd_log_write (CefC_Log_Info, "Library : Not Specified\n");
 	}
+	/* The capacity update clears csmgr_stat, so it precedes the restore 	*/
+	csmgr_stat_hdl = stat_hdl;
+	csmgrd_stat_cache_capacity_update (csmgr_stat_hdl, hdl->cache_capacity);
+
+	/* Restores the cached Cobs before the writer thread starts 		*/
+	if ((hdl->ix) && (fsc_ix_cache_restore () < 0)) {
+		return (-1);
+	}
 
 	/* Creates the process buffer 		*/
 	for (i = 0 ; i < FscC_Max_Buff ; i++) {
@@ -423,8 +786,6 @@ fsc_cs_create (
 	} else {
 		csmgrd_log_write (CefC_Log_Info, "Library  : Not Specified\n");
 	}
-	csmgr_stat_hdl = stat_hdl;
-	csmgrd_stat_cache_capacity_update (csmgr_stat_hdl, hdl->cache_capacity);
 	return (0);
 }
 /*--------------------------------------------------------------------------------------
@@ -464,6 +825,20 @@ fsc_cob_process_thread (
 			}
 			pthread_mutex_unlock (&fsc_comn_buff_mutex[i]);
 		}
+
+		/* Compacts a segment file, only this thread writes the segment files 	*/
+		if (hdl->seg_store) {
+			if (fsc_seg_compact (hdl->seg_store) > 0) {
+#ifdef CefC_Debug
+				csmgrd_dbg_write (CefC_Dbg_Fine,
+					"cob put thread compacted a segment ("FMTU64")\n",
+					hdl->seg_store->compact_num);
+#endif // CefC_Debug
+			}
+		}
+		if (hdl->ix) {
+			fsc_ix_compact (hdl->ix, 0);
+		}
 	}
 
 	pthread_exit (NULL);
@@ -521,8 +896,6 @@ fsc_cs_remove (
 	uint16_t 			type;
 	uint32_t 			chunk_num;
 	CsmgrT_Stat*		rcd = NULL;
-	uint32_t			x, n;
-	uint64_t 			mask;
 
 
 	tlv_hdp = (struct tlv_hdr*) &key[key_len-8];
@@ -539,28 +912,22 @@ fsc_cs_remove (
 			return;
 		}
 		/* Removes the cache  		*/
-		mask = 1;
-		x = chunk_num / 64;
-		n = chunk_num % 64;
-		if ((rcd->map_max-1) < x) {
-			return;
-		}
-//		if (hdl->algo_apis.erase) {
-			if (rcd->cob_map[x]) {
-				mask <<= n;
-				if (rcd->cob_map[x] & mask) {
-					if (rcd->cob_num == 1) {
-						char file_path[PATH_MAX];
-						sprintf (file_path, "%s/%d", hdl->fsc_cache_path, (int) rcd->index);
-						fsc_recursive_dir_clear (file_path);
-					}
-					csmgrd_stat_cob_remove (
-						csmgr_stat_hdl, &key[0], key_len - 8, chunk_num, 0);
-
-					hdl->cache_cobs--;
-				}
+		if (cef_chunk_set_contains (&rcd->cob_set, chunk_num)) {
+			if (hdl->seg_store) {
+				fsc_seg_remove (hdl->seg_store, rcd->index, chunk_num);
+			} else if (rcd->cob_num == 1) {
+				char file_path[PATH_MAX];
+				sprintf (file_path, "%s/%d", hdl->fsc_cache_path, (int) rcd->index);
+				fsc_recursive_dir_clear (file_path);
 			}
-//		}
+			if (hdl->ix) {
+				fsc_ix_cob_del (hdl->ix, rcd->index, chunk_num);
+			}
+			csmgrd_stat_cob_remove (
+				csmgr_stat_hdl, &key[0], key_len - 8, chunk_num, 0);
+
+			hdl->cache_cobs--;
+		}
 	}
 	return;
 }
@@ -600,12 +967,39 @@ fsc_cs_destroy (
 		return;
 	}
 
-	if (hdl->fsc_cache_path[0] != 0x00) {
+	if (hdl->seg_store) {
+		fsc_seg_store_destroy (hdl->seg_store);
+		hdl->seg_store = NULL;
+	}
+	if (hdl->ra_tier) {
+		csmgrd_log_write (CefC_Log_Info,
+			"Readahead staged : "FMTU64", hit : "FMTU64", dropped : "FMTU64"\n",
+			hdl->ra_tier->staged_num, hdl->ra_tier->hit_num, hdl->ra_tier->drop_num);
+		fsc_ra_tier_destroy (hdl->ra_tier);
+		hdl->ra_tier = NULL;
+	}
+	if (hdl->ix) {
+		/* The cache files are left for the restart 	*/
+		if (hdl->ix->broken_f) {
+			csmgrd_log_write (CefC_Log_Warn,
+				"Failed to write the persistent index, the cache is not restored\n");
+		}
+		fsc_ix_close (hdl->ix);
+		hdl->ix = NULL;
+	} else if (hdl->fsc_cache_path[0] != 0x00) {
 		fsc_recursive_dir_clear (hdl->fsc_cache_path);
 	}
 
 	/* Close the loaded cache algorithm library */
 	if (hdl->algo_lib) {
+		if (hdl->algo_apis.status) {
+			CsmgrdT_Lib_Status lib_stat;
+			memset (&lib_stat, 0, sizeof (CsmgrdT_Lib_Status));
+			(*(hdl->algo_apis.status))(&lib_stat);
+			csmgrd_log_write (CefC_Log_Info,
+				"Cache algorithm hit : "FMTU64", miss : "FMTU64"\n",
+				lib_stat.hit_count, lib_stat.miss_count);
+		}
 		if (hdl->algo_apis.destroy) {
 			(*(hdl->algo_apis.destroy))();
 		}
@@ -629,9 +1023,7 @@ fsc_cs_expire_check (
 ) {
 	int 			index = 0;
 	CsmgrT_Stat* 	rcd = NULL;
-	char			file_path[PATH_MAX];
-	uint32_t 		i, n;
-	uint64_t 		mask;
+	uint32_t 		from, first, last;
 	uint32_t 		chunk_num, net_chunk_num;
 	unsigned char 	trg_key[65535];
 	int 			trg_key_len = 0;
@@ -648,54 +1040,51 @@ fsc_cs_expire_check (
 			break;
 		}
 
-		sprintf (file_path, "%s/%d", hdl->fsc_cache_path, (int) rcd->index);
-		fsc_recursive_dir_clear (file_path);
+		fsc_content_files_remove (rcd);
 
 		cob_cnt = rcd->cob_num;
 		if (hdl->algo_apis.erase) {
-			for (i = 0 ; i < rcd->map_max ; i++) {
-				if (cob_cnt == 0) {
-					goto LOOP_END;
-				}
-				if (rcd->cob_map[i]) {
-					mask = 0x0000000000000001;
-					for (n = 0 ; n < 64 ; n++) {
-						if (cob_cnt == 0) {
-							goto LOOP_END;
-						}
-						if (rcd->cob_map[i] & mask) {
-							name_len = rcd->name_len;
-							memcpy (&trg_key[0], rcd->name, name_len);
-							trg_key[name_len] 		= 0x00;
-							trg_key[name_len + 1] 	= 0x10;
-							trg_key[name_len + 2] 	= 0x00;
-							trg_key[name_len + 3] 	= 0x04;
-							chunk_num = (i * 64 + n);
-							net_chunk_num = htonl (chunk_num);
-							memcpy (&trg_key[name_len + 4], &net_chunk_num, sizeof (uint32_t));
-							trg_key_len = name_len + 4 + sizeof (uint32_t);
-
-							(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
-
-							csmgrd_stat_cob_remove (
-								csmgr_stat_hdl, rcd->name, name_len, chunk_num, 0);
-
-							hdl->cache_cobs--;
-							cob_cnt--;
-						}
-						mask <<= 1;
+			/* The record is deleted when the last Cob is removed 	*/
+			from = 0;
+			while ((cob_cnt > 0) &&
+				(cef_chunk_set_range_next (&rcd->cob_set, from, &first, &last))) {
+				for (chunk_num = first ; cob_cnt > 0 ; chunk_num++) {
+					name_len = rcd->name_len;
+					memcpy (&trg_key[0], rcd->name, name_len);
+					trg_key[name_len] 		= 0x00;
+					trg_key[name_len + 1] 	= 0x10;
+					trg_key[name_len + 2] 	= 0x00;
+					trg_key[name_len + 3] 	= 0x04;
+					net_chunk_num = htonl (chunk_num);
+					memcpy (&trg_key[name_len + 4], &net_chunk_num, sizeof (uint32_t));
+					trg_key_len = name_len + 4 + sizeof (uint32_t);
+
+					(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
+
+					csmgrd_stat_cob_remove (
+						csmgr_stat_hdl, rcd->name, name_len, chunk_num, 0);
+
+					hdl->cache_cobs--;
+					cob_cnt--;
+					if (chunk_num == last) {
+						break;
 					}
 				}
+				from = last + 1;
 			}
 		} else {
 			csmgrd_stat_content_info_delete (csmgr_stat_hdl, rcd->name, rcd->name_len);
 			hdl->cache_cobs -= cob_cnt;
 		}
-LOOP_END:;
 
 	}
 	pthread_mutex_unlock (&fsc_cs_mutex);
 
+	/* Wakes up the cob put thread to compact the segment files 	*/
+	if (hdl->seg_store) {
+		sem_post (fsc_comn_buff_sem);
+	}
+
 	return;
 
 }
@@ -718,8 +1107,6 @@ fsc_cache_item_get (
 ) {
 	CsmgrT_Stat* rcd = NULL;
 	uint32_t	file_msglen;
-	uint64_t 	mask;
-	uint32_t 	x;
 	char		file_path[PATH_MAX];
 	static char	red_file_path[PATH_MAX] = {0};
 	int 		cob_block_index;
@@ -746,6 +1133,9 @@ fsc_cache_item_get (
 	uint16_t ucinc_stat;
 	int ret;
 	uint64_t plaint = 0;
+	uint32_t	prev_tx_seq;
+	unsigned char*	staged_buf;
+	int			staged_num = 0;
 
 #ifdef __FSCACHE_VERSION__
 	fprintf (stderr, "--- fsc_cache_item_get()\n");
@@ -762,11 +1152,10 @@ fsc_cache_item_get (
 		return (CefC_Csmgr_Cob_NotExist);
 	}
 	if (rcd->expire_f) {
-		sprintf (file_path, "%s/%d", hdl->fsc_cache_path, (int) rcd->index);
 #ifdef CefC_Debug
-		csmgrd_dbg_write (CefC_Dbg_Fine, "Delete the expired content = %s\n", file_path);
+		csmgrd_dbg_write (CefC_Dbg_Fine, "Delete the expired content = %d\n", (int) rcd->index);
 #endif // CefC_Debug
-		fsc_recursive_dir_clear (file_path);
+		fsc_content_files_remove (rcd);
 		csmgrd_stat_content_info_delete (csmgr_stat_hdl, key, key_size);
 		hdl->cache_cobs -= rcd->cob_num;
 		pthread_mutex_unlock (&fsc_cs_mutex);
@@ -845,14 +1234,10 @@ fsc_cache_item_get (
 	trg_key_len = csmgrd_name_chunknum_concatenate (key, key_size, seqno, trg_key);
 
 	/* Check the work cob is cached or not 		*/
-	mask = 1;
-	x = seqno / 64;
-	mask <<= (seqno % 64);
-
 	file_msglen = rcd->file_msglen;
 	rcdsize = sizeof (uint16_t) + file_msglen;
 
-	if ((rcd->map_max-1) < x || !(rcd->cob_map[x] & mask)) {
+	if (!cef_chunk_set_contains (&rcd->cob_set, seqno)) {
 #ifdef CefC_Debug
 		csmgrd_dbg_write (CefC_Dbg_Finest, "seqno = %u is not cached\n", seqno);
 #endif // CefC_Debug
@@ -868,6 +1253,7 @@ fsc_cache_item_get (
 	gettimeofday (&tv, NULL);
 	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
 
+	prev_tx_seq = rcd->tx_seq;
 	if (nowt > rcd->tx_time) {
 		rcd->tx_seq = 0;
 		rcd->tx_num = -1;
@@ -886,11 +1272,47 @@ fsc_cache_item_get (
 		return (CefC_Csmgr_Cob_NotExist);
 	}
 	if (send_cob_f == 1) {
+		/* The content is read in order if the request starts from the first 	*/
+		/* chunk or follows the Cobs sent last time 							*/
+		if (hdl->ra_tier && resend_1cob_f == 0 &&
+			(seqno == 0 ||
+			 (seqno > prev_tx_seq && seqno <= prev_tx_seq + FscC_Tx_Cob_Num * 2))) {
+			fsc_readahead_request (rcd, seqno, rcdsize);
+		}
 		rcd->tx_seq = seqno;
 		rcd->tx_num = FscC_Tx_Cob_Num;
 		rcd->tx_time = nowt + FscC_Sent_Reset_Time;
 	}
 
+	if (hdl->seg_store) {
+		/* Collects the cached chunks to send, and reads them from the segment 	*/
+		/* files without fsc_cs_mutex 											*/
+		uint32_t 	chunks[FscC_Tx_Cob_Num];
+		int 		chunk_cnt = 0;
+		uint32_t 	con_index = rcd->index;
+		uint32_t 	s, first, last;
+
+		chunks[chunk_cnt++] = seqno;
+		if (resend_1cob_f == 0) {
+			s = seqno + 1;
+			while ((s > seqno) && (chunk_cnt < FscC_Tx_Cob_Num) &&
+				(cef_chunk_set_range_next (&rcd->cob_set, s, &first, &last))) {
+				for (s = first ; chunk_cnt < FscC_Tx_Cob_Num ; s++) {
+					chunks[chunk_cnt++] = s;
+					if (s == last) {
+						break;
+					}
+				}
+				s = last + 1;
+			}
+		}
+		csmgrd_stat_access_count_update (csmgr_stat_hdl, key, key_size);
+		pthread_mutex_unlock (&fsc_cs_mutex);
+
+		fsc_seg_cob_send (sock, con_index, chunks, chunk_cnt);
+		return (CefC_Csmgr_Cob_Exist);
+	}
+
 	/* Open the file that specified cob is cached 		*/
 	cob_block_index = (int)(seqno / FscC_Page_Cob_Num) % FscC_File_Page_Num;
 	page_index = (int)(seqno / FscC_Page_Cob_Num/FscC_File_Page_Num);
@@ -915,6 +1337,22 @@ fsc_cache_item_get (
 			page_read_time = 0L;
 		}
 
+		/* Uses the block staged by the readahead thread 	*/
+		if (hdl->ra_tier) {
+			staged_buf = fsc_ra_take (hdl->ra_tier,
+				rcd->index, page_index, cob_block_index, rcdsize, &staged_num);
+			if (staged_buf != NULL) {
+				if (staged_num > pos_index) {
+					strcpy (red_file_path, file_path);
+					red_cob_block_index = cob_block_index;
+					page_cob_buf = staged_buf;
+					page_read_time = nowt;
+					goto ItemGetStaged;
+				}
+				free (staged_buf);
+			}
+		}
+
 		fp = fopen (file_path, "rb");
 		if (fp == NULL) {
 			csmgrd_log_write (CefC_Log_Error, "Failed to open the cache file (%s)\n", file_path);
@@ -941,6 +1379,7 @@ fsc_cache_item_get (
 #endif // CefC_Debug
 			goto ItemGetPost;
 		}
+ItemGetStaged:
 		if (red_ver_len) {
 			memset (red_version, 0, PATH_MAX);
 		}
@@ -964,11 +1403,12 @@ fsc_cache_item_get (
 			csmgr_stat_hdl, key, key_size);
 
 	/* Send Cob to cefnetd */
-	uint16_t mlen;
-	memcpy (&mlen, &page_cob_buf[pos_index*rcdsize], sizeof (uint16_t));
-	csmgrd_plugin_cob_msg_send (
-						sock, &page_cob_buf[pos_index*rcdsize+sizeof (uint16_t)], mlen);
+	int page_idx[FscC_Tx_Cob_Num];
+	int page_cnt = 0;
+
+	page_idx[page_cnt++] = pos_index;
 	if (resend_1cob_f == 1) {
+		fsc_page_cob_send (sock, page_cob_buf, rcdsize, page_idx, page_cnt);
 		if (fp != NULL) {
 			fclose (fp);
 		}
@@ -980,11 +1420,7 @@ fsc_cache_item_get (
 
 	for (i = pos_index + 1 ; i < FscC_Page_Cob_Num ; i++) {
 		if (tx_cnt < FscC_Tx_Cob_Num) {
-			mask = 1;
-			x = seqno / 64;
-			mask <<= (seqno % 64);
-
-			if ((rcd->map_max-1) < x || !(rcd->cob_map[x] & mask)) {
+			if (!cef_chunk_set_contains (&rcd->cob_set, seqno)) {
 				seqno++;
 				continue;
 			}
@@ -995,18 +1431,14 @@ fsc_cache_item_get (
 				csmgrd_dbg_write (CefC_Dbg_Finest, "send seqno = %u (%u bytes)\n", seqno, mlen);
 			}
 #endif // CefC_Debug
-			uint16_t mlen;
-			memcpy (&mlen, &page_cob_buf[i*rcdsize], sizeof (uint16_t));
-			if (CefC_S_Fix_Header < mlen && mlen < rcdsize) {
-				csmgrd_plugin_cob_msg_send (
-					sock, &page_cob_buf[i*rcdsize+sizeof (uint16_t)], mlen);
-			}
+			page_idx[page_cnt++] = i;
 			tx_cnt++;
 			seqno++;
 		} else {
 			break;
 		}
 	}
+	fsc_page_cob_send (sock, page_cob_buf, rcdsize, page_idx, page_cnt);
 
 ItemGetPost:
 	if (fp != NULL) {
@@ -1113,19 +1545,17 @@ fsc_cache_cob_write (
 	uint16_t 		name_len = 0;
 	int				work_con_index = -1;
 	int 			prev_page_index = -1;
-	int 			work_page_index;
+	int 			work_page_index = 0;
 	char			file_path[PATH_MAX];
-	int  			cob_block_index;
-	int 			rcdsize;
+	int  			cob_block_index = 0;
+	int 			rcdsize = 0;
 	char			cont_path[PATH_MAX];
 	FILE*			fp = NULL;
-	uint64_t 		mask;
-	uint32_t 		x;
 	int*			indxs = NULL;
 	int				cnt = 0;
 	int				rbpflag = 0;
 	int				swindx[FscC_Page_Cob_Num];
-	uint32_t		file_msglen;
+	uint32_t		file_msglen = 0;
 	unsigned char 	del_name[CsmgrT_Name_Max];
 	uint16_t 		del_name_len = 0;
 	uint32_t 		del_chunk_num = UINT_MAX;
@@ -1136,6 +1566,8 @@ fsc_cache_cob_write (
 	CefT_CcnMsg_OptHdr	poh;
 	uint16_t			ucinc_stat;
 	struct fixed_hdr*	fixed_hp;
+	FscT_Seg_Loc		seg_loc;
+	int					ix_con_f = 0;
 
 #ifdef __FSCACHE_VERSION__
 	fprintf (stderr, "--- fsc_cache_cob_write()\n");
@@ -1228,10 +1660,8 @@ fsc_cache_cob_write (
 				rc = cef_csmgr_cache_version_compare (cobs[index].version, cobs[index].ver_len, rcd->version, rcd->ver_len);
 				if (rc != CefC_CV_Inconsistent) {
 					if (rc == CefC_CV_Newest_1stArg) {
-						char file_path[PATH_MAX];
 						/* Delete old files */
-						sprintf (file_path, "%s/%d", hdl->fsc_cache_path, (int) rcd->index);
-						fsc_recursive_dir_clear (file_path);
+						fsc_content_files_remove (rcd);
 
 						/* Old Stat */
 						csmgrd_stat_content_info_delete (csmgr_stat_hdl, cobs[index].name, cobs[index].name_len);
@@ -1246,14 +1676,11 @@ fsc_cache_cob_write (
 							goto NEXTCOB;
 						}
 #ifdef __FSCACHE_VERSION__
-						fprintf (stderr, "    => delete %s and init\n", file_path);
+						fprintf (stderr, "    => delete %d and init\n", (int) rcd->index);
 #endif //__FSCACHE_VERSION__
 					} else if (rc == CefC_CV_Same) {
 						/* Check the work cob is cached or not */
-						mask = 1;
-						x = chunk_num / 64;
-						mask <<= (chunk_num % 64);
-						if ((rcd->map_max-1) >= x && rcd->cob_map[x] & mask) {
+						if (cef_chunk_set_contains (&rcd->cob_set, chunk_num)) {
 							/* cached yet */
 							goto NEXTCOB;
 						} else {
@@ -1276,7 +1703,10 @@ fsc_cache_cob_write (
 			memcpy (name, cobs[index].name, cobs[index].name_len);
 			name_len = cobs[index].name_len;
 
-			if (mkdir (cont_path, 0766) != 0) {
+			if (hdl->seg_store) {
+				/* The segment files do not use the directory of the content 	*/
+				;
+			} else if (mkdir (cont_path, 0766) != 0) {
 				if (errno == ENOENT) {
 					csmgrd_log_write (CefC_Log_Error,
 						"Failed to create the cache directory for the each content\n");
@@ -1291,6 +1721,22 @@ fsc_cache_cob_write (
 			}
 		}
 
+		if (hdl->seg_store) {
+			/* Check the work cob is cached or not 		*/
+			if (cef_chunk_set_contains (&rcd->cob_set, chunk_num)) {
+				goto NEXTCOB;
+			}
+			/* Appends the cob to the active segment, it is indexed before 	*/
+			/* csmgr_stat shows it is cached 									*/
+			if (fsc_seg_append (hdl->seg_store, rcd->index, chunk_num,
+					cobs[index].msg, (uint16_t) cobs[index].msg_len, &seg_loc) < 0) {
+				csmgrd_log_write (CefC_Log_Warn,
+					"Failed to write the cob to the segment file\n");
+				goto NEXTCOB;
+			}
+			goto COBUPDATE;
+		}
+
 		/* Control record size */
 		if (rcd->file_msglen == 0) {
 			rcd->file_msglen
@@ -1320,10 +1766,7 @@ fsc_cache_cob_write (
 			goto NEXTCOB;
 		}
 		/* Check the work cob is cached or not 		*/
-		mask = 1;
-		x = chunk_num / 64;
-		mask <<= (chunk_num % 64);
-		if ((rcd->map_max-1) >= x && rcd->cob_map[x] & mask) {
+		if (cef_chunk_set_contains (&rcd->cob_set, chunk_num)) {
 			goto NEXTCOB;
 		}
 		/* Update the page to write the received cob 		*/
@@ -1368,6 +1811,7 @@ fsc_cache_cob_write (
 			}
 		}
 
+COBUPDATE:
 		/* Updates the content information 			*/
 		if (hdl->algo_apis.insert) {
 			(*(hdl->algo_apis.insert))(&cobs[index]);
@@ -1375,6 +1819,9 @@ fsc_cache_cob_write (
 		csmgrd_stat_cob_update (csmgr_stat_hdl, cobs[index].name, cobs[index].name_len,
 				chunk_num, cobs[index].pay_len, cobs[index].expiry,
 				nowt, cobs[index].node);
+		if (fsc_tier_stored) {
+			(*fsc_tier_stored)(&cobs[index]);
+		}
 		/* Check the status of UCINC */
 		if (rcd->ucinc_stat != CsmgrT_UCINC_STAT_VALIDATION_OK) {
 			memset (&pm, 0, sizeof (CefT_CcnMsg_MsgBdy));
@@ -1434,11 +1881,25 @@ fsc_cache_cob_write (
 								del_name, del_name_len, del_chunk_num, trg_key);
 				(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
 			}
+			if (hdl->ix) {
+				/* file_msglen of the content was changed 	*/
+				fsc_ix_cob_del (hdl->ix, rcd->index, del_chunk_num);
+				ix_con_f = 1;
+			}
 			csmgrd_stat_cob_remove (csmgr_stat_hdl, del_name, del_name_len, del_chunk_num, 0);
 			hdl->cache_cobs--;
 			del_chunk_num = UINT_MAX;
 		}
 
+		if (hdl->seg_store) {
+			fsc_ix_cob_record (rcd, &cobs[index], &seg_loc, 0);
+			rcd->fsc_write_time = nowt;
+			if (!(hdl->algo_apis.insert)) {
+				hdl->cache_cobs++;
+			}
+			goto NEXTCOB;
+		}
+
 		/* Set to write buffer 							*/
 		unsigned char wbuff[sizeof (uint16_t) + UINT16_MAX];
 		int write_index = chunk_num % FscC_Page_Cob_Num;
@@ -1464,7 +1925,12 @@ fsc_cache_cob_write (
 				__FUNCTION__, __LINE__, index, cobs[index].chunk_num, strerror (errno));
 #endif // CefC_Debug
 		}
+		fsc_ix_cob_record (rcd, &cobs[index], NULL, ix_con_f);
+		ix_con_f = 0;
 		rcd->fsc_write_time = nowt;
+		if (hdl->ra_tier) {
+			fsc_ra_invalidate (hdl->ra_tier, work_con_index, work_page_index, cob_block_index);
+		}
 
 		if (!(hdl->algo_apis.insert)) {
 			hdl->cache_cobs++;
@@ -1540,6 +2006,42 @@ fsc_cs_ac_cnt_inc (
 
 	return;
 }
+/*--------------------------------------------------------------------------------------
+	Function to increment access counts of the ranges of chunks
+----------------------------------------------------------------------------------------*/
+static void
+fsc_cs_ac_cnt_inc_bulk (
+	CsmgrdT_Access_Count* acs,					/* ranges of chunks which were hit		*/
+	int num										/* number of ranges						*/
+) {
+	unsigned char key[CefC_Max_Msg_Size];
+	int key_len;
+	uint32_t chunk_num;
+	int i;
+
+	/* Notifies the hits of all ranges in one pass under the lock 	*/
+	if (hdl->algo_apis.hit) {
+		pthread_mutex_lock (&fsc_cs_mutex);
+		for (i = 0 ; i < num ; i++) {
+			for (chunk_num = acs[i].first ; ; chunk_num++) {
+				key_len = csmgrd_name_chunknum_concatenate (
+							acs[i].name, acs[i].name_len, chunk_num, key);
+				(*(hdl->algo_apis.hit))(key, key_len);
+				if (chunk_num == acs[i].last) {
+					break;
+				}
+			}
+		}
+		pthread_mutex_unlock (&fsc_cs_mutex);
+	}
+
+	for (i = 0 ; i < num ; i++) {
+		csmgrd_stat_access_count_add (
+			csmgr_stat_hdl, acs[i].name, acs[i].name_len, acs[i].count);
+	}
+
+	return;
+}
 
 /*--------------------------------------------------------------------------------------
 	Read config file
@@ -1568,6 +2070,11 @@ fsc_config_read (
 	strcpy (params->algo_name, "None");
 	params->algo_name_size = 256;
 	params->algo_cob_size = 2048;
+	params->layout = FscC_Layout_Page;
+	params->seg_size = FscC_Seg_Size_Default;
+	params->ra_page_num = FscC_Ra_Page_Default;
+	params->persist_f = 0;
+	params->port_num = CefC_Default_Tcp_Prot;
 
 	/* Obtains the directory path where the csmgrd's config file is located. */
 #if 0 //+++++ GCC v9 +++++
@@ -1676,6 +2183,55 @@ fsc_config_read (
 				return (-1);
 			}
 			params->extend_lifetime = res * 1000llu;
+		} else if (strcmp (option, "CACHE_FILE_LAYOUT") == 0) {
+			if (strcmp (value, "page") == 0) {
+				params->layout = FscC_Layout_Page;
+			} else if (strcmp (value, "segment") == 0) {
+				params->layout = FscC_Layout_Segment;
+			} else {
+				csmgrd_log_write (CefC_Log_Error,
+					"CACHE_FILE_LAYOUT must be page or segment.\n");
+				fclose (fp);
+				return (-1);
+			}
+		} else if (strcmp (option, "CACHE_SEGMENT_SIZE") == 0) {
+			char *endptr = "";
+			uint64_t seg_size = strtoull (value, &endptr, 0);
+			if ((strcmp (endptr, "") != 0) ||
+				(seg_size < FscC_Seg_Size_Min) || (seg_size > FscC_Seg_Size_Max)) {
+				csmgrd_log_write (CefC_Log_Error,
+					"CACHE_SEGMENT_SIZE must be between %d and %d inclusive.\n",
+					FscC_Seg_Size_Min, FscC_Seg_Size_Max);
+				fclose (fp);
+				return (-1);
+			}
+			params->seg_size = (uint32_t) seg_size;
+		} else if (strcmp (option, "CACHE_READAHEAD_PAGES") == 0) {
+			res = atoi (value);
+			if (!(0 <= res && res <= FscC_Ra_Page_Max)) {
+				csmgrd_log_write (CefC_Log_Error,
+					"CACHE_READAHEAD_PAGES must be between 0 and %d inclusive.\n",
+					FscC_Ra_Page_Max);
+				fclose (fp);
+				return (-1);
+			}
+			params->ra_page_num = res;
+		} else if (strcmp (option, "CACHE_PERSISTENT_INDEX") == 0) {
+			if (strcmp (value, "yes") == 0) {
+				params->persist_f = 1;
+			} else if (strcmp (value, "no") == 0) {
+				params->persist_f = 0;
+			} else {
+				csmgrd_log_write (CefC_Log_Error,
+					"CACHE_PERSISTENT_INDEX must be yes or no.\n");
+				fclose (fp);
+				return (-1);
+			}
+		} else if (strcmp (option, "PORT_NUM") == 0) {
+			res = atoi (value);
+			if ((1024 < res) && (res < 65536)) {
+				params->port_num = (uint16_t) res;
+			}
 		} else {
 			/* NOP */;
 		}
@@ -1848,6 +2404,43 @@ fsc_cache_id_create (
 
 	return (fsc_id);
 }
+/*--------------------------------------------------------------------------------------
+	Opens the directory which keeps the cache files over the restart
+----------------------------------------------------------------------------------------*/
+static uint32_t						/* The return value is FSCID						*/
+fsc_cache_dir_open (
+	FscT_Cache_Handle* hdl,
+	uint16_t port_num							/* port of csmgrd						*/
+) {
+	char cache_path[CefC_Csmgr_File_Path_Length] = {0};
+	struct stat sb;
+
+	/* The name is fixed, so that the next csmgrd on the same port finds it 	*/
+	int rc = snprintf (cache_path, sizeof (cache_path),
+				"%s/csmgr_fsc_p%u", hdl->fsc_root_path, port_num);
+	if ((rc < 0) || (rc >= (int) sizeof (cache_path))) {
+		csmgrd_log_write (CefC_Log_Error, "Failed to cache_path name create\n");
+		return (0xFFFFFFFF);
+	}
+	if (stat (cache_path, &sb) == 0) {
+		if (!S_ISDIR (sb.st_mode)) {
+			csmgrd_log_write (CefC_Log_Error, "%s is not a directory\n", cache_path);
+			return (0xFFFFFFFF);
+		}
+	} else if (mkdir (cache_path, 0766) != 0) {
+		csmgrd_log_write (CefC_Log_Error,
+			"Failed to create the cache directory in %s\n", hdl->fsc_root_path);
+		if (errno == EACCES) {
+			csmgrd_log_write (CefC_Log_Error,
+				"Please make sure that you have write permission for %s.\n",
+				hdl->fsc_root_path);
+		}
+		return (0xFFFFFFFF);
+	}
+	strcpy (hdl->fsc_cache_path, cache_path);
+
+	return ((uint32_t) port_num);
+}
 /*--------------------------------------------------------------------------------------
 	delete file in this directory
 ----------------------------------------------------------------------------------------*/
@@ -1940,3 +2533,411 @@ fsc_recursive_dir_clear (
 
 	return (0);
 }
+/*--------------------------------------------------------------------------------------
+	Removes the cached Cobs of the content from the files
+----------------------------------------------------------------------------------------*/
+static void
+fsc_content_files_remove (
+	CsmgrT_Stat* rcd
+) {
+	char		file_path[PATH_MAX];
+	uint32_t	from, first, last;
+	uint32_t	seq;
+
+	if (hdl->ix) {
+		fsc_ix_content_del (hdl->ix, rcd->index);
+	}
+	if (hdl->seg_store == NULL) {
+		if (hdl->ra_tier) {
+			fsc_ra_invalidate (hdl->ra_tier, rcd->index, -1, 0);
+		}
+		sprintf (file_path, "%s/%d", hdl->fsc_cache_path, (int) rcd->index);
+		fsc_recursive_dir_clear (file_path);
+		return;
+	}
+
+	/* Removes the cached chunks from the index of the segment files 	*/
+	from = 0;
+	while (cef_chunk_set_range_next (&rcd->cob_set, from, &first, &last)) {
+		for (seq = first ; ; seq++) {
+			fsc_seg_remove (hdl->seg_store, rcd->index, seq);
+			if (seq == last) {
+				break;
+			}
+		}
+		if (last == UINT32_MAX) {
+			break;
+		}
+		from = last + 1;
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Restores the cached Cobs from the persistent index
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+fsc_ix_cache_restore (
+	void
+) {
+	FscT_Ix_Restore_State st;
+	FscT_Ix_Restore_Fn fn;
+	struct timeval tv;
+	uint64_t start_t;
+	DIR* dp;
+	struct dirent* ent;
+	char file_path[PATH_MAX];
+	char* endp;
+	unsigned long con_index;
+
+	memset (&st, 0, sizeof (FscT_Ix_Restore_State));
+	st.kept = (unsigned char*) calloc (CsmgrT_Stat_Max, sizeof (unsigned char));
+	if (st.kept == NULL) {
+		csmgrd_log_write (CefC_Log_Error, "Failed to get memory to restore the cache\n");
+		return (-1);
+	}
+	st.page_index = -1;
+	gettimeofday (&tv, NULL);
+	st.nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+	start_t = st.nowt;
+
+	memset (&fn, 0, sizeof (FscT_Ix_Restore_Fn));
+	fn.con_fn 	= fsc_ix_restore_content;
+	fn.cob_fn 	= fsc_ix_restore_cob;
+	fn.empty_fn = fsc_ix_restore_empty;
+	fn.arg 		= &st;
+	if (fsc_ix_restore (hdl->ix, &fn) < 0) {
+		csmgrd_log_write (CefC_Log_Warn,
+			"Failed to write the persistent index, the cache is not restored next time\n");
+	}
+
+	/* Removes the directories of the contents which were not restored 	*/
+	if (hdl->seg_store == NULL) {
+		dp = opendir (hdl->fsc_cache_path);
+		while ((dp) && ((ent = readdir (dp)) != NULL)) {
+			if ((ent->d_name[0] < '0') || (ent->d_name[0] > '9')) {
+				continue;
+			}
+			con_index = strtoul (ent->d_name, &endp, 10);
+			if ((*endp != 0x00) ||
+				((con_index < CsmgrT_Stat_Max) && (st.kept[con_index]))) {
+				continue;
+			}
+			snprintf (file_path, sizeof (file_path),
+				"%s/%s", hdl->fsc_cache_path, ent->d_name);
+			fsc_recursive_dir_clear (file_path);
+		}
+		if (dp) {
+			closedir (dp);
+		}
+	}
+	free (st.kept);
+
+	gettimeofday (&tv, NULL);
+	csmgrd_log_write (CefC_Log_Info,
+		"Restored cobs : "FMTU64" (%d ms)\n", st.num,
+		(int)((tv.tv_sec * 1000000llu + tv.tv_usec - start_t) / 1000));
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Restores the content from the persistent index
+----------------------------------------------------------------------------------------*/
+static int 							/* The return value is negative if it is dropped	*/
+fsc_ix_restore_content (
+	const FscT_Ix_Content* info,
+	const unsigned char* name,
+	const unsigned char* version,
+	void* arg
+) {
+	FscT_Ix_Restore_State* st = (FscT_Ix_Restore_State*) arg;
+	CsmgrT_Stat* rcd;
+	char file_path[PATH_MAX];
+	struct stat sb;
+
+	if (hdl->seg_store == NULL) {
+		sprintf (file_path, "%s/%d", hdl->fsc_cache_path, (int) info->con_index);
+		if ((stat (file_path, &sb) != 0) || (!S_ISDIR (sb.st_mode))) {
+			return (-1);
+		}
+	}
+
+	/* The index is kept since it is written in the cache files 	*/
+	rcd = csmgrd_stat_content_info_restore (
+			csmgr_stat_hdl, name, info->name_len, info->con_index);
+	if (rcd == NULL) {
+		return (-1);
+	}
+	if (csmgrd_stat_content_info_version_init (
+			csmgr_stat_hdl, rcd, (unsigned char*) version, info->ver_len) < 0) {
+		csmgrd_stat_content_info_delete (csmgr_stat_hdl, name, info->name_len);
+		return (-1);
+	}
+	rcd->file_msglen 	= info->file_msglen;
+	rcd->detect_chunkno = info->detect_chunkno;
+	rcd->cached_time 	= info->cached_time;
+	rcd->node 			= info->node;
+	fsc_ix_content_put (hdl->ix, rcd);
+	st->kept[info->con_index] = 1;
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Restores the Cob from the persistent index
+----------------------------------------------------------------------------------------*/
+static int 							/* The return value is negative if it is dropped	*/
+fsc_ix_restore_cob (
+	const FscT_Ix_Content* info,
+	const unsigned char* name,
+	const FscT_Ix_Cob* cob,
+	void* arg
+) {
+	FscT_Ix_Restore_State* st = (FscT_Ix_Restore_State*) arg;
+	CsmgrdT_Content_Entry entry;
+	FscT_Seg_Loc loc;
+	char file_path[PATH_MAX];
+	struct stat sb;
+	int page_index;
+	uint64_t rcd_end;
+
+	/* The Cobs over the capacity are dropped rather than evicted 	*/
+	if ((cob->expiry < st->nowt) || (st->num >= hdl->cache_capacity)) {
+		return (-1);
+	}
+	if (hdl->seg_store) {
+		loc.seg_id 	= cob->seg_id;
+		loc.offset 	= cob->offset;
+		loc.msg_len = cob->msg_len;
+		if (fsc_seg_restore (hdl->seg_store, info->con_index, cob->chunk_num, &loc) < 0) {
+			return (-1);
+		}
+	} else {
+		/* The record has to be in the page file 	*/
+		if ((cob->msg_len == 0) || (info->file_msglen < cob->msg_len)) {
+			return (-1);
+		}
+		page_index = cob->chunk_num / FscC_Page_Cob_Num / FscC_File_Page_Num;
+		if ((st->page_con != info->con_index) || (st->page_index != page_index)) {
+			sprintf (file_path, "%s/%d/%d",
+				hdl->fsc_cache_path, (int) info->con_index, page_index);
+			st->page_size = (stat (file_path, &sb) == 0) ? (uint64_t) sb.st_size : 0;
+			st->page_con 	= info->con_index;
+			st->page_index 	= page_index;
+		}
+		rcd_end = (uint64_t)(cob->chunk_num % (FscC_Page_Cob_Num * FscC_File_Page_Num) + 1)
+					* (sizeof (uint16_t) + info->file_msglen);
+		if (rcd_end > st->page_size) {
+			return (-1);
+		}
+	}
+
+	memset (&entry, 0, sizeof (CsmgrdT_Content_Entry));
+	entry.name 		 = (unsigned char*) name;
+	entry.name_len 	 = info->name_len;
+	entry.chunk_num  = cob->chunk_num;
+	entry.msg_len 	 = cob->msg_len;
+	entry.pay_len 	 = cob->pay_len;
+	entry.expiry 	 = cob->expiry;
+	entry.cache_time = info->cached_time;
+	entry.node 		 = info->node;
+	if (hdl->algo_apis.insert) {
+		(*(hdl->algo_apis.insert))(&entry);
+	} else {
+		hdl->cache_cobs++;
+	}
+	csmgrd_stat_cob_update (csmgr_stat_hdl, name, info->name_len,
+			cob->chunk_num, cob->pay_len, cob->expiry, info->cached_time, info->node);
+	fsc_ix_cob_put (hdl->ix, info->con_index, cob->chunk_num,
+			(hdl->seg_store) ? &loc : NULL, cob->msg_len, cob->pay_len, cob->expiry);
+	st->num++;
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the content none of whose Cobs was restored
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ix_restore_empty (
+	const FscT_Ix_Content* info,
+	const unsigned char* name,
+	void* arg
+) {
+	FscT_Ix_Restore_State* st = (FscT_Ix_Restore_State*) arg;
+	CsmgrT_Stat* rcd;
+
+	rcd = csmgrd_stat_content_info_get (csmgr_stat_hdl, name, info->name_len);
+	if (rcd) {
+		fsc_content_files_remove (rcd);
+		csmgrd_stat_content_info_delete (csmgr_stat_hdl, name, info->name_len);
+	}
+	st->kept[info->con_index] = 0;
+}
+/*--------------------------------------------------------------------------------------
+	Records the Cob written to the cache files in the persistent index
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ix_cob_record (
+	CsmgrT_Stat* rcd,
+	const CsmgrdT_Content_Entry* entry,
+	const FscT_Seg_Loc* loc,					/* NULL with the page files				*/
+	int con_f									/* records the content as well			*/
+) {
+	if (hdl->ix == NULL) {
+		return;
+	}
+	/* The content is recorded with its first Cob 	*/
+	if ((con_f) || (rcd->cob_num == 1)) {
+		fsc_ix_content_put (hdl->ix, rcd);
+	}
+	fsc_ix_cob_put (hdl->ix, rcd->index, entry->chunk_num, loc,
+		entry->msg_len, entry->pay_len, entry->expiry);
+}
+/*--------------------------------------------------------------------------------------
+	Sends the Cobs in the segment files
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_cob_send (
+	int sock,
+	uint32_t con_index,
+	const uint32_t* chunks,
+	int num
+) {
+	FscT_Seg_Loc		locs[FscC_Tx_Cob_Num];
+	FscT_Seg_Read_Buff*	rb;
+	uint32_t			start;
+	uint32_t			end;
+	uint32_t			rec_len;
+	int					found;
+	int					i, j, k;
+
+	found = fsc_seg_lookup (hdl->seg_store, con_index, chunks, num, locs);
+
+	for (i = 0 ; i < found ; i = j) {
+		/* Reads the records which are adjacent in a segment by one pread 	*/
+		start = locs[i].offset;
+		end = start + FscC_Seg_Rec_Head_Size + locs[i].msg_len;
+		for (j = i + 1 ; j < found ; j++) {
+			rec_len = FscC_Seg_Rec_Head_Size + locs[j].msg_len;
+			if ((locs[j].seg_id != locs[i].seg_id) || (locs[j].offset != end) ||
+				(end - start + rec_len > FscC_Seg_Read_Buff)) {
+				break;
+			}
+			end += rec_len;
+		}
+		rb = (FscT_Seg_Read_Buff*) malloc (sizeof (FscT_Seg_Read_Buff) + (end - start));
+		if (rb == NULL) {
+			continue;
+		}
+		rb->data = (unsigned char*) rb + sizeof (FscT_Seg_Read_Buff);
+		if (fsc_seg_read (hdl->seg_store, locs[i].seg_id, start, rb->data, end - start) < 0) {
+			csmgrd_log_write (CefC_Log_Error, "Failed to read the segment file\n");
+			free (rb);
+			continue;
+		}
+
+		/* Send Cobs to cefnetd, the buffer is freed after the last one was sent 	*/
+		rb->refcnt = j - i + 1;
+		for (k = i ; k < j ; k++) {
+			csmgrd_plugin_cob_msg_enqueue (sock,
+				&rb->data[locs[k].offset - start + FscC_Seg_Rec_Head_Size],
+				locs[k].msg_len, fsc_seg_read_buff_release, rb);
+		}
+		fsc_seg_read_buff_release (rb);
+	}
+	fsc_seg_unpin (hdl->seg_store, locs, found);
+}
+/*--------------------------------------------------------------------------------------
+	Sends the Cobs in a page which was read from a cache file
+----------------------------------------------------------------------------------------*/
+static void
+fsc_page_cob_send (
+	int sock,
+	const unsigned char* page,					/* Cobs with their length (uint16_t)	*/
+	int rcdsize,								/* size of one Cob in the page 			*/
+	const int* idx,								/* indexes of the Cobs to send (up to 	*/
+												/* FscC_Tx_Cob_Num)						*/
+	int num
+) {
+	FscT_Seg_Read_Buff*	rb;
+	uint16_t			mlen[FscC_Tx_Cob_Num];
+	size_t				total = 0;
+	size_t				off = 0;
+	int					i;
+
+	for (i = 0 ; i < num ; i++) {
+		memcpy (&mlen[i], &page[idx[i] * rcdsize], sizeof (uint16_t));
+		if ((mlen[i] <= CefC_S_Fix_Header) || (mlen[i] >= rcdsize)) {
+			mlen[i] = 0;
+		}
+		total += mlen[i];
+	}
+	if (total == 0) {
+		return;
+	}
+
+	/* The page is kept for the next request and overwritten, so the Cobs are 	*/
+	/* copied and sent through the output queue as the segment layout does 		*/
+	rb = (FscT_Seg_Read_Buff*) malloc (sizeof (FscT_Seg_Read_Buff) + total);
+	if (rb == NULL) {
+		return;
+	}
+	rb->data = (unsigned char*) rb + sizeof (FscT_Seg_Read_Buff);
+	rb->refcnt = num + 1;
+	for (i = 0 ; i < num ; i++) {
+		if (mlen[i] == 0) {
+			rb->refcnt--;
+			continue;
+		}
+		memcpy (&rb->data[off], &page[idx[i] * rcdsize + sizeof (uint16_t)], mlen[i]);
+		csmgrd_plugin_cob_msg_enqueue (sock,
+			&rb->data[off], mlen[i], fsc_seg_read_buff_release, rb);
+		off += mlen[i];
+	}
+	fsc_seg_read_buff_release (rb);
+}
+/*--------------------------------------------------------------------------------------
+	Releases the buffer which was read from a segment file
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_read_buff_release (
+	void* arg
+) {
+	FscT_Seg_Read_Buff* rb = (FscT_Seg_Read_Buff*) arg;
+
+	if (__atomic_sub_fetch (&rb->refcnt, 1, __ATOMIC_ACQ_REL) > 0) {
+		return;
+	}
+	free (rb);
+}
+/*--------------------------------------------------------------------------------------
+	Requests to read ahead the pages which follow the chunk
+----------------------------------------------------------------------------------------*/
+static void
+fsc_readahead_request (
+	CsmgrT_Stat* rcd,
+	uint32_t seqno,
+	int rcdsize
+) {
+	uint32_t	block;
+	uint32_t	first, last;
+	int			i;
+
+	/* min_seq and max_seq are not maintained by csmgrd, so the blocks are 	*/
+	/* bounded by the cached chunks 										*/
+	block = seqno / FscC_Page_Cob_Num;
+
+	for (i = 1 ; i <= hdl->ra_tier->page_num ; i++) {
+		if (block + i > UINT32_MAX / FscC_Page_Cob_Num) {
+			break;
+		}
+		if (!cef_chunk_set_range_next (
+				&rcd->cob_set, (block + i) * FscC_Page_Cob_Num, &first, &last)) {
+			break;
+		}
+		/* Skips the block which has no cached chunk 	*/
+		if (first / FscC_Page_Cob_Num != block + i) {
+			continue;
+		}
+		fsc_ra_request (hdl->ra_tier, rcd->index,
+			(int)((block + i) / FscC_File_Page_Num),
+			(int)((block + i) % FscC_File_Page_Num), rcdsize);
+	}
+}
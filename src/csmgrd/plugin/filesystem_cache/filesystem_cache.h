@@ -46,12 +46,22 @@
 #include <cefore/cef_rngque.h>
 #include <csmgrd/csmgrd_plugin.h>
 
+#include "fsc_segment.h"
+#include "fsc_readahead.h"
+#include "fsc_index.h"
+
 /****************************************************************************************
  Macros
  ****************************************************************************************/
 
 #define FscC_Max_Node_Inf_Num			1024			/* Max NodeInformation Num		*/
 
+/*------------------------------------------------------------------
+	Layout of the cache files
+--------------------------------------------------------------------*/
+#define FscC_Layout_Page				0				/* files per content and page	*/
+#define FscC_Layout_Segment				1				/* append-only segment files	*/
+
 /*------------------------------------------------------------------
 	Limitation
 --------------------------------------------------------------------*/
@@ -76,6 +86,13 @@ typedef struct {
 	uint64_t 		cache_capacity;				/* size of cache capacity 				*/
 
 	uint64_t 		extend_lifetime;			/* time to extend lifetime 				*/
+
+	int				layout;						/* layout of the cache files			*/
+	uint32_t		seg_size;					/* size of a segment file				*/
+	int				ra_page_num;				/* number of pages read ahead			*/
+	int				persist_f;					/* keeps the cache files and the index	*/
+												/* over the restart						*/
+	uint16_t		port_num;					/* port of csmgrd, names the directory	*/
 	
 } FscT_Config_Param;
 
@@ -109,6 +126,56 @@ typedef struct {
 	uint64_t		cache_capacity;
 	CefT_Mp_Handle	mem_rm_key;
 
+	/********** segment files **********/
+	FscT_Seg_Store*	seg_store;					/* NULL if FscC_Layout_Page is used		*/
+
+	/********** readahead of the page files **********/
+	FscT_Ra_Tier*	ra_tier;					/* NULL if readahead is disabled		*/
+
+	/********** persistent index **********/
+	FscT_Ix*		ix;							/* NULL if CACHE_PERSISTENT_INDEX is no	*/
+
 } FscT_Cache_Handle;
 
+/****************************************************************************************
+ Global Function Declaration
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Road the cache plugin
+----------------------------------------------------------------------------------------*/
+int
+csmgrd_filesystem_plugin_load (
+	CsmgrdT_Plugin_Interface* cs_in,
+	const char* config_dir
+);
+/*--------------------------------------------------------------------------------------
+	Sets the parameters used when the filesystem cache is the lower tier.
+	This function is called before the init API.
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_filesystem_plugin_tier_set (
+	const char* algo_name,						/* overrides CACHE_ALGORITHM			*/
+	void (*stored)(const CsmgrdT_Content_Entry*)
+												/* called with the Cob written			*/
+);
+/*--------------------------------------------------------------------------------------
+	Passes the Cob entry to the writer thread, the filesystem cache takes the
+	buffers of the entry
+----------------------------------------------------------------------------------------*/
+int 								/* The return value is negative if an error occurs	*/
+csmgrd_filesystem_plugin_entry_put (
+	CsmgrdT_Content_Entry* entry
+);
+/*--------------------------------------------------------------------------------------
+	Reads the cached Cob to the entry, the caller frees the buffers of the entry
+----------------------------------------------------------------------------------------*/
+int 								/* The return value is negative if an error occurs	*/
+csmgrd_filesystem_plugin_cob_read (
+	const unsigned char* name,					/* content name							*/
+	uint16_t name_len,							/* content name length					*/
+	uint32_t seqno,								/* chunk num							*/
+	CsmgrdT_Content_Entry* entry
+);
+
 #endif // __CSMGRD_FILESYSTEM_CACHE_HEADER__
@@ -0,0 +1,1322 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * fsc_index.c
+ */
+#define __CSMGRD_FSC_INDEX_SOURCE__
+
+/*
+	fsc_index.c keeps the index of the filesystem cache in a file, so that csmgrd
+	restarts with the Cobs left in the cache files. The changes of the contents and
+	the Cobs are appended to the file as records with CRC-32C. At the startup, the
+	file is mapped and the records up to the first broken one are folded into the
+	live contents and Cobs, which are restored and written to a new file. The file
+	is rewritten with the live records when it has grown to twice its size after
+	the last rewrite.
+*/
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "fsc_index.h"
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define FscC_Ix_Rec_Head_Size		sizeof (FscT_Ix_Rec_Head)
+#define FscC_Ix_Pad(_len)			(((_len) + 7) & ~((uint32_t) 7))
+#define FscC_Ix_Rec_Len(_len)		(FscC_Ix_Rec_Head_Size + FscC_Ix_Pad (_len))
+#define FscC_Ix_Content_Max			(sizeof (FscT_Ix_Content) + UINT16_MAX * 2)
+#define FscC_Ix_Out_Buff			262144		/* buffer to rewrite the index file		*/
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+/***** Output of the compaction *****/
+typedef struct {
+	int				fd;
+	unsigned char*	buff;
+	uint32_t		len;						/* bytes in the buffer					*/
+	uint64_t		size;						/* bytes written to the file			*/
+	uint64_t		nowt;
+	int				error_f;
+} FscT_Ix_Out;
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static uint32_t			fsc_ix_crc_table[256];
+static pthread_once_t	fsc_ix_crc_once = PTHREAD_ONCE_INIT;
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the table of CRC-32C
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ix_crc_init (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Updates CRC-32C with the bytes
+----------------------------------------------------------------------------------------*/
+static uint32_t
+fsc_ix_crc32c (
+	uint32_t crc,
+	const void* buff,
+	size_t len
+);
+/*--------------------------------------------------------------------------------------
+	Builds a record to the buffer
+----------------------------------------------------------------------------------------*/
+static uint32_t						/* length of the record								*/
+fsc_ix_rec_build (
+	uint16_t type,
+	const void* body,
+	uint32_t body_len,
+	unsigned char* buff
+);
+/*--------------------------------------------------------------------------------------
+	Builds the body of FscC_Ix_Rec_Content
+----------------------------------------------------------------------------------------*/
+static uint32_t						/* length of the body								*/
+fsc_ix_content_body (
+	const FscT_Ix_Content* info,
+	const unsigned char* name,
+	const unsigned char* version,
+	unsigned char* body
+);
+/*--------------------------------------------------------------------------------------
+	Appends a record to the index file
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ix_append (
+	FscT_Ix* ix,
+	uint16_t type,
+	const void* body,
+	uint32_t body_len
+);
+/*--------------------------------------------------------------------------------------
+	Writes all bytes to the file
+----------------------------------------------------------------------------------------*/
+static int 							/* The return value is negative if an error occurs	*/
+fsc_ix_write (
+	int fd,
+	const void* buff,
+	size_t len
+);
+/*--------------------------------------------------------------------------------------
+	Creates the new index file which has only the head
+----------------------------------------------------------------------------------------*/
+static int 							/* file descriptor, or negative if an error occurs	*/
+fsc_ix_file_create (
+	FscT_Ix* ix
+);
+/*--------------------------------------------------------------------------------------
+	Replaces the index file with the new index file
+----------------------------------------------------------------------------------------*/
+static int 							/* The return value is negative if an error occurs	*/
+fsc_ix_file_commit (
+	FscT_Ix* ix,
+	int fd
+);
+/*--------------------------------------------------------------------------------------
+	Creates the folded state
+----------------------------------------------------------------------------------------*/
+static FscT_Ix_Fold*
+fsc_ix_fold_create (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Destroys the folded state
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ix_fold_destroy (
+	FscT_Ix_Fold* fold
+);
+/*--------------------------------------------------------------------------------------
+	Folds the records, stops at the first broken record
+----------------------------------------------------------------------------------------*/
+static uint64_t						/* bytes of the folded records						*/
+fsc_ix_fold_records (
+	FscT_Ix_Fold* fold,
+	const unsigned char* recs,
+	uint64_t len
+);
+/*--------------------------------------------------------------------------------------
+	Folds a record
+----------------------------------------------------------------------------------------*/
+static int 							/* The return value is negative if it is invalid	*/
+fsc_ix_fold_record (
+	FscT_Ix_Fold* fold,
+	uint16_t type,
+	const unsigned char* body,
+	uint32_t len
+);
+/*--------------------------------------------------------------------------------------
+	Hash function of the Cob slots
+----------------------------------------------------------------------------------------*/
+static uint32_t
+fsc_ix_hash (
+	uint32_t con_index,
+	uint32_t chunk_num
+);
+/*--------------------------------------------------------------------------------------
+	Searches the Cob slots
+----------------------------------------------------------------------------------------*/
+static FscT_Ix_Slot*
+fsc_ix_slot_find (
+	FscT_Ix_Fold* fold,
+	uint32_t con_index,
+	uint32_t chunk_num
+);
+/*--------------------------------------------------------------------------------------
+	Adds the Cob to the slots
+----------------------------------------------------------------------------------------*/
+static FscT_Ix_Slot*
+fsc_ix_slot_add (
+	FscT_Ix_Fold* fold,
+	uint32_t con_index,
+	uint32_t chunk_num
+);
+/*--------------------------------------------------------------------------------------
+	Removes the Cob from the slots
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ix_slot_delete (
+	FscT_Ix_Fold* fold,
+	FscT_Ix_Slot* slot
+);
+/*--------------------------------------------------------------------------------------
+	Passes the live contents and Cobs to the functions
+----------------------------------------------------------------------------------------*/
+static int 							/* number of the Cobs accepted by the function		*/
+fsc_ix_walk (
+	FscT_Ix_Fold* fold,
+	const FscT_Ix_Restore_Fn* fn,
+	int empty_f									/* passes the contents without Cobs		*/
+);
+/*--------------------------------------------------------------------------------------
+	Compares the Cob slots by content and chunk
+----------------------------------------------------------------------------------------*/
+static int
+fsc_ix_slot_compare (
+	const void* a,
+	const void* b
+);
+/*--------------------------------------------------------------------------------------
+	Writes the content to the compacted index file
+----------------------------------------------------------------------------------------*/
+static int
+fsc_ix_out_content (
+	const FscT_Ix_Content* info,
+	const unsigned char* name,
+	const unsigned char* version,
+	void* arg
+);
+/*--------------------------------------------------------------------------------------
+	Writes the Cob to the compacted index file
+----------------------------------------------------------------------------------------*/
+static int
+fsc_ix_out_cob (
+	const FscT_Ix_Content* info,
+	const unsigned char* name,
+	const FscT_Ix_Cob* cob,
+	void* arg
+);
+/*--------------------------------------------------------------------------------------
+	Writes the record to the buffer of the compaction
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ix_out_write (
+	FscT_Ix_Out* out,
+	uint16_t type,
+	const void* body,
+	uint32_t body_len
+);
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the index handle and reads the index file left in the directory.
+	fold of the handle is NULL if the file was not found or does not match the
+	specified layout.
+----------------------------------------------------------------------------------------*/
+FscT_Ix*
+fsc_ix_open (
+	const char* dir_path,						/* directory of the index file			*/
+	int layout,									/* layout of the cache files			*/
+	uint32_t seg_size,							/* size of a segment file				*/
+	uint32_t page_cob_num,						/* number of the records in a block		*/
+	uint32_t file_page_num						/* number of the blocks in a page file	*/
+) {
+	FscT_Ix* ix;
+	char file_path[PATH_MAX + 32];
+	struct stat st;
+	unsigned char* map;
+	int fd;
+
+	pthread_once (&fsc_ix_crc_once, fsc_ix_crc_init);
+
+	ix = (FscT_Ix*) calloc (1, sizeof (FscT_Ix));
+	if (ix == NULL) {
+		return (NULL);
+	}
+	snprintf (ix->dir_path, sizeof (ix->dir_path), "%s", dir_path);
+	memcpy (ix->head.magic, FscC_Ix_Magic, sizeof (ix->head.magic));
+	ix->head.version 		= FscC_Ix_Version;
+	ix->head.layout 		= (uint32_t) layout;
+	ix->head.seg_size 		= seg_size;
+	ix->head.page_cob_num 	= page_cob_num;
+	ix->head.file_page_num 	= file_page_num;
+	ix->head.crc = fsc_ix_crc32c (0, &ix->head, offsetof (FscT_Ix_File_Head, crc));
+	ix->fd = -1;
+	pthread_mutex_init (&ix->mutex, NULL);
+
+	snprintf (file_path, sizeof (file_path), "%s/" FscC_Ix_Tmp_File_Name, dir_path);
+	unlink (file_path);
+
+	/* Reads the index file written before the restart 	*/
+	snprintf (file_path, sizeof (file_path), "%s/" FscC_Ix_File_Name, dir_path);
+	fd = open (file_path, O_RDONLY);
+	if (fd < 0) {
+		return (ix);
+	}
+	if ((fstat (fd, &st) != 0) || (st.st_size < (off_t) sizeof (FscT_Ix_File_Head))) {
+		close (fd);
+		return (ix);
+	}
+	map = (unsigned char*) mmap (NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd);
+	if (map == MAP_FAILED) {
+		return (ix);
+	}
+	if (memcmp (map, &ix->head, sizeof (FscT_Ix_File_Head)) == 0) {
+		ix->fold = fsc_ix_fold_create ();
+		if (ix->fold) {
+			fsc_ix_fold_records (ix->fold, map + sizeof (FscT_Ix_File_Head),
+				(uint64_t) st.st_size - sizeof (FscT_Ix_File_Head));
+		}
+	}
+	munmap (map, (size_t) st.st_size);
+
+	return (ix);
+}
+/*--------------------------------------------------------------------------------------
+	Starts a new index file and passes the contents and the Cobs read by
+	fsc_ix_open to the functions. The functions record what they restored with
+	fsc_ix_content_put and fsc_ix_cob_put.
+----------------------------------------------------------------------------------------*/
+int 								/* number of the restored Cobs, or negative			*/
+fsc_ix_restore (
+	FscT_Ix* ix,
+	const FscT_Ix_Restore_Fn* fn
+) {
+	int fd;
+	int num = 0;
+
+	fd = fsc_ix_file_create (ix);
+	if (fd < 0) {
+		return (-1);
+	}
+	pthread_mutex_lock (&ix->mutex);
+	ix->fd 	 = fd;
+	ix->size = sizeof (FscT_Ix_File_Head);
+	pthread_mutex_unlock (&ix->mutex);
+
+	/* The old index file is left until the restored records are written 	*/
+	if (ix->fold) {
+		num = fsc_ix_walk (ix->fold, fn, 0);
+		fsc_ix_fold_destroy (ix->fold);
+		ix->fold = NULL;
+	}
+
+	pthread_mutex_lock (&ix->mutex);
+	if ((ix->broken_f) || (fsc_ix_file_commit (ix, fd) < 0)) {
+		ix->broken_f = 1;
+		pthread_mutex_unlock (&ix->mutex);
+		return (-1);
+	}
+	ix->base_size = ix->size;
+	pthread_mutex_unlock (&ix->mutex);
+
+	return (num);
+}
+/*--------------------------------------------------------------------------------------
+	Closes the index handle, the index file is compacted before it is closed
+----------------------------------------------------------------------------------------*/
+void
+fsc_ix_close (
+	FscT_Ix* ix
+) {
+	char file_path[PATH_MAX + 32];
+
+	if (ix == NULL) {
+		return;
+	}
+	if ((ix->fd >= 0) && (!ix->broken_f)) {
+		fsc_ix_compact (ix, 1);
+		fsync (ix->fd);
+	}
+	if (ix->fd >= 0) {
+		close (ix->fd);
+	}
+	if (ix->broken_f) {
+		/* The cache files are not restored with the broken index file 	*/
+		snprintf (file_path, sizeof (file_path), "%s/" FscC_Ix_File_Name, ix->dir_path);
+		unlink (file_path);
+	}
+	if (ix->fold) {
+		fsc_ix_fold_destroy (ix->fold);
+	}
+	pthread_mutex_destroy (&ix->mutex);
+	free (ix);
+}
+/*--------------------------------------------------------------------------------------
+	Records the content
+----------------------------------------------------------------------------------------*/
+void
+fsc_ix_content_put (
+	FscT_Ix* ix,
+	const CsmgrT_Stat* rcd
+) {
+	FscT_Ix_Content info;
+	unsigned char* body;
+	uint32_t len;
+
+	body = (unsigned char*) malloc (FscC_Ix_Content_Max);
+	if (body == NULL) {
+		pthread_mutex_lock (&ix->mutex);
+		ix->broken_f = 1;
+		pthread_mutex_unlock (&ix->mutex);
+		return;
+	}
+	memset (&info, 0, sizeof (FscT_Ix_Content));
+	info.con_index 		= rcd->index;
+	info.name_len 		= rcd->name_len;
+	info.ver_len 		= rcd->ver_len;
+	info.file_msglen 	= rcd->file_msglen;
+	info.detect_chunkno = rcd->detect_chunkno;
+	info.cached_time 	= rcd->cached_time;
+	info.node 			= rcd->node;
+	len = fsc_ix_content_body (&info, rcd->name, rcd->version, body);
+	fsc_ix_append (ix, FscC_Ix_Rec_Content, body, len);
+	free (body);
+}
+/*--------------------------------------------------------------------------------------
+	Records that the content was removed
+----------------------------------------------------------------------------------------*/
+void
+fsc_ix_content_del (
+	FscT_Ix* ix,
+	uint32_t con_index
+) {
+	FscT_Ix_Key key;
+
+	key.con_index = con_index;
+	key.chunk_num = 0;
+	fsc_ix_append (ix, FscC_Ix_Rec_Content_Del, &key, sizeof (FscT_Ix_Key));
+}
+/*--------------------------------------------------------------------------------------
+	Records the Cob
+----------------------------------------------------------------------------------------*/
+void
+fsc_ix_cob_put (
+	FscT_Ix* ix,
+	uint32_t con_index,
+	uint32_t chunk_num,
+	const FscT_Seg_Loc* loc,					/* location in the segment files		*/
+	uint16_t msg_len,
+	uint16_t pay_len,
+	uint64_t expiry
+) {
+	FscT_Ix_Cob cob;
+
+	memset (&cob, 0, sizeof (FscT_Ix_Cob));
+	cob.con_index = con_index;
+	cob.chunk_num = chunk_num;
+	if (loc) {
+		cob.seg_id = loc->seg_id;
+		cob.offset = loc->offset;
+	}
+	cob.msg_len = msg_len;
+	cob.pay_len = pay_len;
+	cob.expiry 	= expiry;
+	fsc_ix_append (ix, FscC_Ix_Rec_Cob, &cob, sizeof (FscT_Ix_Cob));
+}
+/*--------------------------------------------------------------------------------------
+	Records that the Cob was removed
+----------------------------------------------------------------------------------------*/
+void
+fsc_ix_cob_del (
+	FscT_Ix* ix,
+	uint32_t con_index,
+	uint32_t chunk_num
+) {
+	FscT_Ix_Key key;
+
+	key.con_index = con_index;
+	key.chunk_num = chunk_num;
+	fsc_ix_append (ix, FscC_Ix_Rec_Cob_Del, &key, sizeof (FscT_Ix_Key));
+}
+/*--------------------------------------------------------------------------------------
+	Records that the Cob was moved by the compaction of the segment files.
+	This function is set to move_fn of the segment store.
+----------------------------------------------------------------------------------------*/
+void
+fsc_ix_cob_move (
+	void* arg,									/* index handle							*/
+	const FscT_Seg_Idx_Entry* entry
+) {
+	FscT_Ix_Cob cob;
+
+	memset (&cob, 0, sizeof (FscT_Ix_Cob));
+	cob.con_index = entry->con_index;
+	cob.chunk_num = entry->chunk_num;
+	cob.seg_id 	  = entry->seg_id;
+	cob.offset 	  = entry->offset;
+	cob.msg_len   = entry->msg_len;
+	fsc_ix_append ((FscT_Ix*) arg, FscC_Ix_Rec_Cob_Move, &cob, sizeof (FscT_Ix_Cob));
+}
+/*--------------------------------------------------------------------------------------
+	Rewrites the index file with the live records if it has grown enough.
+	Only the writer thread calls this function.
+----------------------------------------------------------------------------------------*/
+int 								/* Returns 1 if the index file was compacted		*/
+fsc_ix_compact (
+	FscT_Ix* ix,
+	int force_f									/* compacts regardless of the size		*/
+) {
+	FscT_Ix_Restore_Fn fn;
+	FscT_Ix_Fold* fold;
+	FscT_Ix_Out out;
+	struct timeval tv;
+	unsigned char* map;
+	uint64_t len;
+	uint64_t off;
+	ssize_t res;
+
+	pthread_mutex_lock (&ix->mutex);
+	if ((ix->fd < 0) || (ix->broken_f) ||
+		((!force_f) &&
+			((ix->size < FscC_Ix_Compact_Min) || (ix->size < ix->base_size * 2)))) {
+		pthread_mutex_unlock (&ix->mutex);
+		return (0);
+	}
+	len = ix->size;
+	pthread_mutex_unlock (&ix->mutex);
+
+	/* Folds the records written so far without the lock, the records which are 	*/
+	/* appended meanwhile are copied to the new file as they are 					*/
+	map = (unsigned char*) mmap (NULL, (size_t) len, PROT_READ, MAP_SHARED, ix->fd, 0);
+	if (map == MAP_FAILED) {
+		return (0);
+	}
+	fold = fsc_ix_fold_create ();
+	if (fold == NULL) {
+		munmap (map, (size_t) len);
+		return (0);
+	}
+	fsc_ix_fold_records (fold, map + sizeof (FscT_Ix_File_Head),
+		len - sizeof (FscT_Ix_File_Head));
+	munmap (map, (size_t) len);
+
+	memset (&out, 0, sizeof (FscT_Ix_Out));
+	out.buff = (unsigned char*) malloc (FscC_Ix_Out_Buff);
+	out.fd 	 = fsc_ix_file_create (ix);
+	if ((out.buff == NULL) || (out.fd < 0)) {
+		goto CompactError;
+	}
+	out.size = sizeof (FscT_Ix_File_Head);
+	gettimeofday (&tv, NULL);
+	out.nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+
+	memset (&fn, 0, sizeof (FscT_Ix_Restore_Fn));
+	fn.con_fn = fsc_ix_out_content;
+	fn.cob_fn = fsc_ix_out_cob;
+	fn.arg 	  = &out;
+	/* The contents without Cobs are kept for the Cobs appended meanwhile 	*/
+	fsc_ix_walk (fold, &fn, 1);
+	if ((out.len > 0) && (!out.error_f)) {
+		if (fsc_ix_write (out.fd, out.buff, out.len) < 0) {
+			out.error_f = 1;
+		}
+		out.size += out.len;
+		out.len = 0;
+	}
+	if (out.error_f) {
+		goto CompactError;
+	}
+
+	pthread_mutex_lock (&ix->mutex);
+	/* Copies the records appended while the records were folded 	*/
+	for (off = len ; off < ix->size ; off += (uint64_t) res) {
+		res = pread (ix->fd, out.buff, FscC_Ix_Out_Buff, (off_t) off);
+		if ((res <= 0) || (fsc_ix_write (out.fd, out.buff, (size_t) res) < 0)) {
+			pthread_mutex_unlock (&ix->mutex);
+			goto CompactError;
+		}
+		out.size += (uint64_t) res;
+	}
+	if (fsc_ix_file_commit (ix, out.fd) < 0) {
+		pthread_mutex_unlock (&ix->mutex);
+		goto CompactError;
+	}
+	close (ix->fd);
+	ix->fd 		  = out.fd;
+	ix->size 	  = out.size;
+	ix->base_size = out.size;
+	ix->compact_num++;
+	pthread_mutex_unlock (&ix->mutex);
+
+	free (out.buff);
+	fsc_ix_fold_destroy (fold);
+	return (1);
+
+CompactError:
+	if (out.fd >= 0) {
+		char file_path[PATH_MAX + 32];
+		close (out.fd);
+		snprintf (file_path, sizeof (file_path), "%s/" FscC_Ix_Tmp_File_Name, ix->dir_path);
+		unlink (file_path);
+	}
+	if (out.buff) {
+		free (out.buff);
+	}
+	fsc_ix_fold_destroy (fold);
+	return (0);
+}
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the table of CRC-32C
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ix_crc_init (
+	void
+) {
+	uint32_t c;
+	int i, n;
+
+	for (i = 0 ; i < 256 ; i++) {
+		c = (uint32_t) i;
+		for (n = 0 ; n < 8 ; n++) {
+			c = (c & 1) ? ((c >> 1) ^ 0x82F63B78) : (c >> 1);
+		}
+		fsc_ix_crc_table[i] = c;
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Updates CRC-32C with the bytes
+----------------------------------------------------------------------------------------*/
+static uint32_t
+fsc_ix_crc32c (
+	uint32_t crc,
+	const void* buff,
+	size_t len
+) {
+	const unsigned char* p = (const unsigned char*) buff;
+
+	crc = ~crc;
+	while (len--) {
+		crc = fsc_ix_crc_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+	}
+	return (~crc);
+}
+/*--------------------------------------------------------------------------------------
+	Builds a record to the buffer
+----------------------------------------------------------------------------------------*/
+static uint32_t						/* length of the record								*/
+fsc_ix_rec_build (
+	uint16_t type,
+	const void* body,
+	uint32_t body_len,
+	unsigned char* buff
+) {
+	FscT_Ix_Rec_Head rh;
+
+	memset (&rh, 0, sizeof (FscT_Ix_Rec_Head));
+	rh.len 	= body_len;
+	rh.type = type;
+	rh.crc 	= fsc_ix_crc32c (0, &rh, offsetof (FscT_Ix_Rec_Head, crc));
+	rh.crc 	= fsc_ix_crc32c (rh.crc, body, body_len);
+
+	memcpy (buff, &rh, FscC_Ix_Rec_Head_Size);
+	memcpy (&buff[FscC_Ix_Rec_Head_Size], body, body_len);
+	memset (&buff[FscC_Ix_Rec_Head_Size + body_len], 0, FscC_Ix_Pad (body_len) - body_len);
+
+	return ((uint32_t) FscC_Ix_Rec_Len (body_len));
+}
+/*--------------------------------------------------------------------------------------
+	Builds the body of FscC_Ix_Rec_Content
+----------------------------------------------------------------------------------------*/
+static uint32_t						/* length of the body								*/
+fsc_ix_content_body (
+	const FscT_Ix_Content* info,
+	const unsigned char* name,
+	const unsigned char* version,
+	unsigned char* body
+) {
+	uint32_t len = sizeof (FscT_Ix_Content);
+
+	memcpy (body, info, sizeof (FscT_Ix_Content));
+	memcpy (&body[len], name, info->name_len);
+	len += info->name_len;
+	if (info->ver_len) {
+		memcpy (&body[len], version, info->ver_len);
+		len += info->ver_len;
+	}
+	return (len);
+}
+/*--------------------------------------------------------------------------------------
+	Appends a record to the index file
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ix_append (
+	FscT_Ix* ix,
+	uint16_t type,
+	const void* body,
+	uint32_t body_len
+) {
+	unsigned char sbuff[FscC_Ix_Rec_Len (sizeof (FscT_Ix_Cob))];
+	unsigned char* buff = sbuff;
+	uint32_t len;
+
+	if (FscC_Ix_Rec_Len (body_len) > sizeof (sbuff)) {
+		buff = (unsigned char*) malloc (FscC_Ix_Rec_Len (body_len));
+		if (buff == NULL) {
+			pthread_mutex_lock (&ix->mutex);
+			ix->broken_f = 1;
+			pthread_mutex_unlock (&ix->mutex);
+			return;
+		}
+	}
+	len = fsc_ix_rec_build (type, body, body_len, buff);
+
+	pthread_mutex_lock (&ix->mutex);
+	if ((ix->fd >= 0) && (!ix->broken_f)) {
+		/* A record which was not written can not be recovered, so the index 	*/
+		/* file is no longer written 											*/
+		if (fsc_ix_write (ix->fd, buff, len) < 0) {
+			ix->broken_f = 1;
+		} else {
+			ix->size += len;
+		}
+	}
+	pthread_mutex_unlock (&ix->mutex);
+
+	if (buff != sbuff) {
+		free (buff);
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Writes all bytes to the file
+----------------------------------------------------------------------------------------*/
+static int 							/* The return value is negative if an error occurs	*/
+fsc_ix_write (
+	int fd,
+	const void* buff,
+	size_t len
+) {
+	const unsigned char* p = (const unsigned char*) buff;
+	size_t written = 0;
+	ssize_t res;
+
+	while (written < len) {
+		res = write (fd, &p[written], len - written);
+		if (res < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return (-1);
+		}
+		written += (size_t) res;
+	}
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Creates the new index file which has only the head
+----------------------------------------------------------------------------------------*/
+static int 							/* file descriptor, or negative if an error occurs	*/
+fsc_ix_file_create (
+	FscT_Ix* ix
+) {
+	char file_path[PATH_MAX + 32];
+	int fd;
+
+	snprintf (file_path, sizeof (file_path), "%s/" FscC_Ix_Tmp_File_Name, ix->dir_path);
+	fd = open (file_path, O_RDWR | O_CREAT | O_TRUNC | O_APPEND, 0644);
+	if (fd < 0) {
+		return (-1);
+	}
+	if (fsc_ix_write (fd, &ix->head, sizeof (FscT_Ix_File_Head)) < 0) {
+		close (fd);
+		unlink (file_path);
+		return (-1);
+	}
+	return (fd);
+}
+/*--------------------------------------------------------------------------------------
+	Replaces the index file with the new index file
+----------------------------------------------------------------------------------------*/
+static int 							/* The return value is negative if an error occurs	*/
+fsc_ix_file_commit (
+	FscT_Ix* ix,
+	int fd
+) {
+	char tmp_path[PATH_MAX + 32];
+	char file_path[PATH_MAX + 32];
+	int dir_fd;
+
+	/* The new file is complete on the disk before it replaces the old one 	*/
+	if (fsync (fd) != 0) {
+		return (-1);
+	}
+	snprintf (tmp_path, sizeof (tmp_path), "%s/" FscC_Ix_Tmp_File_Name, ix->dir_path);
+	snprintf (file_path, sizeof (file_path), "%s/" FscC_Ix_File_Name, ix->dir_path);
+	if (rename (tmp_path, file_path) != 0) {
+		return (-1);
+	}
+	dir_fd = open (ix->dir_path, O_RDONLY);
+	if (dir_fd >= 0) {
+		fsync (dir_fd);
+		close (dir_fd);
+	}
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Creates the folded state
+----------------------------------------------------------------------------------------*/
+static FscT_Ix_Fold*
+fsc_ix_fold_create (
+	void
+) {
+	FscT_Ix_Fold* fold;
+
+	fold = (FscT_Ix_Fold*) calloc (1, sizeof (FscT_Ix_Fold));
+	if (fold == NULL) {
+		return (NULL);
+	}
+	fold->cons 	= (FscT_Ix_Con**) calloc (CsmgrT_Stat_Max, sizeof (FscT_Ix_Con*));
+	fold->slots = (FscT_Ix_Slot*) calloc (FscC_Ix_Slot_Init_Size, sizeof (FscT_Ix_Slot));
+	if ((fold->cons == NULL) || (fold->slots == NULL)) {
+		fsc_ix_fold_destroy (fold);
+		return (NULL);
+	}
+	fold->slot_max = FscC_Ix_Slot_Init_Size;
+
+	return (fold);
+}
+/*--------------------------------------------------------------------------------------
+	Destroys the folded state
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ix_fold_destroy (
+	FscT_Ix_Fold* fold
+) {
+	uint32_t i;
+
+	if (fold == NULL) {
+		return;
+	}
+	if (fold->cons) {
+		for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
+			if (fold->cons[i]) {
+				free (fold->cons[i]);
+			}
+		}
+		free (fold->cons);
+	}
+	if (fold->slots) {
+		free (fold->slots);
+	}
+	free (fold);
+}
+/*--------------------------------------------------------------------------------------
+	Folds the records, stops at the first broken record
+----------------------------------------------------------------------------------------*/
+static uint64_t						/* bytes of the folded records						*/
+fsc_ix_fold_records (
+	FscT_Ix_Fold* fold,
+	const unsigned char* recs,
+	uint64_t len
+) {
+	FscT_Ix_Rec_Head rh;
+	uint64_t off = 0;
+	uint64_t rec_len;
+	uint32_t crc;
+
+	while (off + FscC_Ix_Rec_Head_Size <= len) {
+		memcpy (&rh, &recs[off], FscC_Ix_Rec_Head_Size);
+		/* The length is checked before it is padded, since the padding of a 	*/
+		/* broken length wraps in 32 bits 										*/
+		if ((uint64_t) rh.len > len - off - FscC_Ix_Rec_Head_Size) {
+			break;
+		}
+		rec_len = FscC_Ix_Rec_Head_Size + (((uint64_t) rh.len + 7) & ~((uint64_t) 7));
+		if (rec_len > len - off) {
+			break;
+		}
+		crc = fsc_ix_crc32c (0, &rh, offsetof (FscT_Ix_Rec_Head, crc));
+		crc = fsc_ix_crc32c (crc, &recs[off + FscC_Ix_Rec_Head_Size], rh.len);
+		if (crc != rh.crc) {
+			break;
+		}
+		if (fsc_ix_fold_record (
+				fold, rh.type, &recs[off + FscC_Ix_Rec_Head_Size], rh.len) < 0) {
+			break;
+		}
+		off += rec_len;
+	}
+	return (off);
+}
+/*--------------------------------------------------------------------------------------
+	Folds a record
+----------------------------------------------------------------------------------------*/
+static int 							/* The return value is negative if it is invalid	*/
+fsc_ix_fold_record (
+	FscT_Ix_Fold* fold,
+	uint16_t type,
+	const unsigned char* body,
+	uint32_t len
+) {
+	FscT_Ix_Content info;
+	FscT_Ix_Cob cob;
+	FscT_Ix_Key key;
+	FscT_Ix_Con* con;
+	FscT_Ix_Con* new_con;
+	FscT_Ix_Slot* slot;
+
+	switch (type) {
+		case FscC_Ix_Rec_Content: {
+			if (len < sizeof (FscT_Ix_Content)) {
+				return (-1);
+			}
+			memcpy (&info, body, sizeof (FscT_Ix_Content));
+			if ((info.con_index >= CsmgrT_Stat_Max) || (info.name_len == 0) ||
+				(len != sizeof (FscT_Ix_Content) + info.name_len + info.ver_len)) {
+				return (-1);
+			}
+			new_con = (FscT_Ix_Con*) malloc (
+				sizeof (FscT_Ix_Con) + info.name_len + info.ver_len);
+			if (new_con == NULL) {
+				return (-1);
+			}
+			memset (new_con, 0, sizeof (FscT_Ix_Con));
+			new_con->info = info;
+			memcpy (new_con->data, &body[sizeof (FscT_Ix_Content)], info.name_len + info.ver_len);
+
+			/* The Cobs are kept if the same content is recorded again 	*/
+			con = fold->cons[info.con_index];
+			if ((con) && (con->info.name_len == info.name_len) &&
+				(memcmp (con->data, new_con->data, info.name_len) == 0)) {
+				new_con->gen 	 = con->gen;
+				new_con->cob_num = con->cob_num;
+			} else {
+				new_con->gen = ++fold->gen;
+			}
+			if (con) {
+				free (con);
+			}
+			fold->cons[info.con_index] = new_con;
+			break;
+		}
+		case FscC_Ix_Rec_Content_Del: {
+			if (len != sizeof (FscT_Ix_Key)) {
+				return (-1);
+			}
+			memcpy (&key, body, sizeof (FscT_Ix_Key));
+			if (key.con_index >= CsmgrT_Stat_Max) {
+				return (-1);
+			}
+			if (fold->cons[key.con_index]) {
+				free (fold->cons[key.con_index]);
+				fold->cons[key.con_index] = NULL;
+			}
+			break;
+		}
+		case FscC_Ix_Rec_Cob:
+		case FscC_Ix_Rec_Cob_Move: {
+			if (len != sizeof (FscT_Ix_Cob)) {
+				return (-1);
+			}
+			memcpy (&cob, body, sizeof (FscT_Ix_Cob));
+			if (cob.con_index >= CsmgrT_Stat_Max) {
+				return (-1);
+			}
+			con  = fold->cons[cob.con_index];
+			slot = fsc_ix_slot_find (fold, cob.con_index, cob.chunk_num);
+			if (type == FscC_Ix_Rec_Cob_Move) {
+				if (slot) {
+					slot->cob.seg_id = cob.seg_id;
+					slot->cob.offset = cob.offset;
+				}
+				break;
+			}
+			if (con == NULL) {
+				break;
+			}
+			if (slot == NULL) {
+				slot = fsc_ix_slot_add (fold, cob.con_index, cob.chunk_num);
+				if (slot == NULL) {
+					return (-1);
+				}
+				con->cob_num++;
+			} else if (slot->gen != con->gen) {
+				con->cob_num++;
+			}
+			slot->cob = cob;
+			slot->gen = con->gen;
+			break;
+		}
+		case FscC_Ix_Rec_Cob_Del: {
+			if (len != sizeof (FscT_Ix_Key)) {
+				return (-1);
+			}
+			memcpy (&key, body, sizeof (FscT_Ix_Key));
+			if (key.con_index >= CsmgrT_Stat_Max) {
+				return (-1);
+			}
+			slot = fsc_ix_slot_find (fold, key.con_index, key.chunk_num);
+			if (slot == NULL) {
+				break;
+			}
+			con = fold->cons[key.con_index];
+			if ((con) && (slot->gen == con->gen)) {
+				con->cob_num--;
+			}
+			fsc_ix_slot_delete (fold, slot);
+			break;
+		}
+		default: {
+			return (-1);
+		}
+	}
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Hash function of the Cob slots
+----------------------------------------------------------------------------------------*/
+static uint32_t
+fsc_ix_hash (
+	uint32_t con_index,
+	uint32_t chunk_num
+) {
+	uint64_t h = ((uint64_t) con_index << 32) | chunk_num;
+
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdllu;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53llu;
+	h ^= h >> 33;
+
+	return ((uint32_t) h);
+}
+/*--------------------------------------------------------------------------------------
+	Searches the Cob slots
+----------------------------------------------------------------------------------------*/
+static FscT_Ix_Slot*
+fsc_ix_slot_find (
+	FscT_Ix_Fold* fold,
+	uint32_t con_index,
+	uint32_t chunk_num
+) {
+	uint32_t mask = fold->slot_max - 1;
+	uint32_t i;
+
+	i = fsc_ix_hash (con_index, chunk_num) & mask;
+	while (fold->slots[i].used_f) {
+		if ((fold->slots[i].cob.con_index == con_index) &&
+			(fold->slots[i].cob.chunk_num == chunk_num)) {
+			return (&fold->slots[i]);
+		}
+		i = (i + 1) & mask;
+	}
+	return (NULL);
+}
+/*--------------------------------------------------------------------------------------
+	Adds the Cob to the slots
+----------------------------------------------------------------------------------------*/
+static FscT_Ix_Slot*
+fsc_ix_slot_add (
+	FscT_Ix_Fold* fold,
+	uint32_t con_index,
+	uint32_t chunk_num
+) {
+	FscT_Ix_Slot* new_slots;
+	uint32_t new_max;
+	uint32_t mask;
+	uint32_t i, n;
+
+	/* Keeps the load factor under 3/4 	*/
+	if ((fold->slot_num + 1) * 4 > fold->slot_max * 3) {
+		new_max = fold->slot_max * 2;
+		if (new_max < fold->slot_max) {
+			return (NULL);
+		}
+		new_slots = (FscT_Ix_Slot*) calloc (new_max, sizeof (FscT_Ix_Slot));
+		if (new_slots == NULL) {
+			return (NULL);
+		}
+		mask = new_max - 1;
+		for (n = 0 ; n < fold->slot_max ; n++) {
+			if (fold->slots[n].used_f == 0) {
+				continue;
+			}
+			i = fsc_ix_hash (fold->slots[n].cob.con_index,
+					fold->slots[n].cob.chunk_num) & mask;
+			while (new_slots[i].used_f) {
+				i = (i + 1) & mask;
+			}
+			new_slots[i] = fold->slots[n];
+		}
+		free (fold->slots);
+		fold->slots 	= new_slots;
+		fold->slot_max 	= new_max;
+	}
+	mask = fold->slot_max - 1;
+	i = fsc_ix_hash (con_index, chunk_num) & mask;
+	while (fold->slots[i].used_f) {
+		i = (i + 1) & mask;
+	}
+	memset (&fold->slots[i], 0, sizeof (FscT_Ix_Slot));
+	fold->slots[i].cob.con_index = con_index;
+	fold->slots[i].cob.chunk_num = chunk_num;
+	fold->slots[i].used_f = 1;
+	fold->slot_num++;
+
+	return (&fold->slots[i]);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the Cob from the slots
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ix_slot_delete (
+	FscT_Ix_Fold* fold,
+	FscT_Ix_Slot* slot
+) {
+	uint32_t mask = fold->slot_max - 1;
+	uint32_t i;
+	uint32_t j;
+	uint32_t k;
+
+	/* Shifts back the following slots instead of leaving a tombstone 	*/
+	i = (uint32_t)(slot - fold->slots);
+	j = i;
+	while (1) {
+		j = (j + 1) & mask;
+		if (fold->slots[j].used_f == 0) {
+			break;
+		}
+		k = fsc_ix_hash (fold->slots[j].cob.con_index, fold->slots[j].cob.chunk_num) & mask;
+		if ((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j))) {
+			continue;
+		}
+		fold->slots[i] = fold->slots[j];
+		i = j;
+	}
+	memset (&fold->slots[i], 0, sizeof (FscT_Ix_Slot));
+	fold->slot_num--;
+}
+/*--------------------------------------------------------------------------------------
+	Passes the live contents and Cobs to the functions
+----------------------------------------------------------------------------------------*/
+static int 							/* number of the Cobs accepted by the function		*/
+fsc_ix_walk (
+	FscT_Ix_Fold* fold,
+	const FscT_Ix_Restore_Fn* fn,
+	int empty_f									/* passes the contents without Cobs		*/
+) {
+	FscT_Ix_Slot** list;
+	FscT_Ix_Con* con;
+	uint32_t i, n;
+	int num = 0;
+
+	/* All contents are passed before the Cobs, so that the indexes of the 	*/
+	/* contents are taken before the Cobs are restored 						*/
+	for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
+		con = fold->cons[i];
+		if (con == NULL) {
+			continue;
+		}
+		con->restored = 0;
+		con->drop_f = 0;
+		if (((con->cob_num == 0) && (!empty_f)) ||
+			((*fn->con_fn)(&con->info, con->data,
+				&con->data[con->info.name_len], fn->arg) < 0)) {
+			con->drop_f = 1;
+		}
+	}
+
+	/* Passes the Cobs in order of the contents and the chunks 	*/
+	list = (FscT_Ix_Slot**) malloc (sizeof (FscT_Ix_Slot*) * (fold->slot_num + 1));
+	if (list == NULL) {
+		return (0);
+	}
+	for (i = 0, n = 0 ; i < fold->slot_max ; i++) {
+		if (fold->slots[i].used_f == 0) {
+			continue;
+		}
+		con = fold->cons[fold->slots[i].cob.con_index];
+		if ((con == NULL) || (con->drop_f) || (con->gen != fold->slots[i].gen)) {
+			continue;
+		}
+		list[n] = &fold->slots[i];
+		n++;
+	}
+	qsort (list, n, sizeof (FscT_Ix_Slot*), fsc_ix_slot_compare);
+
+	for (i = 0 ; i < n ; i++) {
+		con = fold->cons[list[i]->cob.con_index];
+		if ((*fn->cob_fn)(&con->info, con->data, &list[i]->cob, fn->arg) == 0) {
+			con->restored++;
+			num++;
+		}
+	}
+	free (list);
+
+	if (fn->empty_fn) {
+		for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
+			con = fold->cons[i];
+			if ((con) && (!con->drop_f) && (con->restored == 0)) {
+				(*fn->empty_fn)(&con->info, con->data, fn->arg);
+			}
+		}
+	}
+	return (num);
+}
+/*--------------------------------------------------------------------------------------
+	Compares the Cob slots by content and chunk
+----------------------------------------------------------------------------------------*/
+static int
+fsc_ix_slot_compare (
+	const void* a,
+	const void* b
+) {
+	const FscT_Ix_Cob* ca = &(*(FscT_Ix_Slot* const*) a)->cob;
+	const FscT_Ix_Cob* cb = &(*(FscT_Ix_Slot* const*) b)->cob;
+
+	if (ca->con_index != cb->con_index) {
+		return ((ca->con_index < cb->con_index) ? -1 : 1);
+	}
+	if (ca->chunk_num != cb->chunk_num) {
+		return ((ca->chunk_num < cb->chunk_num) ? -1 : 1);
+	}
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Writes the content to the compacted index file
+----------------------------------------------------------------------------------------*/
+static int
+fsc_ix_out_content (
+	const FscT_Ix_Content* info,
+	const unsigned char* name,
+	const unsigned char* version,
+	void* arg
+) {
+	FscT_Ix_Out* out = (FscT_Ix_Out*) arg;
+	unsigned char* body;
+	uint32_t len;
+
+	body = (unsigned char*) malloc (FscC_Ix_Content_Max);
+	if (body == NULL) {
+		out->error_f = 1;
+		return (-1);
+	}
+	len = fsc_ix_content_body (info, name, version, body);
+	fsc_ix_out_write (out, FscC_Ix_Rec_Content, body, len);
+	free (body);
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Writes the Cob to the compacted index file
+----------------------------------------------------------------------------------------*/
+static int
+fsc_ix_out_cob (
+	const FscT_Ix_Content* info,
+	const unsigned char* name,
+	const FscT_Ix_Cob* cob,
+	void* arg
+) {
+	FscT_Ix_Out* out = (FscT_Ix_Out*) arg;
+
+	/* The expired Cobs are removed by csmgrd soon 	*/
+	if (cob->expiry < out->nowt) {
+		return (-1);
+	}
+	fsc_ix_out_write (out, FscC_Ix_Rec_Cob, cob, sizeof (FscT_Ix_Cob));
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Writes the record to the buffer of the compaction
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ix_out_write (
+	FscT_Ix_Out* out,
+	uint16_t type,
+	const void* body,
+	uint32_t body_len
+) {
+	if (out->error_f) {
+		return;
+	}
+	if (out->len + FscC_Ix_Rec_Len (body_len) > FscC_Ix_Out_Buff) {
+		if (fsc_ix_write (out->fd, out->buff, out->len) < 0) {
+			out->error_f = 1;
+			return;
+		}
+		out->size += out->len;
+		out->len = 0;
+	}
+	out->len += fsc_ix_rec_build (type, body, body_len, &out->buff[out->len]);
+}
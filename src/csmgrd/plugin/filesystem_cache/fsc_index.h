@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * fsc_index.h
+ */
+#ifndef __CSMGRD_FSC_INDEX_HEADER__
+#define __CSMGRD_FSC_INDEX_HEADER__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#include <limits.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <netinet/in.h>
+
+#include <cefore/cef_csmgr_stat.h>
+
+#include "fsc_segment.h"
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define FscC_Ix_File_Name			"fsc_index"		/* Name of the index file			*/
+#define FscC_Ix_Tmp_File_Name		"fsc_index.new"	/* Index file being rewritten		*/
+#define FscC_Ix_Magic				"CEFFSCIX"
+#define FscC_Ix_Version				1
+#define FscC_Ix_Compact_Min			16777216	/* Min size of the index file which		*/
+												/* is compacted (16MB)					*/
+#define FscC_Ix_Slot_Init_Size		65536		/* Initial number of the Cob slots		*/
+
+/*------------------------------------------------------------------
+	Type of the record
+--------------------------------------------------------------------*/
+#define FscC_Ix_Rec_Content			1			/* content is cached					*/
+#define FscC_Ix_Rec_Content_Del		2			/* content is removed					*/
+#define FscC_Ix_Rec_Cob				3			/* Cob is cached						*/
+#define FscC_Ix_Rec_Cob_Del			4			/* Cob is removed						*/
+#define FscC_Ix_Rec_Cob_Move		5			/* Cob is moved by the compaction		*/
+
+/****************************************************************************************
+ Structure Declarations
+ ****************************************************************************************/
+
+/***** Head of the index file *****/
+typedef struct {
+	char			magic[8];
+	uint32_t		version;
+	uint32_t		layout;						/* layout of the cache files			*/
+	uint32_t		seg_size;					/* size of a segment file				*/
+	uint32_t		page_cob_num;				/* number of the records in a block		*/
+	uint32_t		file_page_num;				/* number of the blocks in a page file	*/
+	uint32_t		crc;						/* CRC-32C of the above fields			*/
+} FscT_Ix_File_Head;
+
+/***** Head of a record, the body is padded to 8 bytes *****/
+typedef struct {
+	uint32_t		len;						/* length of the body					*/
+	uint16_t		type;
+	uint16_t		reserve;
+	uint32_t		crc;						/* CRC-32C of len, type and the body	*/
+	uint32_t		reserve2;
+} FscT_Ix_Rec_Head;
+
+/***** Body of FscC_Ix_Rec_Content, the name and the version follow *****/
+typedef struct {
+	uint32_t		con_index;					/* index of the content in csmgr_stat	*/
+	uint16_t		name_len;
+	uint16_t		ver_len;
+	uint32_t		file_msglen;				/* size of a record in the page files	*/
+	uint32_t		detect_chunkno;
+	uint64_t		cached_time;
+	struct in_addr	node;
+	uint32_t		reserve;
+} FscT_Ix_Content;
+
+/***** Body of FscC_Ix_Rec_Cob and FscC_Ix_Rec_Cob_Move *****/
+typedef struct {
+	uint32_t		con_index;
+	uint32_t		chunk_num;
+	uint32_t		seg_id;						/* location in the segment files,		*/
+	uint32_t		offset;						/* not used with the page files			*/
+	uint16_t		msg_len;
+	uint16_t		pay_len;
+	uint32_t		reserve;
+	uint64_t		expiry;
+} FscT_Ix_Cob;
+
+/***** Body of FscC_Ix_Rec_Content_Del and FscC_Ix_Rec_Cob_Del *****/
+typedef struct {
+	uint32_t		con_index;
+	uint32_t		chunk_num;					/* not used with FscC_Ix_Rec_Content_Del*/
+} FscT_Ix_Key;
+
+/***** Content read from the index file *****/
+typedef struct {
+	FscT_Ix_Content	info;
+	uint32_t		gen;						/* generation of the content			*/
+	uint32_t		cob_num;					/* number of the Cobs in the slots		*/
+	int				drop_f;						/* not restored							*/
+	uint32_t		restored;					/* number of the restored Cobs			*/
+	unsigned char	data[1];					/* name and version						*/
+} FscT_Ix_Con;
+
+/***** Slot of the Cobs read from the index file *****/
+typedef struct {
+	FscT_Ix_Cob		cob;
+	uint32_t		gen;						/* generation of the content			*/
+	uint32_t		used_f;
+} FscT_Ix_Slot;
+
+/***** State folded from the records of the index file *****/
+typedef struct {
+	FscT_Ix_Con**	cons;						/* contents by index of csmgr_stat		*/
+	uint32_t		gen;
+	FscT_Ix_Slot*	slots;						/* Cobs, open addressing				*/
+	uint32_t		slot_max;
+	uint32_t		slot_num;
+} FscT_Ix_Fold;
+
+/***** Functions which restore the contents and the Cobs *****/
+typedef struct {
+	int 	(*con_fn)(const FscT_Ix_Content*, const unsigned char*, const unsigned char*, void*);
+												/* negative if the content is dropped	*/
+	int 	(*cob_fn)(const FscT_Ix_Content*, const unsigned char*, const FscT_Ix_Cob*, void*);
+												/* negative if the Cob is dropped		*/
+	void 	(*empty_fn)(const FscT_Ix_Content*, const unsigned char*, void*);
+												/* none of the Cobs was restored		*/
+	void*	arg;
+} FscT_Ix_Restore_Fn;
+
+typedef struct {
+	char			dir_path[PATH_MAX];			/* directory of the index file			*/
+	FscT_Ix_File_Head	head;
+	int				fd;							/* index file, -1 before the restore	*/
+	uint64_t		size;						/* bytes written to the index file		*/
+	uint64_t		base_size;					/* size just after the compaction		*/
+	int				broken_f;					/* failed to write, no longer written	*/
+	pthread_mutex_t	mutex;						/* protects fd and size					*/
+
+	FscT_Ix_Fold*	fold;						/* read at the startup, NULL if the		*/
+												/* index file was not found or invalid	*/
+	uint64_t		compact_num;				/* number of compactions				*/
+} FscT_Ix;
+
+/****************************************************************************************
+ Global Function Declaration
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the index handle and reads the index file left in the directory.
+	fold of the handle is NULL if the file was not found or does not match the
+	specified layout.
+----------------------------------------------------------------------------------------*/
+FscT_Ix*
+fsc_ix_open (
+	const char* dir_path,						/* directory of the index file			*/
+	int layout,									/* layout of the cache files			*/
+	uint32_t seg_size,							/* size of a segment file				*/
+	uint32_t page_cob_num,						/* number of the records in a block		*/
+	uint32_t file_page_num						/* number of the blocks in a page file	*/
+);
+/*--------------------------------------------------------------------------------------
+	Starts a new index file and passes the contents and the Cobs read by
+	fsc_ix_open to the functions. The functions record what they restored with
+	fsc_ix_content_put and fsc_ix_cob_put.
+----------------------------------------------------------------------------------------*/
+int 								/* number of the restored Cobs, or negative			*/
+fsc_ix_restore (
+	FscT_Ix* ix,
+	const FscT_Ix_Restore_Fn* fn
+);
+/*--------------------------------------------------------------------------------------
+	Closes the index handle, the index file is compacted before it is closed
+----------------------------------------------------------------------------------------*/
+void
+fsc_ix_close (
+	FscT_Ix* ix
+);
+/*--------------------------------------------------------------------------------------
+	Records the content
+----------------------------------------------------------------------------------------*/
+void
+fsc_ix_content_put (
+	FscT_Ix* ix,
+	const CsmgrT_Stat* rcd
+);
+/*--------------------------------------------------------------------------------------
+	Records that the content was removed
+----------------------------------------------------------------------------------------*/
+void
+fsc_ix_content_del (
+	FscT_Ix* ix,
+	uint32_t con_index
+);
+/*--------------------------------------------------------------------------------------
+	Records the Cob
+----------------------------------------------------------------------------------------*/
+void
+fsc_ix_cob_put (
+	FscT_Ix* ix,
+	uint32_t con_index,
+	uint32_t chunk_num,
+	const FscT_Seg_Loc* loc,					/* location in the segment files		*/
+	uint16_t msg_len,
+	uint16_t pay_len,
+	uint64_t expiry
+);
+/*--------------------------------------------------------------------------------------
+	Records that the Cob was removed
+----------------------------------------------------------------------------------------*/
+void
+fsc_ix_cob_del (
+	FscT_Ix* ix,
+	uint32_t con_index,
+	uint32_t chunk_num
+);
+/*--------------------------------------------------------------------------------------
+	Records that the Cob was moved by the compaction of the segment files.
+	This function is set to move_fn of the segment store.
+----------------------------------------------------------------------------------------*/
+void
+fsc_ix_cob_move (
+	void* arg,									/* index handle							*/
+	const FscT_Seg_Idx_Entry* entry
+);
+/*--------------------------------------------------------------------------------------
+	Rewrites the index file with the live records if it has grown enough.
+	Only the writer thread calls this function.
+----------------------------------------------------------------------------------------*/
+int 								/* Returns 1 if the index file was compacted		*/
+fsc_ix_compact (
+	FscT_Ix* ix,
+	int force_f									/* compacts regardless of the size		*/
+);
+
+#endif // __CSMGRD_FSC_INDEX_HEADER__
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * fsc_index_test.c
+ */
+
+/*
+	fsc_index_test.c checks that fsc_ix_open stops at a record whose length field
+	is broken and restores the records written before it.
+*/
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fsc_index.h"
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define FscT_Test_Con_Index		3
+#define FscT_Test_Cob_Num		3
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static char				test_dir[] = "/tmp/fsc_index_test.XXXXXX";
+static unsigned char	test_name[] = { 0x00, 0x01, 0x00, 0x04, 't', 'e', 's', 't' };
+static int				test_con_num = 0;
+static int				test_fail = 0;
+
+/****************************************************************************************
+ Static Functions
+ ****************************************************************************************/
+
+static int
+test_con (
+	const FscT_Ix_Content* info,
+	const unsigned char* name,
+	const unsigned char* version,
+	void* arg
+) {
+	FscT_Ix* ix = (FscT_Ix*) arg;
+	CsmgrT_Stat rcd;
+
+	if ((info->con_index != FscT_Test_Con_Index) ||
+		(info->name_len != sizeof (test_name)) ||
+		(memcmp (name, test_name, sizeof (test_name)) != 0)) {
+		return (-1);
+	}
+	test_con_num++;
+
+	/* Records the restored content to the new index file 	*/
+	memset (&rcd, 0, sizeof (CsmgrT_Stat));
+	rcd.index 	 = info->con_index;
+	rcd.name 	 = (unsigned char*) name;
+	rcd.name_len = info->name_len;
+	fsc_ix_content_put (ix, &rcd);
+	return (0);
+}
+
+static int
+test_cob (
+	const FscT_Ix_Content* info,
+	const unsigned char* name,
+	const FscT_Ix_Cob* cob,
+	void* arg
+) {
+	FscT_Ix* ix = (FscT_Ix*) arg;
+	FscT_Seg_Loc loc;
+
+	/* Records the restored Cob to the new index file 	*/
+	memset (&loc, 0, sizeof (FscT_Seg_Loc));
+	loc.seg_id 	= cob->seg_id;
+	loc.offset 	= cob->offset;
+	loc.msg_len = cob->msg_len;
+	fsc_ix_cob_put (ix, cob->con_index, cob->chunk_num, &loc,
+		cob->msg_len, cob->pay_len, cob->expiry);
+	return (0);
+}
+
+static FscT_Ix*
+test_open (
+	void
+) {
+	return (fsc_ix_open (test_dir, 1, 1048576, 1, 1));
+}
+
+static int
+test_restore (
+	FscT_Ix* ix
+) {
+	FscT_Ix_Restore_Fn fn;
+
+	memset (&fn, 0, sizeof (FscT_Ix_Restore_Fn));
+	fn.con_fn = test_con;
+	fn.cob_fn = test_cob;
+	fn.arg 	  = ix;
+	test_con_num = 0;
+	return (fsc_ix_restore (ix, &fn));
+}
+
+static void
+test_append (
+	const void* buff,
+	size_t len
+) {
+	char file_path[PATH_MAX + 32];
+	int fd;
+
+	snprintf (file_path, sizeof (file_path), "%s/" FscC_Ix_File_Name, test_dir);
+	fd = open (file_path, O_WRONLY | O_APPEND);
+	if ((fd < 0) || (write (fd, buff, len) != (ssize_t) len)) {
+		fprintf (stderr, "FAIL: cannot append to %s\n", file_path);
+		test_fail = 1;
+	}
+	if (fd >= 0) {
+		close (fd);
+	}
+}
+
+static void
+test_expect (
+	const char* what,
+	uint32_t bad_len,
+	int value,
+	int expected
+) {
+	if (value != expected) {
+		fprintf (stderr, "FAIL: %s with len 0x%08x = %d (expected %d)\n",
+			what, bad_len, value, expected);
+		test_fail = 1;
+	}
+}
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+int
+main (
+	int argc,
+	char** argv
+) {
+	static const uint32_t bad_lens[] = {
+		0xFFFFFFFF, 0xFFFFFFFC, 0xFFFFFFF9, 0x80000000, 0x00010000, 0x00000009
+	};
+	unsigned char rec[sizeof (FscT_Ix_Rec_Head) + 8];
+	FscT_Ix_Rec_Head rh;
+	FscT_Seg_Loc loc;
+	CsmgrT_Stat rcd;
+	FscT_Ix* ix;
+	uint32_t i;
+	int num;
+
+	if (mkdtemp (test_dir) == NULL) {
+		perror ("mkdtemp");
+		return (1);
+	}
+
+	/* Writes the content and its Cobs 	*/
+	ix = test_open ();
+	if ((ix == NULL) || (test_restore (ix) != 0)) {
+		fprintf (stderr, "FAIL: cannot create the index file\n");
+		return (1);
+	}
+	memset (&rcd, 0, sizeof (CsmgrT_Stat));
+	rcd.index 	 = FscT_Test_Con_Index;
+	rcd.name 	 = test_name;
+	rcd.name_len = sizeof (test_name);
+	fsc_ix_content_put (ix, &rcd);
+	memset (&loc, 0, sizeof (FscT_Seg_Loc));
+	loc.msg_len = 1024;
+	for (i = 0 ; i < FscT_Test_Cob_Num ; i++) {
+		loc.offset = i * 1024;
+		fsc_ix_cob_put (ix, FscT_Test_Con_Index, i, &loc, 1024, 1000, UINT64_MAX);
+	}
+	fsc_ix_close (ix);
+
+	/* Appends a record whose length field is broken, and the record 	*/
+	/* must be ignored without reading beyond the file 					*/
+	for (i = 0 ; i < sizeof (bad_lens) / sizeof (bad_lens[0]) ; i++) {
+		memset (rec, 0xA5, sizeof (rec));
+		memset (&rh, 0, sizeof (FscT_Ix_Rec_Head));
+		rh.len 	= bad_lens[i];
+		rh.type = FscC_Ix_Rec_Cob_Del;
+		memcpy (rec, &rh, sizeof (FscT_Ix_Rec_Head));
+		test_append (rec, sizeof (rec));
+
+		ix = test_open ();
+		if ((ix == NULL) || (ix->fold == NULL)) {
+			fprintf (stderr, "FAIL: cannot read the index file\n");
+			return (1);
+		}
+		num = test_restore (ix);
+		test_expect ("restored contents", bad_lens[i], test_con_num, 1);
+		test_expect ("restored Cobs", bad_lens[i], num, FscT_Test_Cob_Num);
+		fsc_ix_close (ix);
+	}
+
+	{
+		char cmd[PATH_MAX];
+		snprintf (cmd, sizeof (cmd), "rm -rf %s", test_dir);
+		if (system (cmd) != 0) {
+			fprintf (stderr, "warning: cannot remove %s\n", test_dir);
+		}
+	}
+	if (test_fail) {
+		return (1);
+	}
+	fprintf (stderr, "fsc_index_test: OK\n");
+	return (0);
+}
@@ -0,0 +1,401 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * fsc_readahead.c
+ */
+#define __CSMGRD_FSC_READAHEAD_SOURCE__
+
+/*
+	fsc_readahead.c stages the blocks of the page files in memory before they are
+	requested. When the filesystem cache detects that a content is read in order, it
+	requests the following blocks, and the readahead thread reads them without the
+	lock of the filesystem cache. A lookup takes the staged block instead of reading
+	the page file. A block written while it is staged is dropped.
+*/
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <cefore/cef_pthread.h>
+
+#include "fsc_readahead.h"
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Reads the requested blocks
+----------------------------------------------------------------------------------------*/
+static void*
+fsc_ra_thread (
+	void* arg
+);
+/*--------------------------------------------------------------------------------------
+	Reads a block of the page file
+----------------------------------------------------------------------------------------*/
+static unsigned char*				/* NULL if an error occurs							*/
+fsc_ra_block_read (
+	FscT_Ra_Tier* tp,
+	const FscT_Ra_Slot* key,
+	int* rec_num
+);
+/*--------------------------------------------------------------------------------------
+	Frees the slot
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ra_slot_free (
+	FscT_Ra_Slot* slot
+);
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the staging tier and starts the readahead thread
+----------------------------------------------------------------------------------------*/
+FscT_Ra_Tier*
+fsc_ra_tier_create (
+	const char* dir_path,						/* directory of the page files			*/
+	int page_cob_num,							/* number of the records in a block		*/
+	int page_num								/* number of pages read ahead			*/
+) {
+	FscT_Ra_Tier* tp;
+
+	if (page_num < 1 || page_num > FscC_Ra_Page_Max) {
+		return (NULL);
+	}
+	tp = (FscT_Ra_Tier*) malloc (sizeof (FscT_Ra_Tier));
+	if (tp == NULL) {
+		return (NULL);
+	}
+	memset (tp, 0, sizeof (FscT_Ra_Tier));
+	snprintf (tp->dir_path, sizeof (tp->dir_path), "%s", dir_path);
+	tp->page_cob_num = page_cob_num;
+	tp->page_num = page_num;
+	tp->slot_num = page_num * FscC_Ra_Stream_Num;
+	pthread_mutex_init (&tp->mutex, NULL);
+	pthread_cond_init (&tp->cond, NULL);
+
+	tp->run_f = 1;
+	if (cef_pthread_create (&tp->thread, NULL, fsc_ra_thread, tp) == -1) {
+		pthread_mutex_destroy (&tp->mutex);
+		pthread_cond_destroy (&tp->cond);
+		free (tp);
+		return (NULL);
+	}
+	return (tp);
+}
+/*--------------------------------------------------------------------------------------
+	Stops the readahead thread and destroys the staging tier
+----------------------------------------------------------------------------------------*/
+void
+fsc_ra_tier_destroy (
+	FscT_Ra_Tier* tp
+) {
+	void* status;
+	int i;
+
+	if (tp == NULL) {
+		return;
+	}
+	pthread_mutex_lock (&tp->mutex);
+	tp->run_f = 0;
+	pthread_cond_signal (&tp->cond);
+	pthread_mutex_unlock (&tp->mutex);
+	pthread_join (tp->thread, &status);
+
+	for (i = 0 ; i < tp->slot_num ; i++) {
+		fsc_ra_slot_free (&tp->slots[i]);
+	}
+	pthread_mutex_destroy (&tp->mutex);
+	pthread_cond_destroy (&tp->cond);
+	free (tp);
+}
+/*--------------------------------------------------------------------------------------
+	Requests the readahead thread to stage the block of the page file.
+	Does nothing if the block is already requested or staged.
+----------------------------------------------------------------------------------------*/
+void
+fsc_ra_request (
+	FscT_Ra_Tier* tp,
+	uint32_t con_index,
+	int page_index,
+	int block_index,
+	int rcdsize
+) {
+	FscT_Ra_Slot* slot;
+	FscT_Ra_Slot* trg = NULL;
+	int i;
+
+	pthread_mutex_lock (&tp->mutex);
+	for (i = 0 ; i < tp->slot_num ; i++) {
+		slot = &tp->slots[i];
+		if (slot->state == FscC_Ra_Free) {
+			if (trg == NULL || trg->state != FscC_Ra_Free) {
+				trg = slot;
+			}
+			continue;
+		}
+		if (slot->con_index == con_index && slot->page_index == page_index &&
+			slot->block_index == block_index && slot->stale_f == 0) {
+			pthread_mutex_unlock (&tp->mutex);
+			return;
+		}
+		/* Reuses the page which was staged first if no slot is free 	*/
+		if (slot->state == FscC_Ra_Ready &&
+			(trg == NULL || (trg->state == FscC_Ra_Ready && slot->stamp < trg->stamp))) {
+			trg = slot;
+		}
+	}
+	if (trg == NULL) {
+		pthread_mutex_unlock (&tp->mutex);
+		return;
+	}
+	if (trg->state == FscC_Ra_Ready) {
+		tp->drop_num++;
+	}
+	fsc_ra_slot_free (trg);
+	trg->state = FscC_Ra_Requested;
+	trg->con_index = con_index;
+	trg->page_index = page_index;
+	trg->block_index = block_index;
+	trg->rcdsize = rcdsize;
+	trg->stamp = ++tp->stamp;
+	pthread_cond_signal (&tp->cond);
+	pthread_mutex_unlock (&tp->mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Takes the staged block out of the staging tier.
+	The caller frees the returned buffer.
+----------------------------------------------------------------------------------------*/
+unsigned char*						/* NULL if the block is not staged					*/
+fsc_ra_take (
+	FscT_Ra_Tier* tp,
+	uint32_t con_index,
+	int page_index,
+	int block_index,
+	int rcdsize,
+	int* rec_num						/* number of the records in the buffer			*/
+) {
+	FscT_Ra_Slot* slot;
+	unsigned char* buff = NULL;
+	int i;
+
+	pthread_mutex_lock (&tp->mutex);
+	for (i = 0 ; i < tp->slot_num ; i++) {
+		slot = &tp->slots[i];
+		if (slot->state == FscC_Ra_Free || slot->stale_f || slot->con_index != con_index ||
+			slot->page_index != page_index || slot->block_index != block_index) {
+			continue;
+		}
+		if (slot->state == FscC_Ra_Ready && slot->rcdsize == rcdsize) {
+			buff = slot->buff;
+			*rec_num = slot->rec_num;
+			slot->buff = NULL;
+			fsc_ra_slot_free (slot);
+			tp->hit_num++;
+		} else if (slot->state == FscC_Ra_Loading) {
+			/* The caller reads the block by itself 	*/
+			slot->stale_f = 1;
+		} else {
+			fsc_ra_slot_free (slot);
+		}
+		break;
+	}
+	pthread_mutex_unlock (&tp->mutex);
+
+	return (buff);
+}
+/*--------------------------------------------------------------------------------------
+	Drops the staged block which was written or removed.
+	If page_index is negative, drops all blocks of the content.
+----------------------------------------------------------------------------------------*/
+void
+fsc_ra_invalidate (
+	FscT_Ra_Tier* tp,
+	uint32_t con_index,
+	int page_index,
+	int block_index
+) {
+	FscT_Ra_Slot* slot;
+	int i;
+
+	pthread_mutex_lock (&tp->mutex);
+	for (i = 0 ; i < tp->slot_num ; i++) {
+		slot = &tp->slots[i];
+		if (slot->state == FscC_Ra_Free || slot->con_index != con_index) {
+			continue;
+		}
+		if (page_index >= 0 &&
+			(slot->page_index != page_index || slot->block_index != block_index)) {
+			continue;
+		}
+		if (slot->state == FscC_Ra_Loading) {
+			slot->stale_f = 1;
+		} else {
+			if (slot->state == FscC_Ra_Ready) {
+				tp->drop_num++;
+			}
+			fsc_ra_slot_free (slot);
+		}
+	}
+	pthread_mutex_unlock (&tp->mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Reads the requested blocks
+----------------------------------------------------------------------------------------*/
+static void*
+fsc_ra_thread (
+	void* arg
+) {
+	FscT_Ra_Tier* tp = (FscT_Ra_Tier*) arg;
+	FscT_Ra_Slot* slot;
+	FscT_Ra_Slot key;
+	unsigned char* buff;
+	int rec_num;
+	int i;
+
+	pthread_mutex_lock (&tp->mutex);
+	while (tp->run_f) {
+		/* Reads the block which was requested first 	*/
+		slot = NULL;
+		for (i = 0 ; i < tp->slot_num ; i++) {
+			if (tp->slots[i].state == FscC_Ra_Requested &&
+				(slot == NULL || tp->slots[i].stamp < slot->stamp)) {
+				slot = &tp->slots[i];
+			}
+		}
+		if (slot == NULL) {
+			pthread_cond_wait (&tp->cond, &tp->mutex);
+			continue;
+		}
+		slot->state = FscC_Ra_Loading;
+		slot->stale_f = 0;
+		key = *slot;
+		pthread_mutex_unlock (&tp->mutex);
+
+		rec_num = 0;
+		buff = fsc_ra_block_read (tp, &key, &rec_num);
+
+		pthread_mutex_lock (&tp->mutex);
+		if (buff == NULL || slot->stale_f) {
+			free (buff);
+			fsc_ra_slot_free (slot);
+			tp->drop_num++;
+			continue;
+		}
+		slot->buff = buff;
+		slot->rec_num = rec_num;
+		slot->stamp = ++tp->stamp;
+		slot->state = FscC_Ra_Ready;
+		tp->staged_num++;
+	}
+	pthread_mutex_unlock (&tp->mutex);
+
+	pthread_exit (NULL);
+
+	return ((void*) NULL);
+}
+/*--------------------------------------------------------------------------------------
+	Reads a block of the page file
+----------------------------------------------------------------------------------------*/
+static unsigned char*				/* NULL if an error occurs							*/
+fsc_ra_block_read (
+	FscT_Ra_Tier* tp,
+	const FscT_Ra_Slot* key,
+	int* rec_num
+) {
+	char		file_path[PATH_MAX];
+	unsigned char* buff;
+	size_t		len;
+	size_t		red = 0;
+	off_t		offset;
+	ssize_t		res;
+	int			fd;
+
+	len = (size_t) tp->page_cob_num * key->rcdsize;
+	offset = (off_t) key->block_index * len;
+	res = snprintf (file_path, sizeof (file_path), "%s/%u/%d",
+		tp->dir_path, key->con_index, key->page_index);
+	if (res < 0 || res >= (ssize_t) sizeof (file_path)) {
+		return (NULL);
+	}
+
+	fd = open (file_path, O_RDONLY);
+	if (fd < 0) {
+		return (NULL);
+	}
+	/* Records which were not written are left zero as fsc_cache_item_get does 	*/
+	buff = (unsigned char*) calloc (1, len);
+	if (buff == NULL) {
+		close (fd);
+		return (NULL);
+	}
+	while (red < len) {
+		res = pread (fd, &buff[red], len - red, offset + red);
+		if (res < 0 && errno == EINTR) {
+			continue;
+		}
+		if (res <= 0) {
+			break;
+		}
+		red += res;
+	}
+	close (fd);
+
+	*rec_num = (int)(red / key->rcdsize);
+	if (*rec_num == 0) {
+		free (buff);
+		return (NULL);
+	}
+	return (buff);
+}
+/*--------------------------------------------------------------------------------------
+	Frees the slot
+----------------------------------------------------------------------------------------*/
+static void
+fsc_ra_slot_free (
+	FscT_Ra_Slot* slot
+) {
+	if (slot->buff) {
+		free (slot->buff);
+	}
+	memset (slot, 0, sizeof (FscT_Ra_Slot));
+}
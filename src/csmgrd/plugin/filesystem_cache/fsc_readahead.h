@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * fsc_readahead.h
+ */
+#ifndef __CSMGRD_FSC_READAHEAD_HEADER__
+#define __CSMGRD_FSC_READAHEAD_HEADER__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#include <limits.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define FscC_Ra_Page_Default		2			/* Default number of pages read ahead	*/
+#define FscC_Ra_Page_Max			8			/* Max number of pages read ahead		*/
+#define FscC_Ra_Stream_Num			4			/* Number of sequential readers which	*/
+												/* the staging tier holds pages for		*/
+#define FscC_Ra_Slot_Max			(FscC_Ra_Page_Max * FscC_Ra_Stream_Num)
+
+/*------------------------------------------------------------------
+	State of a staging slot
+--------------------------------------------------------------------*/
+#define FscC_Ra_Free				0
+#define FscC_Ra_Requested			1			/* waiting for the readahead thread		*/
+#define FscC_Ra_Loading				2			/* being read by the readahead thread	*/
+#define FscC_Ra_Ready				3			/* staged in memory						*/
+
+/****************************************************************************************
+ Structure Declarations
+ ****************************************************************************************/
+
+/***** Page staged in memory *****/
+typedef struct {
+	int				state;
+	uint32_t		con_index;					/* index of the content in csmgr_stat	*/
+	int				page_index;					/* page file							*/
+	int				block_index;				/* block of the records in the file		*/
+	int				rcdsize;					/* size of a record						*/
+	int				stale_f;					/* written while it was being read		*/
+	int				rec_num;					/* number of the records read			*/
+	uint64_t		stamp;						/* order of the request or the staging	*/
+	unsigned char*	buff;
+} FscT_Ra_Slot;
+
+typedef struct {
+	char			dir_path[PATH_MAX];			/* directory of the page files			*/
+	int				page_cob_num;				/* number of the records in a block		*/
+	int				page_num;					/* number of pages read ahead			*/
+
+	FscT_Ra_Slot	slots[FscC_Ra_Slot_Max];
+	int				slot_num;
+	uint64_t		stamp;
+	pthread_mutex_t	mutex;						/* protects the slots					*/
+	pthread_cond_t	cond;						/* signaled when a page is requested	*/
+	pthread_t		thread;
+	int				run_f;
+
+	uint64_t		staged_num;					/* pages read by the readahead thread	*/
+	uint64_t		hit_num;					/* staged pages used by lookups			*/
+	uint64_t		drop_num;					/* pages dropped before they were used	*/
+} FscT_Ra_Tier;
+
+/****************************************************************************************
+ Global Function Declaration
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the staging tier and starts the readahead thread
+----------------------------------------------------------------------------------------*/
+FscT_Ra_Tier*
+fsc_ra_tier_create (
+	const char* dir_path,						/* directory of the page files			*/
+	int page_cob_num,							/* number of the records in a block		*/
+	int page_num								/* number of pages read ahead			*/
+);
+/*--------------------------------------------------------------------------------------
+	Stops the readahead thread and destroys the staging tier
+----------------------------------------------------------------------------------------*/
+void
+fsc_ra_tier_destroy (
+	FscT_Ra_Tier* tp
+);
+/*--------------------------------------------------------------------------------------
+	Requests the readahead thread to stage the block of the page file.
+	Does nothing if the block is already requested or staged.
+----------------------------------------------------------------------------------------*/
+void
+fsc_ra_request (
+	FscT_Ra_Tier* tp,
+	uint32_t con_index,
+	int page_index,
+	int block_index,
+	int rcdsize
+);
+/*--------------------------------------------------------------------------------------
+	Takes the staged block out of the staging tier.
+	The caller frees the returned buffer.
+----------------------------------------------------------------------------------------*/
+unsigned char*						/* NULL if the block is not staged					*/
+fsc_ra_take (
+	FscT_Ra_Tier* tp,
+	uint32_t con_index,
+	int page_index,
+	int block_index,
+	int rcdsize,
+	int* rec_num						/* number of the records in the buffer			*/
+);
+/*--------------------------------------------------------------------------------------
+	Drops the staged block which was written or removed.
+	If page_index is negative, drops all blocks of the content.
+----------------------------------------------------------------------------------------*/
+void
+fsc_ra_invalidate (
+	FscT_Ra_Tier* tp,
+	uint32_t con_index,
+	int page_index,
+	int block_index
+);
+
+#endif // __CSMGRD_FSC_READAHEAD_HEADER__
@@ -0,0 +1,833 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * fsc_segment.c
+ */
+#define __CSMGRD_FSC_SEGMENT_SOURCE__
+
+/*
+	fsc_segment.c stores the Cobs of the filesystem cache in append-only segment
+	files. The location of each Cob is kept in an in-memory index, and the Cobs are
+	read with pread without the lock of the filesystem cache. A sealed segment whose
+	most records were removed is compacted by the writer thread.
+*/
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif // HAVE_CONFIG_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "fsc_segment.h"
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define FscC_Seg_Rec_Len(_len)		((uint32_t) FscC_Seg_Rec_Head_Size + (_len))
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Allocates the segment store which has no segment file
+----------------------------------------------------------------------------------------*/
+static FscT_Seg_Store*
+fsc_seg_store_alloc (
+	const char* dir_path,
+	uint32_t seg_size
+);
+/*--------------------------------------------------------------------------------------
+	Hash function of the index
+----------------------------------------------------------------------------------------*/
+static uint32_t
+fsc_seg_idx_hash (
+	uint32_t con_index,
+	uint32_t chunk_num
+);
+/*--------------------------------------------------------------------------------------
+	Searches the index
+----------------------------------------------------------------------------------------*/
+static FscT_Seg_Idx_Entry*
+fsc_seg_idx_find (
+	FscT_Seg_Store* sp,
+	uint32_t con_index,
+	uint32_t chunk_num
+);
+/*--------------------------------------------------------------------------------------
+	Sets the location to the index
+----------------------------------------------------------------------------------------*/
+static int 							/* The return value is negative if an error occurs	*/
+fsc_seg_idx_set (
+	FscT_Seg_Store* sp,
+	uint32_t con_index,
+	uint32_t chunk_num,
+	uint32_t seg_id,
+	uint32_t offset,
+	uint16_t msg_len
+);
+/*--------------------------------------------------------------------------------------
+	Removes the entry from the index
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_idx_delete (
+	FscT_Seg_Store* sp,
+	FscT_Seg_Idx_Entry* entry
+);
+/*--------------------------------------------------------------------------------------
+	Doubles the number of the index slots
+----------------------------------------------------------------------------------------*/
+static int 							/* The return value is negative if an error occurs	*/
+fsc_seg_idx_grow (
+	FscT_Seg_Store* sp
+);
+/*--------------------------------------------------------------------------------------
+	Opens a new segment file
+----------------------------------------------------------------------------------------*/
+static int 							/* ID of the segment, or negative if an error occurs*/
+fsc_seg_open (
+	FscT_Seg_Store* sp
+);
+/*--------------------------------------------------------------------------------------
+	Writes a record to the active segment
+----------------------------------------------------------------------------------------*/
+static int 							/* The return value is negative if an error occurs	*/
+fsc_seg_write (
+	FscT_Seg_Store* sp,
+	uint32_t con_index,
+	uint32_t chunk_num,
+	const unsigned char* msg,
+	uint16_t msg_len,
+	uint32_t* seg_id,
+	uint32_t* offset
+);
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the segment store in the specified directory
+----------------------------------------------------------------------------------------*/
+FscT_Seg_Store*
+fsc_seg_store_create (
+	const char* dir_path,						/* directory of the segment files		*/
+	uint32_t seg_size							/* size to seal a segment				*/
+) {
+	FscT_Seg_Store* sp;
+	int id;
+
+	sp = fsc_seg_store_alloc (dir_path, seg_size);
+	if (sp == NULL) {
+		return (NULL);
+	}
+	id = fsc_seg_open (sp);
+	if (id < 0) {
+		fsc_seg_store_destroy (sp);
+		return (NULL);
+	}
+	sp->active_id = (uint32_t) id;
+
+	return (sp);
+}
+/*--------------------------------------------------------------------------------------
+	Creates the segment store with the segment files left in the specified
+	directory. The Cobs in them are added to the index by fsc_seg_restore.
+----------------------------------------------------------------------------------------*/
+FscT_Seg_Store*
+fsc_seg_store_open (
+	const char* dir_path,						/* directory of the segment files		*/
+	uint32_t seg_size							/* size to seal a segment				*/
+) {
+	FscT_Seg_Store* sp;
+	char file_path[PATH_MAX + 32];
+	struct stat st;
+	int fd;
+	int id;
+	int i;
+
+	sp = fsc_seg_store_alloc (dir_path, seg_size);
+	if (sp == NULL) {
+		return (NULL);
+	}
+
+	/* The left segments are sealed, their live bytes are counted when the 	*/
+	/* Cobs are restored and the segments without live bytes are compacted 	*/
+	for (i = 0 ; i < FscC_Seg_Max ; i++) {
+		snprintf (file_path, sizeof (file_path), "%s/" FscC_Seg_File_Name, dir_path, i);
+		fd = open (file_path, O_RDWR);
+		if (fd < 0) {
+			continue;
+		}
+		if ((fstat (fd, &st) != 0) || (st.st_size > (off_t) UINT32_MAX)) {
+			close (fd);
+			unlink (file_path);
+			continue;
+		}
+		sp->segs[i].fd 	 = fd;
+		sp->segs[i].size = (uint32_t) st.st_size;
+	}
+	id = fsc_seg_open (sp);
+	if (id < 0) {
+		fsc_seg_store_destroy (sp);
+		return (NULL);
+	}
+	sp->active_id = (uint32_t) id;
+
+	return (sp);
+}
+/*--------------------------------------------------------------------------------------
+	Destroys the segment store (segment files are left)
+----------------------------------------------------------------------------------------*/
+void
+fsc_seg_store_destroy (
+	FscT_Seg_Store* sp
+) {
+	int i;
+
+	if (sp == NULL) {
+		return;
+	}
+	for (i = 0 ; i < FscC_Seg_Max ; i++) {
+		if (sp->segs[i].fd >= 0) {
+			close (sp->segs[i].fd);
+		}
+	}
+	pthread_rwlock_destroy (&sp->idx_lock);
+	pthread_mutex_destroy (&sp->seg_mutex);
+	free (sp->idx);
+	free (sp);
+}
+/*--------------------------------------------------------------------------------------
+	Appends a Cob to the active segment and adds it to the index.
+	Only the writer thread calls this function.
+----------------------------------------------------------------------------------------*/
+int 								/* The return value is negative if an error occurs	*/
+fsc_seg_append (
+	FscT_Seg_Store* sp,
+	uint32_t con_index,
+	uint32_t chunk_num,
+	const unsigned char* msg,
+	uint16_t msg_len,
+	FscT_Seg_Loc* loc							/* location of the record (NULL allowed)*/
+) {
+	uint32_t seg_id;
+	uint32_t offset;
+	int res;
+
+	if (msg_len == 0) {
+		return (-1);
+	}
+	if (fsc_seg_write (sp, con_index, chunk_num, msg, msg_len, &seg_id, &offset) < 0) {
+		return (-1);
+	}
+
+	/* The Cob becomes visible to the readers after it was written 	*/
+	pthread_rwlock_wrlock (&sp->idx_lock);
+	res = fsc_seg_idx_set (sp, con_index, chunk_num, seg_id, offset, msg_len);
+	pthread_rwlock_unlock (&sp->idx_lock);
+
+	if (loc) {
+		loc->seg_id  = seg_id;
+		loc->offset  = offset;
+		loc->msg_len = msg_len;
+	}
+	return (res);
+}
+/*--------------------------------------------------------------------------------------
+	Adds the Cob left in the segment file to the index.
+	The record at the location is checked before it is added.
+----------------------------------------------------------------------------------------*/
+int 								/* The return value is negative if an error occurs	*/
+fsc_seg_restore (
+	FscT_Seg_Store* sp,
+	uint32_t con_index,
+	uint32_t chunk_num,
+	const FscT_Seg_Loc* loc
+) {
+	FscT_Seg_Rec_Head rh;
+	FscT_Seg* seg;
+	int res;
+
+	if ((loc->seg_id >= FscC_Seg_Max) || (loc->seg_id == sp->active_id) ||
+		(loc->msg_len == 0)) {
+		return (-1);
+	}
+	seg = &sp->segs[loc->seg_id];
+	if ((seg->fd < 0) ||
+		((uint64_t) loc->offset + FscC_Seg_Rec_Len (loc->msg_len) > seg->size)) {
+		return (-1);
+	}
+
+	/* The segment may have been compacted and reused after the index was written */
+	if (fsc_seg_read (sp, loc->seg_id, loc->offset,
+			(unsigned char*) &rh, FscC_Seg_Rec_Head_Size) < 0) {
+		return (-1);
+	}
+	if ((rh.con_index != con_index) || (rh.chunk_num != chunk_num) ||
+		(rh.msg_len != loc->msg_len)) {
+		return (-1);
+	}
+
+	pthread_rwlock_wrlock (&sp->idx_lock);
+	res = fsc_seg_idx_set (sp, con_index, chunk_num, loc->seg_id, loc->offset, loc->msg_len);
+	pthread_rwlock_unlock (&sp->idx_lock);
+
+	return (res);
+}
+/*--------------------------------------------------------------------------------------
+	Removes a Cob from the index
+----------------------------------------------------------------------------------------*/
+int 								/* Returns 1 if the Cob was in the index			*/
+fsc_seg_remove (
+	FscT_Seg_Store* sp,
+	uint32_t con_index,
+	uint32_t chunk_num
+) {
+	FscT_Seg_Idx_Entry* entry;
+	int found_f = 0;
+
+	pthread_rwlock_wrlock (&sp->idx_lock);
+	entry = fsc_seg_idx_find (sp, con_index, chunk_num);
+	if (entry) {
+		sp->segs[entry->seg_id].live -= FscC_Seg_Rec_Len (entry->msg_len);
+		fsc_seg_idx_delete (sp, entry);
+		found_f = 1;
+	}
+	pthread_rwlock_unlock (&sp->idx_lock);
+
+	return (found_f);
+}
+/*--------------------------------------------------------------------------------------
+	Looks up the Cobs and pins the segments which have them.
+	The locations of the found Cobs are set to locs in the order of chunks.
+----------------------------------------------------------------------------------------*/
+int 								/* number of the found Cobs							*/
+fsc_seg_lookup (
+	FscT_Seg_Store* sp,
+	uint32_t con_index,
+	const uint32_t* chunks,
+	int num,
+	FscT_Seg_Loc* locs
+) {
+	FscT_Seg_Idx_Entry* entry;
+	int found = 0;
+	int i;
+
+	pthread_rwlock_rdlock (&sp->idx_lock);
+	pthread_mutex_lock (&sp->seg_mutex);
+	for (i = 0 ; i < num ; i++) {
+		entry = fsc_seg_idx_find (sp, con_index, chunks[i]);
+		if (entry == NULL) {
+			continue;
+		}
+		locs[found].seg_id 	= entry->seg_id;
+		locs[found].offset 	= entry->offset;
+		locs[found].msg_len = entry->msg_len;
+		sp->segs[entry->seg_id].refcnt++;
+		found++;
+	}
+	pthread_mutex_unlock (&sp->seg_mutex);
+	pthread_rwlock_unlock (&sp->idx_lock);
+
+	return (found);
+}
+/*--------------------------------------------------------------------------------------
+	Unpins the segments pinned by fsc_seg_lookup
+----------------------------------------------------------------------------------------*/
+void
+fsc_seg_unpin (
+	FscT_Seg_Store* sp,
+	const FscT_Seg_Loc* locs,
+	int num
+) {
+	FscT_Seg* seg;
+	int i;
+
+	pthread_mutex_lock (&sp->seg_mutex);
+	for (i = 0 ; i < num ; i++) {
+		seg = &sp->segs[locs[i].seg_id];
+		seg->refcnt--;
+		if ((seg->refcnt == 0) && (seg->dead_f) && (seg->fd >= 0)) {
+			close (seg->fd);
+			seg->fd = -1;
+		}
+	}
+	pthread_mutex_unlock (&sp->seg_mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Reads the bytes from the pinned segment
+----------------------------------------------------------------------------------------*/
+int 								/* The return value is negative if an error occurs	*/
+fsc_seg_read (
+	FscT_Seg_Store* sp,
+	uint32_t seg_id,
+	uint32_t offset,
+	unsigned char* buff,
+	uint32_t len
+) {
+	ssize_t res;
+	uint32_t red = 0;
+
+	while (red < len) {
+		res = pread (sp->segs[seg_id].fd, &buff[red], len - red, (off_t)(offset + red));
+		if (res < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return (-1);
+		}
+		if (res == 0) {
+			return (-1);
+		}
+		red += (uint32_t) res;
+	}
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Compacts the sealed segment which has the fewest live bytes.
+	Only the writer thread calls this function.
+----------------------------------------------------------------------------------------*/
+int 								/* Returns 1 if a segment was compacted				*/
+fsc_seg_compact (
+	FscT_Seg_Store* sp
+) {
+	FscT_Seg* seg;
+	FscT_Seg_Idx_Entry* entry;
+	FscT_Seg_Idx_Entry moved;
+	FscT_Seg_Rec_Head rh;
+	unsigned char* buff;
+	char file_path[PATH_MAX + 32];
+	int victim = -1;
+	uint64_t ratio;
+	uint64_t min_ratio = FscC_Seg_Compact_Ratio;
+	uint32_t size;
+	uint32_t off;
+	uint32_t pos;
+	uint32_t len;
+	uint32_t rec_len;
+	uint32_t new_id;
+	uint32_t new_off;
+	int live_f;
+	int i;
+
+	/* Selects the segment 		*/
+	pthread_rwlock_rdlock (&sp->idx_lock);
+	for (i = 0 ; i < FscC_Seg_Max ; i++) {
+		seg = &sp->segs[i];
+		if ((seg->fd < 0) || (seg->dead_f) ||
+			(i == (int) sp->active_id) || (seg->size == 0)) {
+			continue;
+		}
+		ratio = (uint64_t) seg->live * 100 / seg->size;
+		if (ratio < min_ratio) {
+			min_ratio = ratio;
+			victim = i;
+		}
+	}
+	pthread_rwlock_unlock (&sp->idx_lock);
+	if (victim < 0) {
+		return (0);
+	}
+	seg  = &sp->segs[victim];
+	size = seg->size;
+
+	buff = (unsigned char*) malloc (FscC_Seg_Read_Buff);
+	if (buff == NULL) {
+		return (0);
+	}
+
+	/* Moves the live records to the active segment 	*/
+	off = 0;
+	while (off < size) {
+		len = size - off;
+		if (len > FscC_Seg_Read_Buff) {
+			len = FscC_Seg_Read_Buff;
+		}
+		if (fsc_seg_read (sp, (uint32_t) victim, off, buff, len) < 0) {
+			break;
+		}
+		pos = 0;
+		while (pos + FscC_Seg_Rec_Head_Size <= len) {
+			memcpy (&rh, &buff[pos], FscC_Seg_Rec_Head_Size);
+			rec_len = FscC_Seg_Rec_Len (rh.msg_len);
+			if ((rh.msg_len == 0) || (pos + rec_len > len)) {
+				break;
+			}
+			pthread_rwlock_rdlock (&sp->idx_lock);
+			entry = fsc_seg_idx_find (sp, rh.con_index, rh.chunk_num);
+			live_f = (entry && (entry->seg_id == (uint32_t) victim) &&
+						(entry->offset == off + pos));
+			pthread_rwlock_unlock (&sp->idx_lock);
+
+			if (live_f) {
+				if (fsc_seg_write (sp, rh.con_index, rh.chunk_num,
+						&buff[pos + FscC_Seg_Rec_Head_Size], rh.msg_len,
+						&new_id, &new_off) < 0) {
+					free (buff);
+					return (0);
+				}
+				/* The record may have been removed while it was copied 	*/
+				moved.msg_len = 0;
+				pthread_rwlock_wrlock (&sp->idx_lock);
+				entry = fsc_seg_idx_find (sp, rh.con_index, rh.chunk_num);
+				if (entry && (entry->seg_id == (uint32_t) victim) &&
+					(entry->offset == off + pos)) {
+					seg->live -= rec_len;
+					sp->segs[new_id].live += rec_len;
+					entry->seg_id = new_id;
+					entry->offset = new_off;
+					moved = *entry;
+				}
+				pthread_rwlock_unlock (&sp->idx_lock);
+				if ((moved.msg_len) && (sp->move_fn)) {
+					(*sp->move_fn)(sp->move_arg, &moved);
+				}
+			}
+			pos += rec_len;
+		}
+		if (pos == 0) {
+			/* Broken record 	*/
+			break;
+		}
+		off += pos;
+	}
+	free (buff);
+
+	/* Releases the segment if no record refers to it 	*/
+	pthread_rwlock_wrlock (&sp->idx_lock);
+	if (seg->live != 0) {
+		pthread_rwlock_unlock (&sp->idx_lock);
+		return (0);
+	}
+	pthread_mutex_lock (&sp->seg_mutex);
+	seg->dead_f = 1;
+	if (seg->refcnt == 0) {
+		close (seg->fd);
+		seg->fd = -1;
+	}
+	pthread_mutex_unlock (&sp->seg_mutex);
+	pthread_rwlock_unlock (&sp->idx_lock);
+
+	snprintf (file_path, sizeof (file_path), "%s/" FscC_Seg_File_Name, sp->dir_path, victim);
+	unlink (file_path);
+	sp->compact_num++;
+
+	return (1);
+}
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Allocates the segment store which has no segment file
+----------------------------------------------------------------------------------------*/
+static FscT_Seg_Store*
+fsc_seg_store_alloc (
+	const char* dir_path,
+	uint32_t seg_size
+) {
+	FscT_Seg_Store* sp;
+	int i;
+
+	sp = (FscT_Seg_Store*) malloc (sizeof (FscT_Seg_Store));
+	if (sp == NULL) {
+		return (NULL);
+	}
+	memset (sp, 0, sizeof (FscT_Seg_Store));
+	snprintf (sp->dir_path, sizeof (sp->dir_path), "%s", dir_path);
+	sp->seg_size = seg_size;
+
+	sp->idx = (FscT_Seg_Idx_Entry*)
+		calloc (FscC_Seg_Idx_Init_Size, sizeof (FscT_Seg_Idx_Entry));
+	if (sp->idx == NULL) {
+		free (sp);
+		return (NULL);
+	}
+	sp->idx_max = FscC_Seg_Idx_Init_Size;
+	pthread_rwlock_init (&sp->idx_lock, NULL);
+	pthread_mutex_init (&sp->seg_mutex, NULL);
+
+	for (i = 0 ; i < FscC_Seg_Max ; i++) {
+		sp->segs[i].fd = -1;
+	}
+
+	return (sp);
+}
+/*--------------------------------------------------------------------------------------
+	Hash function of the index
+----------------------------------------------------------------------------------------*/
+static uint32_t
+fsc_seg_idx_hash (
+	uint32_t con_index,
+	uint32_t chunk_num
+) {
+	uint64_t h = ((uint64_t) con_index << 32) | chunk_num;
+
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdllu;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53llu;
+	h ^= h >> 33;
+
+	return ((uint32_t) h);
+}
+/*--------------------------------------------------------------------------------------
+	Searches the index
+----------------------------------------------------------------------------------------*/
+static FscT_Seg_Idx_Entry*
+fsc_seg_idx_find (
+	FscT_Seg_Store* sp,
+	uint32_t con_index,
+	uint32_t chunk_num
+) {
+	uint32_t mask = sp->idx_max - 1;
+	uint32_t i;
+
+	i = fsc_seg_idx_hash (con_index, chunk_num) & mask;
+	while (sp->idx[i].msg_len) {
+		if ((sp->idx[i].con_index == con_index) &&
+			(sp->idx[i].chunk_num == chunk_num)) {
+			return (&sp->idx[i]);
+		}
+		i = (i + 1) & mask;
+	}
+	return (NULL);
+}
+/*--------------------------------------------------------------------------------------
+	Sets the location to the index
+----------------------------------------------------------------------------------------*/
+static int 							/* The return value is negative if an error occurs	*/
+fsc_seg_idx_set (
+	FscT_Seg_Store* sp,
+	uint32_t con_index,
+	uint32_t chunk_num,
+	uint32_t seg_id,
+	uint32_t offset,
+	uint16_t msg_len
+) {
+	FscT_Seg_Idx_Entry* entry;
+	uint32_t mask;
+	uint32_t i;
+
+	entry = fsc_seg_idx_find (sp, con_index, chunk_num);
+	if (entry) {
+		sp->segs[entry->seg_id].live -= FscC_Seg_Rec_Len (entry->msg_len);
+	} else {
+		/* Keeps the load factor under 3/4 	*/
+		if ((sp->idx_num + 1) * 4 > sp->idx_max * 3) {
+			if (fsc_seg_idx_grow (sp) < 0) {
+				return (-1);
+			}
+		}
+		mask = sp->idx_max - 1;
+		i = fsc_seg_idx_hash (con_index, chunk_num) & mask;
+		while (sp->idx[i].msg_len) {
+			i = (i + 1) & mask;
+		}
+		entry = &sp->idx[i];
+		entry->con_index = con_index;
+		entry->chunk_num = chunk_num;
+		sp->idx_num++;
+	}
+	entry->seg_id 	= seg_id;
+	entry->offset 	= offset;
+	entry->msg_len 	= msg_len;
+	sp->segs[seg_id].live += FscC_Seg_Rec_Len (msg_len);
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the entry from the index
+----------------------------------------------------------------------------------------*/
+static void
+fsc_seg_idx_delete (
+	FscT_Seg_Store* sp,
+	FscT_Seg_Idx_Entry* entry
+) {
+	uint32_t mask = sp->idx_max - 1;
+	uint32_t i;
+	uint32_t j;
+	uint32_t k;
+
+	/* Shifts back the following entries instead of leaving a tombstone 	*/
+	i = (uint32_t)(entry - sp->idx);
+	j = i;
+	while (1) {
+		j = (j + 1) & mask;
+		if (sp->idx[j].msg_len == 0) {
+			break;
+		}
+		k = fsc_seg_idx_hash (sp->idx[j].con_index, sp->idx[j].chunk_num) & mask;
+		if ((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j))) {
+			continue;
+		}
+		sp->idx[i] = sp->idx[j];
+		i = j;
+	}
+	memset (&sp->idx[i], 0, sizeof (FscT_Seg_Idx_Entry));
+	sp->idx_num--;
+}
+/*--------------------------------------------------------------------------------------
+	Doubles the number of the index slots
+----------------------------------------------------------------------------------------*/
+static int 							/* The return value is negative if an error occurs	*/
+fsc_seg_idx_grow (
+	FscT_Seg_Store* sp
+) {
+	FscT_Seg_Idx_Entry* new_idx;
+	uint32_t new_max = sp->idx_max * 2;
+	uint32_t mask = new_max - 1;
+	uint32_t n;
+	uint32_t i;
+
+	if (new_max < sp->idx_max) {
+		return (-1);
+	}
+	new_idx = (FscT_Seg_Idx_Entry*) calloc (new_max, sizeof (FscT_Seg_Idx_Entry));
+	if (new_idx == NULL) {
+		return (-1);
+	}
+	for (n = 0 ; n < sp->idx_max ; n++) {
+		if (sp->idx[n].msg_len == 0) {
+			continue;
+		}
+		i = fsc_seg_idx_hash (sp->idx[n].con_index, sp->idx[n].chunk_num) & mask;
+		while (new_idx[i].msg_len) {
+			i = (i + 1) & mask;
+		}
+		new_idx[i] = sp->idx[n];
+	}
+	free (sp->idx);
+	sp->idx = new_idx;
+	sp->idx_max = new_max;
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Opens a new segment file
+----------------------------------------------------------------------------------------*/
+static int 							/* ID of the segment, or negative if an error occurs*/
+fsc_seg_open (
+	FscT_Seg_Store* sp
+) {
+	char file_path[PATH_MAX + 32];
+	int fd;
+	int i;
+
+	for (i = 0 ; i < FscC_Seg_Max ; i++) {
+		if (sp->segs[i].fd < 0) {
+			break;
+		}
+	}
+	if (i == FscC_Seg_Max) {
+		return (-1);
+	}
+	snprintf (file_path, sizeof (file_path), "%s/" FscC_Seg_File_Name, sp->dir_path, i);
+	fd = open (file_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return (-1);
+	}
+
+	pthread_rwlock_wrlock (&sp->idx_lock);
+	pthread_mutex_lock (&sp->seg_mutex);
+	sp->segs[i].size 	= 0;
+	sp->segs[i].live 	= 0;
+	sp->segs[i].refcnt 	= 0;
+	sp->segs[i].dead_f 	= 0;
+	sp->segs[i].fd 		= fd;
+	pthread_mutex_unlock (&sp->seg_mutex);
+	pthread_rwlock_unlock (&sp->idx_lock);
+
+	return (i);
+}
+/*--------------------------------------------------------------------------------------
+	Writes a record to the active segment
+----------------------------------------------------------------------------------------*/
+static int 							/* The return value is negative if an error occurs	*/
+fsc_seg_write (
+	FscT_Seg_Store* sp,
+	uint32_t con_index,
+	uint32_t chunk_num,
+	const unsigned char* msg,
+	uint16_t msg_len,
+	uint32_t* seg_id,
+	uint32_t* offset
+) {
+	unsigned char wbuff[FscC_Seg_Rec_Head_Size + UINT16_MAX];
+	FscT_Seg_Rec_Head rh;
+	FscT_Seg* seg;
+	uint32_t rec_len = FscC_Seg_Rec_Len (msg_len);
+	uint32_t written = 0;
+	ssize_t res;
+	int id;
+
+	/* Seals the active segment if the record does not fit 	*/
+	seg = &sp->segs[sp->active_id];
+	if (seg->size + rec_len > sp->seg_size) {
+		id = fsc_seg_open (sp);
+		if (id < 0) {
+			return (-1);
+		}
+		sp->active_id = (uint32_t) id;
+		seg = &sp->segs[id];
+	}
+
+	memset (&rh, 0, sizeof (FscT_Seg_Rec_Head));
+	rh.con_index = con_index;
+	rh.chunk_num = chunk_num;
+	rh.msg_len 	 = msg_len;
+	memcpy (wbuff, &rh, FscC_Seg_Rec_Head_Size);
+	memcpy (&wbuff[FscC_Seg_Rec_Head_Size], msg, msg_len);
+
+	while (written < rec_len) {
+		res = pwrite (seg->fd, &wbuff[written], rec_len - written,
+						(off_t)(seg->size + written));
+		if (res < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return (-1);
+		}
+		written += (uint32_t) res;
+	}
+	*seg_id = sp->active_id;
+	*offset = seg->size;
+	seg->size += rec_len;
+
+	return (0);
+}
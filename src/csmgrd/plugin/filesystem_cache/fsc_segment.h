@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * fsc_segment.h
+ */
+#ifndef __CSMGRD_FSC_SEGMENT_HEADER__
+#define __CSMGRD_FSC_SEGMENT_HEADER__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#include <limits.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define FscC_Seg_Max				4096		/* Max number of segment files			*/
+#define FscC_Seg_Size_Default		67108864	/* Default size of a segment (64MB)		*/
+#define FscC_Seg_Size_Min			1048576		/* Min size of a segment (1MB)			*/
+#define FscC_Seg_Size_Max			1073741824	/* Max size of a segment (1GB)			*/
+#define FscC_Seg_Idx_Init_Size		65536		/* Initial number of the index slots	*/
+#define FscC_Seg_Compact_Ratio		50			/* A sealed segment whose live bytes	*/
+												/* are less than this ratio (%) is		*/
+												/* compacted							*/
+#define FscC_Seg_Read_Buff			262144		/* Max bytes read by one pread			*/
+#define FscC_Seg_File_Name			"seg_%u"	/* Name of a segment file				*/
+
+/****************************************************************************************
+ Structure Declarations
+ ****************************************************************************************/
+
+/***** Header of a record in a segment file *****/
+typedef struct {
+	uint32_t		con_index;					/* index of the content in csmgr_stat	*/
+	uint32_t		chunk_num;					/* chunk number							*/
+	uint16_t		msg_len;					/* length of the following message		*/
+	uint16_t		reserve;
+} FscT_Seg_Rec_Head;
+
+#define FscC_Seg_Rec_Head_Size		sizeof (FscT_Seg_Rec_Head)
+
+/***** Location of a record *****/
+typedef struct {
+	uint32_t		seg_id;						/* segment which has the record			*/
+	uint32_t		offset;						/* offset of the record header			*/
+	uint16_t		msg_len;					/* length of the message				*/
+} FscT_Seg_Loc;
+
+/***** Slot of the index *****/
+typedef struct {
+	uint32_t		con_index;
+	uint32_t		chunk_num;
+	uint32_t		seg_id;
+	uint32_t		offset;
+	uint16_t		msg_len;					/* 0 means the slot is empty			*/
+} FscT_Seg_Idx_Entry;
+
+/***** Segment file *****/
+typedef struct {
+	int				fd;							/* -1 means the slot is not used		*/
+	uint32_t		size;						/* bytes written to the segment			*/
+	uint32_t		live;						/* bytes of the records in the index	*/
+	int				refcnt;						/* readers which are reading it			*/
+	int				dead_f;						/* compacted, closed at the last unpin	*/
+} FscT_Seg;
+
+typedef struct {
+	char			dir_path[PATH_MAX];			/* directory of the segment files		*/
+	uint32_t		seg_size;					/* size to seal a segment				*/
+
+	/* index (content index, chunk) -> location, open addressing	*/
+	FscT_Seg_Idx_Entry*	idx;
+	uint32_t		idx_max;					/* number of slots (power of 2)			*/
+	uint32_t		idx_num;					/* number of used slots					*/
+	pthread_rwlock_t idx_lock;					/* protects the index and live bytes	*/
+
+	FscT_Seg		segs[FscC_Seg_Max];
+	uint32_t		active_id;					/* segment which records are added to	*/
+	pthread_mutex_t	seg_mutex;					/* protects refcnt, dead_f and fd		*/
+
+	uint64_t		compact_num;				/* number of compacted segments			*/
+
+	/* called when the compaction moved a record, NULL if not used	*/
+	void			(*move_fn)(void*, const FscT_Seg_Idx_Entry*);
+	void*			move_arg;
+} FscT_Seg_Store;
+
+/****************************************************************************************
+ Global Function Declaration
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the segment store in the specified directory
+----------------------------------------------------------------------------------------*/
+FscT_Seg_Store*
+fsc_seg_store_create (
+	const char* dir_path,						/* directory of the segment files		*/
+	uint32_t seg_size							/* size to seal a segment				*/
+);
+/*--------------------------------------------------------------------------------------
+	Creates the segment store with the segment files left in the specified
+	directory. The Cobs in them are added to the index by fsc_seg_restore.
+----------------------------------------------------------------------------------------*/
+FscT_Seg_Store*
+fsc_seg_store_open (
+	const char* dir_path,						/* directory of the segment files		*/
+	uint32_t seg_size							/* size to seal a segment				*/
+);
+/*--------------------------------------------------------------------------------------
+	Destroys the segment store (segment files are left)
+----------------------------------------------------------------------------------------*/
+void
+fsc_seg_store_destroy (
+	FscT_Seg_Store* sp
+);
+/*--------------------------------------------------------------------------------------
+	Appends a Cob to the active segment and adds it to the index.
+	Only the writer thread calls this function.
+----------------------------------------------------------------------------------------*/
+int 								/* The return value is negative if an error occurs	*/
+fsc_seg_append (
+	FscT_Seg_Store* sp,
+	uint32_t con_index,
+	uint32_t chunk_num,
+	const unsigned char* msg,
+	uint16_t msg_len,
+	FscT_Seg_Loc* loc							/* location of the record (NULL allowed)*/
+);
+/*--------------------------------------------------------------------------------------
+	Adds the Cob left in the segment file to the index.
+	The record at the location is checked before it is added.
+----------------------------------------------------------------------------------------*/
+int 								/* The return value is negative if an error occurs	*/
+fsc_seg_restore (
+	FscT_Seg_Store* sp,
+	uint32_t con_index,
+	uint32_t chunk_num,
+	const FscT_Seg_Loc* loc
+);
+/*--------------------------------------------------------------------------------------
+	Removes a Cob from the index
+----------------------------------------------------------------------------------------*/
+int 								/* Returns 1 if the Cob was in the index			*/
+fsc_seg_remove (
+	FscT_Seg_Store* sp,
+	uint32_t con_index,
+	uint32_t chunk_num
+);
+/*--------------------------------------------------------------------------------------
+	Looks up the Cobs and pins the segments which have them.
+	The locations of the found Cobs are set to locs in the order of chunks.
+----------------------------------------------------------------------------------------*/
+int 								/* number of the found Cobs							*/
+fsc_seg_lookup (
+	FscT_Seg_Store* sp,
+	uint32_t con_index,
+	const uint32_t* chunks,
+	int num,
+	FscT_Seg_Loc* locs
+);
+/*--------------------------------------------------------------------------------------
+	Unpins the segments pinned by fsc_seg_lookup
+----------------------------------------------------------------------------------------*/
+void
+fsc_seg_unpin (
+	FscT_Seg_Store* sp,
+	const FscT_Seg_Loc* locs,
+	int num
+);
+/*--------------------------------------------------------------------------------------
+	Reads the bytes from the pinned segment
+----------------------------------------------------------------------------------------*/
+int 								/* The return value is negative if an error occurs	*/
+fsc_seg_read (
+	FscT_Seg_Store* sp,
+	uint32_t seg_id,
+	uint32_t offset,
+	unsigned char* buff,
+	uint32_t len
+);
+/*--------------------------------------------------------------------------------------
+	Compacts the sealed segment which has the fewest live bytes.
+	Only the writer thread calls this function.
+----------------------------------------------------------------------------------------*/
+int 								/* Returns 1 if a segment was compacted				*/
+fsc_seg_compact (
+	FscT_Seg_Store* sp
+);
+
+#endif // __CSMGRD_FSC_SEGMENT_HEADER__
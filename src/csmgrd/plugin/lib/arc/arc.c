@@ -0,0 +1,523 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * arc.c
+ */
+
+/*
+	arc.c is an ARC (Adaptive Replacement Cache) implementation.
+	The cached entries are listed in T1 (accessed once) or T2 (accessed more than
+	once), and the keys of the entries evicted from them are remembered in the ghost
+	lists B1 and B2. A request for a key in B1 or B2 adapts the target size of T1
+	(p), so that the cache balances recency and frequency by itself and a scan only
+	replaces the entries in T1.
+*/
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include <csmgrd/csmgrd_plugin.h>
+#include "cache_replace_lib.h"
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define ArcC_List_T1				0		/* cached, accessed once 					*/
+#define ArcC_List_T2				1		/* cached, accessed more than once 			*/
+#define ArcC_List_B1				2		/* ghost of entries evicted from T1 		*/
+#define ArcC_List_B2				3		/* ghost of entries evicted from T2 		*/
+#define ArcC_List_Num				4
+
+#define ArcC_Is_Cached(ent)			((ent)->list <= ArcC_List_T2)
+
+/* The entries (cache + ghost, up to twice the capacity) are indexed by int 	*/
+#define ArcC_Capacity_Max			(INT_MAX / 2)
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+/***** structure for listing content entries *****/
+typedef struct {
+	unsigned char 	*key;					/* key of content entry 					*/
+	int 			key_len;				/* length of key 							*/
+	int 			size;					/* msg_len of content entry (0 for ghost) 	*/
+	int 			list;					/* list which lists the entry 				*/
+	int 			next;					/* next (LRU side) entry 					*/
+	int 			prev;					/* previous (MRU side) entry 				*/
+} ArcT_Entry;
+
+/***** structure for a LRU list *****/
+typedef struct {
+	int 			head;					/* MRU entry 								*/
+	int 			tail;					/* LRU entry 								*/
+	int 			count;					/* number of listed entries 				*/
+} ArcT_List;
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static int cache_cap = 0;					/* Maximum number of entries that can be 	*/
+											/* listed (it is the same value as the 		*/
+											/* maximum value of the cache table) 		*/
+
+/* pointers of functions which stores and removes the content entry into/from the cache */
+/* table (implementation of the functions are in a plugin which uses this library) 		*/
+static int (*store_api)(CsmgrdT_Content_Entry*);
+static void (*remove_api)(unsigned char*, int);
+
+static int              cache_count;        /* number of cache entries (T1 + T2)        */
+static uint64_t         cache_bytes;        /* total of msg_len of cache entries        */
+static uint64_t         cache_cap_bytes;    /* byte budget (0 means unlimited)          */
+static uint64_t         hit_count;          /* number of calls of Hit API               */
+static uint64_t         miss_count;         /* number of calls of Miss API              */
+static ArcT_Entry*      cache_entry_list;   /* list for cache and ghost entry           */
+static int*             empty_entry_list;   /* list for empty entry                     */
+static int              entry_num;          /* number of used entries (cache + ghost)   */
+static ArcT_List        lists[ArcC_List_Num];
+static int              target_t1;          /* target size of T1 (p)                    */
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+static void arc_store_entry (CsmgrdT_Content_Entry* entry, int index, int list);
+static void arc_remove_entry (int index, int is_removed);
+static void arc_replace (int in_b2);
+static void arc_ghost_drop (int list);
+static void arc_list_push (int list, int index);
+static void arc_list_unlink (int index);
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Init API
+----------------------------------------------------------------------------------------*/
+int 							/* If the error occurs, this value is a negative value	*/
+init (
+	int capacity, 							/* Maximum number of entries that can be 	*/
+											/* listed (it is the same value as the 		*/
+											/* maximum value of the cache table) 		*/
+	int (*store)(CsmgrdT_Content_Entry*), 	/* store a content entry API 				*/
+	void (*remove)(unsigned char*, int)		/* remove a content entry API 				*/
+) {
+	int i;
+
+	cache_count = 0;
+	cache_bytes = 0;
+	cache_cap_bytes = 0;
+	hit_count = 0;
+	miss_count = 0;
+	entry_num = 0;
+	target_t1 = 0;
+
+	/* Records the capacity of cache		*/
+	if ((capacity < 1) || (capacity > ArcC_Capacity_Max)) {
+		fprintf (stderr, "[ARC LIB] Invalid Cacacity\n");
+		return (-1);
+	}
+	cache_cap = capacity;
+
+	/* Records store and remove APIs 		*/
+	if ((store == NULL) || (remove == NULL)) {
+		fprintf (stderr, "[ARC LIB] Not specified store or remove API\n");
+		return (-1);
+	}
+	store_api 	= store;
+	remove_api 	= remove;
+
+	for (i = 0 ; i < ArcC_List_Num ; i++) {
+		lists[i].head  = -1;
+		lists[i].tail  = -1;
+		lists[i].count = 0;
+	}
+
+	/* Creates the memory pool (the ghost lists remember up to capacity keys) 	*/
+	cache_entry_list = (ArcT_Entry*) calloc ((size_t) cache_cap * 2, sizeof (ArcT_Entry));
+	empty_entry_list = (int*) calloc ((size_t) cache_cap * 2, sizeof (int));
+	if ((cache_entry_list == NULL) || (empty_entry_list == NULL)) {
+		fprintf (stderr, "[ARC LIB] Failed to allocate the entry list\n");
+		free (cache_entry_list);
+		free (empty_entry_list);
+		return (-1);
+	}
+	for (i = 0 ; i < cache_cap * 2 ; i++) {
+		empty_entry_list[i] = i;
+		cache_entry_list[i].next = -1;
+		cache_entry_list[i].prev = -1;
+	}
+
+	/* Creates lookup table */
+	crlib_lookup_table_init (capacity * 2);
+
+	return (0);
+}
+
+/*--------------------------------------------------------------------------------------
+	Destroy API
+----------------------------------------------------------------------------------------*/
+void
+destroy (
+	void
+) {
+	int i;
+
+	for (i = 0 ; i < cache_cap * 2 ; i++) {
+		if (cache_entry_list[i].key != NULL) {
+			free (cache_entry_list[i].key);
+		}
+	}
+	free (cache_entry_list);
+	free (empty_entry_list);
+	cache_entry_list = NULL;
+	empty_entry_list = NULL;
+
+	cache_count 	= 0;
+	cache_bytes 	= 0;
+	cache_cap_bytes = 0;
+	entry_num 		= 0;
+	cache_cap 		= 0;
+	store_api 		= NULL;
+	remove_api 		= NULL;
+	crlib_lookup_table_destroy ();
+}
+
+/*--------------------------------------------------------------------------------------
+	Insert API
+----------------------------------------------------------------------------------------*/
+void
+insert (
+	CsmgrdT_Content_Entry* entry			/* content entry 							*/
+) {
+	unsigned char 	key[CsmgrdC_Key_Max];
+	int 			key_len;
+	int 			index;
+	int 			in_b2 = 0;
+	int 			delta;
+	ArcT_Entry*		ent = NULL;
+
+	key_len = csmgrd_name_chunknum_concatenate (
+					entry->name, entry->name_len, entry->chunk_num, key);
+	index = crlib_lookup_table_search (key, key_len);
+
+	if (index >= 0) {
+		ent = &cache_entry_list[index];
+		if (ArcC_Is_Cached (ent)) {
+			fprintf (stderr, "[ARC LIB] specified entry is already cached\n");
+			return;
+		}
+		/* The key is remembered in a ghost list, adapts the target size of T1 	*/
+		if (ent->list == ArcC_List_B1) {
+			delta = (lists[ArcC_List_B2].count > lists[ArcC_List_B1].count) ?
+				lists[ArcC_List_B2].count / lists[ArcC_List_B1].count : 1;
+			target_t1 = (target_t1 + delta < cache_cap) ? target_t1 + delta : cache_cap;
+		} else {
+			delta = (lists[ArcC_List_B1].count > lists[ArcC_List_B2].count) ?
+				lists[ArcC_List_B1].count / lists[ArcC_List_B2].count : 1;
+			target_t1 = (target_t1 > delta) ? target_t1 - delta : 0;
+			in_b2 = 1;
+		}
+	} else {
+		/* Keeps T1 + B1 <= c and T1 + T2 + B1 + B2 <= 2c 	*/
+		if (lists[ArcC_List_T1].count + lists[ArcC_List_B1].count >= cache_cap) {
+			if (lists[ArcC_List_B1].count > 0) {
+				arc_ghost_drop (ArcC_List_B1);
+			} else {
+				arc_remove_entry (lists[ArcC_List_T1].tail, 0);
+			}
+		} else if (entry_num >= cache_cap * 2) {
+			arc_ghost_drop (
+				(lists[ArcC_List_B2].count > 0) ? ArcC_List_B2 : ArcC_List_B1);
+		}
+	}
+
+	/* Evicts entries until both the number and the byte budget are met 	*/
+	while ((cache_count > 0) &&
+		   ((cache_count >= cache_cap) ||
+			((cache_cap_bytes > 0) &&
+			 (cache_bytes + entry->msg_len > cache_cap_bytes)))) {
+		arc_replace (in_b2);
+	}
+
+	if (ent != NULL) {
+		/* The ghost is cached again as an entry accessed more than once 	*/
+		arc_list_unlink (index);
+		arc_store_entry (entry, index, ArcC_List_T2);
+	} else {
+		if (entry_num >= cache_cap * 2) {
+			arc_ghost_drop (
+				(lists[ArcC_List_B1].count > 0) ? ArcC_List_B1 : ArcC_List_B2);
+		}
+		index = empty_entry_list[entry_num];
+		entry_num++;
+		cache_entry_list[index].key = (unsigned char*) calloc (1, key_len);
+		memcpy (cache_entry_list[index].key, key, key_len);
+		cache_entry_list[index].key_len = key_len;
+		crlib_lookup_table_add (key, key_len, index);
+		arc_store_entry (entry, index, ArcC_List_T1);
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+	Erase API
+----------------------------------------------------------------------------------------*/
+void
+erase (
+	unsigned char* key, 					/* key of content entry removed from cache 	*/
+											/* table									*/
+	int key_len								/* length of the key 						*/
+) {
+	int index = crlib_lookup_table_search (key, key_len);
+	if ((index < 0) || !ArcC_Is_Cached (&cache_entry_list[index])) {
+		fprintf (stderr, "[ARC LIB] failed to erace\n");
+		return;
+	}
+	arc_remove_entry (index, 1);
+}
+
+/*--------------------------------------------------------------------------------------
+	Hit API
+----------------------------------------------------------------------------------------*/
+void
+hit (
+	unsigned char* key, 					/* key of the content entry hits in the 	*/
+											/* cache table 								*/
+	int key_len								/* length of the key 						*/
+) {
+	int index;
+
+	hit_count++;
+	index = crlib_lookup_table_search (key, key_len);
+	if ((index < 0) || !ArcC_Is_Cached (&cache_entry_list[index])) {
+		fprintf (stderr, "[ARC LIB] invalid hit\n");
+		return;
+	}
+	arc_list_unlink (index);
+	arc_list_push (ArcC_List_T2, index);
+}
+
+/*--------------------------------------------------------------------------------------
+	Miss API
+----------------------------------------------------------------------------------------*/
+void
+miss (
+	unsigned char* key, 					/* key of the content entry fails to hit 	*/
+											/* in the cache table						*/
+	int key_len								/* length of the key 						*/
+) {
+	/* The ghost lists are consulted when the content is inserted 	*/
+	miss_count++;
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Status API
+----------------------------------------------------------------------------------------*/
+void
+status (
+	void* arg								/* state information						*/
+) {
+	CsmgrdT_Lib_Status* stat = (CsmgrdT_Lib_Status*) arg;
+
+	if (stat == NULL) {
+		return;
+	}
+	stat->cache_cobs 		= (uint64_t) cache_count;
+	stat->cache_bytes 		= cache_bytes;
+	stat->capacity_bytes 	= cache_cap_bytes;
+	stat->hit_count 		= hit_count;
+	stat->miss_count 		= miss_count;
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Capacity Bytes API
+----------------------------------------------------------------------------------------*/
+int 							/* If the error occurs, this value is a negative value	*/
+capacity_bytes_set (
+	uint64_t capacity_bytes					/* maximum total of msg_len of the entries 	*/
+											/* (0 means unlimited)						*/
+) {
+	cache_cap_bytes = capacity_bytes;
+	return (0);
+}
+
+/*--------------------------------------------------------------------------------------
+	Static Functions
+----------------------------------------------------------------------------------------*/
+/*-----
+	Lists the entry whose key has been registered into T1 or T2, and stores it
+-----*/
+static void
+arc_store_entry (
+	CsmgrdT_Content_Entry* entry,
+	int index,
+	int list
+) {
+	cache_entry_list[index].size = entry->msg_len;
+	arc_list_push (list, index);
+	(*store_api)(entry);
+	cache_count++;
+	cache_bytes += entry->msg_len;
+}
+
+/*-----
+	Removes the cached entry without remembering it in the ghost lists
+-----*/
+static void
+arc_remove_entry (
+	int index,
+	int is_removed
+) {
+	ArcT_Entry* rsentry = &cache_entry_list[index];
+
+	arc_list_unlink (index);
+	crlib_lookup_table_remove (rsentry->key, rsentry->key_len);
+	if (!is_removed) {
+		(*remove_api)(rsentry->key, rsentry->key_len);
+	}
+	free (rsentry->key);
+	cache_bytes -= rsentry->size;
+	cache_count--;
+	memset (rsentry, 0, sizeof (ArcT_Entry));
+	rsentry->next = -1;
+	rsentry->prev = -1;
+	entry_num--;
+	empty_entry_list[entry_num] = index;
+}
+
+/*-----
+	REPLACE of ARC: evicts the LRU entry of T1 or T2 into the ghost list
+-----*/
+static void
+arc_replace (
+	int in_b2
+) {
+	int index;
+	int t1 = lists[ArcC_List_T1].count;
+	ArcT_Entry* ent;
+
+	if ((t1 > 0) &&
+		((t1 > target_t1) || (in_b2 && (t1 == target_t1)) ||
+		 (lists[ArcC_List_T2].count == 0))) {
+		index = lists[ArcC_List_T1].tail;
+		arc_list_unlink (index);
+		arc_list_push (ArcC_List_B1, index);
+	} else {
+		index = lists[ArcC_List_T2].tail;
+		arc_list_unlink (index);
+		arc_list_push (ArcC_List_B2, index);
+	}
+	ent = &cache_entry_list[index];
+	(*remove_api)(ent->key, ent->key_len);
+	cache_bytes -= ent->size;
+	cache_count--;
+	ent->size = 0;
+}
+
+/*-----
+	Forgets the LRU key of the specified ghost list
+-----*/
+static void
+arc_ghost_drop (
+	int list
+) {
+	int index = lists[list].tail;
+	ArcT_Entry* ent;
+
+	if (index < 0) {
+		return;
+	}
+	ent = &cache_entry_list[index];
+	arc_list_unlink (index);
+	crlib_lookup_table_remove (ent->key, ent->key_len);
+	free (ent->key);
+	memset (ent, 0, sizeof (ArcT_Entry));
+	ent->next = -1;
+	ent->prev = -1;
+	entry_num--;
+	empty_entry_list[entry_num] = index;
+}
+
+/*-----
+	Lists the entry at the MRU position of the specified list
+-----*/
+static void
+arc_list_push (
+	int list,
+	int index
+) {
+	ArcT_List* lp = &lists[list];
+	ArcT_Entry* ent = &cache_entry_list[index];
+
+	ent->list = list;
+	ent->prev = -1;
+	ent->next = lp->head;
+	if (lp->head >= 0) {
+		cache_entry_list[lp->head].prev = index;
+	} else {
+		lp->tail = index;
+	}
+	lp->head = index;
+	lp->count++;
+}
+
+/*-----
+	Unlinks the entry from the list which lists it
+-----*/
+static void
+arc_list_unlink (
+	int index
+) {
+	ArcT_Entry* ent = &cache_entry_list[index];
+	ArcT_List* lp = &lists[ent->list];
+
+	if (ent->prev >= 0) {
+		cache_entry_list[ent->prev].next = ent->next;
+	} else {
+		lp->head = ent->next;
+	}
+	if (ent->next >= 0) {
+		cache_entry_list[ent->next].prev = ent->prev;
+	} else {
+		lp->tail = ent->prev;
+	}
+	ent->next = -1;
+	ent->prev = -1;
+	lp->count--;
+}
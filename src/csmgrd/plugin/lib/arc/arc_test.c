@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * arc_test.c
+ */
+
+/*
+	arc_test.c checks that Init API rejects a capacity whose cache and ghost
+	entries cannot be indexed, and that the cache and the ghost lists stay
+	within the capacity while the evicted keys are inserted again.
+*/
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include <csmgrd/csmgrd_plugin.h>
+#include "arc.h"
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define ArcT_Test_Cap			4
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static unsigned char	test_name[] = { 0x00, 0x01, 0x00, 0x04, 't', 'e', 's', 't' };
+static int				test_cached = 0;					/* entries in the "plugin" 	*/
+static int				test_fail = 0;
+
+/****************************************************************************************
+ Static Functions
+ ****************************************************************************************/
+
+static int
+test_store (
+	CsmgrdT_Content_Entry* entry
+) {
+	test_cached++;
+	return (0);
+}
+
+static void
+test_remove (
+	unsigned char* key,
+	int key_len
+) {
+	test_cached--;
+}
+
+static void
+test_insert (
+	uint32_t chunk_num
+) {
+	CsmgrdT_Content_Entry entry;
+
+	memset (&entry, 0, sizeof (CsmgrdT_Content_Entry));
+	entry.name 		= test_name;
+	entry.name_len 	= sizeof (test_name);
+	entry.chunk_num = chunk_num;
+	entry.msg_len 	= 1024;
+	insert (&entry);
+}
+
+static void
+test_expect (
+	const char* what,
+	uint64_t value,
+	uint64_t expected
+) {
+	if (value != expected) {
+		fprintf (stderr, "FAIL: %s = %llu (expected %llu)\n", what,
+			(unsigned long long) value, (unsigned long long) expected);
+		test_fail = 1;
+	}
+}
+
+static void
+test_run (
+	void
+) {
+	CsmgrdT_Lib_Status stat;
+	uint32_t i;
+
+	/* twice the capacity does not fit in int 	*/
+	test_expect ("init (INT_MAX)",
+		init (INT_MAX, test_store, test_remove) < 0, 1);
+	test_expect ("init (INT_MAX / 2 + 1)",
+		init (INT_MAX / 2 + 1, test_store, test_remove) < 0, 1);
+
+	if (init (ArcT_Test_Cap, test_store, test_remove) < 0) {
+		fprintf (stderr, "FAIL: init\n");
+		test_fail = 1;
+		return;
+	}
+
+	/* The evicted keys are remembered as ghosts and inserted again 	*/
+	for (i = 0 ; i < ArcT_Test_Cap * 8 ; i++) {
+		test_insert (i % (ArcT_Test_Cap * 3));
+	}
+	memset (&stat, 0, sizeof (CsmgrdT_Lib_Status));
+	status (&stat);
+	test_expect ("cache_cobs", stat.cache_cobs, ArcT_Test_Cap);
+	test_expect ("cached", (uint64_t) test_cached, ArcT_Test_Cap);
+	test_expect ("cache_bytes", stat.cache_bytes, ArcT_Test_Cap * 1024);
+
+	destroy ();
+}
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+int
+main (
+	int argc,
+	char** argv
+) {
+	test_run ();
+
+	if (test_fail) {
+		return (1);
+	}
+	fprintf (stderr, "arc_test: OK\n");
+	return (0);
+}
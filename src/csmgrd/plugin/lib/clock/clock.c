@@ -0,0 +1,397 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * clock.c
+ */
+
+/*
+	clock.c is a CLOCK (second chance) implementation, an approximation of LRU.
+	The entries are placed on a ring and a hand sweeps it at the eviction. An entry
+	whose reference bit is set is given a second chance (the bit is cleared and the
+	hand moves on), and the first entry whose bit is clear is evicted.
+	When the cache plugin registers the function which tests and clears the
+	reference bit kept in its content entry (Reference bit API), a hit is the
+	setting of that bit in the plugin, and Hit API only counts the hit without
+	touching the ring, so that the plugin can call it without its lock.
+*/
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <csmgrd/csmgrd_plugin.h>
+#include "cache_replace_lib.h"
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+/***** structure for listing content entries *****/
+typedef struct {
+	unsigned char 	*key;					/* key of content entry (NULL: empty slot) 	*/
+	int 			key_len;				/* length of key 							*/
+	int 			size;					/* msg_len of content entry 				*/
+	int 			ref;					/* reference bit used when the plugin does 	*/
+											/* not register Reference bit API 			*/
+} ClockT_Entry;
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static int cache_cap = 0;					/* Maximum number of entries that can be 	*/
+											/* listed (it is the same value as the 		*/
+											/* maximum value of the cache table) 		*/
+
+/* pointers of functions which stores and removes the content entry into/from the cache */
+/* table (implementation of the functions are in a plugin which uses this library) 		*/
+static int (*store_api)(CsmgrdT_Content_Entry*);
+static void (*remove_api)(unsigned char*, int);
+
+/* pointer of function which tests and clears the reference bit kept in the plugin 	*/
+static int (*reference_api)(unsigned char*, int) = NULL;
+
+static int              cache_count;        /* number of cache entries                  */
+static uint64_t         cache_bytes;        /* total of msg_len of cache entries        */
+static uint64_t         cache_cap_bytes;    /* byte budget (0 means unlimited)          */
+static uint64_t         hit_count;          /* number of calls of Hit API               */
+static uint64_t         miss_count;         /* number of calls of Miss API              */
+static ClockT_Entry*    cache_entry_list;   /* ring of cache entry                      */
+static int*             empty_entry_list;   /* list for empty cache entry               */
+static int              clock_hand;         /* next entry examined by the hand          */
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+static void clock_store_entry (CsmgrdT_Content_Entry* entry, int index);
+static void clock_remove_entry (int index, int is_removed);
+static void clock_evict (void);
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Init API
+----------------------------------------------------------------------------------------*/
+int 							/* If the error occurs, this value is a negative value	*/
+init (
+	int capacity, 							/* Maximum number of entries that can be 	*/
+											/* listed (it is the same value as the 		*/
+											/* maximum value of the cache table) 		*/
+	int (*store)(CsmgrdT_Content_Entry*), 	/* store a content entry API 				*/
+	void (*remove)(unsigned char*, int)		/* remove a content entry API 				*/
+) {
+	int i;
+
+	cache_count = 0;
+	cache_bytes = 0;
+	cache_cap_bytes = 0;
+	hit_count = 0;
+	miss_count = 0;
+	clock_hand = 0;
+	reference_api = NULL;
+
+	/* Records the capacity of cache		*/
+	if (capacity < 1) {
+		fprintf (stderr, "[CLOCK LIB] Invalid Cacacity\n");
+		return (-1);
+	}
+	cache_cap = capacity;
+
+	/* Records store and remove APIs 		*/
+	if ((store == NULL) || (remove == NULL)) {
+		fprintf (stderr, "[CLOCK LIB] Not specified store or remove API\n");
+		return (-1);
+	}
+	store_api 	= store;
+	remove_api 	= remove;
+
+	/* Creates the ring 					*/
+	cache_entry_list = (ClockT_Entry*) calloc (cache_cap, sizeof (ClockT_Entry));
+	empty_entry_list = (int*) calloc (cache_cap, sizeof (int));
+	if ((cache_entry_list == NULL) || (empty_entry_list == NULL)) {
+		fprintf (stderr, "[CLOCK LIB] Failed to allocate the entry list\n");
+		free (cache_entry_list);
+		free (empty_entry_list);
+		return (-1);
+	}
+	for (i = 0 ; i < cache_cap ; i++) {
+		empty_entry_list[i] = i;
+	}
+
+	/* Creates lookup table */
+	crlib_lookup_table_init (capacity);
+
+	return (0);
+}
+
+/*--------------------------------------------------------------------------------------
+	Destroy API
+----------------------------------------------------------------------------------------*/
+void
+destroy (
+	void
+) {
+	int i;
+
+	for (i = 0 ; i < cache_cap ; i++) {
+		if (cache_entry_list[i].key != NULL) {
+			free (cache_entry_list[i].key);
+		}
+	}
+	free (cache_entry_list);
+	free (empty_entry_list);
+	cache_entry_list = NULL;
+	empty_entry_list = NULL;
+
+	cache_count 	= 0;
+	cache_bytes 	= 0;
+	cache_cap_bytes = 0;
+	cache_cap 		= 0;
+	store_api 		= NULL;
+	remove_api 		= NULL;
+	reference_api 	= NULL;
+	crlib_lookup_table_destroy ();
+}
+
+/*--------------------------------------------------------------------------------------
+	Insert API
+----------------------------------------------------------------------------------------*/
+void
+insert (
+	CsmgrdT_Content_Entry* entry			/* content entry 							*/
+) {
+	unsigned char 	key[CsmgrdC_Key_Max];
+	int 			key_len;
+
+	key_len = csmgrd_name_chunknum_concatenate (
+					entry->name, entry->name_len, entry->chunk_num, key);
+	if (crlib_lookup_table_search (key, key_len) >= 0) {
+		fprintf (stderr, "[CLOCK LIB] specified entry is already cached\n");
+		return;
+	}
+
+	/* Evicts entries until both the number and the byte budget are met 	*/
+	while ((cache_count > 0) &&
+		   ((cache_count >= cache_cap) ||
+			((cache_cap_bytes > 0) &&
+			 (cache_bytes + entry->msg_len > cache_cap_bytes)))) {
+		clock_evict ();
+	}
+	clock_store_entry (entry, empty_entry_list[cache_count]);
+}
+
+/*--------------------------------------------------------------------------------------
+	Erase API
+----------------------------------------------------------------------------------------*/
+void
+erase (
+	unsigned char* key, 					/* key of content entry removed from cache 	*/
+											/* table									*/
+	int key_len								/* length of the key 						*/
+) {
+	int index = crlib_lookup_table_search (key, key_len);
+	if (index < 0) {
+		fprintf (stderr, "[CLOCK LIB] failed to erace\n");
+		return;
+	}
+	clock_remove_entry (index, 1);
+}
+
+/*--------------------------------------------------------------------------------------
+	Hit API
+----------------------------------------------------------------------------------------*/
+void
+hit (
+	unsigned char* key, 					/* key of the content entry hits in the 	*/
+											/* cache table 								*/
+	int key_len								/* length of the key 						*/
+) {
+	int index;
+
+	/* When the plugin registers Reference bit API, it keeps the bit itself 	*/
+	/* and calls this API without its lock, so only the counter is updated 	*/
+	__atomic_add_fetch (&hit_count, 1, __ATOMIC_RELAXED);
+	if (reference_api) {
+		return;
+	}
+	index = crlib_lookup_table_search (key, key_len);
+	if (index < 0) {
+		fprintf (stderr, "[CLOCK LIB] invalid hit\n");
+		return;
+	}
+	cache_entry_list[index].ref = 1;
+}
+
+/*--------------------------------------------------------------------------------------
+	Miss API
+----------------------------------------------------------------------------------------*/
+void
+miss (
+	unsigned char* key, 					/* key of the content entry fails to hit 	*/
+											/* in the cache table						*/
+	int key_len								/* length of the key 						*/
+) {
+	miss_count++;
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Status API
+----------------------------------------------------------------------------------------*/
+void
+status (
+	void* arg								/* state information						*/
+) {
+	CsmgrdT_Lib_Status* stat = (CsmgrdT_Lib_Status*) arg;
+
+	if (stat == NULL) {
+		return;
+	}
+	stat->cache_cobs 		= (uint64_t) cache_count;
+	stat->cache_bytes 		= cache_bytes;
+	stat->capacity_bytes 	= cache_cap_bytes;
+	stat->hit_count 		= __atomic_load_n (&hit_count, __ATOMIC_RELAXED);
+	stat->miss_count 		= miss_count;
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Capacity Bytes API
+----------------------------------------------------------------------------------------*/
+int 							/* If the error occurs, this value is a negative value	*/
+capacity_bytes_set (
+	uint64_t capacity_bytes					/* maximum total of msg_len of the entries 	*/
+											/* (0 means unlimited)						*/
+) {
+	cache_cap_bytes = capacity_bytes;
+	return (0);
+}
+
+/*--------------------------------------------------------------------------------------
+	Reference bit API
+----------------------------------------------------------------------------------------*/
+int 							/* If the error occurs, this value is a negative value	*/
+reference_api_set (
+	int (*reference)(unsigned char*, int)	/* tests and clears the reference bit 		*/
+											/* (returns 1 if it was set, 0 if it was	*/
+											/* clear, negative if not cached)			*/
+) {
+	if (reference == NULL) {
+		return (-1);
+	}
+	reference_api = reference;
+	return (0);
+}
+
+/*--------------------------------------------------------------------------------------
+	Static Functions
+----------------------------------------------------------------------------------------*/
+static void
+clock_store_entry (
+	CsmgrdT_Content_Entry* entry,
+	int index
+) {
+	unsigned char 	key[CsmgrdC_Key_Max];
+	int 			key_len;
+	ClockT_Entry*	rsentry;
+
+	key_len = csmgrd_name_chunknum_concatenate (
+					entry->name, entry->name_len, entry->chunk_num, key);
+	rsentry = &cache_entry_list[index];
+	rsentry->key = (unsigned char*) calloc (1, key_len);
+	memcpy (rsentry->key, key, key_len);
+	rsentry->key_len = key_len;
+	rsentry->size = entry->msg_len;
+	rsentry->ref = 0;
+	crlib_lookup_table_add (rsentry->key, rsentry->key_len, index);
+	(*store_api)(entry);
+	cache_count++;
+	cache_bytes += rsentry->size;
+}
+
+static void
+clock_remove_entry (
+	int index,
+	int is_removed
+) {
+	ClockT_Entry* rsentry = &cache_entry_list[index];
+
+	crlib_lookup_table_remove (rsentry->key, rsentry->key_len);
+	if (!is_removed) {
+		(*remove_api)(rsentry->key, rsentry->key_len);
+	}
+	free (rsentry->key);
+	cache_bytes -= rsentry->size;
+	memset (rsentry, 0, sizeof (ClockT_Entry));
+	cache_count--;
+	empty_entry_list[cache_count] = index;
+}
+
+/*-----
+	Sweeps the ring and evicts the first entry whose reference bit is clear
+-----*/
+static void
+clock_evict (
+	void
+) {
+	ClockT_Entry* ent;
+	int ref;
+
+	while (cache_count > 0) {
+		ent = &cache_entry_list[clock_hand];
+		if (ent->key == NULL) {
+			clock_hand = (clock_hand + 1) % cache_cap;
+			continue;
+		}
+		if (reference_api) {
+			ref = (*reference_api)(ent->key, ent->key_len);
+		} else {
+			ref = ent->ref;
+			ent->ref = 0;
+		}
+		if (ref > 0) {
+			/* second chance 	*/
+			clock_hand = (clock_hand + 1) % cache_cap;
+			continue;
+		}
+		clock_remove_entry (clock_hand, 0);
+		clock_hand = (clock_hand + 1) % cache_cap;
+		return;
+	}
+}
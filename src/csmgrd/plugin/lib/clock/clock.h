@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * clock.h
+ */
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <csmgrd/csmgrd_plugin.h>
+
+
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+
+
+/****************************************************************************************
+ Function Declaration
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Init API
+----------------------------------------------------------------------------------------*/
+int 							/* If the error occurs, this value is a negative value	*/
+init (
+	int capacity, 							/* Maximum number of entries that can be 	*/
+											/* listed (it is the same value as the 		*/
+											/* maximum value of the cache table) 		*/
+	int (*store)(CsmgrdT_Content_Entry*), 	/* store a content entry API 				*/
+	void (*remove)(unsigned char*, int)		/* remove a content entry API 				*/
+);
+/*--------------------------------------------------------------------------------------
+	Destroy API
+----------------------------------------------------------------------------------------*/
+void 
+destroy (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Insert API
+----------------------------------------------------------------------------------------*/
+void 
+insert (
+	CsmgrdT_Content_Entry* entry			/* content entry 							*/
+);
+
+/*--------------------------------------------------------------------------------------
+	Rrase API
+----------------------------------------------------------------------------------------*/
+void 
+erase (
+	unsigned char* key, 					/* key of content entry removed from cache 	*/
+											/* table									*/
+	int key_len								/* length of the key 						*/
+);
+
+/*--------------------------------------------------------------------------------------
+	Hit API
+----------------------------------------------------------------------------------------*/
+void 
+hit (
+	unsigned char* key, 					/* key of the content entry hits in the 	*/
+											/* cache table 								*/
+	int key_len								/* length of the key 						*/
+);
+
+/*--------------------------------------------------------------------------------------
+	Miss API
+----------------------------------------------------------------------------------------*/
+void 
+miss (
+	unsigned char* key, 					/* key of the content entry fails to hit 	*/
+											/* in the cache table						*/
+	int key_len								/* length of the key 						*/
+);
+
+/*--------------------------------------------------------------------------------------
+	Status API
+----------------------------------------------------------------------------------------*/
+void 
+status (
+	void* arg								/* state information						*/
+);
+
+/*--------------------------------------------------------------------------------------
+	Capacity Bytes API
+----------------------------------------------------------------------------------------*/
+int 							/* If the error occurs, this value is a negative value	*/
+capacity_bytes_set (
+	uint64_t capacity_bytes					/* maximum total of msg_len of the entries 	*/
+											/* (0 means unlimited)						*/
+);
+
+/*--------------------------------------------------------------------------------------
+	Reference bit API
+----------------------------------------------------------------------------------------*/
+int 							/* If the error occurs, this value is a negative value	*/
+reference_api_set (
+	int (*reference)(unsigned char*, int)	/* tests and clears the reference bit 		*/
+											/* (returns 1 if it was set, 0 if it was	*/
+											/* clear, negative if not cached)			*/
+);
+
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * clock_test.c
+ */
+
+/*
+	clock_test.c checks that Hit API counts the hits both when the library keeps
+	the reference bits and when the cache plugin keeps them (Reference bit API).
+*/
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <csmgrd/csmgrd_plugin.h>
+#include "clock.h"
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define ClockT_Test_Cap			4
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static unsigned char	test_name[] = { 0x00, 0x01, 0x00, 0x04, 't', 'e', 's', 't' };
+static int				test_ref_bit[ClockT_Test_Cap + 1];	/* kept by the "plugin" 	*/
+static int				test_removed = -1;					/* chunk removed at last 	*/
+static int				test_fail = 0;
+
+/****************************************************************************************
+ Static Functions
+ ****************************************************************************************/
+
+static int
+test_store (
+	CsmgrdT_Content_Entry* entry
+) {
+	return (0);
+}
+
+static void
+test_remove (
+	unsigned char* key,
+	int key_len
+) {
+	uint32_t chunk_num;
+
+	/* The chunk number follows the name in the key 	*/
+	memcpy (&chunk_num, &key[key_len - sizeof (chunk_num)], sizeof (chunk_num));
+	test_removed = (int) ntohl (chunk_num);
+}
+
+static int
+test_reference (
+	unsigned char* key,
+	int key_len
+) {
+	uint32_t chunk_num;
+	int ref;
+
+	memcpy (&chunk_num, &key[key_len - sizeof (chunk_num)], sizeof (chunk_num));
+	chunk_num = ntohl (chunk_num);
+	ref = test_ref_bit[chunk_num];
+	test_ref_bit[chunk_num] = 0;
+	return (ref);
+}
+
+static void
+test_insert (
+	uint32_t chunk_num
+) {
+	CsmgrdT_Content_Entry entry;
+
+	memset (&entry, 0, sizeof (CsmgrdT_Content_Entry));
+	entry.name 		= test_name;
+	entry.name_len 	= sizeof (test_name);
+	entry.chunk_num = chunk_num;
+	entry.msg_len 	= 1024;
+	insert (&entry);
+}
+
+static void
+test_hit (
+	uint32_t chunk_num
+) {
+	unsigned char key[CsmgrdC_Key_Max];
+	int key_len;
+
+	key_len = csmgrd_name_chunknum_concatenate (
+					test_name, sizeof (test_name), chunk_num, key);
+	hit (key, key_len);
+}
+
+static void
+test_expect (
+	const char* what,
+	uint64_t value,
+	uint64_t expected
+) {
+	if (value != expected) {
+		fprintf (stderr, "FAIL: %s = %llu (expected %llu)\n", what,
+			(unsigned long long) value, (unsigned long long) expected);
+		test_fail = 1;
+	}
+}
+
+static void
+test_run (
+	int ref_api_f
+) {
+	CsmgrdT_Lib_Status stat;
+	uint32_t i;
+
+	memset (test_ref_bit, 0, sizeof (test_ref_bit));
+	test_removed = -1;
+	if (init (ClockT_Test_Cap, test_store, test_remove) < 0) {
+		fprintf (stderr, "FAIL: init\n");
+		test_fail = 1;
+		return;
+	}
+	if (ref_api_f) {
+		reference_api_set (test_reference);
+	}
+	for (i = 0 ; i < ClockT_Test_Cap ; i++) {
+		test_insert (i);
+	}
+
+	/* A lookup hit of chunk 0 sets the bit in the plugin and calls Hit API 	*/
+	if (ref_api_f) {
+		test_ref_bit[0] = 1;
+	}
+	test_hit (0);
+
+	memset (&stat, 0, sizeof (CsmgrdT_Lib_Status));
+	status (&stat);
+	test_expect (ref_api_f ? "hit_count (reference bit API)" : "hit_count",
+		stat.hit_count, 1);
+
+	/* Chunk 0 is given the second chance, so chunk 1 is evicted 	*/
+	test_insert (ClockT_Test_Cap);
+	test_expect (ref_api_f ? "evicted (reference bit API)" : "evicted",
+		(uint64_t) test_removed, 1);
+
+	destroy ();
+}
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+int
+main (
+	int argc,
+	char** argv
+) {
+	test_run (0);
+	test_run (1);
+
+	if (test_fail) {
+		return (1);
+	}
+	fprintf (stderr, "clock_test: OK\n");
+	return (0);
+}
@@ -62,6 +62,7 @@ typedef struct {
 	unsigned char 	*key;					/* key of content entry 					*/
 
 	int 			key_len;				/* length of key 							*/
+    int             size;                   /* msg_len of content entry                 */
     int             freq;
     int             track;
 } LfuT_Entry;
@@ -85,6 +86,10 @@ static int              counts[LfuC_Max_Frequency];
 static CefT_Mp_Handle   lfu_mp;
 
 static int              cache_count;        /* number of cache entries                  */
+static uint64_t         cache_bytes;        /* total of msg_len of cache entries        */
+static uint64_t         cache_cap_bytes;    /* byte budget (0 means unlimited)          */
+static uint64_t         hit_count;          /* number of calls of Hit API               */
+static uint64_t         miss_count;         /* number of calls of Miss API              */
 
 /****************************************************************************************
  Static Function Declaration
@@ -113,6 +118,10 @@ init (
     int i;
     max_freq = 0;
     cache_count = 0;
+    cache_bytes = 0;
+    cache_cap_bytes = 0;
+    hit_count = 0;
+    miss_count = 0;
     
 	/* Records the capacity of cache		*/
 	if (capacity < 1) {
@@ -151,6 +160,8 @@ destroy (
 ) {
     max_freq = 0;
     cache_count = 0;
+    cache_bytes = 0;
+    cache_cap_bytes = 0;
 	cache_cap 		= 0;
 	store_api 		= NULL;
 	remove_api 		= NULL;
@@ -172,7 +183,11 @@ insert (
         fprintf(stderr, "[LFU LIB] insert: ERROR: specified entry is already cached.\n");
         return;
     }
-    if (cache_count >= cache_cap) {
+    /* Evicts entries until both the number and the byte budget are met 	*/
+    while ((cache_count > 0) &&
+           ((cache_count >= cache_cap) ||
+            ((cache_cap_bytes > 0) &&
+             (cache_bytes + entry->msg_len > cache_cap_bytes)))) {
         LfuT_Entry* victim_entry;
         while (1) {
             removing_freq = lfu_get_min_freq_ring_having_entry();
@@ -220,7 +235,10 @@ hit (
 	int key_len								/* length of the key 						*/
 ) {
     int preFreq, proFreq;
-    LfuT_Entry* entry = (LfuT_Entry*) crlib_lookup_table_search_v(key, key_len);
+    LfuT_Entry* entry;
+
+    hit_count++;
+    entry = (LfuT_Entry*) crlib_lookup_table_search_v(key, key_len);
     if (entry == NULL) {
         fprintf(stderr, "[LFU LIB] failed to erace\n");
         return;
@@ -245,7 +263,7 @@ miss (
 											/* in the cache table						*/
 	int key_len								/* length of the key 						*/
 ) {
-    // NOTHING TO DO
+	miss_count++;
 	return;
 }
 
@@ -256,10 +274,31 @@ void
 status (
 	void* arg								/* state information						*/
 ) {
-	// TODO
+	CsmgrdT_Lib_Status* stat = (CsmgrdT_Lib_Status*) arg;
+
+	if (stat == NULL) {
+		return;
+	}
+	stat->cache_cobs 		= (uint64_t) cache_count;
+	stat->cache_bytes 		= cache_bytes;
+	stat->capacity_bytes 	= cache_cap_bytes;
+	stat->hit_count 		= hit_count;
+	stat->miss_count 		= miss_count;
 	return;
 }
 
+/*--------------------------------------------------------------------------------------
+	Capacity Bytes API
+----------------------------------------------------------------------------------------*/
+int 							/* If the error occurs, this value is a negative value	*/
+capacity_bytes_set (
+	uint64_t capacity_bytes					/* maximum total of msg_len of the entries 	*/
+											/* (0 means unlimited)						*/
+) {
+	cache_cap_bytes = capacity_bytes;
+	return (0);
+}
+
 /*--------------------------------------------------------------------------------------
 	Static Functions
 ----------------------------------------------------------------------------------------*/
@@ -278,11 +317,13 @@ static void lfu_store_entry(
   	q = calloc(1, key_len);
     memcpy(q, key, key_len);
 	rsentry->key = q;
+    rsentry->size = entry->msg_len;
     rsentry->freq = 0;
     rsentry->track = 1;
     cef_rngque_push(rings[0], rsentry);
     counts[0]++;
     cache_count++;
+    cache_bytes += rsentry->size;
     crlib_lookup_table_add_v(rsentry->key, rsentry->key_len, rsentry);
     (*store_api)(entry);
 }
@@ -294,6 +335,7 @@ static void lfu_remove_entry(
     crlib_lookup_table_remove(entry->key, entry->key_len);
     counts[entry->freq]--;
     cache_count--;
+    cache_bytes -= entry->size;
     entry->freq = -1;
     if (!is_removed) (*remove_api)(entry->key, entry->key_len);
 
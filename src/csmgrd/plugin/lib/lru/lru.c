@@ -60,6 +60,7 @@ typedef struct _LrufT_Entry {
 	unsigned char 	*key;					/* key of content entry 					*/
 
 	int 			key_len;				/* length of key 							*/
+    int             size;                   /* msg_len of content entry                 */
     int             valid;
     int             next;
     int             prev;
@@ -80,6 +81,10 @@ static void (*remove_api)(unsigned char*, int);
 
 static int              lru_index, mru_index;
 static int              cache_count;        /* number of cache entries                  */
+static uint64_t         cache_bytes;        /* total of msg_len of cache entries        */
+static uint64_t         cache_cap_bytes;    /* byte budget (0 means unlimited)          */
+static uint64_t         hit_count;          /* number of calls of Hit API               */
+static uint64_t         miss_count;         /* number of calls of Miss API              */
 static LrufT_Entry*     cache_entry_list;   /* list for cache entry                     */
 static int*             empty_entry_list;   /* list for empty cache entry               */
 
@@ -108,6 +113,10 @@ init (
 ) {
     int i;
     cache_count = 0;
+    cache_bytes = 0;
+    cache_cap_bytes = 0;
+    hit_count = 0;
+    miss_count = 0;
     
 	/* Records the capacity of cache		*/
 	if (capacity < 1) {
@@ -150,6 +159,8 @@ destroy (
 	void
 ) {
     cache_count = 0;
+    cache_bytes = 0;
+    cache_cap_bytes = 0;
 	cache_cap 		= 0;
 	store_api 		= NULL;
 	remove_api 		= NULL;
@@ -174,7 +185,11 @@ void
 insert (
 	CsmgrdT_Content_Entry* entry			/* content entry 							*/
 ) {
-    if (cache_count >= cache_cap) {
+    /* Evicts entries until both the number and the byte budget are met 	*/
+    while ((cache_count > 0) &&
+           ((cache_count >= cache_cap) ||
+            ((cache_cap_bytes > 0) &&
+             (cache_bytes + entry->msg_len > cache_cap_bytes)))) {
     	lru_remove_entry(lru_index, 0);
     }
 	lru_store_entry(entry, empty_entry_list[cache_count]);
@@ -206,7 +221,10 @@ hit (
 											/* cache table 								*/
 	int key_len								/* length of the key 						*/
 ) {
-    int index = crlib_lookup_table_search(key, key_len);
+    int index;
+
+    hit_count++;
+    index = crlib_lookup_table_search(key, key_len);
     if (index < 0) {
         fprintf(stderr, "[LRU LIB] invalid hit\n");
         return;
@@ -224,7 +242,7 @@ miss (
 											/* in the cache table						*/
 	int key_len								/* length of the key 						*/
 ) {
-    // NOTHING TO DO
+	miss_count++;
 	return;
 }
 
@@ -235,10 +253,31 @@ void
 status (
 	void* arg								/* state information						*/
 ) {
-	// TODO
+	CsmgrdT_Lib_Status* stat = (CsmgrdT_Lib_Status*) arg;
+
+	if (stat == NULL) {
+		return;
+	}
+	stat->cache_cobs 		= (uint64_t) cache_count;
+	stat->cache_bytes 		= cache_bytes;
+	stat->capacity_bytes 	= cache_cap_bytes;
+	stat->hit_count 		= hit_count;
+	stat->miss_count 		= miss_count;
 	return;
 }
 
+/*--------------------------------------------------------------------------------------
+	Capacity Bytes API
+----------------------------------------------------------------------------------------*/
+int 							/* If the error occurs, this value is a negative value	*/
+capacity_bytes_set (
+	uint64_t capacity_bytes					/* maximum total of msg_len of the entries 	*/
+											/* (0 means unlimited)						*/
+) {
+	cache_cap_bytes = capacity_bytes;
+	return (0);
+}
+
 
 /*--------------------------------------------------------------------------------------
 	Static Functions
@@ -256,6 +295,7 @@ static void lru_store_entry(
                     entry->name, entry->name_len, entry->chunk_num, key);
     rsentry = &cache_entry_list[index];
     rsentry->key_len = key_len;
+    rsentry->size = entry->msg_len;
   	q = calloc(1, key_len);
     memcpy(q, key, key_len);
 	rsentry->key = q;
@@ -263,6 +303,7 @@ static void lru_store_entry(
     crlib_lookup_table_add(rsentry->key, rsentry->key_len, index);
     (*store_api)(entry);
     cache_count++;
+    cache_bytes += rsentry->size;
 }
 
 static void lru_remove_entry(
@@ -276,6 +317,7 @@ static void lru_remove_entry(
     if (!is_removed) (*remove_api)(rsentry->key, rsentry->key_len);
 
 	free(rsentry->key);
+    cache_bytes -= rsentry->size;
     memset(rsentry, 0, sizeof(LrufT_Entry));
     cache_count--;
     empty_entry_list[cache_count] = index;
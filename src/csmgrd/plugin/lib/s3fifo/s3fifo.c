@@ -0,0 +1,535 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * s3fifo.c
+ */
+
+/*
+	s3fifo.c is a S3-FIFO implementation.
+	A new entry is listed in the small FIFO (S). An entry which is accessed again
+	while it is in S is moved to the main FIFO (M) when it reaches the tail of S,
+	the others are evicted and their keys are remembered in the ghost FIFO (G).
+	A new entry whose key is in G is listed directly in M. An entry at the tail of
+	M is reinserted into M while its access counter is not zero, so that a scan
+	passes through S and does not flush M.
+	A hit only increments the access counter of the entry, no list is modified.
+*/
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <csmgrd/csmgrd_plugin.h>
+#include "cache_replace_lib.h"
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define S3fifoC_Queue_Small			0		/* small FIFO 								*/
+#define S3fifoC_Queue_Main			1		/* main FIFO 								*/
+#define S3fifoC_Queue_Ghost			2		/* ghost FIFO (keys only) 					*/
+#define S3fifoC_Queue_Num			3
+
+#define S3fifoC_Small_Percent		10		/* ratio of S to the capacity 				*/
+#define S3fifoC_Freq_Max			3		/* saturation value of the access counter 	*/
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+/***** structure for listing content entries *****/
+typedef struct {
+	unsigned char 	*key;					/* key of content entry 					*/
+	int 			key_len;				/* length of key 							*/
+	int 			size;					/* msg_len of content entry (0 for ghost) 	*/
+	int 			freq;					/* access counter 							*/
+	int 			queue;					/* queue which lists the entry 				*/
+	int 			next;					/* next (older) entry 						*/
+	int 			prev;					/* previous (newer) entry 					*/
+} S3fifoT_Entry;
+
+/***** structure for a FIFO queue *****/
+typedef struct {
+	int 			head;					/* newest entry 							*/
+	int 			tail;					/* oldest entry 							*/
+	int 			count;					/* number of listed entries 				*/
+	int 			cap;					/* maximum number of listed entries 		*/
+} S3fifoT_Queue;
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static int cache_cap = 0;					/* Maximum number of entries that can be 	*/
+											/* listed (it is the same value as the 		*/
+											/* maximum value of the cache table) 		*/
+
+/* pointers of functions which stores and removes the content entry into/from the cache */
+/* table (implementation of the functions are in a plugin which uses this library) 		*/
+static int (*store_api)(CsmgrdT_Content_Entry*);
+static void (*remove_api)(unsigned char*, int);
+
+static int              cache_count;        /* number of cache entries (S + M)          */
+static uint64_t         cache_bytes;        /* total of msg_len of cache entries        */
+static uint64_t         cache_cap_bytes;    /* byte budget (0 means unlimited)          */
+static uint64_t         hit_count;          /* number of calls of Hit API               */
+static uint64_t         miss_count;         /* number of calls of Miss API              */
+static S3fifoT_Entry*   cache_entry_list;   /* list for cache and ghost entry           */
+static int*             empty_entry_list;   /* list for empty entry                     */
+static int              entry_num;          /* number of used entries (cache + ghost)   */
+static int              entry_max;          /* size of the entry list                   */
+static S3fifoT_Queue    queues[S3fifoC_Queue_Num];
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+static void s3fifo_store_entry (CsmgrdT_Content_Entry* entry, int index, int queue);
+static void s3fifo_remove_entry (int index, int is_removed);
+static void s3fifo_evict (void);
+static void s3fifo_ghost_drop (void);
+static void s3fifo_queue_push (int queue, int index);
+static void s3fifo_queue_unlink (int index);
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Init API
+----------------------------------------------------------------------------------------*/
+int 							/* If the error occurs, this value is a negative value	*/
+init (
+	int capacity, 							/* Maximum number of entries that can be 	*/
+											/* listed (it is the same value as the 		*/
+											/* maximum value of the cache table) 		*/
+	int (*store)(CsmgrdT_Content_Entry*), 	/* store a content entry API 				*/
+	void (*remove)(unsigned char*, int)		/* remove a content entry API 				*/
+) {
+	int i;
+
+	cache_count = 0;
+	cache_bytes = 0;
+	cache_cap_bytes = 0;
+	hit_count = 0;
+	miss_count = 0;
+	entry_num = 0;
+
+	/* Records the capacity of cache		*/
+	if (capacity < 1) {
+		fprintf (stderr, "[S3-FIFO LIB] Invalid Cacacity\n");
+		return (-1);
+	}
+	cache_cap = capacity;
+
+	/* Records store and remove APIs 		*/
+	if ((store == NULL) || (remove == NULL)) {
+		fprintf (stderr, "[S3-FIFO LIB] Not specified store or remove API\n");
+		return (-1);
+	}
+	store_api 	= store;
+	remove_api 	= remove;
+
+	/* Splits the capacity into S and M, G remembers as many keys as M 	*/
+	for (i = 0 ; i < S3fifoC_Queue_Num ; i++) {
+		queues[i].head  = -1;
+		queues[i].tail  = -1;
+		queues[i].count = 0;
+	}
+	queues[S3fifoC_Queue_Small].cap = capacity * S3fifoC_Small_Percent / 100;
+	if (queues[S3fifoC_Queue_Small].cap < 1) {
+		queues[S3fifoC_Queue_Small].cap = 1;
+	}
+	queues[S3fifoC_Queue_Main].cap  = capacity - queues[S3fifoC_Queue_Small].cap;
+	queues[S3fifoC_Queue_Ghost].cap = queues[S3fifoC_Queue_Main].cap;
+	if (queues[S3fifoC_Queue_Ghost].cap < 1) {
+		queues[S3fifoC_Queue_Ghost].cap = 1;
+	}
+	entry_max = capacity + queues[S3fifoC_Queue_Ghost].cap;
+
+	/* Creates the memory pool 				*/
+	cache_entry_list = (S3fifoT_Entry*) calloc (entry_max, sizeof (S3fifoT_Entry));
+	empty_entry_list = (int*) calloc (entry_max, sizeof (int));
+	if ((cache_entry_list == NULL) || (empty_entry_list == NULL)) {
+		fprintf (stderr, "[S3-FIFO LIB] Failed to allocate the entry list\n");
+		free (cache_entry_list);
+		free (empty_entry_list);
+		return (-1);
+	}
+	for (i = 0 ; i < entry_max ; i++) {
+		empty_entry_list[i] = i;
+		cache_entry_list[i].next = -1;
+		cache_entry_list[i].prev = -1;
+	}
+
+	/* Creates lookup table */
+	crlib_lookup_table_init (entry_max);
+
+	return (0);
+}
+
+/*--------------------------------------------------------------------------------------
+	Destroy API
+----------------------------------------------------------------------------------------*/
+void
+destroy (
+	void
+) {
+	int i;
+
+	for (i = 0 ; i < entry_max ; i++) {
+		if (cache_entry_list[i].key != NULL) {
+			free (cache_entry_list[i].key);
+		}
+	}
+	free (cache_entry_list);
+	free (empty_entry_list);
+	cache_entry_list = NULL;
+	empty_entry_list = NULL;
+
+	cache_count 	= 0;
+	cache_bytes 	= 0;
+	cache_cap_bytes = 0;
+	entry_num 		= 0;
+	entry_max 		= 0;
+	cache_cap 		= 0;
+	store_api 		= NULL;
+	remove_api 		= NULL;
+	crlib_lookup_table_destroy ();
+}
+
+/*--------------------------------------------------------------------------------------
+	Insert API
+----------------------------------------------------------------------------------------*/
+void
+insert (
+	CsmgrdT_Content_Entry* entry			/* content entry 							*/
+) {
+	unsigned char 	key[CsmgrdC_Key_Max];
+	int 			key_len;
+	int 			index;
+
+	key_len = csmgrd_name_chunknum_concatenate (
+					entry->name, entry->name_len, entry->chunk_num, key);
+	index = crlib_lookup_table_search (key, key_len);
+
+	if ((index >= 0) &&
+		(cache_entry_list[index].queue != S3fifoC_Queue_Ghost)) {
+		fprintf (stderr, "[S3-FIFO LIB] specified entry is already cached\n");
+		return;
+	}
+
+	/* Evicts entries until both the number and the byte budget are met 	*/
+	while ((cache_count > 0) &&
+		   ((cache_count >= cache_cap) ||
+			((cache_cap_bytes > 0) &&
+			 (cache_bytes + entry->msg_len > cache_cap_bytes)))) {
+		s3fifo_evict ();
+	}
+
+	/* The evictions above may have forgotten the ghost 	*/
+	index = crlib_lookup_table_search (key, key_len);
+
+	if (index >= 0) {
+		/* The key is remembered in G, the entry is listed in M 	*/
+		s3fifo_queue_unlink (index);
+		s3fifo_store_entry (entry, index, S3fifoC_Queue_Main);
+	} else {
+		if (entry_num >= entry_max) {
+			s3fifo_ghost_drop ();
+		}
+		index = empty_entry_list[entry_num];
+		entry_num++;
+		cache_entry_list[index].key = (unsigned char*) calloc (1, key_len);
+		memcpy (cache_entry_list[index].key, key, key_len);
+		cache_entry_list[index].key_len = key_len;
+		crlib_lookup_table_add (key, key_len, index);
+		s3fifo_store_entry (entry, index, S3fifoC_Queue_Small);
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+	Erase API
+----------------------------------------------------------------------------------------*/
+void
+erase (
+	unsigned char* key, 					/* key of content entry removed from cache 	*/
+											/* table									*/
+	int key_len								/* length of the key 						*/
+) {
+	int index = crlib_lookup_table_search (key, key_len);
+	if ((index < 0) ||
+		(cache_entry_list[index].queue == S3fifoC_Queue_Ghost)) {
+		fprintf (stderr, "[S3-FIFO LIB] failed to erace\n");
+		return;
+	}
+	s3fifo_remove_entry (index, 1);
+}
+
+/*--------------------------------------------------------------------------------------
+	Hit API
+----------------------------------------------------------------------------------------*/
+void
+hit (
+	unsigned char* key, 					/* key of the content entry hits in the 	*/
+											/* cache table 								*/
+	int key_len								/* length of the key 						*/
+) {
+	int index;
+	S3fifoT_Entry* ent;
+
+	hit_count++;
+	index = crlib_lookup_table_search (key, key_len);
+	if (index < 0) {
+		fprintf (stderr, "[S3-FIFO LIB] invalid hit\n");
+		return;
+	}
+	ent = &cache_entry_list[index];
+	if ((ent->queue != S3fifoC_Queue_Ghost) && (ent->freq < S3fifoC_Freq_Max)) {
+		ent->freq++;
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+	Miss API
+----------------------------------------------------------------------------------------*/
+void
+miss (
+	unsigned char* key, 					/* key of the content entry fails to hit 	*/
+											/* in the cache table						*/
+	int key_len								/* length of the key 						*/
+) {
+	/* G is consulted when the content is inserted 	*/
+	miss_count++;
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Status API
+----------------------------------------------------------------------------------------*/
+void
+status (
+	void* arg								/* state information						*/
+) {
+	CsmgrdT_Lib_Status* stat = (CsmgrdT_Lib_Status*) arg;
+
+	if (stat == NULL) {
+		return;
+	}
+	stat->cache_cobs 		= (uint64_t) cache_count;
+	stat->cache_bytes 		= cache_bytes;
+	stat->capacity_bytes 	= cache_cap_bytes;
+	stat->hit_count 		= hit_count;
+	stat->miss_count 		= miss_count;
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Capacity Bytes API
+----------------------------------------------------------------------------------------*/
+int 							/* If the error occurs, this value is a negative value	*/
+capacity_bytes_set (
+	uint64_t capacity_bytes					/* maximum total of msg_len of the entries 	*/
+											/* (0 means unlimited)						*/
+) {
+	cache_cap_bytes = capacity_bytes;
+	return (0);
+}
+
+/*--------------------------------------------------------------------------------------
+	Static Functions
+----------------------------------------------------------------------------------------*/
+/*-----
+	Lists the entry whose key has been registered into S or M, and stores it
+-----*/
+static void
+s3fifo_store_entry (
+	CsmgrdT_Content_Entry* entry,
+	int index,
+	int queue
+) {
+	cache_entry_list[index].size = entry->msg_len;
+	cache_entry_list[index].freq = 0;
+	s3fifo_queue_push (queue, index);
+	(*store_api)(entry);
+	cache_count++;
+	cache_bytes += entry->msg_len;
+}
+
+/*-----
+	Removes the cached entry without remembering it in G
+-----*/
+static void
+s3fifo_remove_entry (
+	int index,
+	int is_removed
+) {
+	S3fifoT_Entry* rsentry = &cache_entry_list[index];
+
+	s3fifo_queue_unlink (index);
+	crlib_lookup_table_remove (rsentry->key, rsentry->key_len);
+	if (!is_removed) {
+		(*remove_api)(rsentry->key, rsentry->key_len);
+	}
+	free (rsentry->key);
+	cache_bytes -= rsentry->size;
+	cache_count--;
+	memset (rsentry, 0, sizeof (S3fifoT_Entry));
+	rsentry->next = -1;
+	rsentry->prev = -1;
+	entry_num--;
+	empty_entry_list[entry_num] = index;
+}
+
+/*-----
+	Evicts one cached entry from S or M
+-----*/
+static void
+s3fifo_evict (
+	void
+) {
+	int index;
+	S3fifoT_Entry* ent;
+
+	while (cache_count > 0) {
+		if ((queues[S3fifoC_Queue_Small].count > 0) &&
+			((queues[S3fifoC_Queue_Small].count >= queues[S3fifoC_Queue_Small].cap) ||
+			 (queues[S3fifoC_Queue_Main].count == 0))) {
+			index = queues[S3fifoC_Queue_Small].tail;
+			ent = &cache_entry_list[index];
+			s3fifo_queue_unlink (index);
+
+			if (ent->freq > 0) {
+				/* accessed again while it is in S, moves to M 	*/
+				ent->freq = 0;
+				s3fifo_queue_push (S3fifoC_Queue_Main, index);
+				continue;
+			}
+			/* evicts the entry and remembers its key in G 	*/
+			(*remove_api)(ent->key, ent->key_len);
+			cache_bytes -= ent->size;
+			cache_count--;
+			ent->size = 0;
+			ent->freq = 0;
+			s3fifo_queue_push (S3fifoC_Queue_Ghost, index);
+			if (queues[S3fifoC_Queue_Ghost].count > queues[S3fifoC_Queue_Ghost].cap) {
+				s3fifo_ghost_drop ();
+			}
+			return;
+		}
+
+		index = queues[S3fifoC_Queue_Main].tail;
+		ent = &cache_entry_list[index];
+		if (ent->freq > 0) {
+			/* reinserts the entry into M 	*/
+			ent->freq--;
+			s3fifo_queue_unlink (index);
+			s3fifo_queue_push (S3fifoC_Queue_Main, index);
+			continue;
+		}
+		s3fifo_remove_entry (index, 0);
+		return;
+	}
+}
+
+/*-----
+	Forgets the oldest key in G
+-----*/
+static void
+s3fifo_ghost_drop (
+	void
+) {
+	int index = queues[S3fifoC_Queue_Ghost].tail;
+	S3fifoT_Entry* ent;
+
+	if (index < 0) {
+		return;
+	}
+	ent = &cache_entry_list[index];
+	s3fifo_queue_unlink (index);
+	crlib_lookup_table_remove (ent->key, ent->key_len);
+	free (ent->key);
+	memset (ent, 0, sizeof (S3fifoT_Entry));
+	ent->next = -1;
+	ent->prev = -1;
+	entry_num--;
+	empty_entry_list[entry_num] = index;
+}
+
+/*-----
+	Lists the entry at the head of the specified queue
+-----*/
+static void
+s3fifo_queue_push (
+	int queue,
+	int index
+) {
+	S3fifoT_Queue* qp = &queues[queue];
+	S3fifoT_Entry* ent = &cache_entry_list[index];
+
+	ent->queue = queue;
+	ent->prev  = -1;
+	ent->next  = qp->head;
+	if (qp->head >= 0) {
+		cache_entry_list[qp->head].prev = index;
+	} else {
+		qp->tail = index;
+	}
+	qp->head = index;
+	qp->count++;
+}
+
+/*-----
+	Unlinks the entry from the queue which lists it
+-----*/
+static void
+s3fifo_queue_unlink (
+	int index
+) {
+	S3fifoT_Entry* ent = &cache_entry_list[index];
+	S3fifoT_Queue* qp = &queues[ent->queue];
+
+	if (ent->prev >= 0) {
+		cache_entry_list[ent->prev].next = ent->next;
+	} else {
+		qp->head = ent->next;
+	}
+	if (ent->next >= 0) {
+		cache_entry_list[ent->next].prev = ent->prev;
+	} else {
+		qp->tail = ent->prev;
+	}
+	ent->next = -1;
+	ent->prev = -1;
+	qp->count--;
+}
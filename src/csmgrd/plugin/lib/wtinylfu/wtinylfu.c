@@ -0,0 +1,519 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * wtinylfu.c
+ */
+
+/*
+	wtinylfu.c is a W-TinyLFU implementation.
+	A new entry is listed in a small window LRU. When the window overflows, its LRU
+	entry (candidate) competes with the LRU entry of the main SLRU (victim) and only
+	the one estimated to be accessed more often by a Count-Min Sketch is kept.
+	Therefore, chunks which are accessed only once by a scan do not flush the main
+	cache.
+*/
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <csmgrd/csmgrd_plugin.h>
+#include <cefore/cef_sketch.h>
+#include "cache_replace_lib.h"
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define WtlfuC_Seg_Window			0		/* window LRU 								*/
+#define WtlfuC_Seg_Probation		1		/* probation segment of main SLRU 			*/
+#define WtlfuC_Seg_Protected		2		/* protected segment of main SLRU 			*/
+#define WtlfuC_Seg_Num				3
+
+#define WtlfuC_Window_Percent		1		/* ratio of window to the capacity 			*/
+#define WtlfuC_Protected_Percent	80		/* ratio of protected to the main SLRU 		*/
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+/***** structure for listing content entries *****/
+typedef struct {
+	unsigned char 	*key;					/* key of content entry 					*/
+	int 			key_len;				/* length of key 							*/
+	int 			size;					/* msg_len of content entry 				*/
+	int 			seg;					/* segment which lists the entry 			*/
+	int 			next;					/* next (LRU side) entry 					*/
+	int 			prev;					/* previous (MRU side) entry 				*/
+} WtlfuT_Entry;
+
+/***** structure for a segment (LRU list) *****/
+typedef struct {
+	int 			head;					/* MRU entry 								*/
+	int 			tail;					/* LRU entry 								*/
+	int 			count;					/* number of listed entries 				*/
+	int 			cap;					/* maximum number of listed entries 		*/
+} WtlfuT_List;
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static int cache_cap = 0;					/* Maximum number of entries that can be 	*/
+											/* listed (it is the same value as the 		*/
+											/* maximum value of the cache table) 		*/
+
+/* pointers of functions which stores and removes the content entry into/from the cache */
+/* table (implementation of the functions are in a plugin which uses this library) 		*/
+static int (*store_api)(CsmgrdT_Content_Entry*);
+static void (*remove_api)(unsigned char*, int);
+
+static int              cache_count;        /* number of cache entries                  */
+static uint64_t         cache_bytes;        /* total of msg_len of cache entries        */
+static uint64_t         cache_cap_bytes;    /* byte budget (0 means unlimited)          */
+static uint64_t         hit_count;          /* number of calls of Hit API               */
+static uint64_t         miss_count;         /* number of calls of Miss API              */
+static WtlfuT_Entry*    cache_entry_list;   /* list for cache entry                     */
+static int*             empty_entry_list;   /* list for empty cache entry               */
+static WtlfuT_List      segs[WtlfuC_Seg_Num];
+static int              main_cap;           /* capacity of main SLRU                    */
+static CefT_Sketch*     sketch = NULL;      /* frequency sketch for admission           */
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+static void wtlfu_store_entry (CsmgrdT_Content_Entry* entry, int index);
+static void wtlfu_remove_entry (int index, int is_removed);
+static void wtlfu_evict (void);
+static void wtlfu_list_push (int seg, int index);
+static void wtlfu_list_unlink (int index);
+static int  wtlfu_key_get (CsmgrdT_Content_Entry* entry, unsigned char* key);
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Init API
+----------------------------------------------------------------------------------------*/
+int 							/* If the error occurs, this value is a negative value	*/
+init (
+	int capacity, 							/* Maximum number of entries that can be 	*/
+											/* listed (it is the same value as the 		*/
+											/* maximum value of the cache table) 		*/
+	int (*store)(CsmgrdT_Content_Entry*), 	/* store a content entry API 				*/
+	void (*remove)(unsigned char*, int)		/* remove a content entry API 				*/
+) {
+	int i;
+
+	cache_count = 0;
+	cache_bytes = 0;
+	cache_cap_bytes = 0;
+	hit_count = 0;
+	miss_count = 0;
+
+	/* Records the capacity of cache		*/
+	if (capacity < 1) {
+		fprintf (stderr, "[W-TinyLFU LIB] Invalid Cacacity\n");
+		return (-1);
+	}
+	cache_cap = capacity;
+
+	/* Records store and remove APIs 		*/
+	if ((store == NULL) || (remove == NULL)) {
+		fprintf (stderr, "[W-TinyLFU LIB] Not specified store or remove API\n");
+		return (-1);
+	}
+	store_api 	= store;
+	remove_api 	= remove;
+
+	/* Splits the capacity into the window and the main SLRU 	*/
+	memset (segs, 0, sizeof (segs));
+	for (i = 0 ; i < WtlfuC_Seg_Num ; i++) {
+		segs[i].head = -1;
+		segs[i].tail = -1;
+	}
+	segs[WtlfuC_Seg_Window].cap = capacity * WtlfuC_Window_Percent / 100;
+	if (segs[WtlfuC_Seg_Window].cap < 1) {
+		segs[WtlfuC_Seg_Window].cap = 1;
+	}
+	main_cap = capacity - segs[WtlfuC_Seg_Window].cap;
+	segs[WtlfuC_Seg_Protected].cap = main_cap * WtlfuC_Protected_Percent / 100;
+	segs[WtlfuC_Seg_Probation].cap = main_cap - segs[WtlfuC_Seg_Protected].cap;
+
+	/* Creates the memory pool 				*/
+	cache_entry_list = (WtlfuT_Entry*) calloc (cache_cap, sizeof (WtlfuT_Entry));
+	empty_entry_list = (int*) calloc (cache_cap, sizeof (int));
+	if ((cache_entry_list == NULL) || (empty_entry_list == NULL)) {
+		fprintf (stderr, "[W-TinyLFU LIB] Failed to allocate the entry list\n");
+		free (cache_entry_list);
+		free (empty_entry_list);
+		return (-1);
+	}
+	for (i = 0 ; i < cache_cap ; i++) {
+		empty_entry_list[i] = i;
+		cache_entry_list[i].next = -1;
+		cache_entry_list[i].prev = -1;
+	}
+
+	/* Creates the frequency sketch 		*/
+	sketch = cef_sketch_create ((uint32_t) capacity);
+	if (sketch == NULL) {
+		fprintf (stderr, "[W-TinyLFU LIB] Failed to create the sketch\n");
+		free (cache_entry_list);
+		free (empty_entry_list);
+		return (-1);
+	}
+
+	/* Creates lookup table */
+	crlib_lookup_table_init (capacity);
+
+	return (0);
+}
+
+/*--------------------------------------------------------------------------------------
+	Destroy API
+----------------------------------------------------------------------------------------*/
+void
+destroy (
+	void
+) {
+	int i;
+
+	for (i = 0 ; i < cache_cap ; i++) {
+		if (cache_entry_list[i].key != NULL) {
+			free (cache_entry_list[i].key);
+		}
+	}
+	free (cache_entry_list);
+	free (empty_entry_list);
+	cache_entry_list = NULL;
+	empty_entry_list = NULL;
+
+	cef_sketch_destroy (sketch);
+	sketch = NULL;
+
+	cache_count 	= 0;
+	cache_bytes 	= 0;
+	cache_cap_bytes = 0;
+	cache_cap 		= 0;
+	store_api 		= NULL;
+	remove_api 		= NULL;
+	crlib_lookup_table_destroy ();
+}
+
+/*--------------------------------------------------------------------------------------
+	Insert API
+----------------------------------------------------------------------------------------*/
+void
+insert (
+	CsmgrdT_Content_Entry* entry			/* content entry 							*/
+) {
+	unsigned char 	key[CsmgrdC_Key_Max];
+	int 			key_len;
+
+	key_len = wtlfu_key_get (entry, key);
+	if (crlib_lookup_table_search (key, key_len) >= 0) {
+		fprintf (stderr, "[W-TinyLFU LIB] specified entry is already cached\n");
+		return;
+	}
+
+	/* Evicts entries until both the number and the byte budget are met 	*/
+	while ((cache_count > 0) &&
+		   ((cache_count >= cache_cap) ||
+			((cache_cap_bytes > 0) &&
+			 (cache_bytes + entry->msg_len > cache_cap_bytes)))) {
+		wtlfu_evict ();
+	}
+	wtlfu_store_entry (entry, empty_entry_list[cache_count]);
+
+	/* Overflow of the window is moved to the main SLRU while it has a room 	*/
+	while ((segs[WtlfuC_Seg_Window].count > segs[WtlfuC_Seg_Window].cap) &&
+		   (segs[WtlfuC_Seg_Probation].count +
+		   		segs[WtlfuC_Seg_Protected].count < main_cap)) {
+		int index = segs[WtlfuC_Seg_Window].tail;
+		wtlfu_list_unlink (index);
+		wtlfu_list_push (WtlfuC_Seg_Probation, index);
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+	Erase API
+----------------------------------------------------------------------------------------*/
+void
+erase (
+	unsigned char* key, 					/* key of content entry removed from cache 	*/
+											/* table									*/
+	int key_len								/* length of the key 						*/
+) {
+	int index = crlib_lookup_table_search (key, key_len);
+	if (index < 0) {
+		fprintf (stderr, "[W-TinyLFU LIB] failed to erace\n");
+		return;
+	}
+	wtlfu_remove_entry (index, 1);
+}
+
+/*--------------------------------------------------------------------------------------
+	Hit API
+----------------------------------------------------------------------------------------*/
+void
+hit (
+	unsigned char* key, 					/* key of the content entry hits in the 	*/
+											/* cache table 								*/
+	int key_len								/* length of the key 						*/
+) {
+	int index;
+	int demote;
+
+	hit_count++;
+	cef_sketch_increment (sketch, key, key_len);
+
+	index = crlib_lookup_table_search (key, key_len);
+	if (index < 0) {
+		fprintf (stderr, "[W-TinyLFU LIB] invalid hit\n");
+		return;
+	}
+
+	switch (cache_entry_list[index].seg) {
+		case WtlfuC_Seg_Probation: {
+			/* Promotes to the protected segment 	*/
+			wtlfu_list_unlink (index);
+			wtlfu_list_push (WtlfuC_Seg_Protected, index);
+			while (segs[WtlfuC_Seg_Protected].count > segs[WtlfuC_Seg_Protected].cap) {
+				demote = segs[WtlfuC_Seg_Protected].tail;
+				wtlfu_list_unlink (demote);
+				wtlfu_list_push (WtlfuC_Seg_Probation, demote);
+			}
+			break;
+		}
+		default: {
+			wtlfu_list_unlink (index);
+			wtlfu_list_push (cache_entry_list[index].seg, index);
+			break;
+		}
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+	Miss API
+----------------------------------------------------------------------------------------*/
+void
+miss (
+	unsigned char* key, 					/* key of the content entry fails to hit 	*/
+											/* in the cache table						*/
+	int key_len								/* length of the key 						*/
+) {
+	/* Requests for the content which is not cached also count for the admission 	*/
+	miss_count++;
+	cef_sketch_increment (sketch, key, key_len);
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Status API
+----------------------------------------------------------------------------------------*/
+void
+status (
+	void* arg								/* state information						*/
+) {
+	CsmgrdT_Lib_Status* stat = (CsmgrdT_Lib_Status*) arg;
+
+	if (stat == NULL) {
+		return;
+	}
+	stat->cache_cobs 		= (uint64_t) cache_count;
+	stat->cache_bytes 		= cache_bytes;
+	stat->capacity_bytes 	= cache_cap_bytes;
+	stat->hit_count 		= hit_count;
+	stat->miss_count 		= miss_count;
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Capacity Bytes API
+----------------------------------------------------------------------------------------*/
+int 							/* If the error occurs, this value is a negative value	*/
+capacity_bytes_set (
+	uint64_t capacity_bytes					/* maximum total of msg_len of the entries 	*/
+											/* (0 means unlimited)						*/
+) {
+	cache_cap_bytes = capacity_bytes;
+	return (0);
+}
+
+/*--------------------------------------------------------------------------------------
+	Static Functions
+----------------------------------------------------------------------------------------*/
+static int
+wtlfu_key_get (
+	CsmgrdT_Content_Entry* entry,
+	unsigned char* key
+) {
+	return (csmgrd_name_chunknum_concatenate (
+				entry->name, entry->name_len, entry->chunk_num, key));
+}
+
+static void
+wtlfu_store_entry (
+	CsmgrdT_Content_Entry* entry,
+	int index
+) {
+	unsigned char 	key[CsmgrdC_Key_Max];
+	int 			key_len;
+	WtlfuT_Entry*	rsentry;
+
+	key_len = wtlfu_key_get (entry, key);
+	rsentry = &cache_entry_list[index];
+	rsentry->key = (unsigned char*) calloc (1, key_len);
+	memcpy (rsentry->key, key, key_len);
+	rsentry->key_len = key_len;
+	rsentry->size = entry->msg_len;
+	wtlfu_list_push (WtlfuC_Seg_Window, index);
+	crlib_lookup_table_add (rsentry->key, rsentry->key_len, index);
+	(*store_api)(entry);
+	cache_count++;
+	cache_bytes += rsentry->size;
+}
+
+static void
+wtlfu_remove_entry (
+	int index,
+	int is_removed
+) {
+	WtlfuT_Entry* rsentry;
+
+	wtlfu_list_unlink (index);
+	rsentry = &cache_entry_list[index];
+	crlib_lookup_table_remove (rsentry->key, rsentry->key_len);
+	if (!is_removed) {
+		(*remove_api)(rsentry->key, rsentry->key_len);
+	}
+
+	free (rsentry->key);
+	cache_bytes -= rsentry->size;
+	memset (rsentry, 0, sizeof (WtlfuT_Entry));
+	rsentry->next = -1;
+	rsentry->prev = -1;
+	cache_count--;
+	empty_entry_list[cache_count] = index;
+}
+
+/*-----
+	Evicts one entry: the LRU entry of the window competes with the LRU entry
+	of the main SLRU by the estimated frequency
+-----*/
+static void
+wtlfu_evict (
+	void
+) {
+	int cand = -1;
+	int victim;
+
+	if (segs[WtlfuC_Seg_Window].count >= segs[WtlfuC_Seg_Window].cap) {
+		cand = segs[WtlfuC_Seg_Window].tail;
+	}
+	victim = segs[WtlfuC_Seg_Probation].tail;
+	if (victim < 0) {
+		victim = segs[WtlfuC_Seg_Protected].tail;
+	}
+
+	if (victim < 0) {
+		/* main SLRU is empty 	*/
+		wtlfu_remove_entry (segs[WtlfuC_Seg_Window].tail, 0);
+		return;
+	}
+	if (cand < 0) {
+		/* window has a room, evicts from the main SLRU 	*/
+		wtlfu_remove_entry (victim, 0);
+		return;
+	}
+
+	if (cef_sketch_admit (sketch,
+			cache_entry_list[cand].key, cache_entry_list[cand].key_len,
+			cache_entry_list[victim].key, cache_entry_list[victim].key_len)) {
+		wtlfu_remove_entry (victim, 0);
+		wtlfu_list_unlink (cand);
+		wtlfu_list_push (WtlfuC_Seg_Probation, cand);
+	} else {
+		wtlfu_remove_entry (cand, 0);
+	}
+}
+
+/*-----
+	Lists the entry at the MRU position of the specified segment
+-----*/
+static void
+wtlfu_list_push (
+	int seg,
+	int index
+) {
+	WtlfuT_List* list = &segs[seg];
+	WtlfuT_Entry* ent = &cache_entry_list[index];
+
+	ent->seg  = seg;
+	ent->prev = -1;
+	ent->next = list->head;
+	if (list->head >= 0) {
+		cache_entry_list[list->head].prev = index;
+	} else {
+		list->tail = index;
+	}
+	list->head = index;
+	list->count++;
+}
+
+/*-----
+	Unlinks the entry from the segment which lists it
+-----*/
+static void
+wtlfu_list_unlink (
+	int index
+) {
+	WtlfuT_Entry* ent = &cache_entry_list[index];
+	WtlfuT_List* list = &segs[ent->seg];
+
+	if (ent->prev >= 0) {
+		cache_entry_list[ent->prev].next = ent->next;
+	} else {
+		list->head = ent->next;
+	}
+	if (ent->next >= 0) {
+		cache_entry_list[ent->next].prev = ent->prev;
+	} else {
+		list->tail = ent->prev;
+	}
+	ent->next = -1;
+	ent->prev = -1;
+	list->count--;
+}
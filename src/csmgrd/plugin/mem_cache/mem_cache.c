@@ -67,6 +67,7 @@
 #include <csmgrd/csmgrd_plugin.h>
 #include <cefore/cef_valid.h>	/* for OpenSSL 3.x */
 #include <cefore/cef_pthread.h>
+#include <cefore/cef_expiry_heap.h>
 
 
 /****************************************************************************************
@@ -107,6 +108,11 @@ typedef struct {
 	uint64_t		ins_time;					/* Insert time							*/
 	unsigned char*	version;					/* version								*/
 	uint16_t		ver_len;					/* Length of version					*/
+	uint8_t			ref_bit;					/* Reference bit set on a hit (used		*/
+												/* when the library supports it)		*/
+	int 			refcnt;						/* references from the cache table and	*/
+												/* the output queues					*/
+	uint32_t		expiry_pos;					/* position in mem_expiry_heap			*/
 } CsmgrdT_Content_Mem_Entry;
 
 typedef struct CefT_Mem_Hash_Cell {
@@ -123,6 +129,7 @@ typedef struct CefT_Mem_Hash {
 	uint32_t 				tabl_max;
 	uint64_t 				elem_max;
 	uint64_t 				elem_num;
+	uint64_t 				elem_bytes;			/* total of msg_len of the elements 	*/
 
 } CefT_Mem_Hash;
 
@@ -133,6 +140,8 @@ typedef struct CefT_Mem_Hash {
 static MemT_Cache_Handle* 		hdl = NULL;
 static char 					csmgr_conf_dir[PATH_MAX] = {"/usr/local/cefore"};
 static CefT_Mem_Hash* 			mem_hash_tbl = NULL;
+static CefT_Expiry_Heap* 		mem_expiry_heap = NULL;	/* entries in the table ordered */
+														/* by the expiry time 			*/
 static uint32_t 				mem_tabl_max = 819200;
 static pthread_mutex_t 			mem_comn_buff_mutex[MemC_Max_Buff];
 static sem_t*					mem_comn_buff_sem;
@@ -144,7 +153,15 @@ static CsmgrT_Stat_Handle 		csmgr_stat_hdl;
 static pthread_t				mem_cache_delete_th;
 static int						delete_pipe_fd[2];
 
-static pthread_mutex_t 			mem_cs_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_rwlock_t 		mem_cs_lock = PTHREAD_RWLOCK_INITIALIZER;
+												/* the hits share the cache table when	*/
+												/* they do not touch the library		*/
+static int 						mem_ref_bit_f = 0;	/* the reference bit is used 		*/
+													/* instead of Hit API 				*/
+
+/* Set when the memory cache is the upper tier of the tiered plugin 	*/
+static uint64_t 				mem_tier_capacity = 0;	/* overrides CACHE_CAPACITY		*/
+static void 					(*mem_tier_demote)(const CsmgrdT_Content_Entry*) = NULL;
 
 /****************************************************************************************
  Static Function Declaration
@@ -211,6 +228,32 @@ mem_cs_remove (
 	unsigned char* key,
 	int key_len
 );
+/*--------------------------------------------------------------------------------------
+	Reference bit API
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_entry_demote (
+	CsmgrdT_Content_Mem_Entry* entry
+);
+static int
+mem_cs_reference_test (
+	unsigned char* key,
+	int key_len
+);
+/*--------------------------------------------------------------------------------------
+	Releases a reference to the content entry
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_entry_release (
+	void* arg
+);
+/*--------------------------------------------------------------------------------------
+	Locks the cache table to look up the entry which hits
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_hit_lock (
+	void
+);
 /*--------------------------------------------------------------------------------------
 	function for processing the received message
 ----------------------------------------------------------------------------------------*/
@@ -242,6 +285,14 @@ mem_cs_ac_cnt_inc (
 	uint16_t key_size,							/* content name Length					*/
 	uint32_t seq_num							/* sequence number						*/
 );
+/*--------------------------------------------------------------------------------------
+	Function to increment access counts of the ranges of chunks
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_ac_cnt_inc_bulk (
+	CsmgrdT_Access_Count* acs,					/* ranges of chunks which were hit		*/
+	int num										/* number of ranges						*/
+);
 
 /*--------------------------------------------------------------------------------------
 	Hash APIs for Memory Cahce Plugin
@@ -272,6 +323,30 @@ cef_mem_hash_tbl_item_remove (
 	const unsigned char* key,
 	uint32_t klen
 );
+/*--------------------------------------------------------------------------------------
+	Publishes the entry to the region shared with cefnetd
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_shm_publish (
+	const unsigned char* key,
+	uint32_t klen,
+	CsmgrdT_Content_Mem_Entry* elem
+);
+/*--------------------------------------------------------------------------------------
+	Removes the entry from the region shared with cefnetd
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_shm_invalidate (
+	const unsigned char* key,
+	uint32_t klen
+);
+/*--------------------------------------------------------------------------------------
+	Queues the entry to the expiry heap
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_expiry_set (
+	CsmgrdT_Content_Mem_Entry* elem
+);
 
 int
 csmgrd_key_create_by_Mem_Entry (
@@ -318,6 +393,7 @@ csmgrd_memory_plugin_load (
 	CSMGRD_SET_CALLBACKS (
 		mem_cs_create, mem_cs_destroy, mem_cs_expire_check, mem_cache_item_get,
 		mem_cache_item_puts, mem_cs_ac_cnt_inc, mem_cache_lifetime_get);
+	cs_in->ac_cnt_inc_bulk = mem_cs_ac_cnt_inc_bulk;
 
 	if (config_dir) {
 		strcpy (csmgr_conf_dir, config_dir);
@@ -332,6 +408,42 @@ csmgrd_memory_plugin_load (
 
 	return (0);
 }
+/*--------------------------------------------------------------------------------------
+	Sets the parameters used when the memory cache is the upper tier.
+	This function is called before the init API.
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_memory_plugin_tier_set (
+	uint64_t capacity,							/* capacity of the tier (0:CACHE_CAPACITY)	*/
+	void (*demote)(const CsmgrdT_Content_Entry*)
+												/* called with the evicted Cob			*/
+) {
+	mem_tier_capacity = capacity;
+	mem_tier_demote = demote;
+}
+/*--------------------------------------------------------------------------------------
+	Caches the Cob entry, the memory cache takes the buffers of the entry
+----------------------------------------------------------------------------------------*/
+int 								/* The return value is negative if an error occurs	*/
+csmgrd_memory_plugin_entry_put (
+	CsmgrdT_Content_Entry* entry
+) {
+	int res;
+
+	if (hdl == NULL) {
+		free (entry->msg);
+		free (entry->name);
+		if (entry->ver_len) {
+			free (entry->version);
+		}
+		return (-1);
+	}
+	pthread_rwlock_wrlock (&mem_cs_lock);
+	res = mem_cache_cob_write (entry, 1);
+	pthread_rwlock_unlock (&mem_cs_lock);
+
+	return (res);
+}
 /*--------------------------------------------------------------------------------------
 	Init API
 ----------------------------------------------------------------------------------------*/
@@ -360,7 +472,11 @@ mem_cs_create (
 		csmgrd_log_write (CefC_Log_Error, "[%s] read config\n", __func__);
 		return (-1);
 	}
+	if (mem_tier_capacity > 0) {
+		conf_param.cache_capacity = mem_tier_capacity;
+	}
 	hdl->cache_capacity = conf_param.cache_capacity;
+	hdl->cache_capacity_bytes = conf_param.cache_capacity_bytes;
 	strcpy (hdl->algo_name, conf_param.algo_name);
 	hdl->algo_name_size = conf_param.algo_name_size;
 	hdl->algo_cob_size = conf_param.algo_cob_size;
@@ -381,6 +497,11 @@ mem_cs_create (
 		csmgrd_log_write (CefC_Log_Error, "Unable to create mem hash table\n");
 		return (-1);
 	}
+	mem_expiry_heap = cef_expiry_heap_create ();
+	if (mem_expiry_heap == NULL) {
+		csmgrd_log_write (CefC_Log_Error, "Unable to create mem expiry heap\n");
+		return (-1);
+	}
 
 	/* Loads the library for cache algorithm 		*/
 	if (strcmp (conf_param.algo_name, "None")) {
@@ -400,6 +521,19 @@ mem_cs_create (
 		if (hdl->algo_apis.init) {
 			(*(hdl->algo_apis.init))(hdl->cache_capacity, mem_cs_store, mem_cs_remove);
 		}
+		if (hdl->cache_capacity_bytes > 0) {
+			if ((hdl->algo_apis.capacity_bytes_set == NULL) ||
+				((*(hdl->algo_apis.capacity_bytes_set))(hdl->cache_capacity_bytes) < 0)) {
+				csmgrd_log_write (CefC_Log_Error,
+					"%s does not support CACHE_CAPACITY_BYTES\n", hdl->algo_name);
+				return (-1);
+			}
+		}
+		if (hdl->algo_apis.reference_api_set) {
+			if ((*(hdl->algo_apis.reference_api_set))(mem_cs_reference_test) == 0) {
+				mem_ref_bit_f = 1;
+			}
+		}
 	}
 
 	for (i = 0 ; i < MemC_Max_Buff ; i++) {
@@ -437,16 +571,36 @@ mem_cs_create (
 		return (-1);
 	}
 
+	/* Creates the region shared with cefnetd 		*/
+	if (conf_param.cache_shm_size > 0) {
+		hdl->shm = cef_cs_shm_create (conf_param.port_num,
+					conf_param.cache_shm_size, conf_param.cache_shm_slot_size);
+		if (hdl->shm == NULL) {
+			csmgrd_log_write (CefC_Log_Warn,
+				"Failed to create the shared memory (%s), cefnetd uses the socket only\n",
+				strerror (errno));
+		}
+	}
+
 	csmgrd_log_write (CefC_Log_Info, "Start\n");
 	csmgrd_log_write (CefC_Log_Info, "Cache Capacity : "FMTU64"\n", hdl->cache_capacity);
+	if (hdl->cache_capacity_bytes > 0) {
+		csmgrd_log_write (CefC_Log_Info,
+			"Cache Capacity (Bytes) : "FMTU64"\n", hdl->cache_capacity_bytes);
+	}
 	if (strcmp (conf_param.algo_name, "None")) {
 		csmgrd_log_write (CefC_Log_Info, "Library  : %s ... OK\n", hdl->algo_name);
 	} else {
 		csmgrd_log_write (CefC_Log_Info, "Library  : Not Specified\n");
 	}
+	if (hdl->shm) {
+		csmgrd_log_write (CefC_Log_Info, "Shared Memory : %s (%u slots of %u bytes)\n",
+			hdl->shm->name, hdl->shm->mask + 1, hdl->shm->slot_size);
+	}
 
 	csmgr_stat_hdl = stat_hdl;
 	csmgrd_stat_cache_capacity_update (csmgr_stat_hdl, hdl->cache_capacity);
+	csmgrd_stat_cache_capacity_bytes_update (csmgr_stat_hdl, hdl->cache_capacity_bytes);
 
 	return (0);
 }
@@ -472,9 +626,9 @@ mem_cob_process_thread (
 				csmgrd_dbg_write (CefC_Dbg_Fine,
 					"cob put thread starts to write %d cobs\n", mem_proc_cob_buff_idx[i]);
 #endif // CefC_Debug
-				pthread_mutex_lock (&mem_cs_mutex);
+				pthread_rwlock_wrlock (&mem_cs_lock);
 				mem_cache_cob_write (&mem_proc_cob_buff[i][0], mem_proc_cob_buff_idx[i]);
-				pthread_mutex_unlock (&mem_cs_mutex);
+				pthread_rwlock_unlock (&mem_cs_lock);
 				mem_proc_cob_buff_idx[i] = 0;
 				if (i >= MemC_Min_Buff) {
 					free (mem_proc_cob_buff[i]);
@@ -516,6 +670,7 @@ mem_cs_store (
 	if (entry == NULL) {
 		return (-1);
 	}
+	entry->refcnt = 1;
 
 	/* Inserts the cache entry 		*/
 	entry->msg 		= new_entry->msg;
@@ -555,11 +710,7 @@ mem_cs_store (
 	}
 
 	if (old_entry) {
-		free (old_entry->msg);
-		free (old_entry->name);
-		if (old_entry->ver_len)
-			free (old_entry->version);
-		free (old_entry);
+		mem_cs_entry_release (old_entry);
 	} else {
 		hdl->cache_cobs++;
 	}
@@ -583,14 +734,103 @@ mem_cs_remove (
 		csmgrd_stat_cob_remove (
 			csmgr_stat_hdl, entry->name, entry->name_len,
 			entry->chunk_num, entry->pay_len);
-		free (entry->msg);
-		free (entry->name);
-		free (entry);
+		if (mem_tier_demote) {
+			mem_cs_entry_demote (entry);
+		}
+		mem_cs_entry_release (entry);
 		hdl->cache_cobs--;
 	}
 
 	return;
 }
+/*--------------------------------------------------------------------------------------
+	Passes the evicted entry to the lower tier unless it expired
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_entry_demote (
+	CsmgrdT_Content_Mem_Entry* entry
+) {
+	CsmgrdT_Content_Entry cob;
+	uint64_t nowt;
+	struct timeval tv;
+
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+
+	if (((entry->expiry != 0) && (nowt >= entry->expiry)) ||
+		(nowt >= entry->cache_time)) {
+		return;
+	}
+	memset (&cob, 0, sizeof (CsmgrdT_Content_Entry));
+	cob.msg 		= entry->msg;
+	cob.msg_len 	= entry->msg_len;
+	cob.name 		= entry->name;
+	cob.name_len 	= entry->name_len;
+	cob.pay_len 	= entry->pay_len;
+	cob.chunk_num 	= entry->chunk_num;
+	cob.cache_time 	= entry->cache_time;
+	cob.expiry 		= entry->expiry;
+	cob.node 		= entry->node;
+	cob.ins_time 	= entry->ins_time;
+	cob.version 	= entry->version;
+	cob.ver_len 	= entry->ver_len;
+
+	(*mem_tier_demote)(&cob);
+}
+
+/*--------------------------------------------------------------------------------------
+	Reference bit API
+----------------------------------------------------------------------------------------*/
+static int						/* 1: referenced, 0: not referenced, -1: not cached 	*/
+mem_cs_reference_test (
+	unsigned char* key,
+	int key_len
+) {
+	CsmgrdT_Content_Mem_Entry* entry;
+
+	/* Tests and clears the reference bit of the entry 	*/
+	entry = cef_mem_hash_tbl_item_get (key, key_len);
+	if (entry == NULL) {
+		return (-1);
+	}
+	return ((int) __atomic_exchange_n (&entry->ref_bit, 0, __ATOMIC_RELAXED));
+}
+/*--------------------------------------------------------------------------------------
+	Releases a reference to the content entry
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_entry_release (
+	void* arg
+) {
+	CsmgrdT_Content_Mem_Entry* entry = (CsmgrdT_Content_Mem_Entry*) arg;
+
+	/* The entry is freed when it is removed from the cache table and is not 	*/
+	/* waiting in any output queue 												*/
+	if (__atomic_sub_fetch (&entry->refcnt, 1, __ATOMIC_ACQ_REL) > 0) {
+		return;
+	}
+	free (entry->msg);
+	free (entry->name);
+	if (entry->ver_len) {
+		free (entry->version);
+	}
+	free (entry);
+}
+/*--------------------------------------------------------------------------------------
+	Locks the cache table to look up the entry which hits
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_hit_lock (
+	void
+) {
+	/* When the library has Reference bit API, a hit only sets the bit of the 	*/
+	/* entry and counts in the library, so the hits share the table 			*/
+	if ((mem_ref_bit_f) || (hdl->algo_apis.hit == NULL)) {
+		pthread_rwlock_rdlock (&mem_cs_lock);
+	} else {
+		pthread_rwlock_wrlock (&mem_cs_lock);
+	}
+}
 
 /*--------------------------------------------------------------------------------------
 	Destroy content store
@@ -603,7 +843,7 @@ mem_cs_destroy (
 	int i;
 	void* status;
 
-	pthread_mutex_destroy (&mem_cs_mutex);
+	pthread_rwlock_destroy (&mem_cs_lock);
 
 	if (mem_thread_f) {
 		mem_thread_f = 0;
@@ -623,6 +863,15 @@ mem_cs_destroy (
 	if (hdl == NULL) {
 		return;
 	}
+	/* Releases the entries waiting in the output queues 	*/
+	csmgrd_plugin_send_queue_destroy ();
+
+	/* cefnetd stops reading the shared region 	*/
+	if (hdl->shm) {
+		cef_cs_shm_destroy (hdl->shm);
+		hdl->shm = NULL;
+	}
+
 	if (mem_hash_tbl) {
 		for (i = 0 ; i < mem_hash_tbl->tabl_max ; i++) {
 			CefT_Mem_Hash_Cell* cp;
@@ -638,12 +887,23 @@ mem_cs_destroy (
 		free (mem_hash_tbl->tbl);
 		free (mem_hash_tbl);
 	}
+	cef_expiry_heap_destroy (mem_expiry_heap);
+	mem_expiry_heap = NULL;
 
 	if (hdl->algo_lib) {
+		if (hdl->algo_apis.status) {
+			CsmgrdT_Lib_Status lib_stat;
+			memset (&lib_stat, 0, sizeof (CsmgrdT_Lib_Status));
+			(*(hdl->algo_apis.status))(&lib_stat);
+			csmgrd_log_write (CefC_Log_Info,
+				"Cache algorithm hit : "FMTU64", miss : "FMTU64"\n",
+				lib_stat.hit_count, lib_stat.miss_count);
+		}
 		if (hdl->algo_apis.destroy) {
 			(*(hdl->algo_apis.destroy))();
 		}
 		dlclose (hdl->algo_lib);
+		mem_ref_bit_f = 0;
 	}
 
 	if (hdl) {
@@ -665,50 +925,38 @@ mem_cs_expire_check (
 	CsmgrdT_Content_Mem_Entry* entry1 = NULL;
 	uint64_t 	nowt;
 	struct timeval tv;
-	int n;
 	unsigned char trg_key[65535];
 	int trg_key_len;
 
-	if (pthread_mutex_trylock (&mem_cs_mutex) != 0) {
+	if (pthread_rwlock_trywrlock (&mem_cs_lock) != 0) {
 		return;
 	}
 
 	gettimeofday (&tv, NULL);
 	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
 
-	for (n = 0 ; n < mem_hash_tbl->tabl_max ; n++) {
-		if (mem_hash_tbl->tbl[n] == NULL) {
-			continue;
+	/* Only the expired entries are visited, in order of the expiry time 	*/
+	while ((entry = (CsmgrdT_Content_Mem_Entry*)
+			cef_expiry_heap_expired_peek (mem_expiry_heap, nowt)) != NULL) {
+		/* Removes the expiry cache entry 		*/
+		trg_key_len = csmgrd_key_create_by_Mem_Entry (entry, trg_key);
+		entry1 = cef_mem_hash_tbl_item_remove (trg_key, trg_key_len);
+		if (hdl->algo_apis.erase) {
+			(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
 		}
-		{
-			CefT_Mem_Hash_Cell* cp;
-			CefT_Mem_Hash_Cell* wcp;
-			cp = mem_hash_tbl->tbl[n];
-			for (; cp != NULL; cp = wcp) {
-				entry = cp->elem;
-				wcp = cp->next;
-				if ((entry->cache_time < nowt) ||
-					((entry->expiry != 0) && (entry->expiry < nowt))) {
-					/* Removes the expiry cache entry 		*/
-					trg_key_len = csmgrd_key_create_by_Mem_Entry (entry, trg_key);
-					entry1 = cef_mem_hash_tbl_item_remove (trg_key, trg_key_len);
-					if (hdl->algo_apis.erase) {
-						(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
-					}
-					if ( !entry1 )
-						continue;
-					csmgrd_stat_cob_remove (
-						csmgr_stat_hdl, entry->name, entry->name_len,
-						entry->chunk_num, entry->pay_len);
-					hdl->cache_cobs--;
-					free (entry1->msg);
-					free (entry1->name);
-					free (entry1);
-				}
-			}
+		if (entry1 != entry) {
+			/* The table does not have the entry, forgets it 	*/
+			cef_expiry_heap_remove (mem_expiry_heap, &entry->expiry_pos);
 		}
+		if ( !entry1 )
+			continue;
+		csmgrd_stat_cob_remove (
+			csmgr_stat_hdl, entry1->name, entry1->name_len,
+			entry1->chunk_num, entry1->pay_len);
+		hdl->cache_cobs--;
+		mem_cs_entry_release (entry1);
 	}
-	pthread_mutex_unlock (&mem_cs_mutex);
+	pthread_rwlock_unlock (&mem_cs_lock);
 
 	return;
 }
@@ -745,14 +993,15 @@ mem_cache_item_get (
 	/* Creates the key 		*/
 	trg_key_len = csmgrd_name_chunknum_concatenate (key, key_size, seqno, trg_key);
 
-	/* Access the specified entry 	*/
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+
+	/* Access the specified entry, it is pinned while it is sent 	*/
+	mem_cs_hit_lock ();
 	entry = cef_mem_hash_tbl_item_get (trg_key, trg_key_len);
 
 	if (entry) {
 
-		gettimeofday (&tv, NULL);
-		nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
-
 		if (((entry->expiry == 0) || (nowt < entry->expiry)) &&
 			(nowt < entry->cache_time)) {
 #ifdef __MEMCACHE_VERSION__
@@ -778,29 +1027,46 @@ mem_cache_item_get (
 #endif //__MEMCACHE_VERSION__
 					;
 				} else {
+					pthread_rwlock_unlock (&mem_cs_lock);
 					goto CobNotExist;
 				}
 			} else if (rc != CefC_CV_Same) {
+				pthread_rwlock_unlock (&mem_cs_lock);
 				goto CobNotExist;
 			}
 
-			pthread_mutex_lock (&mem_cs_mutex);
+			if (mem_ref_bit_f) {
+				/* Marks the entry, the library looks at it when it evicts 	*/
+				__atomic_store_n (&entry->ref_bit, 1, __ATOMIC_RELAXED);
+			}
 			if (hdl->algo_apis.hit) {
 				(*(hdl->algo_apis.hit))(trg_key, trg_key_len);
 			}
+			__atomic_add_fetch (&entry->refcnt, 1, __ATOMIC_ACQ_REL);
+			pthread_rwlock_unlock (&mem_cs_lock);
 
 			csmgrd_stat_access_count_update (
 					csmgr_stat_hdl, entry->name, entry->name_len);
 
-			/* Send Cob to cefnetd */
-			csmgrd_plugin_cob_msg_send (sock, entry->msg, entry->msg_len);
+			/* Send Cob to cefnetd without the lock, the entry is released after 	*/
+			/* the Cob is written to the socket or dropped 							*/
+			csmgrd_plugin_cob_msg_enqueue (
+				sock, entry->msg, entry->msg_len, mem_cs_entry_release, entry);
 			exist_f = CefC_Csmgr_Cob_Exist;
-			pthread_mutex_unlock (&mem_cs_mutex);
  		}
 		else {
-			pthread_mutex_lock (&mem_cs_mutex);
-			/* Removes the expiry cache entry 		*/
-			entry = cef_mem_hash_tbl_item_remove (trg_key, trg_key_len);
+			/* Removes the expiry cache entry, another thread may have replaced 	*/
+			/* it while the table was unlocked 										*/
+			pthread_rwlock_unlock (&mem_cs_lock);
+			pthread_rwlock_wrlock (&mem_cs_lock);
+			entry = cef_mem_hash_tbl_item_get (trg_key, trg_key_len);
+			if ((entry) &&
+				(((entry->expiry != 0) && (nowt >= entry->expiry)) ||
+				 (nowt >= entry->cache_time))) {
+				entry = cef_mem_hash_tbl_item_remove (trg_key, trg_key_len);
+			} else {
+				entry = NULL;
+			}
 
 			if ( entry ){
 				if (hdl->algo_apis.erase) {
@@ -812,12 +1078,12 @@ mem_cache_item_get (
 					csmgr_stat_hdl, entry->name, entry->name_len,
 					entry->chunk_num, entry->pay_len);
 
-				free (entry->msg);
-				free (entry->name);
-				free (entry);
+				mem_cs_entry_release (entry);
 			}
-			pthread_mutex_unlock (&mem_cs_mutex);
+			pthread_rwlock_unlock (&mem_cs_lock);
 		}
+	} else {
+		pthread_rwlock_unlock (&mem_cs_lock);
 	}
 CobNotExist:;
 
@@ -989,11 +1255,7 @@ mem_cache_cob_write (
 						}
 						hdl->cache_cobs--;
 						if (entry) {
-							free (entry->msg);
-							free (entry->name);
-							if (entry->ver_len) {
-								free (entry->version);
-							}
+							mem_cs_entry_release (entry);
 						} else {
 							return (-1);
 						}
@@ -1090,7 +1352,14 @@ mem_cache_cob_write (
 				}
 			}
 		} else {
-			if (hdl->cache_cobs >= hdl->cache_capacity) {
+			if ((hdl->cache_cobs >= hdl->cache_capacity) ||
+				((hdl->cache_capacity_bytes > 0) &&
+				 (mem_hash_tbl->elem_bytes + cobs[index].msg_len >
+				 	hdl->cache_capacity_bytes))) {
+				/* The lower tier caches the Cob instead 	*/
+				if (mem_tier_demote) {
+					(*mem_tier_demote)(&cobs[index]);
+				}
 				free (cobs[index].msg);
 				free (cobs[index].name);
 				if (cobs[index].ver_len)
@@ -1104,6 +1373,7 @@ mem_cache_cob_write (
 			if (entry == NULL) {
 				return (-1);
 			}
+			entry->refcnt = 1;
 
 			/* Creates the key 				*/
 			trg_key_len = csmgrd_name_chunknum_concatenate (
@@ -1213,11 +1483,7 @@ mem_cache_cob_write (
 #endif //__MEMCACHE_VERSION__
 						}
 						if (old_entry) {
-							free (old_entry->msg);
-							free (old_entry->name);
-							if (old_entry->ver_len)
-								free (old_entry->version);
-							free (old_entry);
+							mem_cs_entry_release (old_entry);
 						}
 
 						/* Updates the content information 			*/
@@ -1254,11 +1520,7 @@ mem_cache_cob_write (
 						if (old_entry) {
 							csmgrd_stat_content_lifetime_update (csmgr_stat_hdl,
 								entry->name, entry->name_len, entry->expiry);
-							free (old_entry->msg);
-							free (old_entry->name);
-							if (old_entry->ver_len)
-								free (old_entry->version);
-							free (old_entry);
+							mem_cs_entry_release (old_entry);
 						}
 					} else {
 #ifdef __MEMCACHE_VERSION__
@@ -1298,19 +1560,76 @@ mem_cs_ac_cnt_inc (
 ) {
 	CsmgrdT_Content_Mem_Entry* entry;
 
+	/* The entry is pinned until its name is read 	*/
+	mem_cs_hit_lock ();
 	entry = cef_mem_hash_tbl_item_get (key, key_size);
 	if (!entry) {
+		pthread_rwlock_unlock (&mem_cs_lock);
 		return;
 	}
-
-	pthread_mutex_lock (&mem_cs_mutex);
+	if (mem_ref_bit_f) {
+		__atomic_store_n (&entry->ref_bit, 1, __ATOMIC_RELAXED);
+	}
 	if (hdl->algo_apis.hit) {
 		(*(hdl->algo_apis.hit))(key, key_size);
 	}
-	pthread_mutex_unlock (&mem_cs_mutex);
+	__atomic_add_fetch (&entry->refcnt, 1, __ATOMIC_ACQ_REL);
+	pthread_rwlock_unlock (&mem_cs_lock);
 
 	csmgrd_stat_access_count_update (
 			csmgr_stat_hdl, entry->name, entry->name_len);
+	mem_cs_entry_release (entry);
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Function to increment access counts of the ranges of chunks
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_ac_cnt_inc_bulk (
+	CsmgrdT_Access_Count* acs,					/* ranges of chunks which were hit		*/
+	int num										/* number of ranges						*/
+) {
+	CsmgrdT_Content_Mem_Entry* entry;
+	unsigned char key[CefC_Max_Msg_Size];
+	unsigned char hit_f[CefC_Csmgr_Bulk_Increment_Max] = {0};
+	int key_len;
+	uint32_t chunk_num;
+	int i;
+
+	if (num > CefC_Csmgr_Bulk_Increment_Max) {
+		num = CefC_Csmgr_Bulk_Increment_Max;
+	}
+
+	/* Notifies the hits of all ranges in one pass under the lock 	*/
+	mem_cs_hit_lock ();
+	for (i = 0 ; i < num ; i++) {
+		for (chunk_num = acs[i].first ; ; chunk_num++) {
+			key_len = csmgrd_name_chunknum_concatenate (
+						acs[i].name, acs[i].name_len, chunk_num, key);
+			entry = cef_mem_hash_tbl_item_get (key, key_len);
+			if (entry) {
+				hit_f[i] = 1;
+				if (mem_ref_bit_f) {
+					__atomic_store_n (&entry->ref_bit, 1, __ATOMIC_RELAXED);
+				}
+				if (hdl->algo_apis.hit) {
+					(*(hdl->algo_apis.hit))(key, key_len);
+				}
+			}
+			if (chunk_num == acs[i].last) {
+				break;
+			}
+		}
+	}
+	pthread_rwlock_unlock (&mem_cs_lock);
+
+	for (i = 0 ; i < num ; i++) {
+		if (hit_f[i]) {
+			csmgrd_stat_access_count_add (
+				csmgr_stat_hdl, acs[i].name, acs[i].name_len, acs[i].count);
+		}
+	}
 
 	return;
 }
@@ -1338,6 +1657,10 @@ mem_config_read (
 	/* Inits parameters		*/
 	memset (params, 0, sizeof (MemT_Config_Param));
 	params->cache_capacity = 819200;
+	params->cache_capacity_bytes = 0;
+	params->cache_shm_size = CefC_Cs_Shm_Size_Def;
+	params->cache_shm_slot_size = CefC_Cs_Shm_Slot_Size_Def;
+	params->port_num = CefC_Default_Tcp_Prot;
 	strcpy (params->algo_name, "None");
 	params->algo_name_size = 256;
 	params->algo_cob_size = 2048;
@@ -1422,6 +1745,56 @@ mem_config_read (
 				fclose (fp);
 				return (-1);
 			}
+		} else if (strcmp (option, "CACHE_CAPACITY_BYTES") == 0) {
+			char *endptr = "";
+			params->cache_capacity_bytes = strtoull (value, &endptr, 0);
+			if (strcmp (endptr, "") != 0) {
+				csmgrd_log_write (
+					CefC_Log_Error, "[%s] Invalid value %s=%s\n", __func__, option, value);
+				fclose (fp);
+				return (-1);
+			}
+			if ((params->cache_capacity_bytes != 0) &&
+				(params->cache_capacity_bytes < CefC_Max_Msg_Size)) {
+				csmgrd_log_write (CefC_Log_Error,
+				"CACHE_CAPACITY_BYTES must be 0 (unlimited) or greater than or equal to %d.\n",
+				CefC_Max_Msg_Size);
+				fclose (fp);
+				return (-1);
+			}
+		} else if (strcmp (option, "CACHE_SHM_SIZE") == 0) {
+			char *endptr = "";
+			params->cache_shm_size = strtoull (value, &endptr, 0);
+			if (strcmp (endptr, "") != 0) {
+				csmgrd_log_write (
+					CefC_Log_Error, "[%s] Invalid value %s=%s\n", __func__, option, value);
+				fclose (fp);
+				return (-1);
+			}
+			if ((params->cache_shm_size != 0) &&
+				((params->cache_shm_size < CefC_Cs_Shm_Size_Min) ||
+				 (params->cache_shm_size > CefC_Cs_Shm_Size_Max))) {
+				csmgrd_log_write (CefC_Log_Error,
+				"CACHE_SHM_SIZE must be 0 (disabled) or between %d and "FMTU64" inclusive.\n",
+				CefC_Cs_Shm_Size_Min, (uint64_t) CefC_Cs_Shm_Size_Max);
+				fclose (fp);
+				return (-1);
+			}
+		} else if (strcmp (option, "CACHE_SHM_SLOT_SIZE") == 0) {
+			res = atoi (value);
+			if (!(CefC_Cs_Shm_Slot_Size_Min <= res && res <= CefC_Cs_Shm_Slot_Size_Max)) {
+				csmgrd_log_write (CefC_Log_Error,
+					"CACHE_SHM_SLOT_SIZE must be between %d and %d inclusive.\n",
+					CefC_Cs_Shm_Slot_Size_Min, CefC_Cs_Shm_Slot_Size_Max);
+				fclose (fp);
+				return (-1);
+			}
+			params->cache_shm_slot_size = (uint32_t) res;
+		} else if (strcmp (option, "PORT_NUM") == 0) {
+			res = atoi (value);
+			if ((1024 < res) && (res < 65536)) {
+				params->port_num = (uint16_t) res;
+			}
 		} else {
 			/* NOP */;
 		}
@@ -1429,6 +1802,8 @@ mem_config_read (
 #ifdef CefC_Debug
 	csmgrd_dbg_write (CefC_Dbg_Fine, "params->cache_capacity="FMTU64"\n",
 						params->cache_capacity);
+	csmgrd_dbg_write (CefC_Dbg_Fine, "params->cache_capacity_bytes="FMTU64"\n",
+						params->cache_capacity_bytes);
 	csmgrd_dbg_write (CefC_Dbg_Fine, "params->algo_name=%s\n",
 						params->algo_name);
 	csmgrd_dbg_write (CefC_Dbg_Fine, "params->algo_name_size=%d\n",
@@ -1497,6 +1872,7 @@ mem_cache_lifetime_get (
 		oldest_ins_time = nowt;
 		first_expire = UINT64_MAX;
 
+		pthread_rwlock_rdlock (&mem_cs_lock);
 		for (idx = rcd->min_seq; idx <= rcd->max_seq; idx++) {
 			trg_key_len = csmgrd_name_chunknum_concatenate (name, name_len, idx, trg_key);
 			entry = cef_mem_hash_tbl_item_get (trg_key, trg_key_len);
@@ -1508,6 +1884,7 @@ mem_cache_lifetime_get (
 			if (first_expire > entry->expiry)
 				first_expire = entry->expiry;
 		}
+		pthread_rwlock_unlock (&mem_cs_lock);
 		*cache_time = (uint32_t)((nowt - oldest_ins_time) / 1000000);
 		if (first_expire < nowt)
 			*lifetime = 0;
@@ -1515,13 +1892,16 @@ mem_cache_lifetime_get (
 			*lifetime = (uint32_t)((first_expire - nowt) / 1000000);
 		return (1);
 	} else {
+		pthread_rwlock_rdlock (&mem_cs_lock);
 		entry = cef_mem_hash_tbl_item_get (name, name_len);
 		if ((!entry) ||
 			(nowt > entry->expiry)) {
+			pthread_rwlock_unlock (&mem_cs_lock);
 			return (-1);
 		}
 		*cache_time = (uint32_t)((nowt - entry->ins_time) / 1000000);
 		*lifetime   = (uint32_t)((entry->expiry - nowt) / 1000000);
+		pthread_rwlock_unlock (&mem_cs_lock);
 		return (1);
 	}
 	return (-1);
@@ -1619,6 +1999,10 @@ cef_mem_hash_tbl_item_set (
 		cp->klen = klen;
 		memcpy (cp->key, key, klen);
 		ht->elem_num++;
+		ht->elem_bytes += elem->msg_len;
+		csmgrd_stat_cached_bytes_update (csmgr_stat_hdl, ht->elem_bytes);
+		mem_cs_shm_publish (key, klen, elem);
+		mem_cs_expiry_set (elem);
 		return (1);
 	} else {
 		/* exist check & replace */
@@ -1627,6 +2011,12 @@ cef_mem_hash_tbl_item_set (
 			   (memcmp (cp->key, key, klen) == 0)) {
 				*old_elem = cp->elem;
 				cp->elem = elem;
+				ht->elem_bytes -= (*old_elem)->msg_len;
+				ht->elem_bytes += elem->msg_len;
+				csmgrd_stat_cached_bytes_update (csmgr_stat_hdl, ht->elem_bytes);
+				mem_cs_shm_publish (key, klen, elem);
+				cef_expiry_heap_remove (mem_expiry_heap, &(*old_elem)->expiry_pos);
+				mem_cs_expiry_set (elem);
 				return (1);
 		   }
 		}
@@ -1644,6 +2034,10 @@ cef_mem_hash_tbl_item_set (
 		memcpy (cp->key, key, klen);
 
 		ht->elem_num++;
+		ht->elem_bytes += elem->msg_len;
+		csmgrd_stat_cached_bytes_update (csmgr_stat_hdl, ht->elem_bytes);
+		mem_cs_shm_publish (key, klen, elem);
+		mem_cs_expiry_set (elem);
 		return (1);
 	}
 }
@@ -1706,7 +2100,11 @@ cef_mem_hash_tbl_item_remove (
 		   	ht->tbl[y] = cp->next;
 			ht->elem_num--;
 		   	ret_elem = cp->elem;
+			ht->elem_bytes -= ret_elem->msg_len;
+			csmgrd_stat_cached_bytes_update (csmgr_stat_hdl, ht->elem_bytes);
 		   	free (cp);
+			mem_cs_shm_invalidate (key, klen);
+			cef_expiry_heap_remove (mem_expiry_heap, &ret_elem->expiry_pos);
 		   	return (ret_elem);
 		} else {
 			for (; cp->next != NULL; cp = cp->next) {
@@ -1716,7 +2114,11 @@ cef_mem_hash_tbl_item_remove (
 				   	cp->next = cp->next->next;
 					ht->elem_num--;
 				   	ret_elem = wcp->elem;
+					ht->elem_bytes -= ret_elem->msg_len;
+					csmgrd_stat_cached_bytes_update (csmgr_stat_hdl, ht->elem_bytes);
 					free (wcp);
+					mem_cs_shm_invalidate (key, klen);
+					cef_expiry_heap_remove (mem_expiry_heap, &ret_elem->expiry_pos);
 					return (ret_elem);
 				}
 			}
@@ -1725,6 +2127,55 @@ cef_mem_hash_tbl_item_remove (
 
 	return (NULL);
 }
+/*--------------------------------------------------------------------------------------
+	Publishes the entry to the region shared with cefnetd
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_shm_publish (
+	const unsigned char* key,
+	uint32_t klen,
+	CsmgrdT_Content_Mem_Entry* elem
+) {
+	if ((hdl == NULL) || (hdl->shm == NULL)) {
+		return;
+	}
+	/* cefnetd does not compare the version, so it is left to csmgrd 	*/
+	if (elem->ver_len) {
+		cef_cs_shm_invalidate (hdl->shm, key, (uint16_t) klen);
+		return;
+	}
+	cef_cs_shm_publish (hdl->shm, key, (uint16_t) klen,
+		elem->msg, elem->msg_len, elem->cache_time, elem->expiry);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the entry from the region shared with cefnetd
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_shm_invalidate (
+	const unsigned char* key,
+	uint32_t klen
+) {
+	if ((hdl == NULL) || (hdl->shm == NULL)) {
+		return;
+	}
+	cef_cs_shm_invalidate (hdl->shm, key, (uint16_t) klen);
+}
+/*--------------------------------------------------------------------------------------
+	Queues the entry to the expiry heap
+----------------------------------------------------------------------------------------*/
+static void
+mem_cs_expiry_set (
+	CsmgrdT_Content_Mem_Entry* elem
+) {
+	uint64_t key = elem->cache_time;
+
+	if ((elem->expiry != 0) && (elem->expiry < key)) {
+		key = elem->expiry;
+	}
+	if (cef_expiry_heap_set (mem_expiry_heap, elem, &elem->expiry_pos, key) < 0) {
+		csmgrd_log_write (CefC_Log_Warn, "%s (expiry heap is full)\n", __func__);
+	}
+}
 
 
 static uint32_t
@@ -1842,7 +2293,7 @@ mem_cache_delete_thread (
 				memcpy (del_version, stat_p->version, stat_p->ver_len);
 			}
 
-			pthread_mutex_lock (&mem_cs_mutex);
+			pthread_rwlock_wrlock (&mem_cs_lock);
 
 #ifdef __MEMCACHE_VERSION__
 			fprintf (stderr, "--- mem_cache_delete_thread()\n");
@@ -1865,18 +2316,14 @@ mem_cache_delete_thread (
 							(*(hdl->algo_apis.erase))(trg_key, trg_key_len);
 						}
 						hdl->cache_cobs--;
-						free (entry->msg);
-						free (entry->name);
-						if (entry->ver_len)
-							free (entry->version);
-						free (entry);
+						mem_cs_entry_release (entry);
 					}
 				}
 			}
 #ifdef __MEMCACHE_VERSION__
 			fprintf (stderr, "  + (*) cache_cobs="FMTU64"\n", hdl->cache_cobs);
 #endif //__MEMCACHE_VERSION__
-			pthread_mutex_unlock (&mem_cs_mutex);
+			pthread_rwlock_unlock (&mem_cs_lock);
 		}
 	}
 
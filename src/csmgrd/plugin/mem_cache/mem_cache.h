@@ -44,6 +44,7 @@
 #include <cefore/cef_define.h>
 #include <cefore/cef_csmgr.h>
 #include <cefore/cef_rngque.h>
+#include <cefore/cef_cs_shm.h>
 #include <csmgrd/csmgrd_plugin.h>
 
 /****************************************************************************************
@@ -66,6 +67,11 @@ typedef struct {
 	int				algo_cob_size;				/* average Cob size of Cob processed 	*/
                                   				/* by algorithm							*/
 	uint64_t 	 	cache_capacity;				/* size of cache capacity				*/
+	uint64_t 	 	cache_capacity_bytes;		/* byte budget of cache (0:unlimited)	*/
+	uint64_t 		cache_shm_size;				/* size of the region shared with		*/
+												/* cefnetd (0:disabled)					*/
+	uint32_t 		cache_shm_slot_size;		/* size of a slot in the shared region	*/
+	uint16_t 		port_num;					/* port number of csmgrd				*/
 	
 } MemT_Config_Param;
 
@@ -78,6 +84,7 @@ typedef struct {
 	int				algo_cob_size;				/* average Cob size of Cob processed 	*/
                                   				/* by algorithm							*/
 	int 			cache_capacity;				/* size of cache table 					*/
+	uint64_t 		cache_capacity_bytes;		/* byte budget of cache (0:unlimited)	*/
 	
 	/********** cache algorithm library **********/
 	void* 			algo_lib;					/* records to the loaded library 		*/
@@ -85,8 +92,39 @@ typedef struct {
 	
 	uint64_t 		cache_cobs;					/* cached cobs 							*/
 	
+	/********** region shared with cefnetd 	**********/
+	CefT_Cs_Shm* 	shm;						/* NULL if it is disabled 				*/
+	
 } MemT_Cache_Handle;
 
+/****************************************************************************************
+ Global Function Declaration
+ ****************************************************************************************/
 
+/*--------------------------------------------------------------------------------------
+	Road the cache plugin
+----------------------------------------------------------------------------------------*/
+int
+csmgrd_memory_plugin_load (
+	CsmgrdT_Plugin_Interface* cs_in,
+	const char* config_dir
+);
+/*--------------------------------------------------------------------------------------
+	Sets the parameters used when the memory cache is the upper tier.
+	This function is called before the init API.
+----------------------------------------------------------------------------------------*/
+void
+csmgrd_memory_plugin_tier_set (
+	uint64_t capacity,							/* capacity of the tier (0:CACHE_CAPACITY)	*/
+	void (*demote)(const CsmgrdT_Content_Entry*)
+												/* called with the evicted Cob			*/
+);
+/*--------------------------------------------------------------------------------------
+	Caches the Cob entry, the memory cache takes the buffers of the entry
+----------------------------------------------------------------------------------------*/
+int 								/* The return value is negative if an error occurs	*/
+csmgrd_memory_plugin_entry_put (
+	CsmgrdT_Content_Entry* entry
+);
 
 #endif // __CSMGRD_MEM_CACHE_HEADER__
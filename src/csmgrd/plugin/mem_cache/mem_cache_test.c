@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * mem_cache_test.c
+ */
+
+/*
+	mem_cache_test.c checks that the hits look up the cache table together while
+	one of them holds the lock, and that an entry which hits is pinned until the
+	hit has read it, while another thread removes and caches the entries again.
+	The test builds mem_cache.c and sets up the table without the init API.
+*/
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include "mem_cache.c"
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define MemT_Test_Cob_Num			64			/* Cobs cached by the test 				*/
+#define MemT_Test_Msg_Len			128			/* length of a Cob 						*/
+#define MemT_Test_Lifetime			100000000	/* lifetime of the Cobs (us) 			*/
+#define MemT_Test_Hit_Wait			2000		/* wait for the shared hit (ms) 		*/
+#define MemT_Test_Thread_Num		4			/* threads which hit 					*/
+#define MemT_Test_Hit_Num			20000		/* hits by each thread 					*/
+#define MemT_Test_Churn_Num			20000		/* Cobs removed and cached again 		*/
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static int				test_fail = 0;
+static int				test_hit_done = 0;		/* the shared hit has returned 		*/
+static int				test_churn_f = 0;		/* the churn thread is running 		*/
+static unsigned char	test_name[] = {0x00, 0x01, 0x00, 0x04, 't', 'e', 's', 't'};
+
+/****************************************************************************************
+ Static Functions
+ ****************************************************************************************/
+
+static void
+test_expect (
+	const char* what,
+	uint64_t value,
+	uint64_t expected
+) {
+	if (value != expected) {
+		fprintf (stderr, "FAIL: %s = %llu (expected %llu)\n", what,
+			(unsigned long long) value, (unsigned long long) expected);
+		test_fail = 1;
+	}
+}
+
+static int
+test_key_create (
+	uint32_t chunk_num,
+	unsigned char* key
+) {
+	return (csmgrd_name_chunknum_concatenate (
+				test_name, sizeof (test_name), chunk_num, key));
+}
+
+/*--------------------------------------------------------------------------------------
+	Caches the Cob as the writer thread of the memory cache does
+----------------------------------------------------------------------------------------*/
+static void
+test_cob_put (
+	uint32_t chunk_num
+) {
+	CsmgrdT_Content_Entry cob;
+	struct timeval tv;
+	uint64_t nowt;
+
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+
+	memset (&cob, 0, sizeof (CsmgrdT_Content_Entry));
+	cob.msg 		= (unsigned char*) calloc (1, MemT_Test_Msg_Len);
+	cob.msg_len 	= MemT_Test_Msg_Len;
+	cob.name 		= (unsigned char*) malloc (sizeof (test_name));
+	cob.name_len 	= sizeof (test_name);
+	cob.pay_len 	= MemT_Test_Msg_Len;
+	cob.chunk_num 	= chunk_num;
+	cob.cache_time 	= nowt + MemT_Test_Lifetime;
+	cob.expiry 		= nowt + MemT_Test_Lifetime;
+	cob.ins_time 	= nowt;
+	memcpy (cob.name, test_name, sizeof (test_name));
+
+	pthread_rwlock_wrlock (&mem_cs_lock);
+	mem_cache_cob_write (&cob, 1);
+	pthread_rwlock_unlock (&mem_cs_lock);
+}
+
+/*--------------------------------------------------------------------------------------
+	Hits all Cobs one by one and as a range
+----------------------------------------------------------------------------------------*/
+static void
+test_hit_all (
+	void
+) {
+	unsigned char key[CsmgrdC_Key_Max];
+	CsmgrdT_Access_Count acs;
+	uint32_t i;
+
+	for (i = 0 ; i < MemT_Test_Cob_Num ; i++) {
+		mem_cs_ac_cnt_inc (key, test_key_create (i, key), i);
+	}
+	memset (&acs, 0, sizeof (CsmgrdT_Access_Count));
+	acs.name 		= test_name;
+	acs.name_len 	= sizeof (test_name);
+	acs.first 		= 0;
+	acs.last 		= MemT_Test_Cob_Num - 1;
+	acs.count 		= 1;
+	mem_cs_ac_cnt_inc_bulk (&acs, 1);
+}
+
+static void*
+test_hit_thread (
+	void* arg
+) {
+	test_hit_all ();
+	__atomic_store_n (&test_hit_done, 1, __ATOMIC_RELEASE);
+	return (NULL);
+}
+
+/*--------------------------------------------------------------------------------------
+	Hits the Cobs while the churn thread removes them
+----------------------------------------------------------------------------------------*/
+static void*
+test_stress_hit_thread (
+	void* arg
+) {
+	unsigned char key[CsmgrdC_Key_Max];
+	uint32_t seed = (uint32_t)(uintptr_t) arg;
+	uint32_t chunk_num;
+	int i;
+
+	for (i = 0 ; i < MemT_Test_Hit_Num ; i++) {
+		chunk_num = rand_r (&seed) % MemT_Test_Cob_Num;
+		mem_cs_ac_cnt_inc (key, test_key_create (chunk_num, key), chunk_num);
+	}
+	return (NULL);
+}
+
+static void*
+test_churn_thread (
+	void* arg
+) {
+	unsigned char key[CsmgrdC_Key_Max];
+	uint32_t chunk_num;
+	int i;
+
+	for (i = 0 ; i < MemT_Test_Churn_Num ; i++) {
+		chunk_num = i % MemT_Test_Cob_Num;
+		pthread_rwlock_wrlock (&mem_cs_lock);
+		mem_cs_remove (key, test_key_create (chunk_num, key));
+		pthread_rwlock_unlock (&mem_cs_lock);
+		test_cob_put (chunk_num);
+	}
+	__atomic_store_n (&test_churn_f, 0, __ATOMIC_RELEASE);
+	return (NULL);
+}
+
+/*--------------------------------------------------------------------------------------
+	Checks that every Cob is cached and is not pinned
+----------------------------------------------------------------------------------------*/
+static void
+test_entries_check (
+	const char* what
+) {
+	unsigned char key[CsmgrdC_Key_Max];
+	CsmgrdT_Content_Mem_Entry* entry;
+	char buff[256];
+	uint32_t i;
+
+	test_expect (what, hdl->cache_cobs, MemT_Test_Cob_Num);
+	for (i = 0 ; i < MemT_Test_Cob_Num ; i++) {
+		entry = cef_mem_hash_tbl_item_get (key, test_key_create (i, key));
+		snprintf (buff, sizeof (buff), "%s: entry %u is cached", what, i);
+		test_expect (buff, entry != NULL, 1);
+		if (entry == NULL) {
+			continue;
+		}
+		snprintf (buff, sizeof (buff), "%s: references of entry %u", what, i);
+		test_expect (buff, entry->refcnt, 1);
+	}
+}
+
+static void
+test_run_shared (
+	void
+) {
+	pthread_t th;
+	int i;
+
+	/* A hit holds the lock, another hit does not wait for it 	*/
+	mem_cs_hit_lock ();
+	pthread_create (&th, NULL, test_hit_thread, NULL);
+	for (i = 0 ; i < MemT_Test_Hit_Wait ; i++) {
+		if (__atomic_load_n (&test_hit_done, __ATOMIC_ACQUIRE)) {
+			break;
+		}
+		usleep (1000);
+	}
+	test_expect ("hit while another hit holds the lock",
+		__atomic_load_n (&test_hit_done, __ATOMIC_ACQUIRE), 1);
+	pthread_rwlock_unlock (&mem_cs_lock);
+	pthread_join (th, NULL);
+
+	test_entries_check ("shared");
+}
+
+static void
+test_run_stress (
+	void
+) {
+	pthread_t th[MemT_Test_Thread_Num];
+	pthread_t churn_th;
+	int i;
+
+	test_churn_f = 1;
+	pthread_create (&churn_th, NULL, test_churn_thread, NULL);
+	for (i = 0 ; i < MemT_Test_Thread_Num ; i++) {
+		pthread_create (&th[i], NULL, test_stress_hit_thread, (void*)(uintptr_t)(i + 1));
+	}
+	for (i = 0 ; i < MemT_Test_Thread_Num ; i++) {
+		pthread_join (th[i], NULL);
+	}
+	pthread_join (churn_th, NULL);
+
+	test_entries_check ("stress");
+}
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+int
+main (
+	int argc,
+	char** argv
+) {
+	uint32_t i;
+
+	/* The table of the memory cache without the library 	*/
+	hdl = (MemT_Cache_Handle*) calloc (1, sizeof (MemT_Cache_Handle));
+	hdl->cache_capacity = MemT_Test_Cob_Num * 2;
+	strcpy (hdl->algo_name, "None");
+	mem_hash_tbl = cef_mem_hash_tbl_create (hdl->cache_capacity);
+	mem_expiry_heap = cef_expiry_heap_create ();
+	csmgr_stat_hdl = csmgrd_stat_handle_create ();
+	if ((mem_hash_tbl == NULL) || (mem_expiry_heap == NULL) ||
+		(csmgr_stat_hdl == CsmgrC_Invalid)) {
+		fprintf (stderr, "FAIL: init\n");
+		return (1);
+	}
+	for (i = 0 ; i < MemT_Test_Cob_Num ; i++) {
+		test_cob_put (i);
+	}
+	test_entries_check ("put");
+
+	test_run_shared ();
+	test_run_stress ();
+
+	if (test_fail) {
+		return (1);
+	}
+	fprintf (stderr, "mem_cache_test: OK\n");
+	return (0);
+}
@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * tc_demote_test.c
+ */
+
+/*
+	tc_demote_test.c checks that a Cob without expiry which is evicted from the
+	memory tier is passed to the disk tier with the cache time as its expiry, and
+	that it is counted as demoted only when the disk tier has written it. The test
+	builds tiered_cache.c with both tiers replaced by stubs.
+*/
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "tiered_cache.c"
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define TcT_Test_Cache_Time		10000000	/* cache time of the Cobs (us) 			*/
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static int				test_fail = 0;
+static void 			(*test_demote)(const CsmgrdT_Content_Entry*) = NULL;
+static void 			(*test_stored)(const CsmgrdT_Content_Entry*) = NULL;
+static uint64_t			test_put_expiry = 0;		/* expiry of the Cob last put	*/
+static int				test_put_num = 0;			/* Cobs put to the disk tier	*/
+
+/****************************************************************************************
+ Static Functions
+ ****************************************************************************************/
+
+static void
+test_expect (
+	const char* what,
+	uint64_t value,
+	uint64_t expected
+) {
+	if (value != expected) {
+		fprintf (stderr, "FAIL: %s = %llu (expected %llu)\n", what,
+			(unsigned long long) value, (unsigned long long) expected);
+		test_fail = 1;
+	}
+}
+
+static uint64_t
+test_nowt_get (
+	void
+) {
+	struct timeval tv;
+
+	gettimeofday (&tv, NULL);
+	return ((uint64_t) tv.tv_sec * 1000000llu + tv.tv_usec);
+}
+
+/*--------------------------------------------------------------------------------------
+	Stubs of the tiers
+----------------------------------------------------------------------------------------*/
+static int
+test_tier_init (
+	CsmgrT_Stat_Handle stat_hdl, int first_node_f
+) {
+	return (0);
+}
+
+int
+csmgrd_memory_plugin_load (
+	CsmgrdT_Plugin_Interface* cs_in,
+	const char* config_dir
+) {
+	memset (cs_in, 0, sizeof (CsmgrdT_Plugin_Interface));
+	cs_in->init = test_tier_init;
+	return (0);
+}
+
+void
+csmgrd_memory_plugin_tier_set (
+	uint64_t capacity,
+	void (*demote)(const CsmgrdT_Content_Entry*)
+) {
+	test_demote = demote;
+}
+
+int
+csmgrd_memory_plugin_entry_put (
+	CsmgrdT_Content_Entry* entry
+) {
+	return (-1);
+}
+
+int
+csmgrd_filesystem_plugin_load (
+	CsmgrdT_Plugin_Interface* cs_in,
+	const char* config_dir
+) {
+	memset (cs_in, 0, sizeof (CsmgrdT_Plugin_Interface));
+	cs_in->init = test_tier_init;
+	return (0);
+}
+
+void
+csmgrd_filesystem_plugin_tier_set (
+	const char* algo_name,
+	void (*stored)(const CsmgrdT_Content_Entry*)
+) {
+	test_stored = stored;
+}
+
+/*--------------------------------------------------------------------------------------
+	Writes the Cob as the writer thread of the filesystem cache does, which drops
+	the Cob whose expiry has passed
+----------------------------------------------------------------------------------------*/
+int
+csmgrd_filesystem_plugin_entry_put (
+	CsmgrdT_Content_Entry* entry
+) {
+	test_put_num++;
+	test_put_expiry = entry->expiry;
+	if ((entry->expiry >= test_nowt_get ()) && (test_stored)) {
+		(*test_stored)(entry);
+	}
+	free (entry->msg);
+	free (entry->name);
+	free (entry->version);
+	return (0);
+}
+
+int
+csmgrd_filesystem_plugin_cob_read (
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t seqno,
+	CsmgrdT_Content_Entry* entry
+) {
+	return (-1);
+}
+
+/*--------------------------------------------------------------------------------------
+	Demotes a Cob which has the expiry and the cache time
+----------------------------------------------------------------------------------------*/
+static void
+test_cob_demote (
+	uint32_t chunk_num,
+	uint64_t expiry,
+	uint64_t cache_time
+) {
+	static unsigned char msg[] = {0x01, 0x01, 0x00, 0x08, 0x00, 0x00, 0x00, 0x08};
+	static unsigned char name[] = {0x00, 0x01, 0x00, 0x04, 't', 'e', 's', 't'};
+	CsmgrdT_Content_Entry cob;
+
+	memset (&cob, 0, sizeof (CsmgrdT_Content_Entry));
+	cob.msg 		= msg;
+	cob.msg_len 	= sizeof (msg);
+	cob.name 		= name;
+	cob.name_len 	= sizeof (name);
+	cob.chunk_num 	= chunk_num;
+	cob.expiry 		= expiry;
+	cob.cache_time 	= cache_time;
+	(*test_demote)(&cob);
+}
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+int
+main (
+	int argc,
+	char** argv
+) {
+	CsmgrdT_Plugin_Interface cs_in;
+	CsmgrT_Stat_Handle stat_hdl;
+	char dir[] = "/tmp/tc_demote_testXXXXXX";
+	char path[PATH_MAX];
+	uint64_t nowt;
+	FILE* fp;
+
+	/* csmgrd.conf of the tiered cache 	*/
+	if (mkdtemp (dir) == NULL) {
+		fprintf (stderr, "FAIL: mkdtemp\n");
+		return (1);
+	}
+	snprintf (path, sizeof (path), "%s/csmgrd.conf", dir);
+	fp = fopen (path, "w");
+	if (fp == NULL) {
+		fprintf (stderr, "FAIL: fopen %s\n", path);
+		return (1);
+	}
+	fprintf (fp, "CACHE_ALGORITHM=None\n");
+	fclose (fp);
+
+	stat_hdl = csmgrd_stat_handle_create ();
+	if ((csmgrd_tiered_plugin_load (&cs_in, dir) < 0) ||
+		((*cs_in.init)(stat_hdl, 1) < 0)) {
+		fprintf (stderr, "FAIL: init\n");
+		return (1);
+	}
+	test_expect ("demote callback is set", test_demote != NULL, 1);
+	test_expect ("stored callback is set", test_stored != NULL, 1);
+	if (test_fail) {
+		return (1);
+	}
+	nowt = test_nowt_get ();
+
+	/* The Cob without expiry keeps the cache time of the memory tier 	*/
+	test_cob_demote (0, 0, nowt + TcT_Test_Cache_Time);
+	test_expect ("Cobs put (no expiry)", test_put_num, 1);
+	test_expect ("expiry (no expiry)", test_put_expiry, nowt + TcT_Test_Cache_Time);
+	test_expect ("Cobs demoted (no expiry)", hdl->demote_num, 1);
+
+	/* The Cob which has the expiry keeps it 	*/
+	test_cob_demote (1, nowt + TcT_Test_Cache_Time / 2, nowt + TcT_Test_Cache_Time);
+	test_expect ("expiry (expiry)", test_put_expiry, nowt + TcT_Test_Cache_Time / 2);
+	test_expect ("Cobs demoted (expiry)", hdl->demote_num, 2);
+
+	/* The Cob which the disk tier drops is not counted 	*/
+	test_cob_demote (2, nowt - 1, nowt + TcT_Test_Cache_Time);
+	test_expect ("Cobs put (dropped)", test_put_num, 3);
+	test_expect ("Cobs demoted (dropped)", hdl->demote_num, 2);
+
+	unlink (path);
+	rmdir (dir);
+
+	if (test_fail) {
+		return (1);
+	}
+	fprintf (stderr, "tc_demote_test: OK\n");
+	return (0);
+}
@@ -0,0 +1,760 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * tiered_cache.c
+ */
+#define __CSMGRD_TIERED_CACHE_SOURCE__
+
+/*
+	tiered_cache.c keeps the hot Cobs in the memory cache and the others in the
+	filesystem cache. The Cobs evicted from the memory tier are demoted to the disk
+	tier, and the Cobs hit on the disk tier are promoted when the Count-Min sketch
+	estimates that they were hit TIER_PROMOTE_COUNT times. Each tier has its own
+	stat table, which mirrors the cached Cobs to the table of csmgrd.
+*/
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif // HAVE_CONFIG_H
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+
+#include "tiered_cache.h"
+#include "../mem_cache/mem_cache.h"
+#include "../filesystem_cache/filesystem_cache.h"
+#include <cefore/cef_client.h>
+#include <cefore/cef_csmgr.h>
+#include <cefore/cef_frame.h>
+#include <csmgrd/csmgrd_plugin.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static TcT_Cache_Handle* 		hdl = NULL;
+static char 					csmgr_conf_dir[PATH_MAX] = {"/usr/local/cefore"};
+static CsmgrT_Stat_Handle 		csmgr_stat_hdl;
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Init content store
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+tc_cs_create (
+	CsmgrT_Stat_Handle stat_hdl, int first_node_f
+);
+/*--------------------------------------------------------------------------------------
+	Destroy content store
+----------------------------------------------------------------------------------------*/
+static void
+tc_cs_destroy (
+	int Last_Node_f
+);
+/*--------------------------------------------------------------------------------------
+	Check content expire
+----------------------------------------------------------------------------------------*/
+static void
+tc_cs_expire_check (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Function to read a ContentObject from the tiers
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+tc_cache_item_get (
+	unsigned char* key,							/* content name							*/
+	uint16_t key_size,							/* content name Length					*/
+	uint32_t seqno,								/* chunk num							*/
+	int sock,									/* received socket						*/
+	unsigned char* version,						/* version								*/
+	uint16_t ver_len,							/* length of version					*/
+	unsigned char* csact_val,					/* Plain Text							*/
+	uint16_t csact_len,							/* length of Plain Text					*/
+	unsigned char* signature_val,				/* signature							*/
+	uint16_t signature_len						/* length of signature					*/
+);
+/*--------------------------------------------------------------------------------------
+	Upload content byte steream
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+tc_cache_item_puts (
+	unsigned char* msg,
+	int msg_len
+);
+/*--------------------------------------------------------------------------------------
+	Function to increment access count
+----------------------------------------------------------------------------------------*/
+static void
+tc_cs_ac_cnt_inc (
+	unsigned char* key,							/* content name							*/
+	uint16_t key_size,							/* content name Length					*/
+	uint32_t seq_num							/* sequence number						*/
+);
+/*--------------------------------------------------------------------------------------
+	Function to increment access counts of the ranges of chunks
+----------------------------------------------------------------------------------------*/
+static void
+tc_cs_ac_cnt_inc_bulk (
+	CsmgrdT_Access_Count* acs,					/* ranges of chunks which were hit		*/
+	int num										/* number of ranges						*/
+);
+/*--------------------------------------------------------------------------------------
+	get lifetime for ccninfo
+----------------------------------------------------------------------------------------*/
+static int
+tc_cache_lifetime_get (
+	unsigned char* name,
+	uint16_t name_len,
+	uint32_t* cache_time,
+	uint32_t* lifetime,
+	uint8_t partial_f
+);
+/*--------------------------------------------------------------------------------------
+	Read config file
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+tc_config_read (
+	TcT_Config_Param* params
+);
+/*--------------------------------------------------------------------------------------
+	Passes the Cob evicted from the memory tier to the disk tier
+----------------------------------------------------------------------------------------*/
+static void
+tc_cob_demote (
+	const CsmgrdT_Content_Entry* cob
+);
+/*--------------------------------------------------------------------------------------
+	Called by the disk tier with the Cob it has written
+----------------------------------------------------------------------------------------*/
+static void
+tc_cob_demoted (
+	const CsmgrdT_Content_Entry* cob
+);
+/*--------------------------------------------------------------------------------------
+	Copies the Cob cached in the disk tier to the memory tier
+----------------------------------------------------------------------------------------*/
+static void
+tc_cob_promote (
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t seqno
+);
+/*--------------------------------------------------------------------------------------
+	Counts a disk hit of the Cob and returns the estimated hits
+----------------------------------------------------------------------------------------*/
+static int
+tc_sketch_count (
+	TcT_Sketch* sk,
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t seqno
+);
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Road the cache plugin
+----------------------------------------------------------------------------------------*/
+int
+csmgrd_tiered_plugin_load (
+	CsmgrdT_Plugin_Interface* cs_in,
+	const char* config_dir
+) {
+	CSMGRD_SET_CALLBACKS (
+		tc_cs_create, tc_cs_destroy, tc_cs_expire_check, tc_cache_item_get,
+		tc_cache_item_puts, tc_cs_ac_cnt_inc, tc_cache_lifetime_get);
+	cs_in->ac_cnt_inc_bulk = tc_cs_ac_cnt_inc_bulk;
+
+	if (config_dir) {
+		strcpy (csmgr_conf_dir, config_dir);
+	}
+
+	if (hdl != NULL) {
+		free (hdl);
+	}
+	hdl = (TcT_Cache_Handle*) calloc (1, sizeof (TcT_Cache_Handle));
+	if (hdl == NULL) {
+		return (-1);
+	}
+	pthread_mutex_init (&hdl->sketch.mutex, NULL);
+
+	/* Loads the tiers 	*/
+	if ((csmgrd_memory_plugin_load (&hdl->mem_in, config_dir) < 0) ||
+		(csmgrd_filesystem_plugin_load (&hdl->fsc_in, config_dir) < 0)) {
+		return (-1);
+	}
+
+	/* Init logging 	*/
+	csmgrd_log_init ("tiered", 1);
+	csmgrd_log_init2 (csmgr_conf_dir);
+#ifdef CefC_Debug
+	csmgrd_dbg_init ("tiered", csmgr_conf_dir);
+#endif // CefC_Debug
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Init API
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+tc_cs_create (
+	CsmgrT_Stat_Handle stat_hdl, int first_node_f
+) {
+	TcT_Config_Param conf_param;
+
+	if (hdl == NULL) {
+		return (-1);
+	}
+
+	/* Reads config 		*/
+	if (tc_config_read (&conf_param) < 0) {
+		csmgrd_log_write (CefC_Log_Error, "[%s] read config\n", __func__);
+		return (-1);
+	}
+	hdl->promote_count = conf_param.promote_count;
+
+	/* Creates the stat tables of the tiers 	*/
+	csmgr_stat_hdl = stat_hdl;
+	hdl->mem_stat_hdl = csmgrd_stat_tier_handle_create (stat_hdl);
+	hdl->fsc_stat_hdl = csmgrd_stat_tier_handle_create (stat_hdl);
+	if ((hdl->mem_stat_hdl == CsmgrC_Invalid) || (hdl->fsc_stat_hdl == CsmgrC_Invalid)) {
+		csmgrd_log_write (CefC_Log_Error, "Failed to create the stat tables of the tiers\n");
+		return (-1);
+	}
+
+	/* Initializes the tiers 	*/
+	csmgrd_memory_plugin_tier_set (conf_param.mem_capacity, tc_cob_demote);
+	csmgrd_filesystem_plugin_tier_set (conf_param.disk_algo_name, tc_cob_demoted);
+
+	if ((*hdl->mem_in.init)(hdl->mem_stat_hdl, first_node_f) < 0) {
+		csmgrd_log_write (CefC_Log_Error, "Failed to initialize the memory tier\n");
+		return (-1);
+	}
+	if ((*hdl->fsc_in.init)(hdl->fsc_stat_hdl, first_node_f) < 0) {
+		csmgrd_log_write (CefC_Log_Error, "Failed to initialize the disk tier\n");
+		return (-1);
+	}
+
+	/* The disk tier may already have restored its Cobs into the parent table */
+	csmgrd_stat_cache_capacity_set (csmgr_stat_hdl,
+		csmgrd_stat_cache_capacity_get (hdl->mem_stat_hdl) +
+		csmgrd_stat_cache_capacity_get (hdl->fsc_stat_hdl));
+	csmgrd_stat_cache_capacity_bytes_update (csmgr_stat_hdl,
+		csmgrd_stat_cache_capacity_bytes_get (hdl->mem_stat_hdl));
+
+	csmgrd_log_write (CefC_Log_Info, "Start\n");
+	csmgrd_log_write (CefC_Log_Info,
+		"Memory Tier Capacity : "FMTU64"\n", conf_param.mem_capacity);
+	csmgrd_log_write (CefC_Log_Info,
+		"Disk Tier Library : %s\n", conf_param.disk_algo_name);
+	csmgrd_log_write (CefC_Log_Info,
+		"Promote Count : %d\n", conf_param.promote_count);
+	if (strcmp (conf_param.algo_name, "None") == 0) {
+		csmgrd_log_write (CefC_Log_Info,
+			"The memory tier has no library, Cobs are cached to the disk tier when it is full\n");
+	}
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Destroy content store
+----------------------------------------------------------------------------------------*/
+static void
+tc_cs_destroy (
+	int Last_Node_f
+) {
+	if (hdl == NULL) {
+		return;
+	}
+
+	/* The disk tier is destroyed after the memory tier which demotes Cobs to it 	*/
+	if (hdl->mem_in.destroy) {
+		(*hdl->mem_in.destroy)(Last_Node_f);
+	}
+	if (hdl->fsc_in.destroy) {
+		(*hdl->fsc_in.destroy)(Last_Node_f);
+	}
+	csmgrd_log_write (CefC_Log_Info,
+		"Promoted : "FMTU64", Demoted : "FMTU64"\n", hdl->promote_num, hdl->demote_num);
+
+	csmgrd_stat_handle_destroy (hdl->mem_stat_hdl);
+	csmgrd_stat_handle_destroy (hdl->fsc_stat_hdl);
+	pthread_mutex_destroy (&hdl->sketch.mutex);
+	free (hdl);
+	hdl = NULL;
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Check content expire
+----------------------------------------------------------------------------------------*/
+static void
+tc_cs_expire_check (
+	void
+) {
+	(*hdl->mem_in.expire_check)();
+	(*hdl->fsc_in.expire_check)();
+}
+/*--------------------------------------------------------------------------------------
+	Function to read a ContentObject from the tiers
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+tc_cache_item_get (
+	unsigned char* key,							/* content name							*/
+	uint16_t key_size,							/* content name Length					*/
+	uint32_t seqno,								/* chunk num							*/
+	int sock,									/* received socket						*/
+	unsigned char* version,						/* version								*/
+	uint16_t ver_len,							/* length of version					*/
+	unsigned char* csact_val,					/* Plain Text							*/
+	uint16_t csact_len,							/* length of Plain Text					*/
+	unsigned char* signature_val,				/* signature							*/
+	uint16_t signature_len						/* length of signature					*/
+) {
+	int res;
+
+	res = (*hdl->mem_in.cache_item_get)(key, key_size, seqno, sock, version, ver_len,
+			csact_val, csact_len, signature_val, signature_len);
+	if (res == CefC_Csmgr_Cob_Exist) {
+		return (res);
+	}
+	res = (*hdl->fsc_in.cache_item_get)(key, key_size, seqno, sock, version, ver_len,
+			csact_val, csact_len, signature_val, signature_len);
+
+	/* Promotes the Cob which was hit on the disk tier frequently 	*/
+	if ((res == CefC_Csmgr_Cob_Exist) && (csact_len == 0) &&
+		(tc_sketch_count (&hdl->sketch, key, key_size, seqno) >= hdl->promote_count)) {
+		tc_cob_promote (key, key_size, seqno);
+	}
+	return (res);
+}
+/*--------------------------------------------------------------------------------------
+	Upload content byte steream
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+tc_cache_item_puts (
+	unsigned char* msg,
+	int msg_len
+) {
+	/* New Cobs are cached in the memory tier 	*/
+	return ((*hdl->mem_in.cache_item_puts)(msg, msg_len));
+}
+/*--------------------------------------------------------------------------------------
+	Function to increment access count
+----------------------------------------------------------------------------------------*/
+static void
+tc_cs_ac_cnt_inc (
+	unsigned char* key,							/* content name							*/
+	uint16_t key_size,							/* content name Length					*/
+	uint32_t seq_num							/* sequence number						*/
+) {
+	struct tlv_hdr* tlv_hdp;
+	int index = 0;
+	uint16_t type;
+	uint16_t length;
+
+	/* Finds the tier which has the Cob by the name without the chunk number 	*/
+	while (index + (int) sizeof (struct tlv_hdr) <= key_size) {
+		tlv_hdp = (struct tlv_hdr*) &key[index];
+		type 	= ntohs (tlv_hdp->type);
+		length 	= ntohs (tlv_hdp->length);
+
+		if (length < 1) {
+			return;
+		}
+		if (type == CefC_T_CHUNK) {
+			break;
+		}
+		index += sizeof (struct tlv_hdr) + length;
+	}
+
+	if (csmgrd_stat_cob_is_cached (hdl->mem_stat_hdl, key, index, seq_num)) {
+		(*hdl->mem_in.ac_cnt_inc)(key, key_size, seq_num);
+	} else {
+		(*hdl->fsc_in.ac_cnt_inc)(key, key_size, seq_num);
+	}
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Function to increment access counts of the ranges of chunks
+----------------------------------------------------------------------------------------*/
+static void
+tc_cs_ac_cnt_inc_bulk (
+	CsmgrdT_Access_Count* acs,					/* ranges of chunks which were hit		*/
+	int num										/* number of ranges						*/
+) {
+	CsmgrdT_Access_Count runs[2][CefC_Csmgr_Bulk_Increment_Max];
+	CsmgrdT_Plugin_Interface* tiers[2] = { &hdl->mem_in, &hdl->fsc_in };
+	CsmgrdT_Access_Count* run = NULL;
+	int run_num[2] = { 0, 0 };
+	uint32_t chunk_num;
+	uint32_t extra;
+	int tier, prev;
+	int i;
+
+	/* Splits the ranges into the runs of chunks held by the same tier. The 	*/
+	/* hits beyond one per chunk are given to the first run of the range 		*/
+	for (i = 0 ; i < num ; i++) {
+		extra = acs[i].count - (acs[i].last - acs[i].first + 1);
+		prev = -1;
+
+		for (chunk_num = acs[i].first ; ; chunk_num++) {
+			tier = csmgrd_stat_cob_is_cached (
+				hdl->mem_stat_hdl, acs[i].name, acs[i].name_len, chunk_num) ? 0 : 1;
+			if (tier != prev) {
+				if (run_num[tier] == CefC_Csmgr_Bulk_Increment_Max) {
+					(*tiers[tier]->ac_cnt_inc_bulk)(runs[tier], run_num[tier]);
+					run_num[tier] = 0;
+				}
+				run = &runs[tier][run_num[tier]];
+				run_num[tier]++;
+				run->name     = acs[i].name;
+				run->name_len = acs[i].name_len;
+				run->first    = chunk_num;
+				run->count    = extra;
+				extra = 0;
+				prev  = tier;
+			}
+			run->last = chunk_num;
+			run->count++;
+
+			if (chunk_num == acs[i].last) {
+				break;
+			}
+		}
+	}
+
+	for (tier = 0 ; tier < 2 ; tier++) {
+		if (run_num[tier] > 0) {
+			(*tiers[tier]->ac_cnt_inc_bulk)(runs[tier], run_num[tier]);
+		}
+	}
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	get lifetime for ccninfo
+----------------------------------------------------------------------------------------*/
+static int										/* This value MAY be -1 if the router does not know or cannot report. */
+tc_cache_lifetime_get (
+	unsigned char* name,						/* content name							*/
+	uint16_t name_len,							/* content name Length					*/
+	uint32_t* cache_time,						/* The elapsed time (seconds) after the oldest	*/
+												/* content object of the content is cached.		*/
+	uint32_t* lifetime,							/* The lifetime (seconds) of a content object, 	*/
+												/* which is removed first among the cached content objects.*/
+	uint8_t partial_f							/* when flag is 0, exact match			*/
+												/* when flag is 1, partial match		*/
+) {
+	int res;
+
+	res = (*hdl->mem_in.content_lifetime_get)(name, name_len, cache_time, lifetime, partial_f);
+	if (res < 0) {
+		res = (*hdl->fsc_in.content_lifetime_get)(name, name_len, cache_time, lifetime, partial_f);
+	}
+	return (res);
+}
+/*--------------------------------------------------------------------------------------
+	Passes the Cob evicted from the memory tier to the disk tier
+----------------------------------------------------------------------------------------*/
+static void
+tc_cob_demote (
+	const CsmgrdT_Content_Entry* cob
+) {
+	CsmgrdT_Content_Entry entry;
+
+	/* The Cob promoted before is still cached in the disk tier 	*/
+	if (csmgrd_stat_cob_is_cached (
+			hdl->fsc_stat_hdl, cob->name, cob->name_len, cob->chunk_num)) {
+		return;
+	}
+
+	/* The memory tier still owns the buffers of the Cob 	*/
+	memcpy (&entry, cob, sizeof (CsmgrdT_Content_Entry));
+	entry.msg = (unsigned char*) malloc (cob->msg_len);
+	entry.name = (unsigned char*) malloc (cob->name_len);
+	entry.version = NULL;
+	if (cob->ver_len) {
+		entry.version = (unsigned char*) malloc (cob->ver_len);
+	}
+	if ((entry.msg == NULL) || (entry.name == NULL) ||
+		((cob->ver_len) && (entry.version == NULL))) {
+		free (entry.msg);
+		free (entry.name);
+		free (entry.version);
+		return;
+	}
+	memcpy (entry.msg, cob->msg, cob->msg_len);
+	memcpy (entry.name, cob->name, cob->name_len);
+	if (cob->ver_len) {
+		memcpy (entry.version, cob->version, cob->ver_len);
+	}
+
+	/* The disk tier drops a Cob whose expiry has passed, so the Cob which has no 	*/
+	/* expiry keeps the cache time of the memory tier as its expiry 				*/
+	if (entry.expiry == 0) {
+		entry.expiry = (cob->cache_time != 0) ? cob->cache_time : UINT64_MAX;
+	}
+
+	/* tc_cob_demoted counts the Cob when the disk tier has written it 	*/
+	csmgrd_filesystem_plugin_entry_put (&entry);
+}
+/*--------------------------------------------------------------------------------------
+	Called by the disk tier with the Cob it has written
+----------------------------------------------------------------------------------------*/
+static void
+tc_cob_demoted (
+	const CsmgrdT_Content_Entry* cob
+) {
+	__atomic_add_fetch (&hdl->demote_num, 1, __ATOMIC_ACQ_REL);
+}
+/*--------------------------------------------------------------------------------------
+	Copies the Cob cached in the disk tier to the memory tier
+----------------------------------------------------------------------------------------*/
+static void
+tc_cob_promote (
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t seqno
+) {
+	CsmgrdT_Content_Entry entry;
+
+	if (csmgrd_stat_cob_is_cached (hdl->mem_stat_hdl, name, name_len, seqno)) {
+		return;
+	}
+	if (csmgrd_filesystem_plugin_cob_read (name, name_len, seqno, &entry) < 0) {
+		return;
+	}
+
+	/* The copy in the disk tier is kept, so the Cob is not written again when 	*/
+	/* it is evicted from the memory tier 										*/
+	if (csmgrd_memory_plugin_entry_put (&entry) == 0) {
+		__atomic_add_fetch (&hdl->promote_num, 1, __ATOMIC_ACQ_REL);
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Counts a disk hit of the Cob and returns the estimated hits
+----------------------------------------------------------------------------------------*/
+static int
+tc_sketch_count (
+	TcT_Sketch* sk,
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t seqno
+) {
+	uint64_t h = 14695981039346656037ULL;		/* FNV-1a 						*/
+	uint32_t h1, h2;
+	uint32_t pos[TcC_Sketch_Depth];
+	int est = TcC_Sketch_Counter_Max;
+	int i, j;
+
+	for (i = 0 ; i < name_len ; i++) {
+		h = (h ^ name[i]) * 1099511628211ULL;
+	}
+	for (i = 0 ; i < 4 ; i++) {
+		h = (h ^ ((seqno >> (i * 8)) & 0xFF)) * 1099511628211ULL;
+	}
+	h1 = (uint32_t) h;
+	h2 = (uint32_t)(h >> 32) | 1;
+	for (i = 0 ; i < TcC_Sketch_Depth ; i++) {
+		pos[i] = (h1 + i * h2) & (TcC_Sketch_Width - 1);
+	}
+
+	pthread_mutex_lock (&sk->mutex);
+
+	/* Only the smallest counters are incremented (conservative update) 	*/
+	for (i = 0 ; i < TcC_Sketch_Depth ; i++) {
+		if (sk->counters[i][pos[i]] < est) {
+			est = sk->counters[i][pos[i]];
+		}
+	}
+	if (est < TcC_Sketch_Counter_Max) {
+		est++;
+		for (i = 0 ; i < TcC_Sketch_Depth ; i++) {
+			if (sk->counters[i][pos[i]] < est) {
+				sk->counters[i][pos[i]] = est;
+			}
+		}
+	}
+
+	/* Halves the counters periodically so that old hits are forgotten 	*/
+	sk->hit_num++;
+	if (sk->hit_num >= TcC_Sketch_Period) {
+		for (i = 0 ; i < TcC_Sketch_Depth ; i++) {
+			for (j = 0 ; j < TcC_Sketch_Width ; j++) {
+				sk->counters[i][j] >>= 1;
+			}
+		}
+		sk->hit_num = 0;
+	}
+	pthread_mutex_unlock (&sk->mutex);
+
+	return (est);
+}
+/*--------------------------------------------------------------------------------------
+	Read config file
+----------------------------------------------------------------------------------------*/
+static int							/* The return value is negative if an error occurs	*/
+tc_config_read (
+	TcT_Config_Param* params						/* record parameters				*/
+) {
+	FILE*	fp = NULL;								/* file pointer						*/
+	char	file_name[PATH_MAX];					/* file name						*/
+
+	char	param[4096] = {0};						/* parameter						*/
+	char	param_buff[4096] = {0};					/* param buff						*/
+	int		len;									/* read length						*/
+
+	char*	option;									/* deny option						*/
+	char*	value;									/* parameter						*/
+	int		res;
+
+	int		i, n;
+
+	/* Inits parameters		*/
+	memset (params, 0, sizeof (TcT_Config_Param));
+	params->mem_capacity = TcC_Mem_Capacity_Default;
+	params->promote_count = TcC_Promote_Count_Default;
+	strcpy (params->algo_name, "None");
+	strcpy (params->disk_algo_name, "None");
+
+	/* Obtains the directory path where the csmgrd's config file is located. */
+	res = snprintf (file_name, sizeof (file_name), "%s/csmgrd.conf", csmgr_conf_dir);
+	if (res < 0 || res >= (int) sizeof (file_name)) {
+		csmgrd_log_write (CefC_Log_Error,
+			"[%s] Config file dir path too long(%s)\n", __func__, csmgr_conf_dir);
+		return (-1);
+	}
+
+	/* Opens the config file. */
+	fp = fopen (file_name, "r");
+	if (fp == NULL) {
+		csmgrd_log_write (CefC_Log_Error, "[%s] open %s\n", __func__, file_name);
+		return (-1);
+	}
+
+	/* get parameter	*/
+	while (fgets (param_buff, sizeof (param_buff), fp) != NULL) {
+
+		/* Trims a read line 		*/
+		len = strlen (param_buff);
+		if ((param_buff[0] == '#') || (param_buff[0] == '\n') || (len == 0)) {
+			continue;
+		}
+		if (param_buff[len - 1] == '\n') {
+			param_buff[len - 1] = '\0';
+		}
+		for (i = 0, n = 0 ; i < len ; i++) {
+			if (param_buff[i] != ' ') {
+				param[n] = param_buff[i];
+				n++;
+			}
+		}
+		param[n] = '\0';
+
+		/* Gets option */
+		value 	= param;
+		option 	= strsep (&value, "=");
+
+		if (value == NULL) {
+			continue;
+		}
+
+		/* Records a parameter 			*/
+		if (strcmp (option, "CACHE_ALGORITHM") == 0) {
+			strncpy (params->algo_name, value, sizeof (params->algo_name) - 1);
+		} else if (strcmp (option, "TIER_DISK_ALGORITHM") == 0) {
+			strncpy (params->disk_algo_name, value, sizeof (params->disk_algo_name) - 1);
+		} else if (strcmp (option, "TIER_MEMORY_CAPACITY") == 0) {
+			char *endptr = "";
+			params->mem_capacity = strtoul (value, &endptr, 0);
+			if (strcmp (endptr, "") != 0) {
+				csmgrd_log_write (
+					CefC_Log_Error, "[%s] Invalid value %s=%s\n", __func__, option, value);
+				fclose (fp);
+				return (-1);
+			}
+			if ((params->mem_capacity < 1) || (params->mem_capacity > 2147483647)) {
+				csmgrd_log_write (CefC_Log_Error,
+				"TIER_MEMORY_CAPACITY must be between 1 and 2147483647 inclusive.\n");
+				fclose (fp);
+				return (-1);
+			}
+		} else if (strcmp (option, "TIER_PROMOTE_COUNT") == 0) {
+			res = atoi (value);
+			if (!(1 <= res && res <= TcC_Promote_Count_Max)) {
+				csmgrd_log_write (CefC_Log_Error,
+					"TIER_PROMOTE_COUNT must be between 1 and %d inclusive.\n",
+					TcC_Promote_Count_Max);
+				fclose (fp);
+				return (-1);
+			}
+			params->promote_count = res;
+		} else {
+			/* NOP */;
+		}
+	}
+	fclose (fp);
+
+	/* The library has one instance in csmgrd, so the tiers cannot share it 	*/
+	if ((strcmp (params->disk_algo_name, "None") != 0) &&
+		(strcmp (params->disk_algo_name, params->algo_name) == 0)) {
+		csmgrd_log_write (CefC_Log_Error,
+			"TIER_DISK_ALGORITHM must be different from CACHE_ALGORITHM.\n");
+		return (-1);
+	}
+#ifdef CefC_Debug
+	csmgrd_dbg_write (CefC_Dbg_Fine, "params->mem_capacity="FMTU64"\n",
+						params->mem_capacity);
+	csmgrd_dbg_write (CefC_Dbg_Fine, "params->promote_count=%d\n",
+						params->promote_count);
+	csmgrd_dbg_write (CefC_Dbg_Fine, "params->disk_algo_name=%s\n",
+						params->disk_algo_name);
+#endif // CefC_Debug
+
+	return (0);
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * tiered_cache.h
+ */
+#ifndef __CSMGRD_TIERED_CACHE_HEADER__
+#define __CSMGRD_TIERED_CACHE_HEADER__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+#include <netinet/in.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include <cefore/cef_define.h>
+#include <cefore/cef_csmgr.h>
+#include <csmgrd/csmgrd_plugin.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+/*------------------------------------------------------------------
+	Limitation
+--------------------------------------------------------------------*/
+#define TcC_Mem_Capacity_Default		65536			/* Cobs in the memory tier		*/
+#define TcC_Promote_Count_Default		2				/* disk hits to promote a Cob	*/
+#define TcC_Promote_Count_Max			15
+
+/*------------------------------------------------------------------
+	Count-Min sketch which estimates the disk hits of a Cob
+--------------------------------------------------------------------*/
+#define TcC_Sketch_Depth				4
+#define TcC_Sketch_Width				4096			/* must be a power of 2			*/
+#define TcC_Sketch_Counter_Max			15
+#define TcC_Sketch_Period				(TcC_Sketch_Width * 8)
+												/* hits to halve the counters			*/
+
+/****************************************************************************************
+ Structure Declarations
+ ****************************************************************************************/
+
+typedef struct {
+
+	uint64_t 		mem_capacity;				/* Cobs cached in the memory tier		*/
+	int 			promote_count;				/* disk hits to promote a Cob			*/
+	char 			algo_name[1024];			/* algorithm of the memory tier			*/
+	char 			disk_algo_name[1024];		/* algorithm of the disk tier			*/
+
+} TcT_Config_Param;
+
+typedef struct {
+
+	uint8_t 		counters[TcC_Sketch_Depth][TcC_Sketch_Width];
+	uint32_t 		hit_num;					/* hits since the counters were halved	*/
+	pthread_mutex_t mutex;
+
+} TcT_Sketch;
+
+typedef struct {
+
+	/********** tiers 		***********/
+	CsmgrdT_Plugin_Interface	mem_in;			/* memory cache (upper tier)			*/
+	CsmgrdT_Plugin_Interface	fsc_in;			/* filesystem cache (lower tier)		*/
+	CsmgrT_Stat_Handle 			mem_stat_hdl;
+	CsmgrT_Stat_Handle 			fsc_stat_hdl;
+
+	/********** promotion 	***********/
+	int 			promote_count;
+	TcT_Sketch 		sketch;
+
+	/********** statistics 	***********/
+	uint64_t 		promote_num;				/* Cobs copied to the memory tier		*/
+	uint64_t 		demote_num;					/* Cobs written to the disk tier		*/
+
+} TcT_Cache_Handle;
+
+/****************************************************************************************
+ Global Function Declaration
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Road the cache plugin
+----------------------------------------------------------------------------------------*/
+int
+csmgrd_tiered_plugin_load (
+	CsmgrdT_Plugin_Interface* cs_in,
+	const char* config_dir
+);
+
+#endif // __CSMGRD_TIERED_CACHE_HEADER__
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * cef_chunk_set.h
+ */
+
+#ifndef __CEF_CHUNK_SET_HEADER__
+#define __CEF_CHUNK_SET_HEADER__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#include <stdint.h>
+#include <stdlib.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define CefC_Chunk_Set_Run				0		/* container keeps the runs				*/
+#define CefC_Chunk_Set_Bitmap			1		/* container keeps the bitmap			*/
+
+#define CefC_Chunk_Set_Bitmap_Words		1024	/* 65536 bits in a bitmap container		*/
+#define CefC_Chunk_Set_Run_Max			2048	/* runs which fit in a bitmap size		*/
+
+/****************************************************************************************
+ Structure Declarations
+ ****************************************************************************************/
+
+/********** Chunks which have the same upper 16 bits 	**********/
+typedef struct {
+
+	uint16_t 	key;				/* upper 16 bits of the chunk numbers				*/
+	uint16_t 	type;				/* CefC_Chunk_Set_Run or CefC_Chunk_Set_Bitmap		*/
+	uint32_t 	card;				/* number of the chunks in the container			*/
+	uint16_t 	run_num;			/* number of the runs								*/
+	uint16_t 	run_max;			/* number of the slots of the runs					*/
+	uint16_t* 	runs;				/* sorted pairs of the first and the last (lower 16	*/
+									/* bits) of the contiguous chunks					*/
+	uint64_t* 	bits;				/* bitmap of the lower 16 bits						*/
+
+} CefT_Chunk_Container;
+
+/********** Compressed set of the chunk numbers 	**********/
+/* Containers are sorted by the upper 16 bits. A container keeps the contiguous		*/
+/* chunks as runs, and changes to the bitmap when the runs become larger than the	*/
+/* bitmap. The caller is responsible for the lock.									*/
+typedef struct {
+
+	CefT_Chunk_Container* 	conts;	/* sorted containers 								*/
+	uint32_t 				num;	/* number of the containers 						*/
+	uint32_t 				max;	/* number of the slots of the containers			*/
+	uint64_t 				card;	/* number of the chunks in the set					*/
+
+} CefT_Chunk_Set;
+
+/****************************************************************************************
+ Function Declarations
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Initializes the empty chunk set
+----------------------------------------------------------------------------------------*/
+void
+cef_chunk_set_init (
+	CefT_Chunk_Set* set						/* chunk set								*/
+);
+/*--------------------------------------------------------------------------------------
+	Removes all chunks and frees the memory used by the set
+----------------------------------------------------------------------------------------*/
+void
+cef_chunk_set_clear (
+	CefT_Chunk_Set* set						/* chunk set								*/
+);
+/*--------------------------------------------------------------------------------------
+	Adds the chunk to the set
+----------------------------------------------------------------------------------------*/
+int 										/* 1: added, 0: already in the set,			*/
+											/* negative: the set cannot be extended		*/
+cef_chunk_set_add (
+	CefT_Chunk_Set* set,					/* chunk set								*/
+	uint32_t chunk							/* chunk number								*/
+);
+/*--------------------------------------------------------------------------------------
+	Removes the chunk from the set
+----------------------------------------------------------------------------------------*/
+int 										/* 1: removed, 0: not in the set,			*/
+											/* negative: the set cannot be extended		*/
+cef_chunk_set_remove (
+	CefT_Chunk_Set* set,					/* chunk set								*/
+	uint32_t chunk							/* chunk number								*/
+);
+/*--------------------------------------------------------------------------------------
+	Checks whether the chunk is in the set
+----------------------------------------------------------------------------------------*/
+int 										/* 1 if the chunk is in the set				*/
+cef_chunk_set_contains (
+	const CefT_Chunk_Set* set,				/* chunk set								*/
+	uint32_t chunk							/* chunk number								*/
+);
+/*--------------------------------------------------------------------------------------
+	Returns the number of the chunks in the set
+----------------------------------------------------------------------------------------*/
+uint64_t
+cef_chunk_set_count (
+	const CefT_Chunk_Set* set				/* chunk set								*/
+);
+/*--------------------------------------------------------------------------------------
+	Returns the number of the chunks in the set which are smaller than the chunk
+----------------------------------------------------------------------------------------*/
+uint64_t
+cef_chunk_set_rank (
+	const CefT_Chunk_Set* set,				/* chunk set								*/
+	uint32_t chunk							/* chunk number								*/
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the first range of the contiguous chunks which has the chunk not smaller
+	than the specified chunk. The range is clipped at the specified chunk.
+----------------------------------------------------------------------------------------*/
+int 										/* 1 if the range is found					*/
+cef_chunk_set_range_next (
+	const CefT_Chunk_Set* set,				/* chunk set								*/
+	uint32_t from,							/* chunk number to start the search			*/
+	uint32_t* first,						/* first chunk of the range					*/
+	uint32_t* last							/* last chunk of the range					*/
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the smallest and the largest chunks in the set
+----------------------------------------------------------------------------------------*/
+int 										/* 0 if the set is empty					*/
+cef_chunk_set_min_max (
+	const CefT_Chunk_Set* set,				/* chunk set								*/
+	uint32_t* min,							/* smallest chunk							*/
+	uint32_t* max							/* largest chunk							*/
+);
+/*--------------------------------------------------------------------------------------
+	Returns the bytes of the memory used by the set
+----------------------------------------------------------------------------------------*/
+size_t
+cef_chunk_set_mem_size (
+	const CefT_Chunk_Set* set				/* chunk set								*/
+);
+
+#endif // __CEF_CHUNK_SET_HEADER__
@@ -52,6 +52,7 @@
 
 #include <cefore/cef_define.h>
 #include <cefore/cef_frame.h>
+#include <cefore/cef_shmring.h>
 
 /****************************************************************************************
  Macros
@@ -87,6 +88,7 @@ typedef struct {
 	int 	sock;							/* File descriptor 							*/
 	struct addrinfo* ai;					/* addrinfo of this connection 				*/
 	uint32_t seqnum;
+	CefT_Shmring_Pair* shm;					/* shared memory rings to cefnetd 			*/
 } CefT_Connect;
 
 /****************************************************************************************
@@ -79,6 +79,16 @@
 #define CefC_CnpbMax_Pending_Timer			65535	/* Max value of the pending_timer	*/
 #define CefC_CnpbDefault_Block_Size			1024	/* Specify the maximum payload 		*/
 													/* length (bytes) of Content Object	*/
+#define CefC_CnpbDefault_Publish_Workers	4		/* Threads which build and sign		*/
+													/* Content Objects in parallel		*/
+#define CefC_CnpbMax_Publish_Workers		64		/* Max value of the publish workers	*/
+#define CefC_Cnpb_Eager_Publish_Mode		"eager"	/* Cobs are built when the content	*/
+													/* is loaded						*/
+#define CefC_Cnpb_Lazy_Publish_Mode			"lazy"	/* Cobs are built when Interests	*/
+													/* arrive							*/
+#define CefC_CnpbDefault_Lazy_Cache_Cobs	65536	/* Cobs kept by the lazy publishing	*/
+#define CefC_CnpbMax_Lazy_Cache_Cobs		16777216
+													/* Max value of the lazy cache Cobs	*/
 #define CefC_CnpbDefault_Node_Path			"127.0.0.1"
 #define CefC_CnpbDefault_Cefnetd_Port		CefC_Default_PortNum
 
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * cef_cs_shm.h
+ */
+
+#ifndef __CEF_CS_SHM_HEADER__
+#define __CEF_CS_SHM_HEADER__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#ifdef __linux__
+#define CefC_Cs_Shm_Enable
+#endif // __linux__
+
+#define CefC_Cs_Shm_Magic			0x4d485343		/* "CSHM" 							*/
+#define CefC_Cs_Shm_Name			"/cefore_cs_%u"	/* %u is the port number of csmgrd 	*/
+#define CefC_Cs_Shm_Name_Len		64
+
+/********** Size of the shared region (bytes) 			**********/
+#define CefC_Cs_Shm_Size_Def		0				/* Disabled 						*/
+#define CefC_Cs_Shm_Size_Min		(1024 * 1024)
+#define CefC_Cs_Shm_Size_Max		(4096LLU * 1024 * 1024)
+
+/********** Size of each slot (bytes) 					**********/
+#define CefC_Cs_Shm_Slot_Size_Def	2048
+#define CefC_Cs_Shm_Slot_Size_Min	512
+#define CefC_Cs_Shm_Slot_Size_Max	65536
+
+#define CefC_Cs_Shm_Retry_Interval	1000000			/* Interval to re-attach (us) 		*/
+#define CefC_Cs_Shm_Check_Interval	1000000			/* Interval to check csmgrd (us) 	*/
+
+/****************************************************************************************
+ Structure Declarations
+ ****************************************************************************************/
+
+/********** Header placed at the top of the shared region 	**********/
+typedef struct {
+
+	uint32_t 	magic;
+	uint32_t 	alive;					/* cleared when csmgrd closes the region 		*/
+	uint32_t 	slot_num;				/* number of slots (power of 2) 				*/
+	uint32_t 	slot_size;				/* bytes of a slot including its header 		*/
+	uint32_t 	pid;					/* process ID of csmgrd 						*/
+	uint8_t 	pad[44];
+
+} CefT_Cs_Shm_Hdr;
+
+/********** Header of one slot, the key and the Cob follow 	**********/
+typedef struct {
+
+	uint32_t 	seq;					/* odd while csmgrd is writing the slot 		*/
+	uint16_t 	key_len;				/* 0 if the slot is empty 						*/
+	uint16_t 	msg_len;
+	uint64_t 	cache_time;
+	uint64_t 	expiry;
+
+} CefT_Cs_Shm_Slot;
+
+/********** Process local view of the shared region 		**********/
+typedef struct {
+
+	void* 				map;
+	size_t 				map_len;
+	CefT_Cs_Shm_Hdr* 	hdr;
+	unsigned char* 		slots;
+	uint32_t 			mask;
+	uint32_t 			slot_size;
+	int 				owner_f;		/* 1: csmgrd (writer), 0: cefnetd (reader) 		*/
+	char 				name[CefC_Cs_Shm_Name_Len];
+	uint64_t 			ino;			/* inode of the region which is attached 		*/
+	uint64_t 			check_time;		/* time to check csmgrd again (us) 				*/
+
+} CefT_Cs_Shm;
+
+/****************************************************************************************
+ Global Variables
+ ****************************************************************************************/
+
+
+
+/****************************************************************************************
+ Function Declarations
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the shared region (csmgrd side)
+----------------------------------------------------------------------------------------*/
+CefT_Cs_Shm* 								/* Returns NULL if it fails 				*/
+cef_cs_shm_create (
+	uint16_t port_num,						/* port number of csmgrd 					*/
+	uint64_t size,							/* size of the region 						*/
+	uint32_t slot_size						/* size of each slot 						*/
+);
+/*--------------------------------------------------------------------------------------
+	Attaches the shared region created by csmgrd (cefnetd side)
+----------------------------------------------------------------------------------------*/
+CefT_Cs_Shm* 								/* Returns NULL if it fails 				*/
+cef_cs_shm_attach (
+	uint16_t port_num						/* port number of csmgrd 					*/
+);
+/*--------------------------------------------------------------------------------------
+	Detaches the shared region (csmgrd also removes it)
+----------------------------------------------------------------------------------------*/
+void
+cef_cs_shm_destroy (
+	CefT_Cs_Shm* shm
+);
+/*--------------------------------------------------------------------------------------
+	Checks whether csmgrd still publishes to the region. The region is dead if
+	csmgrd closed it, exited without closing it or a new csmgrd replaced it.
+----------------------------------------------------------------------------------------*/
+int											/* 1 if the region is alive 				*/
+cef_cs_shm_is_alive (
+	CefT_Cs_Shm* shm,
+	uint64_t nowt							/* present time (us) 						*/
+);
+/*--------------------------------------------------------------------------------------
+	Publishes the Cob to the slot of the key (csmgrd side)
+----------------------------------------------------------------------------------------*/
+int											/* Returns a negative value if it is not 	*/
+											/* published 								*/
+cef_cs_shm_publish (
+	CefT_Cs_Shm* shm,
+	const unsigned char* key,				/* name including the chunk number 			*/
+	uint16_t key_len,
+	const unsigned char* msg,				/* Cob 										*/
+	uint16_t msg_len,
+	uint64_t cache_time,
+	uint64_t expiry							/* 0 means no expiry 						*/
+);
+/*--------------------------------------------------------------------------------------
+	Removes the Cob of the key from the region (csmgrd side)
+----------------------------------------------------------------------------------------*/
+void
+cef_cs_shm_invalidate (
+	CefT_Cs_Shm* shm,
+	const unsigned char* key,
+	uint16_t key_len
+);
+/*--------------------------------------------------------------------------------------
+	Looks up the Cob of the key and copies it to the buffer (cefnetd side)
+----------------------------------------------------------------------------------------*/
+int											/* length of the Cob, negative if it misses */
+cef_cs_shm_lookup (
+	CefT_Cs_Shm* shm,
+	const unsigned char* key,
+	uint16_t key_len,
+	uint64_t nowt,							/* present time (us) 						*/
+	unsigned char* buff,
+	int buff_len
+);
+
+#endif // __CEF_CS_SHM_HEADER__
@@ -45,6 +45,7 @@
 #include <cefore/cef_hash.h>
 #include <cefore/cef_pit.h>
 #include <cefore/cef_rcvbuf.h>
+#include <cefore/cef_cs_shm.h>
 
 /****************************************************************************************
  Macros
@@ -123,7 +124,9 @@
 #define CefC_Csmgr_Msg_Type_PreCcninfo	0x14		/* Type Prepare Ccninfo message		*/
 #define CefC_Csmgr_Msg_Type_ContInfo	0x15		/* Type Get Contents Information	*/
 #define CefC_Csmgr_Msg_Type_SockID		0x16		/* Type Sending Socket Identifier	*/
-#define CefC_Csmgr_Msg_Type_Num			0x17
+#define CefC_Csmgr_Msg_Type_BulkInterest	0x17	/* Type Interest (Bulk)				*/
+#define CefC_Csmgr_Msg_Type_Bulk_Increment	0x18	/* Type Increment Access Count (Bulk)	*/
+#define CefC_Csmgr_Msg_Type_Num			0x19
 //#define CefC_Csmgr_Msg_Type_Num			0x15
 
 #define CefC_Csmgr_Cob_Exist			0x00		/* Type Content is exist			*/
@@ -146,6 +149,31 @@
 #define CefC_Csmgr_Interest_ChunkNum_NotExist	0	/* Chunk Num Flag off				*/
 #define CefC_Csmgr_Interest_ChunkNum_Exist		1	/* Chunk Num Flag on				*/
 
+/*------------------------------------------------------------------*/
+/* CefC_Csmgr_Msg_Type_BulkInterest									*/
+/*------------------------------------------------------------------*/
+/* The Bulk Interest carries the number of Interests followed by the 	*/
+/* (length, body of the Interest message) pairs. csmgrd replies with 	*/
+/* the found Cobs followed by a Bulk_Cob message which carries the 		*/
+/* number of Interests and the bitmap of the Interests whose Cob does 	*/
+/* not exist (bit i of byte i/8 is set for the i-th Interest). 			*/
+#define CefC_Csmgr_Bulk_Interest_Max	64			/* Max number of Interests			*/
+#define CefC_Csmgr_Bulk_Bitmap_Len		(CefC_Csmgr_Bulk_Interest_Max / 8)
+
+/*------------------------------------------------------------------*/
+/* CefC_Csmgr_Msg_Type_Bulk_Increment								*/
+/*------------------------------------------------------------------*/
+/* The Bulk Increment carries the number of records followed by the 	*/
+/* records of (length of name, name without the chunk number, first 	*/
+/* chunk number, last chunk number, number of hits). Every chunk in the */
+/* range was hit at least once. cefnetd sends it when the hits reach 	*/
+/* CefC_Csmgr_Bulk_Increment_Hits or the first hit has waited for 		*/
+/* CefC_Csmgr_Bulk_Increment_Wait, so the total number of hits in a 	*/
+/* message does not exceed CefC_Csmgr_Bulk_Increment_Hits. 				*/
+#define CefC_Csmgr_Bulk_Increment_Max	64			/* Max number of records			*/
+#define CefC_Csmgr_Bulk_Increment_Hits	256			/* Hits which send the records		*/
+#define CefC_Csmgr_Bulk_Increment_Wait	5000		/* Max wait of a hit (us)			*/
+
 /*------------------------------------------------------------------*/
 /* Macros for get csmgr status										*/
 /*------------------------------------------------------------------*/
@@ -242,12 +270,19 @@ typedef struct {
 
 	/********** local Cache Information ***********/
 	uint32_t		local_cache_capacity;			/* Cache Capacity					*/
+	uint64_t		local_cache_capacity_bytes;		/* Cache Capacity in bytes			*/
+													/* (0 means unlimited)				*/
+	int 			local_cache_admission;			/* Admission policy					*/
 	uint32_t		local_cache_interval;			/* Expired check cycle (sec)		*/
 	int 			pipe_fd[2];						/* socket of cefnetd->Local cache	*/
 													/*  0: for cefnetd					*/
 													/*  1: for Local cache				*/
 	int				to_csmgrd_pipe_fd[2];
 
+	/********** Region shared with the local csmgrd ***********/
+	CefT_Cs_Shm* 	shm;							/* NULL if it is not attached		*/
+	uint64_t 		shm_retry_time;					/* Time to try attaching again		*/
+	unsigned char* 	shm_cob;						/* Cob copied from the region		*/
 
 } CefT_Cs_Stat;
 
@@ -300,6 +335,8 @@ struct CefT_Csmgr_Status_Hdr {
 
 	uint16_t 		node_num;
 	uint32_t 		con_num;
+	uint64_t 		cached_bytes;
+	uint64_t 		capacity_bytes;
 
 } __attribute__((__packed__));
 
@@ -428,6 +465,32 @@ cef_csmgr_excache_lookup (
 	CefT_CcnMsg_OptHdr* poh,				/* Parsed Option Header						*/
 	CefT_Pit_Entry* pe						/* PIT entry								*/
 );
+/*--------------------------------------------------------------------------------------
+	Sends the Interests which are waiting in the bulk lookup buffer
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_excache_lookup_push (
+	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
+);
+/*--------------------------------------------------------------------------------------
+	Sends the access counts which are waiting in the bulk increment buffer
+	if they have waited for CefC_Csmgr_Bulk_Increment_Wait
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_excache_access_push (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	uint64_t nowt							/* present time (us)						*/
+);
+/*--------------------------------------------------------------------------------------
+	Parses the Bulk_Cob message which replies to the Bulk Interest
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if an error occurs	*/
+cef_csmgr_bulk_cob_parse (
+	unsigned char* msg,						/* Bulk_Cob message (without the header)	*/
+	int msg_len,							/* length of the message					*/
+	uint16_t* num,							/* number of the Interests					*/
+	unsigned char** bitmap					/* bitmap of the Interests which missed		*/
+);
 /*--------------------------------------------------------------------------------------
 	Get frame from received message
 ----------------------------------------------------------------------------------------*/
@@ -52,6 +52,8 @@
 #include <cefore/cef_define.h>
 #include <cefore/cef_ccninfo.h>
 #include <cefore/cef_log.h>
+#include <cefore/cef_expiry_heap.h>
+#include <cefore/cef_chunk_set.h>
 
 /****************************************************************************************
  Macros
@@ -62,6 +64,7 @@
 #define CsmgrC_Invalid	 				0
 
 #define CsmgrT_Add_Maps					1000
+#define CsmgrT_Tier_Max					4		/* tables which mirror to a table	*/
 
 #define	CsmgrT_MAP_BASE					(64 * CsmgrT_Add_Maps)
 #define CsmgrT_NODE_MAX					100
@@ -102,8 +105,7 @@ typedef struct CsmgrT_Stat {
 	uint64_t 			access;
 	uint64_t 			req_count;		//0.8.3c
 
-	uint64_t 			*cob_map;
-	uint32_t			map_max;
+	CefT_Chunk_Set		cob_set;		/* chunks cached						*/
 
 	uint32_t			map_num;		//0.8.3c
 
@@ -136,16 +138,31 @@ typedef struct CsmgrT_Stat {
 	uint16_t			ssl_public_key_len;
 	uint16_t			validation_result;
 
+	/* Position in the expiry heap */
+	uint32_t			expiry_pos;
+
 	struct CsmgrT_Stat*	next;
 } CsmgrT_Stat;
 //0.8.3c S
-typedef struct {
+typedef struct CsmgrT_Stat_Table {
 
 	uint64_t 			capacity;
 	uint32_t			cached_con_num;
 	uint64_t			cached_cob_num;
+	uint64_t			capacity_bytes;		/* byte budget of cache (0:unlimited)	*/
+	uint64_t			cached_bytes;		/* total size of cached Cobs			*/
 	CsmgrT_Stat** 		rcds;
+	unsigned char*		index_mngr;			/* used flags of the record indexes, 	*/
+											/* guarded by stat_mutex of this table	*/
 	pthread_mutex_t 	stat_mutex;
+	CefT_Expiry_Heap*	expiry_heap;		/* records ordered by the expiry time	*/
+	uint64_t			expiry_scan_t;		/* time when the expiry scan starts		*/
+
+	/* A tier table mirrors the changes of the cached Cobs to the parent table, 	*/
+	/* the parent table has the union of the Cobs cached in its tiers 				*/
+	struct CsmgrT_Stat_Table*	parent;		/* NULL if this is not a tier			*/
+	struct CsmgrT_Stat_Table*	tiers[CsmgrT_Tier_Max];
+	int					tier_num;
 
 } CsmgrT_Stat_Table;
 //0.8.3c E
@@ -182,6 +199,13 @@ CsmgrT_Stat_Handle
 csmgr_stat_handle_create (
 	void
 );
+/*--------------------------------------------------------------------------------------
+	Creates the Csmgr Stat Handle of a tier which mirrors to the specified handle
+----------------------------------------------------------------------------------------*/
+CsmgrT_Stat_Handle
+csmgr_stat_tier_handle_create (
+	CsmgrT_Stat_Handle parent_hdl
+);
 /*--------------------------------------------------------------------------------------
 	Destroy the Csmgr Stat Handle
 ----------------------------------------------------------------------------------------*/
@@ -283,6 +307,28 @@ csmgr_stat_cob_remove (
 	uint32_t seq,
 	uint32_t cob_size
 );
+/*--------------------------------------------------------------------------------------
+	Checks whether the specified Cob is cached
+----------------------------------------------------------------------------------------*/
+int 								/* Returns 1 if the Cob is cached					*/
+csmgr_stat_cob_is_cached (
+	CsmgrT_Stat_Handle hdl,
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t seq
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the first range of the contiguous cached Cobs from the specified Cob
+----------------------------------------------------------------------------------------*/
+int 								/* Returns 1 if the range is found					*/
+csmgr_stat_cob_range_get (
+	CsmgrT_Stat_Handle hdl,
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t from,
+	uint32_t* first,
+	uint32_t* last
+);
 /*--------------------------------------------------------------------------------------
 	Update access count
 ----------------------------------------------------------------------------------------*/
@@ -292,6 +338,16 @@ csmgr_stat_access_count_update (
 	const unsigned char* name,
 	uint16_t name_len
 );
+/*--------------------------------------------------------------------------------------
+	Adds the number of hits to access count
+----------------------------------------------------------------------------------------*/
+void
+csmgr_stat_access_count_add (
+	CsmgrT_Stat_Handle hdl,
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t count
+);
 /*--------------------------------------------------------------------------------------
 	Update request count
 ----------------------------------------------------------------------------------------*/
@@ -311,6 +367,17 @@ csmgr_stat_content_info_init (
 	uint16_t name_len,
 	CsmgrT_DB_COB_MAP**	cob_map
 );
+/*--------------------------------------------------------------------------------------
+	Init the valiables of the specified content with the index which was used
+	before the restart. Returns NULL if the index is already used.
+----------------------------------------------------------------------------------------*/
+CsmgrT_Stat*
+csmgr_stat_content_info_restore (
+	CsmgrT_Stat_Handle hdl,
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t index
+);
 /*--------------------------------------------------------------------------------------
 	Init the valiables of the specified content (for version)
 ----------------------------------------------------------------------------------------*/
@@ -338,6 +405,30 @@ csmgr_stat_cache_capacity_update (
 	CsmgrT_Stat_Handle hdl,
 	uint64_t capacity
 );
+/*--------------------------------------------------------------------------------------
+	Sets cache capacity without clearing the cached records
+----------------------------------------------------------------------------------------*/
+void
+csmgr_stat_cache_capacity_set (
+	CsmgrT_Stat_Handle hdl,
+	uint64_t capacity
+);
+/*--------------------------------------------------------------------------------------
+	Update cache capacity in bytes
+----------------------------------------------------------------------------------------*/
+void
+csmgr_stat_cache_capacity_bytes_update (
+	CsmgrT_Stat_Handle hdl,
+	uint64_t capacity_bytes
+);
+/*--------------------------------------------------------------------------------------
+	Update the total size of cached Cobs
+----------------------------------------------------------------------------------------*/
+void
+csmgr_stat_cached_bytes_update (
+	CsmgrT_Stat_Handle hdl,
+	uint64_t cached_bytes
+);
 /*--------------------------------------------------------------------------------------
 	Update content expire time
 ----------------------------------------------------------------------------------------*/
@@ -369,6 +460,20 @@ uint64_t
 csmgr_stat_cache_capacity_get (
 	CsmgrT_Stat_Handle hdl
 );
+/*--------------------------------------------------------------------------------------
+	Obtains the Cache capacity in bytes
+----------------------------------------------------------------------------------------*/
+uint64_t
+csmgr_stat_cache_capacity_bytes_get (
+	CsmgrT_Stat_Handle hdl
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the total size of cached Cobs
+----------------------------------------------------------------------------------------*/
+uint64_t
+csmgr_stat_cached_bytes_get (
+	CsmgrT_Stat_Handle hdl
+);
 /*--------------------------------------------------------------------------------------
 	Verification for UCINC
 ----------------------------------------------------------------------------------------*/
@@ -502,6 +607,8 @@ csmgr_stat_cob_remove_for_pub (
 		 csmgr_stat_handle_create()
 #define csmgrd_stat_handle_destroy(hdl) \
 		 csmgr_stat_handle_destroy(hdl)
+#define csmgrd_stat_tier_handle_create(parent_hdl) \
+		 csmgr_stat_tier_handle_create(parent_hdl)
 #define csmgrd_stat_content_info_access(hdl, name, name_len) \
 		 csmgr_stat_content_info_access(hdl, name, name_len, CsmgrT_IM_CSMGRD)
 #define csmgrd_stat_content_info_is_exist(hdl, name, name_len, cob_map) \
@@ -516,12 +623,20 @@ csmgr_stat_cob_remove_for_pub (
 		 csmgr_stat_cob_update(hdl, name, name_len, seq, cob_size, expiry, cached_time, node)
 #define csmgrd_stat_cob_remove(hdl, name, name_len, seq, cob_size) \
 		 csmgr_stat_cob_remove(hdl, name, name_len, seq, cob_size)
+#define csmgrd_stat_cob_is_cached(hdl, name, name_len, seq) \
+		 csmgr_stat_cob_is_cached(hdl, name, name_len, seq)
+#define csmgrd_stat_cob_range_get(hdl, name, name_len, from, first, last) \
+		 csmgr_stat_cob_range_get(hdl, name, name_len, from, first, last)
 #define csmgrd_stat_access_count_update(hdl, name, name_len) \
 		 csmgr_stat_access_count_update(hdl, name, name_len)
+#define csmgrd_stat_access_count_add(hdl, name, name_len, count) \
+		 csmgr_stat_access_count_add(hdl, name, name_len, count)
 #define csmgrd_stat_request_count_update(hdl, name, name_len) \
 		 csmgr_stat_request_count_update(hdl, name, name_len)
 #define csmgrd_stat_content_info_init(hdl, name, name_len, cob_map) \
 		 csmgr_stat_content_info_init(hdl, name, name_len, cob_map)
+#define csmgrd_stat_content_info_restore(hdl, name, name_len, index) \
+		 csmgr_stat_content_info_restore(hdl, name, name_len, index)
 #define csmgrd_stat_content_info_version_init(hdl, rcd, version, ver_len) \
 		 csmgr_stat_content_info_version_init(hdl, rcd, version, ver_len)
 #define csmgrd_stat_content_info_delete(hdl, name, name_len) \
@@ -536,6 +651,16 @@ csmgr_stat_cob_remove_for_pub (
 		 csmgr_stat_cached_cob_num_get(hdl)
 #define csmgrd_stat_cache_capacity_get(hdl) \
 		 csmgr_stat_cache_capacity_get(hdl)
+#define csmgrd_stat_cache_capacity_set(hdl, capacity) \
+		 csmgr_stat_cache_capacity_set(hdl, capacity)
+#define csmgrd_stat_cache_capacity_bytes_update(hdl, capacity_bytes) \
+		 csmgr_stat_cache_capacity_bytes_update(hdl, capacity_bytes)
+#define csmgrd_stat_cached_bytes_update(hdl, cached_bytes) \
+		 csmgr_stat_cached_bytes_update(hdl, cached_bytes)
+#define csmgrd_stat_cache_capacity_bytes_get(hdl) \
+		 csmgr_stat_cache_capacity_bytes_get(hdl)
+#define csmgrd_stat_cached_bytes_get(hdl) \
+		 csmgr_stat_cached_bytes_get(hdl)
 //0.8.3c
 #define	 csmgrd_stat_content_info_gets_for_RM(hdl, name, name_len, ret) \
 		 csmgr_stat_content_info_gets_for_RM(hdl, name, name_len, ret)
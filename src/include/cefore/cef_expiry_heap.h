@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * cef_expiry_heap.h
+ */
+
+#ifndef __CEF_EXPIRY_HEAP_HEADER__
+#define __CEF_EXPIRY_HEAP_HEADER__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#include <stdint.h>
+#include <stdlib.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define CefC_Expiry_Heap_Init_Size		1024	/* initial number of the slots			*/
+#define CefC_Expiry_Heap_Never			UINT64_MAX	/* key of the item never expires	*/
+
+/****************************************************************************************
+ Structure Declarations
+ ****************************************************************************************/
+
+typedef struct {
+
+	uint64_t 	key;				/* time when the item expires (usec)				*/
+	void* 		item;				/* item which has the key							*/
+	uint32_t* 	pos;				/* position of the item (kept in the item)			*/
+
+} CefT_Expiry_Heap_Elem;
+
+/********** Min-heap ordered by the expiry time 	**********/
+/* The items keep their own position (1 origin, 0 if not in the heap) so that the	*/
+/* key can be updated and the item can be removed in O(log n) without search. The	*/
+/* caller is responsible for the lock.												*/
+typedef struct {
+
+	CefT_Expiry_Heap_Elem* 	elems;	/* binary heap 										*/
+	uint32_t 				num;	/* number of the items 								*/
+	uint32_t 				max;	/* number of the slots 								*/
+
+} CefT_Expiry_Heap;
+
+/****************************************************************************************
+ Function Declarations
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the expiry heap
+----------------------------------------------------------------------------------------*/
+CefT_Expiry_Heap* 							/* Created heap, NULL if an error occurs	*/
+cef_expiry_heap_create (
+	void
+);
+/*--------------------------------------------------------------------------------------
+	Destroys the expiry heap (the items are not freed)
+----------------------------------------------------------------------------------------*/
+void
+cef_expiry_heap_destroy (
+	CefT_Expiry_Heap* hp					/* expiry heap								*/
+);
+/*--------------------------------------------------------------------------------------
+	Inserts the item, or updates the key of the item already in the heap. The item
+	is removed if the key is CefC_Expiry_Heap_Never.
+----------------------------------------------------------------------------------------*/
+int 										/* negative if the heap cannot be extended	*/
+cef_expiry_heap_set (
+	CefT_Expiry_Heap* hp,					/* expiry heap								*/
+	void* item,								/* item										*/
+	uint32_t* pos,							/* position of the item kept in the item	*/
+	uint64_t key							/* time when the item expires				*/
+);
+/*--------------------------------------------------------------------------------------
+	Removes the item from the heap
+----------------------------------------------------------------------------------------*/
+void
+cef_expiry_heap_remove (
+	CefT_Expiry_Heap* hp,					/* expiry heap								*/
+	uint32_t* pos							/* position of the item kept in the item	*/
+);
+/*--------------------------------------------------------------------------------------
+	Returns the item which expires first if it expires before the specified time
+----------------------------------------------------------------------------------------*/
+void* 										/* item, NULL if no item has expired		*/
+cef_expiry_heap_expired_peek (
+	CefT_Expiry_Heap* hp,					/* expiry heap								*/
+	uint64_t nowt							/* current time								*/
+);
+/*--------------------------------------------------------------------------------------
+	Removes all items from the heap
+----------------------------------------------------------------------------------------*/
+void
+cef_expiry_heap_clear (
+	CefT_Expiry_Heap* hp					/* expiry heap								*/
+);
+
+#endif // __CEF_EXPIRY_HEAP_HEADER__
@@ -55,6 +55,7 @@
 #include <cefore/cef_define.h>
 #include <cefore/cef_frame.h>
 #include <cefore/cef_rcvbuf.h>
+#include <cefore/cef_shmring.h>
 
 /****************************************************************************************
  Macros
@@ -101,6 +102,8 @@ typedef struct {
 #endif // __APPLE__
 	int				bw_stat_i;
 	long			tv_sec;
+	CefT_Shmring_Pair*	shm;				/* shared memory rings (local face only) 	*/
+	uint32_t		gen;					/* changed when the entry is initialized 	*/
 } CefT_Face;
 
 /********** Neighbor Management				**********/
@@ -209,6 +212,14 @@ int										/* Returns the value less than 1 if it fails 	*/
 cef_face_check_close (
 	int faceid								/* Face-ID									*/
 );
+/*--------------------------------------------------------------------------------------
+	Obtains the generation of the specified Face, which changes when the Face-ID
+	is closed or assigned again
+----------------------------------------------------------------------------------------*/
+uint32_t
+cef_face_generation_get (
+	int faceid								/* Face-ID									*/
+);
 /*--------------------------------------------------------------------------------------
 	Obtains the Face structure from the specified Face-ID
 ----------------------------------------------------------------------------------------*/
@@ -432,5 +443,20 @@ long
 cef_face_get_reftime (
 	int	faceid
 );
+/*--------------------------------------------------------------------------------------
+	Sets the shared memory rings to the specified local Face
+----------------------------------------------------------------------------------------*/
+int											/* Returns a negative value if it fails 	*/
+cef_face_local_shmring_set (
+	uint16_t faceid,						/* Face-ID									*/
+	CefT_Shmring_Pair* pair					/* rings attached by cefnetd 				*/
+);
+/*--------------------------------------------------------------------------------------
+	Obtains the shared memory rings of the specified local Face
+----------------------------------------------------------------------------------------*/
+CefT_Shmring_Pair* 							/* NULL if the Face uses the socket only 	*/
+cef_face_local_shmring_get (
+	uint16_t faceid							/* Face-ID									*/
+);
 
 #endif // __CEF_FACE_HEADER__
@@ -73,6 +73,10 @@
 #define Cef_NewestVersion_1stArg			1
 #define Cef_NewestVersion_2ndArg			-1
 
+/***** Admission policy of the local cache *****/
+#define CefMemCacheC_Admission_None			0	/* every Cob is cached 					*/
+#define CefMemCacheC_Admission_TinyLFU		1	/* TinyLFU (frequency sketch) filter 	*/
+
 /****************************************************************************************
  Structure Declarations
  ****************************************************************************************/
@@ -132,7 +136,9 @@ typedef struct {
 ----------------------------------------------------------------------------------------*/
 int
 cef_mem_cache_init(
-		uint32_t		capacity
+		uint32_t		capacity,				/* maximum number of cached Cobs 		*/
+		uint64_t		capacity_bytes,			/* byte budget (0 means unlimited) 		*/
+		int 			admission				/* admission policy 					*/
 );
 /*--------------------------------------------------------------------------------------
 	A thread that puts a content object in the local cache
@@ -177,6 +183,15 @@ void
 cef_mem_cache_destroy (
 	void
 );
+/*--------------------------------------------------------------------------------------
+	Obtains the number and the total size of the cached Cobs
+----------------------------------------------------------------------------------------*/
+void
+cef_mem_cache_usage_get (
+	uint64_t* cobs,								/* number of cached Cobs 				*/
+	uint64_t* bytes,							/* total of msg_len of cached Cobs 		*/
+	uint64_t* capacity_bytes					/* byte budget (0 means unlimited) 		*/
+);
 /*--------------------------------------------------------------------------------------
 	Function to increment access count
 ----------------------------------------------------------------------------------------*/
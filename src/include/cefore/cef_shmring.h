@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * cef_shmring.h
+ */
+
+#ifndef __CEF_SHMRING_HEADER__
+#define __CEF_SHMRING_HEADER__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#ifdef __linux__
+#define CefC_Shmring_Enable
+#endif // __linux__
+
+#define CefC_Shmring_Magic			0x52484d53		/* "SMHR" 							*/
+
+/********** Size of each ring (bytes, one direction) 	**********/
+#define CefC_Shmring_Size_Min		(256 * 1024)
+#define CefC_Shmring_Size_Def		CefC_Shmring_Size_Min	/* every client creates two 	*/
+#define CefC_Shmring_Size_Max		(256 * 1024 * 1024)
+
+/********** Negotiation on the local socket 			**********/
+#define CefC_Shmring_Open			"/SHMRING:Face"
+#define CefC_Shmring_Accept			"/SHMRING:OK"
+#define CefC_Shmring_Reject			"/SHMRING:NG"
+#define CefC_Shmring_Reply_Len		11
+#define CefC_Shmring_Nego_Timeout	100				/* Wait for the reply (ms) 			*/
+#define CefC_Shmring_Fd_Num			3				/* memfd, doorbell x2 				*/
+
+/****************************************************************************************
+ Structure Declarations
+ ****************************************************************************************/
+
+/********** Header of one ring placed in shared memory 	**********/
+typedef struct {
+
+	uint32_t 	magic;
+	uint32_t 	size;					/* capacity of the data area (power of 2) 		*/
+	uint64_t 	head 					/* written only by the producer 				*/
+				__attribute__ ((aligned (64)));
+	uint64_t 	tail 					/* written only by the consumer 				*/
+				__attribute__ ((aligned (64)));
+	uint8_t 	pad[56];
+
+} CefT_Shmring_Hdr;
+
+/********** Process local view of one ring 				**********/
+typedef struct {
+
+	CefT_Shmring_Hdr* 	hdr;
+	unsigned char* 		data;
+	uint32_t 			mask;
+	uint64_t 			pos;			/* index owned by this end (head of tx, tail 	*/
+										/* of rx), the copy in the shared memory can 	*/
+										/* be overwritten by the peer 					*/
+	int 				efd;			/* doorbell (eventfd) 							*/
+	pthread_mutex_t 	mutex;			/* serializes the local users of this end 		*/
+
+} CefT_Shmring;
+
+/********** Pair of rings shared by an application and cefnetd 	**********/
+typedef struct {
+
+	void* 			map;
+	size_t 			map_len;
+	int 			fds[CefC_Shmring_Fd_Num];	/* memfd, app->cefnetd, cefnetd->app 	*/
+	CefT_Shmring 	tx;							/* the ring which this side writes 		*/
+	CefT_Shmring 	rx;							/* the ring which this side reads 		*/
+	uint64_t 		tx_drop;					/* frames dropped on the full tx ring 	*/
+
+} CefT_Shmring_Pair;
+
+/****************************************************************************************
+ Global Variables
+ ****************************************************************************************/
+
+
+
+/****************************************************************************************
+ Function Declarations
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the pair of rings (application side)
+----------------------------------------------------------------------------------------*/
+CefT_Shmring_Pair* 							/* Returns NULL if it fails 				*/
+cef_shmring_pair_create (
+	uint32_t size							/* size of each ring 						*/
+);
+/*--------------------------------------------------------------------------------------
+	Attaches the pair of rings created by the peer (cefnetd side)
+----------------------------------------------------------------------------------------*/
+CefT_Shmring_Pair* 							/* Returns NULL if it fails 				*/
+cef_shmring_pair_attach (
+	int fds[]								/* memfd, app->cefnetd, cefnetd->app 		*/
+);
+/*--------------------------------------------------------------------------------------
+	Destroys the pair of rings
+----------------------------------------------------------------------------------------*/
+void
+cef_shmring_pair_destroy (
+	CefT_Shmring_Pair* pair
+);
+/*--------------------------------------------------------------------------------------
+	Writes one frame into the ring
+----------------------------------------------------------------------------------------*/
+int											/* length of the written frame, 0 if full, 	*/
+											/* a negative value if the ring is broken 	*/
+cef_shmring_write (
+	CefT_Shmring* ring,
+	const unsigned char* msg,
+	int len
+);
+/*--------------------------------------------------------------------------------------
+	Reads the data from the ring as a byte stream
+----------------------------------------------------------------------------------------*/
+int											/* length of the read frames, a negative 	*/
+											/* value if the ring is broken 				*/
+cef_shmring_read (
+	CefT_Shmring* ring,
+	unsigned char* buff,
+	int len
+);
+/*--------------------------------------------------------------------------------------
+	Checks whether the ring has frames to read
+----------------------------------------------------------------------------------------*/
+int											/* 1 if the ring is empty 					*/
+cef_shmring_is_empty (
+	CefT_Shmring* ring
+);
+/*--------------------------------------------------------------------------------------
+	Sends the message with the file descriptors over the UNIX domain socket
+----------------------------------------------------------------------------------------*/
+int											/* Returns a negative value if it fails 	*/
+cef_shmring_fds_send (
+	int sock,
+	const char* msg,
+	int fds[],
+	int fd_num
+);
+/*--------------------------------------------------------------------------------------
+	Receives the message and file descriptors from the UNIX domain socket
+----------------------------------------------------------------------------------------*/
+int											/* length of the received message 			*/
+cef_shmring_fds_recv (
+	int sock,
+	unsigned char* buff,
+	int len,
+	int fds[],
+	int* fd_num
+);
+
+#endif // __CEF_SHMRING_HEADER__
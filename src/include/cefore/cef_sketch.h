@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * cef_sketch.h
+ */
+
+#ifndef __CEF_SKETCH_HEADER__
+#define __CEF_SKETCH_HEADER__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+#include <stdint.h>
+#include <stdlib.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define CefC_Sketch_Depth			4		/* number of rows of the sketch 			*/
+#define CefC_Sketch_Counter_Max		15		/* saturation value of a counter 			*/
+#define CefC_Sketch_Width_Min		64		/* minimum number of counters in a row 		*/
+#define CefC_Sketch_Width_Max		(1 << 24)
+											/* maximum number of counters in a row 		*/
+#define CefC_Sketch_Sample_Factor	10		/* counters are halved after width * factor */
+											/* increments (aging) 						*/
+
+/****************************************************************************************
+ Structure Declarations
+ ****************************************************************************************/
+
+/********** Count-Min Sketch used as TinyLFU admission filter 	**********/
+typedef struct {
+
+	uint8_t*	table;				/* CefC_Sketch_Depth rows of width counters 		*/
+	uint32_t	width;				/* number of counters in a row (power of 2) 		*/
+	uint32_t	mask;				/* width - 1 										*/
+	uint32_t	additions;			/* number of increments since the last aging 		*/
+	uint32_t	sample_size;		/* the counters are halved at this additions 		*/
+
+} CefT_Sketch;
+
+/****************************************************************************************
+ Global Variables
+ ****************************************************************************************/
+
+
+
+/****************************************************************************************
+ Function Declarations
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the Count-Min Sketch
+----------------------------------------------------------------------------------------*/
+CefT_Sketch* 								/* Created sketch, NULL if an error occurs 	*/
+cef_sketch_create (
+	uint32_t capacity						/* number of entries of the cache 			*/
+);
+/*--------------------------------------------------------------------------------------
+	Destroys the Count-Min Sketch
+----------------------------------------------------------------------------------------*/
+void
+cef_sketch_destroy (
+	CefT_Sketch* sk							/* sketch 									*/
+);
+/*--------------------------------------------------------------------------------------
+	Records an access to the specified key
+----------------------------------------------------------------------------------------*/
+void
+cef_sketch_increment (
+	CefT_Sketch* sk,						/* sketch 									*/
+	const unsigned char* key,				/* key 										*/
+	int key_len								/* length of the key 						*/
+);
+/*--------------------------------------------------------------------------------------
+	Estimates the access frequency of the specified key
+----------------------------------------------------------------------------------------*/
+int 										/* estimated frequency 						*/
+cef_sketch_estimate (
+	CefT_Sketch* sk,						/* sketch 									*/
+	const unsigned char* key,				/* key 										*/
+	int key_len								/* length of the key 						*/
+);
+/*--------------------------------------------------------------------------------------
+	TinyLFU admission: decides whether the candidate replaces the victim
+----------------------------------------------------------------------------------------*/
+int 										/* 1: admit the candidate, 0: keep victim 	*/
+cef_sketch_admit (
+	CefT_Sketch* sk,						/* sketch 									*/
+	const unsigned char* cand_key,			/* key of the candidate to be cached 		*/
+	int cand_len,							/* length of the candidate key 				*/
+	const unsigned char* victim_key,		/* key of the victim to be evicted 			*/
+	int victim_len							/* length of the victim key 				*/
+);
+
+#endif // __CEF_SKETCH_HEADER__
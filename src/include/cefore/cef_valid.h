@@ -38,6 +38,7 @@
  ****************************************************************************************/
 #include <stdlib.h>
 #include <stdio.h>
+#include <sys/types.h>
 
 /****************************************************************************************
  Macros
@@ -46,10 +47,37 @@
 #define	CefC_ValidTypeStr_RSA256 "rsa-sha256"
 // #define CRC32C_POLY 0x1EDC6F41    /* Forward polynomial of CRC. */
 
+/* Digest algorithms of cef_valid_digest */
+#define CefC_Valid_Digest_SHA256	0
+#define CefC_Valid_Digest_SHA384	1
+#define CefC_Valid_Digest_MD5		2
+#define CefC_Valid_Digest_Num		3
+
 /****************************************************************************************
  Structure Declarations
  ****************************************************************************************/
 
+/*--------------------------------------------------------------------------------------
+	Functions which look up and store the RSA-SHA256 signatures.
+	digest is the SHA-256 digest of the signed message.
+----------------------------------------------------------------------------------------*/
+typedef int 						/* 1 if the signature is found 						*/
+(*CefT_Valid_Sign_Lookup) (
+	const unsigned char* name,
+	int name_len,
+	const unsigned char* digest,
+	unsigned char* sign,
+	unsigned int* sign_len
+);
+typedef void
+(*CefT_Valid_Sign_Store) (
+	const unsigned char* name,
+	int name_len,
+	const unsigned char* digest,
+	const unsigned char* sign,
+	unsigned int sign_len
+);
+
 /****************************************************************************************
  Global Variables
  ****************************************************************************************/
@@ -104,12 +132,36 @@ cef_valid_rsa_sha256_dosign (
 	unsigned char* sign,
 	unsigned int* sign_len
 );
+void
+cef_valid_sign_cache_set (
+	CefT_Valid_Sign_Lookup lookup,
+	CefT_Valid_Sign_Store store
+);
+int 								/* 1 if the signature is valid 						*/
+cef_valid_rsa_sha256_sign_verify (
+	const unsigned char* name,
+	int name_len,
+	const unsigned char* digest,		/* SHA-256 digest of the signed message 		*/
+	const unsigned char* sign,
+	unsigned int sign_len
+);
 int 								/* If the return value is 0 the code is equal, 		*/
 									/* otherwise the code is different. 				*/
 cef_valid_msg_verify (
 	const unsigned char* msg,
 	int msg_len
 );
+void
+cef_valid_verify_cache_stat_get (
+	uint64_t* hit,					/* verifications answered by the cache 				*/
+	uint64_t* miss					/* verifications which used the public key 			*/
+);
+uint16_t							/* CefC_T_XXX of the algorithm, or 0 if the message */
+									/* does not have a valid Validation Algorithm TLV 	*/
+cef_valid_msg_alg_get (
+	const unsigned char* msg,
+	int msg_len
+);
 
 int
 cef_valid_keyid_create_forccninfo (
@@ -165,6 +217,31 @@ cef_valid_md5 (
 	unsigned char *md
 );
 
+int									/* length of the digest, or -1 if it fails			*/
+cef_valid_digest (
+	int type,						/* CefC_Valid_Digest_xxx 							*/
+	const unsigned char* d,
+	size_t n,
+	unsigned char* md
+);
+
+int									/* length of each digest, or -1 if it fails			*/
+cef_valid_digest_batch (
+	int type,						/* CefC_Valid_Digest_xxx 							*/
+	int num,						/* number of the buffers 							*/
+	const unsigned char* const* d,
+	const size_t* n,
+	unsigned char* md				/* digests of the buffers in order 					*/
+);
+
+int									/* length of the digest, or -1 if it fails			*/
+cef_valid_digest_fd (
+	int type,						/* CefC_Valid_Digest_xxx 							*/
+	int fd,
+	off_t size,						/* bytes read from the head of the file 			*/
+	unsigned char* md
+);
+
 int
 cef_valid_get_keyid_from_specified_pubkey (
 	const char* key_path,	// path of publickey
@@ -0,0 +1,784 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * cef_chunk_set.c
+ */
+
+#define __CEF_CHUNK_SET_SOURECE__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <string.h>
+
+#include <cefore/cef_chunk_set.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define cef_chunk_set_hi(n)			((uint16_t)((n) >> 16))
+#define cef_chunk_set_lo(n)			((uint16_t)((n) & 0xFFFF))
+#define cef_chunk_set_bit_test(b, x) \
+	(((b)[(x) >> 6] >> ((x) & 63)) & 1)
+
+#define CefC_Chunk_Set_Cont_Init		4		/* initial number of the containers		*/
+#define CefC_Chunk_Set_Run_Init			4		/* initial number of the runs			*/
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+static int
+cef_chunk_set_cont_search (
+	const CefT_Chunk_Set* set,
+	uint16_t key,
+	uint32_t* pos
+);
+static CefT_Chunk_Container*
+cef_chunk_set_cont_insert (
+	CefT_Chunk_Set* set,
+	uint32_t pos,
+	uint16_t key
+);
+static void
+cef_chunk_set_cont_erase (
+	CefT_Chunk_Set* set,
+	uint32_t pos
+);
+static int
+cef_chunk_set_run_search (
+	const CefT_Chunk_Container* cp,
+	uint16_t low
+);
+static int
+cef_chunk_set_run_insert (
+	CefT_Chunk_Container* cp,
+	int i,
+	uint16_t first,
+	uint16_t last
+);
+static void
+cef_chunk_set_run_erase (
+	CefT_Chunk_Container* cp,
+	int i
+);
+static int
+cef_chunk_set_to_bitmap (
+	CefT_Chunk_Container* cp
+);
+static int
+cef_chunk_set_to_run (
+	CefT_Chunk_Container* cp
+);
+static int
+cef_chunk_set_cont_add (
+	CefT_Chunk_Container* cp,
+	uint16_t low
+);
+static int
+cef_chunk_set_cont_remove (
+	CefT_Chunk_Container* cp,
+	uint16_t low
+);
+static int
+cef_chunk_set_cont_contains (
+	const CefT_Chunk_Container* cp,
+	uint16_t low
+);
+static int
+cef_chunk_set_cont_stretch (
+	const CefT_Chunk_Container* cp,
+	uint32_t from,
+	uint16_t* first,
+	uint16_t* last
+);
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Initializes the empty chunk set
+----------------------------------------------------------------------------------------*/
+void
+cef_chunk_set_init (
+	CefT_Chunk_Set* set						/* chunk set								*/
+) {
+	memset (set, 0, sizeof (CefT_Chunk_Set));
+}
+/*--------------------------------------------------------------------------------------
+	Removes all chunks and frees the memory used by the set
+----------------------------------------------------------------------------------------*/
+void
+cef_chunk_set_clear (
+	CefT_Chunk_Set* set						/* chunk set								*/
+) {
+	uint32_t i;
+
+	for (i = 0 ; i < set->num ; i++) {
+		free (set->conts[i].runs);
+		free (set->conts[i].bits);
+	}
+	free (set->conts);
+	memset (set, 0, sizeof (CefT_Chunk_Set));
+}
+/*--------------------------------------------------------------------------------------
+	Adds the chunk to the set
+----------------------------------------------------------------------------------------*/
+int 										/* 1: added, 0: already in the set,			*/
+											/* negative: the set cannot be extended		*/
+cef_chunk_set_add (
+	CefT_Chunk_Set* set,					/* chunk set								*/
+	uint32_t chunk							/* chunk number								*/
+) {
+	CefT_Chunk_Container* cp;
+	uint32_t pos;
+	int res;
+
+	if (cef_chunk_set_cont_search (set, cef_chunk_set_hi (chunk), &pos)) {
+		cp = &set->conts[pos];
+	} else {
+		cp = cef_chunk_set_cont_insert (set, pos, cef_chunk_set_hi (chunk));
+		if (cp == NULL) {
+			return (-1);
+		}
+	}
+	res = cef_chunk_set_cont_add (cp, cef_chunk_set_lo (chunk));
+	if (res > 0) {
+		set->card++;
+	} else if ((res < 0) && (cp->card == 0)) {
+		cef_chunk_set_cont_erase (set, pos);
+	}
+
+	return (res);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the chunk from the set
+----------------------------------------------------------------------------------------*/
+int 										/* 1: removed, 0: not in the set,			*/
+											/* negative: the set cannot be extended		*/
+cef_chunk_set_remove (
+	CefT_Chunk_Set* set,					/* chunk set								*/
+	uint32_t chunk							/* chunk number								*/
+) {
+	CefT_Chunk_Container* cp;
+	uint32_t pos;
+	int res;
+
+	if (!cef_chunk_set_cont_search (set, cef_chunk_set_hi (chunk), &pos)) {
+		return (0);
+	}
+	cp = &set->conts[pos];
+	res = cef_chunk_set_cont_remove (cp, cef_chunk_set_lo (chunk));
+	if (res > 0) {
+		set->card--;
+		if (cp->card == 0) {
+			cef_chunk_set_cont_erase (set, pos);
+		}
+	}
+
+	return (res);
+}
+/*--------------------------------------------------------------------------------------
+	Checks whether the chunk is in the set
+----------------------------------------------------------------------------------------*/
+int 										/* 1 if the chunk is in the set				*/
+cef_chunk_set_contains (
+	const CefT_Chunk_Set* set,				/* chunk set								*/
+	uint32_t chunk							/* chunk number								*/
+) {
+	uint32_t pos;
+
+	if (!cef_chunk_set_cont_search (set, cef_chunk_set_hi (chunk), &pos)) {
+		return (0);
+	}
+	return (cef_chunk_set_cont_contains (&set->conts[pos], cef_chunk_set_lo (chunk)));
+}
+/*--------------------------------------------------------------------------------------
+	Returns the number of the chunks in the set
+----------------------------------------------------------------------------------------*/
+uint64_t
+cef_chunk_set_count (
+	const CefT_Chunk_Set* set				/* chunk set								*/
+) {
+	return (set->card);
+}
+/*--------------------------------------------------------------------------------------
+	Returns the number of the chunks in the set which are smaller than the chunk
+----------------------------------------------------------------------------------------*/
+uint64_t
+cef_chunk_set_rank (
+	const CefT_Chunk_Set* set,				/* chunk set								*/
+	uint32_t chunk							/* chunk number								*/
+) {
+	const CefT_Chunk_Container* cp;
+	uint64_t rank = 0;
+	uint32_t pos, i;
+	uint16_t low;
+
+	if (!cef_chunk_set_cont_search (set, cef_chunk_set_hi (chunk), &pos)) {
+		for (i = 0 ; i < pos ; i++) {
+			rank += set->conts[i].card;
+		}
+		return (rank);
+	}
+	for (i = 0 ; i < pos ; i++) {
+		rank += set->conts[i].card;
+	}
+	cp  = &set->conts[pos];
+	low = cef_chunk_set_lo (chunk);
+
+	if (cp->type == CefC_Chunk_Set_Run) {
+		for (i = 0 ; i < cp->run_num ; i++) {
+			if (cp->runs[i * 2] >= low) {
+				break;
+			}
+			if (cp->runs[i * 2 + 1] < low) {
+				rank += cp->runs[i * 2 + 1] - cp->runs[i * 2] + 1;
+			} else {
+				rank += low - cp->runs[i * 2];
+				break;
+			}
+		}
+	} else {
+		for (i = 0 ; i < (uint32_t)(low >> 6) ; i++) {
+			rank += __builtin_popcountll (cp->bits[i]);
+		}
+		if (low & 63) {
+			rank += __builtin_popcountll (
+						cp->bits[low >> 6] & ((1llu << (low & 63)) - 1));
+		}
+	}
+
+	return (rank);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the first range of the contiguous chunks which has the chunk not smaller
+	than the specified chunk. The range is clipped at the specified chunk.
+----------------------------------------------------------------------------------------*/
+int 										/* 1 if the range is found					*/
+cef_chunk_set_range_next (
+	const CefT_Chunk_Set* set,				/* chunk set								*/
+	uint32_t from,							/* chunk number to start the search			*/
+	uint32_t* first,						/* first chunk of the range					*/
+	uint32_t* last							/* last chunk of the range					*/
+) {
+	const CefT_Chunk_Container* cp = NULL;
+	uint32_t pos;
+	uint16_t s, e;
+	uint32_t low;
+
+	cef_chunk_set_cont_search (set, cef_chunk_set_hi (from), &pos);
+
+	for ( ; pos < set->num ; pos++) {
+		cp = &set->conts[pos];
+		low = (cp->key == cef_chunk_set_hi (from)) ? cef_chunk_set_lo (from) : 0;
+		if (cef_chunk_set_cont_stretch (cp, low, &s, &e)) {
+			break;
+		}
+	}
+	if (pos == set->num) {
+		return (0);
+	}
+	*first = ((uint32_t) cp->key << 16) | s;
+	*last  = ((uint32_t) cp->key << 16) | e;
+
+	/* Continues the range over the boundaries of the containers 		*/
+	while ((e == 0xFFFF) && (pos + 1 < set->num)
+		&& (set->conts[pos + 1].key == cp->key + 1)) {
+		pos++;
+		cp = &set->conts[pos];
+		if (!cef_chunk_set_cont_stretch (cp, 0, &s, &e) || (s != 0)) {
+			break;
+		}
+		*last = ((uint32_t) cp->key << 16) | e;
+	}
+
+	return (1);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the smallest and the largest chunks in the set
+----------------------------------------------------------------------------------------*/
+int 										/* 0 if the set is empty					*/
+cef_chunk_set_min_max (
+	const CefT_Chunk_Set* set,				/* chunk set								*/
+	uint32_t* min,							/* smallest chunk							*/
+	uint32_t* max							/* largest chunk							*/
+) {
+	const CefT_Chunk_Container* cp;
+	int i;
+
+	if (set->num == 0) {
+		return (0);
+	}
+
+	cp = &set->conts[0];
+	if (cp->type == CefC_Chunk_Set_Run) {
+		*min = ((uint32_t) cp->key << 16) | cp->runs[0];
+	} else {
+		for (i = 0 ; cp->bits[i] == 0 ; i++) {
+			;
+		}
+		*min = ((uint32_t) cp->key << 16) | (i * 64 + __builtin_ctzll (cp->bits[i]));
+	}
+
+	cp = &set->conts[set->num - 1];
+	if (cp->type == CefC_Chunk_Set_Run) {
+		*max = ((uint32_t) cp->key << 16) | cp->runs[cp->run_num * 2 - 1];
+	} else {
+		for (i = CefC_Chunk_Set_Bitmap_Words - 1 ; cp->bits[i] == 0 ; i--) {
+			;
+		}
+		*max = ((uint32_t) cp->key << 16) | (i * 64 + 63 - __builtin_clzll (cp->bits[i]));
+	}
+
+	return (1);
+}
+/*--------------------------------------------------------------------------------------
+	Returns the bytes of the memory used by the set
+----------------------------------------------------------------------------------------*/
+size_t
+cef_chunk_set_mem_size (
+	const CefT_Chunk_Set* set				/* chunk set								*/
+) {
+	size_t size;
+	uint32_t i;
+
+	size = sizeof (CefT_Chunk_Container) * set->max;
+	for (i = 0 ; i < set->num ; i++) {
+		if (set->conts[i].type == CefC_Chunk_Set_Run) {
+			size += sizeof (uint16_t) * 2 * set->conts[i].run_max;
+		} else {
+			size += sizeof (uint64_t) * CefC_Chunk_Set_Bitmap_Words;
+		}
+	}
+
+	return (size);
+}
+/*--------------------------------------------------------------------------------------
+	Searches the container which has the specified upper 16 bits
+----------------------------------------------------------------------------------------*/
+static int 									/* 1 if the container is found				*/
+cef_chunk_set_cont_search (
+	const CefT_Chunk_Set* set,				/* chunk set								*/
+	uint16_t key,							/* upper 16 bits							*/
+	uint32_t* pos							/* position of the container, or the		*/
+											/* position to insert the container			*/
+) {
+	uint32_t lo = 0;
+	uint32_t hi = set->num;
+	uint32_t mid;
+
+	/* Chunks are usually added in order 		*/
+	if ((hi > 0) && (set->conts[hi - 1].key < key)) {
+		*pos = hi;
+		return (0);
+	}
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (set->conts[mid].key < key) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	*pos = lo;
+
+	return ((lo < set->num) && (set->conts[lo].key == key));
+}
+/*--------------------------------------------------------------------------------------
+	Inserts the empty container
+----------------------------------------------------------------------------------------*/
+static CefT_Chunk_Container* 				/* inserted container, NULL if the set		*/
+											/* cannot be extended						*/
+cef_chunk_set_cont_insert (
+	CefT_Chunk_Set* set,					/* chunk set								*/
+	uint32_t pos,							/* position to insert						*/
+	uint16_t key							/* upper 16 bits							*/
+) {
+	CefT_Chunk_Container* conts;
+	uint32_t new_max;
+
+	if (set->num == set->max) {
+		new_max = (set->max == 0) ? CefC_Chunk_Set_Cont_Init : set->max * 2;
+		conts = (CefT_Chunk_Container*)
+					realloc (set->conts, sizeof (CefT_Chunk_Container) * new_max);
+		if (conts == NULL) {
+			return (NULL);
+		}
+		set->conts = conts;
+		set->max   = new_max;
+	}
+	memmove (&set->conts[pos + 1], &set->conts[pos],
+				sizeof (CefT_Chunk_Container) * (set->num - pos));
+	set->num++;
+	memset (&set->conts[pos], 0, sizeof (CefT_Chunk_Container));
+	set->conts[pos].key  = key;
+	set->conts[pos].type = CefC_Chunk_Set_Run;
+
+	return (&set->conts[pos]);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the container
+----------------------------------------------------------------------------------------*/
+static void
+cef_chunk_set_cont_erase (
+	CefT_Chunk_Set* set,					/* chunk set								*/
+	uint32_t pos							/* position of the container				*/
+) {
+	free (set->conts[pos].runs);
+	free (set->conts[pos].bits);
+	set->num--;
+	memmove (&set->conts[pos], &set->conts[pos + 1],
+				sizeof (CefT_Chunk_Container) * (set->num - pos));
+}
+/*--------------------------------------------------------------------------------------
+	Searches the last run which starts at or before the specified value
+----------------------------------------------------------------------------------------*/
+static int 									/* index of the run, -1 if no run			*/
+cef_chunk_set_run_search (
+	const CefT_Chunk_Container* cp,			/* run container							*/
+	uint16_t low							/* lower 16 bits							*/
+) {
+	int lo = 0;
+	int hi = cp->run_num;
+	int mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (cp->runs[mid * 2] <= low) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return (lo - 1);
+}
+/*--------------------------------------------------------------------------------------
+	Inserts the run at the specified index
+----------------------------------------------------------------------------------------*/
+static int 									/* negative if the runs cannot be extended	*/
+cef_chunk_set_run_insert (
+	CefT_Chunk_Container* cp,				/* run container							*/
+	int i,									/* index of the run							*/
+	uint16_t first,							/* first value of the run					*/
+	uint16_t last							/* last value of the run					*/
+) {
+	uint16_t* runs;
+	uint16_t new_max;
+
+	if (cp->run_num == cp->run_max) {
+		new_max = (cp->run_max == 0) ? CefC_Chunk_Set_Run_Init : cp->run_max * 2;
+		runs = (uint16_t*) realloc (cp->runs, sizeof (uint16_t) * 2 * new_max);
+		if (runs == NULL) {
+			return (-1);
+		}
+		cp->runs    = runs;
+		cp->run_max = new_max;
+	}
+	memmove (&cp->runs[(i + 1) * 2], &cp->runs[i * 2],
+				sizeof (uint16_t) * 2 * (cp->run_num - i));
+	cp->runs[i * 2]     = first;
+	cp->runs[i * 2 + 1] = last;
+	cp->run_num++;
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the run at the specified index
+----------------------------------------------------------------------------------------*/
+static void
+cef_chunk_set_run_erase (
+	CefT_Chunk_Container* cp,				/* run container							*/
+	int i									/* index of the run							*/
+) {
+	cp->run_num--;
+	memmove (&cp->runs[i * 2], &cp->runs[(i + 1) * 2],
+				sizeof (uint16_t) * 2 * (cp->run_num - i));
+}
+/*--------------------------------------------------------------------------------------
+	Changes the run container to the bitmap container
+----------------------------------------------------------------------------------------*/
+static int 									/* negative if the bitmap cannot be created	*/
+cef_chunk_set_to_bitmap (
+	CefT_Chunk_Container* cp				/* run container							*/
+) {
+	uint64_t* bits;
+	uint32_t i, x;
+
+	bits = (uint64_t*) calloc (CefC_Chunk_Set_Bitmap_Words, sizeof (uint64_t));
+	if (bits == NULL) {
+		return (-1);
+	}
+	for (i = 0 ; i < cp->run_num ; i++) {
+		for (x = cp->runs[i * 2] ; x <= cp->runs[i * 2 + 1] ; x++) {
+			bits[x >> 6] |= 1llu << (x & 63);
+		}
+	}
+	free (cp->runs);
+	cp->runs    = NULL;
+	cp->run_num = 0;
+	cp->run_max = 0;
+	cp->bits    = bits;
+	cp->type    = CefC_Chunk_Set_Bitmap;
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Changes the bitmap container to the run container
+----------------------------------------------------------------------------------------*/
+static int 									/* negative if the runs cannot be created	*/
+cef_chunk_set_to_run (
+	CefT_Chunk_Container* cp				/* bitmap container							*/
+) {
+	uint64_t* bits = cp->bits;
+	uint16_t s, e;
+	uint32_t from = 0;
+
+	cp->bits = NULL;
+	cp->type = CefC_Chunk_Set_Run;
+	while ((from <= 0xFFFF) && (bits != NULL)) {
+		/* Finds the next stretch in the bitmap 		*/
+		for ( ; from <= 0xFFFF ; from++) {
+			if (cef_chunk_set_bit_test (bits, from)) {
+				break;
+			}
+		}
+		if (from > 0xFFFF) {
+			break;
+		}
+		s = (uint16_t) from;
+		for ( ; from <= 0xFFFF ; from++) {
+			if (!cef_chunk_set_bit_test (bits, from)) {
+				break;
+			}
+		}
+		e = (uint16_t)(from - 1);
+		if (cef_chunk_set_run_insert (cp, cp->run_num, s, e) < 0) {
+			/* Keeps the bitmap 		*/
+			free (cp->runs);
+			cp->runs    = NULL;
+			cp->run_num = 0;
+			cp->run_max = 0;
+			cp->bits    = bits;
+			cp->type    = CefC_Chunk_Set_Bitmap;
+			return (-1);
+		}
+	}
+	free (bits);
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Adds the value to the container
+----------------------------------------------------------------------------------------*/
+static int 									/* 1: added, 0: already in the container,	*/
+											/* negative: cannot be extended				*/
+cef_chunk_set_cont_add (
+	CefT_Chunk_Container* cp,				/* container								*/
+	uint16_t low							/* lower 16 bits							*/
+) {
+	int i;
+	int left_f, right_f;
+
+	if (cp->type == CefC_Chunk_Set_Bitmap) {
+		if (cef_chunk_set_bit_test (cp->bits, low)) {
+			return (0);
+		}
+		cp->bits[low >> 6] |= 1llu << (low & 63);
+		cp->card++;
+		return (1);
+	}
+
+	i = cef_chunk_set_run_search (cp, low);
+	if ((i >= 0) && (low <= cp->runs[i * 2 + 1])) {
+		return (0);
+	}
+	left_f  = ((i >= 0) && ((uint32_t) cp->runs[i * 2 + 1] + 1 == low));
+	right_f = ((i + 1 < cp->run_num) && ((uint32_t) low + 1 == cp->runs[(i + 1) * 2]));
+
+	if (left_f && right_f) {
+		cp->runs[i * 2 + 1] = cp->runs[(i + 1) * 2 + 1];
+		cef_chunk_set_run_erase (cp, i + 1);
+	} else if (left_f) {
+		cp->runs[i * 2 + 1] = low;
+	} else if (right_f) {
+		cp->runs[(i + 1) * 2] = low;
+	} else if (cp->run_num < CefC_Chunk_Set_Run_Max) {
+		if (cef_chunk_set_run_insert (cp, i + 1, low, low) < 0) {
+			return (-1);
+		}
+	} else {
+		/* The runs are larger than the bitmap 		*/
+		if (cef_chunk_set_to_bitmap (cp) < 0) {
+			return (-1);
+		}
+		return (cef_chunk_set_cont_add (cp, low));
+	}
+	cp->card++;
+
+	return (1);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the value from the container
+----------------------------------------------------------------------------------------*/
+static int 									/* 1: removed, 0: not in the container,		*/
+											/* negative: cannot be extended				*/
+cef_chunk_set_cont_remove (
+	CefT_Chunk_Container* cp,				/* container								*/
+	uint16_t low							/* lower 16 bits							*/
+) {
+	int i;
+	uint16_t last;
+
+	if (cp->type == CefC_Chunk_Set_Bitmap) {
+		if (!cef_chunk_set_bit_test (cp->bits, low)) {
+			return (0);
+		}
+		cp->bits[low >> 6] &= ~(1llu << (low & 63));
+		cp->card--;
+		/* The runs are never larger than the number of the values 		*/
+		if (cp->card < CefC_Chunk_Set_Run_Max / 2) {
+			cef_chunk_set_to_run (cp);
+		}
+		return (1);
+	}
+
+	i = cef_chunk_set_run_search (cp, low);
+	if ((i < 0) || (low > cp->runs[i * 2 + 1])) {
+		return (0);
+	}
+	last = cp->runs[i * 2 + 1];
+
+	if (cp->runs[i * 2] == last) {
+		cef_chunk_set_run_erase (cp, i);
+	} else if (cp->runs[i * 2] == low) {
+		cp->runs[i * 2] = low + 1;
+	} else if (last == low) {
+		cp->runs[i * 2 + 1] = low - 1;
+	} else if (cp->run_num < CefC_Chunk_Set_Run_Max) {
+		/* Splits the run 		*/
+		if (cef_chunk_set_run_insert (cp, i + 1, low + 1, last) < 0) {
+			return (-1);
+		}
+		cp->runs[i * 2 + 1] = low - 1;
+	} else {
+		if (cef_chunk_set_to_bitmap (cp) < 0) {
+			return (-1);
+		}
+		return (cef_chunk_set_cont_remove (cp, low));
+	}
+	cp->card--;
+
+	return (1);
+}
+/*--------------------------------------------------------------------------------------
+	Checks whether the value is in the container
+----------------------------------------------------------------------------------------*/
+static int 									/* 1 if the value is in the container		*/
+cef_chunk_set_cont_contains (
+	const CefT_Chunk_Container* cp,			/* container								*/
+	uint16_t low							/* lower 16 bits							*/
+) {
+	int i;
+
+	if (cp->type == CefC_Chunk_Set_Bitmap) {
+		return ((int) cef_chunk_set_bit_test (cp->bits, low));
+	}
+	i = cef_chunk_set_run_search (cp, low);
+
+	return ((i >= 0) && (low <= cp->runs[i * 2 + 1]));
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the first stretch of the contiguous values not smaller than the specified
+	value in the container
+----------------------------------------------------------------------------------------*/
+static int 									/* 1 if the stretch is found				*/
+cef_chunk_set_cont_stretch (
+	const CefT_Chunk_Container* cp,			/* container								*/
+	uint32_t from,							/* value to start the search				*/
+	uint16_t* first,						/* first value of the stretch				*/
+	uint16_t* last							/* last value of the stretch				*/
+) {
+	uint64_t word;
+	uint32_t x;
+	int i;
+
+	if (cp->type == CefC_Chunk_Set_Run) {
+		i = cef_chunk_set_run_search (cp, (uint16_t) from);
+		if ((i < 0) || (from > cp->runs[i * 2 + 1])) {
+			i++;
+		}
+		if (i >= cp->run_num) {
+			return (0);
+		}
+		*first = (cp->runs[i * 2] < from) ? (uint16_t) from : cp->runs[i * 2];
+		*last  = cp->runs[i * 2 + 1];
+		return (1);
+	}
+
+	/* Finds the first set bit 		*/
+	x = from >> 6;
+	word = cp->bits[x] & (~0llu << (from & 63));
+	while (word == 0) {
+		x++;
+		if (x >= CefC_Chunk_Set_Bitmap_Words) {
+			return (0);
+		}
+		word = cp->bits[x];
+	}
+	from = x * 64 + __builtin_ctzll (word);
+	*first = (uint16_t) from;
+
+	/* Finds the next clear bit 		*/
+	word = ~cp->bits[x] & (~0llu << (from & 63));
+	while (word == 0) {
+		x++;
+		if (x >= CefC_Chunk_Set_Bitmap_Words) {
+			*last = 0xFFFF;
+			return (1);
+		}
+		word = ~cp->bits[x];
+	}
+	*last = (uint16_t)(x * 64 + __builtin_ctzll (word) - 1);
+
+	return (1);
+}
@@ -72,6 +72,7 @@ static char csmgr_lsock_name[2048] = {"/tmp/csmgr_9799.0"};
 static char cbd_lsock_name[2048] = {"/tmp/cbd_9896.0"};
 static char cef_conf_dir[PATH_MAX*2] = {"/usr/local/cefore"};
 static int  cef_port_num = CefC_Default_PortNum;
+static uint32_t cef_shmring_size = CefC_Shmring_Size_Def;
 static unsigned char* work_buff = NULL;
 
 /****************************************************************************************
@@ -91,6 +92,14 @@ cef_client_trim_line_string (
 /*--------------------------------------------------------------------------------------
 	Key pair configuration management functions
 ----------------------------------------------------------------------------------------*/
+/*--------------------------------------------------------------------------------------
+	Negotiates the shared memory rings with cefnetd
+----------------------------------------------------------------------------------------*/
+static void
+cef_client_shmring_open (
+	CefT_Connect* conn						/* connection to cefnetd 					*/
+);
+
 static void* cef_client_load_keypair_config(void);
 static int cef_client_apply_keyid_for_uri(void*, CefT_CcnMsg_MsgBdy*);
 
@@ -176,6 +185,16 @@ cef_client_init (
 				return (-1);
 			}
 			strcpy (lsock_id, ws);
+		} else if (strcmp (pname, CefC_ParamName_LocalShmRing) == 0) {
+			res = atoi (ws);
+			if (res < 0) {
+				cef_log_write (CefC_Log_Error,
+					"[client] %s must be higher than or equal to 0.\n",
+						CefC_ParamName_LocalShmRing);
+				fclose (fp);
+				return (-1);
+			}
+			cef_shmring_size = (uint32_t) res;
 		}
 	}
 	if (port_num == CefC_Unset_Port) {
@@ -306,6 +325,9 @@ cef_client_connect (
 	memset (conn, 0, sizeof (CefT_Connect));
 	conn->sock = sock;
 
+	/* Uses the shared memory rings if cefnetd accepts them 	*/
+	cef_client_shmring_open (conn);
+
 	return ((CefT_Client_Handle) conn);
 }
 CefT_Client_Handle 								/* created client handle 				*/
@@ -542,6 +564,9 @@ cef_client_close (
 	} else {
 		send (conn->sock, CefC_Face_Close, strlen (CefC_Face_Close), 0);
 		close (conn->sock);
+		if (conn->shm) {
+			cef_shmring_pair_destroy (conn->shm);
+		}
 		free (conn);
 	}
 	if (work_buff) {
@@ -688,12 +713,19 @@ static int
 cef_client_conn_send(
 	CefT_Connect	*conn,
 	unsigned char	*buff,
-	size_t			length
+	size_t			length,
+	int				shm_f				/* 1 if the message may use the ring 		*/
 )
 {
 	int	ret = 0;
 
-	if (conn->ai) {
+	if (conn->shm && shm_f) {
+		/* cefnetd reassembles the frames, so the ring can carry them in pieces */
+		if (length > CefC_Max_Length) {
+			length = CefC_Max_Length;
+		}
+		ret = cef_shmring_write (&conn->shm->tx, buff, (int) length);
+	} else if (conn->ai) {
 		ret = sendto (conn->sock, buff, length, 0,
 						conn->ai->ai_addr, conn->ai->ai_addrlen);
 	} else {
@@ -712,11 +744,15 @@ cef_client_message_input (
 ) {
 	CefT_Connect* conn = (CefT_Connect*) fhdl;
 	int	send_len = 0, frame_len = len;
+	int	shm_f;
+
+	/* Control messages are always sent on the socket 	*/
+	shm_f = (len > 0 && msg[0] == CefC_Version) ? 1 : 0;
 
 	for ( int i = 0; i < CefC_Conn_Send_RetryMax; i++ ){
 		int		ret = 0;
 
-		ret = cef_client_conn_send (conn, &msg[send_len], frame_len-send_len);
+		ret = cef_client_conn_send (conn, &msg[send_len], frame_len-send_len, shm_f);
 cef_dbg_write (CefC_Dbg_Finest, "i=%d, frame_len=%ld, send_len=%ld, ret=%d\n", i, frame_len, send_len, ret);
 
 		if ( 0 < ret ){
@@ -759,7 +795,7 @@ cef_client_interest_input (
 	for ( int i = 0; i < CefC_Conn_Send_RetryMax; i++ ){
 		int		ret = 0;
 
-		ret = cef_client_conn_send (conn, &buff[send_len], frame_len-send_len);
+		ret = cef_client_conn_send (conn, &buff[send_len], frame_len-send_len, 1);
 cef_dbg_write (CefC_Dbg_Finest, "i=%d, frame_len=%ld, send_len=%ld, ret=%d\n", i, frame_len, send_len, ret);
 
 		if ( 0 < ret ){
@@ -863,7 +899,7 @@ cef_client_object_input (
 	for ( int i = 0; i < CefC_Conn_Send_RetryMax; i++ ){
 		int		ret = 0;
 
-		ret = cef_client_conn_send (conn, &buff[send_len], frame_len-send_len);
+		ret = cef_client_conn_send (conn, &buff[send_len], frame_len-send_len, 1);
 cef_dbg_write (CefC_Dbg_Finest, "i=%d, frame_len=%ld, send_len=%ld, ret=%d\n", i, frame_len, send_len, ret);
 
 		if ( 0 < ret ){
@@ -901,7 +937,7 @@ cef_client_ccninfo_input (
 	for ( int i = 0; i < CefC_Conn_Send_RetryMax; i++ ){
 		int		ret = 0;
 
-		ret = cef_client_conn_send (conn, &buff[send_len], frame_len-send_len);
+		ret = cef_client_conn_send (conn, &buff[send_len], frame_len-send_len, 1);
 cef_dbg_write (CefC_Dbg_Finest, "i=%d, frame_len=%ld, send_len=%ld, ret=%d\n", i, frame_len, send_len, ret);
 
 		if ( 0 < ret ){
@@ -931,18 +967,38 @@ cef_client_read_core (
 ) {
 	CefT_Connect* conn = (CefT_Connect*) fhdl;
 	int recv_len = 0;
-	struct pollfd infds[1];
+	struct pollfd infds[2];
+	int nfds = 1;
 	struct sockaddr_storage sas;
 	socklen_t sas_len = (socklen_t) sizeof (struct sockaddr_storage);
 
 	infds[0].fd = conn->sock;
 	infds[0].events = POLLIN | POLLERR;
 
+	if (conn->shm) {
+		/* Frames from cefnetd are written into the ring 	*/
+		recv_len = cef_shmring_read (&conn->shm->rx, buff, len);
+		if (recv_len > 0) {
+			return (recv_len);
+		}
+		infds[1].fd = conn->shm->rx.efd;
+		infds[1].events = POLLIN;
+		infds[1].revents = 0;
+		nfds = 2;
+	}
+
 	/* ppoll can improve the accuracy of timeout,
 	   but ppoll is Linux-specific and not portable. */
-	poll (infds, 1, timeout);
+	poll (infds, nfds, timeout);
 	errno = 0;
 
+	if ((nfds > 1) && (infds[1].revents & POLLIN)) {
+		recv_len = cef_shmring_read (&conn->shm->rx, buff, len);
+		if (recv_len > 0) {
+			return (recv_len);
+		}
+	}
+
 	if (infds[0].revents != 0) {
 		if (infds[0].revents & (POLLERR | POLLNVAL | POLLHUP)) {
 			if (conn->ai) {
@@ -1410,4 +1466,47 @@ cef_client_trim_line_string (
 
 	return (equal_f);
 }
+/*--------------------------------------------------------------------------------------
+	Negotiates the shared memory rings with cefnetd
+----------------------------------------------------------------------------------------*/
+static void
+cef_client_shmring_open (
+	CefT_Connect* conn						/* connection to cefnetd 					*/
+) {
+	CefT_Shmring_Pair* pair;
+	struct pollfd infds[1];
+	char rsp[CefC_Shmring_Reply_Len];
+	int res;
 
+	if (cef_shmring_size == 0) {
+		return;
+	}
+	pair = cef_shmring_pair_create (cef_shmring_size);
+	if (pair == NULL) {
+		return;
+	}
+	if (cef_shmring_fds_send (
+			conn->sock, CefC_Shmring_Open, pair->fds, CefC_Shmring_Fd_Num) < 0) {
+		cef_shmring_pair_destroy (pair);
+		return;
+	}
+
+	/* cefnetd which does not know the rings never replies 	*/
+	infds[0].fd = conn->sock;
+	infds[0].events = POLLIN | POLLERR;
+	if ((poll (infds, 1, CefC_Shmring_Nego_Timeout) > 0) &&
+		(infds[0].revents & POLLIN)) {
+		res = recv (conn->sock, rsp, CefC_Shmring_Reply_Len, MSG_PEEK);
+		if ((res == CefC_Shmring_Reply_Len) &&
+			((memcmp (rsp, CefC_Shmring_Accept, CefC_Shmring_Reply_Len) == 0) ||
+			 (memcmp (rsp, CefC_Shmring_Reject, CefC_Shmring_Reply_Len) == 0))) {
+			recv (conn->sock, rsp, CefC_Shmring_Reply_Len, 0);
+			if (memcmp (rsp, CefC_Shmring_Accept, CefC_Shmring_Reply_Len) == 0) {
+				conn->shm = pair;
+				cef_log_write (CefC_Log_Info, "[client] Uses the shared memory ring\n");
+				return;
+			}
+		}
+	}
+	cef_shmring_pair_destroy (pair);
+}
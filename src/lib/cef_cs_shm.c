@@ -0,0 +1,479 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * cef_cs_shm.c
+ */
+
+#define __CEF_CS_SHM_SOURECE__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+
+#include <cefore/cef_cs_shm.h>
+
+#ifdef CefC_Cs_Shm_Enable
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // CefC_Cs_Shm_Enable
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define CefC_Cs_Shm_Fnv_Offset		2166136261U
+#define CefC_Cs_Shm_Fnv_Prime		16777619U
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+#ifdef CefC_Cs_Shm_Enable
+/*--------------------------------------------------------------------------------------
+	Obtains the slot which the key is placed in
+----------------------------------------------------------------------------------------*/
+static CefT_Cs_Shm_Slot*
+cef_cs_shm_slot_get (
+	CefT_Cs_Shm* shm,
+	const unsigned char* key,
+	uint16_t key_len
+);
+/*--------------------------------------------------------------------------------------
+	Locks the slot for writing
+----------------------------------------------------------------------------------------*/
+static int									/* Returns a negative value if it fails 	*/
+cef_cs_shm_slot_lock (
+	CefT_Cs_Shm_Slot* slot,
+	uint32_t* seq
+);
+#endif // CefC_Cs_Shm_Enable
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the shared region (csmgrd side)
+----------------------------------------------------------------------------------------*/
+CefT_Cs_Shm* 								/* Returns NULL if it fails 				*/
+cef_cs_shm_create (
+	uint16_t port_num,						/* port number of csmgrd 					*/
+	uint64_t size,							/* size of the region 						*/
+	uint32_t slot_size						/* size of each slot 						*/
+) {
+#ifdef CefC_Cs_Shm_Enable
+	CefT_Cs_Shm* shm;
+	uint64_t slot_num;
+	uint64_t p;
+	int fd;
+
+	if ((size < CefC_Cs_Shm_Size_Min) || (size > CefC_Cs_Shm_Size_Max) ||
+		(slot_size < CefC_Cs_Shm_Slot_Size_Min) || (slot_size > CefC_Cs_Shm_Slot_Size_Max)) {
+		return (NULL);
+	}
+
+	/* Obtains the number of slots (power of 2) 	*/
+	slot_size = (slot_size + 7) & ~7U;
+	slot_num  = (size - sizeof (CefT_Cs_Shm_Hdr)) / slot_size;
+	for (p = 1 ; (p << 1) <= slot_num ; p <<= 1) {
+		;
+	}
+	slot_num = p;
+
+	shm = (CefT_Cs_Shm*) calloc (1, sizeof (CefT_Cs_Shm));
+	if (shm == NULL) {
+		return (NULL);
+	}
+	shm->map     = MAP_FAILED;
+	shm->map_len = sizeof (CefT_Cs_Shm_Hdr) + (size_t)(slot_num * slot_size);
+	shm->owner_f = 1;
+	snprintf (shm->name, sizeof (shm->name), CefC_Cs_Shm_Name, port_num);
+
+	/* Removes the region left by the previous csmgrd 	*/
+	shm_unlink (shm->name);
+	fd = shm_open (shm->name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd < 0) {
+		free (shm);
+		return (NULL);
+	}
+	if (ftruncate (fd, (off_t) shm->map_len) < 0) {
+		goto ERROR;
+	}
+	shm->map = mmap (NULL, shm->map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (shm->map == MAP_FAILED) {
+		goto ERROR;
+	}
+	close (fd);
+
+	shm->hdr       = (CefT_Cs_Shm_Hdr*) shm->map;
+	shm->slots     = (unsigned char*) shm->map + sizeof (CefT_Cs_Shm_Hdr);
+	shm->mask      = (uint32_t)(slot_num - 1);
+	shm->slot_size = slot_size;
+
+	shm->hdr->slot_num  = (uint32_t) slot_num;
+	shm->hdr->slot_size = slot_size;
+	shm->hdr->pid       = (uint32_t) getpid ();
+	shm->hdr->alive     = 1;
+	__atomic_store_n (&shm->hdr->magic, CefC_Cs_Shm_Magic, __ATOMIC_RELEASE);
+
+	return (shm);
+
+ERROR:
+	close (fd);
+	shm_unlink (shm->name);
+	free (shm);
+#endif // CefC_Cs_Shm_Enable
+	return (NULL);
+}
+
+/*--------------------------------------------------------------------------------------
+	Attaches the shared region created by csmgrd (cefnetd side)
+----------------------------------------------------------------------------------------*/
+CefT_Cs_Shm* 								/* Returns NULL if it fails 				*/
+cef_cs_shm_attach (
+	uint16_t port_num						/* port number of csmgrd 					*/
+) {
+#ifdef CefC_Cs_Shm_Enable
+	CefT_Cs_Shm* shm;
+	CefT_Cs_Shm_Hdr* hdr;
+	struct stat st;
+	uint32_t slot_num;
+	uint32_t slot_size;
+	int fd;
+
+	shm = (CefT_Cs_Shm*) calloc (1, sizeof (CefT_Cs_Shm));
+	if (shm == NULL) {
+		return (NULL);
+	}
+	shm->map = MAP_FAILED;
+	snprintf (shm->name, sizeof (shm->name), CefC_Cs_Shm_Name, port_num);
+
+	fd = shm_open (shm->name, O_RDONLY, 0);
+	if (fd < 0) {
+		free (shm);
+		return (NULL);
+	}
+
+	/* Checks the size of the shared region 		*/
+	if ((fstat (fd, &st) < 0) ||
+		(st.st_size < (off_t)(sizeof (CefT_Cs_Shm_Hdr) + CefC_Cs_Shm_Slot_Size_Min)) ||
+		(st.st_size > (off_t) CefC_Cs_Shm_Size_Max)) {
+		goto ERROR;
+	}
+	shm->map_len = (size_t) st.st_size;
+	shm->ino     = (uint64_t) st.st_ino;
+	shm->map = mmap (NULL, shm->map_len, PROT_READ, MAP_SHARED, fd, 0);
+	if (shm->map == MAP_FAILED) {
+		goto ERROR;
+	}
+	close (fd);
+	fd = -1;
+
+	/* Validates the header which csmgrd wrote 		*/
+	hdr       = (CefT_Cs_Shm_Hdr*) shm->map;
+	slot_num  = hdr->slot_num;
+	slot_size = hdr->slot_size;
+	if ((__atomic_load_n (&hdr->magic, __ATOMIC_ACQUIRE) != CefC_Cs_Shm_Magic) ||
+		(hdr->pid == 0) || (slot_num == 0) || ((slot_num & (slot_num - 1)) != 0) ||
+		(slot_size < CefC_Cs_Shm_Slot_Size_Min) || (slot_size > CefC_Cs_Shm_Slot_Size_Max) ||
+		(shm->map_len != sizeof (CefT_Cs_Shm_Hdr) + (size_t) slot_num * slot_size)) {
+		goto ERROR;
+	}
+	shm->hdr       = hdr;
+	shm->slots     = (unsigned char*) shm->map + sizeof (CefT_Cs_Shm_Hdr);
+	shm->mask      = slot_num - 1;
+	shm->slot_size = slot_size;
+	shm->owner_f   = 0;
+
+	return (shm);
+
+ERROR:
+	if (fd != -1) {
+		close (fd);
+	}
+	if (shm->map != MAP_FAILED) {
+		munmap (shm->map, shm->map_len);
+	}
+	free (shm);
+#endif // CefC_Cs_Shm_Enable
+	return (NULL);
+}
+
+/*--------------------------------------------------------------------------------------
+	Detaches the shared region (csmgrd also removes it)
+----------------------------------------------------------------------------------------*/
+void
+cef_cs_shm_destroy (
+	CefT_Cs_Shm* shm
+) {
+#ifdef CefC_Cs_Shm_Enable
+	if (shm == NULL) {
+		return;
+	}
+	if (shm->owner_f) {
+		/* The attached cefnetd stops using the region 	*/
+		__atomic_store_n (&shm->hdr->alive, 0, __ATOMIC_RELEASE);
+		shm_unlink (shm->name);
+	}
+	munmap (shm->map, shm->map_len);
+	free (shm);
+#endif // CefC_Cs_Shm_Enable
+}
+
+/*--------------------------------------------------------------------------------------
+	Checks whether csmgrd still publishes to the region
+----------------------------------------------------------------------------------------*/
+int											/* 1 if the region is alive 				*/
+cef_cs_shm_is_alive (
+	CefT_Cs_Shm* shm,
+	uint64_t nowt							/* present time (us) 						*/
+) {
+#ifdef CefC_Cs_Shm_Enable
+	struct stat st;
+	int fd;
+	int res;
+
+	if (shm == NULL) {
+		return (0);
+	}
+	if (__atomic_load_n (&shm->hdr->alive, __ATOMIC_ACQUIRE) == 0) {
+		return (0);
+	}
+	if ((shm->owner_f) || (nowt < shm->check_time)) {
+		return (1);
+	}
+	shm->check_time = nowt + CefC_Cs_Shm_Check_Interval;
+
+	/* csmgrd exited without clearing alive 		*/
+	if ((kill ((pid_t) shm->hdr->pid, 0) < 0) && (errno == ESRCH)) {
+		return (0);
+	}
+
+	/* The region was removed or a new csmgrd created another one 	*/
+	fd = shm_open (shm->name, O_RDONLY, 0);
+	if (fd < 0) {
+		return (0);
+	}
+	res = ((fstat (fd, &st) == 0) && ((uint64_t) st.st_ino == shm->ino)) ? 1 : 0;
+	close (fd);
+
+	return (res);
+#else // CefC_Cs_Shm_Enable
+	return (0);
+#endif // CefC_Cs_Shm_Enable
+}
+
+/*--------------------------------------------------------------------------------------
+	Publishes the Cob to the slot of the key (csmgrd side)
+----------------------------------------------------------------------------------------*/
+int											/* Returns a negative value if it is not 	*/
+											/* published 								*/
+cef_cs_shm_publish (
+	CefT_Cs_Shm* shm,
+	const unsigned char* key,				/* name including the chunk number 			*/
+	uint16_t key_len,
+	const unsigned char* msg,				/* Cob 										*/
+	uint16_t msg_len,
+	uint64_t cache_time,
+	uint64_t expiry							/* 0 means no expiry 						*/
+) {
+#ifdef CefC_Cs_Shm_Enable
+	CefT_Cs_Shm_Slot* slot;
+	unsigned char* wp;
+	uint32_t seq;
+
+	if ((shm == NULL) || (!shm->owner_f) || (key_len == 0)) {
+		return (-1);
+	}
+	if (sizeof (CefT_Cs_Shm_Slot) + key_len + msg_len > shm->slot_size) {
+		/* Too large, the old Cob of the key must not remain 	*/
+		cef_cs_shm_invalidate (shm, key, key_len);
+		return (-1);
+	}
+	slot = cef_cs_shm_slot_get (shm, key, key_len);
+	if (cef_cs_shm_slot_lock (slot, &seq) < 0) {
+		return (-1);
+	}
+
+	/* Overwrites the slot, the readers retry while seq is odd 	*/
+	wp = (unsigned char*) slot + sizeof (CefT_Cs_Shm_Slot);
+	slot->key_len    = key_len;
+	slot->msg_len    = msg_len;
+	slot->cache_time = cache_time;
+	slot->expiry     = expiry;
+	memcpy (wp, key, key_len);
+	memcpy (wp + key_len, msg, msg_len);
+
+	__atomic_store_n (&slot->seq, seq + 2, __ATOMIC_RELEASE);
+	return (0);
+#else // CefC_Cs_Shm_Enable
+	return (-1);
+#endif // CefC_Cs_Shm_Enable
+}
+
+/*--------------------------------------------------------------------------------------
+	Removes the Cob of the key from the region (csmgrd side)
+----------------------------------------------------------------------------------------*/
+void
+cef_cs_shm_invalidate (
+	CefT_Cs_Shm* shm,
+	const unsigned char* key,
+	uint16_t key_len
+) {
+#ifdef CefC_Cs_Shm_Enable
+	CefT_Cs_Shm_Slot* slot;
+	uint32_t seq;
+
+	if ((shm == NULL) || (!shm->owner_f) || (key_len == 0)) {
+		return;
+	}
+	slot = cef_cs_shm_slot_get (shm, key, key_len);
+
+	/* The removed Cob must not remain, so waits for the other writer 	*/
+	while (cef_cs_shm_slot_lock (slot, &seq) < 0) {
+		;
+	}
+	if ((slot->key_len == key_len) &&
+		(memcmp ((unsigned char*) slot + sizeof (CefT_Cs_Shm_Slot), key, key_len) == 0)) {
+		slot->key_len = 0;
+		seq += 2;
+	}
+	/* Restores seq if the slot holds another key, readers need not retry 	*/
+	__atomic_store_n (&slot->seq, seq, __ATOMIC_RELEASE);
+#endif // CefC_Cs_Shm_Enable
+}
+
+/*--------------------------------------------------------------------------------------
+	Looks up the Cob of the key and copies it to the buffer (cefnetd side)
+----------------------------------------------------------------------------------------*/
+int											/* length of the Cob, negative if it misses */
+cef_cs_shm_lookup (
+	CefT_Cs_Shm* shm,
+	const unsigned char* key,
+	uint16_t key_len,
+	uint64_t nowt,							/* present time (us) 						*/
+	unsigned char* buff,
+	int buff_len
+) {
+#ifdef CefC_Cs_Shm_Enable
+	CefT_Cs_Shm_Slot* slot;
+	unsigned char* rp;
+	uint32_t seq;
+	uint16_t msg_len;
+	uint64_t expiry;
+
+	if ((shm == NULL) || (key_len == 0)) {
+		return (-1);
+	}
+	slot = cef_cs_shm_slot_get (shm, key, key_len);
+
+	seq = __atomic_load_n (&slot->seq, __ATOMIC_ACQUIRE);
+	if (seq & 1) {
+		return (-1);
+	}
+	rp = (unsigned char*) slot + sizeof (CefT_Cs_Shm_Slot);
+	msg_len = slot->msg_len;
+	expiry  = slot->expiry;
+	if ((slot->key_len != key_len) || (msg_len > buff_len) ||
+		(sizeof (CefT_Cs_Shm_Slot) + key_len + msg_len > shm->slot_size) ||
+		(nowt >= slot->cache_time) || ((expiry != 0) && (nowt >= expiry)) ||
+		(memcmp (rp, key, key_len) != 0)) {
+		return (-1);
+	}
+	memcpy (buff, rp + key_len, msg_len);
+
+	/* The copy is valid only if csmgrd did not overwrite the slot meanwhile 	*/
+	__atomic_thread_fence (__ATOMIC_ACQUIRE);
+	if (__atomic_load_n (&slot->seq, __ATOMIC_RELAXED) != seq) {
+		return (-1);
+	}
+	return ((int) msg_len);
+#else // CefC_Cs_Shm_Enable
+	return (-1);
+#endif // CefC_Cs_Shm_Enable
+}
+
+#ifdef CefC_Cs_Shm_Enable
+/*--------------------------------------------------------------------------------------
+	Obtains the slot which the key is placed in
+----------------------------------------------------------------------------------------*/
+static CefT_Cs_Shm_Slot*
+cef_cs_shm_slot_get (
+	CefT_Cs_Shm* shm,
+	const unsigned char* key,
+	uint16_t key_len
+) {
+	uint32_t hash = CefC_Cs_Shm_Fnv_Offset;
+	int i;
+
+	/* FNV-1a, csmgrd and cefnetd must derive the same slot 	*/
+	for (i = 0 ; i < key_len ; i++) {
+		hash ^= key[i];
+		hash *= CefC_Cs_Shm_Fnv_Prime;
+	}
+	return ((CefT_Cs_Shm_Slot*)
+		(shm->slots + (size_t)(hash & shm->mask) * shm->slot_size));
+}
+/*--------------------------------------------------------------------------------------
+	Locks the slot for writing
+----------------------------------------------------------------------------------------*/
+static int									/* Returns a negative value if it fails 	*/
+cef_cs_shm_slot_lock (
+	CefT_Cs_Shm_Slot* slot,
+	uint32_t* seq
+) {
+	*seq = __atomic_load_n (&slot->seq, __ATOMIC_RELAXED);
+
+	/* Another thread of csmgrd is writing the slot, gives it up 	*/
+	if (*seq & 1) {
+		return (-1);
+	}
+	if (!__atomic_compare_exchange_n (&slot->seq, seq, *seq + 1,
+			0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+		return (-1);
+	}
+	return (0);
+}
+#endif // CefC_Cs_Shm_Enable
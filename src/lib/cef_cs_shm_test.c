@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * cef_cs_shm_test.c
+ */
+
+/*
+	cef_cs_shm_test.c checks that cefnetd finds the region of csmgrd dead when
+	csmgrd exits without closing it or a new csmgrd replaces it, and that the
+	region is not readable by the other users.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <cefore/cef_cs_shm.h>
+
+#ifdef CefC_Cs_Shm_Enable
+#include <sys/mman.h>
+#endif // CefC_Cs_Shm_Enable
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static int				test_fail = 0;
+
+/****************************************************************************************
+ Static Functions
+ ****************************************************************************************/
+
+static void
+test_expect (
+	const char* what,
+	int64_t value,
+	int64_t expected
+) {
+	if (value != expected) {
+		fprintf (stderr, "FAIL: %s = %lld (expected %lld)\n", what,
+			(long long) value, (long long) expected);
+		test_fail = 1;
+	}
+}
+
+#ifdef CefC_Cs_Shm_Enable
+/*--------------------------------------------------------------------------------------
+	Publishes one Cob and looks it up through the attached region
+----------------------------------------------------------------------------------------*/
+static int
+test_lookup (
+	CefT_Cs_Shm* owner,
+	CefT_Cs_Shm* shm
+) {
+	unsigned char key[] = "key";
+	unsigned char msg[] = "message";
+	unsigned char buff[64];
+
+	if ((owner) &&
+		(cef_cs_shm_publish (owner, key, sizeof (key), msg, sizeof (msg),
+			UINT64_MAX, 0) < 0)) {
+		return (-1);
+	}
+	return (cef_cs_shm_lookup (shm, key, sizeof (key), 1, buff, sizeof (buff)));
+}
+
+static void
+test_run (
+	void
+) {
+	CefT_Cs_Shm* owner;
+	CefT_Cs_Shm* shm;
+	struct stat st;
+	uint16_t port;
+	pid_t pid;
+	int fd;
+	int status;
+	uint64_t nowt = 1;
+
+	port = (uint16_t)(50000 + (getpid () % 10000));
+
+	/* The region is alive while csmgrd runs, and only its user reads it 	*/
+	owner = cef_cs_shm_create (port, CefC_Cs_Shm_Size_Min, CefC_Cs_Shm_Slot_Size_Def);
+	if (owner == NULL) {
+		fprintf (stderr, "FAIL: create\n");
+		test_fail = 1;
+		return;
+	}
+	fd = shm_open (owner->name, O_RDONLY, 0);
+	test_expect ("fstat", (fd >= 0) && (fstat (fd, &st) == 0), 1);
+	test_expect ("mode", st.st_mode & 0777, 0600);
+	if (fd >= 0) {
+		close (fd);
+	}
+	shm = cef_cs_shm_attach (port);
+	test_expect ("attach", shm != NULL, 1);
+	if (shm == NULL) {
+		cef_cs_shm_destroy (owner);
+		return;
+	}
+	test_expect ("lookup", test_lookup (owner, shm), sizeof ("message"));
+	test_expect ("alive", cef_cs_shm_is_alive (shm, nowt), 1);
+
+	/* A new csmgrd replaces the region, the old one is dead 	*/
+	cef_cs_shm_destroy (owner);
+	test_expect ("closed", cef_cs_shm_is_alive (shm, nowt), 0);
+	cef_cs_shm_destroy (shm);
+	owner = cef_cs_shm_create (port, CefC_Cs_Shm_Size_Min, CefC_Cs_Shm_Slot_Size_Def);
+	shm = cef_cs_shm_attach (port);
+	test_expect ("attach again", (owner != NULL) && (shm != NULL), 1);
+	if ((owner == NULL) || (shm == NULL)) {
+		cef_cs_shm_destroy (owner);
+		cef_cs_shm_destroy (shm);
+		return;
+	}
+	test_expect ("lookup again", test_lookup (owner, shm), sizeof ("message"));
+	test_expect ("alive again", cef_cs_shm_is_alive (shm, nowt), 1);
+	owner->owner_f = 0;
+	munmap (owner->map, owner->map_len);
+	free (owner);
+	owner = cef_cs_shm_create (port, CefC_Cs_Shm_Size_Min, CefC_Cs_Shm_Slot_Size_Def);
+	test_expect ("replaced (not checked yet)", cef_cs_shm_is_alive (shm, nowt), 1);
+	nowt += CefC_Cs_Shm_Check_Interval;
+	test_expect ("replaced", cef_cs_shm_is_alive (shm, nowt), 0);
+	cef_cs_shm_destroy (shm);
+	cef_cs_shm_destroy (owner);
+
+	/* csmgrd exits without closing the region, the region is dead 	*/
+	pid = fork ();
+	if (pid == 0) {
+		owner = cef_cs_shm_create (port, CefC_Cs_Shm_Size_Min, CefC_Cs_Shm_Slot_Size_Def);
+		_exit ((owner != NULL) ? 0 : 1);
+	}
+	test_expect ("child", (pid > 0) && (waitpid (pid, &status, 0) == pid) &&
+		WIFEXITED (status) && (WEXITSTATUS (status) == 0), 1);
+	shm = cef_cs_shm_attach (port);
+	test_expect ("attach crashed", shm != NULL, 1);
+	if (shm == NULL) {
+		return;
+	}
+	nowt += CefC_Cs_Shm_Check_Interval;
+	test_expect ("crashed", cef_cs_shm_is_alive (shm, nowt), 0);
+	/* Removes the region left by the child 	*/
+	shm_unlink (shm->name);
+	cef_cs_shm_destroy (shm);
+}
+#endif // CefC_Cs_Shm_Enable
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+int
+main (
+	int argc,
+	char** argv
+) {
+#ifdef CefC_Cs_Shm_Enable
+	test_run ();
+#endif // CefC_Cs_Shm_Enable
+
+	if (test_fail) {
+		return (1);
+	}
+	fprintf (stderr, "cef_cs_shm_test: OK\n");
+	return (0);
+}
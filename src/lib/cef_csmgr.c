@@ -63,6 +63,15 @@ uint32_t bchunk = 0xFFFF;
  Structures Declaration
  ****************************************************************************************/
 
+/***** Hits of a range of chunks which are not sent to csmgrd yet 	*****/
+typedef struct {
+	uint32_t 		name_off;					/* offset of the name in cefnetd_ac_buff*/
+	uint16_t 		name_len;					/* name without the chunk number		*/
+	uint32_t 		hash;
+	uint32_t 		first;						/* first chunk number of the range		*/
+	uint32_t 		last;						/* last chunk number of the range		*/
+	uint32_t 		count;						/* number of hits in the range			*/
+} CefT_Cs_Access_Rcd;
 
 /****************************************************************************************
  State Variables
@@ -72,6 +81,22 @@ static unsigned char* 	cefnetd_msg_buff 		= NULL;
 static int 				cefnetd_msg_buff_index 	= 0;
 static unsigned char* 	work_msg_buff 			= NULL;
 
+/* Interests to csmgrd are gathered into a Bulk Interest message until the 	*/
+/* cefnetd main loop calls cef_csmgr_excache_lookup_push 						*/
+static unsigned char* 	cefnetd_int_buff 		= NULL;
+static int 				cefnetd_int_buff_index 	= 0;
+static int 				cefnetd_int_num 		= 0;
+
+/* Access counts to csmgrd are gathered per content and range of chunks into 	*/
+/* a Bulk Increment message until the hits reach CefC_Csmgr_Bulk_Increment_Hits	*/
+/* or CefC_Csmgr_Bulk_Increment_Wait passes 										*/
+static CefT_Cs_Access_Rcd* 	cefnetd_ac_rcds 	= NULL;
+static unsigned char* 	cefnetd_ac_buff 		= NULL;	/* Bulk Increment message	*/
+static int 				cefnetd_ac_num 			= 0;
+static int 				cefnetd_ac_msg_len 		= 0;	/* length of the Bulk Increment	*/
+static uint32_t 		cefnetd_ac_hits 		= 0;
+static uint64_t 		cefnetd_ac_push_time 	= 0;	/* 0 if no hit is waiting		*/
+
 /****************************************************************************************
  Static Function Declaration
  ****************************************************************************************/
@@ -86,6 +111,22 @@ cef_csmgr_excache_access_increment (
 	uint32_t klen,							/* Content name length						*/
 	uint32_t chunk_num						/* Content Chunk Number 					*/
 );
+/*--------------------------------------------------------------------------------------
+	Sends the access counts which are waiting in the bulk increment buffer
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_excache_access_flush (
+	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
+);
+/*--------------------------------------------------------------------------------------
+	Searches the Cob in the region shared with the local csmgrd
+----------------------------------------------------------------------------------------*/
+static unsigned char*						/* Cob, NULL if it does not exist			*/
+cef_csmgr_excache_shm_lookup (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	CefT_CcnMsg_MsgBdy* pm,					/* Parsed CEFORE message					*/
+	uint64_t nowt							/* present time (us)						*/
+);
 /*--------------------------------------------------------------------------------------
 	Create Interest message for csmgr
 ----------------------------------------------------------------------------------------*/
@@ -318,7 +359,8 @@ cef_csmgr_stat_create (
 			pthread_t cef_mem_cache_put_th;
 			pthread_t cef_mem_cache_clear_th;
 			int rtc;
-			rtc = cef_mem_cache_init (cs_stat->cache_cap);
+			rtc = cef_mem_cache_init (cs_stat->cache_cap, cs_stat->local_cache_capacity_bytes
+									, cs_stat->local_cache_admission);
 			if(rtc != 0){
 				cef_csmgr_stat_destroy (&cs_stat);
 				cef_log_write (CefC_Log_Error
@@ -356,6 +398,37 @@ cef_csmgr_stat_create (
 		return (NULL);
 	}
 	cefnetd_msg_buff_index = 0;
+
+	if (cefnetd_int_buff) {
+		free (cefnetd_int_buff);
+	}
+	cefnetd_int_buff = malloc (sizeof (unsigned char) * CefC_Max_Length);
+	if (cefnetd_int_buff == NULL) {
+		cef_csmgr_stat_destroy (&cs_stat);
+		cef_log_write (CefC_Log_Error, "%s (alloc message buffer)\n", __func__);
+		return (NULL);
+	}
+	cefnetd_int_buff_index = CefC_Csmgr_Msg_HeaderLen + CefC_S_Length;
+	cefnetd_int_num = 0;
+
+	if (cefnetd_ac_rcds) {
+		free (cefnetd_ac_rcds);
+	}
+	if (cefnetd_ac_buff) {
+		free (cefnetd_ac_buff);
+	}
+	cefnetd_ac_rcds = (CefT_Cs_Access_Rcd*) malloc (
+		sizeof (CefT_Cs_Access_Rcd) * CefC_Csmgr_Bulk_Increment_Max);
+	cefnetd_ac_buff = malloc (sizeof (unsigned char) * CefC_Max_Length);
+	if ((cefnetd_ac_rcds == NULL) || (cefnetd_ac_buff == NULL)) {
+		cef_csmgr_stat_destroy (&cs_stat);
+		cef_log_write (CefC_Log_Error, "%s (alloc message buffer)\n", __func__);
+		return (NULL);
+	}
+	cefnetd_ac_num = 0;
+	cefnetd_ac_msg_len = CefC_Csmgr_Msg_HeaderLen + CefC_S_Length;
+	cefnetd_ac_hits = 0;
+	cefnetd_ac_push_time = 0;
 	cef_csmgr_buffer_init ();
 
 	return (cs_stat);
@@ -442,6 +515,8 @@ cef_csmgr_config_read (
 	strcpy (cs_stat->peer_id_str, CefC_Default_Node_Path);
 #ifdef CefC_CefnetdCache
 	cs_stat->local_cache_capacity = 65535;
+	cs_stat->local_cache_capacity_bytes = 0;
+	cs_stat->local_cache_admission = CefMemCacheC_Admission_None;
 	cs_stat->local_cache_interval = 60;
 #endif //CefC_CefnetdCache
 
@@ -521,6 +596,31 @@ cef_csmgr_config_read (
 			}
 			cs_stat->local_cache_capacity = res;
 		}
+		else if (strcmp (option, "LOCAL_CACHE_CAPACITY_BYTES") == 0) {
+			char *endptr = "";
+			uint64_t bytes = strtoull (value, &endptr, 0);
+			if ((strcmp (endptr, "") != 0) ||
+				((bytes != 0) && (bytes < CefC_Max_Msg_Size))) {
+				cef_log_write (CefC_Log_Error,
+					"LOCAL_CACHE_CAPACITY_BYTES must be 0 (unlimited) or greater than or equal to %d.\n"
+					, CefC_Max_Msg_Size);
+				fclose (fp);
+				return (-1);
+			}
+			cs_stat->local_cache_capacity_bytes = bytes;
+		}
+		else if (strcmp (option, "LOCAL_CACHE_ADMISSION") == 0) {
+			if (strcasecmp (value, "NONE") == 0) {
+				cs_stat->local_cache_admission = CefMemCacheC_Admission_None;
+			} else if (strcasecmp (value, "TINYLFU") == 0) {
+				cs_stat->local_cache_admission = CefMemCacheC_Admission_TinyLFU;
+			} else {
+				cef_log_write (CefC_Log_Error,
+					"LOCAL_CACHE_ADMISSION must be NONE or TINYLFU.\n");
+				fclose (fp);
+				return (-1);
+			}
+		}
 		else if (strcmp (option, "LOCAL_CACHE_INTERVAL") == 0) {
 			res = cef_csmgr_config_get_value (option, value);
 			if ((res <= 1) || (res >= 86400)) {
@@ -874,6 +974,7 @@ cef_csmgr_stat_destroy (
 			cef_mpool_destroy (stat->cs_cob_entry_mp);
 		}
 		if (stat->cache_type == CefC_Cache_Type_Excache) {
+			cef_csmgr_excache_access_flush (stat);
 			csmgr_sock_close (stat);
 		}
 #ifdef CefC_CefnetdCache
@@ -890,6 +991,12 @@ cef_csmgr_stat_destroy (
 	}
 
 	if (stat != NULL) {
+		if (stat->shm) {
+			cef_cs_shm_destroy (stat->shm);
+		}
+		if (stat->shm_cob) {
+			free (stat->shm_cob);
+		}
 		free (stat);
 		*cs_stat = NULL;
 	}
@@ -900,6 +1007,24 @@ cef_csmgr_stat_destroy (
 	}
 	cefnetd_msg_buff_index = 0;
 
+	if (cefnetd_int_buff) {
+		free (cefnetd_int_buff);
+		cefnetd_int_buff = NULL;
+	}
+	cefnetd_int_buff_index = 0;
+	cefnetd_int_num = 0;
+
+	if (cefnetd_ac_rcds) {
+		free (cefnetd_ac_rcds);
+		cefnetd_ac_rcds = NULL;
+	}
+	if (cefnetd_ac_buff) {
+		free (cefnetd_ac_buff);
+		cefnetd_ac_buff = NULL;
+	}
+	cefnetd_ac_num = 0;
+	cefnetd_ac_hits = 0;
+	cefnetd_ac_push_time = 0;
 
 	return;
 }
@@ -980,6 +1105,18 @@ cef_csmgr_cache_lookup (
 			}
 		}
 
+		/* Reads the Cob which the local csmgrd published, the Interest 	*/
+		/* whose version is specified is left to csmgrd 					*/
+		if ((pm->chunk_num_f) && (pm->org.version_f == 0)) {
+			*cob = cef_csmgr_excache_shm_lookup (
+						cs_stat, pm, cef_client_present_timeus_get ());
+			if (*cob) {
+				cef_csmgr_excache_access_increment (
+					cs_stat, pm->name, pm->name_len, pm->chunk_num);
+				return (1);
+			}
+		}
+
 	}
 #ifdef CefC_CefnetdCache
 	else if (cs_stat->cache_type == CefC_Cache_Type_Localcache){
@@ -1456,6 +1593,7 @@ cef_csmgr_excache_lookup (
 ) {
 	unsigned char buff[CefC_Max_Length];
 	uint16_t index = 0;
+	uint16_t value16;
 	int res;
 
 	if (pm->org.symbolic_f) {
@@ -1476,14 +1614,119 @@ cef_csmgr_excache_lookup (
 	/* Create Interest message 		*/
 	cef_csmgr_interest_msg_create (buff, &index, poh, pm);
 
+	if (cefnetd_int_buff == NULL) {
+		/* Send messages 				*/
+		res = cef_csmgr_send_msg_to_csmgr (cs_stat, buff, index);
+		if (res < 0) {
+			cef_log_write (CefC_Log_Warn, "%s (%s)\n", __func__, strerror (errno));
+		}
+		return;
+	}
+
+	/* The bulk buffer is full, so send it to csmgrd 	*/
+	if ((cefnetd_int_num >= CefC_Csmgr_Bulk_Interest_Max) ||
+		(cefnetd_int_buff_index + CefC_S_Length + index - CefC_Csmgr_Msg_HeaderLen
+			> CefC_Max_Length)) {
+		cef_csmgr_excache_lookup_push (cs_stat);
+	}
+
+	/* Appends the body of the Interest message 	*/
+	value16 = htons (index - CefC_Csmgr_Msg_HeaderLen);
+	memcpy (&cefnetd_int_buff[cefnetd_int_buff_index], &value16, CefC_S_Length);
+	cefnetd_int_buff_index += CefC_S_Length;
+	memcpy (&cefnetd_int_buff[cefnetd_int_buff_index],
+		&buff[CefC_Csmgr_Msg_HeaderLen], index - CefC_Csmgr_Msg_HeaderLen);
+	cefnetd_int_buff_index += index - CefC_Csmgr_Msg_HeaderLen;
+	cefnetd_int_num++;
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Sends the Interests which are waiting in the bulk lookup buffer
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_excache_lookup_push (
+	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
+) {
+	unsigned char* mp;
+	uint16_t value16;
+	int len;
+	int res;
+
+	if ((cefnetd_int_buff == NULL) || (cefnetd_int_num == 0)) {
+		return;
+	}
+
+	if (cefnetd_int_num == 1) {
+		/* Sends the single Interest message without the bulk framing. 	*/
+		/* The header overwrites the number and the length fields. 		*/
+		mp  = &cefnetd_int_buff[CefC_S_Length + CefC_S_Length];
+		len = cefnetd_int_buff_index - CefC_S_Length - CefC_S_Length;
+		mp[CefC_O_Fix_Ver]  = CefC_Version;
+		mp[CefC_O_Fix_Type] = CefC_Csmgr_Msg_Type_Interest;
+	} else {
+		mp  = cefnetd_int_buff;
+		len = cefnetd_int_buff_index;
+		mp[CefC_O_Fix_Ver]  = CefC_Version;
+		mp[CefC_O_Fix_Type] = CefC_Csmgr_Msg_Type_BulkInterest;
+		value16 = htons ((uint16_t) cefnetd_int_num);
+		memcpy (&mp[CefC_Csmgr_Msg_HeaderLen], &value16, CefC_S_Length);
+	}
+	value16 = htons ((uint16_t) len);
+	memcpy (&mp[CefC_O_Fix_PacketLength], &value16, CefC_S_Length);
+
 	/* Send messages 				*/
-	res = cef_csmgr_send_msg_to_csmgr (cs_stat, buff, index);
+	res = cef_csmgr_send_msg_to_csmgr (cs_stat, mp, len);
 	if (res < 0) {
 		cef_log_write (CefC_Log_Warn, "%s (%s)\n", __func__, strerror (errno));
 	}
 
+	cefnetd_int_buff_index = CefC_Csmgr_Msg_HeaderLen + CefC_S_Length;
+	cefnetd_int_num = 0;
+
 	return;
 }
+/*--------------------------------------------------------------------------------------
+	Sends the access counts which are waiting in the bulk increment buffer
+	if they have waited for CefC_Csmgr_Bulk_Increment_Wait
+----------------------------------------------------------------------------------------*/
+void
+cef_csmgr_excache_access_push (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	uint64_t nowt							/* present time (us)						*/
+) {
+	if ((cefnetd_ac_push_time == 0) || (nowt < cefnetd_ac_push_time)) {
+		return;
+	}
+	cef_csmgr_excache_access_flush (cs_stat);
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Parses the Bulk_Cob message which replies to the Bulk Interest
+----------------------------------------------------------------------------------------*/
+int									/* The return value is negative if an error occurs	*/
+cef_csmgr_bulk_cob_parse (
+	unsigned char* msg,						/* Bulk_Cob message (without the header)	*/
+	int msg_len,							/* length of the message					*/
+	uint16_t* num,							/* number of the Interests					*/
+	unsigned char** bitmap					/* bitmap of the Interests which missed		*/
+) {
+	uint16_t value16;
+
+	if (msg_len < CefC_S_Length) {
+		return (-1);
+	}
+	memcpy (&value16, msg, CefC_S_Length);
+	*num = ntohs (value16);
+	if ((*num == 0) || (*num > CefC_Csmgr_Bulk_Interest_Max) ||
+		(msg_len < CefC_S_Length + (*num + 7) / 8)) {
+		return (-1);
+	}
+	*bitmap = msg + CefC_S_Length;
+
+	return (0);
+}
 /*--------------------------------------------------------------------------------------
 	Get frame from received message
 ----------------------------------------------------------------------------------------*/
@@ -1972,11 +2215,15 @@ cef_csmgr_excache_access_increment (
 	uint32_t klen,							/* Content name length						*/
 	uint32_t chunk_num						/* Content Chunk Number 					*/
 ) {
-	unsigned char buff[CefC_Max_Length] = {0};
+	unsigned char buff[CefC_Max_Length];
 	uint16_t index = 0;
 	uint16_t value16;
 	uint32_t value32;
+	uint32_t hash = 2166136261U;
+	uint32_t name_len;
+	CefT_Cs_Access_Rcd* rcd;
 	int res;
+	int i;
 
 #ifdef CefC_CefnetdCache
 	if (cs_stat->cache_type == CefC_Cache_Type_Localcache){
@@ -1984,6 +2231,68 @@ cef_csmgr_excache_access_increment (
 	}
 #endif //CefC_CefnetdCache
 
+	/* Gathers the hit into the bulk increment buffer by the name without 	*/
+	/* the chunk number 														*/
+	name_len = 0;
+	if (cefnetd_ac_rcds) {
+		name_len = cef_frame_get_name_without_chunkno (
+						(unsigned char*) key, (uint16_t) klen, &value32);
+	}
+	if (name_len > 0) {
+
+		for (i = 0 ; i < name_len ; i++) {
+			hash ^= key[i];
+			hash *= 16777619U;
+		}
+
+		/* Extends the range which is adjacent to the chunk 	*/
+		for (i = 0 ; i < cefnetd_ac_num ; i++) {
+			rcd = &cefnetd_ac_rcds[i];
+			if ((rcd->hash != hash) || (rcd->name_len != name_len) ||
+				((uint64_t) chunk_num + 1 < rcd->first) ||
+				((uint64_t) chunk_num > (uint64_t) rcd->last + 1) ||
+				(memcmp (&cefnetd_ac_buff[rcd->name_off], key, name_len))) {
+				continue;
+			}
+			if (chunk_num < rcd->first) {
+				rcd->first = chunk_num;
+			}
+			if (chunk_num > rcd->last) {
+				rcd->last = chunk_num;
+			}
+			rcd->count++;
+			break;
+		}
+
+		if (i == cefnetd_ac_num) {
+			if ((cefnetd_ac_num >= CefC_Csmgr_Bulk_Increment_Max) ||
+				(cefnetd_ac_msg_len + CefC_S_Length + name_len + sizeof (uint32_t) * 3
+					> CefC_Max_Length)) {
+				cef_csmgr_excache_access_flush (cs_stat);
+			}
+			rcd = &cefnetd_ac_rcds[cefnetd_ac_num];
+			rcd->name_off = cefnetd_ac_msg_len + CefC_S_Length;
+			rcd->name_len = (uint16_t) name_len;
+			rcd->hash  = hash;
+			rcd->first = chunk_num;
+			rcd->last  = chunk_num;
+			rcd->count = 1;
+			memcpy (&cefnetd_ac_buff[rcd->name_off], key, name_len);
+			cefnetd_ac_msg_len += CefC_S_Length + name_len + sizeof (uint32_t) * 3;
+			cefnetd_ac_num++;
+		}
+
+		if (cefnetd_ac_push_time == 0) {
+			cefnetd_ac_push_time =
+				cef_client_present_timeus_get () + CefC_Csmgr_Bulk_Increment_Wait;
+		}
+		cefnetd_ac_hits++;
+		if (cefnetd_ac_hits >= CefC_Csmgr_Bulk_Increment_Hits) {
+			cef_csmgr_excache_access_flush (cs_stat);
+		}
+		return;
+	}
+
 	/* Create Upload Request message */
 	/* set header */
 	buff[CefC_O_Fix_Ver]  = CefC_Version;
@@ -2013,7 +2322,113 @@ cef_csmgr_excache_access_increment (
 
 	return;
 }
+/*--------------------------------------------------------------------------------------
+	Sends the access counts which are waiting in the bulk increment buffer
+----------------------------------------------------------------------------------------*/
+static void
+cef_csmgr_excache_access_flush (
+	CefT_Cs_Stat* cs_stat					/* Content Store status						*/
+) {
+	unsigned char* mp;
+	CefT_Cs_Access_Rcd* rcd;
+	uint16_t value16;
+	uint32_t value32;
+	int index;
+	int res;
+	int i;
+
+	if ((cefnetd_ac_rcds == NULL) || (cefnetd_ac_num == 0)) {
+		return;
+	}
+
+	/* The names are stored at their offset in the message, so the records 	*/
+	/* are built around them in place 											*/
+	mp = cefnetd_ac_buff;
+	mp[CefC_O_Fix_Ver]  = CefC_Version;
+	mp[CefC_O_Fix_Type] = CefC_Csmgr_Msg_Type_Bulk_Increment;
+	value16 = htons ((uint16_t) cefnetd_ac_num);
+	memcpy (&mp[CefC_Csmgr_Msg_HeaderLen], &value16, CefC_S_Length);
+	index = CefC_Csmgr_Msg_HeaderLen + CefC_S_Length;
+
+	for (i = 0 ; i < cefnetd_ac_num ; i++) {
+		rcd = &cefnetd_ac_rcds[i];
+		value16 = htons (rcd->name_len);
+		memcpy (&mp[index], &value16, CefC_S_Length);
+		index += CefC_S_Length + rcd->name_len;
+		value32 = htonl (rcd->first);
+		memcpy (&mp[index], &value32, sizeof (uint32_t));
+		value32 = htonl (rcd->last);
+		memcpy (&mp[index + sizeof (uint32_t)], &value32, sizeof (uint32_t));
+		value32 = htonl (rcd->count);
+		memcpy (&mp[index + sizeof (uint32_t) * 2], &value32, sizeof (uint32_t));
+		index += sizeof (uint32_t) * 3;
+	}
+	value16 = htons ((uint16_t) index);
+	memcpy (&mp[CefC_O_Fix_PacketLength], &value16, CefC_S_Length);
+
+	/* Send messages 				*/
+	res = cef_csmgr_send_msg_to_csmgr (cs_stat, mp, index);
+	if (res < 0) {
+		cef_log_write (CefC_Log_Warn, "%s (%s)\n", __func__, strerror (errno));
+	}
 
+	cefnetd_ac_num = 0;
+	cefnetd_ac_msg_len = CefC_Csmgr_Msg_HeaderLen + CefC_S_Length;
+	cefnetd_ac_hits = 0;
+	cefnetd_ac_push_time = 0;
+
+	return;
+}
+/*--------------------------------------------------------------------------------------
+	Searches the Cob in the region shared with the local csmgrd
+----------------------------------------------------------------------------------------*/
+static unsigned char*						/* Cob, NULL if it does not exist			*/
+cef_csmgr_excache_shm_lookup (
+	CefT_Cs_Stat* cs_stat,					/* Content Store status						*/
+	CefT_CcnMsg_MsgBdy* pm,					/* Parsed CEFORE message					*/
+	uint64_t nowt							/* present time (us)						*/
+) {
+	int len;
+
+	/* csmgrd has stopped or restarted, detaches the region 	*/
+	if ((cs_stat->shm) && (!cef_cs_shm_is_alive (cs_stat->shm, nowt))) {
+		cef_cs_shm_destroy (cs_stat->shm);
+		cs_stat->shm = NULL;
+		cs_stat->shm_retry_time = nowt + CefC_Cs_Shm_Retry_Interval;
+	}
+
+	/* Attaches the region if csmgrd runs on this node 	*/
+	if (cs_stat->shm == NULL) {
+		if (nowt < cs_stat->shm_retry_time) {
+			return (NULL);
+		}
+		cs_stat->shm_retry_time = nowt + CefC_Cs_Shm_Retry_Interval;
+		if ((cs_stat->local_sock == -1) &&
+			(strcmp (cs_stat->peer_id_str, "127.0.0.1") != 0) &&
+			(strcmp (cs_stat->peer_id_str, "localhost") != 0)) {
+			return (NULL);
+		}
+		if (cs_stat->shm_cob == NULL) {
+			cs_stat->shm_cob = (unsigned char*) malloc (CefC_Max_Length);
+			if (cs_stat->shm_cob == NULL) {
+				return (NULL);
+			}
+		}
+		cs_stat->shm = cef_cs_shm_attach (cs_stat->tcp_port_num);
+		if (cs_stat->shm == NULL) {
+			return (NULL);
+		}
+		cef_log_write (CefC_Log_Info,
+			"Attached the shared memory of csmgrd (%s)\n", cs_stat->shm->name);
+	}
+
+	len = cef_cs_shm_lookup (cs_stat->shm, pm->name, pm->name_len,
+				nowt, cs_stat->shm_cob, CefC_Max_Length);
+	if (len < 0) {
+		return (NULL);
+	}
+	return (cs_stat->shm_cob);
+}
 /*--------------------------------------------------------------------------------------
 	Create Interest message for csmgr
 ----------------------------------------------------------------------------------------*/
@@ -128,6 +128,66 @@ csmgr_stat_hash_number_create (
 	uint16_t klen
 );
 static void
+csmgr_stat_expiry_update (
+	CsmgrT_Stat_Table* tbl,
+	CsmgrT_Stat* rcd
+);
+static void
+csmgr_stat_record_delete (
+	CsmgrT_Stat_Table* tbl,
+	const unsigned char* name,
+	uint16_t name_len
+);
+static void
+csmgr_stat_cob_clear (
+	CsmgrT_Stat_Table* tbl,
+	CsmgrT_Stat* rcd,
+	uint32_t seq,
+	uint32_t cob_size
+);
+static int
+csmgr_stat_tier_sibling_cached (
+	CsmgrT_Stat_Table* tier,
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t seq
+);
+static void
+csmgr_stat_tier_cob_update (
+	CsmgrT_Stat_Table* tier,
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t seq,
+	uint32_t cob_size,
+	uint64_t expiry,
+	uint64_t cached_time,
+	struct in_addr node
+);
+static void
+csmgr_stat_tier_cob_remove (
+	CsmgrT_Stat_Table* tier,
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t seq,
+	uint32_t cob_size
+);
+static void
+csmgr_stat_tier_content_sync (
+	CsmgrT_Stat_Table* tier,
+	const unsigned char* name,
+	uint16_t name_len
+);
+static void
+csmgr_stat_tier_version_sync (
+	CsmgrT_Stat_Table* tier,
+	const unsigned char* name,
+	uint16_t name_len
+);
+static void
+csmgr_stat_tier_bytes_sync (
+	CsmgrT_Stat_Table* tier
+);
+static void
 csmgr_stat_decoder_from_data(
 	EVP_PKEY **pkey,
 	const unsigned char *pubkey,
@@ -143,10 +203,6 @@ csmgr_verify_sig_of_buff(
 	size_t sig_len
 );
 
-/****************************************************************************************
- ****************************************************************************************/
-static int				stat_index_mngr[CsmgrT_Stat_Max];
-
 /*--------------------------------------------------------------------------------------
 	Creates the Csmgr Stat Handle
 ----------------------------------------------------------------------------------------*/
@@ -165,7 +221,15 @@ csmgr_stat_handle_create (
 	tbl->rcds = (CsmgrT_Stat**) malloc (sizeof (CsmgrT_Stat*) * CsmgrT_Stat_Max);
 	memset (tbl->rcds, 0, sizeof (CsmgrT_Stat*) * CsmgrT_Stat_Max);
 
-	memset (stat_index_mngr, 0, sizeof (int)*CsmgrT_Stat_Max);
+	tbl->index_mngr = (unsigned char*) calloc (CsmgrT_Stat_Max, sizeof (unsigned char));
+	tbl->expiry_heap = cef_expiry_heap_create ();
+	if ((tbl->index_mngr == NULL) || (tbl->expiry_heap == NULL)) {
+		cef_expiry_heap_destroy (tbl->expiry_heap);
+		free (tbl->index_mngr);
+		free (tbl->rcds);
+		free (tbl);
+		return (CsmgrC_Invalid);
+	}
 
 	/* Init csmgr_stat_mutex for recursive */
     pthread_mutexattr_t attr ;
@@ -183,6 +247,65 @@ csmgr_stat_handle_create (
 	return ((CsmgrT_Stat_Handle) tbl);
 }
 
+/*--------------------------------------------------------------------------------------
+	Creates the Csmgr Stat Handle of a tier which mirrors to the specified handle
+----------------------------------------------------------------------------------------*/
+CsmgrT_Stat_Handle
+csmgr_stat_tier_handle_create (
+	CsmgrT_Stat_Handle parent_hdl
+) {
+	CsmgrT_Stat_Table* parent = (CsmgrT_Stat_Table*) parent_hdl;
+	CsmgrT_Stat_Table* tbl;
+	pthread_mutexattr_t attr;
+
+	if ((parent == NULL) || (parent->parent != NULL)) {
+		return (CsmgrC_Invalid);
+	}
+	tbl = (CsmgrT_Stat_Table*) calloc (1, sizeof (CsmgrT_Stat_Table));
+	if (tbl == NULL) {
+		return (CsmgrC_Invalid);
+	}
+	tbl->rcds = (CsmgrT_Stat**) calloc (CsmgrT_Stat_Max, sizeof (CsmgrT_Stat*));
+	tbl->index_mngr = (unsigned char*) calloc (CsmgrT_Stat_Max, sizeof (unsigned char));
+	tbl->expiry_heap = cef_expiry_heap_create ();
+	if ((tbl->rcds == NULL) || (tbl->index_mngr == NULL) || (tbl->expiry_heap == NULL)) {
+		cef_expiry_heap_destroy (tbl->expiry_heap);
+		free (tbl->index_mngr);
+		free (tbl->rcds);
+		free (tbl);
+		return (CsmgrC_Invalid);
+	}
+
+	/* Each tier has its own index pool and mutex, the index of a record is only 	*/
+	/* unique within its table (e.g. fsc uses it as the directory of the content) 	*/
+	if ((pthread_mutexattr_init (&attr) != 0) ||
+		(pthread_mutexattr_settype (&attr, PTHREAD_MUTEX_RECURSIVE) != 0) ||
+		(pthread_mutex_init (&tbl->stat_mutex, &attr) != 0)) {
+		cef_expiry_heap_destroy (tbl->expiry_heap);
+		free (tbl->index_mngr);
+		free (tbl->rcds);
+		free (tbl);
+		return (CsmgrC_Invalid);
+	}
+
+	pthread_mutex_lock (&parent->stat_mutex);
+	if (parent->tier_num == CsmgrT_Tier_Max) {
+		pthread_mutex_unlock (&parent->stat_mutex);
+		pthread_mutex_destroy (&tbl->stat_mutex);
+		cef_expiry_heap_destroy (tbl->expiry_heap);
+		free (tbl->index_mngr);
+		free (tbl->rcds);
+		free (tbl);
+		return (CsmgrC_Invalid);
+	}
+	parent->tiers[parent->tier_num] = tbl;
+	parent->tier_num++;
+	tbl->parent = parent;
+	pthread_mutex_unlock (&parent->stat_mutex);
+
+	return ((CsmgrT_Stat_Handle) tbl);
+}
+
 /*--------------------------------------------------------------------------------------
 	Destroy the Csmgr Stat Handle
 ----------------------------------------------------------------------------------------*/
@@ -191,24 +314,44 @@ csmgr_stat_handle_destroy (
 	CsmgrT_Stat_Handle hdl
 ) {
 	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+	CsmgrT_Stat_Table* parent;
 	int i;
 
 	if (tbl == NULL) {
 		return;
 	}
+	/* Stops mirroring to the parent 	*/
+	parent = tbl->parent;
+	if (parent) {
+		pthread_mutex_lock (&parent->stat_mutex);
+		for (i = 0 ; i < parent->tier_num ; i++) {
+			if (parent->tiers[i] == tbl) {
+				parent->tier_num--;
+				parent->tiers[i] = parent->tiers[parent->tier_num];
+				parent->tiers[parent->tier_num] = NULL;
+				break;
+			}
+		}
+		pthread_mutex_unlock (&parent->stat_mutex);
+	}
 	for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
 		CsmgrT_Stat* cp;
 		CsmgrT_Stat* wcp;
 		cp = tbl->rcds[i];
 		while (cp != NULL) {
 			wcp = cp->next;
-		   	stat_index_mngr[cp->index] = 0;
-				free (cp->cob_map);
+		   	tbl->index_mngr[cp->index] = 0;
+				cef_chunk_set_clear (&cp->cob_set);
 			free (cp);
 			cp = wcp;
 		}
 	}
+	cef_expiry_heap_destroy (tbl->expiry_heap);
+	free (tbl->index_mngr);
 	free (tbl->rcds);
+	if (parent) {
+		pthread_mutex_destroy (&tbl->stat_mutex);
+	}
 	free (tbl);
 
 	return;
@@ -310,8 +453,6 @@ csmgr_stat_content_info_get (
 	CsmgrT_Stat* rcd = NULL;
 	uint32_t min_seq = 0;
 	uint32_t max_seq = 0;
-	uint32_t i, n;
-	uint64_t mask;
 	uint64_t nowt;
 	struct timeval tv;
 
@@ -331,32 +472,9 @@ csmgr_stat_content_info_get (
 			return (NULL);
 		}
 
-		for (i = 0 ; i < rcd->map_max ; i++) {
-			if (rcd->cob_map[i]) {
-				mask = 0x0000000000000001;
-				for (n = 0 ; n < 64 ; n++) {
-					if (rcd->cob_map[i] & mask) {
-						min_seq = i * 64 + n;
-						break;
-					}
-					mask <<= 1;
-				}
-				break;
-			}
-		}
-		for (i = rcd->map_max - 1 ; i >= 0 ; i--) {
-			if (rcd->cob_map[i]) {
-				mask = 0x8000000000000000;
-				for (n = 0 ; n < 64 ; n++) {
-					if (rcd->cob_map[i] & mask) {
-						max_seq = i * 64 + (64 - n) - 1;
-						break;
-					}
-					mask >>= 1;
-				}
-				break;
-			}
-		}
+		min_seq = 0;
+		max_seq = 0;
+		cef_chunk_set_min_max (&rcd->cob_set, &min_seq, &max_seq);
 		rcd->min_seq = min_seq;
 		rcd->max_seq = max_seq;
 	}
@@ -380,8 +498,6 @@ csmgr_stat_content_info_gets (
 
 	uint32_t min_seq = 0;
 	uint32_t max_seq = 0 /*@@@= CsmgrT_Stat_Seq_Max @@@*/;
-	uint32_t i, n;
-	uint64_t mask;
 	int index = 0;
 	int num = 0;
 	uint64_t nowt;
@@ -413,32 +529,9 @@ csmgr_stat_content_info_gets (
 			pthread_mutex_unlock (&tbl->stat_mutex);
 			return (0);
 		}
-		for (i = 0 ; i < rcd->map_max ; i++) {
-			if (rcd->cob_map[i]) {
-				mask = 0x0000000000000001;
-				for (n = 0 ; n < 64 ; n++) {
-					if (rcd->cob_map[i] & mask) {
-						min_seq = i * 64 + n;
-						break;
-					}
-					mask <<= 1;
-				}
-				break;
-			}
-		}
-		for (i = rcd->map_max - 1 ; i >= 0 ; i--) {
-			if (rcd->cob_map[i]) {
-				mask = 0x8000000000000000;
-				for (n = 0 ; n < 64 ; n++) {
-					if (rcd->cob_map[i] & mask) {
-						max_seq = i * 64 + (64 - n) - 1;
-						break;
-					}
-					mask >>= 1;
-				}
-				break;
-			}
-		}
+		min_seq = 0;
+		max_seq = 0;
+		cef_chunk_set_min_max (&rcd->cob_set, &min_seq, &max_seq);
 		rcd->min_seq = min_seq;
 		rcd->max_seq = max_seq;
 
@@ -464,32 +557,9 @@ csmgr_stat_content_info_gets (
 			continue;
 		}
 
-		for (i = 0 ; i < rcd->map_max ; i++) {
-			if (rcd->cob_map[i]) {
-				mask = 0x0000000000000001;
-				for (n = 0 ; n < 64 ; n++) {
-					if (rcd->cob_map[i] & mask) {
-						min_seq = i * 64 + n;
-						break;
-					}
-					mask <<= 1;
-				}
-				break;
-			}
-		}
-		for (i = rcd->map_max - 1 ; i >= 0 ; i--) {
-			if (rcd->cob_map[i]) {
-				mask = 0x8000000000000000;
-				for (n = 0 ; n < 64 ; n++) {
-					if (rcd->cob_map[i] & mask) {
-						max_seq = i * 64 + (64 - n) - 1;
-						break;
-					}
-					mask >>= 1;
-				}
-				break;
-			}
-		}
+		min_seq = 0;
+		max_seq = 0;
+		cef_chunk_set_min_max (&rcd->cob_set, &min_seq, &max_seq);
 		rcd->min_seq = min_seq;
 		rcd->max_seq = max_seq;
 
@@ -559,32 +629,45 @@ csmgr_stat_expired_content_info_get (
 	uint16_t module_name
 ) {
 	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+	CsmgrT_Stat* cp;
 	uint64_t nowt;
 	struct timeval tv;
-	int i;
 
 	if (!tbl) {
 		return (0);
 	}
-	gettimeofday (&tv, NULL);
-	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
 
 	pthread_mutex_lock (&tbl->stat_mutex);
-	for (i = *index ; i < CsmgrT_Stat_Max ; i++) {
-		CsmgrT_Stat* cp;
-		cp = tbl->rcds[i];
-		while (cp != NULL) {
-			if ((cp->expiry != 0 && nowt > cp->expiry)
-				|| ((module_name == CsmgrT_IM_CSMGRD)
-					&& (is_check_pending_timer_status (cp->ucinc_stat) && (nowt > cp->pending_timer)))) {
-				if (cp->next == NULL) {
-					*index += 1;
-				}
-				cp->expire_f = 1;
-				pthread_mutex_unlock (&tbl->stat_mutex);
-				return (cp);
-			}
-			cp = cp->next;
+	if (*index == 0) {
+		/* Starts the scan, the records which expire after this time are left 	*/
+		/* to the next scan 													*/
+		gettimeofday (&tv, NULL);
+		tbl->expiry_scan_t = tv.tv_sec * 1000000llu + tv.tv_usec;
+		*index = 1;
+	}
+	nowt = tbl->expiry_scan_t;
+
+	/* Only the expired records are visited, in order of the expiry time 	*/
+	while ((cp = (CsmgrT_Stat*)
+			cef_expiry_heap_expired_peek (tbl->expiry_heap, nowt)) != NULL) {
+		if ((cp->expiry != 0 && nowt > cp->expiry)
+			|| ((module_name == CsmgrT_IM_CSMGRD)
+				&& (is_check_pending_timer_status (cp->ucinc_stat) && (nowt > cp->pending_timer)))) {
+			/* The caller usually deletes the record, otherwise it is 	*/
+			/* returned again in the next scan 							*/
+			cef_expiry_heap_set (tbl->expiry_heap, cp, &cp->expiry_pos, nowt);
+			cp->expire_f = 1;
+			pthread_mutex_unlock (&tbl->stat_mutex);
+			return (cp);
+		}
+		/* The pending timer is not checked by this module, so the record 	*/
+		/* is visited again only when it expires 							*/
+		if (cp->expiry == 0) {
+			cef_expiry_heap_set (tbl->expiry_heap, cp, &cp->expiry_pos,
+				CefC_Expiry_Heap_Never);
+		} else {
+			cef_expiry_heap_set (tbl->expiry_heap, cp, &cp->expiry_pos,
+				(cp->expiry > nowt) ? cp->expiry : nowt);
 		}
 	}
 	pthread_mutex_unlock (&tbl->stat_mutex);
@@ -607,8 +690,7 @@ csmgr_stat_cob_update (
 ) {
 	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
 	CsmgrT_Stat* rcd;
-	uint64_t mask = 1;
-	uint32_t x;
+	int add_f;
 	int create_f = 0;
 
 	if (!tbl) {
@@ -621,26 +703,10 @@ csmgr_stat_cob_update (
 		pthread_mutex_unlock (&tbl->stat_mutex);
 		return;
 	}
-	x = seq / 64;
-	mask <<= (seq % 64);
-
-	if ((rcd->map_max-1) < x) {
-		char *ptr;
-		uint32_t map_bsize;
-		map_bsize = x / CsmgrT_Add_Maps;
-		if (x % CsmgrT_Add_Maps != 0) {
-			map_bsize ++;
-		}
-		map_bsize = CsmgrT_Add_Maps + map_bsize * CsmgrT_Add_Maps;
-		ptr = calloc (1, sizeof (uint64_t) * map_bsize);
-		if (ptr == NULL) {
-			pthread_mutex_unlock (&tbl->stat_mutex);
-			return;
-		}
-		memcpy (ptr, rcd->cob_map, sizeof (uint64_t) * rcd->map_max);
-		free (rcd->cob_map);
-		rcd->cob_map = (uint64_t *) ptr;
-		rcd->map_max = map_bsize;
+	add_f = cef_chunk_set_add (&rcd->cob_set, seq);
+	if (add_f < 0) {
+		pthread_mutex_unlock (&tbl->stat_mutex);
+		return;
 	}
 
 	if (create_f) {
@@ -679,14 +745,14 @@ csmgr_stat_cob_update (
 	}
 	if (rcd->expiry < expiry) {
 		rcd->expiry = expiry;
+		csmgr_stat_expiry_update (tbl, rcd);
 	}
 
-	if (!(rcd->cob_map[x] & mask)) {
+	if (add_f > 0) {
 		rcd->cob_num++;
 		rcd->con_size += cob_size;
 		tbl->cached_cob_num++;
 	}
-	rcd->cob_map[x] |= mask;
 
 #ifdef _CS_COB_NUM //@@@@@+++++ Show cached_cob_num status +++++
 {
@@ -699,6 +765,11 @@ csmgr_stat_cob_update (
 #endif //CS_COB_NUM //@@@@@----- Show cached_cob_num status -----
 
 	pthread_mutex_unlock (&tbl->stat_mutex);
+
+	if (tbl->parent) {
+		csmgr_stat_tier_cob_update (
+			tbl, name, name_len, seq, cob_size, expiry, cached_time, node);
+	}
 	return;
 }
 /*--------------------------------------------------------------------------------------
@@ -714,8 +785,7 @@ csmgr_stat_cob_remove (
 ) {
 	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
 	CsmgrT_Stat* rcd;
-	uint64_t mask = 1;
-	uint32_t x;
+	int res = -1;
 
 
 	pthread_mutex_lock (&tbl->stat_mutex);
@@ -725,36 +795,78 @@ csmgr_stat_cob_remove (
 		return (-1);
 	}
 
-	x = seq / 64;
-	mask <<= (seq % 64);
+	if (!cef_chunk_set_contains (&rcd->cob_set, seq)) {
+		pthread_mutex_unlock (&tbl->stat_mutex);
+		return (-1);
+	}
+	csmgr_stat_cob_clear (tbl, rcd, seq, cob_size);
 
-	if (cob_size == 0) {
-		if (seq == rcd->last_chunk_num) {
-			cob_size = rcd->last_cob_size;
-		} else {
-			cob_size = rcd->cob_size;
-		}
+	if (rcd->cob_num == 0) {
+		csmgr_stat_record_delete (tbl, name, name_len);
+		res = 0;
 	}
+	pthread_mutex_unlock (&tbl->stat_mutex);
 
-	if ((rcd->map_max-1) < x) {
-		pthread_mutex_unlock (&tbl->stat_mutex);
-		return (-1);
+	if (tbl->parent) {
+		csmgr_stat_tier_cob_remove (tbl, name, name_len, seq, cob_size);
 	}
-	if (rcd->cob_map[x] & mask) {
-		rcd->cob_num--;
-		rcd->con_size -= cob_size;
-		tbl->cached_cob_num--;
+	return (res);
+}
+/*--------------------------------------------------------------------------------------
+	Checks whether the specified Cob is cached
+----------------------------------------------------------------------------------------*/
+int 								/* Returns 1 if the Cob is cached					*/
+csmgr_stat_cob_is_cached (
+	CsmgrT_Stat_Handle hdl,
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t seq
+) {
+	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+	CsmgrT_Stat* rcd;
+	int res = 0;
+
+	if (!tbl) {
+		return (0);
 	}
-	rcd->cob_map[x] &= ~mask;
 
-	if (rcd->cob_num == 0) {
-		csmgrd_stat_content_info_delete (hdl, name, name_len);
-		pthread_mutex_unlock (&tbl->stat_mutex);
+	pthread_mutex_lock (&tbl->stat_mutex);
+	rcd = csmgr_stat_content_search (tbl, name, name_len);
+	if ((rcd) && (cef_chunk_set_contains (&rcd->cob_set, seq))) {
+		res = 1;
+	}
+	pthread_mutex_unlock (&tbl->stat_mutex);
+
+	return (res);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the first range of the contiguous cached Cobs from the specified Cob
+----------------------------------------------------------------------------------------*/
+int 								/* Returns 1 if the range is found					*/
+csmgr_stat_cob_range_get (
+	CsmgrT_Stat_Handle hdl,
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t from,
+	uint32_t* first,
+	uint32_t* last
+) {
+	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+	CsmgrT_Stat* rcd;
+	int res = 0;
+
+	if (!tbl) {
 		return (0);
 	}
 
+	pthread_mutex_lock (&tbl->stat_mutex);
+	rcd = csmgr_stat_content_search (tbl, name, name_len);
+	if (rcd) {
+		res = cef_chunk_set_range_next (&rcd->cob_set, from, first, last);
+	}
 	pthread_mutex_unlock (&tbl->stat_mutex);
-	return (-1);
+
+	return (res);
 }
 /*--------------------------------------------------------------------------------------
 	Update access count
@@ -764,6 +876,20 @@ csmgr_stat_access_count_update (
 	CsmgrT_Stat_Handle hdl,
 	const unsigned char* name,
 	uint16_t name_len
+) {
+	csmgr_stat_access_count_add (hdl, name, name_len, 1);
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Adds the number of hits to access count
+----------------------------------------------------------------------------------------*/
+void
+csmgr_stat_access_count_add (
+	CsmgrT_Stat_Handle hdl,
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t count								/* number of hits						*/
 ) {
 	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
 	CsmgrT_Stat* rcd;
@@ -778,11 +904,17 @@ csmgr_stat_access_count_update (
 		pthread_mutex_unlock (&tbl->stat_mutex);
 		return;
 	}
-	if (rcd->access < UINT64_MAX) {
-		rcd->access++;
+	if (rcd->access < UINT64_MAX - count) {
+		rcd->access += count;
+	} else {
+		rcd->access = UINT64_MAX;
 	}
 	pthread_mutex_unlock (&tbl->stat_mutex);
 
+	if (tbl->parent) {
+		csmgr_stat_access_count_add (
+			(CsmgrT_Stat_Handle) tbl->parent, name, name_len, count);
+	}
 	return;
 }
 
@@ -832,14 +964,15 @@ csmgr_stat_cache_capacity_update (
 	}
 
 	pthread_mutex_lock (&tbl->stat_mutex);
+	cef_expiry_heap_clear (tbl->expiry_heap);
 	for (i = 0 ; i < CsmgrT_Stat_Max ; i++) {
 		CsmgrT_Stat* cp;
 		CsmgrT_Stat* wcp;
 		cp = tbl->rcds[i];
 		while (cp != NULL) {
 			wcp = cp->next;
-		   	stat_index_mngr[cp->index] = 0;
-			free (cp->cob_map);
+		   	tbl->index_mngr[cp->index] = 0;
+			cef_chunk_set_clear (&cp->cob_set);
 			free (cp);
 			cp = wcp;
 		}
@@ -851,11 +984,78 @@ csmgr_stat_cache_capacity_update (
 	tbl->cached_con_num = 0;
 	tbl->capacity = capacity;
 	tbl->cached_cob_num = 0;
+	tbl->cached_bytes = 0;
+	pthread_mutex_unlock (&tbl->stat_mutex);
+
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Sets cache capacity without clearing the cached records
+----------------------------------------------------------------------------------------*/
+void
+csmgr_stat_cache_capacity_set (
+	CsmgrT_Stat_Handle hdl,
+	uint64_t capacity
+) {
+	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+
+	if (!tbl) {
+		return;
+	}
+
+	pthread_mutex_lock (&tbl->stat_mutex);
+	tbl->capacity = capacity;
+	pthread_mutex_unlock (&tbl->stat_mutex);
+
+	return;
+}
+
+/*--------------------------------------------------------------------------------------
+	Update cache capacity in bytes
+----------------------------------------------------------------------------------------*/
+void
+csmgr_stat_cache_capacity_bytes_update (
+	CsmgrT_Stat_Handle hdl,
+	uint64_t capacity_bytes						/* byte budget (0 means unlimited)		*/
+) {
+	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+
+	if (!tbl) {
+		return;
+	}
+
+	pthread_mutex_lock (&tbl->stat_mutex);
+	tbl->capacity_bytes = capacity_bytes;
 	pthread_mutex_unlock (&tbl->stat_mutex);
 
 	return;
 }
 
+/*--------------------------------------------------------------------------------------
+	Update the total size of cached Cobs
+----------------------------------------------------------------------------------------*/
+void
+csmgr_stat_cached_bytes_update (
+	CsmgrT_Stat_Handle hdl,
+	uint64_t cached_bytes						/* total of the message length			*/
+) {
+	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+
+	if (!tbl) {
+		return;
+	}
+
+	pthread_mutex_lock (&tbl->stat_mutex);
+	tbl->cached_bytes = cached_bytes;
+	pthread_mutex_unlock (&tbl->stat_mutex);
+
+	if (tbl->parent) {
+		csmgr_stat_tier_bytes_sync (tbl);
+	}
+	return;
+}
+
 /*--------------------------------------------------------------------------------------
 	Update content expire time
 ----------------------------------------------------------------------------------------*/
@@ -879,8 +1079,13 @@ csmgr_stat_content_lifetime_update (
 		return;
 	}
 	rcd->expiry = expiry;
+	csmgr_stat_expiry_update (tbl, rcd);
 	pthread_mutex_unlock (&tbl->stat_mutex);
 
+	if (tbl->parent) {
+		csmgr_stat_content_lifetime_update (
+			(CsmgrT_Stat_Handle) tbl->parent, name, name_len, expiry);
+	}
 	return;
 }
 /*--------------------------------------------------------------------------------------
@@ -915,6 +1120,44 @@ csmgr_stat_content_info_init (
 
 	return (rcd);
 }
+/*--------------------------------------------------------------------------------------
+	Init the valiables of the specified content with the index which was used
+	before the restart. Returns NULL if the index is already used.
+----------------------------------------------------------------------------------------*/
+CsmgrT_Stat*
+csmgr_stat_content_info_restore (
+	CsmgrT_Stat_Handle hdl,
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t index
+) {
+	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+	CsmgrT_Stat* rcd;
+	int create_f = 0;
+
+	if ((!tbl) || (index >= CsmgrT_Stat_Max)) {
+		return (NULL);
+	}
+
+	pthread_mutex_lock (&tbl->stat_mutex);
+	if ((tbl->index_mngr[index]) || (csmgr_stat_content_search (tbl, name, name_len))) {
+		pthread_mutex_unlock (&tbl->stat_mutex);
+		return (NULL);
+	}
+	rcd = csmgr_stat_content_lookup (tbl, name, name_len, &create_f);
+	if (!rcd) {
+		pthread_mutex_unlock (&tbl->stat_mutex);
+		return (NULL);
+	}
+	/* Moves the record to the specified index 	*/
+	tbl->index_mngr[rcd->index] = 0;
+	tbl->index_mngr[index] = 1;
+	rcd->index = index;
+	tbl->cached_con_num++;
+	pthread_mutex_unlock (&tbl->stat_mutex);
+
+	return (rcd);
+}
 /*--------------------------------------------------------------------------------------
 	Init the valiables of the specified content (for version)
 ----------------------------------------------------------------------------------------*/
@@ -926,6 +1169,8 @@ csmgr_stat_content_info_version_init (
 	uint16_t ver_len
 ) {
 	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+	unsigned char name[CefC_Max_Length];
+	uint16_t name_len;
 
 	pthread_mutex_lock (&tbl->stat_mutex);
 	rcd->ver_len = ver_len;
@@ -939,7 +1184,14 @@ csmgr_stat_content_info_version_init (
 	} else {
 		rcd->version = NULL;
 	}
+	/* The record may be deleted after the table is unlocked 	*/
+	name_len = rcd->name_len;
+	memcpy (name, rcd->name, name_len);
 	pthread_mutex_unlock (&tbl->stat_mutex);
+
+	if (tbl->parent) {
+		csmgr_stat_tier_version_sync (tbl, name, name_len);
+	}
 	return (1);
 }
 /*--------------------------------------------------------------------------------------
@@ -952,65 +1204,18 @@ csmgr_stat_content_info_delete (
 	uint16_t name_len
 ) {
 	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
-	CsmgrT_Stat* cp;
-	CsmgrT_Stat* wcp;
-	uint32_t hash;
-	uint32_t index;
 
 	if (!tbl) {
 		return;
 	}
 
 	pthread_mutex_lock (&tbl->stat_mutex);
-	hash = csmgr_stat_hash_number_create (name, name_len);
-	index = hash % CsmgrT_Stat_Max;
-
-	cp = tbl->rcds[index];
-	if (cp == NULL) {
-		pthread_mutex_unlock (&tbl->stat_mutex);
-		return;
-	}
-	if (cp != NULL) {
-		if ((cp->name_len == name_len) &&
-			(memcmp (cp->name, name, name_len) == 0)) {
-			tbl->rcds[index] = cp->next;
-			tbl->cached_con_num--;
-			stat_index_mngr[cp->index] = 0;
-			free (cp->cob_map);
-			if (cp->version != NULL && cp->ver_len > 0) {
-				free (cp->version);
-			}
-			if (cp->ssl_public_key_val != NULL && cp->ssl_public_key_len > 0) {
-				free (cp->ssl_public_key_val);
-			}
-			free (cp);
-			pthread_mutex_unlock (&tbl->stat_mutex);
-			return;
-		} else {
-			cp = tbl->rcds[index];
-			for (; cp->next != NULL; cp = cp->next) {
-				if ((cp->next->name_len == name_len) &&
-					(memcmp (cp->next->name, name, name_len) == 0)) {
-					wcp = cp->next;
-					cp->next = cp->next->next;
-					tbl->cached_con_num--;
-					stat_index_mngr[wcp->index] = 0;
-					free (wcp->cob_map);
-					if (wcp->version != NULL && wcp->ver_len > 0) {
-						free (wcp->version);
-					}
-					if (wcp->ssl_public_key_val != NULL && wcp->ssl_public_key_len > 0) {
-						free (wcp->ssl_public_key_val);
-					}
-					free (wcp);
-					pthread_mutex_unlock (&tbl->stat_mutex);
-					return;
-				}
-			}
-		}
-	}
+	csmgr_stat_record_delete (tbl, name, name_len);
 	pthread_mutex_unlock (&tbl->stat_mutex);
 
+	if (tbl->parent) {
+		csmgr_stat_tier_content_sync (tbl, name, name_len);
+	}
 	return;
 }
 /*--------------------------------------------------------------------------------------
@@ -1056,6 +1261,36 @@ csmgr_stat_cache_capacity_get (
 	}
 	return (tbl->capacity);
 }
+
+/*--------------------------------------------------------------------------------------
+	Obtains the Cache capacity in bytes
+----------------------------------------------------------------------------------------*/
+uint64_t
+csmgr_stat_cache_capacity_bytes_get (
+	CsmgrT_Stat_Handle hdl
+) {
+	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+
+	if (!tbl) {
+		return (0);
+	}
+	return (tbl->capacity_bytes);
+}
+
+/*--------------------------------------------------------------------------------------
+	Obtains the total size of cached Cobs
+----------------------------------------------------------------------------------------*/
+uint64_t
+csmgr_stat_cached_bytes_get (
+	CsmgrT_Stat_Handle hdl
+) {
+	CsmgrT_Stat_Table* tbl = (CsmgrT_Stat_Table*) hdl;
+
+	if (!tbl) {
+		return (0);
+	}
+	return (tbl->cached_bytes);
+}
 /*--------------------------------------------------------------------------------------
 	Obtain the content information for publisher
 ----------------------------------------------------------------------------------------*/
@@ -1198,6 +1433,7 @@ csmgr_stat_cob_update_for_pub (
 	}
 	if (rcd->expiry < expiry) {
 		rcd->expiry = expiry;
+		csmgr_stat_expiry_update (tbl, rcd);
 	}
 	rcd->cob_num++;
 	rcd->con_size += cob_size;
@@ -1319,6 +1555,7 @@ csmgr_stat_content_ucinc_stat_update (
 		return;
 	}
 	rcd->ucinc_stat = ucinc_stat;
+	csmgr_stat_expiry_update (tbl, rcd);
 	pthread_mutex_unlock (&tbl->stat_mutex);
 
 	return;
@@ -1347,6 +1584,7 @@ csmgr_stat_content_pending_timer_update (
 		return;
 	}
 	rcd->pending_timer = pending_timer;
+	csmgr_stat_expiry_update (tbl, rcd);
 	pthread_mutex_unlock (&tbl->stat_mutex);
 
 	return;
@@ -1466,11 +1704,10 @@ csmgr_stat_content_lookup (
 		cp->tx_seq = 0;
 		cp->tx_num = -1;
 		cp->tx_time = 0;
-		cp->cob_map = (uint64_t *) calloc (1, sizeof (uint64_t) * CsmgrT_Add_Maps);
-		cp->map_max = CsmgrT_Add_Maps;
+		cef_chunk_set_init (&cp->cob_set);
 		for (int i=0; i<CsmgrT_Stat_Max; i++) {
-			if (stat_index_mngr[i] == 0) {
-				stat_index_mngr[i] = 1;
+			if (tbl->index_mngr[i] == 0) {
+				tbl->index_mngr[i] = 1;
 				cp->index = i;
 				break;
 			}
@@ -1496,11 +1733,10 @@ csmgr_stat_content_lookup (
 		cp->tx_seq = 0;
 		cp->tx_num = -1;
 		cp->tx_time = 0;
-		cp->cob_map = (uint64_t *) calloc (1, sizeof (uint64_t) * CsmgrT_Add_Maps/*@*/);
-		cp->map_max = CsmgrT_Add_Maps;
+		cef_chunk_set_init (&cp->cob_set);
 		for (int i=0; i<CsmgrT_Stat_Max; i++) {
-			if (stat_index_mngr[i] == 0) {
-				stat_index_mngr[i] = 1;
+			if (tbl->index_mngr[i] == 0) {
+				tbl->index_mngr[i] = 1;
 				cp->index = i;
 				break;
 			}
@@ -1691,3 +1927,282 @@ END:
     return ret_verify;
 }
 
+/*--------------------------------------------------------------------------------------
+	Updates the position of the record in the expiry heap
+----------------------------------------------------------------------------------------*/
+static void
+csmgr_stat_expiry_update (
+	CsmgrT_Stat_Table* tbl,
+	CsmgrT_Stat* rcd
+) {
+	uint64_t key = CefC_Expiry_Heap_Never;
+
+	if (rcd->expiry != 0) {
+		key = rcd->expiry;
+	}
+	if (is_check_pending_timer_status (rcd->ucinc_stat) && (rcd->pending_timer < key)) {
+		key = rcd->pending_timer;
+	}
+	if (cef_expiry_heap_set (tbl->expiry_heap, rcd, &rcd->expiry_pos, key) < 0) {
+		cef_log_write (CefC_Log_Warn, "%s (expiry heap is full)\n", __func__);
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Deletes the record of the content (the caller holds stat_mutex)
+----------------------------------------------------------------------------------------*/
+static void
+csmgr_stat_record_delete (
+	CsmgrT_Stat_Table* tbl,
+	const unsigned char* name,
+	uint16_t name_len
+) {
+	CsmgrT_Stat** pp;
+	CsmgrT_Stat* cp;
+	uint32_t hash;
+
+	hash = csmgr_stat_hash_number_create (name, name_len);
+
+	for (pp = &tbl->rcds[hash % CsmgrT_Stat_Max] ; *pp != NULL ; pp = &(*pp)->next) {
+		cp = *pp;
+		if ((cp->name_len == name_len) &&
+			(memcmp (cp->name, name, name_len) == 0)) {
+			*pp = cp->next;
+			tbl->cached_con_num--;
+			tbl->index_mngr[cp->index] = 0;
+			cef_expiry_heap_remove (tbl->expiry_heap, &cp->expiry_pos);
+			cef_chunk_set_clear (&cp->cob_set);
+			if (cp->version != NULL && cp->ver_len > 0) {
+				free (cp->version);
+			}
+			if (cp->ssl_public_key_val != NULL && cp->ssl_public_key_len > 0) {
+				free (cp->ssl_public_key_val);
+			}
+			free (cp);
+			return;
+		}
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Removes the Cob from the record (the caller holds stat_mutex)
+----------------------------------------------------------------------------------------*/
+static void
+csmgr_stat_cob_clear (
+	CsmgrT_Stat_Table* tbl,
+	CsmgrT_Stat* rcd,
+	uint32_t seq,
+	uint32_t cob_size
+) {
+	if (cob_size == 0) {
+		if (seq == rcd->last_chunk_num) {
+			cob_size = rcd->last_cob_size;
+		} else {
+			cob_size = rcd->cob_size;
+		}
+	}
+	if (cef_chunk_set_remove (&rcd->cob_set, seq) > 0) {
+		rcd->cob_num--;
+		rcd->con_size -= cob_size;
+		tbl->cached_cob_num--;
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Checks whether a tier other than the specified one caches the Cob.
+	The caller holds stat_mutex of the parent, the locks are taken in the order
+	of the parent and the tier.
+----------------------------------------------------------------------------------------*/
+static int
+csmgr_stat_tier_sibling_cached (
+	CsmgrT_Stat_Table* tier,
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t seq
+) {
+	CsmgrT_Stat_Table* parent = tier->parent;
+	int i;
+
+	for (i = 0 ; i < parent->tier_num ; i++) {
+		if (parent->tiers[i] == tier) {
+			continue;
+		}
+		if (csmgr_stat_cob_is_cached (
+				(CsmgrT_Stat_Handle) parent->tiers[i], name, name_len, seq)) {
+			return (1);
+		}
+	}
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Mirrors the cached Cob to the parent
+----------------------------------------------------------------------------------------*/
+static void
+csmgr_stat_tier_cob_update (
+	CsmgrT_Stat_Table* tier,
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t seq,
+	uint32_t cob_size,
+	uint64_t expiry,
+	uint64_t cached_time,
+	struct in_addr node
+) {
+	CsmgrT_Stat_Table* parent = tier->parent;
+	CsmgrT_Stat* rcd;
+	int sync_f = 0;
+
+	pthread_mutex_lock (&parent->stat_mutex);
+	csmgr_stat_cob_update (
+		(CsmgrT_Stat_Handle) parent, name, name_len, seq,
+		cob_size, expiry, cached_time, node);
+	rcd = csmgr_stat_content_search (parent, name, name_len);
+	if ((rcd) && (rcd->cob_num == 1) && (rcd->ver_len == 0)) {
+		sync_f = 1;
+	}
+	pthread_mutex_unlock (&parent->stat_mutex);
+
+	/* The version is set after the first Cob of the content was cached 	*/
+	if (sync_f) {
+		csmgr_stat_tier_version_sync (tier, name, name_len);
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Mirrors the removed Cob to the parent unless another tier caches it
+----------------------------------------------------------------------------------------*/
+static void
+csmgr_stat_tier_cob_remove (
+	CsmgrT_Stat_Table* tier,
+	const unsigned char* name,
+	uint16_t name_len,
+	uint32_t seq,
+	uint32_t cob_size
+) {
+	CsmgrT_Stat_Table* parent = tier->parent;
+
+	pthread_mutex_lock (&parent->stat_mutex);
+	if (!csmgr_stat_tier_sibling_cached (tier, name, name_len, seq)) {
+		csmgr_stat_cob_remove ((CsmgrT_Stat_Handle) parent, name, name_len, seq, cob_size);
+	}
+	pthread_mutex_unlock (&parent->stat_mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Mirrors the deleted content to the parent, the Cobs which no other tier
+	caches are removed from the record of the parent
+----------------------------------------------------------------------------------------*/
+static void
+csmgr_stat_tier_content_sync (
+	CsmgrT_Stat_Table* tier,
+	const unsigned char* name,
+	uint16_t name_len
+) {
+	CsmgrT_Stat_Table* parent = tier->parent;
+	CsmgrT_Stat_Table* sibling;
+	CsmgrT_Stat* rcd;
+	CsmgrT_Stat_Table* stbls[CsmgrT_Tier_Max];
+	CsmgrT_Stat* srcds[CsmgrT_Tier_Max];
+	int srcd_num = 0;
+	uint32_t first, last;
+	uint32_t seq;
+	int i, keep_f;
+
+	pthread_mutex_lock (&parent->stat_mutex);
+	rcd = csmgr_stat_content_search (parent, name, name_len);
+	if (!rcd) {
+		pthread_mutex_unlock (&parent->stat_mutex);
+		return;
+	}
+
+	/* Locks the other tiers which cache the content 	*/
+	for (i = 0 ; i < parent->tier_num ; i++) {
+		sibling = parent->tiers[i];
+		if (sibling == tier) {
+			continue;
+		}
+		pthread_mutex_lock (&sibling->stat_mutex);
+		srcds[srcd_num] = csmgr_stat_content_search (sibling, name, name_len);
+		if (srcds[srcd_num]) {
+			stbls[srcd_num] = sibling;
+			srcd_num++;
+		} else {
+			pthread_mutex_unlock (&sibling->stat_mutex);
+		}
+	}
+
+	/* Removes the Cobs which no other tier caches 	*/
+	seq = 0;
+	while (cef_chunk_set_range_next (&rcd->cob_set, seq, &first, &last)) {
+		for (seq = first ; ; seq++) {
+			keep_f = 0;
+			for (i = 0 ; i < srcd_num ; i++) {
+				if (cef_chunk_set_contains (&srcds[i]->cob_set, seq)) {
+					keep_f = 1;
+					break;
+				}
+			}
+			if (!keep_f) {
+				csmgr_stat_cob_clear (parent, rcd, seq, 0);
+			}
+			if (seq == last) {
+				break;
+			}
+		}
+		if (last == UINT32_MAX) {
+			break;
+		}
+		seq = last + 1;
+	}
+
+	for (i = 0 ; i < srcd_num ; i++) {
+		pthread_mutex_unlock (&stbls[i]->stat_mutex);
+	}
+
+	if (rcd->cob_num == 0) {
+		csmgr_stat_record_delete (parent, name, name_len);
+	}
+	pthread_mutex_unlock (&parent->stat_mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Copies the version of the content to the record of the parent
+----------------------------------------------------------------------------------------*/
+static void
+csmgr_stat_tier_version_sync (
+	CsmgrT_Stat_Table* tier,
+	const unsigned char* name,
+	uint16_t name_len
+) {
+	CsmgrT_Stat_Table* parent = tier->parent;
+	CsmgrT_Stat* rcd;
+	CsmgrT_Stat* trcd;
+
+	pthread_mutex_lock (&parent->stat_mutex);
+	rcd = csmgr_stat_content_search (parent, name, name_len);
+	if ((rcd) && (rcd->ver_len == 0)) {
+		pthread_mutex_lock (&tier->stat_mutex);
+		trcd = csmgr_stat_content_search (tier, name, name_len);
+		if ((trcd) && (trcd->ver_len > 0) && (trcd->version != NULL)) {
+			rcd->version = (unsigned char*) malloc (trcd->ver_len);
+			if (rcd->version != NULL) {
+				memcpy (rcd->version, trcd->version, trcd->ver_len);
+				rcd->ver_len = trcd->ver_len;
+			}
+		}
+		pthread_mutex_unlock (&tier->stat_mutex);
+	}
+	pthread_mutex_unlock (&parent->stat_mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Sets the total size of the Cobs cached in the tiers to the parent
+----------------------------------------------------------------------------------------*/
+static void
+csmgr_stat_tier_bytes_sync (
+	CsmgrT_Stat_Table* tier
+) {
+	CsmgrT_Stat_Table* parent = tier->parent;
+	uint64_t cached_bytes = 0;
+	int i;
+
+	pthread_mutex_lock (&parent->stat_mutex);
+	for (i = 0 ; i < parent->tier_num ; i++) {
+		cached_bytes += __atomic_load_n (&parent->tiers[i]->cached_bytes, __ATOMIC_RELAXED);
+	}
+	parent->cached_bytes = cached_bytes;
+	pthread_mutex_unlock (&parent->stat_mutex);
+}
@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * cef_expiry_heap.c
+ */
+
+#define __CEF_EXPIRY_HEAP_SOURECE__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <string.h>
+
+#include <cefore/cef_expiry_heap.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define cef_expiry_heap_parent(i)	(((i) - 1) / 2)
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+static void
+cef_expiry_heap_up (
+	CefT_Expiry_Heap* hp,
+	uint32_t i
+);
+static void
+cef_expiry_heap_down (
+	CefT_Expiry_Heap* hp,
+	uint32_t i
+);
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the expiry heap
+----------------------------------------------------------------------------------------*/
+CefT_Expiry_Heap* 							/* Created heap, NULL if an error occurs	*/
+cef_expiry_heap_create (
+	void
+) {
+	CefT_Expiry_Heap* hp;
+
+	hp = (CefT_Expiry_Heap*) calloc (1, sizeof (CefT_Expiry_Heap));
+	if (hp == NULL) {
+		return (NULL);
+	}
+	hp->elems = (CefT_Expiry_Heap_Elem*)
+			malloc (sizeof (CefT_Expiry_Heap_Elem) * CefC_Expiry_Heap_Init_Size);
+	if (hp->elems == NULL) {
+		free (hp);
+		return (NULL);
+	}
+	hp->max = CefC_Expiry_Heap_Init_Size;
+
+	return (hp);
+}
+/*--------------------------------------------------------------------------------------
+	Destroys the expiry heap (the items are not freed)
+----------------------------------------------------------------------------------------*/
+void
+cef_expiry_heap_destroy (
+	CefT_Expiry_Heap* hp					/* expiry heap								*/
+) {
+	if (hp == NULL) {
+		return;
+	}
+	free (hp->elems);
+	free (hp);
+}
+/*--------------------------------------------------------------------------------------
+	Inserts the item, or updates the key of the item already in the heap. The item
+	is removed if the key is CefC_Expiry_Heap_Never.
+----------------------------------------------------------------------------------------*/
+int 										/* negative if the heap cannot be extended	*/
+cef_expiry_heap_set (
+	CefT_Expiry_Heap* hp,					/* expiry heap								*/
+	void* item,								/* item										*/
+	uint32_t* pos,							/* position of the item kept in the item	*/
+	uint64_t key							/* time when the item expires				*/
+) {
+	CefT_Expiry_Heap_Elem* elems;
+	uint32_t i;
+	uint64_t old_key;
+
+	if (key == CefC_Expiry_Heap_Never) {
+		cef_expiry_heap_remove (hp, pos);
+		return (0);
+	}
+
+	if (*pos != 0) {
+		/* Updates the key 		*/
+		i = *pos - 1;
+		old_key = hp->elems[i].key;
+		hp->elems[i].key = key;
+		if (key < old_key) {
+			cef_expiry_heap_up (hp, i);
+		} else if (key > old_key) {
+			cef_expiry_heap_down (hp, i);
+		}
+		return (0);
+	}
+
+	if (hp->num == hp->max) {
+		elems = (CefT_Expiry_Heap_Elem*)
+				realloc (hp->elems, sizeof (CefT_Expiry_Heap_Elem) * hp->max * 2);
+		if (elems == NULL) {
+			return (-1);
+		}
+		hp->elems = elems;
+		hp->max *= 2;
+	}
+	i = hp->num;
+	hp->num++;
+	hp->elems[i].key  = key;
+	hp->elems[i].item = item;
+	hp->elems[i].pos  = pos;
+	*pos = i + 1;
+	cef_expiry_heap_up (hp, i);
+
+	return (0);
+}
+/*--------------------------------------------------------------------------------------
+	Removes the item from the heap
+----------------------------------------------------------------------------------------*/
+void
+cef_expiry_heap_remove (
+	CefT_Expiry_Heap* hp,					/* expiry heap								*/
+	uint32_t* pos							/* position of the item kept in the item	*/
+) {
+	uint32_t i;
+	uint64_t old_key;
+
+	if (*pos == 0) {
+		return;
+	}
+	i = *pos - 1;
+	*pos = 0;
+	hp->num--;
+	if (i == hp->num) {
+		return;
+	}
+
+	/* Moves the last item to the hole 		*/
+	old_key = hp->elems[i].key;
+	hp->elems[i] = hp->elems[hp->num];
+	*(hp->elems[i].pos) = i + 1;
+	if (hp->elems[i].key < old_key) {
+		cef_expiry_heap_up (hp, i);
+	} else {
+		cef_expiry_heap_down (hp, i);
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Returns the item which expires first if it expires before the specified time
+----------------------------------------------------------------------------------------*/
+void* 										/* item, NULL if no item has expired		*/
+cef_expiry_heap_expired_peek (
+	CefT_Expiry_Heap* hp,					/* expiry heap								*/
+	uint64_t nowt							/* current time								*/
+) {
+	if ((hp->num == 0) || (hp->elems[0].key >= nowt)) {
+		return (NULL);
+	}
+	return (hp->elems[0].item);
+}
+/*--------------------------------------------------------------------------------------
+	Removes all items from the heap
+----------------------------------------------------------------------------------------*/
+void
+cef_expiry_heap_clear (
+	CefT_Expiry_Heap* hp					/* expiry heap								*/
+) {
+	uint32_t i;
+
+	for (i = 0 ; i < hp->num ; i++) {
+		*(hp->elems[i].pos) = 0;
+	}
+	hp->num = 0;
+}
+/*--------------------------------------------------------------------------------------
+	Moves the item toward the root
+----------------------------------------------------------------------------------------*/
+static void
+cef_expiry_heap_up (
+	CefT_Expiry_Heap* hp,
+	uint32_t i
+) {
+	CefT_Expiry_Heap_Elem elem = hp->elems[i];
+	uint32_t p;
+
+	while (i > 0) {
+		p = cef_expiry_heap_parent (i);
+		if (hp->elems[p].key <= elem.key) {
+			break;
+		}
+		hp->elems[i] = hp->elems[p];
+		*(hp->elems[i].pos) = i + 1;
+		i = p;
+	}
+	hp->elems[i] = elem;
+	*(elem.pos) = i + 1;
+}
+/*--------------------------------------------------------------------------------------
+	Moves the item toward the leaves
+----------------------------------------------------------------------------------------*/
+static void
+cef_expiry_heap_down (
+	CefT_Expiry_Heap* hp,
+	uint32_t i
+) {
+	CefT_Expiry_Heap_Elem elem = hp->elems[i];
+	uint32_t c;
+
+	while ((c = i * 2 + 1) < hp->num) {
+		if ((c + 1 < hp->num) && (hp->elems[c + 1].key < hp->elems[c].key)) {
+			c++;
+		}
+		if (elem.key <= hp->elems[c].key) {
+			break;
+		}
+		hp->elems[i] = hp->elems[c];
+		*(hp->elems[i].pos) = i + 1;
+		i = c;
+	}
+	hp->elems[i] = elem;
+	*(elem.pos) = i + 1;
+}
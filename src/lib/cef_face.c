@@ -175,9 +175,13 @@ static void
 cef_face_init_entry(
 	CefT_Face *entry
 ){
+	uint32_t gen = entry->gen;
+
 	memset(entry, 0x00, sizeof(*entry));
 	cef_face_reset_entry(entry);
 	entry->tv_sec = -1;
+	/* The messages which were held for the old Face are told by the generation */
+	entry->gen = gen + 1;
 }
 /*--------------------------------------------------------------------------------------
 	Update Face entries
@@ -242,7 +246,7 @@ cef_face_init (
 		return (-1);
 	}
 
-	face_tbl = (CefT_Face*) malloc (sizeof (CefT_Face) * face_tbl_max);
+	face_tbl = (CefT_Face*) calloc (face_tbl_max, sizeof (CefT_Face));
 
 	for (i = 0; i < face_tbl_max; i++) {
 		cef_face_init_entry(&face_tbl[i]);
@@ -502,6 +506,9 @@ cef_face_close (
 			entry->skfd = face_tbl[entry->faceid].fd = CefC_Fd_Invalid;
 		}
 //		close (entry->skfd);
+		if (face_tbl[faceid].shm) {
+			cef_shmring_pair_destroy (face_tbl[faceid].shm);
+		}
 		cef_face_init_entry(&face_tbl[faceid]);
 		cef_face_sock_entry_destroy (entry);
 	}
@@ -578,6 +585,17 @@ cef_face_check_close (
 	assert (faceid >= 0 && faceid < face_tbl_max);
 	return (face_tbl[faceid].protocol == CefC_Face_Type_Invalid);
 }
+/*--------------------------------------------------------------------------------------
+	Obtains the generation of the specified Face, which changes when the Face-ID
+	is closed or assigned again
+----------------------------------------------------------------------------------------*/
+uint32_t
+cef_face_generation_get (
+	int faceid								/* Face-ID									*/
+) {
+	assert (faceid >= 0 && faceid < face_tbl_max);
+	return (face_tbl[faceid].gen);
+}
 /*--------------------------------------------------------------------------------------
 	Creates the listening UDP socket with the specified port
 ----------------------------------------------------------------------------------------*/
@@ -1214,6 +1232,33 @@ cef_face_get_seqnum_from_faceid (
 	return (face_tbl[faceid].seqnum);
 }
 
+/*--------------------------------------------------------------------------------------
+	Writes a message into the shared memory ring of the local Face
+----------------------------------------------------------------------------------------*/
+static int
+cef_face_shmring_send (
+	CefT_Shmring_Pair* pair,				/* rings of the destination 				*/
+	int				faceid,					/* Face-ID indicating the destination 		*/
+	unsigned char* 	msg, 					/* a message to send						*/
+	int				msg_len					/* length of the message to send 			*/
+) {
+	int res;
+	uint64_t drop;
+
+	res = cef_shmring_write (&pair->tx, msg, msg_len);
+	if (res > 0) {
+		return (res);
+	}
+
+	/* Waiting for the application to drain the ring would stall every face, 	*/
+	/* and the ring never falls back to the socket once it is used, because 	*/
+	/* the peer reassembles the frames from both of them in the same buffer. 	*/
+	drop = __atomic_add_fetch (&pair->tx_drop, 1, __ATOMIC_RELAXED);
+	cef_log_write (CefC_Log_Warn,
+		"[face] Face#%d shared memory ring is %s, dropped the frame (%llu drops)\n",
+		faceid, (res == 0) ? "full" : "broken", (unsigned long long) drop);
+	return (-1);
+}
 /*--------------------------------------------------------------------------------------
 	Sends a message via the specified Face
 ----------------------------------------------------------------------------------------*/
@@ -1239,6 +1284,9 @@ cef_face_send_sockentry (
 		/*********************/
 		/*	1. local socket  */
 		/*********************/
+		if (faceinf->shm) {
+			return (cef_face_shmring_send (faceinf->shm, entry->faceid, msg, msg_len));
+		}
 		res = send (entry->skfd, msg, msg_len, 0);
 	} else if (faceinf->protocol == CefC_Face_Type_Tcp) {
 		/************/
@@ -1485,7 +1533,12 @@ cef_face_apimsg_send_iflocal (
 		if ( payload && 0 < payload_len )
 			memcpy (api_frame + api_hdr_len, payload, payload_len);
 
-		ret = send (entry->skfd, api_frame, (api_hdr_len + payload_len), 0);
+		if (face_tbl[faceid].shm) {
+			ret = cef_face_shmring_send (face_tbl[faceid].shm,
+					faceid, api_frame, (api_hdr_len + payload_len));
+		} else {
+			ret = send (entry->skfd, api_frame, (api_hdr_len + payload_len), 0);
+		}
 
 	} else {
 		ret = 0;
@@ -1528,6 +1581,9 @@ cef_face_all_face_close (
 #endif // CefC_Debug
 			close (face_tbl[i].fd);
 		}
+		if (face_tbl[i].shm) {
+			cef_shmring_pair_destroy (face_tbl[i].shm);
+		}
 	}
 
 	free (face_tbl);
@@ -2218,4 +2274,31 @@ cef_dbg_write (CefC_Dbg_Finer, "faceid=%d, fd=%d, IP=%s, ifname=%s\n",
 
 	return ( faceid );
 }
+/*--------------------------------------------------------------------------------------
+	Sets the shared memory rings to the specified local Face
+----------------------------------------------------------------------------------------*/
+int											/* Returns a negative value if it fails 	*/
+cef_face_local_shmring_set (
+	uint16_t faceid,						/* Face-ID									*/
+	CefT_Shmring_Pair* pair					/* rings attached by cefnetd 				*/
+) {
+	if ((faceid >= face_tbl_max) || (!face_tbl[faceid].local_f) ||
+		(face_tbl[faceid].shm != NULL)) {
+		return (-1);
+	}
+	face_tbl[faceid].shm = pair;
 
+	return (1);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the shared memory rings of the specified local Face
+----------------------------------------------------------------------------------------*/
+CefT_Shmring_Pair* 							/* NULL if the Face uses the socket only 	*/
+cef_face_local_shmring_get (
+	uint16_t faceid							/* Face-ID									*/
+) {
+	if (faceid >= face_tbl_max) {
+		return (NULL);
+	}
+	return (face_tbl[faceid].shm);
+}
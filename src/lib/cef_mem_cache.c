@@ -60,6 +60,7 @@
 #include <cefore/cef_mem_cache.h>
 #include <cefore/cef_valid.h>
 #include <cefore/cef_pthread.h>
+#include <cefore/cef_sketch.h>
 
 /****************************************************************************************
  Macros
@@ -88,6 +89,12 @@ static int xpthread_mutex_lock (const char* pname, int pline, pthread_mutex_t *m
 #define Cef_Mstat_HashTbl_Size				1009
 #define Cef_Mstat_Delete_Cob_AtOnce			1000
 
+#define CefMemCacheC_Shard_Max				16		/* Max number of shards (power of 2)*/
+#define CefMemCacheC_Shard_Min_Cap			64		/* Min capacity of one shard 		*/
+#define CefMemCacheC_Shard_Min_Bytes		(CefC_Max_Msg_Size * 16)
+													/* Min byte budget of one shard 	*/
+#define cef_mem_cache_shard_get(hash)		(&mem_shards[(hash) & (mem_shard_num - 1)])
+
 /****************************************************************************************
  Structures Declaration
  ****************************************************************************************/
@@ -98,6 +105,7 @@ typedef struct _FifoT_Entry {
 	unsigned char* 			ver;
 	int 					key_len;
 	int 					ver_len;
+	int 					size;				/* msg_len of the cached entry 			*/
     int             		valid;
 	struct _FifoT_Entry*	before;
  	struct _FifoT_Entry*	next;
@@ -123,6 +131,21 @@ typedef struct CefT_Mem_Hash {
 
 } CefT_Mem_Hash;
 
+/*** one shard of the memory cache (hash table and FIFO of its own) ***/
+typedef struct CefT_Mem_Cache_Shard {
+	pthread_mutex_t 		mutex;				/* protects all members of the shard 	*/
+	CefT_Mem_Hash* 			hash_tbl;			/* caching hash table 					*/
+	CefT_Hash_Handle 		lookup_table;		/* hash-table to look-up FIFO entries 	*/
+	FifoT_Entry*			entry_head;
+	FifoT_Entry*			entry_tail;
+	int 					cache_cap;			/* Maximum number of entries 			*/
+	int 					cache_count;		/* number of cache entries 				*/
+	uint64_t 				cache_cap_bytes;	/* byte budget (0 means unlimited) 		*/
+	uint64_t 				cache_bytes;		/* total of msg_len of cache entries 	*/
+	CefT_Sketch* 			sketch;				/* TinyLFU frequency sketch (NULL means	*/
+												/* that every Cob is admitted) 			*/
+} CefT_Mem_Cache_Shard;
+
 typedef struct CefT_Mem_Hash_Stat {
 	unsigned char* 				contents_name;		/* Name of Contents					*/
 	uint32_t 					cname_len;			/* Length of Name					*/
@@ -151,25 +174,14 @@ typedef struct CefT_Mem_Hash_Stat_Del {
  State Variables
  ****************************************************************************************/
 
-static int cache_cap = 0;					/* Maximum number of entries that can be 	*/
-											/* listed (it is the same value as the 		*/
-											/* maximum value of the cache table) 		*/
-
-/* pointers of functions which stores and removes the content entry into/from the cache */
-/* table (implementation of the functions are in a plugin which uses this library) 		*/
-
-static int              fifo_hand;          /* position of hand                         */
-static int              cache_count;        /* number of cache entries                  */
-FifoT_Entry*			cache_entry_head;
-FifoT_Entry*			cache_entry_tail;
-static CefT_Hash_Handle lookup_table;       /* hash-table to look-up cache entries      */
-static int              count;              /* the number of entries in lookup table    */
+/* Content Objects are distributed over the shards by the hash of Name and Chunk number.	*/
+/* The lookup from cefnetd only tries the lock of a shard, so that it is never blocked 		*/
+/* by the insertion or the expiry check running in the other threads. 						*/
+static CefT_Mem_Cache_Shard		mem_shards[CefMemCacheC_Shard_Max];
+static uint32_t 				mem_shard_num = 0;		/* number of the shards in use 	*/
 
-static CefT_Mem_Hash* 			mem_hash_tbl = NULL;	/* caching hash table			*/
-static uint32_t 				mem_tabl_max;			/* max size 					*/
-														/* of caching hash table		*/
-
-static pthread_mutex_t 			cef_mem_cs_mutex = PTHREAD_MUTEX_INITIALIZER;
+/* mstat_tbl is shared by all shards, the lock order is shard -> mstat 					*/
+static pthread_mutex_t 			cef_mem_mstat_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static int	cache_cs_expire_check_stat = 0;
 
@@ -191,32 +203,38 @@ static unsigned char tl_t_chunk[] = {
 ----------------------------------------------------------------------------------------*/
 static int
 cef_mem_cache_fifo_init (
-		uint32_t		capacity
+	CefT_Mem_Cache_Shard* shard,
+	uint32_t		capacity
 );
 static void
 cef_mem_cache_fifo_destroy (
-	void
+	CefT_Mem_Cache_Shard* shard
 );
-static void
+static int
 cef_mem_cache_fifo_insert (
+	CefT_Mem_Cache_Shard* shard,
 	CefMemCacheT_Content_Entry* entry
 );
 static void
 cef_mem_cache_fifo_erase (
+	CefT_Mem_Cache_Shard* shard,
 	unsigned char* key,
 	int key_len
 );
 static void
 cef_mem_cache_fifo_store_entry(
+	CefT_Mem_Cache_Shard* shard,
 	CefMemCacheT_Content_Entry* entry
 );
 static void
 cef_mem_cache_fifo_remove_entry(
+	CefT_Mem_Cache_Shard* shard,
 	FifoT_Entry*   entry,
 	int is_removed
 );
 static FifoT_Entry*
 cef_mem_cache_fifo_cache_entry_enqueue(
+	CefT_Mem_Cache_Shard* shard,
 	unsigned char* key,
 	int key_len,
 	unsigned char* ver,
@@ -224,6 +242,7 @@ cef_mem_cache_fifo_cache_entry_enqueue(
 );
 static void
 cef_mem_cache_fifo_cache_entry_dequeue(
+	CefT_Mem_Cache_Shard* shard,
 	FifoT_Entry* p
 );
 
@@ -233,14 +252,18 @@ cef_mem_cache_fifo_cache_entry_dequeue(
 ----------------------------------------------------------------------------------------*/
 static int
 cef_mem_cache_cs_create (
-		uint32_t		capacity
+		uint32_t		capacity,
+		uint64_t		capacity_bytes,
+		int 			admission
 );
 static int
 cef_mem_cache_cs_store (
+	CefT_Mem_Cache_Shard* shard,
 	CefMemCacheT_Content_Entry* new_entry
 );
 static void
 cef_mem_cache_cs_remove (
+	CefT_Mem_Cache_Shard* shard,
 	unsigned char* key,
 	int key_len
 );
@@ -254,8 +277,13 @@ cef_mem_cache_cs_expire_check (
 );
 static int
 cef_mem_cache_cob_write (
+	CefT_Mem_Cache_Shard* shard,
 	CefMemCacheT_Content_Entry* cob
 );
+static void
+cef_mem_cache_entry_free (
+	CefMemCacheT_Content_Mem_Entry* entry
+);
 /*--------------------------------------------------------------------------------------
 	Hash Functions
 ----------------------------------------------------------------------------------------*/
@@ -270,6 +298,8 @@ cef_mem_hash_number_create (
 );
 static int
 cef_mem_cache_hash_tbl_item_set (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen,
 	CefMemCacheT_Content_Mem_Entry* elem,
@@ -277,16 +307,22 @@ cef_mem_cache_hash_tbl_item_set (
 );
 static CefMemCacheT_Content_Mem_Entry*
 cef_mem_cache_hash_tbl_item_get (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen
 );
 static CefMemCacheT_Content_Mem_Entry*
 cef_mem_cache_hash_tbl_item_remove (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen
 );
 static CefMemCacheT_Content_Mem_Entry*
 cef_mem_cache_hash_tbl_item_remove_version (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen,
 	unsigned char* ver,
@@ -381,12 +417,14 @@ cef_mem_cache_mstat_print (
 ----------------------------------------------------------------------------------------*/
 int
 cef_mem_cache_init(
-		uint32_t		capacity
+		uint32_t		capacity,				/* maximum number of cached Cobs 		*/
+		uint64_t		capacity_bytes,			/* byte budget (0 means unlimited) 		*/
+		int 			admission				/* admission policy 					*/
 ){
 	int rtc;
 	int flags;
 
-	rtc = cef_mem_cache_cs_create (capacity);
+	rtc = cef_mem_cache_cs_create (capacity, capacity_bytes, admission);
 	cef_mem_cache_mstat_init ();
 
 	/* Create delete thread */
@@ -575,6 +613,8 @@ cef_mem_cache_delete_thread (
 	int							del_seq;
 	unsigned char 				key[CefMemCacheC_Key_Max];
 	int 						key_len;
+	uint32_t 					hash;
+	CefT_Mem_Cache_Shard*		shard;
 
 	read_fd = *(int *)p;
 
@@ -613,36 +653,33 @@ cef_mem_cache_delete_thread (
 }
 #endif // CefC_Debug
 
-			pthread_mutex_lock (&cef_mem_cs_mutex);
 			for (; del_seq <= max_seq; del_seq++) {
 				CefMemCacheT_Content_Mem_Entry* entry;
 
 				if (del_count >= Cef_Mstat_Delete_Cob_AtOnce) {
 					del_count = 0;
-					pthread_mutex_unlock (&cef_mem_cs_mutex);
 					usleep (50);
-					pthread_mutex_lock (&cef_mem_cs_mutex);
 				}
 
 				key_len = cef_mem_cache_name_chunknum_concatenate (
 							mstat_p->cname, mstat_p->cname_len, del_seq, key);
+				hash  = cef_mem_hash_number_create (key, key_len);
+				shard = cef_mem_cache_shard_get (hash);
+
+				/* Only the shard which has this chunk is locked */
+				pthread_mutex_lock (&shard->mutex);
 				/* Delete from CS */
 				entry = cef_mem_cache_hash_tbl_item_remove_version (
-							key, key_len, mstat_p->cver, mstat_p->cver_len);
+							shard->hash_tbl, hash, key, key_len, mstat_p->cver, mstat_p->cver_len);
 				if (entry != NULL) {
-					free (entry->msg);
-					free (entry->name);
-					if (entry->ver_len)
-						free (entry->version);
-					free (entry);
+					cef_mem_cache_entry_free (entry);
 					/* Delete from FIFO queue */
-					cef_lhash_tbl_item_remove(lookup_table, key, key_len);
-					count--;
+					cef_mem_cache_fifo_erase (shard, key, key_len);
 				}
+				pthread_mutex_unlock (&shard->mutex);
 
 				del_count++;
 			}
-			pthread_mutex_unlock (&cef_mem_cs_mutex);
 		}
 	}
 
@@ -675,9 +712,19 @@ int									/* The return value is negative if an error occurs	*/
 cef_mem_cache_item_set (
 	CefMemCacheT_Content_Entry* entry
 ) {
-	pthread_mutex_lock (&cef_mem_cs_mutex);
-	cef_mem_cache_cob_write (entry);
-	pthread_mutex_unlock (&cef_mem_cs_mutex);
+	CefT_Mem_Cache_Shard* shard;
+	unsigned char 	key[CefMemCacheC_Key_Max];
+	int 			key_len;
+
+	if (mem_shard_num == 0) {
+		return (-1);
+	}
+	key_len = cef_mem_cache_key_create (entry, key);
+	shard = cef_mem_cache_shard_get (cef_mem_hash_number_create (key, key_len));
+
+	pthread_mutex_lock (&shard->mutex);
+	cef_mem_cache_cob_write (shard, entry);
+	pthread_mutex_unlock (&shard->mutex);
 	return (0);
 }
 /*--------------------------------------------------------------------------------------
@@ -689,12 +736,28 @@ cef_mem_cache_item_get (
 	uint16_t trg_key_len						/* content name Length					*/
 ) {
 	CefMemCacheT_Content_Mem_Entry* entry;
+	CefT_Mem_Cache_Shard* shard;
+	uint32_t 		hash;
 	uint64_t 		nowt;
 	struct timeval 	tv;
 
-	/* Access the specified entry 	*/
-	pthread_mutex_lock (&cef_mem_cs_mutex);
-	entry = cef_mem_cache_hash_tbl_item_get (trg_key, trg_key_len);
+	if ((mem_shard_num == 0) || (trg_key_len > CefMemCacheC_Key_Max)) {
+		return (0);
+	}
+	hash  = cef_mem_hash_number_create (trg_key, trg_key_len);
+	shard = cef_mem_cache_shard_get (hash);
+
+	/* Access the specified entry. When the shard is busy with the insertion 	*/
+	/* or the expiry check, this lookup is handled as a cache miss. 			*/
+	if (pthread_mutex_trylock (&shard->mutex) != 0) {
+		return (0);
+	}
+	entry = cef_mem_cache_hash_tbl_item_get (shard->hash_tbl, hash, trg_key, trg_key_len);
+
+	/* Both hits and misses are recorded as the access frequency for the admission 	*/
+	if (shard->sketch) {
+		cef_sketch_increment (shard->sketch, trg_key, trg_key_len);
+	}
 
 	if (entry) {
 
@@ -703,12 +766,12 @@ cef_mem_cache_item_get (
 
 		if (((entry->expiry == 0) || (nowt < entry->expiry)) &&
 			(nowt < entry->cache_time)) {
-			pthread_mutex_unlock (&cef_mem_cs_mutex);
+			pthread_mutex_unlock (&shard->mutex);
 			cef_mem_cache_mstat_ac_cnt_inc (trg_key, trg_key_len, entry->version, entry->ver_len);
 			return (entry);
  		}
 		else {
-			pthread_mutex_unlock (&cef_mem_cs_mutex);
+			pthread_mutex_unlock (&shard->mutex);
 			{
 				pthread_t th;
 				if (cef_pthread_create (&th, NULL, cef_mem_cache_clear_demand_thread, NULL) == -1) {
@@ -719,7 +782,7 @@ cef_mem_cache_item_get (
 		}
 	}
 
-	pthread_mutex_unlock (&cef_mem_cs_mutex);
+	pthread_mutex_unlock (&shard->mutex);
 
 	return (0);
 }
@@ -730,13 +793,35 @@ void
 cef_mem_cache_destroy (
 	void
 ) {
-pthread_mutex_lock (&cef_mem_cs_mutex);
-	cef_mem_cache_fifo_destroy ();
 	cef_mem_cache_cs_destroy ();
-pthread_mutex_unlock (&cef_mem_cs_mutex);
-	pthread_mutex_destroy (&cef_mem_cs_mutex);
 
 	cef_mem_cache_mstat_destroy ();
+	pthread_mutex_destroy (&cef_mem_mstat_mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the number and the total size of the cached Cobs
+----------------------------------------------------------------------------------------*/
+void
+cef_mem_cache_usage_get (
+	uint64_t* cobs,								/* number of cached Cobs 				*/
+	uint64_t* bytes,							/* total of msg_len of cached Cobs 		*/
+	uint64_t* capacity_bytes					/* byte budget (0 means unlimited) 		*/
+) {
+	CefT_Mem_Cache_Shard* shard;
+	uint32_t i;
+
+	*cobs 			= 0;
+	*bytes 			= 0;
+	*capacity_bytes = 0;
+
+	for (i = 0 ; i < mem_shard_num ; i++) {
+		shard = &mem_shards[i];
+		pthread_mutex_lock (&shard->mutex);
+		*cobs 			+= shard->cache_count;
+		*bytes 			+= shard->cache_bytes;
+		*capacity_bytes += shard->cache_cap_bytes;
+		pthread_mutex_unlock (&shard->mutex);
+	}
 }
 
 /****************************************************************************************
@@ -747,27 +832,27 @@ pthread_mutex_unlock (&cef_mem_cs_mutex);
 ----------------------------------------------------------------------------------------*/
 static int 							/* If the error occurs, this value is a negative value	*/
 cef_mem_cache_fifo_init (
-		uint32_t		capacity
+	CefT_Mem_Cache_Shard* shard,
+	uint32_t		capacity
 ) {
-    fifo_hand = 0;
-    cache_count = 0;
+	shard->cache_count = 0;
+	shard->cache_bytes = 0;
 	/* Records the capacity of cache		*/
 	if (capacity < 1) {
 		fprintf (stderr, "[FIFO] Invalid Cacacity\n");
 		return (-1);
 	}
-	cache_cap = capacity;
+	shard->cache_cap = capacity;
 
 	/* Initialize FIFO list management unit */
-	cache_entry_head = (FifoT_Entry*)NULL;
-	cache_entry_tail = (FifoT_Entry*)NULL;
+	shard->entry_head = (FifoT_Entry*)NULL;
+	shard->entry_tail = (FifoT_Entry*)NULL;
 
     /* Creates lookup table */
-    lookup_table = cef_lhash_tbl_create_u32_ext(capacity, CefC_Hash_Coef_Cache);
-	if(lookup_table == (CefT_Hash_Handle)NULL){
+    shard->lookup_table = cef_lhash_tbl_create_u32_ext(capacity, CefC_Hash_Coef_Cache);
+	if(shard->lookup_table == (CefT_Hash_Handle)NULL){
 		return (-1);
 	}
-    count = 0;
 
 	return (0);
 }
@@ -777,39 +862,68 @@ cef_mem_cache_fifo_init (
 ----------------------------------------------------------------------------------------*/
 static void
 cef_mem_cache_fifo_destroy (
-	void
+	CefT_Mem_Cache_Shard* shard
 ) {
-    fifo_hand = 0;
-    cache_count = 0;
-	cache_cap 		= 0;
+	shard->cache_count = 0;
+	shard->cache_cap   = 0;
+	shard->cache_bytes = 0;
+	shard->cache_cap_bytes = 0;
 	{
 		FifoT_Entry* p;
 		FifoT_Entry* np;
-		p = cache_entry_head;
+		p = shard->entry_head;
 		while (p != (FifoT_Entry*)NULL){
 			np = p->next;
 			free(p);
 			p = np;
 		}
-		cache_entry_head = (FifoT_Entry*)NULL;
-		cache_entry_tail = (FifoT_Entry*)NULL;
+		shard->entry_head = (FifoT_Entry*)NULL;
+		shard->entry_tail = (FifoT_Entry*)NULL;
+	}
+	if (shard->lookup_table) {
+		cef_lhash_tbl_destroy(shard->lookup_table);
+		shard->lookup_table = (CefT_Hash_Handle)NULL;
+	}
+	if (shard->sketch) {
+		cef_sketch_destroy (shard->sketch);
+		shard->sketch = NULL;
 	}
-    cef_lhash_tbl_destroy(lookup_table);
-    count = 0;
 }
 
 /*--------------------------------------------------------------------------------------
 	Insert API
 ----------------------------------------------------------------------------------------*/
-static void
+static int
 cef_mem_cache_fifo_insert (
+	CefT_Mem_Cache_Shard* shard,
 	CefMemCacheT_Content_Entry* entry	/* content entry 							*/
 ) {
-    if (cache_count == cache_cap) {
-        /* when cache is full, replace entry */
-    	cef_mem_cache_fifo_remove_entry(cache_entry_head, 0);
+    unsigned char 	key[CefMemCacheC_Key_Max];
+    int 			key_len;
+
+    /* TinyLFU admission: when the cache is full, the new entry is stored only if it is 	*/
+    /* accessed more frequently than the entry which would be replaced 					*/
+    if ((shard->sketch != NULL) &&
+    	(shard->entry_head != (FifoT_Entry*) NULL) &&
+    	((shard->cache_count >= shard->cache_cap) ||
+    	 ((shard->cache_cap_bytes > 0) &&
+    	  (shard->cache_bytes + entry->msg_len > shard->cache_cap_bytes)))) {
+    	key_len = cef_mem_cache_name_chunknum_concatenate (
+    					entry->name, entry->name_len, entry->chunk_num, key);
+    	if (!cef_sketch_admit (shard->sketch, key, key_len,
+    			shard->entry_head->key, shard->entry_head->key_len)) {
+    		return (-1);
+    	}
+    }
+    /* when cache is full, replace entries until both the number and the byte budget are met */
+    while ((shard->entry_head != (FifoT_Entry*) NULL) &&
+    	   ((shard->cache_count >= shard->cache_cap) ||
+    	    ((shard->cache_cap_bytes > 0) &&
+    	     (shard->cache_bytes + entry->msg_len > shard->cache_cap_bytes)))) {
+    	cef_mem_cache_fifo_remove_entry(shard, shard->entry_head, 0);
     }
-    cef_mem_cache_fifo_store_entry(entry);
+    cef_mem_cache_fifo_store_entry(shard, entry);
+    return (0);
 }
 
 /*--------------------------------------------------------------------------------------
@@ -817,25 +931,27 @@ cef_mem_cache_fifo_insert (
 ----------------------------------------------------------------------------------------*/
 static void
 cef_mem_cache_fifo_erase (
+	CefT_Mem_Cache_Shard* shard,
 	unsigned char* key, 					/* key of content entry removed from cache 	*/
 											/* table									*/
 	int key_len								/* length of the key 						*/
 ) {
 
 	FifoT_Entry*	del_entry;
-	void* val = cef_lhash_tbl_item_get(lookup_table, key, key_len);
+	void* val = cef_lhash_tbl_item_get(shard->lookup_table, key, key_len);
     if (val == NULL) {
         fprintf(stderr, "[FIFO] failed to erace\n");
         return;
     }
 	del_entry = (FifoT_Entry*) val;
-    cef_mem_cache_fifo_remove_entry(del_entry, 1);
+    cef_mem_cache_fifo_remove_entry(shard, del_entry, 1);
 }
 /*--------------------------------------------------------------------------------------
 	MISC. Functions
 ----------------------------------------------------------------------------------------*/
 static void
 cef_mem_cache_fifo_store_entry(
+	CefT_Mem_Cache_Shard* shard,
 	CefMemCacheT_Content_Entry* entry
 ) {
     unsigned char 	key[CefMemCacheC_Key_Max];
@@ -845,37 +961,42 @@ cef_mem_cache_fifo_store_entry(
 
     key_len = cef_mem_cache_name_chunknum_concatenate (
                     entry->name, entry->name_len, entry->chunk_num, key);
-	rsentry = cef_mem_cache_fifo_cache_entry_enqueue(key, key_len, entry->version, entry->ver_len);
+	rsentry = cef_mem_cache_fifo_cache_entry_enqueue(shard, key, key_len, entry->version, entry->ver_len);
 
 	if (rsentry == (FifoT_Entry*) NULL){
 		return;
 	}
-    cef_lhash_tbl_item_set(lookup_table, rsentry->key, rsentry->key_len
+	rsentry->size = entry->msg_len;
+    cef_lhash_tbl_item_set(shard->lookup_table, rsentry->key, rsentry->key_len
     	, (void*)rsentry);
-    count++;
-    cef_mem_cache_cs_store(entry);
-    cache_count++;
+    cef_mem_cache_cs_store(shard, entry);
+    shard->cache_count++;
+    shard->cache_bytes += rsentry->size;
 }
 /*-----*/
 static void
 cef_mem_cache_fifo_remove_entry(
+	CefT_Mem_Cache_Shard* shard,
 	FifoT_Entry*   entry,
     int is_removed
 ) {
     FifoT_Entry* rsentry;
     rsentry = entry;
-    cef_lhash_tbl_item_remove(lookup_table, rsentry->key, rsentry->key_len);
-    count--;
+    if (rsentry == (FifoT_Entry*) NULL) {
+    	return;
+    }
+    cef_lhash_tbl_item_remove(shard->lookup_table, rsentry->key, rsentry->key_len);
 
-    if (!is_removed) cef_mem_cache_cs_remove(rsentry->key, rsentry->key_len);
-	cef_mem_cache_fifo_cache_entry_dequeue(rsentry);
+    if (!is_removed) cef_mem_cache_cs_remove(shard, rsentry->key, rsentry->key_len);
+	shard->cache_bytes -= rsentry->size;
+	cef_mem_cache_fifo_cache_entry_dequeue(shard, rsentry);
 
-	cache_count--;
+	shard->cache_count--;
 
 }
 
 static FifoT_Entry*
-cef_mem_cache_fifo_cache_entry_enqueue(unsigned char* key, int key_len, unsigned char* ver, uint16_t ver_len) {
+cef_mem_cache_fifo_cache_entry_enqueue(CefT_Mem_Cache_Shard* shard, unsigned char* key, int key_len, unsigned char* ver, uint16_t ver_len) {
 
 	FifoT_Entry*	q;
 	q = (FifoT_Entry*) calloc(1, sizeof(FifoT_Entry) + key_len + ver_len);
@@ -888,27 +1009,27 @@ cef_mem_cache_fifo_cache_entry_enqueue(unsigned char* key, int key_len, unsigned
 	q->ver = ((unsigned char*) q) + sizeof(FifoT_Entry) + key_len;
 	memcpy (q->ver, ver, ver_len);
 	q->ver_len = ver_len;
-	if(cache_entry_tail == (FifoT_Entry*)NULL){
-		cache_entry_head = q;
-		cache_entry_tail = q;
+	if(shard->entry_tail == (FifoT_Entry*)NULL){
+		shard->entry_head = q;
+		shard->entry_tail = q;
 	} else {
-		cache_entry_tail->next = q;
-		q->before = cache_entry_tail;
-		cache_entry_tail = q;
+		shard->entry_tail->next = q;
+		q->before = shard->entry_tail;
+		shard->entry_tail = q;
 	}
   	return(q);
 }
 
 static void
-cef_mem_cache_fifo_cache_entry_dequeue(FifoT_Entry* p){
+cef_mem_cache_fifo_cache_entry_dequeue(CefT_Mem_Cache_Shard* shard, FifoT_Entry* p){
 
 	 if(p->before == (FifoT_Entry*)NULL && p->next != (FifoT_Entry*)NULL){
-	 	cache_entry_head = p->next;
+	 	shard->entry_head = p->next;
 	 	p->next->before = (FifoT_Entry*)NULL;
 	 } else
 	 if(p->before == (FifoT_Entry*)NULL && p->next == (FifoT_Entry*)NULL){
-	 	cache_entry_head = (FifoT_Entry*)NULL;
-	 	cache_entry_tail = (FifoT_Entry*)NULL;
+	 	shard->entry_head = (FifoT_Entry*)NULL;
+	 	shard->entry_tail = (FifoT_Entry*)NULL;
 	 } else
 	 if(p->before != (FifoT_Entry*)NULL && p->next != (FifoT_Entry*)NULL){
 	    p->before->next = p->next;
@@ -916,7 +1037,7 @@ cef_mem_cache_fifo_cache_entry_dequeue(FifoT_Entry* p){
 	 } else
 	 if(p->before != (FifoT_Entry*)NULL && p->next == (FifoT_Entry*)NULL){
 	    p->before->next = p->next;
-	 	cache_entry_tail = p->before;
+	 	shard->entry_tail = p->before;
 	 }
 	free (p);
 }
@@ -929,21 +1050,60 @@ cef_mem_cache_fifo_cache_entry_dequeue(FifoT_Entry* p){
 ----------------------------------------------------------------------------------------*/
 static int							/* The return value is negative if an error occurs	*/
 cef_mem_cache_cs_create (
-		uint32_t		capacity
+		uint32_t		capacity,
+		uint64_t		capacity_bytes,
+		int 			admission
 ) {
+	CefT_Mem_Cache_Shard* shard;
+	uint32_t shard_cap;
+	uint64_t shard_cap_bytes;
+	uint32_t i;
+
+	/* Decides the number of shards, each shard keeps a reasonable capacity 	*/
+	mem_shard_num = CefMemCacheC_Shard_Max;
+	while ((mem_shard_num > 1) &&
+		   ((capacity / mem_shard_num < CefMemCacheC_Shard_Min_Cap) ||
+		    ((capacity_bytes > 0) &&
+		     (capacity_bytes / mem_shard_num < CefMemCacheC_Shard_Min_Bytes)))) {
+		mem_shard_num >>= 1;
+	}
+	shard_cap = (capacity + mem_shard_num - 1) / mem_shard_num;
+	shard_cap_bytes = capacity_bytes / mem_shard_num;
 
 	/* Creates the memory cache 		*/
-	mem_hash_tbl = cef_mem_hash_tbl_create (capacity);
-	if (mem_hash_tbl ==  NULL) {
-		cef_log_write (CefC_Log_Error, "create mem hash table\n");
-		return (-1);
-	}
-	if (cef_mem_cache_fifo_init (capacity) == -1) {
-		cef_log_write (CefC_Log_Error, "create fifo cache\n");
-		return (-1);
+	for (i = 0 ; i < mem_shard_num ; i++) {
+		shard = &mem_shards[i];
+		memset (shard, 0, sizeof (CefT_Mem_Cache_Shard));
+		pthread_mutex_init (&shard->mutex, NULL);
+
+		shard->hash_tbl = cef_mem_hash_tbl_create (shard_cap);
+		if (shard->hash_tbl ==  NULL) {
+			cef_log_write (CefC_Log_Error, "create mem hash table\n");
+			return (-1);
+		}
+		if (cef_mem_cache_fifo_init (shard, shard_cap) == -1) {
+			cef_log_write (CefC_Log_Error, "create fifo cache\n");
+			return (-1);
+		}
+		shard->cache_cap_bytes = shard_cap_bytes;
+		if (admission == CefMemCacheC_Admission_TinyLFU) {
+			shard->sketch = cef_sketch_create (shard_cap);
+			if (shard->sketch == NULL) {
+				cef_log_write (CefC_Log_Error, "create admission sketch\n");
+				return (-1);
+			}
+		}
 	}
 
-	cef_log_write (CefC_Log_Info, "Local cache capacity : %u\n", capacity);
+	cef_log_write (CefC_Log_Info, "Local cache capacity : %u (%u shards)\n"
+					, capacity, mem_shard_num);
+	if (capacity_bytes > 0) {
+		cef_log_write (CefC_Log_Info, "Local cache capacity (Bytes) : "FMTU64"\n"
+						, shard_cap_bytes * mem_shard_num);
+	}
+	if (admission == CefMemCacheC_Admission_TinyLFU) {
+		cef_log_write (CefC_Log_Info, "Local cache admission : TinyLFU\n");
+	}
 
 	return (0);
 }
@@ -952,6 +1112,7 @@ cef_mem_cache_cs_create (
 ----------------------------------------------------------------------------------------*/
 static int
 cef_mem_cache_cs_store (
+	CefT_Mem_Cache_Shard* shard,
 	CefMemCacheT_Content_Entry* new_entry
 ) {
 	CefMemCacheT_Content_Mem_Entry* entry;
@@ -1007,25 +1168,15 @@ cef_mem_cache_cs_store (
 	entry->expiry		 = new_entry->expiry;
 	entry->node			 = new_entry->node;
 
-	if (cef_mem_cache_hash_tbl_item_set (
-		key, key_len, entry, &old_entry) < 0) {
-		free (entry->msg);
-		free (entry->name);
-		if (entry->version != NULL) {
-			free (entry->version);
-		}
-		free (entry);
+	if (cef_mem_cache_hash_tbl_item_set (shard->hash_tbl,
+		cef_mem_hash_number_create (key, key_len), key, key_len, entry, &old_entry) < 0) {
+		cef_mem_cache_entry_free (entry);
 		return (-1);
 	}
 
 
 	if (old_entry) {
-		free (old_entry->msg);
-		free (old_entry->name);
-		if (old_entry->version != NULL) {
-			free (old_entry->version);
-		}
-		free (old_entry);
+		cef_mem_cache_entry_free (old_entry);
 	}
 
 	return (0);
@@ -1036,21 +1187,19 @@ cef_mem_cache_cs_store (
 ----------------------------------------------------------------------------------------*/
 static void
 cef_mem_cache_cs_remove (
+	CefT_Mem_Cache_Shard* shard,
 	unsigned char* key,
 	int key_len
 ) {
 	CefMemCacheT_Content_Mem_Entry* entry;
 
 	/* Removes the specified entry 	*/
-	entry = cef_mem_cache_hash_tbl_item_remove (key, key_len);
+	entry = cef_mem_cache_hash_tbl_item_remove (
+				shard->hash_tbl, cef_mem_hash_number_create (key, key_len), key, key_len);
 
 	if (entry) {
 		cef_mem_cache_mstat_remove (key, key_len, entry->pay_len);
-		free (entry->msg);
-		free (entry->name);
-		if (entry->ver_len)
-			free (entry->version);
-		free (entry);
+		cef_mem_cache_entry_free (entry);
 	}
 
 	return;
@@ -1063,23 +1212,35 @@ static void
 cef_mem_cache_cs_destroy (
 	void
 ) {
+	CefT_Mem_Cache_Shard* shard;
+	uint32_t s;
 	int i;
 
-	if (mem_hash_tbl) {
-		for (i = 0 ; i < mem_hash_tbl->tabl_max ; i++) {
-			CefT_Mem_Hash_Cell* cp;
-			CefT_Mem_Hash_Cell* wcp;
-			cp = mem_hash_tbl->tbl[i];
-			while (cp != NULL) {
-				wcp = cp->next;
-				free (cp->elem);
-				free(cp);
-				cp = wcp;
+	for (s = 0 ; s < mem_shard_num ; s++) {
+		shard = &mem_shards[s];
+
+		pthread_mutex_lock (&shard->mutex);
+		cef_mem_cache_fifo_destroy (shard);
+		if (shard->hash_tbl) {
+			for (i = 0 ; i < shard->hash_tbl->tabl_max ; i++) {
+				CefT_Mem_Hash_Cell* cp;
+				CefT_Mem_Hash_Cell* wcp;
+				cp = shard->hash_tbl->tbl[i];
+				while (cp != NULL) {
+					wcp = cp->next;
+					cef_mem_cache_entry_free (cp->elem);
+					free(cp);
+					cp = wcp;
+				}
 			}
+			free (shard->hash_tbl->tbl);
+			free (shard->hash_tbl);
+			shard->hash_tbl = NULL;
 		}
-		free (mem_hash_tbl->tbl);
-		free (mem_hash_tbl);
+		pthread_mutex_unlock (&shard->mutex);
+		pthread_mutex_destroy (&shard->mutex);
 	}
+	mem_shard_num = 0;
 
 	return;
 }
@@ -1093,8 +1254,10 @@ cef_mem_cache_cs_expire_check (
 ) {
 	CefMemCacheT_Content_Mem_Entry* entry = NULL;
 	CefMemCacheT_Content_Mem_Entry* entry1 = NULL;
+	CefT_Mem_Cache_Shard* shard;
 	uint64_t 	nowt;
 	struct timeval tv;
+	uint32_t s;
 	int n;
 	unsigned char trg_key[65535];
 	int trg_key_len;
@@ -1102,44 +1265,63 @@ cef_mem_cache_cs_expire_check (
 	gettimeofday (&tv, NULL);
 	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
 
-	for (n = 0 ; n < mem_hash_tbl->tabl_max ; n++) {
-		pthread_mutex_lock (&cef_mem_cs_mutex);
-		if (mem_hash_tbl->tbl[n] == NULL) {
-			pthread_mutex_unlock (&cef_mem_cs_mutex);
-			continue;
-		}
-		{
-			CefT_Mem_Hash_Cell* cp;
-			CefT_Mem_Hash_Cell* wcp;
-			cp = mem_hash_tbl->tbl[n];
-			for (; cp != NULL; cp = wcp) {
-				entry = cp->elem;
-				wcp = cp->next;
-				if ((entry->cache_time < nowt) ||
-					((entry->expiry != 0) && (entry->expiry < nowt))) {
-					/* Removes the expiry cache entry 		*/
-					trg_key_len = cef_mem_cache_key_create_by_Mem_Entry (entry, trg_key);
-					entry1 = cef_mem_cache_hash_tbl_item_remove (trg_key, trg_key_len);
-					cef_mem_cache_fifo_erase(trg_key, trg_key_len);
-					cef_mem_cache_mstat_remove (trg_key, trg_key_len, entry->pay_len);
-					free (entry1->msg);
-					free (entry1->name);
-					if (entry1->ver_len)
-						free (entry1->version);
-					free (entry1);
+	/* Each bucket is checked with the lock of its shard only 	*/
+	for (s = 0 ; s < mem_shard_num ; s++) {
+		shard = &mem_shards[s];
+
+		for (n = 0 ; n < shard->hash_tbl->tabl_max ; n++) {
+			if (shard->hash_tbl->tbl[n] == NULL) {
+				continue;
+			}
+			pthread_mutex_lock (&shard->mutex);
+			{
+				CefT_Mem_Hash_Cell* cp;
+				CefT_Mem_Hash_Cell* wcp;
+				cp = shard->hash_tbl->tbl[n];
+				for (; cp != NULL; cp = wcp) {
+					entry = cp->elem;
+					wcp = cp->next;
+					if ((entry->cache_time < nowt) ||
+						((entry->expiry != 0) && (entry->expiry < nowt))) {
+						/* Removes the expiry cache entry 		*/
+						trg_key_len = cef_mem_cache_key_create_by_Mem_Entry (entry, trg_key);
+						entry1 = cef_mem_cache_hash_tbl_item_remove (
+									shard->hash_tbl, cp->hash, trg_key, trg_key_len);
+						cef_mem_cache_fifo_erase (shard, trg_key, trg_key_len);
+						cef_mem_cache_mstat_remove (trg_key, trg_key_len, entry->pay_len);
+						cef_mem_cache_entry_free (entry1);
+					}
 				}
 			}
+			pthread_mutex_unlock (&shard->mutex);
 		}
-		pthread_mutex_unlock (&cef_mem_cs_mutex);
 	}
 
 	return;
 }
+/*--------------------------------------------------------------------------------------
+	Frees the entry of memory cache
+----------------------------------------------------------------------------------------*/
+static void
+cef_mem_cache_entry_free (
+	CefMemCacheT_Content_Mem_Entry* entry
+) {
+	if (entry == NULL) {
+		return;
+	}
+	free (entry->msg);
+	free (entry->name);
+	if (entry->version != NULL) {
+		free (entry->version);
+	}
+	free (entry);
+}
 /*--------------------------------------------------------------------------------------
 	write the cobs to memry cache
 ----------------------------------------------------------------------------------------*/
 static int							/* The return value is negative if an error occurs	*/
 cef_mem_cache_cob_write (
+	CefT_Mem_Cache_Shard* shard,					/* shard which the cob belongs to 	*/
 	CefMemCacheT_Content_Entry* cob
 ) {
 	CefMemCacheT_Content_Mem_Entry* entry = NULL;
@@ -1149,6 +1331,7 @@ cef_mem_cache_cob_write (
 	struct timeval tv;
 	uint64_t old_ver_ac_cnt = 0;
 	int				rc;
+	uint32_t		hash;
 
 	gettimeofday (&tv, NULL);
 	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
@@ -1157,10 +1340,11 @@ cef_mem_cache_cob_write (
 	}
 
 	trg_key_len = cef_mem_cache_key_create (cob, trg_key);
-	entry = cef_mem_cache_hash_tbl_item_get (trg_key, trg_key_len);
+	hash = cef_mem_hash_number_create (trg_key, trg_key_len);
+	entry = cef_mem_cache_hash_tbl_item_get (shard->hash_tbl, hash, trg_key, trg_key_len);
 #if 0
 	if (entry == NULL) {
-		cef_mem_cache_fifo_insert(cob);
+		cef_mem_cache_fifo_insert(shard, cob);
 		cef_mem_cache_mstat_insert (trg_key, trg_key_len, cob->pay_len);
 	}
 #else
@@ -1187,18 +1371,12 @@ cef_mem_cache_cob_write (
 				/* Pass the Stat table entry to the delete thread */
 
 				/* Delete only this Cob entry first */
-				cef_mem_cache_fifo_erase (trg_key, trg_key_len);
-				entry = cef_mem_cache_hash_tbl_item_remove (trg_key, trg_key_len);
+				cef_mem_cache_fifo_erase (shard, trg_key, trg_key_len);
+				entry = cef_mem_cache_hash_tbl_item_remove (shard->hash_tbl, hash, trg_key, trg_key_len);
 
 				mstat_p = cef_mem_cache_mstat_get_out (trg_key, trg_key_len, entry->version, entry->ver_len);
 
-				if (entry) {
-					free (entry->msg);
-					free (entry->name);
-					if (entry->ver_len)
-						free (entry->version);
-					free (entry);
-				}
+				cef_mem_cache_entry_free (entry);
 
 				if (mstat_p != NULL) {
 					CefT_Mem_Hash_Stat_Del mstat_del;
@@ -1245,7 +1423,10 @@ cef_mem_cache_cob_write (
 			return (0);
 		}
 	}
-	cef_mem_cache_fifo_insert(cob);
+	if (cef_mem_cache_fifo_insert(shard, cob) < 0) {
+		/* rejected by the admission filter 	*/
+		return (0);
+	}
 	cef_mem_cache_mstat_insert (trg_key, trg_key_len, cob->pay_len, cob->version, cob->ver_len, old_ver_ac_cnt);
 #endif
 	return (0);
@@ -1306,7 +1487,6 @@ cef_mem_hash_tbl_create (
 	srand ((unsigned) time (NULL));
 	ht->elem_max = capacity;
 	ht->tabl_max = table_size;
-	mem_tabl_max = ht->tabl_max;
 
 	return (ht);
 }
@@ -1315,20 +1495,19 @@ cef_mem_hash_tbl_create (
 ----------------------------------------------------------------------------------------*/
 static int
 cef_mem_cache_hash_tbl_item_set (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen,
 	CefMemCacheT_Content_Mem_Entry* elem,
 	CefMemCacheT_Content_Mem_Entry** old_elem
 ) {
-	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
-	uint32_t hash = 0;
 	uint32_t y;
 	CefT_Mem_Hash_Cell* cp;
 	CefT_Mem_Hash_Cell* wcp;
 
 	*old_elem = NULL;
 
-	hash = cef_mem_hash_number_create (key, klen);
 	y = hash % ht->tabl_max;
 
 	if(ht->tbl[y] == NULL){
@@ -1338,6 +1517,7 @@ cef_mem_cache_hash_tbl_item_set (
 		}
 		ht->tbl[y]->key = ((unsigned char* )ht->tbl[y]) + sizeof(CefT_Mem_Hash_Cell);
 		cp = ht->tbl[y];
+		cp->hash = hash;
 		cp->elem = elem;
 		cp->klen = klen;
 		memcpy (cp->key, key, klen);
@@ -1347,7 +1527,7 @@ cef_mem_cache_hash_tbl_item_set (
 	} else {
 		/* exist check & replace */
 		for (cp = ht->tbl[y]; cp != NULL; cp = cp->next) {
-			if((cp->klen == klen) &&
+			if((cp->hash == hash) && (cp->klen == klen) &&
 			   (memcmp (cp->key, key, klen) == 0)){
 				*old_elem = cp->elem;
 				cp->elem = elem;
@@ -1363,6 +1543,7 @@ cef_mem_cache_hash_tbl_item_set (
 		ht->tbl[y]->key = ((unsigned char* )ht->tbl[y]) + sizeof(CefT_Mem_Hash_Cell);
 		cp = ht->tbl[y];
 		cp->next = wcp;
+		cp->hash = hash;
 		cp->elem = elem;
 		cp->klen = klen;
 		memcpy (cp->key, key, klen);
@@ -1376,18 +1557,17 @@ cef_mem_cache_hash_tbl_item_set (
 ----------------------------------------------------------------------------------------*/
 static CefMemCacheT_Content_Mem_Entry*
 cef_mem_cache_hash_tbl_item_get (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen
 ) {
-	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
-	uint32_t hash = 0;
 	uint32_t y;
 	CefT_Mem_Hash_Cell* cp;
 
 	if ((klen > CefMemCacheC_Key_Max) || (ht == NULL)) {
 		return (NULL);
 	}
-	hash = cef_mem_hash_number_create (key, klen);
 	y = hash % ht->tabl_max;
 
 	cp = ht->tbl[y];
@@ -1409,11 +1589,11 @@ cef_mem_cache_hash_tbl_item_get (
 ----------------------------------------------------------------------------------------*/
 static CefMemCacheT_Content_Mem_Entry*
 cef_mem_cache_hash_tbl_item_remove (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen
 ) {
-	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
-	uint32_t hash = 0;
 	uint32_t y;
 	CefMemCacheT_Content_Mem_Entry* ret_elem;
 	CefT_Mem_Hash_Cell* cp;
@@ -1423,7 +1603,6 @@ cef_mem_cache_hash_tbl_item_remove (
 		return (NULL);
 	}
 
-	hash = cef_mem_hash_number_create (key, klen);
 	y = hash % ht->tabl_max;
 
 	cp = ht->tbl[y];
@@ -1460,13 +1639,13 @@ cef_mem_cache_hash_tbl_item_remove (
 ----------------------------------------------------------------------------------------*/
 static CefMemCacheT_Content_Mem_Entry*
 cef_mem_cache_hash_tbl_item_remove_version (
+	CefT_Mem_Hash* ht,
+	uint32_t hash,
 	const unsigned char* key,
 	uint32_t klen,
 	unsigned char* ver,
 	uint16_t vlen
 ) {
-	CefT_Mem_Hash* ht = (CefT_Mem_Hash*) mem_hash_tbl;
-	uint32_t hash = 0;
 	uint32_t y;
 	CefMemCacheT_Content_Mem_Entry* ret_elem;
 	CefT_Mem_Hash_Cell* cp;
@@ -1476,7 +1655,6 @@ cef_mem_cache_hash_tbl_item_remove_version (
 		return (NULL);
 	}
 
-	hash = cef_mem_hash_number_create (key, klen);
 	y = hash % ht->tabl_max;
 
 	cp = ht->tbl[y];
@@ -1658,6 +1836,8 @@ cef_mem_cache_mstat_insert (
 	hash = cef_mem_hash_number_create (key, tmp_klen);
 	y = hash % Cef_Mstat_HashTbl_Size;
 
+	pthread_mutex_lock (&cef_mem_mstat_mutex);
+
 	if(mstat_tbl[y] == NULL){
 		mstat_tbl[y] = (CefT_Mem_Hash_Stat*)malloc (sizeof (CefT_Mem_Hash_Stat));
 		mstat_p = mstat_tbl[y];
@@ -1672,6 +1852,7 @@ cef_mem_cache_mstat_insert (
 					mstat_p->min_seq = seqno;
 				if (mstat_p->max_seq < seqno)
 					mstat_p->max_seq = seqno;
+				pthread_mutex_unlock (&cef_mem_mstat_mutex);
 				return;
 			}
 			if (mstat_p->next == NULL)
@@ -1699,6 +1880,7 @@ cef_mem_cache_mstat_insert (
 		mstat_p->version = NULL;
 	}
 
+	pthread_mutex_unlock (&cef_mem_mstat_mutex);
 	return;
 }
 /*--------------------------------------------------------------------------------------
@@ -1731,6 +1913,8 @@ cef_mem_cache_mstat_remove (
 	hash = cef_mem_hash_number_create (key, tmp_klen);
 	y = hash % Cef_Mstat_HashTbl_Size;
 
+	pthread_mutex_lock (&cef_mem_mstat_mutex);
+
 	mstat_p = mstat_tbl[y];
 	while (mstat_p != NULL) {
 		if (mstat_p->cname_len == tmp_klen &&
@@ -1752,11 +1936,13 @@ cef_mem_cache_mstat_remove (
 					mstat_tbl[y] = NULL;
 				}
 			}
+			pthread_mutex_unlock (&cef_mem_mstat_mutex);
 			return;
 		}
 		mstat_p = mstat_p->next;
 	}
 
+	pthread_mutex_unlock (&cef_mem_mstat_mutex);
 	return;
 }
 /*--------------------------------------------------------------------------------------
@@ -1789,6 +1975,8 @@ cef_mem_cache_mstat_get (
 	hash = cef_mem_hash_number_create (key, tmp_klen);
 	y = hash % Cef_Mstat_HashTbl_Size;
 
+	pthread_mutex_lock (&cef_mem_mstat_mutex);
+
 	mstat_p = mstat_tbl[y];
 	while (mstat_p != NULL) {
 		if (mstat_p->cname_len == tmp_klen &&
@@ -1821,11 +2009,13 @@ cef_mem_cache_mstat_get (
 			info_p->max_seq = mstat_p->max_seq;
 #endif //-----@@@@@ CCNINFO
 
+			pthread_mutex_unlock (&cef_mem_mstat_mutex);
 			return (1);
 		}
 		mstat_p = mstat_p->next;
 	}
 
+	pthread_mutex_unlock (&cef_mem_mstat_mutex);
 	return (-1);
 }
 /*--------------------------------------------------------------------------------------
@@ -1859,6 +2049,8 @@ cef_mem_cache_mstat_get_out (
 	hash = cef_mem_hash_number_create (key, tmp_klen);
 	y = hash % Cef_Mstat_HashTbl_Size;
 
+	pthread_mutex_lock (&cef_mem_mstat_mutex);
+
 	mstat_p = mstat_tbl[y];
 	while (mstat_p != NULL) {
 		if (mstat_p->cname_len == tmp_klen &&
@@ -1873,11 +2065,13 @@ cef_mem_cache_mstat_get_out (
 				mstat_tbl[y] = NULL;
 			}
 
+			pthread_mutex_unlock (&cef_mem_mstat_mutex);
 			return (wk_mstat_p);
 		}
 		mstat_p = mstat_p->next;
 	}
 
+	pthread_mutex_unlock (&cef_mem_mstat_mutex);
 	return (NULL);
 }
 /*--------------------------------------------------------------------------------------
@@ -1907,6 +2101,11 @@ cef_mem_cache_mstat_ac_cnt_inc (
 	hash = cef_mem_hash_number_create (key, tmp_klen);
 	y = hash % Cef_Mstat_HashTbl_Size;
 
+	/* The access count is best effort, it never waits for the other threads */
+	if (pthread_mutex_trylock (&cef_mem_mstat_mutex) != 0) {
+		return;
+	}
+
 	mstat_p = mstat_tbl[y];
 	while (mstat_p != NULL) {
 		if ((mstat_p->cname_len == tmp_klen &&
@@ -1915,11 +2114,13 @@ cef_mem_cache_mstat_ac_cnt_inc (
 			memcmp (mstat_p->version, version, ver_len) == 0)) {
 			mstat_p->ver_ac_cnt++;
 			mstat_p->ac_cnt++;
+			pthread_mutex_unlock (&cef_mem_mstat_mutex);
 			return;
 		}
 		mstat_p = mstat_p->next;
 	}
 
+	pthread_mutex_unlock (&cef_mem_mstat_mutex);
 	return;
 }
 /*--------------------------------------------------------------------------------------
@@ -1992,6 +2193,40 @@ cef_mem_cache_mstat_print (
 }
 #endif
 #if ((defined CefC_CefnetdCache) && (defined CefC_Develop))
+/*--------------------------------------------------------------------------------------
+	Checks whether the entry is cached and not expired
+----------------------------------------------------------------------------------------*/
+static int										/* 1:valid, 0:expired, -1:not cached 	*/
+cef_mem_cache_item_check (
+	unsigned char* key,
+	int key_len,
+	uint64_t nowt
+) {
+	CefMemCacheT_Content_Mem_Entry* ent_p;
+	CefT_Mem_Cache_Shard* shard;
+	uint32_t hash;
+	int rc = -1;
+
+	hash  = cef_mem_hash_number_create (key, key_len);
+	shard = cef_mem_cache_shard_get (hash);
+
+	/* mstat is locked by the caller, so the shard is only tried (shard -> mstat) */
+	if (pthread_mutex_trylock (&shard->mutex) != 0) {
+		return (1);
+	}
+	ent_p = cef_mem_cache_hash_tbl_item_get (shard->hash_tbl, hash, key, key_len);
+	if (ent_p != NULL) {
+		if ((ent_p->cache_time < nowt) ||
+			((ent_p->expiry != 0) && (ent_p->expiry < nowt))) {
+			rc = 0;
+		} else {
+			rc = 1;
+		}
+	}
+	pthread_mutex_unlock (&shard->mutex);
+
+	return (rc);
+}
 /*--------------------------------------------------------------------------------------
 	Get mstat info in buffer
 ----------------------------------------------------------------------------------------*/
@@ -2011,11 +2246,22 @@ cef_mem_cache_mstat_get_buff (
 	char ver_none[] = "None";
 	char* wk = buff;
 	uint32_t entry_num = 0;
+	uint64_t nowt;
+	struct timeval tv;
 
 	/* num of entry */
 	wk += 4;
 	index += 4;
 
+	if (mem_shard_num == 0) {
+		memcpy (buff, &entry_num, 4);
+		return (index);
+	}
+	gettimeofday (&tv, NULL);
+	nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
+
+	pthread_mutex_lock (&cef_mem_mstat_mutex);
+
 	for (k = 0; k < Cef_Mstat_HashTbl_Size; k++) {
 		mstat_p = mstat_tbl[k];
 		while (mstat_p != NULL) {
@@ -2026,12 +2272,10 @@ cef_mem_cache_mstat_get_buff (
 			for (uint64_t m = mstat_p->min_seq; m <= mstat_p->max_seq; m++) {
 				unsigned char	key[CefMemCacheC_Key_Max];
 				int 			key_len;
-				CefMemCacheT_Content_Mem_Entry* ent_p;
 
 				key_len = cef_mem_cache_name_chunknum_concatenate (
 							mstat_p->contents_name, mstat_p->cname_len, m, key);
-				ent_p = cef_mem_cache_hash_tbl_item_get (key, key_len);
-				if (ent_p == NULL) {
+				if (cef_mem_cache_item_check (key, key_len, nowt) < 0) {
 					continue;
 				}
 				if (m < mins) {
@@ -2048,17 +2292,10 @@ cef_mem_cache_mstat_get_buff (
 			{
 				unsigned char	key[CefMemCacheC_Key_Max];
 				int 			key_len;
-				CefMemCacheT_Content_Mem_Entry* ent_p;
-				uint64_t		nowt;
-				struct timeval	tv;
 
-				gettimeofday (&tv, NULL);
-				nowt = tv.tv_sec * 1000000llu + tv.tv_usec;
 				key_len = cef_mem_cache_name_chunknum_concatenate (
 							mstat_p->contents_name, mstat_p->cname_len, mstat_p->min_seq, key);
-				ent_p = cef_mem_cache_hash_tbl_item_get (key, key_len);
-				if ((ent_p->cache_time < nowt) ||
-					((ent_p->expiry != 0) && (ent_p->expiry < nowt))) {
+				if (cef_mem_cache_item_check (key, key_len, nowt) < 1) {
 					/* exclude */
 					mstat_p = mstat_p->next;
 					continue;
@@ -2138,6 +2375,8 @@ cef_mem_cache_mstat_get_buff (
 		}
 	}
 
+	pthread_mutex_unlock (&cef_mem_mstat_mutex);
+
 	/* num of entry */
 	memcpy (buff, &entry_num, 4);
 
@@ -0,0 +1,607 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * cef_shmring.c
+ */
+
+#define __CEF_SHMRING_SOURECE__
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <cefore/cef_frame.h>
+#include <cefore/cef_shmring.h>
+
+#ifdef CefC_Shmring_Enable
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+#endif // CefC_Shmring_Enable
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define CefC_Shmring_Frame_Hdr		sizeof (uint32_t)
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+#ifdef CefC_Shmring_Enable
+/*--------------------------------------------------------------------------------------
+	Sets the process local view of the pair of rings
+----------------------------------------------------------------------------------------*/
+static int									/* Returns a negative value if it fails 	*/
+cef_shmring_pair_map (
+	CefT_Shmring_Pair* pair,
+	uint32_t size,
+	int app_f								/* 1: application side, 0: cefnetd side 	*/
+);
+/*--------------------------------------------------------------------------------------
+	Copies the data into the ring at the specified position
+----------------------------------------------------------------------------------------*/
+static void
+cef_shmring_copy_in (
+	CefT_Shmring* ring,
+	uint64_t pos,
+	const unsigned char* src,
+	uint32_t len
+);
+/*--------------------------------------------------------------------------------------
+	Copies the data from the ring at the specified position
+----------------------------------------------------------------------------------------*/
+static void
+cef_shmring_copy_out (
+	CefT_Shmring* ring,
+	uint64_t pos,
+	unsigned char* dst,
+	uint32_t len
+);
+#endif // CefC_Shmring_Enable
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the pair of rings (application side)
+----------------------------------------------------------------------------------------*/
+CefT_Shmring_Pair* 							/* Returns NULL if it fails 				*/
+cef_shmring_pair_create (
+	uint32_t size							/* size of each ring 						*/
+) {
+#ifdef CefC_Shmring_Enable
+	CefT_Shmring_Pair* pair;
+	CefT_Shmring_Hdr* hdr;
+	uint32_t p;
+	int i;
+
+	/* Obtains the size of each ring (power of 2) 	*/
+	if (size < CefC_Shmring_Size_Min) {
+		size = CefC_Shmring_Size_Min;
+	}
+	if (size > CefC_Shmring_Size_Max) {
+		size = CefC_Shmring_Size_Max;
+	}
+	for (p = CefC_Shmring_Size_Min ; p < size ; p <<= 1) {
+		;
+	}
+	size = p;
+
+	pair = (CefT_Shmring_Pair*) calloc (1, sizeof (CefT_Shmring_Pair));
+	if (pair == NULL) {
+		return (NULL);
+	}
+	for (i = 0 ; i < CefC_Shmring_Fd_Num ; i++) {
+		pair->fds[i] = -1;
+	}
+	pair->map     = MAP_FAILED;
+	pair->map_len = (sizeof (CefT_Shmring_Hdr) + size) * 2;
+
+	/* Creates the shared memory and doorbells 		*/
+	pair->fds[0] = memfd_create ("cef_shmring", MFD_CLOEXEC);
+	if (pair->fds[0] < 0) {
+		goto ERROR;
+	}
+	if (ftruncate (pair->fds[0], (off_t) pair->map_len) < 0) {
+		goto ERROR;
+	}
+	for (i = 1 ; i < CefC_Shmring_Fd_Num ; i++) {
+		pair->fds[i] = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (pair->fds[i] < 0) {
+			goto ERROR;
+		}
+	}
+	pair->map = mmap (NULL, pair->map_len,
+				PROT_READ | PROT_WRITE, MAP_SHARED, pair->fds[0], 0);
+	if (pair->map == MAP_FAILED) {
+		goto ERROR;
+	}
+
+	/* Initializes the headers of both rings 		*/
+	for (i = 0 ; i < 2 ; i++) {
+		hdr = (CefT_Shmring_Hdr*)((unsigned char*) pair->map
+						+ (sizeof (CefT_Shmring_Hdr) + size) * i);
+		hdr->size  = size;
+		hdr->head  = 0;
+		hdr->tail  = 0;
+		__atomic_store_n (&hdr->magic, CefC_Shmring_Magic, __ATOMIC_RELEASE);
+	}
+	if (cef_shmring_pair_map (pair, size, 1) < 0) {
+		goto ERROR;
+	}
+	return (pair);
+
+ERROR:
+	if (pair->map != MAP_FAILED) {
+		munmap (pair->map, pair->map_len);
+	}
+	for (i = 0 ; i < CefC_Shmring_Fd_Num ; i++) {
+		if (pair->fds[i] != -1) {
+			close (pair->fds[i]);
+		}
+	}
+	free (pair);
+#endif // CefC_Shmring_Enable
+	return (NULL);
+}
+
+/*--------------------------------------------------------------------------------------
+	Attaches the pair of rings created by the peer (cefnetd side)
+----------------------------------------------------------------------------------------*/
+CefT_Shmring_Pair* 							/* Returns NULL if it fails 				*/
+cef_shmring_pair_attach (
+	int fds[]								/* memfd, app->cefnetd, cefnetd->app 		*/
+) {
+	int i;
+#ifdef CefC_Shmring_Enable
+	CefT_Shmring_Pair* pair;
+	CefT_Shmring_Hdr* hdr;
+	struct stat st;
+	uint32_t size;
+
+	pair = (CefT_Shmring_Pair*) calloc (1, sizeof (CefT_Shmring_Pair));
+	if (pair == NULL) {
+		goto ERROR;
+	}
+	pair->map = MAP_FAILED;
+
+	/* Checks the size of the shared memory 		*/
+	if ((fstat (fds[0], &st) < 0) ||
+		(st.st_size < (off_t)((sizeof (CefT_Shmring_Hdr) + CefC_Shmring_Size_Min) * 2)) ||
+		(st.st_size > (off_t)((sizeof (CefT_Shmring_Hdr) + CefC_Shmring_Size_Max) * 2))) {
+		goto ERROR;
+	}
+	pair->map_len = (size_t) st.st_size;
+	pair->map = mmap (NULL, pair->map_len,
+				PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+	if (pair->map == MAP_FAILED) {
+		goto ERROR;
+	}
+
+	/* Validates the headers which the peer wrote 	*/
+	hdr  = (CefT_Shmring_Hdr*) pair->map;
+	size = hdr->size;
+	if ((__atomic_load_n (&hdr->magic, __ATOMIC_ACQUIRE) != CefC_Shmring_Magic) ||
+		(size == 0) || ((size & (size - 1)) != 0) ||
+		(pair->map_len != (sizeof (CefT_Shmring_Hdr) + size) * 2)) {
+		goto ERROR;
+	}
+	hdr = (CefT_Shmring_Hdr*)((unsigned char*) pair->map + sizeof (CefT_Shmring_Hdr) + size);
+	if ((__atomic_load_n (&hdr->magic, __ATOMIC_ACQUIRE) != CefC_Shmring_Magic) ||
+		(hdr->size != size)) {
+		goto ERROR;
+	}
+	for (i = 0 ; i < CefC_Shmring_Fd_Num ; i++) {
+		pair->fds[i] = fds[i];
+	}
+	if (cef_shmring_pair_map (pair, size, 0) < 0) {
+		goto ERROR;
+	}
+	return (pair);
+
+ERROR:
+	if (pair) {
+		if (pair->map != MAP_FAILED) {
+			munmap (pair->map, pair->map_len);
+		}
+		free (pair);
+	}
+#endif // CefC_Shmring_Enable
+	for (i = 0 ; i < CefC_Shmring_Fd_Num ; i++) {
+		if (fds[i] != -1) {
+			close (fds[i]);
+		}
+	}
+	return (NULL);
+}
+
+/*--------------------------------------------------------------------------------------
+	Destroys the pair of rings
+----------------------------------------------------------------------------------------*/
+void
+cef_shmring_pair_destroy (
+	CefT_Shmring_Pair* pair
+) {
+#ifdef CefC_Shmring_Enable
+	int i;
+
+	if (pair == NULL) {
+		return;
+	}
+	pthread_mutex_destroy (&pair->tx.mutex);
+	pthread_mutex_destroy (&pair->rx.mutex);
+	munmap (pair->map, pair->map_len);
+	for (i = 0 ; i < CefC_Shmring_Fd_Num ; i++) {
+		close (pair->fds[i]);
+	}
+	free (pair);
+#endif // CefC_Shmring_Enable
+}
+
+/*--------------------------------------------------------------------------------------
+	Writes one frame into the ring
+----------------------------------------------------------------------------------------*/
+int											/* length of the written frame, 0 if full, 	*/
+											/* a negative value if the ring is broken 	*/
+cef_shmring_write (
+	CefT_Shmring* ring,
+	const unsigned char* msg,
+	int len
+) {
+#ifdef CefC_Shmring_Enable
+	CefT_Shmring_Hdr* hdr = ring->hdr;
+	uint64_t head;
+	uint64_t tail;
+	uint32_t flen;
+
+	if ((len <= 0) || ((uint32_t) len + CefC_Shmring_Frame_Hdr > ring->mask + 1)) {
+		return (-1);
+	}
+	pthread_mutex_lock (&ring->mutex);
+
+	/* The tail is written by the peer, so it is loaded once and checked 	*/
+	head = ring->pos;
+	tail = __atomic_load_n (&hdr->tail, __ATOMIC_ACQUIRE);
+	if ((tail > head) || (head - tail > (uint64_t) ring->mask + 1)) {
+		pthread_mutex_unlock (&ring->mutex);
+		return (-1);
+	}
+	if ((ring->mask + 1) - (head - tail) < (uint64_t) len + CefC_Shmring_Frame_Hdr) {
+		pthread_mutex_unlock (&ring->mutex);
+		return (0);
+	}
+
+	/* Copies the length and the frame 				*/
+	flen = (uint32_t) len;
+	cef_shmring_copy_in (ring, head, (const unsigned char*) &flen, CefC_Shmring_Frame_Hdr);
+	cef_shmring_copy_in (ring, head + CefC_Shmring_Frame_Hdr, msg, flen);
+	ring->pos = head + CefC_Shmring_Frame_Hdr + flen;
+	__atomic_store_n (&hdr->head, ring->pos, __ATOMIC_SEQ_CST);
+
+	/* Rings the doorbell only when the peer may have drained the ring 	*/
+	tail = __atomic_load_n (&hdr->tail, __ATOMIC_SEQ_CST);
+	if (tail == head) {
+		eventfd_write (ring->efd, 1);
+	}
+	pthread_mutex_unlock (&ring->mutex);
+
+	return (len);
+#else // CefC_Shmring_Enable
+	return (-1);
+#endif // CefC_Shmring_Enable
+}
+
+/*--------------------------------------------------------------------------------------
+	Reads the data from the ring as a byte stream
+----------------------------------------------------------------------------------------*/
+int											/* length of the read frames, a negative 	*/
+											/* value if the ring is broken 				*/
+cef_shmring_read (
+	CefT_Shmring* ring,
+	unsigned char* buff,
+	int len
+) {
+#ifdef CefC_Shmring_Enable
+	CefT_Shmring_Hdr* hdr = ring->hdr;
+	eventfd_t cnt;
+	uint64_t head;
+	uint64_t tail;
+	uint32_t flen;
+	int rd = 0;
+
+	pthread_mutex_lock (&ring->mutex);
+
+	/* Clears the doorbell before looking at the ring 	*/
+	eventfd_read (ring->efd, &cnt);
+
+	/* The head and the lengths are written by the peer, so the head is 	*/
+	/* loaded once and every value is checked before it is used 			*/
+	tail = ring->pos;
+	head = __atomic_load_n (&hdr->head, __ATOMIC_ACQUIRE);
+	if ((head < tail) || (head - tail > (uint64_t) ring->mask + 1)) {
+		pthread_mutex_unlock (&ring->mutex);
+		return (-1);
+	}
+
+	while (head - tail >= CefC_Shmring_Frame_Hdr) {
+		cef_shmring_copy_out (ring, tail, (unsigned char*) &flen, CefC_Shmring_Frame_Hdr);
+		if ((flen == 0) || (flen > CefC_Max_Msg_Size) ||
+			((uint64_t) flen + CefC_Shmring_Frame_Hdr > head - tail)) {
+			pthread_mutex_unlock (&ring->mutex);
+			return (-1);
+		}
+		if (rd + (int) flen > len) {
+			/* Takes the head of the frame and leaves the rest with a new length 	*/
+			flen -= (uint32_t)(len - rd);
+			cef_shmring_copy_out (ring, tail + CefC_Shmring_Frame_Hdr, &buff[rd], len - rd);
+			tail += (uint64_t)(len - rd);
+			cef_shmring_copy_in (ring, tail, (const unsigned char*) &flen, CefC_Shmring_Frame_Hdr);
+			rd = len;
+			break;
+		}
+		cef_shmring_copy_out (ring, tail + CefC_Shmring_Frame_Hdr, &buff[rd], flen);
+		rd   += (int) flen;
+		tail += CefC_Shmring_Frame_Hdr + flen;
+	}
+	ring->pos = tail;
+	__atomic_store_n (&hdr->tail, tail, __ATOMIC_SEQ_CST);
+
+	/* Re-arms the doorbell if frames remain 			*/
+	head = __atomic_load_n (&hdr->head, __ATOMIC_SEQ_CST);
+	if (head != tail) {
+		eventfd_write (ring->efd, 1);
+	}
+	pthread_mutex_unlock (&ring->mutex);
+
+	return (rd);
+#else // CefC_Shmring_Enable
+	return (0);
+#endif // CefC_Shmring_Enable
+}
+
+/*--------------------------------------------------------------------------------------
+	Checks whether the ring has frames to read
+----------------------------------------------------------------------------------------*/
+int											/* 1 if the ring is empty 					*/
+cef_shmring_is_empty (
+	CefT_Shmring* ring
+) {
+#ifdef CefC_Shmring_Enable
+	return (__atomic_load_n (&ring->hdr->head, __ATOMIC_ACQUIRE) ==
+			__atomic_load_n (&ring->hdr->tail, __ATOMIC_ACQUIRE));
+#else // CefC_Shmring_Enable
+	return (1);
+#endif // CefC_Shmring_Enable
+}
+
+/*--------------------------------------------------------------------------------------
+	Sends the message with the file descriptors over the UNIX domain socket
+----------------------------------------------------------------------------------------*/
+int											/* Returns a negative value if it fails 	*/
+cef_shmring_fds_send (
+	int sock,
+	const char* msg,
+	int fds[],
+	int fd_num
+) {
+	struct msghdr mh;
+	struct iovec iov;
+	struct cmsghdr* cmsg;
+	char ctrl[CMSG_SPACE (sizeof (int) * CefC_Shmring_Fd_Num)];
+
+	if ((fd_num <= 0) || (fd_num > CefC_Shmring_Fd_Num)) {
+		return (-1);
+	}
+	memset (&mh, 0, sizeof (mh));
+	memset (ctrl, 0, sizeof (ctrl));
+	iov.iov_base = (void*) msg;
+	iov.iov_len  = strlen (msg);
+	mh.msg_iov        = &iov;
+	mh.msg_iovlen     = 1;
+	mh.msg_control    = ctrl;
+	mh.msg_controllen = CMSG_SPACE (sizeof (int) * fd_num);
+
+	cmsg = CMSG_FIRSTHDR (&mh);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type  = SCM_RIGHTS;
+	cmsg->cmsg_len   = CMSG_LEN (sizeof (int) * fd_num);
+	memcpy (CMSG_DATA (cmsg), fds, sizeof (int) * fd_num);
+
+	return ((int) sendmsg (sock, &mh, 0));
+}
+
+/*--------------------------------------------------------------------------------------
+	Receives the message and file descriptors from the UNIX domain socket
+----------------------------------------------------------------------------------------*/
+int											/* length of the received message 			*/
+cef_shmring_fds_recv (
+	int sock,
+	unsigned char* buff,
+	int len,
+	int fds[],
+	int* fd_num
+) {
+	struct msghdr mh;
+	struct iovec iov;
+	struct cmsghdr* cmsg;
+	char ctrl[CMSG_SPACE (sizeof (int) * CefC_Shmring_Fd_Num)];
+	int rc;
+	int num;
+	int i;
+
+	*fd_num = 0;
+	memset (&mh, 0, sizeof (mh));
+	iov.iov_base = buff;
+	iov.iov_len  = (size_t) len;
+	mh.msg_iov        = &iov;
+	mh.msg_iovlen     = 1;
+	mh.msg_control    = ctrl;
+	mh.msg_controllen = sizeof (ctrl);
+
+#ifdef MSG_CMSG_CLOEXEC
+	rc = (int) recvmsg (sock, &mh, MSG_CMSG_CLOEXEC);
+#else // MSG_CMSG_CLOEXEC
+	rc = (int) recvmsg (sock, &mh, 0);
+#endif // MSG_CMSG_CLOEXEC
+	if (rc < 0) {
+		return (rc);
+	}
+
+	/* Obtains the passed file descriptors 			*/
+	for (cmsg = CMSG_FIRSTHDR (&mh) ; cmsg != NULL ; cmsg = CMSG_NXTHDR (&mh, cmsg)) {
+		if ((cmsg->cmsg_level != SOL_SOCKET) || (cmsg->cmsg_type != SCM_RIGHTS)) {
+			continue;
+		}
+		num = (int)((cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (int));
+		for (i = 0 ; i < num ; i++) {
+			if (*fd_num < CefC_Shmring_Fd_Num) {
+				memcpy (&fds[*fd_num], CMSG_DATA (cmsg) + sizeof (int) * i, sizeof (int));
+				*fd_num += 1;
+			} else {
+				int wfd;
+				memcpy (&wfd, CMSG_DATA (cmsg) + sizeof (int) * i, sizeof (int));
+				close (wfd);
+			}
+		}
+	}
+	if (mh.msg_flags & MSG_CTRUNC) {
+		for (i = 0 ; i < *fd_num ; i++) {
+			close (fds[i]);
+		}
+		*fd_num = 0;
+	}
+
+	return (rc);
+}
+
+#ifdef CefC_Shmring_Enable
+/*--------------------------------------------------------------------------------------
+	Sets the process local view of the pair of rings
+----------------------------------------------------------------------------------------*/
+static int									/* Returns a negative value if it fails 	*/
+cef_shmring_pair_map (
+	CefT_Shmring_Pair* pair,
+	uint32_t size,
+	int app_f								/* 1: application side, 0: cefnetd side 	*/
+) {
+	CefT_Shmring* ring_a;
+	CefT_Shmring* ring_b;
+
+	/* Ring A carries app->cefnetd, ring B carries cefnetd->app 	*/
+	ring_a = (app_f) ? &pair->tx : &pair->rx;
+	ring_b = (app_f) ? &pair->rx : &pair->tx;
+
+	ring_a->hdr  = (CefT_Shmring_Hdr*) pair->map;
+	ring_a->data = (unsigned char*) pair->map + sizeof (CefT_Shmring_Hdr);
+	ring_a->mask = size - 1;
+	ring_a->efd  = pair->fds[1];
+
+	ring_b->hdr  = (CefT_Shmring_Hdr*)(ring_a->data + size);
+	ring_b->data = (unsigned char*) ring_b->hdr + sizeof (CefT_Shmring_Hdr);
+	ring_b->mask = size - 1;
+	ring_b->efd  = pair->fds[2];
+
+	pair->tx.pos = __atomic_load_n (&pair->tx.hdr->head, __ATOMIC_ACQUIRE);
+	pair->rx.pos = __atomic_load_n (&pair->rx.hdr->tail, __ATOMIC_ACQUIRE);
+
+	if (pthread_mutex_init (&pair->tx.mutex, NULL) != 0) {
+		return (-1);
+	}
+	if (pthread_mutex_init (&pair->rx.mutex, NULL) != 0) {
+		pthread_mutex_destroy (&pair->tx.mutex);
+		return (-1);
+	}
+	return (1);
+}
+
+/*--------------------------------------------------------------------------------------
+	Copies the data into the ring at the specified position
+----------------------------------------------------------------------------------------*/
+static void
+cef_shmring_copy_in (
+	CefT_Shmring* ring,
+	uint64_t pos,
+	const unsigned char* src,
+	uint32_t len
+) {
+	uint32_t off = (uint32_t)(pos & ring->mask);
+	uint32_t n = ring->mask + 1 - off;
+
+	if (n >= len) {
+		memcpy (&ring->data[off], src, len);
+	} else {
+		memcpy (&ring->data[off], src, n);
+		memcpy (ring->data, src + n, len - n);
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+	Copies the data from the ring at the specified position
+----------------------------------------------------------------------------------------*/
+static void
+cef_shmring_copy_out (
+	CefT_Shmring* ring,
+	uint64_t pos,
+	unsigned char* dst,
+	uint32_t len
+) {
+	uint32_t off = (uint32_t)(pos & ring->mask);
+	uint32_t n = ring->mask + 1 - off;
+
+	if (n >= len) {
+		memcpy (dst, &ring->data[off], len);
+	} else {
+		memcpy (dst, &ring->data[off], n);
+		memcpy (dst + n, ring->data, len - n);
+	}
+}
+#endif // CefC_Shmring_Enable
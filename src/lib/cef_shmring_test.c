@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * cef_shmring_test.c
+ */
+
+/*
+	cef_shmring_test.c checks that the reader of a shared memory ring rejects
+	the head and the frame lengths forged by the peer instead of copying past
+	the ring or the buffer.
+*/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <cefore/cef_frame.h>
+#include <cefore/cef_shmring.h>
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static unsigned char	test_buff[CefC_Max_Length];
+static int				test_fail = 0;
+
+/****************************************************************************************
+ Static Functions
+ ****************************************************************************************/
+
+static void
+test_expect (
+	const char* what,
+	int64_t value,
+	int64_t expected
+) {
+	if (value != expected) {
+		fprintf (stderr, "FAIL: %s = %lld (expected %lld)\n", what,
+			(long long) value, (long long) expected);
+		test_fail = 1;
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+	Creates the rings of the application and attaches them as cefnetd does
+----------------------------------------------------------------------------------------*/
+static int
+test_open (
+	CefT_Shmring_Pair** app,
+	CefT_Shmring_Pair** netd
+) {
+	int fds[CefC_Shmring_Fd_Num];
+	int i;
+
+	*app = cef_shmring_pair_create (CefC_Shmring_Size_Min);
+	if (*app == NULL) {
+		return (-1);
+	}
+	for (i = 0 ; i < CefC_Shmring_Fd_Num ; i++) {
+		fds[i] = dup ((*app)->fds[i]);
+	}
+	*netd = cef_shmring_pair_attach (fds);
+	if (*netd == NULL) {
+		cef_shmring_pair_destroy (*app);
+		return (-1);
+	}
+	return (1);
+}
+
+/*--------------------------------------------------------------------------------------
+	Writes a frame header with the specified length as a broken application does
+----------------------------------------------------------------------------------------*/
+static void
+test_forge (
+	CefT_Shmring* ring,
+	uint32_t flen,
+	uint64_t head
+) {
+	uint64_t pos = ring->hdr->head;
+
+	memcpy (&ring->data[pos & ring->mask], &flen, sizeof (flen));
+	__atomic_store_n (&ring->hdr->head, head, __ATOMIC_SEQ_CST);
+}
+
+static void
+test_run (
+	void
+) {
+	CefT_Shmring_Pair* app;
+	CefT_Shmring_Pair* netd;
+	unsigned char msg[64];
+	uint64_t size;
+
+	memset (msg, 0xa5, sizeof (msg));
+
+	/* A frame written by the application is read as is 		*/
+	if (test_open (&app, &netd) < 0) {
+		fprintf (stderr, "FAIL: open\n");
+		test_fail = 1;
+		return;
+	}
+	size = (uint64_t) app->tx.mask + 1;
+	test_expect ("write", cef_shmring_write (&app->tx, msg, sizeof (msg)), sizeof (msg));
+	test_expect ("read", cef_shmring_read (&netd->rx, test_buff, CefC_Max_Length),
+		sizeof (msg));
+
+	/* A length longer than a CCNx message 						*/
+	test_forge (&app->tx, CefC_Max_Msg_Size + 1,
+		app->tx.hdr->head + sizeof (uint32_t) + CefC_Max_Msg_Size + 1);
+	test_expect ("read (forged length)",
+		cef_shmring_read (&netd->rx, test_buff, CefC_Max_Length), -1);
+	cef_shmring_pair_destroy (netd);
+	cef_shmring_pair_destroy (app);
+
+	/* A length longer than the bytes in the ring 				*/
+	if (test_open (&app, &netd) < 0) {
+		fprintf (stderr, "FAIL: open\n");
+		test_fail = 1;
+		return;
+	}
+	test_forge (&app->tx, 1024, sizeof (uint32_t) + 16);
+	test_expect ("read (length over used bytes)",
+		cef_shmring_read (&netd->rx, test_buff, CefC_Max_Length), -1);
+	cef_shmring_pair_destroy (netd);
+	cef_shmring_pair_destroy (app);
+
+	/* A head which runs more than the ring size ahead 			*/
+	if (test_open (&app, &netd) < 0) {
+		fprintf (stderr, "FAIL: open\n");
+		test_fail = 1;
+		return;
+	}
+	test_forge (&app->tx, 16, size * 4);
+	test_expect ("read (head over size)",
+		cef_shmring_read (&netd->rx, test_buff, CefC_Max_Length), -1);
+
+	/* A tail of the cefnetd->app ring moved ahead of the head 	*/
+	__atomic_store_n (&app->rx.hdr->tail, size, __ATOMIC_SEQ_CST);
+	test_expect ("write (forged tail)",
+		cef_shmring_write (&netd->tx, msg, sizeof (msg)), -1);
+	cef_shmring_pair_destroy (netd);
+	cef_shmring_pair_destroy (app);
+}
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+int
+main (
+	int argc,
+	char** argv
+) {
+#ifdef CefC_Shmring_Enable
+	test_run ();
+#endif // CefC_Shmring_Enable
+
+	if (test_fail) {
+		return (1);
+	}
+	fprintf (stderr, "cef_shmring_test: OK\n");
+	return (0);
+}
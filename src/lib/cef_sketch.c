@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * cef_sketch.c
+ */
+
+#define __CEF_SKETCH_SOURECE__
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <string.h>
+
+#include <cefore/cef_sketch.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define CefC_Sketch_Fnv_Offset		0xcbf29ce484222325llu
+#define CefC_Sketch_Fnv_Prime		0x00000100000001b3llu
+
+/****************************************************************************************
+ Structures Declaration
+ ****************************************************************************************/
+
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+
+/****************************************************************************************
+ Static Function Declaration
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Calculates the indexes of the key in each row
+----------------------------------------------------------------------------------------*/
+static void
+cef_sketch_index_get (
+	CefT_Sketch* sk,						/* sketch 									*/
+	const unsigned char* key,				/* key 										*/
+	int key_len,							/* length of the key 						*/
+	uint32_t* idx							/* CefC_Sketch_Depth indexes 				*/
+);
+/*--------------------------------------------------------------------------------------
+	Halves all counters (aging)
+----------------------------------------------------------------------------------------*/
+static void
+cef_sketch_reset (
+	CefT_Sketch* sk							/* sketch 									*/
+);
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+	Creates the Count-Min Sketch
+----------------------------------------------------------------------------------------*/
+CefT_Sketch* 								/* Created sketch, NULL if an error occurs 	*/
+cef_sketch_create (
+	uint32_t capacity						/* number of entries of the cache 			*/
+) {
+	CefT_Sketch* sk;
+	uint32_t width = CefC_Sketch_Width_Min;
+
+	while ((width < capacity) && (width < CefC_Sketch_Width_Max)) {
+		width <<= 1;
+	}
+
+	sk = (CefT_Sketch*) calloc (1, sizeof (CefT_Sketch));
+	if (sk == NULL) {
+		return (NULL);
+	}
+	sk->table = (uint8_t*) calloc (CefC_Sketch_Depth, width);
+	if (sk->table == NULL) {
+		free (sk);
+		return (NULL);
+	}
+	sk->width 		= width;
+	sk->mask 		= width - 1;
+	sk->additions 	= 0;
+	sk->sample_size = width * CefC_Sketch_Sample_Factor;
+
+	return (sk);
+}
+
+/*--------------------------------------------------------------------------------------
+	Destroys the Count-Min Sketch
+----------------------------------------------------------------------------------------*/
+void
+cef_sketch_destroy (
+	CefT_Sketch* sk							/* sketch 									*/
+) {
+	if (sk == NULL) {
+		return;
+	}
+	free (sk->table);
+	free (sk);
+}
+
+/*--------------------------------------------------------------------------------------
+	Records an access to the specified key
+----------------------------------------------------------------------------------------*/
+void
+cef_sketch_increment (
+	CefT_Sketch* sk,						/* sketch 									*/
+	const unsigned char* key,				/* key 										*/
+	int key_len								/* length of the key 						*/
+) {
+	uint32_t idx[CefC_Sketch_Depth];
+	uint8_t* cnt;
+	uint8_t min = CefC_Sketch_Counter_Max;
+	int i;
+
+	if (sk == NULL) {
+		return;
+	}
+	cef_sketch_index_get (sk, key, key_len, idx);
+
+	for (i = 0 ; i < CefC_Sketch_Depth ; i++) {
+		cnt = &sk->table[i * sk->width + idx[i]];
+		if (*cnt < min) {
+			min = *cnt;
+		}
+	}
+	if (min >= CefC_Sketch_Counter_Max) {
+		return;
+	}
+
+	/* Conservative update: only the smallest counters are incremented 	*/
+	for (i = 0 ; i < CefC_Sketch_Depth ; i++) {
+		cnt = &sk->table[i * sk->width + idx[i]];
+		if (*cnt == min) {
+			(*cnt)++;
+		}
+	}
+
+	sk->additions++;
+	if (sk->additions >= sk->sample_size) {
+		cef_sketch_reset (sk);
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+	Estimates the access frequency of the specified key
+----------------------------------------------------------------------------------------*/
+int 										/* estimated frequency 						*/
+cef_sketch_estimate (
+	CefT_Sketch* sk,						/* sketch 									*/
+	const unsigned char* key,				/* key 										*/
+	int key_len								/* length of the key 						*/
+) {
+	uint32_t idx[CefC_Sketch_Depth];
+	uint8_t cnt;
+	uint8_t min = CefC_Sketch_Counter_Max;
+	int i;
+
+	if (sk == NULL) {
+		return (0);
+	}
+	cef_sketch_index_get (sk, key, key_len, idx);
+
+	for (i = 0 ; i < CefC_Sketch_Depth ; i++) {
+		cnt = sk->table[i * sk->width + idx[i]];
+		if (cnt < min) {
+			min = cnt;
+		}
+	}
+
+	return ((int) min);
+}
+
+/*--------------------------------------------------------------------------------------
+	TinyLFU admission: decides whether the candidate replaces the victim
+----------------------------------------------------------------------------------------*/
+int 										/* 1: admit the candidate, 0: keep victim 	*/
+cef_sketch_admit (
+	CefT_Sketch* sk,						/* sketch 									*/
+	const unsigned char* cand_key,			/* key of the candidate to be cached 		*/
+	int cand_len,							/* length of the candidate key 				*/
+	const unsigned char* victim_key,		/* key of the victim to be evicted 			*/
+	int victim_len							/* length of the victim key 				*/
+) {
+	if (sk == NULL) {
+		return (1);
+	}
+	/* The victim wins the tie, so that one-hit-wonders do not flush the hot set 	*/
+	if (cef_sketch_estimate (sk, cand_key, cand_len) >
+		cef_sketch_estimate (sk, victim_key, victim_len)) {
+		return (1);
+	}
+	return (0);
+}
+
+/*--------------------------------------------------------------------------------------
+	Calculates the indexes of the key in each row
+----------------------------------------------------------------------------------------*/
+static void
+cef_sketch_index_get (
+	CefT_Sketch* sk,						/* sketch 									*/
+	const unsigned char* key,				/* key 										*/
+	int key_len,							/* length of the key 						*/
+	uint32_t* idx							/* CefC_Sketch_Depth indexes 				*/
+) {
+	uint64_t hash = CefC_Sketch_Fnv_Offset;
+	uint32_t h1, h2;
+	int i;
+
+	/* FNV-1a, then the rows are derived by double hashing 	*/
+	for (i = 0 ; i < key_len ; i++) {
+		hash ^= key[i];
+		hash *= CefC_Sketch_Fnv_Prime;
+	}
+	h1 = (uint32_t) hash;
+	h2 = (uint32_t)(hash >> 32) | 1;
+
+	for (i = 0 ; i < CefC_Sketch_Depth ; i++) {
+		idx[i] = (h1 + i * h2) & sk->mask;
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+	Halves all counters (aging)
+----------------------------------------------------------------------------------------*/
+static void
+cef_sketch_reset (
+	CefT_Sketch* sk							/* sketch 									*/
+) {
+	uint32_t i;
+	uint32_t num = sk->width * CefC_Sketch_Depth;
+
+	for (i = 0 ; i < num ; i++) {
+		sk->table[i] >>= 1;
+	}
+	sk->additions >>= 1;
+}
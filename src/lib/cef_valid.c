@@ -37,8 +37,21 @@
  ****************************************************************************************/
 
 #include <string.h>
+#include <errno.h>
+#include <unistd.h>
 #include <limits.h>
+#include <time.h>
+#include <pthread.h>
 #include <arpa/inet.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CefC_Crc32c_Hw
+#elif defined(__aarch64__) && defined(__linux__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#define CefC_Crc32c_Hw
+#endif
 
 #include <openssl/rsa.h>
 #include <openssl/sha.h>
@@ -62,10 +75,30 @@
 #define	BUFSIZ1K	1024
 #define	BUFSIZ2K	2048
 
+/* CRC32C (Castagnoli) */
+#define CefC_Crc32c_Poly		0x82F63B78	/* reflected form of 0x1EDC6F41 			*/
+#define CefC_Crc32c_Long		8192		/* length of the 3-way interleaved blocks	*/
+#define CefC_Crc32c_Short		256
+
+/* Verification result cache */
+#define CefC_Valid_Vcache_Ways			4			/* entries in a set 					*/
+#define CefC_Valid_Vcache_Default_Size	16384		/* entries (0 disables the cache) 		*/
+#define CefC_Valid_Vcache_Max_Size		1048576
+#define CefC_Valid_Vcache_Default_Ttl	60			/* seconds 								*/
+#define CefC_Valid_Vcache_Max_Ttl		86400
+
+/* Digest of a file */
+#define CefC_Valid_Digest_Block			1048576		/* bytes read at once 					*/
+
 /****************************************************************************************
  Structures Declaration
  ****************************************************************************************/
 
+/* Digest contexts of a thread, reused for every digest */
+typedef struct {
+	EVP_MD_CTX*		ctx[CefC_Valid_Digest_Num];
+} CefT_Valid_Digest_Ctx;
+
 typedef struct {
 
 	unsigned char 	name[CefC_Max_Length];
@@ -81,45 +114,30 @@ typedef struct {
 
 } CefT_Keys;
 
+/* Key of the verification result cache */
+typedef struct {
+	unsigned char	digest[SHA256_DIGEST_LENGTH];	/* of the message and the signature	*/
+	unsigned char	keyid[SHA256_DIGEST_LENGTH];
+} CefT_Valid_Vcache_Key;
+
+/* Entry of the verification result cache */
+typedef struct {
+	CefT_Valid_Vcache_Key	key;
+	int						res;					/* result of the verification 		*/
+	time_t					expire;					/* 0 if the entry is not used 		*/
+} CefT_Valid_Vcache_Entry;
+
 /****************************************************************************************
  State Variables
  ****************************************************************************************/
 
-static uint32_t 			crc_table[256] =  /* this lookup table made with normal form polynomial 0x1EDC6F41. */
-                                {
-                                    0x00000000, 0x1edc6f41, 0x3db8de82, 0x2364b1c3, 0x7b71bd04, 0x65add245, 0x46c96386, 0x58150cc7,
-                                    0xf6e37a08, 0xe83f1549, 0xcb5ba48a, 0xd587cbcb, 0x8d92c70c, 0x934ea84d, 0xb02a198e, 0xaef676cf,
-                                    0xf31a9b51, 0xedc6f410, 0xcea245d3, 0xd07e2a92, 0x886b2655, 0x96b74914, 0xb5d3f8d7, 0xab0f9796,
-                                    0x05f9e159, 0x1b258e18, 0x38413fdb, 0x269d509a, 0x7e885c5d, 0x6054331c, 0x433082df, 0x5deced9e,
-                                    0xf8e959e3, 0xe63536a2, 0xc5518761, 0xdb8de820, 0x8398e4e7, 0x9d448ba6, 0xbe203a65, 0xa0fc5524,
-                                    0x0e0a23eb, 0x10d64caa, 0x33b2fd69, 0x2d6e9228, 0x757b9eef, 0x6ba7f1ae, 0x48c3406d, 0x561f2f2c,
-                                    0x0bf3c2b2, 0x152fadf3, 0x364b1c30, 0x28977371, 0x70827fb6, 0x6e5e10f7, 0x4d3aa134, 0x53e6ce75,
-                                    0xfd10b8ba, 0xe3ccd7fb, 0xc0a86638, 0xde740979, 0x866105be, 0x98bd6aff, 0xbbd9db3c, 0xa505b47d,
-                                    0xef0edc87, 0xf1d2b3c6, 0xd2b60205, 0xcc6a6d44, 0x947f6183, 0x8aa30ec2, 0xa9c7bf01, 0xb71bd040,
-                                    0x19eda68f, 0x0731c9ce, 0x2455780d, 0x3a89174c, 0x629c1b8b, 0x7c4074ca, 0x5f24c509, 0x41f8aa48,
-                                    0x1c1447d6, 0x02c82897, 0x21ac9954, 0x3f70f615, 0x6765fad2, 0x79b99593, 0x5add2450, 0x44014b11,
-                                    0xeaf73dde, 0xf42b529f, 0xd74fe35c, 0xc9938c1d, 0x918680da, 0x8f5aef9b, 0xac3e5e58, 0xb2e23119,
-                                    0x17e78564, 0x093bea25, 0x2a5f5be6, 0x348334a7, 0x6c963860, 0x724a5721, 0x512ee6e2, 0x4ff289a3,
-                                    0xe104ff6c, 0xffd8902d, 0xdcbc21ee, 0xc2604eaf, 0x9a754268, 0x84a92d29, 0xa7cd9cea, 0xb911f3ab,
-                                    0xe4fd1e35, 0xfa217174, 0xd945c0b7, 0xc799aff6, 0x9f8ca331, 0x8150cc70, 0xa2347db3, 0xbce812f2,
-                                    0x121e643d, 0x0cc20b7c, 0x2fa6babf, 0x317ad5fe, 0x696fd939, 0x77b3b678, 0x54d707bb, 0x4a0b68fa,
-                                    0xc0c1d64f, 0xde1db90e, 0xfd7908cd, 0xe3a5678c, 0xbbb06b4b, 0xa56c040a, 0x8608b5c9, 0x98d4da88,
-                                    0x3622ac47, 0x28fec306, 0x0b9a72c5, 0x15461d84, 0x4d531143, 0x538f7e02, 0x70ebcfc1, 0x6e37a080,
-                                    0x33db4d1e, 0x2d07225f, 0x0e63939c, 0x10bffcdd, 0x48aaf01a, 0x56769f5b, 0x75122e98, 0x6bce41d9,
-                                    0xc5383716, 0xdbe45857, 0xf880e994, 0xe65c86d5, 0xbe498a12, 0xa095e553, 0x83f15490, 0x9d2d3bd1,
-                                    0x38288fac, 0x26f4e0ed, 0x0590512e, 0x1b4c3e6f, 0x435932a8, 0x5d855de9, 0x7ee1ec2a, 0x603d836b,
-                                    0xcecbf5a4, 0xd0179ae5, 0xf3732b26, 0xedaf4467, 0xb5ba48a0, 0xab6627e1, 0x88029622, 0x96def963,
-                                    0xcb3214fd, 0xd5ee7bbc, 0xf68aca7f, 0xe856a53e, 0xb043a9f9, 0xae9fc6b8, 0x8dfb777b, 0x9327183a,
-                                    0x3dd16ef5, 0x230d01b4, 0x0069b077, 0x1eb5df36, 0x46a0d3f1, 0x587cbcb0, 0x7b180d73, 0x65c46232,
-                                    0x2fcf0ac8, 0x31136589, 0x1277d44a, 0x0cabbb0b, 0x54beb7cc, 0x4a62d88d, 0x6906694e, 0x77da060f,
-                                    0xd92c70c0, 0xc7f01f81, 0xe494ae42, 0xfa48c103, 0xa25dcdc4, 0xbc81a285, 0x9fe51346, 0x81397c07,
-                                    0xdcd59199, 0xc209fed8, 0xe16d4f1b, 0xffb1205a, 0xa7a42c9d, 0xb97843dc, 0x9a1cf21f, 0x84c09d5e,
-                                    0x2a36eb91, 0x34ea84d0, 0x178e3513, 0x09525a52, 0x51475695, 0x4f9b39d4, 0x6cff8817, 0x7223e756,
-                                    0xd726532b, 0xc9fa3c6a, 0xea9e8da9, 0xf442e2e8, 0xac57ee2f, 0xb28b816e, 0x91ef30ad, 0x8f335fec,
-                                    0x21c52923, 0x3f194662, 0x1c7df7a1, 0x02a198e0, 0x5ab49427, 0x4468fb66, 0x670c4aa5, 0x79d025e4,
-                                    0x243cc87a, 0x3ae0a73b, 0x198416f8, 0x075879b9, 0x5f4d757e, 0x41911a3f, 0x62f5abfc, 0x7c29c4bd,
-                                    0xd2dfb272, 0xcc03dd33, 0xef676cf0, 0xf1bb03b1, 0xa9ae0f76, 0xb7726037, 0x9416d1f4, 0x8acabeb5
-                                };
+static uint32_t 			crc32c_table[8][256];		/* slicing-by-8 tables 			*/
+#ifdef CefC_Crc32c_Hw
+static uint32_t 			crc32c_long[4][256];		/* shifts a CRC by Long zeros 	*/
+static uint32_t 			crc32c_short[4][256];		/* shifts a CRC by Short zeros 	*/
+#endif // CefC_Crc32c_Hw
+static uint32_t 			(*crc32c_func) (uint32_t, const unsigned char*, size_t) = NULL;
+static pthread_once_t		crc32c_once = PTHREAD_ONCE_INIT;
 static CefT_Hash_Handle		key_table;
 static CefT_Keys* 			default_key_entry = NULL;
 static char					ccninfo_sha256_prvkey_path[PATH_MAX*2];
@@ -128,6 +146,24 @@ unsigned char* 				ccninfo_sha256_pub_key_bi;
 size_t 						ccninfo_sha256_pub_key_bi_len;
 EVP_PKEY*					ccninfo_sha256_pub_key;
 EVP_PKEY*					ccninfo_sha256_prv_key;
+static CefT_Valid_Sign_Lookup	sign_cache_lookup = NULL;
+static CefT_Valid_Sign_Store	sign_cache_store = NULL;
+
+/* Digest engine */
+static const char*			digest_names[CefC_Valid_Digest_Num] = {"SHA256", "SHA384", "MD5"};
+static EVP_MD*				digest_mds[CefC_Valid_Digest_Num];	/* fetched only once		*/
+static pthread_once_t		digest_once = PTHREAD_ONCE_INIT;
+static pthread_key_t		digest_key;
+static int					digest_key_f = 0;
+
+/* Verification result cache */
+static CefT_Valid_Vcache_Entry*	vcache_tbl = NULL;
+static uint32_t				vcache_set_mask = 0;
+static uint32_t				vcache_size = CefC_Valid_Vcache_Default_Size;
+static uint32_t				vcache_ttl  = CefC_Valid_Vcache_Default_Ttl;
+static uint64_t				vcache_hit  = 0;
+static uint64_t				vcache_miss = 0;
+static pthread_mutex_t		vcache_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /****************************************************************************************
  Static Function Declaration
@@ -137,6 +173,56 @@ static void
 cef_valid_crc32c_init (
 	void
 );
+static void
+cef_valid_crc32c_setup (
+	void
+);
+static uint32_t
+cef_valid_crc32c_sw (
+	uint32_t crc,
+	const unsigned char* buf,
+	size_t len
+);
+#ifdef CefC_Crc32c_Hw
+static uint32_t
+cef_valid_crc32c_hw (
+	uint32_t crc,
+	const unsigned char* buf,
+	size_t len
+);
+static uint32_t
+cef_valid_crc32c_shift (
+	uint32_t zeros[][256],
+	uint32_t crc
+);
+static uint32_t
+cef_valid_crc32c_gf2_times (
+	const uint32_t* mat,
+	uint32_t vec
+);
+static void
+cef_valid_crc32c_gf2_square (
+	uint32_t* square,
+	const uint32_t* mat
+);
+static void
+cef_valid_crc32c_zeros (
+	uint32_t zeros[][256],
+	size_t len
+);
+#endif // CefC_Crc32c_Hw
+static void
+cef_valid_digest_init (
+	void
+);
+static void
+cef_valid_digest_ctx_free (
+	void* arg
+);
+static EVP_MD_CTX*
+cef_valid_digest_ctx_get (
+	int type
+);
 static int
 cef_valid_trim_line_string (
 	const char* p1,
@@ -197,6 +283,20 @@ cef_valid_crc_verify (
 	uint16_t alg_offset, 			/* offset of T_VALIDATION_ALG 						*/
 	uint16_t pld_offset		 		/* offset of T_VALIDATION_PAYLOAD 					*/
 );
+static int 							/* 0 if hit, 1 if miss, -1 if it cannot be cached 	*/
+cef_valid_vcache_lookup (
+	const unsigned char* msg,
+	uint16_t hdr_len, 				/* HeaderLength (offset of CCN Message)				*/
+	uint16_t alg_offset, 			/* offset of T_VALIDATION_ALG 						*/
+	uint16_t pld_offset,	 		/* offset of T_VALIDATION_PAYLOAD 					*/
+	CefT_Valid_Vcache_Key* key,		/* set to the key of the message 					*/
+	int* res_p						/* set to the cached result if hit 					*/
+);
+static void
+cef_valid_vcache_store (
+	const CefT_Valid_Vcache_Key* key,
+	int res
+);
 static int 							/* If the return value is 0 the code is equal, 		*/
 									/* otherwise the code is different. 				*/
 cef_valid_rsa_sha256_verify (
@@ -360,31 +460,13 @@ cef_valid_type_get (
 	return (res);
 }
 
-uint32_t
-reverse_bit(
-    uint32_t input,
-    size_t len
-) {
-    uint32_t output = 0;
-    for(size_t i = 0; i < len; i++){
-        output = (output << 1) | ((input >> i) & 1);
-    }
-    return output;
-}
-
 uint32_t
 cef_valid_crc32c_calc (
 	const unsigned char* buf,
 	size_t len
 ) {
-    uint32_t c = 0xFFFFFFFF;
-
-    while(len--){
-        c = crc_table[ (c >> 24) ^ reverse_bit(*buf++, 8)] ^ (c << 8);
-    }
-
-    c = reverse_bit(c, 32);
-    return (c ^ 0xFFFFFFFF);
+	cef_valid_crc32c_init ();
+	return (crc32c_func (0, buf, len));
 }
 
 int
@@ -512,12 +594,53 @@ cef_valid_rsa_sha256_dosign (
 
 //	SHA256 (msg, msg_len, hash);
 	cef_valid_sha256( msg, msg_len, hash );	/* for OpenSSL 3.x */
+
+	/* Reuses the signature of the same digest if it is cached 	*/
+	if ((sign_cache_lookup != NULL) &&
+		(sign_cache_lookup (name, name_len, hash, sign, sign_len) == 1)) {
+		return (1);
+	}
 	res = cef_valid_rsa_sign (
 		NID_sha256, hash, SHA256_DIGEST_LENGTH, sign, sign_len, key_entry->prv_key);
 
+	if ((res == 1) && (sign_cache_store != NULL)) {
+		sign_cache_store (name, name_len, hash, sign, *sign_len);
+	}
 
 	return (res);
 }
+/*--------------------------------------------------------------------------------------
+	Sets the functions which cache the signatures of cef_valid_rsa_sha256_dosign
+	(NULL disables the cache)
+----------------------------------------------------------------------------------------*/
+void
+cef_valid_sign_cache_set (
+	CefT_Valid_Sign_Lookup lookup,
+	CefT_Valid_Sign_Store store
+) {
+	sign_cache_lookup = lookup;
+	sign_cache_store  = store;
+}
+/*--------------------------------------------------------------------------------------
+	Verifies the RSA-SHA256 signature of the digest with the public key of the name
+----------------------------------------------------------------------------------------*/
+int 								/* 1 if the signature is valid 						*/
+cef_valid_rsa_sha256_sign_verify (
+	const unsigned char* name,
+	int name_len,
+	const unsigned char* digest,		/* SHA-256 digest of the signed message 		*/
+	const unsigned char* sign,
+	unsigned int sign_len
+) {
+	CefT_Keys* key_entry;
+
+	key_entry = (CefT_Keys*) cef_valid_key_entry_search (name, name_len);
+	if ((key_entry == NULL) || (key_entry->pub_key == NULL)) {
+		return (0);
+	}
+	return ((cef_valid_rsa_verify (NID_sha256, digest, SHA256_DIGEST_LENGTH,
+				sign, sign_len, key_entry->pub_key) == 1) ? 1 : 0);
+}
 
 int 								/* If the return value is 0 the code is equal, 		*/
 									/* otherwise the code is different. 				*/
@@ -592,8 +715,20 @@ cef_valid_msg_verify (
 			break;
 		}
 		case CefC_T_RSA_SHA256: {
+			CefT_Valid_Vcache_Key key;
+			int cache_res;
+
+			/* The same bytes signed by the same key were verified recently 	*/
+			cache_res = cef_valid_vcache_lookup (
+					msg, hdr_len, alg_offset, pld_offset, &key, &res);
+			if (cache_res == 0) {
+				break;
+			}
 			res = cef_valid_rsa_sha256_verify (
 					msg, pkt_len, hdr_len, alg_offset, pld_offset);
+			if (cache_res > 0) {
+				cef_valid_vcache_store (&key, res);
+			}
 			break;
 		}
 		default: {
@@ -603,6 +738,177 @@ cef_valid_msg_verify (
 
 	return (res);
 }
+/*--------------------------------------------------------------------------------------
+	Looks up the result of the verification of the message in the cache
+----------------------------------------------------------------------------------------*/
+static int 							/* 0 if hit, 1 if miss, -1 if it cannot be cached 	*/
+cef_valid_vcache_lookup (
+	const unsigned char* msg,
+	uint16_t hdr_len, 				/* HeaderLength (offset of CCN Message)				*/
+	uint16_t alg_offset, 			/* offset of T_VALIDATION_ALG 						*/
+	uint16_t pld_offset,	 		/* offset of T_VALIDATION_PAYLOAD 					*/
+	CefT_Valid_Vcache_Key* key,		/* set to the key of the message 					*/
+	int* res_p						/* set to the cached result if hit 					*/
+) {
+	CefT_Valid_Vcache_Entry* set;
+	struct tlv_hdr* tlv_ptr;
+	struct timespec now;
+	uint32_t idx;
+	uint16_t pld_len;
+	int res = 1;
+	int i;
+
+	if (vcache_size == 0) {
+		return (-1);
+	}
+
+	/* Obtains the KeyId which follows T_RSA-SHA256 		*/
+	tlv_ptr = (struct tlv_hdr*) &msg[alg_offset + CefC_S_TLF + CefC_S_TLF];
+	if ((ntohs (tlv_ptr->type) != CefC_T_KEYID) ||
+		(ntohs (tlv_ptr->length) != SHA256_DIGEST_LENGTH) ||
+		(alg_offset + CefC_S_TLF * 3 + SHA256_DIGEST_LENGTH > pld_offset)) {
+		return (-1);
+	}
+	memcpy (key->keyid, &msg[alg_offset + CefC_S_TLF * 3], SHA256_DIGEST_LENGTH);
+
+	/* The digest covers the CCN message, the algorithm and the signature, 	*/
+	/* so a message with the other signature does not hit 					*/
+	tlv_ptr = (struct tlv_hdr*) &msg[pld_offset];
+	pld_len = ntohs (tlv_ptr->length);
+	cef_valid_sha256 (&msg[hdr_len],
+		(pld_offset + CefC_S_TLF + pld_len) - hdr_len, key->digest);
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+
+	pthread_mutex_lock (&vcache_mutex);
+	if (vcache_tbl == NULL) {
+		uint32_t sets = 1;
+
+		while (sets * CefC_Valid_Vcache_Ways < vcache_size) {
+			sets <<= 1;
+		}
+		vcache_tbl = (CefT_Valid_Vcache_Entry*) calloc (
+					sets * CefC_Valid_Vcache_Ways, sizeof (CefT_Valid_Vcache_Entry));
+		if (vcache_tbl == NULL) {
+			vcache_size = 0;
+			pthread_mutex_unlock (&vcache_mutex);
+			return (-1);
+		}
+		vcache_set_mask = sets - 1;
+	}
+
+	memcpy (&idx, key->digest, sizeof (idx));
+	set = &vcache_tbl[(idx & vcache_set_mask) * CefC_Valid_Vcache_Ways];
+	for (i = 0 ; i < CefC_Valid_Vcache_Ways ; i++) {
+		if ((set[i].expire > now.tv_sec) &&
+			(memcmp (&set[i].key, key, sizeof (CefT_Valid_Vcache_Key)) == 0)) {
+			*res_p = set[i].res;
+			res = 0;
+			break;
+		}
+	}
+	if (res == 0) {
+		vcache_hit++;
+	} else {
+		vcache_miss++;
+	}
+	pthread_mutex_unlock (&vcache_mutex);
+
+	return (res);
+}
+/*--------------------------------------------------------------------------------------
+	Records the result of the verification of the message in the cache
+----------------------------------------------------------------------------------------*/
+static void
+cef_valid_vcache_store (
+	const CefT_Valid_Vcache_Key* key,
+	int res
+) {
+	CefT_Valid_Vcache_Entry* set;
+	CefT_Valid_Vcache_Entry* entry;
+	struct timespec now;
+	uint32_t idx;
+	int i;
+
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	memcpy (&idx, key->digest, sizeof (idx));
+
+	pthread_mutex_lock (&vcache_mutex);
+	set = &vcache_tbl[(idx & vcache_set_mask) * CefC_Valid_Vcache_Ways];
+
+	/* Replaces the same key, or the entry which expires first 		*/
+	entry = &set[0];
+	for (i = 0 ; i < CefC_Valid_Vcache_Ways ; i++) {
+		if (memcmp (&set[i].key, key, sizeof (CefT_Valid_Vcache_Key)) == 0) {
+			entry = &set[i];
+			break;
+		}
+		if (set[i].expire < entry->expire) {
+			entry = &set[i];
+		}
+	}
+	memcpy (&entry->key, key, sizeof (CefT_Valid_Vcache_Key));
+	entry->res = res;
+	entry->expire = now.tv_sec + vcache_ttl;
+	pthread_mutex_unlock (&vcache_mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the hit and miss counts of the verification result cache
+----------------------------------------------------------------------------------------*/
+void
+cef_valid_verify_cache_stat_get (
+	uint64_t* hit,
+	uint64_t* miss
+) {
+	pthread_mutex_lock (&vcache_mutex);
+	*hit  = vcache_hit;
+	*miss = vcache_miss;
+	pthread_mutex_unlock (&vcache_mutex);
+}
+/*--------------------------------------------------------------------------------------
+	Obtains the Validation Algorithm type of the message without verifying it
+----------------------------------------------------------------------------------------*/
+uint16_t							/* CefC_T_XXX of the algorithm, or 0 if the message */
+									/* does not have a valid Validation Algorithm TLV 	*/
+cef_valid_msg_alg_get (
+	const unsigned char* msg,
+	int msg_len
+) {
+	struct fixed_hdr* 	fixed_hp;
+	struct tlv_hdr* 	tlv_ptr;
+	uint16_t 	index;
+	uint16_t 	pkt_len;
+	uint16_t 	hdr_len;
+	uint16_t 	val_len;
+
+	/* Obtains header length and packet length 		*/
+	fixed_hp = (struct fixed_hdr*) msg;
+	pkt_len  = ntohs (fixed_hp->pkt_len);
+	if (pkt_len != msg_len) {
+		return (0);
+	}
+	hdr_len = fixed_hp->hdr_len;
+	if (hdr_len + CefC_S_TLF > pkt_len) {
+		return (0);
+	}
+
+	/* Skips the CCN message 		*/
+	tlv_ptr = (struct tlv_hdr*) &msg[hdr_len];
+	val_len = ntohs (tlv_ptr->length);
+	index = hdr_len + CefC_S_TLF + val_len;
+	if (index + CefC_S_TLF + CefC_S_TLF > pkt_len) {
+		return (0);
+	}
+
+	/* Checks Validation Algorithm TLVs 	*/
+	tlv_ptr = (struct tlv_hdr*) &msg[index];
+	if (ntohs (tlv_ptr->type) != CefC_T_VALIDATION_ALG) {
+		return (0);
+	}
+	tlv_ptr = (struct tlv_hdr*) &msg[index + CefC_S_TLF];
+
+	return (ntohs (tlv_ptr->type));
+}
 
 int
 cef_valid_keyid_create_forccninfo (
@@ -1303,6 +1609,24 @@ cef_valid_read_conf (
 			strcpy(pprv_key, value);
 		} else if (strcasecmp (keyword, "PATH_PUBLIC_KEY") == 0) {
 			strcpy(ppub_key, value);
+		} else if (strcasecmp (keyword, "VALID_CACHE_SIZE") == 0) {
+			long num = strtol (value, NULL, 10);
+			if ((num < 0) || (num > CefC_Valid_Vcache_Max_Size)) {
+				cef_log_write (CefC_Log_Warn,
+					"VALID_CACHE_SIZE must be lower than %d, the default is used.\n",
+					CefC_Valid_Vcache_Max_Size + 1);
+			} else {
+				vcache_size = (uint32_t) num;
+			}
+		} else if (strcasecmp (keyword, "VALID_CACHE_TTL") == 0) {
+			long num = strtol (value, NULL, 10);
+			if ((num < 1) || (num > CefC_Valid_Vcache_Max_Ttl)) {
+				cef_log_write (CefC_Log_Warn,
+					"VALID_CACHE_TTL must be 1 to %d, the default is used.\n",
+					CefC_Valid_Vcache_Max_Ttl);
+			} else {
+				vcache_ttl = (uint32_t) num;
+			}
 		}
 	}
 	fclose (fp);
@@ -1473,35 +1797,269 @@ cef_valid_sha256_keypath_ccninfoRT(
 static void
 cef_valid_crc32c_init (
 	void
+) {
+	pthread_once (&crc32c_once, cef_valid_crc32c_setup);
+}
+
+/*--------------------------------------------------------------------------------------
+	Makes the CRC32C tables and selects the implementation for this CPU
+----------------------------------------------------------------------------------------*/
+static void
+cef_valid_crc32c_setup (
+	void
 ) {
     /*
     Castagnoli CRC32 (iSCSI, ext4, etc.) with normal form polynomial 0x1EDC6F41.
     From "Description" of "Table 10: CCNx Validation Types" of RFC8609.
+    The tables use the reflected form, which gives the same code as the bit
+    reversed input and output of the normal form.
     */
+	uint32_t i, c;
+	int j;
 
-#ifdef CRC32C_POLY
-    uint32_t i, c;
-    int j;
-
-    // initialize lookup table
-    for (i = 0; i < 256; i++) {
-      crc_table[i] = 0;
-    }
-
-    // make lookup table
-    for (i = 0; i < 256; i++) {
-        c = i << 24;
-        for (j = 0; j < 8; j++) {
-            if(c & (1L << 31))
-               c = (c << 1) ^ CRC32C_POLY;
-            else
-               c = (c << 1);
-        }
-        crc_table[i] = c;
-    }
+	for (i = 0 ; i < 256 ; i++) {
+		c = i;
+		for (j = 0 ; j < 8 ; j++) {
+			c = (c & 1) ? (c >> 1) ^ CefC_Crc32c_Poly : (c >> 1);
+		}
+		crc32c_table[0][i] = c;
+	}
+	for (i = 0 ; i < 256 ; i++) {
+		c = crc32c_table[0][i];
+		for (j = 1 ; j < 8 ; j++) {
+			c = crc32c_table[0][c & 0xFF] ^ (c >> 8);
+			crc32c_table[j][i] = c;
+		}
+	}
+	crc32c_func = cef_valid_crc32c_sw;
+
+#ifdef CefC_Crc32c_Hw
+#if defined(__aarch64__)
+	if (getauxval (AT_HWCAP) & HWCAP_CRC32) {
+#else
+	if (__builtin_cpu_supports ("sse4.2")) {
 #endif
+		cef_valid_crc32c_zeros (crc32c_long, CefC_Crc32c_Long);
+		cef_valid_crc32c_zeros (crc32c_short, CefC_Crc32c_Short);
+		crc32c_func = cef_valid_crc32c_hw;
+	}
+#endif // CefC_Crc32c_Hw
+}
+
+/*--------------------------------------------------------------------------------------
+	Calculates CRC32C with the slicing-by-8 tables
+----------------------------------------------------------------------------------------*/
+static uint32_t
+cef_valid_crc32c_sw (
+	uint32_t crc,
+	const unsigned char* buf,
+	size_t len
+) {
+	uint32_t c = ~crc;
+
+	while (len >= 8) {
+		c ^= (uint32_t) buf[0] | ((uint32_t) buf[1] << 8) |
+			 ((uint32_t) buf[2] << 16) | ((uint32_t) buf[3] << 24);
+		c = crc32c_table[7][c & 0xFF] ^ crc32c_table[6][(c >> 8) & 0xFF] ^
+			crc32c_table[5][(c >> 16) & 0xFF] ^ crc32c_table[4][c >> 24] ^
+			crc32c_table[3][buf[4]] ^ crc32c_table[2][buf[5]] ^
+			crc32c_table[1][buf[6]] ^ crc32c_table[0][buf[7]];
+		buf += 8;
+		len -= 8;
+	}
+	while (len--) {
+		c = crc32c_table[0][(c ^ *buf++) & 0xFF] ^ (c >> 8);
+	}
+	return (~c);
+}
+
+#ifdef CefC_Crc32c_Hw
+#if defined(__x86_64__)
+#define CefC_Crc32c_Target		__attribute__((target("sse4.2")))
+#define CefC_Crc32c_U8(c, v)	_mm_crc32_u8 ((uint32_t)(c), (v))
+#define CefC_Crc32c_U64(c, v)	_mm_crc32_u64 ((c), (v))
+#elif defined(__i386__)
+#define CefC_Crc32c_Target		__attribute__((target("sse4.2")))
+#define CefC_Crc32c_U8(c, v)	_mm_crc32_u8 ((uint32_t)(c), (v))
+#define CefC_Crc32c_U64(c, v)	\
+	_mm_crc32_u32 (_mm_crc32_u32 ((uint32_t)(c), (uint32_t)(v)), (uint32_t)((v) >> 32))
+#else
+#define CefC_Crc32c_Target		__attribute__((target("+crc")))
+#define CefC_Crc32c_U8(c, v)	__crc32cb ((uint32_t)(c), (v))
+#define CefC_Crc32c_U64(c, v)	__crc32cd ((uint32_t)(c), (v))
+#endif
+/*--------------------------------------------------------------------------------------
+	Calculates CRC32C with the CRC instructions. Long buffers are processed in three
+	interleaved streams, which are combined by shifting the CRCs over zeros.
+----------------------------------------------------------------------------------------*/
+static uint32_t CefC_Crc32c_Target
+cef_valid_crc32c_hw (
+	uint32_t crc,
+	const unsigned char* buf,
+	size_t len
+) {
+	const unsigned char* end;
+	uint64_t crc0, crc1, crc2;
+	uint64_t v0, v1, v2;
+
+	crc0 = (uint32_t) ~crc;
+
+	/* Aligns the buffer to 8 bytes 	*/
+	while ((len > 0) && (((uintptr_t) buf & 7) != 0)) {
+		crc0 = CefC_Crc32c_U8 (crc0, *buf);
+		buf++;
+		len--;
+	}
+
+	/* Three streams of Long bytes 		*/
+	while (len >= CefC_Crc32c_Long * 3) {
+		crc1 = 0;
+		crc2 = 0;
+		end = buf + CefC_Crc32c_Long;
+		do {
+			memcpy (&v0, buf, sizeof (uint64_t));
+			memcpy (&v1, buf + CefC_Crc32c_Long, sizeof (uint64_t));
+			memcpy (&v2, buf + CefC_Crc32c_Long * 2, sizeof (uint64_t));
+			crc0 = CefC_Crc32c_U64 (crc0, v0);
+			crc1 = CefC_Crc32c_U64 (crc1, v1);
+			crc2 = CefC_Crc32c_U64 (crc2, v2);
+			buf += 8;
+		} while (buf < end);
+		crc0 = cef_valid_crc32c_shift (crc32c_long, (uint32_t) crc0) ^ crc1;
+		crc0 = cef_valid_crc32c_shift (crc32c_long, (uint32_t) crc0) ^ crc2;
+		buf += CefC_Crc32c_Long * 2;
+		len -= CefC_Crc32c_Long * 3;
+	}
+
+	/* Three streams of Short bytes 	*/
+	while (len >= CefC_Crc32c_Short * 3) {
+		crc1 = 0;
+		crc2 = 0;
+		end = buf + CefC_Crc32c_Short;
+		do {
+			memcpy (&v0, buf, sizeof (uint64_t));
+			memcpy (&v1, buf + CefC_Crc32c_Short, sizeof (uint64_t));
+			memcpy (&v2, buf + CefC_Crc32c_Short * 2, sizeof (uint64_t));
+			crc0 = CefC_Crc32c_U64 (crc0, v0);
+			crc1 = CefC_Crc32c_U64 (crc1, v1);
+			crc2 = CefC_Crc32c_U64 (crc2, v2);
+			buf += 8;
+		} while (buf < end);
+		crc0 = cef_valid_crc32c_shift (crc32c_short, (uint32_t) crc0) ^ crc1;
+		crc0 = cef_valid_crc32c_shift (crc32c_short, (uint32_t) crc0) ^ crc2;
+		buf += CefC_Crc32c_Short * 2;
+		len -= CefC_Crc32c_Short * 3;
+	}
+
+	/* Remaining bytes 					*/
+	while (len >= 8) {
+		memcpy (&v0, buf, sizeof (uint64_t));
+		crc0 = CefC_Crc32c_U64 (crc0, v0);
+		buf += 8;
+		len -= 8;
+	}
+	while (len > 0) {
+		crc0 = CefC_Crc32c_U8 (crc0, *buf);
+		buf++;
+		len--;
+	}
+	return (~(uint32_t) crc0);
+}
+
+/*--------------------------------------------------------------------------------------
+	Shifts the CRC over the zeros of the table
+----------------------------------------------------------------------------------------*/
+static uint32_t
+cef_valid_crc32c_shift (
+	uint32_t zeros[][256],
+	uint32_t crc
+) {
+	return (zeros[0][crc & 0xFF] ^ zeros[1][(crc >> 8) & 0xFF] ^
+			zeros[2][(crc >> 16) & 0xFF] ^ zeros[3][crc >> 24]);
+}
+
+/*--------------------------------------------------------------------------------------
+	Multiplies the GF(2) matrix by the vector
+----------------------------------------------------------------------------------------*/
+static uint32_t
+cef_valid_crc32c_gf2_times (
+	const uint32_t* mat,
+	uint32_t vec
+) {
+	uint32_t sum = 0;
+
+	while (vec) {
+		if (vec & 1) {
+			sum ^= *mat;
+		}
+		vec >>= 1;
+		mat++;
+	}
+	return (sum);
 }
 
+/*--------------------------------------------------------------------------------------
+	Squares the GF(2) matrix
+----------------------------------------------------------------------------------------*/
+static void
+cef_valid_crc32c_gf2_square (
+	uint32_t* square,
+	const uint32_t* mat
+) {
+	int n;
+
+	for (n = 0 ; n < 32 ; n++) {
+		square[n] = cef_valid_crc32c_gf2_times (mat, mat[n]);
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+	Makes the table which shifts a CRC over len (power of 2) zero bytes
+----------------------------------------------------------------------------------------*/
+static void
+cef_valid_crc32c_zeros (
+	uint32_t zeros[][256],
+	size_t len
+) {
+	uint32_t even[32];						/* operator of even power of 2 zero bits	*/
+	uint32_t odd[32];						/* operator of odd power of 2 zero bits		*/
+	uint32_t* op;
+	uint32_t row;
+	uint32_t n;
+
+	/* Operator of one zero bit 		*/
+	odd[0] = CefC_Crc32c_Poly;
+	row = 1;
+	for (n = 1 ; n < 32 ; n++) {
+		odd[n] = row;
+		row <<= 1;
+	}
+	cef_valid_crc32c_gf2_square (even, odd);		/* two zero bits 	*/
+	cef_valid_crc32c_gf2_square (odd, even);		/* four zero bits 	*/
+
+	/* Squares the operator until it shifts over len zero bytes 	*/
+	op = odd;
+	do {
+		cef_valid_crc32c_gf2_square (even, odd);
+		op = even;
+		len >>= 1;
+		if (len == 0) {
+			break;
+		}
+		cef_valid_crc32c_gf2_square (odd, even);
+		op = odd;
+		len >>= 1;
+	} while (len);
+
+	for (n = 0 ; n < 256 ; n++) {
+		zeros[0][n] = cef_valid_crc32c_gf2_times (op, n);
+		zeros[1][n] = cef_valid_crc32c_gf2_times (op, n << 8);
+		zeros[2][n] = cef_valid_crc32c_gf2_times (op, n << 16);
+		zeros[3][n] = cef_valid_crc32c_gf2_times (op, n << 24);
+	}
+}
+#endif // CefC_Crc32c_Hw
+
 /*--------------------------------------------------------------------------------------
 	Trims the string buffer read from the config file
 ----------------------------------------------------------------------------------------*/
@@ -1563,7 +2121,7 @@ cef_valid_sha256 (
 
 	if (md == NULL)
 		return NULL;
-	return EVP_Q_digest(NULL, "SHA256", NULL, d, n, md, NULL) ? md : NULL;
+	return (cef_valid_digest (CefC_Valid_Digest_SHA256, d, n, md) < 0) ? NULL : md;
 
 }
 
@@ -1576,7 +2134,7 @@ cef_valid_sha384 (
 
 	if (md == NULL)
 		return NULL;
-	return EVP_Q_digest(NULL, "SHA384", NULL, d, n, md, NULL) ? md : NULL;
+	return (cef_valid_digest (CefC_Valid_Digest_SHA384, d, n, md) < 0) ? NULL : md;
 
 }
 
@@ -1587,18 +2145,182 @@ cef_valid_md5 (
 	unsigned char *md
 ) {
 
-	EVP_MD_CTX *mdctx = EVP_MD_CTX_new();
-	unsigned int md_len;
-
 	if (md == NULL)
 		return NULL;
+	return (cef_valid_digest (CefC_Valid_Digest_MD5, d, n, md) < 0) ? NULL : md;
+
+}
+/*--------------------------------------------------------------------------------------
+	Computes the digest of the buffer with the context of the calling thread
+----------------------------------------------------------------------------------------*/
+int									/* length of the digest, or -1 if it fails			*/
+cef_valid_digest (
+	int type,						/* CefC_Valid_Digest_xxx 							*/
+	const unsigned char* d,
+	size_t n,
+	unsigned char* md
+) {
+	return (cef_valid_digest_batch (type, 1, &d, &n, md));
+}
+/*--------------------------------------------------------------------------------------
+	Computes the digests of the buffers with the context of the calling thread
+----------------------------------------------------------------------------------------*/
+int									/* length of each digest, or -1 if it fails			*/
+cef_valid_digest_batch (
+	int type,						/* CefC_Valid_Digest_xxx 							*/
+	int num,						/* number of the buffers 							*/
+	const unsigned char* const* d,
+	const size_t* n,
+	unsigned char* md				/* digests of the buffers in order 					*/
+) {
+	EVP_MD_CTX* ctx;
+	unsigned int md_len = 0;
+	int i;
 
-	EVP_DigestInit_ex2(mdctx, EVP_md5(), NULL);
-	EVP_DigestUpdate(mdctx, d, n);
-	EVP_DigestFinal_ex(mdctx, md, &md_len);
-	EVP_MD_CTX_free(mdctx);
-	return md;
+	if ((type < 0) || (type >= CefC_Valid_Digest_Num) || (md == NULL)) {
+		return (-1);
+	}
+	ctx = cef_valid_digest_ctx_get (type);
+	if ((ctx == NULL) && (digest_mds[type] == NULL)) {
+		/* The algorithm could not be fetched, so the length is unknown 	*/
+		return (-1);
+	}
 
+	for (i = 0 ; i < num ; i++) {
+		if (ctx == NULL) {
+			/* Falls back to the one-shot digest 	*/
+			if (EVP_Q_digest (NULL, digest_names[type], NULL, d[i], n[i], md, NULL) == 0) {
+				return (-1);
+			}
+			md_len = (unsigned int) EVP_MD_size (digest_mds[type]);
+		} else if ((EVP_DigestInit_ex2 (ctx, digest_mds[type], NULL) != 1) ||
+			(EVP_DigestUpdate (ctx, d[i], n[i]) != 1) ||
+			(EVP_DigestFinal_ex (ctx, md, &md_len) != 1)) {
+			return (-1);
+		}
+		md += md_len;
+	}
+	return ((int) md_len);
+}
+/*--------------------------------------------------------------------------------------
+	Computes the digest of the file, which is read in blocks instead of being mapped
+----------------------------------------------------------------------------------------*/
+int									/* length of the digest, or -1 if it fails			*/
+cef_valid_digest_fd (
+	int type,						/* CefC_Valid_Digest_xxx 							*/
+	int fd,
+	off_t size,						/* bytes read from the head of the file 			*/
+	unsigned char* md
+) {
+	EVP_MD_CTX* ctx;
+	unsigned char* buff;
+	unsigned int md_len = 0;
+	off_t offset = 0;
+	ssize_t len;
+	int res = -1;
+
+	if ((type < 0) || (type >= CefC_Valid_Digest_Num) || (md == NULL) || (size < 0)) {
+		return (-1);
+	}
+	pthread_once (&digest_once, cef_valid_digest_init);
+	if (digest_mds[type] == NULL) {
+		return (-1);
+	}
+	buff = (unsigned char*) malloc (CefC_Valid_Digest_Block);
+	ctx = EVP_MD_CTX_new ();
+	if ((buff == NULL) || (ctx == NULL) ||
+		(EVP_DigestInit_ex2 (ctx, digest_mds[type], NULL) != 1)) {
+		goto DIGEST_END;
+	}
+	while (offset < size) {
+		len = pread (fd, buff, ((size - offset) < CefC_Valid_Digest_Block) ?
+					(size_t)(size - offset) : CefC_Valid_Digest_Block, offset);
+		if (len < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			goto DIGEST_END;
+		}
+		if (len == 0) {
+			/* The file was truncated 	*/
+			goto DIGEST_END;
+		}
+		if (EVP_DigestUpdate (ctx, buff, (size_t) len) != 1) {
+			goto DIGEST_END;
+		}
+		offset += len;
+	}
+	if (EVP_DigestFinal_ex (ctx, md, &md_len) == 1) {
+		res = (int) md_len;
+	}
+
+DIGEST_END:
+	EVP_MD_CTX_free (ctx);
+	free (buff);
+	return (res);
+}
+/*--------------------------------------------------------------------------------------
+	Fetches the digest algorithms and creates the key of the thread contexts
+----------------------------------------------------------------------------------------*/
+static void
+cef_valid_digest_init (
+	void
+) {
+	int i;
+
+	for (i = 0 ; i < CefC_Valid_Digest_Num ; i++) {
+		digest_mds[i] = EVP_MD_fetch (NULL, digest_names[i], NULL);
+	}
+	if (pthread_key_create (&digest_key, cef_valid_digest_ctx_free) == 0) {
+		digest_key_f = 1;
+	}
+}
+/*--------------------------------------------------------------------------------------
+	Releases the digest contexts when the thread exits
+----------------------------------------------------------------------------------------*/
+static void
+cef_valid_digest_ctx_free (
+	void* arg
+) {
+	CefT_Valid_Digest_Ctx* dctx = (CefT_Valid_Digest_Ctx*) arg;
+	int i;
+
+	if (dctx == NULL) {
+		return;
+	}
+	for (i = 0 ; i < CefC_Valid_Digest_Num ; i++) {
+		EVP_MD_CTX_free (dctx->ctx[i]);
+	}
+	free (dctx);
+}
+/*--------------------------------------------------------------------------------------
+	Returns the digest context of the calling thread (NULL if it is not available)
+----------------------------------------------------------------------------------------*/
+static EVP_MD_CTX*
+cef_valid_digest_ctx_get (
+	int type
+) {
+	CefT_Valid_Digest_Ctx* dctx;
+
+	pthread_once (&digest_once, cef_valid_digest_init);
+	if ((digest_key_f == 0) || (digest_mds[type] == NULL)) {
+		return (NULL);
+	}
+	dctx = (CefT_Valid_Digest_Ctx*) pthread_getspecific (digest_key);
+	if (dctx == NULL) {
+		dctx = (CefT_Valid_Digest_Ctx*) calloc (1, sizeof (CefT_Valid_Digest_Ctx));
+		if (dctx == NULL) {
+			return (NULL);
+		}
+		if (pthread_setspecific (digest_key, dctx) != 0) {
+			free (dctx);
+			return (NULL);
+		}
+	}
+	if (dctx->ctx[type] == NULL) {
+		dctx->ctx[type] = EVP_MD_CTX_new ();
+	}
+	return (dctx->ctx[type]);
 }
 
 static void
@@ -1744,6 +2466,7 @@ cef_valid_rsa_sign (
 	EVP_PKEY_CTX *ctx;
 	int ret = 0;
 	unsigned char* sig = NULL;
+	size_t sig_len = 0;							/* siglen is not a size_t			*/
 
 	ctx = EVP_PKEY_CTX_new (pkey, NULL);
 	if (!ctx) {
@@ -1761,17 +2484,17 @@ cef_valid_rsa_sign (
 			ret, ERR_error_string (ERR_get_error (), NULL));
 		goto err;
 	}
-	if ((ret = EVP_PKEY_sign (ctx, NULL, (size_t*)siglen, msg, msg_len)) <= 0) {
+	if ((ret = EVP_PKEY_sign (ctx, NULL, &sig_len, msg, msg_len)) <= 0) {
 		cef_log_write (CefC_Log_Error, "EVP_PKEY_sign(NULL)=%d, ERR_error_string:%s\n",
 			ret, ERR_error_string (ERR_get_error (), NULL));
 		goto err;
 	}
-	sig = OPENSSL_malloc(*siglen);
+	sig = OPENSSL_malloc(sig_len);
 	if (sig == NULL) {
 		cef_log_write (CefC_Log_Error, "Failed to allocation signing buffer\n");
 		goto err;
 	}
-	ret = EVP_PKEY_sign (ctx, sig, (size_t*)siglen, msg, msg_len);
+	ret = EVP_PKEY_sign (ctx, sig, &sig_len, msg, msg_len);
 	if (ret <= 0) {
 		cef_log_write (CefC_Log_Error, "EVP_PKEY_sign(%p)=%d, ERR_error_string:%s\n",
 			sigret, ret, ERR_error_string (ERR_get_error (), NULL));
@@ -1781,7 +2504,8 @@ cef_valid_rsa_sign (
 		cef_dbg_write (CefC_Dbg_Finest, "EVP_PKEY_sign()=OK\n");
 #endif // CefC_Debug
 	}
-	memcpy (sigret, sig, *siglen);
+	memcpy (sigret, sig, sig_len);
+	*siglen = (unsigned int) sig_len;
 
 err:
 	EVP_PKEY_CTX_free (ctx);
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2016-2023, National Institute of Information and Communications
+ * Technology (NICT). All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the NICT nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE NICT AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE NICT OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+/*
+ * cef_valid_test.c
+ */
+
+/*
+	cef_valid_test.c checks the functions with which conpubd decides to reuse the
+	signatures of its signature file. The digest of a file read in blocks must be
+	the digest of its contents, and must change when the contents are changed
+	without changing the size. A signature must verify only with the digest it was
+	made from, so the signature of the old contents is not reused.
+*/
+
+/****************************************************************************************
+ Include Files
+ ****************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include <openssl/sha.h>
+
+#include <cefore/cef_define.h>
+#include <cefore/cef_frame.h>
+#include <cefore/cef_log.h>
+#include <cefore/cef_valid.h>
+
+/****************************************************************************************
+ Macros
+ ****************************************************************************************/
+
+#define CefT_Test_File_Size		(2 * 1048576 + 123)	/* spans the blocks of the digest */
+#define CefT_Test_Msg_Len		1024
+
+/****************************************************************************************
+ State Variables
+ ****************************************************************************************/
+
+static int				test_fail = 0;
+static char				test_dir[] = "/tmp/cef_valid_testXXXXXX";
+
+/****************************************************************************************
+ Static Functions
+ ****************************************************************************************/
+
+static void
+test_expect (
+	const char* what,
+	long value,
+	long expected
+) {
+	if (value != expected) {
+		fprintf (stderr, "FAIL: %s = %ld (expected %ld)\n", what, value, expected);
+		test_fail = 1;
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+	Creates the key pair and cefnetd.conf which points to it
+----------------------------------------------------------------------------------------*/
+static int
+test_key_create (
+	void
+) {
+	char path[PATH_MAX];
+	EVP_PKEY* pkey;
+	BIO* bio;
+	FILE* fp;
+
+	pkey = EVP_RSA_gen (2048);
+	if (pkey == NULL) {
+		return (-1);
+	}
+	/* cefore reads the private key in the traditional format 	*/
+	snprintf (path, sizeof (path), "%s/test-private-key", test_dir);
+	bio = BIO_new_file (path, "w");
+	if ((bio == NULL) ||
+		(PEM_write_bio_PrivateKey_traditional (bio, pkey, NULL, NULL, 0, NULL, NULL) != 1)) {
+		return (-1);
+	}
+	BIO_free (bio);
+	snprintf (path, sizeof (path), "%s/test-public-key", test_dir);
+	fp = fopen (path, "w");
+	if ((fp == NULL) || (PEM_write_PUBKEY (fp, pkey) != 1)) {
+		return (-1);
+	}
+	fclose (fp);
+	EVP_PKEY_free (pkey);
+
+	snprintf (path, sizeof (path), "%s/cefnetd.conf", test_dir);
+	fp = fopen (path, "w");
+	if (fp == NULL) {
+		return (-1);
+	}
+	fprintf (fp, "PATH_PRIVATE_KEY=%s/test-private-key\n", test_dir);
+	fprintf (fp, "PATH_PUBLIC_KEY=%s/test-public-key\n", test_dir);
+	fclose (fp);
+	return (0);
+}
+
+static void
+test_key_remove (
+	void
+) {
+	char path[PATH_MAX];
+
+	snprintf (path, sizeof (path), "%s/test-private-key", test_dir);
+	unlink (path);
+	snprintf (path, sizeof (path), "%s/test-public-key", test_dir);
+	unlink (path);
+	snprintf (path, sizeof (path), "%s/cefnetd.conf", test_dir);
+	unlink (path);
+	rmdir (test_dir);
+}
+
+/*--------------------------------------------------------------------------------------
+	Compares the digest of the file with the digest of the buffer
+----------------------------------------------------------------------------------------*/
+static void
+test_digest_fd (
+	const char* what,
+	int fd,
+	const unsigned char* buff,
+	size_t len,
+	unsigned char* md
+) {
+	unsigned char expected[SHA256_DIGEST_LENGTH];
+	char buf[256];
+
+	if ((pwrite (fd, buff, len, 0) != (ssize_t) len) || (ftruncate (fd, (off_t) len) < 0)) {
+		fprintf (stderr, "FAIL: write the file (%s)\n", what);
+		test_fail = 1;
+		return;
+	}
+	cef_valid_sha256 (buff, len, expected);
+	snprintf (buf, sizeof (buf), "digest length (%s)", what);
+	test_expect (buf,
+		cef_valid_digest_fd (CefC_Valid_Digest_SHA256, fd, (off_t) len, md),
+		SHA256_DIGEST_LENGTH);
+	snprintf (buf, sizeof (buf), "digest equals (%s)", what);
+	test_expect (buf, memcmp (md, expected, SHA256_DIGEST_LENGTH) == 0, 1);
+}
+
+static void
+test_run_digest (
+	void
+) {
+	unsigned char md_old[SHA256_DIGEST_LENGTH];
+	unsigned char md_new[SHA256_DIGEST_LENGTH];
+	unsigned char md[SHA256_DIGEST_LENGTH];
+	char path[PATH_MAX];
+	unsigned char* buff;
+	size_t i;
+	int fd;
+
+	buff = (unsigned char*) malloc (CefT_Test_File_Size);
+	for (i = 0 ; i < CefT_Test_File_Size ; i++) {
+		buff[i] = (unsigned char)(i * 7 + (i >> 13));
+	}
+	snprintf (path, sizeof (path), "%s/content", test_dir);
+	fd = open (path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0) {
+		fprintf (stderr, "FAIL: open %s\n", path);
+		test_fail = 1;
+		free (buff);
+		return;
+	}
+
+	test_digest_fd ("empty", fd, buff, 0, md);
+	test_digest_fd ("one byte", fd, buff, 1, md);
+	test_digest_fd ("old contents", fd, buff, CefT_Test_File_Size, md_old);
+
+	/* The contents are changed in the second block, the size is the same 	*/
+	buff[1048576 + 5] ^= 0xff;
+	test_digest_fd ("new contents", fd, buff, CefT_Test_File_Size, md_new);
+	test_expect ("digest of the changed contents differs",
+		memcmp (md_old, md_new, SHA256_DIGEST_LENGTH) != 0, 1);
+
+	/* The file is shorter than the size to read 	*/
+	test_expect ("digest of the truncated file",
+		cef_valid_digest_fd (CefC_Valid_Digest_SHA256, fd, CefT_Test_File_Size + 1, md), -1);
+
+	close (fd);
+	unlink (path);
+	free (buff);
+}
+
+static void
+test_run_sign (
+	void
+) {
+	unsigned char name[CefC_Max_Length];
+	unsigned char msg[CefT_Test_Msg_Len];
+	unsigned char digest_old[SHA256_DIGEST_LENGTH];
+	unsigned char digest_new[SHA256_DIGEST_LENGTH];
+	unsigned char sign[CefC_Max_Length];
+	unsigned int sign_len = 0;
+	int name_len;
+
+	if ((test_key_create () < 0) || (cef_valid_init (test_dir) < 0)) {
+		fprintf (stderr, "FAIL: create the key\n");
+		test_fail = 1;
+		return;
+	}
+	name_len = cef_frame_conversion_uri_to_name ("ccnx:/test/content", name);
+
+	/* Signs the Cob of the old contents 	*/
+	memset (msg, 0x5a, sizeof (msg));
+	cef_valid_sha256 (msg, sizeof (msg), digest_old);
+	test_expect ("dosign", cef_valid_rsa_sha256_dosign (
+		msg, sizeof (msg), name, name_len, sign, &sign_len), 1);
+	test_expect ("verify the signature",
+		cef_valid_rsa_sha256_sign_verify (name, name_len, digest_old, sign, sign_len), 1);
+
+	/* The signature of the old Cob does not verify for the changed Cob 	*/
+	msg[100] ^= 0xff;
+	cef_valid_sha256 (msg, sizeof (msg), digest_new);
+	test_expect ("verify the signature of the old contents",
+		cef_valid_rsa_sha256_sign_verify (name, name_len, digest_new, sign, sign_len), 0);
+
+	/* A broken signature does not verify 	*/
+	sign[sign_len / 2] ^= 0x01;
+	test_expect ("verify the broken signature",
+		cef_valid_rsa_sha256_sign_verify (name, name_len, digest_old, sign, sign_len), 0);
+}
+
+/****************************************************************************************
+ ****************************************************************************************/
+
+int
+main (
+	int argc,
+	char** argv
+) {
+	if (mkdtemp (test_dir) == NULL) {
+		fprintf (stderr, "FAIL: mkdtemp\n");
+		return (1);
+	}
+	cef_log_init ("cef_valid_test", 1);
+	test_run_digest ();
+	test_run_sign ();
+	test_key_remove ();
+
+	if (test_fail) {
+		return (1);
+	}
+	fprintf (stderr, "cef_valid_test: OK\n");
+	return (0);
+}
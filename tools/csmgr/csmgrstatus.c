@@ -464,12 +464,26 @@ output_result (
 	memcpy (&stat_hdr, &frame[0], sizeof (struct CefT_Csmgr_Status_Hdr));
 	stat_hdr.node_num 	= ntohs (stat_hdr.node_num);
 	stat_hdr.con_num 	= ntohl (stat_hdr.con_num);
+	stat_hdr.cached_bytes 	= cef_client_ntohb (stat_hdr.cached_bytes);
+	stat_hdr.capacity_bytes = cef_client_ntohb (stat_hdr.capacity_bytes);
 
 	fprintf (ofp, "*****   Connection Status Report   *****\n");
 	fprintf (ofp, "All Connection Num             : %d\n\n", stat_hdr.node_num);
 
 	fprintf (ofp, "*****   Cache Status Report        *****\n");
-	fprintf (ofp, "Number of Cached Contents      : %d\n\n", stat_hdr.con_num);
+	fprintf (ofp, "Number of Cached Contents      : %d\n", stat_hdr.con_num);
+	/* Cache plugins which do not account bytes report zero for both */
+	if (stat_hdr.cached_bytes || stat_hdr.capacity_bytes) {
+		fprintf (ofp, "Cached Bytes                   : %llu Bytes\n",
+			(unsigned long long) stat_hdr.cached_bytes);
+		if (stat_hdr.capacity_bytes) {
+			fprintf (ofp, "Cache Capacity (Bytes)         : %llu Bytes\n",
+				(unsigned long long) stat_hdr.capacity_bytes);
+		} else {
+			fprintf (ofp, "Cache Capacity (Bytes)         : Unlimited\n");
+		}
+	}
+	fprintf (ofp, "\n");
 	index += sizeof (struct CefT_Csmgr_Status_Hdr);
 
 	while (index < frame_size) {